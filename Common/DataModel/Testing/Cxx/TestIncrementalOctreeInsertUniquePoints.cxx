@@ -0,0 +1,159 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestIncrementalOctreeInsertUniquePoints.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// This tests that vtkIncrementalOctreePointLocator::InsertUniquePoints()
+// returns the ids and inserts the points of successive InsertUniquePoint()
+// calls, whatever the number of threads, the tolerance and the precision of
+// the inserted points.
+
+#include <vtkIdList.h>
+#include <vtkIncrementalOctreePointLocator.h>
+#include <vtkMinimalStandardRandomSequence.h>
+#include <vtkPoints.h>
+#include <vtkSmartPointer.h>
+
+// Random points in the unit cube, a third of which duplicate (exactly or
+// almost) a previous one
+static vtkSmartPointer<vtkPoints> RandomPoints(int seed, vtkIdType numPts)
+{
+  vtkSmartPointer<vtkMinimalStandardRandomSequence> random =
+    vtkSmartPointer<vtkMinimalStandardRandomSequence>::New();
+  random->SetSeed(seed);
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  points->SetDataTypeToDouble();
+  for (vtkIdType i = 0; i < numPts; ++i)
+    {
+    double x[3];
+    random->Next();
+    if (i > 0 && random->GetValue() < 0.33)
+      {
+      random->Next();
+      points->GetPoint(static_cast<vtkIdType>(random->GetValue() * i), x);
+      random->Next();
+      if (random->GetValue() < 0.5)
+        {
+        for (int j = 0; j < 3; ++j)
+          {
+          random->Next();
+          x[j] += random->GetRangeValue(-0.004, 0.004);
+          }
+        }
+      }
+    else
+      {
+      for (int j = 0; j < 3; ++j)
+        {
+        random->Next();
+        x[j] = random->GetValue();
+        }
+      }
+    points->InsertNextPoint(x);
+    }
+  return points;
+}
+
+static vtkSmartPointer<vtkIncrementalOctreePointLocator> NewLocator(
+  double tolerance, int dataType, vtkPoints *existing)
+{
+  double bounds[6] = { -0.1, 1.1, -0.1, 1.1, -0.1, 1.1 };
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  points->SetDataType(dataType);
+  vtkSmartPointer<vtkIncrementalOctreePointLocator> locator =
+    vtkSmartPointer<vtkIncrementalOctreePointLocator>::New();
+  locator->SetTolerance(tolerance);
+  locator->SetMaxPointsPerLeaf(16);
+  locator->InitPointInsertion(points, bounds);
+  for (vtkIdType i = 0; i < existing->GetNumberOfPoints(); ++i)
+    {
+    vtkIdType id;
+    locator->InsertUniquePoint(existing->GetPoint(i), id);
+    }
+  return locator;
+}
+
+int TestIncrementalOctreeInsertUniquePoints(int, char*[])
+{
+  vtkSmartPointer<vtkPoints> existing = RandomPoints(1414, 2000);
+  vtkSmartPointer<vtkPoints> points = RandomPoints(1732, 20000);
+
+  // duplicates of the points already in the octree
+  for (vtkIdType i = 0; i < existing->GetNumberOfPoints(); i += 7)
+    {
+    points->InsertNextPoint(existing->GetPoint(i));
+    }
+
+  const double tolerances[3] = { 0.0, 0.001, 0.01 };
+  const int dataTypes[2] = { VTK_FLOAT, VTK_DOUBLE };
+  for (int tol = 0; tol < 3; ++tol)
+    {
+    for (int type = 0; type < 2; ++type)
+      {
+      vtkSmartPointer<vtkIncrementalOctreePointLocator> reference =
+        NewLocator(tolerances[tol], dataTypes[type], existing);
+      vtkSmartPointer<vtkIdList> expected = vtkSmartPointer<vtkIdList>::New();
+      for (vtkIdType i = 0; i < points->GetNumberOfPoints(); ++i)
+        {
+        vtkIdType id;
+        reference->InsertUniquePoint(points->GetPoint(i), id);
+        expected->InsertNextId(id);
+        }
+      vtkIdType numNew = reference->GetNumberOfPoints() -
+        NewLocator(tolerances[tol], dataTypes[type], existing)
+        ->GetNumberOfPoints();
+      if (numNew <= 0 || numNew >= points->GetNumberOfPoints())
+        {
+        std::cerr << "Error: " << numNew << " new points with tolerance "
+                  << tolerances[tol] << std::endl;
+        return EXIT_FAILURE;
+        }
+
+      for (int numThreads = 1; numThreads <= 4; numThreads += 3)
+        {
+        vtkSmartPointer<vtkIncrementalOctreePointLocator> locator =
+          NewLocator(tolerances[tol], dataTypes[type], existing);
+        locator->SetNumberOfThreads(numThreads);
+        vtkSmartPointer<vtkIdList> ids = vtkSmartPointer<vtkIdList>::New();
+        locator->InsertUniquePoints(points, ids);
+
+        bool same =
+          (ids->GetNumberOfIds() == expected->GetNumberOfIds() &&
+           locator->GetNumberOfPoints() == reference->GetNumberOfPoints());
+        for (vtkIdType i = 0; same && i < ids->GetNumberOfIds(); ++i)
+          {
+          same = (ids->GetId(i) == expected->GetId(i));
+          }
+        vtkPoints *a = locator->GetLocatorPoints();
+        vtkPoints *b = reference->GetLocatorPoints();
+        for (vtkIdType i = 0; same && i < a->GetNumberOfPoints(); ++i)
+          {
+          double pa[3], pb[3];
+          a->GetPoint(i, pa);
+          b->GetPoint(i, pb);
+          same = (pa[0] == pb[0] && pa[1] == pb[1] && pa[2] == pb[2]);
+          }
+        if (!same)
+          {
+          std::cerr << "Error: InsertUniquePoints differs from InsertUniquePoint"
+                    << " with tolerance " << tolerances[tol] << ", "
+                    << (dataTypes[type] == VTK_FLOAT ? "float" : "double")
+                    << " points and " << numThreads << " thread(s)"
+                    << std::endl;
+          return EXIT_FAILURE;
+          }
+        }
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,179 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestKdTreeBatchQueries.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// This tests that vtkKdTree builds the same tree whatever the number of
+// threads, and that the batch FindClosestNPoints and FindPointsWithinRadius
+// return the neighbors of the single point queries.
+
+#include <vtkIdList.h>
+#include <vtkIdTypeArray.h>
+#include <vtkKdTree.h>
+#include <vtkKdTreePointLocator.h>
+#include <vtkMath.h>
+#include <vtkMinimalStandardRandomSequence.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+static vtkSmartPointer<vtkPoints> RandomPoints(int seed, vtkIdType numPts)
+{
+  vtkSmartPointer<vtkMinimalStandardRandomSequence> random =
+    vtkSmartPointer<vtkMinimalStandardRandomSequence>::New();
+  random->SetSeed(seed);
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  for (vtkIdType i = 0; i < numPts; ++i)
+    {
+    double x[3];
+    for (int j = 0; j < 3; ++j)
+      {
+      random->Next();
+      x[j] = random->GetRangeValue(-1.0, 1.0);
+      }
+    points->InsertNextPoint(x);
+    }
+  return points;
+}
+
+// Compare the batch results with the single point queries
+static bool SameNeighbors(vtkKdTreePointLocator *locator, vtkPoints *queries,
+                          int N, double R, vtkIdTypeArray *offsets,
+                          vtkIdTypeArray *ids)
+{
+  if (offsets->GetNumberOfTuples() != queries->GetNumberOfPoints() + 1 ||
+      offsets->GetValue(queries->GetNumberOfPoints()) !=
+      ids->GetNumberOfTuples())
+    {
+    return false;
+    }
+  vtkSmartPointer<vtkIdList> result = vtkSmartPointer<vtkIdList>::New();
+  for (vtkIdType i = 0; i < queries->GetNumberOfPoints(); ++i)
+    {
+    double x[3];
+    queries->GetPoint(i, x);
+    if (N > 0)
+      {
+      locator->FindClosestNPoints(N, x, result);
+      }
+    else
+      {
+      locator->FindPointsWithinRadius(R, x, result);
+      }
+    vtkIdType begin = offsets->GetValue(i);
+    if (offsets->GetValue(i+1) - begin != result->GetNumberOfIds())
+      {
+      return false;
+      }
+    for (vtkIdType j = 0; j < result->GetNumberOfIds(); ++j)
+      {
+      if (ids->GetValue(begin + j) != result->GetId(j))
+        {
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+int TestKdTreeBatchQueries(int, char*[])
+{
+  vtkSmartPointer<vtkPoints> points = RandomPoints(1618, 20000);
+  vtkSmartPointer<vtkPoints> queries = RandomPoints(2718, 1000);
+
+  // The same regions for any number of threads
+  vtkSmartPointer<vtkKdTree> reference = vtkSmartPointer<vtkKdTree>::New();
+  reference->SetNumberOfThreads(1);
+  reference->BuildLocatorFromPoints(points);
+  for (int numThreads = 2; numThreads <= 8; numThreads *= 2)
+    {
+    vtkSmartPointer<vtkKdTree> tree = vtkSmartPointer<vtkKdTree>::New();
+    tree->SetNumberOfThreads(numThreads);
+    tree->BuildLocatorFromPoints(points);
+    bool same = (tree->GetNumberOfRegions() > 1 &&
+                 tree->GetNumberOfRegions() ==
+                 reference->GetNumberOfRegions());
+    for (int r = 0; same && r < tree->GetNumberOfRegions(); ++r)
+      {
+      vtkIdTypeArray *a = tree->GetPointsInRegion(r);
+      vtkIdTypeArray *b = reference->GetPointsInRegion(r);
+      same = (a->GetNumberOfTuples() == b->GetNumberOfTuples());
+      for (vtkIdType i = 0; same && i < a->GetNumberOfTuples(); ++i)
+        {
+        same = (a->GetValue(i) == b->GetValue(i));
+        }
+      a->Delete();
+      b->Delete();
+      }
+    if (!same)
+      {
+      std::cerr << "Error: the tree built with " << numThreads
+                << " threads differs" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  vtkSmartPointer<vtkPolyData> polydata = vtkSmartPointer<vtkPolyData>::New();
+  polydata->SetPoints(points);
+  vtkSmartPointer<vtkKdTreePointLocator> locator =
+    vtkSmartPointer<vtkKdTreePointLocator>::New();
+  locator->SetDataSet(polydata);
+  locator->BuildLocator();
+
+  for (int numThreads = 1; numThreads <= 4; numThreads += 3)
+    {
+    locator->SetNumberOfThreads(numThreads);
+    vtkSmartPointer<vtkIdTypeArray> offsets =
+      vtkSmartPointer<vtkIdTypeArray>::New();
+    vtkSmartPointer<vtkIdTypeArray> ids =
+      vtkSmartPointer<vtkIdTypeArray>::New();
+
+    locator->FindClosestNPoints(10, queries, offsets, ids);
+    if (ids->GetNumberOfTuples() != 10 * queries->GetNumberOfPoints() ||
+        !SameNeighbors(locator, queries, 10, 0.0, offsets, ids))
+      {
+      std::cerr << "Error: batch FindClosestNPoints differs with "
+                << numThreads << " thread(s)" << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    // The first neighbor is the closest point
+    for (vtkIdType i = 0; i < queries->GetNumberOfPoints(); ++i)
+      {
+      double x[3];
+      queries->GetPoint(i, x);
+      double closest = vtkMath::Distance2BetweenPoints(
+        x, points->GetPoint(ids->GetValue(offsets->GetValue(i))));
+      for (vtkIdType j = 0; j < points->GetNumberOfPoints(); ++j)
+        {
+        if (vtkMath::Distance2BetweenPoints(x, points->GetPoint(j)) <
+            closest - 1e-6)
+          {
+          std::cerr << "Error: point " << j << " is closer to query " << i
+                    << " than its first neighbor" << std::endl;
+          return EXIT_FAILURE;
+          }
+        }
+      }
+
+    locator->FindPointsWithinRadius(0.1, queries, offsets, ids);
+    if (ids->GetNumberOfTuples() == 0 ||
+        !SameNeighbors(locator, queries, 0, 0.1, offsets, ids))
+      {
+      std::cerr << "Error: batch FindPointsWithinRadius differs with "
+                << numThreads << " thread(s)" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
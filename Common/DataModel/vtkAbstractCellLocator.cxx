@@ -21,8 +21,178 @@
 #include "vtkIdList.h"
 #include "vtkPoints.h"
 #include "vtkDataSet.h"
+#include "vtkDoubleArray.h"
 #include "vtkMath.h"
+#include "vtkMultiThreader.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+struct vtkAbstractCellLocatorFindCells
+{
+  vtkAbstractCellLocator *Locator;
+  vtkPoints *Points;
+  vtkIdType *CellIds;
+  double *PCoords;
+  double *Weights;
+  int NumberOfWeights;
+  vtkIdType Begin;
+  vtkIdType End;
+  int NumberOfThreads;
+};
+
+struct vtkAbstractCellLocatorIntersectLines
+{
+  vtkAbstractCellLocator *Locator;
+  vtkPoints *P1;
+  vtkPoints *P2;
+  double Tolerance;
+  vtkIdType *CellIds;
+  double *T;
+  vtkPoints *Points;
+  vtkIdType Begin;
+  vtkIdType End;
+  int NumberOfThreads;
+};
+
+struct vtkAbstractCellLocatorCellBounds
+{
+  vtkDataSet *DataSet;
+  double (*CellBounds)[6];
+  vtkIdType NumberOfCells;
+  int NumberOfThreads;
+};
+}
+
+//----------------------------------------------------------------------------
+static VTK_THREAD_RETURN_TYPE vtkAbstractCellLocatorCellBoundsExecute(
+  void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkAbstractCellLocatorCellBounds *str =
+    static_cast<vtkAbstractCellLocatorCellBounds *>(info->UserData);
+
+  vtkIdType begin = str->NumberOfCells * info->ThreadID / str->NumberOfThreads;
+  vtkIdType end = str->NumberOfCells * (info->ThreadID+1) /
+    str->NumberOfThreads;
+  for (vtkIdType cellId = begin; cellId < end; cellId++)
+    {
+    str->DataSet->GetCellBounds(cellId, str->CellBounds[cellId]);
+    }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+// Locate a range of the points. Each thread uses its own cell, so the
+// locator's GenericCell is not touched.
+static void vtkAbstractCellLocatorFindCellRange(
+  vtkAbstractCellLocatorFindCells *str, vtkIdType begin, vtkIdType end,
+  vtkGenericCell *cell)
+{
+  std::vector<double> weights(str->NumberOfWeights + 1);
+  double x[3], pcoords[3];
+  for (vtkIdType ptId = begin; ptId < end; ptId++)
+    {
+    str->Points->GetPoint(ptId, x);
+    pcoords[0] = pcoords[1] = pcoords[2] = 0.0;
+    std::fill(weights.begin(), weights.end(), 0.0);
+    vtkIdType cellId =
+      str->Locator->FindCell(x, 0.0, cell, pcoords, &weights[0]);
+    str->CellIds[ptId] = cellId;
+    if (str->PCoords)
+      {
+      double *p = str->PCoords + 3*ptId;
+      p[0] = pcoords[0];
+      p[1] = pcoords[1];
+      p[2] = pcoords[2];
+      }
+    if (str->Weights)
+      {
+      double *w = str->Weights + str->NumberOfWeights*ptId;
+      for (int i = 0; i < str->NumberOfWeights; i++)
+        {
+        w[i] = ( cellId >= 0 ? weights[i] : 0.0 );
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+static VTK_THREAD_RETURN_TYPE vtkAbstractCellLocatorFindCellsExecute(
+  void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkAbstractCellLocatorFindCells *str =
+    static_cast<vtkAbstractCellLocatorFindCells *>(info->UserData);
+
+  vtkIdType num = str->End - str->Begin;
+  vtkIdType begin = str->Begin + num * info->ThreadID / str->NumberOfThreads;
+  vtkIdType end = str->Begin + num * (info->ThreadID+1) / str->NumberOfThreads;
+
+  vtkGenericCell *cell = vtkGenericCell::New();
+  vtkAbstractCellLocatorFindCellRange(str, begin, end, cell);
+  cell->Delete();
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
 //----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+// Intersect a range of the lines, with a cell of the thread's own.
+static void vtkAbstractCellLocatorIntersectLineRange(
+  vtkAbstractCellLocatorIntersectLines *str, vtkIdType begin, vtkIdType end,
+  vtkGenericCell *cell)
+{
+  double p1[3], p2[3], x[3], pcoords[3], t;
+  int subId;
+  for (vtkIdType lineId = begin; lineId < end; lineId++)
+    {
+    str->P1->GetPoint(lineId, p1);
+    str->P2->GetPoint(lineId, p2);
+    vtkIdType cellId = -1;
+    if (!str->Locator->IntersectWithLine(p1, p2, str->Tolerance, t, x,
+                                         pcoords, subId, cellId, cell))
+      {
+      cellId = -1;
+      t = -1.0;
+      x[0] = p1[0]; x[1] = p1[1]; x[2] = p1[2];
+      }
+    str->CellIds[lineId] = cellId;
+    if (str->T)
+      {
+      str->T[lineId] = t;
+      }
+    if (str->Points)
+      {
+      str->Points->SetPoint(lineId, x);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+static VTK_THREAD_RETURN_TYPE vtkAbstractCellLocatorIntersectLinesExecute(
+  void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkAbstractCellLocatorIntersectLines *str =
+    static_cast<vtkAbstractCellLocatorIntersectLines *>(info->UserData);
+
+  vtkIdType num = str->End - str->Begin;
+  vtkIdType begin = str->Begin + num * info->ThreadID / str->NumberOfThreads;
+  vtkIdType end = str->Begin + num * (info->ThreadID+1) / str->NumberOfThreads;
+  vtkGenericCell *cell = vtkGenericCell::New();
+  vtkAbstractCellLocatorIntersectLineRange(str, begin, end, cell);
+  cell->Delete();
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
 //----------------------------------------------------------------------------
 vtkAbstractCellLocator::vtkAbstractCellLocator()
 {
@@ -34,6 +204,8 @@ vtkAbstractCellLocator::vtkAbstractCellLocator()
   this->NumberOfCellsPerNode       = 32;
   this->UseExistingSearchStructure = 0;
   this->LazyEvaluation             = 0;
+  this->NumberOfThreads            =
+    vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
   this->GenericCell                = vtkGenericCell::New();
 }
 //----------------------------------------------------------------------------
@@ -49,6 +221,23 @@ bool vtkAbstractCellLocator::StoreCellBounds()
   // Allocate space for cell bounds storage, then fill
   vtkIdType numCells = this->DataSet->GetNumberOfCells();
   this->CellBounds = new double [numCells][6];
+  int numThreads = this->NumberOfThreads;
+  if (numThreads > 1 && numCells > 1 && this->PrepareConcurrentDataSetAccess())
+    {
+    vtkAbstractCellLocatorCellBounds str;
+    str.DataSet = this->DataSet;
+    str.CellBounds = this->CellBounds;
+    str.NumberOfCells = numCells;
+    str.NumberOfThreads = ( numThreads > numCells ?
+                            static_cast<int>(numCells) : numThreads );
+
+    vtkMultiThreader *threader = vtkMultiThreader::New();
+    threader->SetNumberOfThreads(str.NumberOfThreads);
+    threader->SetSingleMethod(vtkAbstractCellLocatorCellBoundsExecute, &str);
+    threader->SingleMethodExecute();
+    threader->Delete();
+    return true;
+    }
   for (vtkIdType j=0; j<numCells; j++)
     {
     this->DataSet->GetCellBounds(j, CellBounds[j]);
@@ -56,6 +245,24 @@ bool vtkAbstractCellLocator::StoreCellBounds()
   return true;
 }
 //----------------------------------------------------------------------------
+int vtkAbstractCellLocator::PrepareConcurrentDataSetAccess()
+{
+  if (!this->DataSet ||
+      !(this->DataSet->IsA("vtkPolyData") ||
+        this->DataSet->IsA("vtkUnstructuredGrid") ||
+        this->DataSet->IsA("vtkImageData")))
+    {
+    return 0;
+    }
+  // vtkPolyData builds its cells on first access
+  if (this->DataSet->GetNumberOfCells() > 0)
+    {
+    double bounds[6];
+    this->DataSet->GetCellBounds(0, bounds);
+    }
+  return 1;
+}
+//----------------------------------------------------------------------------
 void vtkAbstractCellLocator::FreeCellBounds()
 {
   if (this->CellBounds)
@@ -205,6 +412,144 @@ vtkIdType vtkAbstractCellLocator::FindCell(
   return returnVal;
 }
 //----------------------------------------------------------------------------
+void vtkAbstractCellLocator::FindCells(
+  vtkPoints *points, vtkIdList *cellIds,
+  vtkDoubleArray *pcoords, vtkDoubleArray *weights)
+{
+  vtkIdType numPts = points->GetNumberOfPoints();
+  int numWeights = ( this->DataSet && this->DataSet->GetNumberOfCells() > 0 ?
+                     this->DataSet->GetMaxCellSize() : 0 );
+
+  cellIds->SetNumberOfIds(numPts);
+  if (pcoords)
+    {
+    pcoords->SetNumberOfComponents(3);
+    pcoords->SetNumberOfTuples(numPts);
+    }
+  if (weights)
+    {
+    weights->SetNumberOfComponents(numWeights > 0 ? numWeights : 1);
+    weights->SetNumberOfTuples(numPts);
+    if (numWeights == 0)
+      {
+      weights->FillComponent(0, 0.0);
+      }
+    }
+  if (numPts == 0)
+    {
+    return;
+    }
+
+  vtkAbstractCellLocatorFindCells str;
+  str.Locator = this;
+  str.Points = points;
+  str.CellIds = cellIds->GetPointer(0);
+  str.PCoords = ( pcoords ? pcoords->GetPointer(0) : NULL );
+  str.Weights = ( weights && numWeights > 0 ? weights->GetPointer(0) : NULL );
+  str.NumberOfWeights = numWeights;
+
+  // The first point is located by the calling thread: this builds the
+  // search structure if that is still to be done.
+  vtkAbstractCellLocatorFindCellRange(&str, 0, 1, this->GenericCell);
+
+  int numThreads = this->NumberOfThreads;
+  if (!this->IsFindCellThreadSafe() || !this->PrepareConcurrentDataSetAccess())
+    {
+    numThreads = 1;
+    }
+  if (numThreads > numPts - 1)
+    {
+    numThreads = static_cast<int>(numPts - 1);
+    }
+
+  if (numThreads <= 1)
+    {
+    vtkAbstractCellLocatorFindCellRange(&str, 1, numPts, this->GenericCell);
+    return;
+    }
+
+  str.Begin = 1;
+  str.End = numPts;
+  str.NumberOfThreads = numThreads;
+
+  vtkMultiThreader *threader = vtkMultiThreader::New();
+  threader->SetNumberOfThreads(numThreads);
+  threader->SetSingleMethod(vtkAbstractCellLocatorFindCellsExecute, &str);
+  threader->SingleMethodExecute();
+  threader->Delete();
+}
+//----------------------------------------------------------------------------
+void vtkAbstractCellLocator::IntersectWithLines(
+  vtkPoints *p1, vtkPoints *p2, double tol, vtkIdList *cellIds,
+  vtkDoubleArray *t, vtkPoints *points)
+{
+  vtkIdType numLines = p1->GetNumberOfPoints();
+  if (p2->GetNumberOfPoints() != numLines)
+    {
+    vtkErrorMacro(<< "IntersectWithLines needs as many end points as start "
+                  << "points");
+    cellIds->Reset();
+    return;
+    }
+
+  cellIds->SetNumberOfIds(numLines);
+  if (t)
+    {
+    t->SetNumberOfComponents(1);
+    t->SetNumberOfTuples(numLines);
+    }
+  if (points)
+    {
+    points->SetNumberOfPoints(numLines);
+    }
+  if (numLines == 0)
+    {
+    return;
+    }
+
+  vtkAbstractCellLocatorIntersectLines str;
+  str.Locator = this;
+  str.P1 = p1;
+  str.P2 = p2;
+  str.Tolerance = tol;
+  str.CellIds = cellIds->GetPointer(0);
+  str.T = ( t ? t->GetPointer(0) : NULL );
+  str.Points = points;
+
+  // The first line is intersected by the calling thread: this builds the
+  // search structure if that is still to be done.
+  vtkAbstractCellLocatorIntersectLineRange(&str, 0, 1, this->GenericCell);
+
+  int numThreads = this->NumberOfThreads;
+  if (!this->IsIntersectWithLineThreadSafe() ||
+      !this->PrepareConcurrentDataSetAccess())
+    {
+    numThreads = 1;
+    }
+  if (numThreads > numLines - 1)
+    {
+    numThreads = static_cast<int>(numLines - 1);
+    }
+
+  if (numThreads <= 1)
+    {
+    vtkAbstractCellLocatorIntersectLineRange(&str, 1, numLines,
+                                             this->GenericCell);
+    return;
+    }
+
+  str.Begin = 1;
+  str.End = numLines;
+  str.NumberOfThreads = numThreads;
+
+  vtkMultiThreader *threader = vtkMultiThreader::New();
+  threader->SetNumberOfThreads(numThreads);
+  threader->SetSingleMethod(vtkAbstractCellLocatorIntersectLinesExecute,
+                            &str);
+  threader->SingleMethodExecute();
+  threader->Delete();
+}
+//----------------------------------------------------------------------------
 bool vtkAbstractCellLocator::InsideCellBounds(double x[3], vtkIdType cell_ID)
 {
   double cellBounds[6], delta[3] = {0.0, 0.0, 0.0};
@@ -229,5 +574,7 @@ void vtkAbstractCellLocator::PrintSelf(ostream& os, vtkIndent indent)
      << this->UseExistingSearchStructure << "\n";
   os << indent << "LazyEvaluation: "
      << this->LazyEvaluation << "\n";
+  os << indent << "NumberOfThreads: "
+     << this->NumberOfThreads << "\n";
 }
 //----------------------------------------------------------------------------
@@ -40,6 +40,7 @@
 #include "vtkLocator.h"
 
 class vtkCellArray;
+class vtkDoubleArray;
 class vtkGenericCell;
 class vtkIdList;
 class vtkPoints;
@@ -234,6 +235,41 @@ public:
     double x[3], double tol2, vtkGenericCell *GenCell,
     double pcoords[3], double *weights);
 
+  // Description:
+  // Find the cells containing each of the given points. The id of the cell
+  // containing the i-th point (-1 if there is none) is stored as the i-th
+  // id of cellIds. If pcoords is not NULL, it receives the parametric
+  // coordinates of the points in their cell (3 components). If weights is
+  // not NULL, it receives their interpolation weights, with as many
+  // components as the largest cell of the dataset; the extra components
+  // are set to zero. For locators whose FindCell() is thread-safe, the
+  // points are split over NumberOfThreads threads.
+  virtual void FindCells(vtkPoints *points, vtkIdList *cellIds,
+                         vtkDoubleArray *pcoords=NULL,
+                         vtkDoubleArray *weights=NULL);
+
+  // Description:
+  // Intersect a batch of finite lines with the cells: the i-th line goes
+  // from the i-th point of p1 to the i-th point of p2. For every line, the
+  // first intersection found by IntersectWithLine() is stored as the i-th
+  // id of cellIds (-1 if the line hits no cell), the i-th value of t (the
+  // parametric coordinate along the line) and the i-th point of points.
+  // t and points may be NULL; for lines that hit nothing they receive -1
+  // and the start of the line. For locators whose IntersectWithLine() is
+  // thread-safe, the lines are split over NumberOfThreads threads.
+  virtual void IntersectWithLines(vtkPoints *p1, vtkPoints *p2, double tol,
+                                  vtkIdList *cellIds,
+                                  vtkDoubleArray *t=NULL,
+                                  vtkPoints *points=NULL);
+
+  // Description:
+  // Set/Get the number of threads used by FindCells() and
+  // IntersectWithLines(), and by the locators that support it to build
+  // their search structure. Defaults to the number of available
+  // processors.
+  vtkSetClampMacro(NumberOfThreads,int,1,VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads,int);
+
   // Description:
   // Quickly test if a point is inside the bounds of a particular cell.
   // Some locators cache cell bounds and this function can make use
@@ -253,11 +289,33 @@ protected:
   virtual bool StoreCellBounds();
   virtual void FreeCellBounds();
 
+  // Description:
+  // Return 1 if FindCell(x, tol2, cell, pcoords, weights) may be called
+  // from several threads at once (each with its own cell) once the locator
+  // has been built. FindCells() uses threads only for these locators.
+  // Returns 0 by default.
+  virtual int IsFindCellThreadSafe() { return 0; }
+
+  // Description:
+  // Return 1 if IntersectWithLine(p1, p2, tol, t, x, pcoords, subId,
+  // cellId, cell) may be called from several threads at once (each with
+  // its own cell) once the locator has been built. IntersectWithLines()
+  // uses threads only for these locators. Returns 0 by default.
+  virtual int IsIntersectWithLineThreadSafe() { return 0; }
+
+  // Description:
+  // Return 1 if GetCell() and GetCellBounds() of the dataset may be called
+  // from several threads at once, which holds for vtkPolyData,
+  // vtkUnstructuredGrid and vtkImageData. The dataset first builds
+  // whatever it builds on the first access to its cells.
+  int PrepareConcurrentDataSetAccess();
+
   int NumberOfCellsPerNode;
   int RetainCellLists;
   int CacheCellBounds;
   int LazyEvaluation;
   int UseExistingSearchStructure;
+  int NumberOfThreads;
   vtkGenericCell *GenericCell;
 //BTX - begin tcl exclude
   double (*CellBounds)[6];
@@ -392,6 +392,45 @@ int vtkCellLocator::IntersectWithLine(double a0[3], double a1[3], double tol,
 void vtkCellLocator::FindClosestPoint(double x[3], double closestPoint[3],
                                       vtkGenericCell *cell, vtkIdType &cellId,
                                       int &subId, double& dist2)
+{
+  this->BuildLocatorIfNeeded();
+
+  // Clear the array that indicates whether we have visited this cell.
+  // The array is only cleared when the query number rolls over.  This
+  // saves a number of calls to memset.
+  this->QueryNumber++;
+  if (this->QueryNumber == 0)
+    {
+    this->ClearCellHasBeenVisited();
+    this->QueryNumber++;    // can't use 0 as a marker
+    }
+
+  this->FindClosestPoint(x, closestPoint, cell, cellId, subId, dist2,
+                         this->Buckets, this->CellHasBeenVisited);
+}
+
+//----------------------------------------------------------------------------
+// Thread-safe version: the buckets are gathered in a local list and the
+// cells are not marked as visited.
+void vtkCellLocator::FindClosestPointConcurrently(double x[3],
+                                                  double closestPoint[3],
+                                                  vtkGenericCell *cell,
+                                                  vtkIdType &cellId,
+                                                  int &subId, double& dist2)
+{
+  vtkNeighborCells buckets(10, 10);
+  this->FindClosestPoint(x, closestPoint, cell, cellId, subId, dist2,
+                         &buckets, NULL);
+}
+
+//----------------------------------------------------------------------------
+// Closest point search over the given bucket list. Cells are marked with the
+// current query number in visited, unless it is NULL.
+void vtkCellLocator::FindClosestPoint(double x[3], double closestPoint[3],
+                                      vtkGenericCell *cell, vtkIdType &cellId,
+                                      int &subId, double& dist2,
+                                      vtkNeighborCells *buckets,
+                                      unsigned char *visited)
 {
   int i;
   vtkIdType j;
@@ -410,8 +449,6 @@ void vtkCellLocator::FindClosestPoint(double x[3], double closestPoint[3],
   int stat;
   //int minStat=0; //save this variable it is used for debugging
 
-  this->BuildLocatorIfNeeded();
-
   cachedPoint[0] = 0.0;
   cachedPoint[1] = 0.0;
   cachedPoint[2] = 0.0;
@@ -419,16 +456,6 @@ void vtkCellLocator::FindClosestPoint(double x[3], double closestPoint[3],
   leafStart = this->NumberOfOctants
     - this->NumberOfDivisions*this->NumberOfDivisions*this->NumberOfDivisions;
 
-  // Clear the array that indicates whether we have visited this cell.
-  // The array is only cleared when the query number rolls over.  This
-  // saves a number of calls to memset.
-  this->QueryNumber++;
-  if (this->QueryNumber == 0)
-    {
-    this->ClearCellHasBeenVisited();
-    this->QueryNumber++;    // can't use 0 as a marker
-    }
-
   // init
   dist2 = -1.0;
   refinedRadius2 = VTK_DOUBLE_MAX;
@@ -457,11 +484,11 @@ void vtkCellLocator::FindClosestPoint(double x[3], double closestPoint[3],
   for (closestCell=(-1),minDist2=VTK_DOUBLE_MAX,level=0;
   (closestCell == -1) && (level < this->NumberOfDivisions); level++)
     {
-    this->GetBucketNeighbors(ijk, this->NumberOfDivisions, level);
+    this->GetBucketNeighbors(buckets, ijk, this->NumberOfDivisions, level);
 
-    for (i=0; i<this->Buckets->GetNumberOfNeighbors(); i++)
+    for (i=0; i<buckets->GetNumberOfNeighbors(); i++)
       {
-      nei = this->Buckets->GetPoint(i);
+      nei = buckets->GetPoint(i);
 
       // if a neighboring bucket has cells,
       if ( (cellIds =
@@ -478,9 +505,12 @@ void vtkCellLocator::FindClosestPoint(double x[3], double closestPoint[3],
             {
             // get the cell
             cellId = cellIds->GetId(j);
-            if (this->CellHasBeenVisited[cellId] != this->QueryNumber)
+            if (!visited || visited[cellId] != this->QueryNumber)
               {
-              this->CellHasBeenVisited[cellId] = this->QueryNumber;
+              if (visited)
+                {
+                visited[cellId] = this->QueryNumber;
+                }
 
               // check whether we could be close enough to the cell by
               // testing the cell bounds
@@ -567,12 +597,12 @@ void vtkCellLocator::FindClosestPoint(double x[3], double closestPoint[3],
         prevMaxLevel[i] = this->NumberOfDivisions - 1;
         }
       }
-    this->GetOverlappingBuckets(x, ijk, sqrt(minDist2), prevMinLevel,
+    this->GetOverlappingBuckets(buckets, x, ijk, sqrt(minDist2), prevMinLevel,
                                 prevMaxLevel);
 
-    for (i=0; i<this->Buckets->GetNumberOfNeighbors(); i++)
+    for (i=0; i<buckets->GetNumberOfNeighbors(); i++)
       {
-      nei = this->Buckets->GetPoint(i);
+      nei = buckets->GetPoint(i);
 
       if ( (cellIds =
           this->Tree[leafStart + nei[0] + nei[1]*this->NumberOfDivisions +
@@ -588,9 +618,12 @@ void vtkCellLocator::FindClosestPoint(double x[3], double closestPoint[3],
             {
             // get the cell
             cellId = cellIds->GetId(j);
-            if (this->CellHasBeenVisited[cellId] != this->QueryNumber)
+            if (!visited || visited[cellId] != this->QueryNumber)
               {
-              this->CellHasBeenVisited[cellId] = this->QueryNumber;
+              if (visited)
+                {
+                visited[cellId] = this->QueryNumber;
+                }
 
               // check whether we could be close enough to the cell by
               // testing the cell bounds
@@ -970,6 +1003,13 @@ vtkIdType vtkCellLocator::FindClosestPointWithinRadius(double x[3], double radiu
 //  layer before they can be used. Only those buckets with cells are returned.
 //
 void vtkCellLocator::GetBucketNeighbors(int ijk[3], int ndivs, int level)
+{
+  this->GetBucketNeighbors(this->Buckets, ijk, ndivs, level);
+}
+
+//----------------------------------------------------------------------------
+void vtkCellLocator::GetBucketNeighbors(vtkNeighborCells *buckets, int ijk[3],
+                                        int ndivs, int level)
 {
   int i, j, k, min, max, minLevel[3], maxLevel[3];
   int nei[3];
@@ -984,7 +1024,7 @@ void vtkCellLocator::GetBucketNeighbors(int ijk[3], int ndivs, int level)
 
   //  Initialize
   //
-  this->Buckets->Reset();
+  buckets->Reset();
 
   //  If at this bucket, just place into list
   //
@@ -993,7 +1033,7 @@ void vtkCellLocator::GetBucketNeighbors(int ijk[3], int ndivs, int level)
     if (this->Tree[leafStart + ijk[0] + ijk[1]*this->NumberOfDivisions
       + ijk[2]*numberOfBucketsPerPlane])
       {
-      this->Buckets->InsertNextPoint(ijk);
+      buckets->InsertNextPoint(ijk);
       }
     return;
     }
@@ -1023,7 +1063,7 @@ void vtkCellLocator::GetBucketNeighbors(int ijk[3], int ndivs, int level)
             + k*numberOfBucketsPerPlane])
             {
             nei[0]=i; nei[1]=j; nei[2]=k;
-            this->Buckets->InsertNextPoint(nei);
+            buckets->InsertNextPoint(nei);
             }
           }
         }
@@ -1041,7 +1081,18 @@ void vtkCellLocator::GetBucketNeighbors(int ijk[3], int ndivs, int level)
 // layer before they can be used. Only buckets that have cells are placed
 // in the bucket list.
 //
-void vtkCellLocator::GetOverlappingBuckets(double x[3], int vtkNotUsed(ijk)[3],
+void vtkCellLocator::GetOverlappingBuckets(double x[3], int ijk[3],
+                                           double dist,
+                                           int prevMinLevel[3],
+                                           int prevMaxLevel[3])
+{
+  this->GetOverlappingBuckets(this->Buckets, x, ijk, dist, prevMinLevel,
+                              prevMaxLevel);
+}
+
+//----------------------------------------------------------------------------
+void vtkCellLocator::GetOverlappingBuckets(vtkNeighborCells *buckets,
+                                           double x[3], int vtkNotUsed(ijk)[3],
                                            double dist,
                                            int prevMinLevel[3],
                                            int prevMaxLevel[3])
@@ -1057,7 +1108,7 @@ void vtkCellLocator::GetOverlappingBuckets(double x[3], int vtkNotUsed(ijk)[3],
     - numberOfBucketsPerPlane*this->NumberOfDivisions;
 
   // Initialize
-  this->Buckets->Reset();
+  buckets->Reset();
 
   // Determine the range of indices in each direction
   for (i=0; i < 3; i++)
@@ -1127,7 +1178,7 @@ void vtkCellLocator::GetOverlappingBuckets(double x[3], int vtkNotUsed(ijk)[3],
         if (this->Tree[leafStart + i + jFactor + kFactor])
           {
           nei[0]=i; nei[1]=j; nei[2]=k;
-          this->Buckets->InsertNextPoint(nei);
+          buckets->InsertNextPoint(nei);
           }
         }
       }
@@ -1236,6 +1287,21 @@ void vtkCellLocator::BuildLocatorInternal()
     }
   this->FreeCellBounds();
 
+  //  Load the octants from the cache file if it is valid
+  //
+  if ( this->ReadCacheFile() )
+    {
+    this->CellHasBeenVisited = new unsigned char [ numCells ];
+    this->ClearCellHasBeenVisited();
+    this->QueryNumber = 0;
+    if (this->CacheCellBounds)
+      {
+      this->StoreCellBounds();
+      }
+    this->BuildTime.Modified();
+    return;
+    }
+
   //  Size the root cell.  Initialize cell data structure, compute
   //  level and divisions.
   //
@@ -1350,9 +1416,160 @@ void vtkCellLocator::BuildLocatorInternal()
 
     } //for all cells
 
+  this->WriteCacheFile();
   this->BuildTime.Modified();
 }
 
+//----------------------------------------------------------------------------
+// The octants are written as one count per octant, -1 for an empty octant
+// and -2 for a parent octant containing cells, followed by the cell ids of
+// all the leaf octants.
+int vtkCellLocator::WriteSearchStructure(ostream &os)
+{
+  int params[4] = { this->Automatic, this->MaxLevel,
+                    this->NumberOfCellsPerNode, this->Level };
+  vtkLocator::WriteCacheBlock(os, params, sizeof(params));
+  vtkLocator::WriteCacheBlock(os, &this->NumberOfDivisions, sizeof(int));
+  vtkLocator::WriteCacheBlock(os, &this->NumberOfOctants, sizeof(int));
+  vtkLocator::WriteCacheBlock(os, this->Bounds, 6*sizeof(double));
+  vtkLocator::WriteCacheBlock(os, this->H, 3*sizeof(double));
+
+  vtkIdType *counts = new vtkIdType [this->NumberOfOctants];
+  vtkIdType numIds = 0;
+  int i;
+  for (i=0; i<this->NumberOfOctants; i++)
+    {
+    vtkIdList *octant = this->Tree[i];
+    if ( !octant )
+      {
+      counts[i] = -1;
+      }
+    else if ( octant == reinterpret_cast<void *>(VTK_CELL_INSIDE) )
+      {
+      counts[i] = -2;
+      }
+    else
+      {
+      counts[i] = octant->GetNumberOfIds();
+      numIds += counts[i];
+      }
+    }
+  vtkLocator::WriteCacheBlock(os, counts,
+                              this->NumberOfOctants*sizeof(vtkIdType));
+  delete [] counts;
+
+  vtkLocator::WriteCacheBlock(os, &numIds, sizeof(vtkIdType));
+  for (i=0; i<this->NumberOfOctants; i++)
+    {
+    vtkIdList *octant = this->Tree[i];
+    if ( octant && octant != reinterpret_cast<void *>(VTK_CELL_INSIDE) )
+      {
+      vtkLocator::WriteCacheBlock(os, octant->GetPointer(0),
+        octant->GetNumberOfIds()*sizeof(vtkIdType));
+      }
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkCellLocator::ReadSearchStructure(istream &is)
+{
+  // the level only depends on the data if it is computed automatically
+  int params[4];
+  int level = (this->Level > this->MaxLevel ? this->MaxLevel : this->Level);
+  if ( !vtkLocator::ReadCacheBlock(is, params, sizeof(params)) ||
+       params[0] != this->Automatic || params[1] != this->MaxLevel ||
+       params[2] != this->NumberOfCellsPerNode ||
+       (!this->Automatic && params[3] != level) ||
+       params[3] > this->MaxLevel )
+    {
+    return 0;
+    }
+
+  // the divisions and octants follow from the level as in BuildLocator()
+  int numDivs, numOctants, ndivs, prod, numOctantsForLevel, i;
+  for (ndivs=1,prod=1,numOctantsForLevel=1,i=0; i<params[3]; i++)
+    {
+    ndivs *= 2;
+    prod *= 8;
+    numOctantsForLevel += prod;
+    }
+  double bounds[6], h[3];
+  if ( !vtkLocator::ReadCacheBlock(is, &numDivs, sizeof(int)) ||
+       !vtkLocator::ReadCacheBlock(is, &numOctants, sizeof(int)) ||
+       !vtkLocator::ReadCacheBlock(is, bounds, 6*sizeof(double)) ||
+       !vtkLocator::ReadCacheBlock(is, h, 3*sizeof(double)) ||
+       numDivs != ndivs || numOctants != numOctantsForLevel )
+    {
+    return 0;
+    }
+
+  // only the parent octants may be marked as containing cells, and the
+  // counts must add up to the number of ids
+  vtkIdType *counts = new vtkIdType [numOctants];
+  vtkIdType numIds = 0, totalIds = 0;
+  int leafStart = numOctants - ndivs*ndivs*ndivs;
+  int ok = ( vtkLocator::ReadCacheBlock(is, counts,
+                                        numOctants*sizeof(vtkIdType)) &&
+             vtkLocator::ReadCacheBlock(is, &numIds, sizeof(vtkIdType)) );
+  for (i=0; ok && i<numOctants; i++)
+    {
+    if ( counts[i] < -2 || (counts[i] == -2 && i >= leafStart) )
+      {
+      ok = 0;
+      }
+    else if ( counts[i] > 0 )
+      {
+      totalIds += counts[i];
+      }
+    }
+  if ( !ok || totalIds != numIds )
+    {
+    delete [] counts;
+    return 0;
+    }
+
+  this->Level = params[3];
+  this->NumberOfDivisions = numDivs;
+  this->NumberOfOctants = numOctants;
+  for (i=0; i<6; i++)
+    {
+    this->Bounds[i] = bounds[i];
+    }
+  for (i=0; i<3; i++)
+    {
+    this->H[i] = h[i];
+    }
+
+  // every cell id must be a cell of the data set
+  vtkIdType numCells = this->DataSet->GetNumberOfCells();
+  this->Tree = new vtkIdListPtr[numOctants];
+  memset (this->Tree, 0, numOctants*sizeof(vtkIdListPtr));
+  for (i=0; ok && i<numOctants; i++)
+    {
+    if ( counts[i] == -2 )
+      {
+      this->Tree[i] = reinterpret_cast<vtkIdListPtr>(VTK_CELL_INSIDE);
+      }
+    else if ( counts[i] >= 0 )
+      {
+      vtkIdList *octant = vtkIdList::New();
+      octant->SetNumberOfIds(counts[i]);
+      this->Tree[i] = octant;
+      ok = vtkLocator::ReadCacheBlock(is, octant->GetPointer(0),
+                                      counts[i]*sizeof(vtkIdType));
+      for (vtkIdType j=0; ok && j<counts[i]; j++)
+        {
+        vtkIdType cellId = octant->GetId(j);
+        ok = ( cellId >= 0 && cellId < numCells );
+        }
+      }
+    }
+  delete [] counts;
+
+  return ok;
+}
+
 //----------------------------------------------------------------------------
 void vtkCellLocator::MarkParents(void* a, int i, int j, int k,
                                  int ndivs, int level)
@@ -134,6 +134,17 @@ public:
     vtkGenericCell *cell, vtkIdType &cellId,
     int &subId, double& dist2);
 
+  // Description:
+  // Same as FindClosestPoint() above, but safe to call from several threads
+  // at once, each with its own cell, once the locator has been built. The
+  // locator is not modified: the cells of the searched buckets are not
+  // marked as visited, so a cell lying in several buckets may be evaluated
+  // more than once.
+  void FindClosestPointConcurrently(
+    double x[3], double closestPoint[3],
+    vtkGenericCell *cell, vtkIdType &cellId,
+    int &subId, double& dist2);
+
   // Description:
   // reimplemented from vtkAbstractCellLocator to support bad compilers
   virtual vtkIdType FindClosestPointWithinRadius(
@@ -229,10 +240,36 @@ protected:
   vtkCellLocator();
   ~vtkCellLocator();
 
+  // Description:
+  // FindCell() only reads the buckets once they are built.
+  virtual int IsFindCellThreadSafe() { return 1; }
+
+  // Description:
+  // Write/read the octants to/from a cache file (see CacheFileName).
+  virtual int WriteSearchStructure(ostream &os);
+  virtual int ReadSearchStructure(istream &is);
+
   void GetBucketNeighbors(int ijk[3], int ndivs, int level);
   void GetOverlappingBuckets(double x[3], int ijk[3], double dist,
                              int prevMinLevel[3], int prevMaxLevel[3]);
 
+  // Description:
+  // Same as above, but the buckets are returned in the given list rather
+  // than in the Buckets member.
+  void GetBucketNeighbors(vtkNeighborCells *buckets, int ijk[3], int ndivs,
+                          int level);
+  void GetOverlappingBuckets(vtkNeighborCells *buckets, double x[3],
+                             int ijk[3], double dist, int prevMinLevel[3],
+                             int prevMaxLevel[3]);
+
+  // Description:
+  // Closest point search gathering the buckets in the given list. The cells
+  // are marked with the QueryNumber in visited, unless it is NULL.
+  void FindClosestPoint(double x[3], double closestPoint[3],
+                        vtkGenericCell *cell, vtkIdType &cellId,
+                        int &subId, double& dist2,
+                        vtkNeighborCells *buckets, unsigned char *visited);
+
   void ClearCellHasBeenVisited();
   void ClearCellHasBeenVisited(int id);
 
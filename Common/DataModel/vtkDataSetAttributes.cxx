@@ -710,6 +710,25 @@ void vtkDataSetAttributes::CopyData(vtkDataSetAttributes* fromPd,
     }
 }
 
+//--------------------------------------------------------------------------
+void vtkDataSetAttributes::FillData(vtkDataSetAttributes* fromPd,
+                                    vtkIdType fromId, vtkIdType toId,
+                                    vtkIdType numTuples)
+{
+  // use a private iterator so that concurrent calls do not interfere
+  vtkFieldData::BasicIterator required(this->RequiredArrays);
+  int i;
+  for(i=required.BeginIndex(); !required.End(); i=required.NextIndex())
+    {
+    vtkAbstractArray *fromData = fromPd->Data[i];
+    vtkAbstractArray *toData = this->Data[this->TargetIndices[i]];
+    for (vtkIdType j=0; j < numTuples; j++)
+      {
+      this->CopyTuple(fromData, toData, fromId, toId+j);
+      }
+    }
+}
+
 //--------------------------------------------------------------------------
 void vtkDataSetAttributes::CopyAllocate(vtkDataSetAttributes* pd,
                                         vtkIdType sze, vtkIdType ext,
@@ -1584,6 +1603,53 @@ void vtkDataSetAttributes::CopyData(vtkDataSetAttributes::FieldList& list,
     }
 }
 
+//--------------------------------------------------------------------------
+// Copy a range of tuples. Data arrays are copied in bulk when the
+// destination array already holds the destination tuples; otherwise the
+// tuples are copied (and inserted) one at a time.
+void vtkDataSetAttributes::CopyData(vtkDataSetAttributes::FieldList& list,
+                                    vtkDataSetAttributes* fromDSA,
+                                    int idx, vtkIdType fromId, vtkIdType toId,
+                                    vtkIdType numTuples)
+{
+  vtkAbstractArray *fromDA;
+  vtkAbstractArray *toDA;
+  vtkIdType j;
+  int i, numComp;
+
+  if ( numTuples <= 0 )
+    {
+    return;
+    }
+
+  for (i=0; i < list.NumberOfFields; i++)
+    {
+    if ( list.FieldIndices[i] >= 0 && list.DSAIndices[idx][i] >= 0 )
+      {
+      toDA = this->GetAbstractArray(list.FieldIndices[i]);
+      fromDA = fromDSA->GetAbstractArray(list.DSAIndices[idx][i]);
+      numComp = fromDA->GetNumberOfComponents();
+      if ( fromDA->IsA("vtkDataArray") && fromDA->GetDataType() != VTK_BIT &&
+           fromDA->GetDataType() == toDA->GetDataType() &&
+           toDA->GetNumberOfComponents() == numComp &&
+           toDA->GetNumberOfTuples() >= toId + numTuples )
+        {
+        memcpy(toDA->GetVoidPointer(toId*numComp),
+               fromDA->GetVoidPointer(fromId*numComp),
+               static_cast<size_t>(numTuples*numComp) *
+               fromDA->GetDataTypeSize());
+        }
+      else
+        {
+        for (j=0; j < numTuples; j++)
+          {
+          this->CopyTuple(fromDA, toDA, fromId+j, toId+j);
+          }
+        }
+      }
+    }
+}
+
 //--------------------------------------------------------------------------
 // Interpolate data from points and interpolation weights. Make sure that the
 // method InterpolateAllocate() has been invoked before using this method.
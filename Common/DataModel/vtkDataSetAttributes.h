@@ -451,6 +451,15 @@ public:
   // CopyAllOn/Off
   void CopyData(vtkDataSetAttributes *fromPd, vtkIdType fromId, vtkIdType toId);
 
+  // Description:
+  // Copy the attribute data of fromId to the numTuples consecutive ids
+  // starting at toId, following the same rules as CopyData(). Unlike
+  // CopyData(), this method does not modify the state of this object: if
+  // the arrays already hold the destination tuples (e.g. CopyAllocate()
+  // followed by SetNumberOfTuples()), disjoint ranges of ids may be filled
+  // from different threads, provided that no array is a vtkBitArray.
+  void FillData(vtkDataSetAttributes *fromPd, vtkIdType fromId,
+                vtkIdType toId, vtkIdType numTuples);
 
   // Description:
   // Copy a tuple of data from one data array to another. This method
@@ -533,6 +542,17 @@ public:
                 vtkDataSetAttributes* dsa, int idx, vtkIdType fromId,
                 vtkIdType toId);
 
+  // Description:
+  // A special form of CopyData() to be used with FieldLists that copies the
+  // numTuples consecutive tuples starting at fromId to the tuples starting
+  // at toId. Data arrays are copied with bulk memory copies. If the arrays
+  // already hold the destination tuples (e.g. CopyAllocate() followed by
+  // SetNumberOfTuples()), disjoint ranges of tuples may be copied from
+  // different threads, provided that no array is a vtkBitArray.
+  void CopyData(vtkDataSetAttributes::FieldList& list,
+                vtkDataSetAttributes* dsa, int idx, vtkIdType fromId,
+                vtkIdType toId, vtkIdType numTuples);
+
   // Description:
   // A special form of InterpolateAllocate() to be used with FieldLists. Use it
   // when you are interpolating data from a set of vtkDataSetAttributes.
@@ -22,10 +22,13 @@
 #include "vtkFloatArray.h"
 #include "vtkDoubleArray.h"
 #include "vtkObjectFactory.h"
+#include "vtkMultiThreader.h"
 #include "vtkIncrementalOctreeNode.h"
 #include "vtkIncrementalOctreePointLocator.h"
 
 #include <map>
+#include <cmath>
+#include <algorithm>
 #include <list>
 #include <stack>
 #include <queue>
@@ -147,6 +150,188 @@ namespace
   };
 }
 
+// ---------------------------------------------------------------------------
+// ------------------------- Batch  Point  Insertion -------------------------
+// ---------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------
+// Helper data shared by the threads of
+// vtkIncrementalOctreePointLocator::InsertUniquePoints(). Each point is first
+// looked up in the octree (pass 1). The points without an existing duplicate
+// are then binned in a uniform grid, through which each point collects the
+// preceding such points within the tolerance (pass 2). Both passes only read
+// the octree and the grid and write the slots of their own points, so they
+// run concurrently without any locking.
+namespace
+{
+  typedef std::pair< double, vtkIdType > DistanceIdPair;
+
+  struct InsertUniquePointsData
+  {
+    vtkIncrementalOctreePointLocator * Locator;
+    vtkPoints *   Points;
+    vtkPoints *   LocatorPoints;
+    int           FloatType;
+    double        Tolerance2;
+    vtkIdType     NumberOfPoints;
+    int           NumberOfThreads;
+
+    // pass 1: the coordinates as given and as stored (rounded to float if
+    // so are the locator points), and the existing duplicate, if any
+    std::vector< double >      Coords;
+    std::vector< double >      Stored;
+    std::vector< vtkIdType >   Existing;
+    std::vector< double >      ExistingDist2;
+
+    // grid of the points without an existing duplicate, in ascending order
+    // within each bin
+    double        Origin[3];
+    double        BinSize;
+    int           Divisions[3];
+    std::vector< vtkIdType >   BinOffsets;
+    std::vector< vtkIdType >   BinPoints;
+
+    // pass 2: the candidates of each point, sorted by distance and id, are
+    // kept by the thread that processed the point
+    std::vector< DistanceIdPair >   Candidates[ VTK_MAX_THREADS ];
+    std::vector< vtkIdType >        CandidateBegin;
+    std::vector< vtkIdType >        CandidateEnd;
+
+    void GetBin( const double x[3], int ijk[3] )
+      {
+      for ( int k = 0; k < 3; k ++ )
+        {
+        double t = floor(  ( x[k] - this->Origin[k] ) / this->BinSize  );
+        ijk[k] = ( t < 0.0 ) ? 0 :
+                 (  ( t >= this->Divisions[k] )
+                    ? this->Divisions[k] - 1 : static_cast< int >( t )  );
+        }
+      }
+
+    void LookupInOctree( vtkIdType begin, vtkIdType end )
+      {
+      double  pnt[3];
+      for ( vtkIdType i = begin; i < end; i ++ )
+        {
+        double * x = &this->Coords[ 3 * i ];
+        double * s = &this->Stored[ 3 * i ];
+        this->Points->GetPoint( i, x );
+        for ( int k = 0; k < 3; k ++ )
+          {
+          s[k] = this->FloatType
+                 ? static_cast< double >(  static_cast< float >( x[k] )  )
+                 : x[k];
+          }
+
+        this->Existing[i] = this->Locator->IsInsertedPoint( x );
+        this->ExistingDist2[i] = 0.0;
+        if ( this->Existing[i] > -1 && this->Tolerance2 != 0.0 )
+          {
+          this->LocatorPoints->GetPoint( this->Existing[i], pnt );
+          this->ExistingDist2[i] = vtkMath::Distance2BetweenPoints( x, pnt );
+          }
+        }
+      }
+
+    void FindCandidates( vtkIdType begin, vtkIdType end, int threadId )
+      {
+      std::vector< DistanceIdPair > & candidates = this->Candidates[ threadId ];
+      int  ijk[3], lo[3], hi[3];
+
+      for ( vtkIdType i = begin; i < end; i ++ )
+        {
+        this->CandidateBegin[i] = static_cast< vtkIdType >( candidates.size() );
+
+        if ( this->Tolerance2 == 0.0 )
+          {
+          // exact duplicates share the bin of their stored coordinates and
+          // only the first one may have been inserted
+          const double * s = &this->Stored[ 3 * i ];
+          this->GetBin( s, ijk );
+          vtkIdType bin = ijk[0] +
+            this->Divisions[0] * ( ijk[1] + this->Divisions[1] * ijk[2] );
+          for ( vtkIdType b = this->BinOffsets[ bin ];
+                b < this->BinOffsets[ bin + 1 ] && this->BinPoints[b] < i;
+                b ++ )
+            {
+            const double * t = &this->Stored[ 3 * this->BinPoints[b] ];
+            if ( s[0] == t[0] && s[1] == t[1] && s[2] == t[2] )
+              {
+              candidates.push_back( DistanceIdPair( 0.0, this->BinPoints[b] ) );
+              break;
+              }
+            }
+          }
+        else
+          {
+          // the bins are not smaller than the tolerance
+          const double * x = &this->Coords[ 3 * i ];
+          this->GetBin( x, ijk );
+          for ( int k = 0; k < 3; k ++ )
+            {
+            lo[k] = ( ijk[k] > 0 ) ? ijk[k] - 1 : 0;
+            hi[k] = ( ijk[k] < this->Divisions[k] - 1 ) ? ijk[k] + 1 : ijk[k];
+            }
+          for ( int z = lo[2]; z <= hi[2]; z ++ )
+            {
+            for ( int y = lo[1]; y <= hi[1]; y ++ )
+              {
+              for ( int c = lo[0]; c <= hi[0]; c ++ )
+                {
+                vtkIdType bin = c +
+                  this->Divisions[0] * ( y + this->Divisions[1] * z );
+                for ( vtkIdType b = this->BinOffsets[ bin ];
+                      b < this->BinOffsets[ bin + 1 ] && this->BinPoints[b] < i;
+                      b ++ )
+                  {
+                  vtkIdType j = this->BinPoints[b];
+                  double dist2 = vtkMath::Distance2BetweenPoints
+                                 (  x, &this->Stored[ 3 * j ]  );
+                  if ( dist2 <= this->Tolerance2 )
+                    {
+                    candidates.push_back( DistanceIdPair( dist2, j ) );
+                    }
+                  }
+                }
+              }
+            }
+          std::sort( candidates.begin() + this->CandidateBegin[i],
+                     candidates.end() );
+          }
+
+        this->CandidateEnd[i] = static_cast< vtkIdType >( candidates.size() );
+        }
+      }
+  };
+
+  VTK_THREAD_RETURN_TYPE InsertUniquePointsLookupExecute( void * arg )
+  {
+    vtkMultiThreader::ThreadInfo * info =
+      static_cast< vtkMultiThreader::ThreadInfo * >( arg );
+    InsertUniquePointsData * data =
+      static_cast< InsertUniquePointsData * >( info->UserData );
+    vtkIdType num = data->NumberOfPoints;
+    int  numThreads = data->NumberOfThreads;
+    data->LookupInOctree( num * info->ThreadID / numThreads,
+                          num * ( info->ThreadID + 1 ) / numThreads );
+    return VTK_THREAD_RETURN_VALUE;
+  }
+
+  VTK_THREAD_RETURN_TYPE InsertUniquePointsCandidatesExecute( void * arg )
+  {
+    vtkMultiThreader::ThreadInfo * info =
+      static_cast< vtkMultiThreader::ThreadInfo * >( arg );
+    InsertUniquePointsData * data =
+      static_cast< InsertUniquePointsData * >( info->UserData );
+    vtkIdType num = data->NumberOfPoints;
+    int  numThreads = data->NumberOfThreads;
+    data->FindCandidates( num * info->ThreadID / numThreads,
+                          num * ( info->ThreadID + 1 ) / numThreads,
+                          info->ThreadID );
+    return VTK_THREAD_RETURN_VALUE;
+  }
+}
+
 // ---------------------------------------------------------------------------
 // --------------------- vtkIncrementalOctreePointLocator --------------------
 // ---------------------------------------------------------------------------
@@ -158,6 +343,8 @@ vtkIncrementalOctreePointLocator::vtkIncrementalOctreePointLocator()
   this->OctreeMaxDimSize = 0;
   this->BuildCubicOctree = 0;
   this->MaxPointsPerLeaf = 128;
+  this->NumberOfThreads  =
+    vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
   this->InsertTolerance2 = 0.000001;
   this->LocatorPoints  = NULL;
   this->OctreeRootNode = NULL;
@@ -290,6 +477,7 @@ void vtkIncrementalOctreePointLocator::PrintSelf( ostream & os, vtkIndent indent
   os << indent << "OctreeRootNode: "   << this->OctreeRootNode   << endl;
   os << indent << "BuildCubicOctree: " << this->BuildCubicOctree << endl;
   os << indent << "MaxPointsPerLeaf: " << this->MaxPointsPerLeaf << endl;
+  os << indent << "NumberOfThreads: "  << this->NumberOfThreads  << endl;
   os << indent << "InsertTolerance2: " << this->InsertTolerance2 << endl;
   os << indent << "OctreeMaxDimSize: " << this->OctreeMaxDimSize << endl;
 }
@@ -1343,6 +1531,175 @@ int vtkIncrementalOctreePointLocator::InsertUniquePoint( const double point[3],
          );
 }
 
+//----------------------------------------------------------------------------
+void vtkIncrementalOctreePointLocator::InsertUniquePoints( vtkPoints * points,
+                                                          vtkIdList * ptIds )
+{
+  vtkIdType  numPts = ( points ? points->GetNumberOfPoints() : 0 );
+  ptIds->SetNumberOfIds( numPts );
+  if ( numPts == 0 )
+    {
+    return;
+    }
+
+  if ( this->OctreeRootNode == NULL )
+    {
+    vtkErrorMacro( << "InitPointInsertion() should have been called" );
+    return;
+    }
+
+  InsertUniquePointsData data;
+  data.Locator         = this;
+  data.Points          = points;
+  data.LocatorPoints   = this->LocatorPoints;
+  data.FloatType       = ( this->LocatorPoints->GetDataType() == VTK_FLOAT );
+  data.Tolerance2      = this->InsertTolerance2;
+  data.NumberOfPoints  = numPts;
+  data.NumberOfThreads = ( this->NumberOfThreads > numPts )
+                         ? static_cast< int >( numPts ) : this->NumberOfThreads;
+  data.Coords.resize( 3 * numPts );
+  data.Stored.resize( 3 * numPts );
+  data.Existing.resize( numPts );
+  data.ExistingDist2.resize( numPts );
+  data.CandidateBegin.resize( numPts );
+  data.CandidateEnd.resize( numPts );
+
+  vtkMultiThreader * threader = NULL;
+  if ( data.NumberOfThreads > 1 )
+    {
+    threader = vtkMultiThreader::New();
+    threader->SetNumberOfThreads( data.NumberOfThreads );
+    threader->SetSingleMethod( InsertUniquePointsLookupExecute, &data );
+    threader->SingleMethodExecute();
+    }
+  else
+    {
+    data.LookupInOctree( 0, numPts );
+    }
+
+  // bin the points without an existing duplicate: these are the only ones
+  // that may be inserted. The bins are at least as large as the tolerance
+  // and their number is about that of the binned points.
+  vtkIdType  i, numBinned = 0;
+  double     bounds[6] = { VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX,
+                           VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX,
+                           VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX };
+  for ( i = 0; i < numPts; i ++ )
+    {
+    if ( data.Existing[i] == -1 )
+      {
+      const double * s = &data.Stored[ 3 * i ];
+      for ( int k = 0; k < 3; k ++ )
+        {
+        bounds[ 2 * k     ] = ( s[k] < bounds[ 2 * k ] )
+                              ? s[k] : bounds[ 2 * k ];
+        bounds[ 2 * k + 1 ] = ( s[k] > bounds[ 2 * k + 1 ] )
+                              ? s[k] : bounds[ 2 * k + 1 ];
+        }
+      numBinned ++;
+      }
+    }
+
+  double  sizes[3], maxSize = 0.0;
+  for ( int k = 0; k < 3; k ++ )
+    {
+    data.Origin[k] = ( numBinned > 0 ) ? bounds[ 2 * k ] : 0.0;
+    sizes[k] = ( numBinned > 0 ) ? bounds[ 2 * k + 1 ] - bounds[ 2 * k ] : 0.0;
+    maxSize  = ( sizes[k] > maxSize ) ? sizes[k] : maxSize;
+    }
+  data.BinSize = maxSize / ceil(  pow( static_cast< double >( numBinned + 1 ),
+                                       1.0 / 3.0 )  );
+  // the bins are made slightly larger than the tolerance such that rounding
+  // never puts two points within the tolerance two bins apart
+  double  tolerance = 1.0001 * sqrt( this->InsertTolerance2 );
+  data.BinSize = ( tolerance > data.BinSize ) ? tolerance : data.BinSize;
+  data.BinSize = ( data.BinSize > 0.0 ) ? data.BinSize : 1.0;
+
+  vtkIdType  numBins = 1;
+  for ( int k = 0; k < 3; k ++ )
+    {
+    data.Divisions[k] = static_cast< int >( sizes[k] / data.BinSize ) + 1;
+    numBins *= data.Divisions[k];
+    }
+
+  // counting sort, which keeps the points of a bin in ascending order
+  int  ijk[3];
+  std::vector< vtkIdType >  binOfPoint( numPts, -1 );
+  data.BinOffsets.assign( numBins + 1, 0 );
+  data.BinPoints.resize( numBinned );
+  for ( i = 0; i < numPts; i ++ )
+    {
+    if ( data.Existing[i] == -1 )
+      {
+      data.GetBin( &data.Stored[ 3 * i ], ijk );
+      binOfPoint[i] = ijk[0] +
+        data.Divisions[0] * ( ijk[1] + data.Divisions[1] * ijk[2] );
+      data.BinOffsets[ binOfPoint[i] + 1 ] ++;
+      }
+    }
+  for ( vtkIdType b = 0; b < numBins; b ++ )
+    {
+    data.BinOffsets[ b + 1 ] += data.BinOffsets[b];
+    }
+  std::vector< vtkIdType >  binFill( data.BinOffsets.begin(),
+                                     data.BinOffsets.end() - 1 );
+  for ( i = 0; i < numPts; i ++ )
+    {
+    if ( binOfPoint[i] > -1 )
+      {
+      data.BinPoints[  binFill[ binOfPoint[i] ] ++  ] = i;
+      }
+    }
+
+  if ( threader )
+    {
+    threader->SetSingleMethod( InsertUniquePointsCandidatesExecute, &data );
+    threader->SingleMethodExecute();
+    threader->Delete();
+    threader = NULL;
+    }
+  else
+    {
+    data.FindCandidates( 0, numPts, 0 );
+    }
+
+  // resolve the points in their input order, exactly as InsertUniquePoint()
+  // would do one after the other: a point refers to the closest one among
+  // its existing duplicate and the preceding points actually inserted, or
+  // is inserted itself, which numbers the new points in input order
+  std::vector< vtkIdType >  newIds( numPts, -1 );
+  for ( int t = 0; t < data.NumberOfThreads; t ++ )
+    {
+    vtkIdType  begin = numPts * t / data.NumberOfThreads;
+    vtkIdType  end   = numPts * ( t + 1 ) / data.NumberOfThreads;
+    const std::vector< DistanceIdPair > & candidates = data.Candidates[t];
+    for ( i = begin; i < end; i ++ )
+      {
+      vtkIdType  pntId = data.Existing[i];
+      for ( vtkIdType c = data.CandidateBegin[i];
+            c < data.CandidateEnd[i]; c ++ )
+        {
+        vtkIdType  j = candidates[c].second;
+        if ( newIds[j] > -1 )
+          {
+          if ( pntId == -1 || candidates[c].first < data.ExistingDist2[i] )
+            {
+            pntId = newIds[j];
+            }
+          break;
+          }
+        }
+
+      if ( pntId == -1 )
+        {
+        this->InsertPointWithoutChecking( &data.Coords[ 3 * i ], pntId, 1 );
+        newIds[i] = pntId;
+        }
+      ptIds->SetId( i, pntId );
+      }
+    }
+}
+
 //----------------------------------------------------------------------------
 void vtkIncrementalOctreePointLocator::InsertPointWithoutChecking
   ( const double point[3], vtkIdType & pntId, int insert )
@@ -81,6 +81,13 @@ public:
   vtkGetMacro( BuildCubicOctree, int );
   vtkBooleanMacro( BuildCubicOctree, int );
 
+  // Description:
+  // Set/Get the number of threads used by InsertUniquePoints() to look up
+  // the points. The result does not depend on this number. It defaults to
+  // the global default number of threads of vtkMultiThreader.
+  vtkSetClampMacro( NumberOfThreads, int, 1, VTK_MAX_THREADS );
+  vtkGetMacro( NumberOfThreads, int );
+
   // Description:
   // Get access to the vtkPoints object in which point coordinates are stored
   // for either point location or point insertion.
@@ -247,6 +254,18 @@ public:
   // is invoked. This method is not thread safe.
   virtual int InsertUniquePoint( const double point[3], vtkIdType & pntId );
 
+  // Description:
+  // Insert the points of a vtkPoints object, each unless there has been a
+  // duplicate point, and return via ptIds the index of every point (either
+  // new or the duplicate). The points are looked up in the octree and among
+  // each other by NumberOfThreads threads, after which the new points are
+  // inserted in their input order. The ids are thus those returned by
+  // calling InsertUniquePoint() for each point in order, except that of two
+  // candidates at exactly the same distance from a point, the one inserted
+  // first is always chosen. InitPointInsertion() should have been called
+  // prior to this function. This method is not thread safe.
+  virtual void InsertUniquePoints( vtkPoints * points, vtkIdList * ptIds );
+
   // Description:
   // Insert a given point into the octree with a specified point index ptId.
   // InitPointInsertion() should have been called prior to this function. In
@@ -285,6 +304,7 @@ private:
 
   int         BuildCubicOctree;
   int         MaxPointsPerLeaf;
+  int         NumberOfThreads;
   double      InsertTolerance2;
   double      OctreeMaxDimSize;
   double      FudgeFactor;
@@ -13,7 +13,9 @@
 
 =========================================================================*/
 
+#include "vtkIdList.h"
 #include "vtkObjectFactory.h"
+#include "vtkPoints.h"
 #include "vtkIncrementalPointLocator.h"
 
 
@@ -30,3 +32,18 @@ void vtkIncrementalPointLocator::PrintSelf( ostream & os, vtkIndent indent )
   this->Superclass::PrintSelf( os, indent );
 }
 
+void vtkIncrementalPointLocator::InsertUniquePoints( vtkPoints * points,
+                                                     vtkIdList * ptIds )
+{
+  vtkIdType numPts = ( points ? points->GetNumberOfPoints() : 0 );
+  ptIds->SetNumberOfIds( numPts );
+
+  double x[3];
+  vtkIdType ptId;
+  for ( vtkIdType i = 0; i < numPts; i ++ )
+    {
+    points->GetPoint( i, x );
+    this->InsertUniquePoint( x, ptId );
+    ptIds->SetId( i, ptId );
+    }
+}
@@ -107,6 +107,16 @@ public:
   // This method is not thread safe.
   virtual int InsertUniquePoint( const double x[3], vtkIdType & ptId ) = 0;
 
+  // Description:
+  // Insert the points of a vtkPoints object, each unless there has been a
+  // duplicate in the search structure, and return via ptIds the index of every
+  // point (either new or the duplicate). The result is that of calling
+  // InsertUniquePoint() for each point in order, so the new points are
+  // numbered in their input order. This implementation does exactly that;
+  // subclasses may process the points concurrently. InitPointInsertion()
+  // should have been called in advance. This method is not thread safe.
+  virtual void InsertUniquePoints( vtkPoints * points, vtkIdList * ptIds );
+
   // Description:
   // Insert a given point with a specified point index ptId. InitPointInsertion()
   // should have been called prior to this function. Also, IsInsertedPoint()
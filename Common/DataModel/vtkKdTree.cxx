@@ -41,6 +41,8 @@
 #include "vtkUniformGrid.h"
 #include "vtkRectilinearGrid.h"
 #include "vtkCallbackCommand.h"
+#include "vtkCriticalSection.h"
+#include "vtkMultiThreader.h"
 
 #ifdef _MSC_VER
 #pragma warning ( disable : 4100 )
@@ -50,6 +52,7 @@
 #include <map>
 #include <queue>
 #include <set>
+#include <vector>
 
 
 // Timing data ---------------------------------------------
@@ -174,6 +177,117 @@ namespace
   };
 }
 
+//----------------------------------------------------------------------------
+// Parallel construction: the top levels of the tree are divided serially,
+// leaving the regions below them as tasks that the threads take in turn.
+// The regions of the tasks hold disjoint ranges of the point array.
+class vtkKdTreeRegionTasks
+{
+public:
+  struct Task
+  {
+    vtkKdNode *Node;
+    float     *Points;
+    int       *Ids;
+    int        Level;
+  };
+
+  vtkKdTree               *Tree;
+  std::vector<Task>        Tasks;
+  int                      Level;     // level of the deferred regions
+  size_t                   NextTask;
+  vtkSimpleCriticalSection Lock;
+
+  void Defer(vtkKdNode *kd, float *c1, int *ids, int level)
+  {
+    Task task;
+    task.Node = kd;
+    task.Points = c1;
+    task.Ids = ids;
+    task.Level = level;
+    this->Tasks.push_back(task);
+  }
+
+  void Run()
+  {
+    while (true)
+      {
+      this->Lock.Lock();
+      size_t next = this->NextTask++;
+      this->Lock.Unlock();
+      if (next >= this->Tasks.size())
+        {
+        break;
+        }
+      Task &task = this->Tasks[next];
+      this->Tree->DivideRegion(task.Node, task.Points, task.Ids, task.Level);
+      }
+  }
+};
+
+static VTK_THREAD_RETURN_TYPE vtkKdTreeDivideRegionsExecute(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  static_cast<vtkKdTreeRegionTasks *>(info->UserData)->Run();
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+// Batch neighbor queries: each thread queries a contiguous range of the
+// points into a list of its own, and stores the number of neighbors of
+// every point. The lists are concatenated in order once all are done.
+namespace
+{
+struct vtkKdTreeFindNeighbors
+{
+  vtkKdTree *Tree;
+  vtkPoints *Points;
+  int N;          // number of neighbors, or
+  double Radius;  // radius of the search when N is 0
+  vtkIdType *Counts;
+  std::vector<vtkIdType> Neighbors[VTK_MAX_THREADS];
+  int NumberOfThreads;
+};
+}
+
+static void vtkKdTreeFindNeighborsRange(vtkKdTreeFindNeighbors *str,
+                                        int threadId)
+{
+  vtkIdType numPts = str->Points->GetNumberOfPoints();
+  vtkIdType begin = numPts * threadId / str->NumberOfThreads;
+  vtkIdType end = numPts * (threadId+1) / str->NumberOfThreads;
+  std::vector<vtkIdType> &neighbors = str->Neighbors[threadId];
+  vtkIdList *result = vtkIdList::New();
+  double x[3];
+  for (vtkIdType i = begin; i < end; i++)
+    {
+    str->Points->GetPoint(i, x);
+    if (str->N > 0)
+      {
+      str->Tree->FindClosestNPoints(str->N, x, result);
+      }
+    else
+      {
+      str->Tree->FindPointsWithinRadius(str->Radius, x, result);
+      }
+    vtkIdType numIds = result->GetNumberOfIds();
+    neighbors.insert(neighbors.end(), result->GetPointer(0),
+                     result->GetPointer(0) + numIds);
+    str->Counts[i] = numIds;
+    }
+  result->Delete();
+}
+
+static VTK_THREAD_RETURN_TYPE vtkKdTreeFindNeighborsExecute(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkKdTreeFindNeighborsRange(
+    static_cast<vtkKdTreeFindNeighbors *>(info->UserData), info->ThreadID);
+  return VTK_THREAD_RETURN_VALUE;
+}
+
 vtkStandardNewMacro(vtkKdTree);
 
 //----------------------------------------------------------------------------
@@ -192,6 +306,8 @@ vtkKdTree::vtkKdTree()
 
   this->MinCells = 100;
   this->NumberOfRegions     = 0;
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  this->RegionTasks = NULL;
 
   this->DataSets = vtkDataSetCollection::New();
 
@@ -861,6 +977,7 @@ void vtkKdTree::BuildLocator()
     }
   TIMERDONE("Set up to build k-d tree");
 
+  int cached = 0;
   if (this->UserDefinedCuts)
     {
     // Actually, we will not compute the k-d tree.  We will use a
@@ -873,6 +990,12 @@ void vtkKdTree::BuildLocator()
       return;
       }
     }
+  else if (this->ReadCacheFile())
+    {
+    // The k-d tree was computed for the same data sets before.
+
+    cached = 1;
+    }
   else
     {
     // cell centers - basis of spatial decomposition
@@ -908,7 +1031,7 @@ void vtkKdTree::BuildLocator()
 
     this->ProgressOffset += this->ProgressScale;
     this->ProgressScale = 0.7;
-    this->DivideRegion(kd, ptarray, NULL, 0);
+    this->DivideRegions(kd, ptarray, NULL);
 
     TIMERDONE("Build tree");
 
@@ -919,6 +1042,11 @@ void vtkKdTree::BuildLocator()
     delete [] ptarray;
     }
 
+  if (!this->UserDefinedCuts && !cached)
+    {
+    this->WriteCacheFile();
+    }
+
   this->SetActualLevel();
   this->BuildRegionList();
 
@@ -984,6 +1112,154 @@ int vtkKdTree::ProcessUserDefinedCuts(double *minBounds)
 
   return 0;
 }
+//----------------------------------------------------------------------------
+// The nodes are stored in depth first order, each as six integers (whether
+// it has children, the cut dimension, the region ids and the number of
+// cells) and twelve doubles (the spatial and the data bounds).
+static void vtkKdTreeStoreNodes(vtkKdNode *kd, std::vector<int> &ints,
+                                std::vector<double> &doubles)
+{
+  ints.push_back(kd->GetLeft() ? 1 : 0);
+  ints.push_back(kd->GetDim());
+  ints.push_back(kd->GetID());
+  ints.push_back(kd->GetMinID());
+  ints.push_back(kd->GetMaxID());
+  ints.push_back(kd->GetNumberOfPoints());
+  doubles.insert(doubles.end(), kd->GetMinBounds(), kd->GetMinBounds() + 3);
+  doubles.insert(doubles.end(), kd->GetMaxBounds(), kd->GetMaxBounds() + 3);
+  doubles.insert(doubles.end(), kd->GetMinDataBounds(),
+                 kd->GetMinDataBounds() + 3);
+  doubles.insert(doubles.end(), kd->GetMaxDataBounds(),
+                 kd->GetMaxDataBounds() + 3);
+
+  if (kd->GetLeft())
+    {
+    vtkKdTreeStoreNodes(kd->GetLeft(), ints, doubles);
+    vtkKdTreeStoreNodes(kd->GetRight(), ints, doubles);
+    }
+}
+
+//----------------------------------------------------------------------------
+// The nodes read are checked as BuildLocator() would have made them, since
+// the searches index arrays with the cut dimensions: the cuts are along x,
+// y or z, the tree is no deeper than maxLevel, and the cells of a node are
+// split among its children. The region ids are assigned by
+// BuildRegionList() afterwards.
+static bool vtkKdTreeRestoreNodes(vtkKdNode *kd, const std::vector<int> &ints,
+                                  const std::vector<double> &doubles,
+                                  size_t &next, int level, int maxLevel)
+{
+  if (6 * (next + 1) > ints.size() || level > maxLevel)
+    {
+    return false;
+    }
+  const int *i = &ints[6 * next];
+  const double *d = &doubles[12 * next];
+  next++;
+
+  if (i[1] < 0 || i[1] > (i[0] ? 2 : 3) || i[5] < 0)
+    {
+    return false;
+    }
+  for (int j = 0; j < 3; j++)
+    {
+    if (!(d[j] <= d[j + 3]))
+      {
+      return false;
+      }
+    }
+
+  kd->SetDim(i[1]);
+  kd->SetID(i[2]);
+  kd->SetMinID(i[3]);
+  kd->SetMaxID(i[4]);
+  kd->SetNumberOfPoints(i[5]);
+  kd->SetMinBounds(const_cast<double *>(d));
+  kd->SetMaxBounds(const_cast<double *>(d + 3));
+  kd->SetMinDataBounds(const_cast<double *>(d + 6));
+  kd->SetMaxDataBounds(const_cast<double *>(d + 9));
+
+  if (!i[0])
+    {
+    return true;
+    }
+
+  vtkKdNode *left = vtkKdNode::New();
+  vtkKdNode *right = vtkKdNode::New();
+  kd->AddChildNodes(left, right);
+  return vtkKdTreeRestoreNodes(left, ints, doubles, next, level + 1,
+                               maxLevel) &&
+         vtkKdTreeRestoreNodes(right, ints, doubles, next, level + 1,
+                               maxLevel) &&
+         i[5] == left->GetNumberOfPoints() + right->GetNumberOfPoints();
+}
+
+//----------------------------------------------------------------------------
+int vtkKdTree::WriteSearchStructure(ostream &os)
+{
+  int params[5] = { this->MaxLevel, this->MinCells,
+                    this->NumberOfRegionsOrLess, this->NumberOfRegionsOrMore,
+                    this->ValidDirections };
+  std::vector<int> ints;
+  std::vector<double> doubles;
+  vtkKdTreeStoreNodes(this->Top, ints, doubles);
+  int numNodes = static_cast<int>(ints.size() / 6);
+
+  vtkLocator::WriteCacheBlock(os, params, sizeof(params));
+  vtkLocator::WriteCacheBlock(os, &numNodes, sizeof(int));
+  vtkLocator::WriteCacheBlock(os, &ints[0], ints.size() * sizeof(int));
+  vtkLocator::WriteCacheBlock(os, &doubles[0],
+                              doubles.size() * sizeof(double));
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkKdTree::ReadSearchStructure(istream &is)
+{
+  int params[5], numNodes;
+  if (!vtkLocator::ReadCacheBlock(is, params, sizeof(params)) ||
+      params[0] != this->MaxLevel || params[1] != this->MinCells ||
+      params[2] != this->NumberOfRegionsOrLess ||
+      params[3] != this->NumberOfRegionsOrMore ||
+      params[4] != this->ValidDirections ||
+      !vtkLocator::ReadCacheBlock(is, &numNodes, sizeof(int)) ||
+      numNodes < 1)
+    {
+    return 0;
+    }
+
+  std::vector<int> ints(6 * numNodes);
+  std::vector<double> doubles(12 * numNodes);
+  if (!vtkLocator::ReadCacheBlock(is, &ints[0], ints.size() * sizeof(int)) ||
+      !vtkLocator::ReadCacheBlock(is, &doubles[0],
+                                  doubles.size() * sizeof(double)))
+    {
+    return 0;
+    }
+
+  size_t next = 0;
+  this->Top = vtkKdNode::New();
+  return (vtkKdTreeRestoreNodes(this->Top, ints, doubles, next, 0,
+                                this->MaxLevel) &&
+          next == static_cast<size_t>(numNodes) &&
+          this->Top->GetNumberOfPoints() == this->GetNumberOfCells()) ? 1 : 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkKdTree::ComputeDataDigest(char digest[33])
+{
+  std::vector<vtkDataSet *> dataSets;
+  vtkCollectionSimpleIterator cookie;
+  this->DataSets->InitTraversal(cookie);
+  for (vtkDataSet *iset = this->DataSets->GetNextDataSet(cookie);
+       iset != NULL; iset = this->DataSets->GetNextDataSet(cookie))
+    {
+    dataSets.push_back(iset);
+    }
+  vtkLocator::ComputeDataSetsDigest(dataSets.empty() ? NULL : &dataSets[0],
+    static_cast<int>(dataSets.size()), digest);
+}
+
 //----------------------------------------------------------------------------
 void vtkKdTree::ZeroNumberOfPoints(vtkKdNode *kd)
 {
@@ -1234,6 +1510,44 @@ int vtkKdTree::DivideTest(int size, int level)
 
   return 1;
 }
+//----------------------------------------------------------------------------
+void vtkKdTree::DivideRegions(vtkKdNode *kd, float *c1, int *ids)
+{
+  int numThreads = this->NumberOfThreads;
+  if (numThreads > kd->GetNumberOfPoints())
+    {
+    numThreads = kd->GetNumberOfPoints();
+    }
+  if (numThreads <= 1)
+    {
+    this->DivideRegion(kd, c1, ids, 0);
+    return;
+    }
+
+  // Enough regions for the threads to balance their load
+  vtkKdTreeRegionTasks tasks;
+  tasks.Tree = this;
+  tasks.NextTask = 0;
+  tasks.Level = 0;
+  while ((1 << tasks.Level) < 8*numThreads)
+    {
+    tasks.Level++;
+    }
+
+  this->RegionTasks = &tasks;
+  this->DivideRegion(kd, c1, ids, 0);
+  this->RegionTasks = NULL;
+
+  if (!tasks.Tasks.empty())
+    {
+    vtkMultiThreader *threader = vtkMultiThreader::New();
+    threader->SetNumberOfThreads(numThreads);
+    threader->SetSingleMethod(vtkKdTreeDivideRegionsExecute, &tasks);
+    threader->SingleMethodExecute();
+    threader->Delete();
+    }
+}
+
 //----------------------------------------------------------------------------
 int vtkKdTree::DivideRegion(vtkKdNode *kd, float *c1, int *ids, int level)
 {
@@ -1244,6 +1558,12 @@ int vtkKdTree::DivideRegion(vtkKdNode *kd, float *c1, int *ids, int level)
     return 0;
     }
 
+  if (this->RegionTasks && level == this->RegionTasks->Level)
+    {
+    this->RegionTasks->Defer(kd, c1, ids, level);
+    return 0;
+    }
+
   int maxdim = this->SelectCutDirection(kd);
 
   kd->SetDim(maxdim);
@@ -1869,7 +2189,7 @@ void vtkKdTree::BuildLocatorFromPoints(vtkPoints **ptArrays, int numPtArrays)
 
   TIMER("Build tree");
 
-  this->DivideRegion(kd, points, ptIds, 0);
+  this->DivideRegions(kd, points, ptIds);
 
   this->SetActualLevel();
   this->BuildRegionList();
@@ -2728,6 +3048,102 @@ void vtkKdTree::FindClosestNPoints(int N, const double x[3],
 }
 
 
+//----------------------------------------------------------------------------
+void vtkKdTree::FindClosestNPoints(int N, vtkPoints *points,
+                                   vtkIdTypeArray *offsets,
+                                   vtkIdTypeArray *ids)
+{
+  offsets->Reset();
+  ids->Reset();
+  if (!this->LocatorPoints)
+    {
+    vtkErrorMacro(<< "vtkKdTree::FindClosestNPoints - must build locator first");
+    return;
+    }
+
+  // Warn once rather than for every point
+  int numTotalPoints = this->Top->GetNumberOfPoints();
+  if (numTotalPoints < N)
+    {
+    vtkWarningMacro("Number of requested points is greater than total number of points in KdTree");
+    N = numTotalPoints;
+    }
+  if (N <= 0)
+    {
+    offsets->SetNumberOfValues(points->GetNumberOfPoints() + 1);
+    offsets->FillComponent(0, 0);
+    return;
+    }
+
+  this->FindNeighbors(N, 0.0, points, offsets, ids);
+}
+
+//----------------------------------------------------------------------------
+void vtkKdTree::FindPointsWithinRadius(double R, vtkPoints *points,
+                                       vtkIdTypeArray *offsets,
+                                       vtkIdTypeArray *ids)
+{
+  offsets->Reset();
+  ids->Reset();
+  if (!this->LocatorPoints)
+    {
+    vtkErrorMacro(<< "vtkKdTree::FindPointsWithinRadius - must build locator first");
+    return;
+    }
+
+  this->FindNeighbors(0, R, points, offsets, ids);
+}
+
+//----------------------------------------------------------------------------
+void vtkKdTree::FindNeighbors(int N, double R, vtkPoints *points,
+                              vtkIdTypeArray *offsets, vtkIdTypeArray *ids)
+{
+  vtkIdType numPts = points->GetNumberOfPoints();
+  offsets->SetNumberOfValues(numPts + 1);
+  vtkIdType *offsetPtr = offsets->GetPointer(0);
+  offsetPtr[0] = 0;
+  if (numPts == 0)
+    {
+    return;
+    }
+
+  vtkKdTreeFindNeighbors str;
+  str.Tree = this;
+  str.Points = points;
+  str.N = N;
+  str.Radius = R;
+  str.Counts = offsetPtr + 1;
+  str.NumberOfThreads = ( this->NumberOfThreads > numPts ?
+                          static_cast<int>(numPts) : this->NumberOfThreads );
+
+  if (str.NumberOfThreads > 1)
+    {
+    vtkMultiThreader *threader = vtkMultiThreader::New();
+    threader->SetNumberOfThreads(str.NumberOfThreads);
+    threader->SetSingleMethod(vtkKdTreeFindNeighborsExecute, &str);
+    threader->SingleMethodExecute();
+    threader->Delete();
+    }
+  else
+    {
+    vtkKdTreeFindNeighborsRange(&str, 0);
+    }
+
+  for (vtkIdType i = 0; i < numPts; i++)
+    {
+    offsetPtr[i+1] += offsetPtr[i];
+    }
+  vtkIdType *idPtr = ids->WritePointer(0, offsetPtr[numPts]);
+  for (int t = 0; t < str.NumberOfThreads; t++)
+    {
+    if (!str.Neighbors[t].empty())
+      {
+      std::copy(str.Neighbors[t].begin(), str.Neighbors[t].end(), idPtr);
+      idPtr += str.Neighbors[t].size();
+      }
+    }
+}
+
 //----------------------------------------------------------------------------
 vtkIdTypeArray *vtkKdTree::GetPointsInRegion(int regionId)
 {
@@ -4751,6 +5167,7 @@ void vtkKdTree::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "NumberOfRegionsOrMore: " << this->NumberOfRegionsOrMore << endl;
 
   os << indent << "NumberOfRegions: " << this->NumberOfRegions << endl;
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << endl;
 
   os << indent << "DataSets: " << this->DataSets << endl;
 
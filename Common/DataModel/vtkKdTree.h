@@ -68,6 +68,7 @@ class vtkKdNode;
 class vtkBSPCuts;
 class vtkBSPIntersections;
 class vtkDataSetCollection;
+class vtkKdTreeRegionTasks;
 
 class VTKCOMMONDATAMODEL_EXPORT vtkKdTree : public vtkLocator
 {
@@ -115,6 +116,14 @@ public:
   vtkGetMacro(FudgeFactor, double);
   vtkSetMacro(FudgeFactor, double);
 
+  // Description:
+  //  Set/Get the number of threads used to build the k-d tree, and by the
+  //  batch versions of FindClosestNPoints() and FindPointsWithinRadius().
+  //  The tree is the same whatever the number of threads.  Defaults to
+  //  the number of available processors.
+  vtkSetClampMacro(NumberOfThreads, int, 1, VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads, int);
+
   // Description:
   //   Get a vtkBSPCuts object, a general object representing an axis-
   //   aligned spatial partitioning.  Used by vtkBSPIntersections.
@@ -342,7 +351,9 @@ public:
   // Description:
   // Create the k-d tree decomposition of the cells of the data set
   // or data sets.  Cells are assigned to k-d tree spatial regions
-  // based on the location of their centroids.
+  // based on the location of their centroids. Unless the cuts are user
+  // defined, the regions are loaded from CacheFileName when that file was
+  // written for the same data sets and parameters (see vtkLocator).
   void BuildLocator();
 
   // Description:
@@ -475,6 +486,21 @@ public:
   // indirectly called from a single thread first.
   void FindClosestNPoints(int N, const double x[3], vtkIdList *result);
 
+  // Description:
+  // Batch versions of FindClosestNPoints() and FindPointsWithinRadius():
+  // find the neighbors of every point of a vtkPoints.  The points are
+  // distributed over NumberOfThreads threads.  The neighbors are returned
+  // in compressed rows: the ids of the neighbors of point i are
+  // ids[offsets[i]] to ids[offsets[i+1]-1], so offsets holds one more
+  // value than there are points.  The neighbors of each point are listed
+  // in the order of the single point query, whatever the number of
+  // threads.  You must have called BuildLocatorFromPoints() before
+  // calling these.
+  void FindClosestNPoints(int N, vtkPoints *points,
+                          vtkIdTypeArray *offsets, vtkIdTypeArray *ids);
+  void FindPointsWithinRadius(double R, vtkPoints *points,
+                              vtkIdTypeArray *offsets, vtkIdTypeArray *ids);
+
   // Description:
   // Get a list of the original IDs of all points in a region.  You
   // must have called BuildLocatorFromPoints before calling this.
@@ -551,6 +577,13 @@ protected:
 
   int ProcessUserDefinedCuts(double *bounds);
 
+  // Description:
+  // Write/read the tree of regions to/from a cache file. The data sets
+  // the regions are computed from are those of the DataSets collection.
+  virtual int WriteSearchStructure(ostream &os);
+  virtual int ReadSearchStructure(istream &is);
+  virtual void ComputeDataDigest(char digest[33]);
+
   void SetCuts(vtkBSPCuts *cuts, int userDefined);
 
   // Description:
@@ -677,11 +710,24 @@ protected:
   // Recursive helper for public FindPointsInArea
   void FindPointsInArea(vtkKdNode* node, double* area, vtkIdTypeArray* ids);
 
+  // Helper for the batch FindClosestNPoints (N > 0) and
+  // FindPointsWithinRadius (N = 0)
+  void FindNeighbors(int N, double R, vtkPoints *points,
+                     vtkIdTypeArray *offsets, vtkIdTypeArray *ids);
+
   // Recursive helper for public FindPointsInArea
   void AddAllPointsInRegion(vtkKdNode* node, vtkIdTypeArray* ids);
 
   int DivideRegion(vtkKdNode *kd, float *c1, int *ids, int nlevels);
 
+  // Divide the tree below kd with DivideRegion().  Once the top levels are
+  // divided, the regions below them are divided by NumberOfThreads threads.
+  void DivideRegions(vtkKdNode *kd, float *c1, int *ids);
+
+  // Regions left to divide by the threads, while the top levels are built
+  vtkKdTreeRegionTasks *RegionTasks;
+  friend class vtkKdTreeRegionTasks;
+
   void DoMedianFind(vtkKdNode *kd, float *c1, int *ids, int d1, int d2, int d3);
 
   void SelfRegister(vtkKdNode *kd);
@@ -796,6 +842,7 @@ protected:
 
   int MinCells;
   int NumberOfRegions;              // number of leaf nodes
+  int NumberOfThreads;
 
   int Timing;
   double FudgeFactor;   // a very small distance, relative to the dataset's size
@@ -15,6 +15,7 @@
 #include "vtkKdTreePointLocator.h"
 
 #include "vtkKdTree.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointSet.h"
 
@@ -23,6 +24,7 @@ vtkStandardNewMacro(vtkKdTreePointLocator);
 vtkKdTreePointLocator::vtkKdTreePointLocator()
 {
   this->KdTree = 0;
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
 }
 
 vtkKdTreePointLocator::~vtkKdTreePointLocator()
@@ -62,6 +64,24 @@ void vtkKdTreePointLocator::FindPointsWithinRadius(double R, const double x[3],
   this->KdTree->FindPointsWithinRadius(R, x, result);
 }
 
+void vtkKdTreePointLocator::FindClosestNPoints(int N, vtkPoints *points,
+                                               vtkIdTypeArray *offsets,
+                                               vtkIdTypeArray *ids)
+{
+  this->BuildLocator();
+  this->KdTree->SetNumberOfThreads(this->NumberOfThreads);
+  this->KdTree->FindClosestNPoints(N, points, offsets, ids);
+}
+
+void vtkKdTreePointLocator::FindPointsWithinRadius(double R, vtkPoints *points,
+                                                   vtkIdTypeArray *offsets,
+                                                   vtkIdTypeArray *ids)
+{
+  this->BuildLocator();
+  this->KdTree->SetNumberOfThreads(this->NumberOfThreads);
+  this->KdTree->FindPointsWithinRadius(R, points, offsets, ids);
+}
+
 void vtkKdTreePointLocator::FreeSearchStructure()
 {
   if(this->KdTree)
@@ -82,6 +102,7 @@ void vtkKdTreePointLocator::BuildLocator()
       return;
       }
     this->KdTree = vtkKdTree::New();
+    this->KdTree->SetNumberOfThreads(this->NumberOfThreads);
     this->KdTree->BuildLocatorFromPoints(pointSet);
     this->KdTree->GetBounds(this->Bounds);
     this->Modified();
@@ -99,5 +120,6 @@ void vtkKdTreePointLocator::PrintSelf(ostream& os, vtkIndent indent)
   this->Superclass::PrintSelf(os,indent);
 
   os << indent << "KdTree " << this->KdTree << "\n";
+  os << indent << "NumberOfThreads " << this->NumberOfThreads << "\n";
 }
 
@@ -27,7 +27,9 @@
 #include "vtkAbstractPointLocator.h"
 
 class vtkIdList;
+class vtkIdTypeArray;
 class vtkKdTree;
+class vtkPoints;
 
 class VTKCOMMONDATAMODEL_EXPORT vtkKdTreePointLocator : public vtkAbstractPointLocator
 {
@@ -68,6 +70,22 @@ public:
   virtual void FindPointsWithinRadius(double R, const double x[3],
                                       vtkIdList *result);
 
+  // Description:
+  // Batch versions of FindClosestNPoints() and FindPointsWithinRadius()
+  // that query every point of a vtkPoints with NumberOfThreads threads.
+  // The neighbors of point i are ids[offsets[i]] to ids[offsets[i+1]-1].
+  // See vtkKdTree for details.
+  void FindClosestNPoints(int N, vtkPoints *points,
+                          vtkIdTypeArray *offsets, vtkIdTypeArray *ids);
+  void FindPointsWithinRadius(double R, vtkPoints *points,
+                              vtkIdTypeArray *offsets, vtkIdTypeArray *ids);
+
+  // Description:
+  // Set/Get the number of threads used to build the k-d tree and by the
+  // batch queries. Defaults to the number of available processors.
+  vtkSetClampMacro(NumberOfThreads,int,1,VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads,int);
+
   // Description:
   // See vtkLocator interface documentation.
   // These methods are not thread safe.
@@ -80,6 +98,7 @@ protected:
   virtual ~vtkKdTreePointLocator();
 
   vtkKdTree* KdTree;
+  int NumberOfThreads;
 
 private:
   vtkKdTreePointLocator(const vtkKdTreePointLocator&);  // Not implemented.
@@ -14,8 +14,27 @@
 =========================================================================*/
 #include "vtkLocator.h"
 
+#include "vtkCellArray.h"
 #include "vtkDataSet.h"
 #include "vtkGarbageCollector.h"
+#include "vtkIdList.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "vtkUnsignedCharArray.h"
+#include "vtkUnstructuredGrid.h"
+
+#include <vtksys/MD5.h>
+#include <vtksys/SystemTools.hxx>
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+// The cache files start with this signature, followed by the format
+// version, a byte order mark and the size of vtkIdType.
+static const char vtkLocatorCacheSignature[16] = "vtkLocatorCache";
+static const int vtkLocatorCacheVersion = 1;
+static const int vtkLocatorCacheByteOrderMark = 0x01020304;
 
 
 vtkCxxSetObjectMacro(vtkLocator,DataSet,vtkDataSet);
@@ -27,6 +46,7 @@ vtkLocator::vtkLocator()
   this->Automatic = 1;
   this->MaxLevel = 8;
   this->Level = 8;
+  this->CacheFileName = NULL;
 }
 
 vtkLocator::~vtkLocator()
@@ -34,6 +54,7 @@ vtkLocator::~vtkLocator()
   // commented out because of compiler problems in g++
   //  this->FreeSearchStructure();
   this->SetDataSet(NULL);
+  this->SetCacheFileName(NULL);
 }
 
 void vtkLocator::Initialize()
@@ -74,6 +95,8 @@ void vtkLocator::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "Build Time: " << this->BuildTime.GetMTime() << "\n";
   os << indent << "MaxLevel: "   << this->MaxLevel << "\n" ;
   os << indent << "Level: "      << this->Level << "\n" ;
+  os << indent << "CacheFileName: "
+     << (this->CacheFileName ? this->CacheFileName : "(none)") << "\n";
 }
 
 //----------------------------------------------------------------------------
@@ -94,3 +117,243 @@ void vtkLocator::ReportReferences(vtkGarbageCollector* collector)
   this->Superclass::ReportReferences(collector);
   vtkGarbageCollectorReport(collector, this->DataSet, "DataSet");
 }
+
+//----------------------------------------------------------------------------
+// Append raw bytes to a digest, in pieces as the length is an int.
+static void vtkLocatorAppendToDigest(vtksysMD5 *md5, const void *data,
+                                     size_t size)
+{
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  while (size > 0)
+    {
+    int piece = (size > (1 << 30) ? (1 << 30) : static_cast<int>(size));
+    vtksysMD5_Append(md5, bytes, piece);
+    bytes += piece;
+    size -= piece;
+    }
+}
+
+//----------------------------------------------------------------------------
+static void vtkLocatorAppendCellArrayToDigest(vtksysMD5 *md5,
+                                              vtkCellArray *cells)
+{
+  vtkIdType numCells = (cells ? cells->GetNumberOfCells() : 0);
+  vtkLocatorAppendToDigest(md5, &numCells, sizeof(vtkIdType));
+  if (numCells > 0)
+    {
+    vtkLocatorAppendToDigest(md5, cells->GetPointer(),
+      cells->GetNumberOfConnectivityEntries() * sizeof(vtkIdType));
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkLocator::ComputeDataSetsDigest(vtkDataSet **dataSets,
+                                       int numDataSets, char digest[33])
+{
+  vtksysMD5 *md5 = vtksysMD5_New();
+  vtksysMD5_Initialize(md5);
+
+  for (int i = 0; i < numDataSets; i++)
+    {
+    vtkDataSet *ds = dataSets[i];
+    if (!ds)
+      {
+      continue;
+      }
+    vtksysMD5_Append(md5, reinterpret_cast<const unsigned char *>(
+                       ds->GetClassName()), -1);
+    vtkIdType numPts = ds->GetNumberOfPoints();
+    vtkIdType numCells = ds->GetNumberOfCells();
+    vtkLocatorAppendToDigest(md5, &numPts, sizeof(vtkIdType));
+    vtkLocatorAppendToDigest(md5, &numCells, sizeof(vtkIdType));
+
+    // points: the raw coordinates of point sets, the computed ones otherwise
+    vtkPointSet *pointSet = vtkPointSet::SafeDownCast(ds);
+    vtkPoints *points = (pointSet ? pointSet->GetPoints() : NULL);
+    if (points)
+      {
+      int type = points->GetDataType();
+      vtkLocatorAppendToDigest(md5, &type, sizeof(int));
+      vtkLocatorAppendToDigest(md5, points->GetVoidPointer(0),
+        3 * numPts * points->GetData()->GetDataTypeSize());
+      }
+    else if (numPts > 0)
+      {
+      std::vector<double> x(3 * numPts);
+      for (vtkIdType ptId = 0; ptId < numPts; ptId++)
+        {
+        ds->GetPoint(ptId, &x[3 * ptId]);
+        }
+      vtkLocatorAppendToDigest(md5, &x[0], x.size() * sizeof(double));
+      }
+
+    // cells: the connectivity arrays of polygonal and unstructured data, the
+    // type and points of each cell otherwise
+    vtkPolyData *polyData = vtkPolyData::SafeDownCast(ds);
+    vtkUnstructuredGrid *grid = vtkUnstructuredGrid::SafeDownCast(ds);
+    if (polyData)
+      {
+      vtkLocatorAppendCellArrayToDigest(md5, polyData->GetVerts());
+      vtkLocatorAppendCellArrayToDigest(md5, polyData->GetLines());
+      vtkLocatorAppendCellArrayToDigest(md5, polyData->GetPolys());
+      vtkLocatorAppendCellArrayToDigest(md5, polyData->GetStrips());
+      }
+    else if (grid && grid->GetCellTypesArray())
+      {
+      vtkLocatorAppendCellArrayToDigest(md5, grid->GetCells());
+      vtkLocatorAppendToDigest(md5, grid->GetCellTypesArray()->GetPointer(0),
+                               numCells);
+      }
+    else if (numCells > 0)
+      {
+      vtkIdList *ptIds = vtkIdList::New();
+      std::vector<vtkIdType> cell;
+      for (vtkIdType cellId = 0; cellId < numCells; cellId++)
+        {
+        ds->GetCellPoints(cellId, ptIds);
+        cell.resize(ptIds->GetNumberOfIds() + 2);
+        cell[0] = ds->GetCellType(cellId);
+        cell[1] = ptIds->GetNumberOfIds();
+        for (vtkIdType j = 0; j < ptIds->GetNumberOfIds(); j++)
+          {
+          cell[j + 2] = ptIds->GetId(j);
+          }
+        vtkLocatorAppendToDigest(md5, &cell[0],
+                                 cell.size() * sizeof(vtkIdType));
+        }
+      ptIds->Delete();
+      }
+    }
+
+  vtksysMD5_FinalizeHex(md5, digest);
+  digest[32] = '\0';
+  vtksysMD5_Delete(md5);
+}
+
+//----------------------------------------------------------------------------
+void vtkLocator::ComputeDataDigest(char digest[33])
+{
+  vtkDataSet *ds = this->DataSet;
+  vtkLocator::ComputeDataSetsDigest(&ds, 1, digest);
+}
+
+//----------------------------------------------------------------------------
+void vtkLocator::WriteCacheBlock(ostream &os, const void *data, size_t size)
+{
+  if (size > 0)
+    {
+    os.write(static_cast<const char *>(data), size);
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkLocator::ReadCacheBlock(istream &is, void *data, size_t size)
+{
+  if (size > 0)
+    {
+    is.read(static_cast<char *>(data), size);
+    }
+  return (is.good() ? 1 : 0);
+}
+
+//----------------------------------------------------------------------------
+int vtkLocator::ReadCacheFile()
+{
+  if (!this->CacheFileName || !this->CacheFileName[0])
+    {
+    return 0;
+    }
+
+  std::ifstream is(this->CacheFileName, std::ios::in | std::ios::binary);
+  if (!is)
+    {
+    return 0;
+    }
+
+  // the header must be the one WriteCacheFile() would write
+  char digest[33], cachedDigest[33];
+  char signature[16];
+  int version = 0, byteOrderMark = 0, idSize = 0, nameLength = 0;
+  if (!vtkLocator::ReadCacheBlock(is, signature, 16) ||
+      memcmp(signature, vtkLocatorCacheSignature, 16) != 0 ||
+      !vtkLocator::ReadCacheBlock(is, &version, sizeof(int)) ||
+      !vtkLocator::ReadCacheBlock(is, &byteOrderMark, sizeof(int)) ||
+      !vtkLocator::ReadCacheBlock(is, &idSize, sizeof(int)) ||
+      version != vtkLocatorCacheVersion ||
+      byteOrderMark != vtkLocatorCacheByteOrderMark ||
+      idSize != static_cast<int>(sizeof(vtkIdType)) ||
+      !vtkLocator::ReadCacheBlock(is, &nameLength, sizeof(int)) ||
+      nameLength != static_cast<int>(strlen(this->GetClassName())))
+    {
+    vtkDebugMacro(<< "Ignoring cache file " << this->CacheFileName);
+    return 0;
+    }
+  std::vector<char> name(nameLength + 1, '\0');
+  if (!vtkLocator::ReadCacheBlock(is, &name[0], nameLength) ||
+      strcmp(&name[0], this->GetClassName()) != 0 ||
+      !vtkLocator::ReadCacheBlock(is, cachedDigest, 32))
+    {
+    vtkDebugMacro(<< "Ignoring cache file " << this->CacheFileName);
+    return 0;
+    }
+  cachedDigest[32] = '\0';
+  this->ComputeDataDigest(digest);
+  if (strcmp(digest, cachedDigest) != 0)
+    {
+    vtkDebugMacro(<< "Cache file " << this->CacheFileName
+                  << " was written for other data");
+    return 0;
+    }
+
+  if (!this->ReadSearchStructure(is))
+    {
+    vtkDebugMacro(<< "Cache file " << this->CacheFileName
+                  << " was written with other parameters or is truncated");
+    this->FreeSearchStructure();
+    return 0;
+    }
+
+  vtkDebugMacro(<< "Search structure read from " << this->CacheFileName);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkLocator::WriteCacheFile()
+{
+  if (!this->CacheFileName || !this->CacheFileName[0])
+    {
+    return;
+    }
+
+  std::ofstream os(this->CacheFileName,
+                   std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!os)
+    {
+    vtkWarningMacro(<< "Cannot write the cache file " << this->CacheFileName);
+    return;
+    }
+
+  char digest[33];
+  this->ComputeDataDigest(digest);
+  int idSize = static_cast<int>(sizeof(vtkIdType));
+  int nameLength = static_cast<int>(strlen(this->GetClassName()));
+  vtkLocator::WriteCacheBlock(os, vtkLocatorCacheSignature, 16);
+  vtkLocator::WriteCacheBlock(os, &vtkLocatorCacheVersion, sizeof(int));
+  vtkLocator::WriteCacheBlock(os, &vtkLocatorCacheByteOrderMark, sizeof(int));
+  vtkLocator::WriteCacheBlock(os, &idSize, sizeof(int));
+  vtkLocator::WriteCacheBlock(os, &nameLength, sizeof(int));
+  vtkLocator::WriteCacheBlock(os, this->GetClassName(), nameLength);
+  vtkLocator::WriteCacheBlock(os, digest, 32);
+
+  int written = this->WriteSearchStructure(os);
+  os.close();
+  if (!written || !os)
+    {
+    if (written)
+      {
+      vtkWarningMacro(<< "Cannot write the cache file "
+                      << this->CacheFileName);
+      }
+    vtksys::SystemTools::RemoveFile(this->CacheFileName);
+    }
+}
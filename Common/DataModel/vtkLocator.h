@@ -119,6 +119,18 @@ public:
   // data.
   virtual void GenerateRepresentation(int level, vtkPolyData *pd) = 0;
 
+  // Description:
+  // Specify the name of a file in which to cache the search structure. When
+  // set, the locators that support it (vtkCellLocator, vtkCellTreeLocator,
+  // vtkKdTree and vtkOctreePointLocator) load their search structure from
+  // this file instead of building it, provided that the file was written by
+  // the same class, with the same build parameters, for points and cells
+  // identical to the current ones. Otherwise they build the search structure
+  // and write it to the file. The file is written in the native byte order.
+  // Initial value is NULL (no caching).
+  vtkSetStringMacro(CacheFileName);
+  vtkGetStringMacro(CacheFileName);
+
   // Description:
   // Return the time of the last data structure build.
   vtkGetMacro(BuildTime, unsigned long);
@@ -139,6 +151,44 @@ protected:
 
   vtkTimeStamp BuildTime;  // time at which locator was built
 
+  char *CacheFileName;
+
+  // Description:
+  // Load the search structure from CacheFileName if the file is valid for
+  // the current data and parameters and return 1. Otherwise free any partly
+  // loaded structure and return 0. Subclasses call this before building.
+  int ReadCacheFile();
+
+  // Description:
+  // Write the search structure to CacheFileName, if set. Subclasses call
+  // this once the search structure has been built.
+  void WriteCacheFile();
+
+  // Description:
+  // Write/read the parameters the search structure was built with and the
+  // search structure itself to/from a binary stream. ReadSearchStructure()
+  // returns 0 if the parameters differ from the current ones or if the
+  // stream is too short. The default implementations support no caching.
+  virtual int WriteSearchStructure(ostream &) { return 0; }
+  virtual int ReadSearchStructure(istream &) { return 0; }
+
+  // Description:
+  // Compute the digest (32 hexadecimal characters and a terminating null)
+  // of the points and cells the search structure is built from. By default,
+  // those of DataSet.
+  virtual void ComputeDataDigest(char digest[33]);
+
+  // Description:
+  // Compute the digest of the points and cells of several datasets.
+  static void ComputeDataSetsDigest(vtkDataSet **dataSets, int numDataSets,
+                                    char digest[33]);
+
+  // Description:
+  // Write/read a block of raw bytes to/from a cache stream. ReadCacheBlock()
+  // returns 0 if the stream ends before the block does.
+  static void WriteCacheBlock(ostream &os, const void *data, size_t size);
+  static int ReadCacheBlock(istream &is, void *data, size_t size);
+
   virtual void ReportReferences(vtkGarbageCollector*);
 private:
   vtkLocator(const vtkLocator&);  // Not implemented.
@@ -346,6 +346,12 @@ void vtkOctreePointLocator::BuildLocator()
     }
   this->FreeSearchStructure();
 
+  if (this->ReadCacheFile())
+    {
+    this->BuildTime.Modified();
+    return;
+    }
+
   // Fix bounds - (1) push out a little if flat
   // (2) pull back the x, y and z lower bounds a little bit so that
   // points are clearly "inside" the spatial region.  Point p is
@@ -450,9 +456,170 @@ void vtkOctreePointLocator::BuildLocator()
   int index = 0;
   this->LeafNodeList = new vtkOctreePointLocatorNode*[this->NumberOfLeafNodes];
   this->BuildLeafNodeList(this->Top, index);
+  this->WriteCacheFile();
   this->BuildTime.Modified();
 }
 
+//----------------------------------------------------------------------------
+// The octree is stored in depth first order as the number of points and
+// whether there are children of each node: the bounds of the children and
+// the remaining node information follow from the root bounds and the points.
+namespace
+{
+void vtkOctreePointLocatorStoreNodes(vtkOctreePointLocatorNode *node,
+                                     std::vector<int> &nodes)
+{
+  nodes.push_back(node->GetNumberOfPoints());
+  nodes.push_back(node->GetChild(0) ? 1 : 0);
+  if(node->GetChild(0))
+    {
+    for(int i=0;i<8;i++)
+      {
+      vtkOctreePointLocatorStoreNodes(node->GetChild(i), nodes);
+      }
+    }
+}
+
+// The nodes read are checked as BuildLocator() would have made them: no
+// deeper than levelLimit, and with the points of a node split among its
+// children, since the leaves index LocatorIds with the point counts.
+bool vtkOctreePointLocatorRestoreNodes(vtkOctreePointLocatorNode *node,
+                                       const std::vector<int> &nodes,
+                                       size_t &next, int level, int &maxLevel,
+                                       int levelLimit)
+{
+  if(next + 2 > nodes.size() || nodes[next] < 0)
+    {
+    return false;
+    }
+  node->SetNumberOfPoints(nodes[next]);
+  int hasChildren = nodes[next+1];
+  next += 2;
+  if(hasChildren)
+    {
+    if(level + 1 > levelLimit)
+      {
+      return false;
+      }
+    maxLevel = (level + 1 > maxLevel ? level + 1 : maxLevel);
+    node->CreateChildNodes();
+    int numPoints = 0;
+    for(int i=0;i<8;i++)
+      {
+      if(!vtkOctreePointLocatorRestoreNodes(node->GetChild(i), nodes, next,
+                                            level + 1, maxLevel, levelLimit))
+        {
+        return false;
+        }
+      numPoints += node->GetChild(i)->GetNumberOfPoints();
+      }
+    if(numPoints != node->GetNumberOfPoints())
+      {
+      return false;
+      }
+    }
+  return true;
+}
+}
+
+//----------------------------------------------------------------------------
+int vtkOctreePointLocator::WriteSearchStructure(ostream &os)
+{
+  int params[3] = { this->MaxLevel, this->MaximumPointsPerRegion,
+                    this->CreateCubicOctants };
+  double bounds[6];
+  this->Top->GetBounds(bounds);
+  std::vector<int> nodes;
+  vtkOctreePointLocatorStoreNodes(this->Top, nodes);
+  int sizes[2] = { static_cast<int>(nodes.size()),
+                   this->Top->GetNumberOfPoints() };
+
+  vtkLocator::WriteCacheBlock(os, params, sizeof(params));
+  vtkLocator::WriteCacheBlock(os, &this->MaxWidth, sizeof(float));
+  vtkLocator::WriteCacheBlock(os, &this->FudgeFactor, sizeof(double));
+  vtkLocator::WriteCacheBlock(os, bounds, sizeof(bounds));
+  vtkLocator::WriteCacheBlock(os, sizes, sizeof(sizes));
+  vtkLocator::WriteCacheBlock(os, &nodes[0], nodes.size()*sizeof(int));
+  vtkLocator::WriteCacheBlock(os, this->LocatorIds, sizes[1]*sizeof(int));
+  vtkLocator::WriteCacheBlock(os, this->LocatorPoints,
+                              3*sizes[1]*sizeof(float));
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkOctreePointLocator::ReadSearchStructure(istream &is)
+{
+  int params[3], sizes[2];
+  float maxWidth;
+  double fudgeFactor, bounds[6];
+  if ( !vtkLocator::ReadCacheBlock(is, params, sizeof(params)) ||
+       params[0] != this->MaxLevel ||
+       params[1] != this->MaximumPointsPerRegion ||
+       params[2] != this->CreateCubicOctants ||
+       !vtkLocator::ReadCacheBlock(is, &maxWidth, sizeof(float)) ||
+       !vtkLocator::ReadCacheBlock(is, &fudgeFactor, sizeof(double)) ||
+       !vtkLocator::ReadCacheBlock(is, bounds, sizeof(bounds)) ||
+       !vtkLocator::ReadCacheBlock(is, sizes, sizeof(sizes)) ||
+       sizes[0] < 2 || sizes[1] != this->GetDataSet()->GetNumberOfPoints() )
+    {
+    return 0;
+    }
+
+  std::vector<int> nodes(sizes[0]);
+  if ( !vtkLocator::ReadCacheBlock(is, &nodes[0], sizes[0]*sizeof(int)) )
+    {
+    return 0;
+    }
+  this->LocatorIds = new int [sizes[1]];
+  this->LocatorPoints = new float [3*sizes[1]];
+  if ( !vtkLocator::ReadCacheBlock(is, this->LocatorIds,
+                                   sizes[1]*sizeof(int)) ||
+       !vtkLocator::ReadCacheBlock(is, this->LocatorPoints,
+                                   3*sizes[1]*sizeof(float)) )
+    {
+    return 0;
+    }
+
+  // Every point is listed once
+  std::vector<char> listed(sizes[1], 0);
+  for(int i=0;i<sizes[1];i++)
+    {
+    int id = this->LocatorIds[i];
+    if(id < 0 || id >= sizes[1] || listed[id])
+      {
+      return 0;
+      }
+    listed[id] = 1;
+    }
+
+  this->MaxWidth = maxWidth;
+  this->FudgeFactor = fudgeFactor;
+  this->Top = vtkOctreePointLocatorNode::New();
+  this->Top->SetBounds(bounds);
+  this->Top->SetDataBounds(bounds[0], bounds[1], bounds[2],
+                           bounds[3], bounds[4], bounds[5]);
+  size_t next = 0;
+  int level = 0;
+  if ( !vtkOctreePointLocatorRestoreNodes(this->Top, nodes, next, 0, level,
+                                          this->MaxLevel) ||
+       next != nodes.size() || this->Top->GetNumberOfPoints() != sizes[1] )
+    {
+    return 0;
+    }
+  this->Level = level;
+
+  int nextLeafNodeId = 0;
+  int nextMinId = 0;
+  this->Top->ComputeOctreeNodeInformation(this->Top, nextLeafNodeId,
+                                          nextMinId, this->LocatorPoints);
+
+  this->NumberOfLeafNodes = nextLeafNodeId;
+  int index = 0;
+  this->LeafNodeList = new vtkOctreePointLocatorNode*[this->NumberOfLeafNodes];
+  this->BuildLeafNodeList(this->Top, index);
+  return 1;
+}
+
 //----------------------------------------------------------------------------
 void vtkOctreePointLocator::BuildLeafNodeList(vtkOctreePointLocatorNode* node,
                                               int & index)
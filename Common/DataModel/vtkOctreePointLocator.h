@@ -163,6 +163,12 @@ protected:
 
   void BuildLeafNodeList(vtkOctreePointLocatorNode* node, int & index);
 
+  // Description:
+  // Write/read the octree and the sorted points to/from a cache file (see
+  // CacheFileName).
+  virtual int WriteSearchStructure(ostream &os);
+  virtual int ReadSearchStructure(istream &is);
+
   // Description:
   // Given a point and a node return the leaf node id that contains the
   // point.  The function returns -1 if no nodes contain the point.
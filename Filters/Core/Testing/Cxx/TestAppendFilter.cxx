@@ -0,0 +1,195 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestAppendFilter.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// This tests that vtkAppendFilter gives the same output when appending
+// unstructured grids in bulk, with one thread and with several threads, as
+// when appending the same cells one by one from poly data inputs, and that
+// the bulk copies report progress.
+
+#include <vtkAppendFilter.h>
+#include <vtkCallbackCommand.h>
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkCellType.h>
+#include <vtkDoubleArray.h>
+#include <vtkIdList.h>
+#include <vtkIntArray.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkUnstructuredGrid.h>
+
+// A strip of numCells quads (triangles for odd blocks, which also use double
+// precision points), placed at y = block.
+static vtkSmartPointer<vtkUnstructuredGrid> MakeBlock(int block, int numCells)
+{
+  vtkSmartPointer<vtkUnstructuredGrid> ug =
+    vtkSmartPointer<vtkUnstructuredGrid>::New();
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  if (block % 2)
+    {
+    points->SetDataTypeToDouble();
+    }
+  vtkSmartPointer<vtkDoubleArray> scalars =
+    vtkSmartPointer<vtkDoubleArray>::New();
+  scalars->SetName("Scalars");
+  for (int i = 0; i <= numCells; ++i)
+    {
+    points->InsertNextPoint(i, block, 0.0);
+    points->InsertNextPoint(i, block + 0.5, 0.0);
+    scalars->InsertNextValue(block + i);
+    scalars->InsertNextValue(block - i);
+    }
+  ug->SetPoints(points);
+  ug->GetPointData()->SetScalars(scalars);
+
+  vtkSmartPointer<vtkIntArray> ids = vtkSmartPointer<vtkIntArray>::New();
+  ids->SetName("BlockId");
+  ug->Allocate(numCells);
+  for (int i = 0; i < numCells; ++i)
+    {
+    vtkIdType quad[4] = {2*i, 2*i+2, 2*i+3, 2*i+1};
+    if (block % 2)
+      {
+      ug->InsertNextCell(VTK_TRIANGLE, 3, quad);
+      }
+    else
+      {
+      ug->InsertNextCell(VTK_QUAD, 4, quad);
+      }
+    ids->InsertNextValue(block);
+    }
+  ug->GetCellData()->AddArray(ids);
+  return ug;
+}
+
+// The same points, cells and attributes as a poly data, which vtkAppendFilter
+// appends one cell at a time.
+static vtkSmartPointer<vtkPolyData> ToPolyData(vtkUnstructuredGrid *ug)
+{
+  vtkSmartPointer<vtkPolyData> pd = vtkSmartPointer<vtkPolyData>::New();
+  pd->SetPoints(ug->GetPoints());
+  pd->GetPointData()->ShallowCopy(ug->GetPointData());
+  pd->GetCellData()->ShallowCopy(ug->GetCellData());
+  vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+  polys->DeepCopy(ug->GetCells());
+  pd->SetPolys(polys);
+  return pd;
+}
+
+// Whether two appended outputs differ, printing the first difference.
+static bool Differ(vtkUnstructuredGrid *a, vtkUnstructuredGrid *b)
+{
+  if (a->GetNumberOfPoints() != b->GetNumberOfPoints() ||
+      a->GetNumberOfCells() != b->GetNumberOfCells() ||
+      a->GetNumberOfCells() == 0)
+    {
+    std::cerr << "Error: point or cell counts differ" << std::endl;
+    return true;
+    }
+
+  for (vtkIdType ptId = 0; ptId < a->GetNumberOfPoints(); ++ptId)
+    {
+    double x[3], y[3];
+    a->GetPoint(ptId, x);
+    b->GetPoint(ptId, y);
+    if (x[0] != y[0] || x[1] != y[1] || x[2] != y[2] ||
+        a->GetPointData()->GetScalars()->GetTuple1(ptId) !=
+        b->GetPointData()->GetScalars()->GetTuple1(ptId))
+      {
+      std::cerr << "Error: point " << ptId << " differs" << std::endl;
+      return true;
+      }
+    }
+
+  vtkSmartPointer<vtkIdList> ptsA = vtkSmartPointer<vtkIdList>::New();
+  vtkSmartPointer<vtkIdList> ptsB = vtkSmartPointer<vtkIdList>::New();
+  for (vtkIdType cellId = 0; cellId < a->GetNumberOfCells(); ++cellId)
+    {
+    a->GetCellPoints(cellId, ptsA);
+    b->GetCellPoints(cellId, ptsB);
+    bool same = a->GetCellType(cellId) == b->GetCellType(cellId) &&
+      ptsA->GetNumberOfIds() == ptsB->GetNumberOfIds() &&
+      a->GetCellData()->GetArray("BlockId")->GetTuple1(cellId) ==
+      b->GetCellData()->GetArray("BlockId")->GetTuple1(cellId);
+    for (vtkIdType i = 0; same && i < ptsA->GetNumberOfIds(); ++i)
+      {
+      same = ptsA->GetId(i) == ptsB->GetId(i);
+      }
+    if (!same)
+      {
+      std::cerr << "Error: cell " << cellId << " differs" << std::endl;
+      return true;
+      }
+    }
+  return false;
+}
+
+// Count the progress events strictly between 0 and 1.
+static void CountProgress(vtkObject *caller, unsigned long, void *clientData,
+                          void *)
+{
+  double progress = static_cast<vtkAppendFilter *>(caller)->GetProgress();
+  if (progress > 0.0 && progress < 1.0)
+    {
+    ++*static_cast<int *>(clientData);
+    }
+}
+
+int TestAppendFilter(int, char*[])
+{
+  const int numBlocks = 7;
+
+  vtkSmartPointer<vtkAppendFilter> perCell =
+    vtkSmartPointer<vtkAppendFilter>::New();
+  vtkSmartPointer<vtkAppendFilter> serial =
+    vtkSmartPointer<vtkAppendFilter>::New();
+  vtkSmartPointer<vtkAppendFilter> threaded =
+    vtkSmartPointer<vtkAppendFilter>::New();
+  serial->SetNumberOfThreads(1);
+  threaded->SetNumberOfThreads(4);
+  for (int block = 0; block < numBlocks; ++block)
+    {
+    vtkSmartPointer<vtkUnstructuredGrid> ug = MakeBlock(block, 10 + 5*block);
+    perCell->AddInputData(ToPolyData(ug));
+    serial->AddInputData(ug);
+    threaded->AddInputData(ug);
+    }
+
+  int numProgress = 0;
+  vtkSmartPointer<vtkCallbackCommand> progress =
+    vtkSmartPointer<vtkCallbackCommand>::New();
+  progress->SetCallback(CountProgress);
+  progress->SetClientData(&numProgress);
+  serial->AddObserver(vtkCommand::ProgressEvent, progress);
+
+  perCell->Update();
+  serial->Update();
+  threaded->Update();
+
+  if (Differ(perCell->GetOutput(), serial->GetOutput()) ||
+      Differ(perCell->GetOutput(), threaded->GetOutput()))
+    {
+    return EXIT_FAILURE;
+    }
+  if (numProgress < numBlocks - 1)
+    {
+    std::cerr << "Error: " << numProgress << " progress events instead of "
+              << numBlocks - 1 << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -12,80 +12,145 @@
      PURPOSE.  See the above copyright notice for more information.
 
 =========================================================================*/
+// This tests vtkAppendPolyData against a hand-checked output, with one
+// thread and with several threads: the inputs mix float and double points,
+// verts, lines, polys and strips, and include an empty poly data.
 
-#include <vtkSmartPointer.h>
-#include <vtkPolyData.h>
-#include <vtkPoints.h>
 #include <vtkAppendPolyData.h>
-#include <vtkXMLPolyDataWriter.h>
 #include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkFloatArray.h>
+#include <vtkIdList.h>
+#include <vtkIntArray.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
 
-int TestAppendPolyData(int, char *[])
+// A poly data with the given points and point scalars, and empty cell arrays
+// that the caller fills.
+static vtkSmartPointer<vtkPolyData> MakeInput(int dataType, int numPts,
+                                              const double (*pts)[3],
+                                              float firstScalar)
 {
-  vtkSmartPointer<vtkPoints> points1 = vtkSmartPointer<vtkPoints>::New();
-  points1->InsertNextPoint(0,0,0);
-  points1->InsertNextPoint(1,1,1);
-
-  vtkSmartPointer<vtkPoints> points2 = vtkSmartPointer<vtkPoints>::New();
-  vtkSmartPointer<vtkCellArray> vertices = vtkSmartPointer<vtkCellArray>::New();
-  vtkIdType pid[1];
-  pid[0] = points2->InsertNextPoint(5,5,5);
-  vertices->InsertNextCell ( 1,pid );
-  pid[0] = points2->InsertNextPoint(6,6,6);
-  vertices->InsertNextCell ( 1,pid );
-
-  vtkSmartPointer<vtkPolyData> polydata1 = vtkSmartPointer<vtkPolyData>::New();
-  polydata1->SetPoints(points1);
-  polydata1->SetVerts(vertices);
-  /*
-  cout << "polydata1" << endl;
-  cout << "There are " << polydata1->GetNumberOfPoints() << " points." << endl;
-  cout << "There are " << polydata1->GetNumberOfCells() << " cells." << endl;
-  */
-  vtkSmartPointer<vtkXMLPolyDataWriter> writer1 = vtkSmartPointer<vtkXMLPolyDataWriter>::New();
-  writer1->SetFileName("polydata1.vtp");
-  writer1->SetInput(polydata1);
-  writer1->Write();
-
-  vtkSmartPointer<vtkPolyData> polydata2 = vtkSmartPointer<vtkPolyData>::New();
-  polydata2->SetPoints(points2);
-  /*
-  cout << "polydata2" << endl;
-  cout << "There are " << polydata2->GetNumberOfPoints() << " points." << endl;
-  cout << "There are " << polydata2->GetNumberOfCells() << " cells." << endl;
-  */
-  vtkSmartPointer<vtkXMLPolyDataWriter> writer2 = vtkSmartPointer<vtkXMLPolyDataWriter>::New();
-  writer2->SetFileName("polydata2.vtp");
-  writer2->SetInput(polydata2);
-  writer2->Write();
-
-  vtkSmartPointer<vtkAppendPolyData> appendFilter = vtkSmartPointer<vtkAppendPolyData>::New();
-  appendFilter->AddInput(polydata1);
-  appendFilter->AddInput(polydata2);
-  appendFilter->Update();
-
-  vtkPolyData* polydataCombined = appendFilter->GetOutput();
-  vtkSmartPointer<vtkXMLPolyDataWriter> writerCombined = vtkSmartPointer<vtkXMLPolyDataWriter>::New();
-  writerCombined->SetFileName("polydataCombined.vtp");
-  writerCombined->SetInput(polydataCombined);
-  writerCombined->Write();
-  /*
-  cout << "Combined" << endl;
-  cout << "There are " << polydataCombined->GetNumberOfPoints() << " points." << endl;
-  cout << "There are " << polydataCombined->GetNumberOfCells() << " cells." << endl;
-  */
-  if(polydataCombined->GetNumberOfPoints() != polydata1->GetNumberOfPoints() + polydata2->GetNumberOfPoints())
+  vtkSmartPointer<vtkPolyData> pd = vtkSmartPointer<vtkPolyData>::New();
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  points->SetDataType(dataType);
+  vtkSmartPointer<vtkFloatArray> scalars =
+    vtkSmartPointer<vtkFloatArray>::New();
+  for (int i = 0; i < numPts; ++i)
     {
-    cerr << "The combined number of points is incorrect." << endl;
-    return EXIT_FAILURE;
+    points->InsertNextPoint(pts[i]);
+    scalars->InsertNextValue(firstScalar + i);
     }
+  pd->SetPoints(points);
+  pd->GetPointData()->SetScalars(scalars);
+  pd->SetVerts(vtkSmartPointer<vtkCellArray>::New());
+  pd->SetLines(vtkSmartPointer<vtkCellArray>::New());
+  pd->SetPolys(vtkSmartPointer<vtkCellArray>::New());
+  pd->SetStrips(vtkSmartPointer<vtkCellArray>::New());
+  return pd;
+}
 
-  if(polydataCombined->GetNumberOfCells() != polydata1->GetNumberOfCells() + polydata2->GetNumberOfCells())
+static void AddCellIds(vtkPolyData *pd, int firstId)
+{
+  vtkSmartPointer<vtkIntArray> ids = vtkSmartPointer<vtkIntArray>::New();
+  ids->SetName("CellIds");
+  for (vtkIdType i = 0; i < pd->GetNumberOfCells(); ++i)
     {
-    cerr << "The combined number of cells is incorrect." << endl;
-    return EXIT_FAILURE;
+    ids->InsertNextValue(firstId + i);
+    }
+  pd->GetCellData()->AddArray(ids);
+}
+
+int TestAppendPolyData(int, char *[])
+{
+  // a float quad with a vertex on its first point
+  static const double pts1[4][3] = {
+    {0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0} };
+  vtkSmartPointer<vtkPolyData> pd1 = MakeInput(VTK_FLOAT, 4, pts1, 0);
+  vtkIdType quad[4] = {0, 1, 2, 3};
+  vtkIdType vert1[1] = {0};
+  pd1->GetVerts()->InsertNextCell(1, vert1);
+  pd1->GetPolys()->InsertNextCell(4, quad);
+  AddCellIds(pd1, 10);
+
+  // a double line and strip on the same points, with a vertex on the last
+  static const double pts2[3][3] = { {0, 0, 1}, {1, 0, 1}, {2, 0, 1} };
+  vtkSmartPointer<vtkPolyData> pd2 = MakeInput(VTK_DOUBLE, 3, pts2, 4);
+  vtkIdType line[3] = {0, 1, 2};
+  vtkIdType vert2[1] = {2};
+  pd2->GetVerts()->InsertNextCell(1, vert2);
+  pd2->GetLines()->InsertNextCell(3, line);
+  pd2->GetStrips()->InsertNextCell(3, line);
+  AddCellIds(pd2, 20);
+
+  vtkSmartPointer<vtkPolyData> empty = vtkSmartPointer<vtkPolyData>::New();
+
+  // The points of the second input follow the ones of the first, and the
+  // cells are sorted by type: verts, lines, polys and strips.
+  static const vtkIdType expectedCells[] = {
+    1, 0,   1, 6,   3, 4, 5, 6,   4, 0, 1, 2, 3,   3, 4, 5, 6 };
+  static const int expectedTypes[] = {
+    VTK_VERTEX, VTK_VERTEX, VTK_POLY_LINE, VTK_QUAD, VTK_TRIANGLE_STRIP };
+  static const int expectedCellIds[] = { 10, 20, 21, 11, 22 };
+
+  for (int numThreads = 1; numThreads <= 3; numThreads += 2)
+    {
+    vtkSmartPointer<vtkAppendPolyData> append =
+      vtkSmartPointer<vtkAppendPolyData>::New();
+    append->SetNumberOfThreads(numThreads);
+    append->AddInputData(pd1);
+    append->AddInputData(empty);
+    append->AddInputData(pd2);
+    append->Update();
+    vtkPolyData *output = append->GetOutput();
+
+    if (output->GetNumberOfPoints() != 7 || output->GetNumberOfCells() != 5 ||
+        output->GetPoints()->GetDataType() != VTK_DOUBLE)
+      {
+      std::cerr << "Error with " << numThreads << " threads: "
+                << output->GetNumberOfPoints() << " points and "
+                << output->GetNumberOfCells() << " cells" << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    vtkDataArray *scalars = output->GetPointData()->GetScalars();
+    for (vtkIdType ptId = 0; ptId < 7; ++ptId)
+      {
+      const double *expected = ptId < 4 ? pts1[ptId] : pts2[ptId-4];
+      double x[3];
+      output->GetPoint(ptId, x);
+      if (x[0] != expected[0] || x[1] != expected[1] ||
+          x[2] != expected[2] || !scalars || scalars->GetTuple1(ptId) != ptId)
+        {
+        std::cerr << "Error with " << numThreads << " threads: point "
+                  << ptId << " differs" << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+
+    vtkDataArray *cellIds = output->GetCellData()->GetArray("CellIds");
+    vtkSmartPointer<vtkIdList> cellPts = vtkSmartPointer<vtkIdList>::New();
+    const vtkIdType *expected = expectedCells;
+    for (vtkIdType cellId = 0; cellId < 5; ++cellId)
+      {
+      output->GetCellPoints(cellId, cellPts);
+      bool same = output->GetCellType(cellId) == expectedTypes[cellId] &&
+        cellPts->GetNumberOfIds() == *expected++ &&
+        cellIds && cellIds->GetTuple1(cellId) == expectedCellIds[cellId];
+      for (vtkIdType i = 0; same && i < cellPts->GetNumberOfIds(); ++i)
+        {
+        same = cellPts->GetId(i) == *expected++;
+        }
+      if (!same)
+        {
+        std::cerr << "Error with " << numThreads << " threads: cell "
+                  << cellId << " differs" << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
     }
 
   return EXIT_SUCCESS;
 }
-
@@ -0,0 +1,320 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestCellDataToPointDataThreads.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// This tests that vtkCellDataToPointData and vtkPointDataToCellData average
+// the arrays of image data, rectilinear and structured grids, polygonal data
+// and unstructured grids like the cells using each point or the points of
+// each cell do, whatever the number of threads.
+
+#include "vtkAppendFilter.h"
+#include "vtkCellArray.h"
+#include "vtkCellData.h"
+#include "vtkCellDataToPointData.h"
+#include "vtkDoubleArray.h"
+#include "vtkFloatArray.h"
+#include "vtkIdList.h"
+#include "vtkImageData.h"
+#include "vtkIntArray.h"
+#include "vtkMath.h"
+#include "vtkPointData.h"
+#include "vtkPointDataToCellData.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "vtkRectilinearGrid.h"
+#include "vtkSmartPointer.h"
+#include "vtkStringArray.h"
+#include "vtkStructuredGrid.h"
+#include "vtkUnstructuredGrid.h"
+
+#include <cmath>
+
+static void AddArrays(vtkDataSetAttributes *data, vtkIdType numTuples)
+{
+  vtkSmartPointer<vtkDoubleArray> doubles =
+    vtkSmartPointer<vtkDoubleArray>::New();
+  doubles->SetName("Doubles");
+  vtkSmartPointer<vtkFloatArray> floats =
+    vtkSmartPointer<vtkFloatArray>::New();
+  floats->SetName("Floats");
+  floats->SetNumberOfComponents(3);
+  vtkSmartPointer<vtkIntArray> ints = vtkSmartPointer<vtkIntArray>::New();
+  ints->SetName("Ints");
+  vtkSmartPointer<vtkStringArray> strings =
+    vtkSmartPointer<vtkStringArray>::New();
+  strings->SetName("Strings");
+  for (vtkIdType i = 0; i < numTuples; ++i)
+    {
+    doubles->InsertNextValue(vtkMath::Random(-1.0, 1.0));
+    floats->InsertNextTuple3(vtkMath::Random(-1.0, 1.0), i, -i);
+    ints->InsertNextValue(static_cast<int>(vtkMath::Random(-100.0, 100.0)));
+    strings->InsertNextValue(i % 2 ? "odd" : "even");
+    }
+  data->SetScalars(doubles);
+  data->AddArray(floats);
+  data->AddArray(ints);
+  data->AddArray(strings);
+}
+
+// Compare the averaged arrays with the averages over the cells using each
+// point or the points of each cell
+static bool CheckAverages(vtkDataSet *input, vtkDataSet *output,
+                          bool cellsToPoints)
+{
+  vtkDataSetAttributes *from = input->GetCellData();
+  vtkDataSetAttributes *to = output->GetPointData();
+  vtkIdType numTuples = input->GetNumberOfPoints();
+  if (!cellsToPoints)
+    {
+    from = input->GetPointData();
+    to = output->GetCellData();
+    numTuples = input->GetNumberOfCells();
+    }
+  const char *names[3] = { "Doubles", "Floats", "Ints" };
+  vtkSmartPointer<vtkIdList> ids = vtkSmartPointer<vtkIdList>::New();
+  for (int a = 0; a < 3; ++a)
+    {
+    vtkDataArray *fromArray = from->GetArray(names[a]);
+    vtkDataArray *toArray = to->GetArray(names[a]);
+    if (!toArray || toArray->GetDataType() != fromArray->GetDataType() ||
+        toArray->GetNumberOfTuples() != numTuples)
+      {
+      std::cerr << "Error: missing or wrong array " << names[a] << std::endl;
+      return false;
+      }
+    int numComp = fromArray->GetNumberOfComponents();
+    for (vtkIdType i = 0; i < numTuples; ++i)
+      {
+      if (cellsToPoints)
+        {
+        input->GetPointCells(i, ids);
+        }
+      else
+        {
+        input->GetCellPoints(i, ids);
+        }
+      for (int c = 0; c < numComp; ++c)
+        {
+        double weight = 1.0 / ids->GetNumberOfIds();
+        double average = 0.0;
+        for (vtkIdType j = 0; j < ids->GetNumberOfIds(); ++j)
+          {
+          average += weight * fromArray->GetComponent(ids->GetId(j), c);
+          }
+        if (a == 2)
+          {
+          average = (average >= 0.0) ? floor(average + 0.5) :
+            ceil(average - 0.5);
+          }
+        if (fabs(toArray->GetComponent(i, c) - average) >
+            1e-6 * (fabs(average) + 10.0))
+          {
+          std::cerr << "Error: " << names[a] << " " << i << " is "
+                    << toArray->GetComponent(i, c) << " instead of "
+                    << average << std::endl;
+          return false;
+          }
+        }
+      }
+    }
+  if (to->GetAbstractArray("Strings")->GetNumberOfTuples() != numTuples)
+    {
+    std::cerr << "Error: wrong string array" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+static bool CheckSameArrays(vtkDataSetAttributes *a, vtkDataSetAttributes *b)
+{
+  const char *names[3] = { "Doubles", "Floats", "Ints" };
+  for (int n = 0; n < 3; ++n)
+    {
+    vtkDataArray *x = a->GetArray(names[n]);
+    vtkDataArray *y = b->GetArray(names[n]);
+    for (vtkIdType i = 0; i < x->GetNumberOfTuples(); ++i)
+      {
+      for (int c = 0; c < x->GetNumberOfComponents(); ++c)
+        {
+        if (x->GetComponent(i, c) != y->GetComponent(i, c))
+          {
+          std::cerr << "Error: " << names[n] << " " << i
+                    << " depends on the number of threads" << std::endl;
+          return false;
+          }
+        }
+      }
+    }
+  return true;
+}
+
+static bool TestDataSet(vtkDataSet *input)
+{
+  vtkSmartPointer<vtkCellDataToPointData> c2p =
+    vtkSmartPointer<vtkCellDataToPointData>::New();
+  c2p->SetInputData(input);
+  c2p->SetNumberOfThreads(1);
+  c2p->Update();
+  vtkSmartPointer<vtkDataSet> c2pSerial = c2p->GetOutput()->NewInstance();
+  c2pSerial->ShallowCopy(c2p->GetOutput());
+  c2pSerial->Delete();
+  c2p->SetNumberOfThreads(4);
+  c2p->Modified();
+  c2p->Update();
+
+  vtkSmartPointer<vtkPointDataToCellData> p2c =
+    vtkSmartPointer<vtkPointDataToCellData>::New();
+  p2c->SetInputData(input);
+  p2c->SetNumberOfThreads(1);
+  p2c->Update();
+  vtkSmartPointer<vtkDataSet> p2cSerial = p2c->GetOutput()->NewInstance();
+  p2cSerial->ShallowCopy(p2c->GetOutput());
+  p2cSerial->Delete();
+  p2c->SetNumberOfThreads(4);
+  p2c->Modified();
+  p2c->Update();
+
+  return CheckAverages(input, c2p->GetOutput(), true) &&
+    CheckAverages(input, p2c->GetOutput(), false) &&
+    CheckSameArrays(c2pSerial->GetPointData(),
+                    c2p->GetOutput()->GetPointData()) &&
+    CheckSameArrays(p2cSerial->GetCellData(),
+                    p2c->GetOutput()->GetCellData());
+}
+
+int TestCellDataToPointDataThreads(int, char*[])
+{
+  vtkMath::RandomSeed(1234);
+
+  vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+  image->SetExtent(0, 39, 0, 29, 0, 19);
+  AddArrays(image->GetPointData(), image->GetNumberOfPoints());
+  AddArrays(image->GetCellData(), image->GetNumberOfCells());
+  if (!TestDataSet(image))
+    {
+    return EXIT_FAILURE;
+    }
+
+  vtkSmartPointer<vtkImageData> slice = vtkSmartPointer<vtkImageData>::New();
+  slice->SetExtent(0, 99, 0, 0, 0, 79);
+  AddArrays(slice->GetPointData(), slice->GetNumberOfPoints());
+  AddArrays(slice->GetCellData(), slice->GetNumberOfCells());
+  if (!TestDataSet(slice))
+    {
+    return EXIT_FAILURE;
+    }
+
+  vtkSmartPointer<vtkRectilinearGrid> rgrid =
+    vtkSmartPointer<vtkRectilinearGrid>::New();
+  rgrid->SetDimensions(25, 20, 15);
+  vtkSmartPointer<vtkDoubleArray> coords[3];
+  for (int i = 0; i < 3; ++i)
+    {
+    coords[i] = vtkSmartPointer<vtkDoubleArray>::New();
+    for (int j = 0; j < rgrid->GetDimensions()[i]; ++j)
+      {
+      coords[i]->InsertNextValue(j * j * 0.1);
+      }
+    }
+  rgrid->SetXCoordinates(coords[0]);
+  rgrid->SetYCoordinates(coords[1]);
+  rgrid->SetZCoordinates(coords[2]);
+  AddArrays(rgrid->GetPointData(), rgrid->GetNumberOfPoints());
+  AddArrays(rgrid->GetCellData(), rgrid->GetNumberOfCells());
+  if (!TestDataSet(rgrid))
+    {
+    return EXIT_FAILURE;
+    }
+
+  vtkSmartPointer<vtkStructuredGrid> sgrid =
+    vtkSmartPointer<vtkStructuredGrid>::New();
+  sgrid->SetDimensions(30, 25, 10);
+  vtkSmartPointer<vtkPoints> sgridPoints = vtkSmartPointer<vtkPoints>::New();
+  for (int k = 0; k < 10; ++k)
+    {
+    for (int j = 0; j < 25; ++j)
+      {
+      for (int i = 0; i < 30; ++i)
+        {
+        sgridPoints->InsertNextPoint(i + 0.1 * j, j + 0.2 * sin(0.3 * i), k);
+        }
+      }
+    }
+  sgrid->SetPoints(sgridPoints);
+  AddArrays(sgrid->GetPointData(), sgrid->GetNumberOfPoints());
+  AddArrays(sgrid->GetCellData(), sgrid->GetNumberOfCells());
+  if (!TestDataSet(sgrid))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Polygonal data with vertices, lines, quads and triangles, and a point
+  // used by no cell
+  vtkSmartPointer<vtkPolyData> poly = vtkSmartPointer<vtkPolyData>::New();
+  vtkSmartPointer<vtkPoints> polyPoints = vtkSmartPointer<vtkPoints>::New();
+  vtkSmartPointer<vtkCellArray> verts = vtkSmartPointer<vtkCellArray>::New();
+  vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
+  vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+  for (int j = 0; j < 70; ++j)
+    {
+    for (int i = 0; i < 80; ++i)
+      {
+      polyPoints->InsertNextPoint(i, j, 0.0);
+      }
+    }
+  polyPoints->InsertNextPoint(-1.0, -1.0, 0.0);
+  for (vtkIdType j = 0; j < 69; ++j)
+    {
+    for (vtkIdType i = 0; i < 79; ++i)
+      {
+      vtkIdType ids[4] = { i + j * 80, i + 1 + j * 80, i + 1 + (j + 1) * 80,
+                           i + (j + 1) * 80 };
+      if ((i + j) % 3)
+        {
+        polys->InsertNextCell(4, ids);
+        }
+      else
+        {
+        vtkIdType other[3] = { ids[0], ids[2], ids[3] };
+        polys->InsertNextCell(3, ids);
+        polys->InsertNextCell(3, other);
+        }
+      }
+    lines->InsertNextCell(2);
+    lines->InsertCellPoint(j * 80);
+    lines->InsertCellPoint((j + 1) * 80 + 40);
+    vtkIdType vert = j * 80 + 79;
+    verts->InsertNextCell(1, &vert);
+    }
+  poly->SetPoints(polyPoints);
+  poly->SetVerts(verts);
+  poly->SetLines(lines);
+  poly->SetPolys(polys);
+  AddArrays(poly->GetPointData(), poly->GetNumberOfPoints());
+  AddArrays(poly->GetCellData(), poly->GetNumberOfCells());
+  if (!TestDataSet(poly))
+    {
+    return EXIT_FAILURE;
+    }
+
+  vtkSmartPointer<vtkAppendFilter> append =
+    vtkSmartPointer<vtkAppendFilter>::New();
+  append->AddInputData(image);
+  append->Update();
+  if (!TestDataSet(append->GetOutput()))
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
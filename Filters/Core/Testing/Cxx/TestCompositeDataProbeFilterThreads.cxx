@@ -0,0 +1,225 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestCompositeDataProbeFilterThreads.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// This tests that vtkCompositeDataProbeFilter gives each point the values
+// of the first block containing it in reverse traversal order, with
+// overlapping blocks, an empty block and a partial array, and that the
+// output does not depend on the number of threads.
+
+#include <vtkCompositeDataProbeFilter.h>
+#include <vtkDataSetTriangleFilter.h>
+#include <vtkDoubleArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+#include <vtkUnstructuredGrid.h>
+
+#include <cmath>
+
+#define NUMBER_OF_BLOCKS 4
+
+static double LinearField(const double x[3])
+{
+  return x[0] + 2.0*x[1] - 3.0*x[2];
+}
+
+// The bounds of the blocks, the third of which is empty
+static const double BlockBounds[NUMBER_OF_BLOCKS][6] = {
+  { -1.0, 0.0, -1.0, 0.0, -1.0, 0.0 },
+  { -0.5, 0.5, -0.5, 0.5, -0.5, 0.5 },
+  { 1.0, -1.0, 1.0, -1.0, 1.0, -1.0 },
+  { 0.2, 1.0, -1.0, 1.0, -1.0, 1.0 } };
+
+static vtkSmartPointer<vtkDataSet> MakeBlock(int b)
+{
+  const double *bounds = BlockBounds[b];
+  if (bounds[0] > bounds[1])
+    {
+    return vtkSmartPointer<vtkUnstructuredGrid>::New();
+    }
+
+  vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+  image->SetOrigin(bounds[0], bounds[2], bounds[4]);
+  image->SetSpacing(0.1, 0.1, 0.1);
+  image->SetDimensions(
+    static_cast<int>((bounds[1] - bounds[0]) / 0.1 + 1.5),
+    static_cast<int>((bounds[3] - bounds[2]) / 0.1 + 1.5),
+    static_cast<int>((bounds[5] - bounds[4]) / 0.1 + 1.5));
+
+  vtkSmartPointer<vtkDoubleArray> field =
+    vtkSmartPointer<vtkDoubleArray>::New();
+  field->SetName("Field");
+  vtkSmartPointer<vtkDoubleArray> extra =
+    vtkSmartPointer<vtkDoubleArray>::New();
+  extra->SetName("Extra");
+  for (vtkIdType i = 0; i < image->GetNumberOfPoints(); ++i)
+    {
+    field->InsertNextValue(LinearField(image->GetPoint(i)) + 10.0*b);
+    extra->InsertNextValue(LinearField(image->GetPoint(i)));
+    }
+  image->GetPointData()->AddArray(field);
+  if (b == 1)
+    {
+    image->GetPointData()->AddArray(extra);
+    }
+  if (b == NUMBER_OF_BLOCKS - 1)
+    {
+    return image;
+    }
+
+  // The other blocks are tetrahedra
+  vtkSmartPointer<vtkDataSetTriangleFilter> tetra =
+    vtkSmartPointer<vtkDataSetTriangleFilter>::New();
+  tetra->SetInputData(image);
+  tetra->Update();
+  return tetra->GetOutput();
+}
+
+// The block expected to be probed at x, or -1 if x is outside of all of
+// them, or -2 if x is too close to a block boundary to tell.
+static int ExpectedBlock(const double x[3])
+{
+  for (int b = NUMBER_OF_BLOCKS - 1; b >= 0; --b)
+    {
+    const double *bounds = BlockBounds[b];
+    bool inside = true;
+    for (int i = 0; i < 3; ++i)
+      {
+      if (std::fabs(x[i] - bounds[2*i]) < 0.01 ||
+          std::fabs(x[i] - bounds[2*i+1]) < 0.01)
+        {
+        return -2;
+        }
+      inside = inside && x[i] > bounds[2*i] && x[i] < bounds[2*i+1];
+      }
+    if (inside)
+      {
+      return b;
+      }
+    }
+  return -1;
+}
+
+int TestCompositeDataProbeFilterThreads(int, char*[])
+{
+  vtkSmartPointer<vtkMultiBlockDataSet> source =
+    vtkSmartPointer<vtkMultiBlockDataSet>::New();
+  source->SetNumberOfBlocks(NUMBER_OF_BLOCKS);
+  for (int b = 0; b < NUMBER_OF_BLOCKS; ++b)
+    {
+    source->SetBlock(b, MakeBlock(b));
+    }
+
+  vtkSmartPointer<vtkImageData> input = vtkSmartPointer<vtkImageData>::New();
+  input->SetDimensions(31, 31, 31);
+  input->SetOrigin(-1.2, -1.2, -1.2);
+  input->SetSpacing(0.083, 0.083, 0.083);
+
+  vtkSmartPointer<vtkCompositeDataProbeFilter> reference =
+    vtkSmartPointer<vtkCompositeDataProbeFilter>::New();
+  reference->SetInputData(input);
+  reference->SetSourceData(source);
+  reference->PassPartialArraysOn();
+  reference->SetNumberOfThreads(1);
+  reference->Update();
+
+  vtkPointData *pd = reference->GetOutput()->GetPointData();
+  vtkDataArray *field = pd->GetArray("Field");
+  vtkDataArray *extra = pd->GetArray("Extra");
+  vtkDataArray *mask = pd->GetArray("vtkValidPointMask");
+  if (!field || !extra || !mask)
+    {
+    std::cerr << "Error: missing probed arrays" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  int numChecked[NUMBER_OF_BLOCKS + 1] = { 0, 0, 0, 0, 0 };
+  for (vtkIdType i = 0; i < input->GetNumberOfPoints(); ++i)
+    {
+    double x[3];
+    input->GetPoint(i, x);
+    int b = ExpectedBlock(x);
+    if (b == -2)
+      {
+      continue;
+      }
+    numChecked[b + 1]++;
+    bool valid = mask->GetComponent(i, 0) != 0.0;
+    double f = field->GetComponent(i, 0);
+    double e = extra->GetComponent(i, 0);
+    bool ok = ( b < 0 ? !valid :
+                valid && std::fabs(f - LinearField(x) - 10.0*b) < 1e-5 );
+    ok = ok && ( b == 1 ? std::fabs(e - LinearField(x)) < 1e-5 :
+                 vtkMath::IsNan(e) );
+    if (!ok)
+      {
+      std::cerr << "Error: point " << i << " of block " << b
+                << " is probed as " << f << ", " << e << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  if (!numChecked[0] || !numChecked[1] || !numChecked[2] ||
+      numChecked[3] || !numChecked[4])
+    {
+    std::cerr << "Error: the points do not cover all the blocks" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Same output with threads
+  for (int numThreads = 2; numThreads <= 8; numThreads *= 2)
+    {
+    vtkSmartPointer<vtkCompositeDataProbeFilter> threaded =
+      vtkSmartPointer<vtkCompositeDataProbeFilter>::New();
+    threaded->SetInputData(input);
+    threaded->SetSourceData(source);
+    threaded->PassPartialArraysOn();
+    threaded->SetNumberOfThreads(numThreads);
+    threaded->Update();
+
+    vtkPointData *threadedPD = threaded->GetOutput()->GetPointData();
+    const char *names[3] = { "Field", "Extra", "vtkValidPointMask" };
+    bool same = ( threaded->GetValidPoints()->GetNumberOfTuples() ==
+                  reference->GetValidPoints()->GetNumberOfTuples() );
+    for (int a = 0; same && a < 3; ++a)
+      {
+      vtkDataArray *expected = pd->GetArray(names[a]);
+      vtkDataArray *actual = threadedPD->GetArray(names[a]);
+      same = ( actual &&
+               actual->GetNumberOfTuples() == expected->GetNumberOfTuples() );
+      for (vtkIdType i = 0; same && i < expected->GetNumberOfTuples(); ++i)
+        {
+        double u = expected->GetComponent(i, 0);
+        double v = actual->GetComponent(i, 0);
+        same = ( u == v || (vtkMath::IsNan(u) && vtkMath::IsNan(v)) );
+        }
+      }
+    for (vtkIdType i = 0;
+         same && i < reference->GetValidPoints()->GetNumberOfTuples(); ++i)
+      {
+      same = ( threaded->GetValidPoints()->GetValue(i) ==
+               reference->GetValidPoints()->GetValue(i) );
+      }
+    if (!same)
+      {
+      std::cerr << "Error: the output differs with " << numThreads
+                << " threads" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
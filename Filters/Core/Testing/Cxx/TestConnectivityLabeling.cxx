@@ -0,0 +1,175 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestConnectivityLabeling.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// This tests that the union-find labeling of vtkConnectivityFilter and
+// vtkPolyDataConnectivityFilter finds the same regions as the wave front
+// traversal, which is used when ScalarConnectivity is on (here with a
+// scalar range that accepts every cell).
+
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkConnectivityFilter.h>
+#include <vtkDoubleArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkMinimalStandardRandomSequence.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkPolyDataConnectivityFilter.h>
+#include <vtkSmartPointer.h>
+#include <vtkUnstructuredGrid.h>
+
+// Random triangles over a pool of points: most are connected to a few
+// others, which gives regions of many sizes. Some points are left unused.
+static vtkSmartPointer<vtkPolyData> RandomTriangles(vtkIdType numPts,
+                                                    vtkIdType numTris)
+{
+  vtkSmartPointer<vtkMinimalStandardRandomSequence> random =
+    vtkSmartPointer<vtkMinimalStandardRandomSequence>::New();
+  random->SetSeed(5489);
+
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  vtkSmartPointer<vtkDoubleArray> scalars =
+    vtkSmartPointer<vtkDoubleArray>::New();
+  for (vtkIdType i = 0; i < numPts; ++i)
+    {
+    points->InsertNextPoint(i, 0.0, 0.0);
+    scalars->InsertNextValue(0.0);
+    }
+
+  vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+  for (vtkIdType i = 0; i < numTris; ++i)
+    {
+    vtkIdType tri[3];
+    for (int j = 0; j < 3; ++j)
+      {
+      random->Next();
+      tri[j] = static_cast<vtkIdType>(random->GetValue() * numPts) % numPts;
+      }
+    polys->InsertNextCell(3, tri);
+    }
+
+  vtkSmartPointer<vtkPolyData> polydata = vtkSmartPointer<vtkPolyData>::New();
+  polydata->SetPoints(points);
+  polydata->SetPolys(polys);
+  polydata->GetPointData()->SetScalars(scalars);
+  return polydata;
+}
+
+static bool SameCellRegions(vtkDataSet *a, vtkDataSet *b)
+{
+  vtkIdTypeArray *ra = vtkIdTypeArray::SafeDownCast(
+    a->GetCellData()->GetArray("RegionId"));
+  vtkIdTypeArray *rb = vtkIdTypeArray::SafeDownCast(
+    b->GetCellData()->GetArray("RegionId"));
+  if (!ra || !rb || ra->GetNumberOfTuples() != rb->GetNumberOfTuples())
+    {
+    return false;
+    }
+  for (vtkIdType i = 0; i < ra->GetNumberOfTuples(); ++i)
+    {
+    if (ra->GetValue(i) != rb->GetValue(i))
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+int TestConnectivityLabeling(int, char*[])
+{
+  vtkSmartPointer<vtkPolyData> input = RandomTriangles(6000, 2500);
+  vtkIdType numCells = input->GetNumberOfCells();
+
+  // vtkConnectivityFilter, all regions
+  {
+  vtkSmartPointer<vtkConnectivityFilter> wave =
+    vtkSmartPointer<vtkConnectivityFilter>::New();
+  wave->SetInputData(input);
+  wave->SetExtractionModeToAllRegions();
+  wave->ColorRegionsOn();
+  wave->ScalarConnectivityOn();
+  wave->SetScalarRange(-1.0, 1.0);
+  wave->Update();
+
+  for (int numThreads = 1; numThreads <= 4; numThreads += 3)
+    {
+    vtkSmartPointer<vtkConnectivityFilter> labels =
+      vtkSmartPointer<vtkConnectivityFilter>::New();
+    labels->SetInputData(input);
+    labels->SetExtractionModeToAllRegions();
+    labels->ColorRegionsOn();
+    labels->SetNumberOfThreads(numThreads);
+    labels->Update();
+
+    if (labels->GetNumberOfExtractedRegions() < 2 ||
+        labels->GetNumberOfExtractedRegions() !=
+        wave->GetNumberOfExtractedRegions() ||
+        labels->GetOutput()->GetNumberOfCells() != numCells ||
+        labels->GetOutput()->GetNumberOfPoints() !=
+        wave->GetOutput()->GetNumberOfPoints() ||
+        !SameCellRegions(labels->GetOutput(), wave->GetOutput()))
+      {
+      std::cerr << "Error: vtkConnectivityFilter found "
+                << labels->GetNumberOfExtractedRegions()
+                << " regions with " << numThreads << " thread(s) but "
+                << wave->GetNumberOfExtractedRegions()
+                << " with scalar connectivity" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  }
+
+  // vtkPolyDataConnectivityFilter, largest region
+  {
+  vtkSmartPointer<vtkPolyDataConnectivityFilter> wave =
+    vtkSmartPointer<vtkPolyDataConnectivityFilter>::New();
+  wave->SetInputData(input);
+  wave->SetExtractionModeToLargestRegion();
+  wave->ScalarConnectivityOn();
+  wave->SetScalarRange(-1.0, 1.0);
+  wave->Update();
+
+  for (int numThreads = 1; numThreads <= 4; numThreads += 3)
+    {
+    vtkSmartPointer<vtkPolyDataConnectivityFilter> labels =
+      vtkSmartPointer<vtkPolyDataConnectivityFilter>::New();
+    labels->SetInputData(input);
+    labels->SetExtractionModeToLargestRegion();
+    labels->SetNumberOfThreads(numThreads);
+    labels->Update();
+
+    int numRegions = labels->GetNumberOfExtractedRegions();
+    bool same = (numRegions > 1 &&
+                 numRegions == wave->GetNumberOfExtractedRegions() &&
+                 labels->GetOutput()->GetNumberOfCells() ==
+                 wave->GetOutput()->GetNumberOfCells());
+    for (int i = 0; same && i < numRegions; ++i)
+      {
+      same = (labels->GetRegionSizes()->GetValue(i) ==
+              wave->GetRegionSizes()->GetValue(i));
+      }
+    if (!same)
+      {
+      std::cerr << "Error: vtkPolyDataConnectivityFilter found "
+                << numRegions << " regions with " << numThreads
+                << " thread(s) but " << wave->GetNumberOfExtractedRegions()
+                << " with scalar connectivity" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
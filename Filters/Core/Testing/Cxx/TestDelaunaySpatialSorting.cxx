@@ -0,0 +1,104 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestDelaunaySpatialSorting.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// This tests the SpatialSorting option of vtkDelaunay2D and vtkDelaunay3D.
+// Random points are in general position, so their Delaunay triangulation is
+// unique and must not depend on the insertion order.
+
+#include <vtkDelaunay2D.h>
+#include <vtkDelaunay3D.h>
+#include <vtkMinimalStandardRandomSequence.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkUnstructuredGrid.h>
+
+static vtkSmartPointer<vtkPolyData> RandomPoints(vtkIdType numPts, bool flat)
+{
+  vtkSmartPointer<vtkMinimalStandardRandomSequence> random =
+    vtkSmartPointer<vtkMinimalStandardRandomSequence>::New();
+  random->SetSeed(8775070);
+
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  points->SetDataTypeToDouble();
+  for (vtkIdType i = 0; i < numPts; ++i)
+    {
+    double x[3];
+    for (int j = 0; j < 3; ++j)
+      {
+      random->Next();
+      x[j] = random->GetValue();
+      }
+    if (flat)
+      {
+      x[2] = 0.0;
+      }
+    points->InsertNextPoint(x);
+    }
+
+  vtkSmartPointer<vtkPolyData> polydata = vtkSmartPointer<vtkPolyData>::New();
+  polydata->SetPoints(points);
+  return polydata;
+}
+
+int TestDelaunaySpatialSorting(int, char*[])
+{
+  const vtkIdType numPts = 2000;
+
+  // 2D
+  {
+  vtkSmartPointer<vtkPolyData> input = RandomPoints(numPts, true);
+  vtkSmartPointer<vtkDelaunay2D> del = vtkSmartPointer<vtkDelaunay2D>::New();
+  del->SetInputData(input);
+  del->Update();
+  vtkIdType numTris = del->GetOutput()->GetNumberOfPolys();
+
+  del->SpatialSortingOn();
+  del->Update();
+  vtkIdType numSortedTris = del->GetOutput()->GetNumberOfPolys();
+
+  if (numTris == 0 || numTris != numSortedTris ||
+      del->GetOutput()->GetNumberOfPoints() != numPts)
+    {
+    std::cerr << "Error: vtkDelaunay2D generated " << numTris
+              << " triangles in input order but " << numSortedTris
+              << " with spatial sorting" << std::endl;
+    return EXIT_FAILURE;
+    }
+  }
+
+  // 3D
+  {
+  vtkSmartPointer<vtkPolyData> input = RandomPoints(numPts, false);
+  vtkSmartPointer<vtkDelaunay3D> del = vtkSmartPointer<vtkDelaunay3D>::New();
+  del->SetInputData(input);
+  del->Update();
+  vtkIdType numTetras = del->GetOutput()->GetNumberOfCells();
+
+  del->SpatialSortingOn();
+  del->Update();
+  vtkIdType numSortedTetras = del->GetOutput()->GetNumberOfCells();
+
+  if (numTetras == 0 || numTetras != numSortedTetras ||
+      del->GetOutput()->GetNumberOfPoints() != numPts)
+    {
+    std::cerr << "Error: vtkDelaunay3D generated " << numTetras
+              << " tetrahedra in input order but " << numSortedTetras
+              << " with spatial sorting" << std::endl;
+    return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,145 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestGlyph3DInstances.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// This tests that the instance table of vtkGlyph3D describes the glyphs it
+// generates, and that the glyphs do not depend on the number of threads and
+// are the same as the ones generated in a single pass, which indexing forces.
+// The glyphs are more than the ones written in one batch.
+
+#include <vtkConeSource.h>
+#include <vtkDataArray.h>
+#include <vtkGlyph3D.h>
+#include <vtkIdList.h>
+#include <vtkMath.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkSphereSource.h>
+#include <vtkTransform.h>
+
+int TestGlyph3DInstances(int, char*[])
+{
+  vtkSmartPointer<vtkSphereSource> sphere =
+    vtkSmartPointer<vtkSphereSource>::New();
+  sphere->SetThetaResolution(160);
+  sphere->SetPhiResolution(140);
+  sphere->Update();
+
+  // glyphs oriented along the sphere normals
+  vtkSmartPointer<vtkPolyData> input = vtkSmartPointer<vtkPolyData>::New();
+  input->ShallowCopy(sphere->GetOutput());
+  input->GetPointData()->SetVectors(input->GetPointData()->GetNormals());
+
+  vtkSmartPointer<vtkConeSource> cone = vtkSmartPointer<vtkConeSource>::New();
+  cone->SetResolution(6);
+  cone->Update();
+  vtkPolyData *source = cone->GetOutput();
+
+  vtkSmartPointer<vtkTransform> sourceTransform =
+    vtkSmartPointer<vtkTransform>::New();
+  sourceTransform->Translate(0.5, 0.0, 0.0);
+
+  vtkSmartPointer<vtkGlyph3D> glyphs[4];
+  for (int i = 0; i < 4; ++i)
+    {
+    glyphs[i] = vtkSmartPointer<vtkGlyph3D>::New();
+    glyphs[i]->SetInputData(input);
+    glyphs[i]->SetSourceConnection(cone->GetOutputPort());
+    glyphs[i]->SetScaleFactor(0.25);
+    glyphs[i]->SetSourceTransform(sourceTransform);
+    }
+  glyphs[0]->SetNumberOfThreads(1);
+  glyphs[1]->SetNumberOfThreads(4);
+  glyphs[2]->OutputInstancesOn();
+  glyphs[3]->SetIndexModeToVector();
+  for (int i = 0; i < 4; ++i)
+    {
+    glyphs[i]->Update();
+    }
+
+  vtkPolyData *serial = glyphs[0]->GetOutput();
+  vtkPolyData *threaded = glyphs[1]->GetOutput();
+  vtkPolyData *table = glyphs[2]->GetOutput();
+  vtkPolyData *legacy = glyphs[3]->GetOutput();
+  vtkIdType numSourcePts = source->GetNumberOfPoints();
+  vtkIdType numGlyphs = input->GetNumberOfPoints();
+
+  if (serial->GetNumberOfPoints() != numGlyphs * numSourcePts ||
+      serial->GetNumberOfCells() != numGlyphs * source->GetNumberOfCells() ||
+      threaded->GetNumberOfPoints() != serial->GetNumberOfPoints() ||
+      threaded->GetNumberOfCells() != serial->GetNumberOfCells() ||
+      legacy->GetNumberOfPoints() != serial->GetNumberOfPoints() ||
+      legacy->GetNumberOfCells() != serial->GetNumberOfCells() ||
+      table->GetNumberOfPoints() != numGlyphs ||
+      table->GetNumberOfVerts() != numGlyphs)
+    {
+    std::cerr << "Error: unexpected number of points or cells" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  vtkDataArray *transforms = table->GetPointData()->GetArray("GlyphTransform");
+  if (!transforms || transforms->GetNumberOfComponents() != 16 ||
+      !table->GetPointData()->GetArray("GlyphSourceIndex"))
+    {
+    std::cerr << "Error: missing instance table arrays" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  for (vtkIdType glyphId = 0; glyphId < numGlyphs; ++glyphId)
+    {
+    double m[16];
+    transforms->GetTuple(glyphId, m);
+    for (vtkIdType i = 0; i < numSourcePts; ++i)
+      {
+      vtkIdType ptId = glyphId * numSourcePts + i;
+      double x[3], y[3], z[3], w[3];
+      source->GetPoint(i, x);
+      for (int j = 0; j < 3; ++j)
+        {
+        y[j] = m[4*j]*x[0] + m[4*j+1]*x[1] + m[4*j+2]*x[2] + m[4*j+3];
+        }
+      serial->GetPoint(ptId, x);
+      threaded->GetPoint(ptId, z);
+      legacy->GetPoint(ptId, w);
+      if (x[0] != z[0] || x[1] != z[1] || x[2] != z[2] ||
+          x[0] != w[0] || x[1] != w[1] || x[2] != w[2] ||
+          vtkMath::Distance2BetweenPoints(x, y) > 1.0e-10)
+        {
+        std::cerr << "Error: glyph point " << ptId << " differs" << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  vtkSmartPointer<vtkIdList> ids = vtkSmartPointer<vtkIdList>::New();
+  vtkSmartPointer<vtkIdList> legacyIds = vtkSmartPointer<vtkIdList>::New();
+  for (vtkIdType cellId = 0; cellId < serial->GetNumberOfCells(); ++cellId)
+    {
+    serial->GetCellPoints(cellId, ids);
+    legacy->GetCellPoints(cellId, legacyIds);
+    bool same = serial->GetCellType(cellId) == legacy->GetCellType(cellId) &&
+      ids->GetNumberOfIds() == legacyIds->GetNumberOfIds();
+    for (vtkIdType i = 0; same && i < ids->GetNumberOfIds(); ++i)
+      {
+      same = ids->GetId(i) == legacyIds->GetId(i);
+      }
+    if (!same)
+      {
+      std::cerr << "Error: glyph cell " << cellId << " differs" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
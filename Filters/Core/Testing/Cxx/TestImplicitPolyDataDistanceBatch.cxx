@@ -0,0 +1,106 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestImplicitPolyDataDistanceBatch.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+=========================================================================*/
+// This tests that the batch evaluation of vtkImplicitPolyDataDistance
+// matches the point by point evaluation, whatever the number of threads,
+// and that points are classified correctly against a closed surface.
+
+#include <vtkDoubleArray.h>
+#include <vtkImplicitPolyDataDistance.h>
+#include <vtkMath.h>
+#include <vtkMinimalStandardRandomSequence.h>
+#include <vtkPoints.h>
+#include <vtkSmartPointer.h>
+#include <vtkSphereSource.h>
+
+#include <cmath>
+
+int TestImplicitPolyDataDistanceBatch(int, char*[])
+{
+  vtkSmartPointer<vtkSphereSource> sphere =
+    vtkSmartPointer<vtkSphereSource>::New();
+  sphere->SetRadius(1.0);
+  sphere->SetPhiResolution(24);
+  sphere->SetThetaResolution(32);
+  sphere->Update();
+
+  vtkSmartPointer<vtkImplicitPolyDataDistance> distance =
+    vtkSmartPointer<vtkImplicitPolyDataDistance>::New();
+  distance->SetInput(sphere->GetOutput());
+
+  // Random points in a box around the sphere, and the sphere vertices
+  vtkSmartPointer<vtkMinimalStandardRandomSequence> random =
+    vtkSmartPointer<vtkMinimalStandardRandomSequence>::New();
+  random->SetSeed(8775070);
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  points->SetDataTypeToDouble();
+  for (int i = 0; i < 2000; ++i)
+    {
+    double x[3];
+    for (int j = 0; j < 3; ++j)
+      {
+      random->Next();
+      x[j] = random->GetRangeValue(-1.5, 1.5);
+      }
+    points->InsertNextPoint(x);
+    }
+  for (vtkIdType i = 0; i < sphere->GetOutput()->GetNumberOfPoints(); ++i)
+    {
+    points->InsertNextPoint(sphere->GetOutput()->GetPoint(i));
+    }
+
+  for (int numThreads = 1; numThreads <= 4; numThreads += 3)
+    {
+    distance->SetNumberOfThreads(numThreads);
+    vtkSmartPointer<vtkDoubleArray> distances =
+      vtkSmartPointer<vtkDoubleArray>::New();
+    vtkSmartPointer<vtkDoubleArray> gradients =
+      vtkSmartPointer<vtkDoubleArray>::New();
+    distance->EvaluatePoints(points, distances, gradients);
+
+    if (distances->GetNumberOfTuples() != points->GetNumberOfPoints() ||
+        gradients->GetNumberOfTuples() != points->GetNumberOfPoints())
+      {
+      std::cerr << "Error: wrong number of values" << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    for (vtkIdType i = 0; i < points->GetNumberOfPoints(); ++i)
+      {
+      double x[3], g[3], batchG[3];
+      points->GetPoint(i, x);
+      double d = distance->EvaluateFunction(x);
+      distance->EvaluateGradient(x, g);
+      gradients->GetTupleValue(i, batchG);
+      if (d != distances->GetValue(i) || g[0] != batchG[0] ||
+          g[1] != batchG[1] || g[2] != batchG[2])
+        {
+        std::cerr << "Error: batch value " << distances->GetValue(i)
+                  << " differs from " << d << " at point " << i
+                  << " with " << numThreads << " thread(s)" << std::endl;
+        return EXIT_FAILURE;
+        }
+
+      // The facets are within 0.01 of the sphere
+      double r = sqrt(vtkMath::Dot(x, x));
+      if ((r < 0.95 && d >= 0.0) || (r > 1.05 && d <= 0.0))
+        {
+        std::cerr << "Error: point " << i << " at radius " << r
+                  << " has distance " << d << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,269 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestProbeFilterThreads.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// This tests that vtkProbeFilter gives the same output whatever the number
+// of threads, with and without a cell locator, and that it interpolates a
+// linear field inside the source, up to the float precision of its points.
+
+#include <vtkCellData.h>
+#include <vtkCellLocator.h>
+#include <vtkCharArray.h>
+#include <vtkDataSetTriangleFilter.h>
+#include <vtkDoubleArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkImageData.h>
+#include <vtkIntArray.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkProbeFilter.h>
+#include <vtkSmartPointer.h>
+#include <vtkUnstructuredGrid.h>
+
+#include <cmath>
+
+static double LinearField(const double x[3])
+{
+  return x[0] + 2.0*x[1] - 3.0*x[2];
+}
+
+static vtkSmartPointer<vtkImageData> MakeImage(int dim, double origin,
+                                               double spacing)
+{
+  vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+  image->SetDimensions(dim, dim, dim);
+  image->SetOrigin(origin, origin, origin);
+  image->SetSpacing(spacing, spacing, spacing);
+  return image;
+}
+
+static bool SameArrays(vtkDataArray *a, vtkDataArray *b)
+{
+  if (!a || !b || a->GetNumberOfTuples() != b->GetNumberOfTuples() ||
+      a->GetNumberOfComponents() != b->GetNumberOfComponents())
+    {
+    return false;
+    }
+  for (vtkIdType i = 0; i < a->GetNumberOfTuples(); ++i)
+    {
+    for (int c = 0; c < a->GetNumberOfComponents(); ++c)
+      {
+      if (a->GetComponent(i, c) != b->GetComponent(i, c))
+        {
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+static bool SameOutputs(vtkProbeFilter *a, vtkProbeFilter *b)
+{
+  const char *names[3] = { "Field", "Ids", "vtkValidPointMask" };
+  for (int i = 0; i < 3; ++i)
+    {
+    if (!SameArrays(a->GetOutput()->GetPointData()->GetArray(names[i]),
+                    b->GetOutput()->GetPointData()->GetArray(names[i])))
+      {
+      return false;
+      }
+    }
+  return SameArrays(a->GetValidPoints(), b->GetValidPoints());
+}
+
+int TestProbeFilterThreads(int, char*[])
+{
+  // A tetrahedral source with a linear point field and a cell array
+  vtkSmartPointer<vtkImageData> grid = MakeImage(21, -1.0, 0.1);
+  vtkSmartPointer<vtkDoubleArray> field =
+    vtkSmartPointer<vtkDoubleArray>::New();
+  field->SetName("Field");
+  for (vtkIdType i = 0; i < grid->GetNumberOfPoints(); ++i)
+    {
+    field->InsertNextValue(LinearField(grid->GetPoint(i)));
+    }
+  grid->GetPointData()->AddArray(field);
+
+  vtkSmartPointer<vtkDataSetTriangleFilter> tetra =
+    vtkSmartPointer<vtkDataSetTriangleFilter>::New();
+  tetra->SetInputData(grid);
+  tetra->Update();
+  vtkUnstructuredGrid *source = tetra->GetOutput();
+
+  vtkSmartPointer<vtkIntArray> ids = vtkSmartPointer<vtkIntArray>::New();
+  ids->SetName("Ids");
+  for (vtkIdType i = 0; i < source->GetNumberOfCells(); ++i)
+    {
+    ids->InsertNextValue(static_cast<int>(i));
+    }
+  source->GetCellData()->AddArray(ids);
+
+  // Probe points partly outside of the source
+  vtkSmartPointer<vtkImageData> input = MakeImage(37, -1.3, 0.07);
+
+  vtkSmartPointer<vtkProbeFilter> reference =
+    vtkSmartPointer<vtkProbeFilter>::New();
+  reference->SetInputData(input);
+  reference->SetSourceData(source);
+  reference->SetNumberOfThreads(1);
+  reference->Update();
+
+  vtkDataArray *probed =
+    reference->GetOutput()->GetPointData()->GetArray("Field");
+  vtkCharArray *mask = vtkCharArray::SafeDownCast(
+    reference->GetOutput()->GetPointData()->GetArray("vtkValidPointMask"));
+  vtkIdTypeArray *validPoints = reference->GetValidPoints();
+  if (!probed || !mask ||
+      probed->GetNumberOfTuples() != input->GetNumberOfPoints())
+    {
+    std::cerr << "Error: missing probed arrays" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  vtkIdType numValid = 0;
+  for (vtkIdType i = 0; i < input->GetNumberOfPoints(); ++i)
+    {
+    double x[3];
+    input->GetPoint(i, x);
+    bool inside = std::fabs(x[0]) < 0.99 && std::fabs(x[1]) < 0.99 &&
+      std::fabs(x[2]) < 0.99;
+    bool outside = std::fabs(x[0]) > 1.01 || std::fabs(x[1]) > 1.01 ||
+      std::fabs(x[2]) > 1.01;
+    if ((inside && mask->GetValue(i) != 1) ||
+        (outside && mask->GetValue(i) != 0))
+      {
+      std::cerr << "Error: point " << i << " has mask "
+                << static_cast<int>(mask->GetValue(i)) << std::endl;
+      return EXIT_FAILURE;
+      }
+    double expected = ( mask->GetValue(i) ? LinearField(x) : 0.0 );
+    if (std::fabs(probed->GetComponent(i, 0) - expected) > 1e-5)
+      {
+      std::cerr << "Error: point " << i << " is probed as "
+                << probed->GetComponent(i, 0) << " instead of " << expected
+                << std::endl;
+      return EXIT_FAILURE;
+      }
+    if (mask->GetValue(i))
+      {
+      if (numValid >= validPoints->GetNumberOfTuples() ||
+          validPoints->GetValue(numValid) != i)
+        {
+        std::cerr << "Error: point " << i << " is not listed as valid"
+                  << std::endl;
+        return EXIT_FAILURE;
+        }
+      ++numValid;
+      }
+    }
+  if (numValid == 0 || numValid == input->GetNumberOfPoints() ||
+      numValid != validPoints->GetNumberOfTuples())
+    {
+    std::cerr << "Error: " << validPoints->GetNumberOfTuples()
+              << " valid points" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Same output with threads, with and without a cell locator
+  vtkSmartPointer<vtkCellLocator> locator =
+    vtkSmartPointer<vtkCellLocator>::New();
+  for (int useLocator = 0; useLocator < 2; ++useLocator)
+    {
+    vtkSmartPointer<vtkProbeFilter> serial =
+      vtkSmartPointer<vtkProbeFilter>::New();
+    serial->SetInputData(input);
+    serial->SetSourceData(source);
+    serial->SetNumberOfThreads(1);
+    if (useLocator)
+      {
+      serial->SetCellLocator(locator);
+      }
+    serial->Update();
+
+    for (int numThreads = 2; numThreads <= 8; numThreads *= 2)
+      {
+      vtkSmartPointer<vtkProbeFilter> threaded =
+        vtkSmartPointer<vtkProbeFilter>::New();
+      threaded->SetInputData(input);
+      threaded->SetSourceData(source);
+      threaded->SetNumberOfThreads(numThreads);
+      if (useLocator)
+        {
+        threaded->SetCellLocator(locator);
+        }
+      threaded->Update();
+      if (!SameOutputs(serial, threaded) ||
+          (!useLocator && !SameOutputs(reference, threaded)))
+        {
+        std::cerr << "Error: the output differs with " << numThreads
+                  << " threads" << (useLocator ? " and a locator" : "")
+                  << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+
+    // The locator finds the same points, up to the tolerance
+    vtkDataArray *located =
+      serial->GetOutput()->GetPointData()->GetArray("Field");
+    vtkDataArray *locatedMask =
+      serial->GetOutput()->GetPointData()->GetArray("vtkValidPointMask");
+    for (vtkIdType i = 0; useLocator && i < input->GetNumberOfPoints(); ++i)
+      {
+      if (locatedMask->GetComponent(i, 0) &&
+          std::fabs(located->GetComponent(i, 0) -
+                    probed->GetComponent(i, 0)) > 1e-5)
+        {
+        std::cerr << "Error: point " << i << " is probed as "
+                  << located->GetComponent(i, 0) << " with a locator"
+                  << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  // An image source, probed at the same points given as a point cloud
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  for (vtkIdType i = 0; i < input->GetNumberOfPoints(); ++i)
+    {
+    points->InsertNextPoint(input->GetPoint(i));
+    }
+  vtkSmartPointer<vtkPolyData> cloud = vtkSmartPointer<vtkPolyData>::New();
+  cloud->SetPoints(points);
+
+  vtkSmartPointer<vtkProbeFilter> imageReference =
+    vtkSmartPointer<vtkProbeFilter>::New();
+  imageReference->SetInputData(cloud);
+  imageReference->SetSourceData(grid);
+  imageReference->SetNumberOfThreads(1);
+  imageReference->Update();
+  vtkSmartPointer<vtkProbeFilter> imageThreaded =
+    vtkSmartPointer<vtkProbeFilter>::New();
+  imageThreaded->SetInputData(cloud);
+  imageThreaded->SetSourceData(grid);
+  imageThreaded->SetNumberOfThreads(4);
+  imageThreaded->Update();
+  if (!SameArrays(
+        imageReference->GetOutput()->GetPointData()->GetArray("Field"),
+        imageThreaded->GetOutput()->GetPointData()->GetArray("Field")) ||
+      !SameArrays(imageReference->GetValidPoints(),
+                  imageThreaded->GetValidPoints()) ||
+      imageReference->GetValidPoints()->GetNumberOfTuples() != numValid)
+    {
+    std::cerr << "Error: the probe of the image differs with 4 threads"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,128 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestTensorGlyphInstances.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// This tests that the instance table of vtkTensorGlyph describes the glyphs
+// it generates: applying the transformation of each instance to the source
+// gives the points of the glyph, and the instance has the color of the
+// glyph. Three symmetric glyphs per point are generated, and one of the
+// tensors has a negative eigenvalue.
+
+#include <vtkConeSource.h>
+#include <vtkDataArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkMath.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkTensorGlyph.h>
+
+int TestTensorGlyphInstances(int, char*[])
+{
+  static const double tensors[4][9] = {
+    { 1.0, 0.0, 0.0,   0.0, 2.0, 0.0,   0.0, 0.0, 3.0 },
+    { 2.0, 1.0, 0.0,   1.0, 2.0, 0.0,   0.0, 0.0, 1.0 },
+    { -1.0, 0.0, 0.0,  0.0, 0.5, 0.0,   0.0, 0.0, 2.0 },
+    { 1.0, 0.5, 0.2,   0.5, 3.0, 0.1,   0.2, 0.1, 2.0 } };
+
+  vtkSmartPointer<vtkPolyData> input = vtkSmartPointer<vtkPolyData>::New();
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  vtkSmartPointer<vtkDoubleArray> tensorArray =
+    vtkSmartPointer<vtkDoubleArray>::New();
+  tensorArray->SetNumberOfComponents(9);
+  for (int i = 0; i < 4; ++i)
+    {
+    points->InsertNextPoint(4.0*i, 0.5*i, -1.0*i);
+    tensorArray->InsertNextTuple(tensors[i]);
+    }
+  input->SetPoints(points);
+  input->GetPointData()->SetTensors(tensorArray);
+
+  vtkSmartPointer<vtkConeSource> cone = vtkSmartPointer<vtkConeSource>::New();
+  cone->SetResolution(6);
+  cone->Update();
+  vtkPolyData *source = cone->GetOutput();
+
+  vtkSmartPointer<vtkTensorGlyph> glyphs[2];
+  for (int i = 0; i < 2; ++i)
+    {
+    glyphs[i] = vtkSmartPointer<vtkTensorGlyph>::New();
+    glyphs[i]->SetInputData(input);
+    glyphs[i]->SetSourceConnection(cone->GetOutputPort());
+    glyphs[i]->SetScaleFactor(0.5);
+    glyphs[i]->ThreeGlyphsOn();
+    glyphs[i]->SymmetricOn();
+    glyphs[i]->ColorGlyphsOn();
+    glyphs[i]->SetColorModeToEigenvalues();
+    }
+  glyphs[1]->OutputInstancesOn();
+  glyphs[0]->Update();
+  glyphs[1]->Update();
+
+  vtkPolyData *geometry = glyphs[0]->GetOutput();
+  vtkPolyData *table = glyphs[1]->GetOutput();
+  vtkIdType numSourcePts = source->GetNumberOfPoints();
+  vtkIdType numGlyphs = 6 * input->GetNumberOfPoints();
+
+  if (geometry->GetNumberOfPoints() != numGlyphs * numSourcePts ||
+      table->GetNumberOfPoints() != numGlyphs ||
+      table->GetNumberOfVerts() != numGlyphs ||
+      table->GetNumberOfCells() != numGlyphs)
+    {
+    std::cerr << "Error: unexpected number of points or cells" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  vtkDataArray *transforms = table->GetPointData()->GetArray("GlyphTransform");
+  vtkDataArray *colors = geometry->GetPointData()->GetScalars();
+  vtkDataArray *tableColors = table->GetPointData()->GetScalars();
+  if (!transforms || transforms->GetNumberOfComponents() != 16 ||
+      !colors || !tableColors)
+    {
+    std::cerr << "Error: missing instance table arrays" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  for (vtkIdType glyphId = 0; glyphId < numGlyphs; ++glyphId)
+    {
+    double m[16], x[3], y[3], z[3];
+    transforms->GetTuple(glyphId, m);
+    table->GetPoint(glyphId, x);
+    input->GetPoint(glyphId / 6, y);
+    if (x[0] != y[0] || x[1] != y[1] || x[2] != y[2])
+      {
+      std::cerr << "Error: instance " << glyphId << " is not at its input "
+                << "point" << std::endl;
+      return EXIT_FAILURE;
+      }
+    for (vtkIdType i = 0; i < numSourcePts; ++i)
+      {
+      vtkIdType ptId = glyphId * numSourcePts + i;
+      source->GetPoint(i, x);
+      for (int j = 0; j < 3; ++j)
+        {
+        y[j] = m[4*j]*x[0] + m[4*j+1]*x[1] + m[4*j+2]*x[2] + m[4*j+3];
+        }
+      geometry->GetPoint(ptId, z);
+      if (vtkMath::Distance2BetweenPoints(y, z) > 1.0e-10 ||
+          colors->GetTuple1(ptId) != tableColors->GetTuple1(glyphId))
+        {
+        std::cerr << "Error: glyph point " << ptId << " differs" << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
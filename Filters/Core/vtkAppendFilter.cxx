@@ -14,26 +14,191 @@
 =========================================================================*/
 #include "vtkAppendFilter.h"
 
+#include "vtkCellArray.h"
 #include "vtkCellData.h"
 #include "vtkCell.h"
 #include "vtkDataSetAttributes.h"
 #include "vtkDataSetCollection.h"
 #include "vtkExecutive.h"
+#include "vtkIdTypeArray.h"
 #include "vtkIncrementalOctreePointLocator.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
+#include "vtkUnsignedCharArray.h"
 #include "vtkUnstructuredGrid.h"
 
+#include <vector>
+
 vtkStandardNewMacro(vtkAppendFilter);
 
+// Where an unstructured grid input goes in the output when inputs are
+// appended in bulk. This is computed for all the inputs before anything is
+// copied, so that the inputs can be copied concurrently.
+struct vtkAppendFilterInput
+{
+  vtkUnstructuredGrid *Input;
+  int Index; // index of the input in the field lists
+  vtkIdType PointOffset;
+  vtkIdType CellOffset;
+  vtkIdType ConnectivityOffset;
+};
+
+struct vtkAppendFilterThreadStruct
+{
+  vtkAppendFilterInput *Inputs;
+  int *FirstInput; // thread i copies inputs FirstInput[i]...FirstInput[i+1]-1
+  vtkDataArray *Points;
+  vtkIdType *Connectivity;
+  unsigned char *Types;
+  vtkIdType *Locations;
+  vtkPointData *OutputPD;
+  vtkCellData *OutputCD;
+  vtkDataSetAttributes::FieldList *PointList;
+  vtkDataSetAttributes::FieldList *CellList;
+
+  // The filter checked for abort and reporting progress
+  vtkAppendFilter *Filter;
+};
+
+//----------------------------------------------------------------------------
+template <class IT, class OT>
+void vtkAppendFilterConvertPoints(IT *in, OT *out, vtkIdType n)
+{
+  for (vtkIdType i = 0; i < n; i++)
+    {
+    *out++ = static_cast<OT>(*in++);
+    }
+}
+
+//----------------------------------------------------------------------------
+// Points are copied in bulk; float and double points may be mixed.
+static void vtkAppendFilterCopyPoints(vtkDataArray *src, vtkDataArray *dest,
+                                      vtkIdType offset)
+{
+  vtkIdType n = 3*src->GetNumberOfTuples();
+  void *pSrc = src->GetVoidPointer(0);
+  void *pDest = dest->GetVoidPointer(3*offset);
+
+  if ( src->GetDataType() == dest->GetDataType() )
+    {
+    memcpy(pDest, pSrc, static_cast<size_t>(n) * src->GetDataTypeSize());
+    }
+  else if ( src->GetDataType() == VTK_FLOAT )
+    {
+    vtkAppendFilterConvertPoints(static_cast<float *>(pSrc),
+                                 static_cast<double *>(pDest), n);
+    }
+  else
+    {
+    vtkAppendFilterConvertPoints(static_cast<double *>(pSrc),
+                                 static_cast<float *>(pDest), n);
+    }
+}
+
+//----------------------------------------------------------------------------
+static bool vtkAppendFilterHasBitArrays(vtkDataSetAttributes *dsa)
+{
+  for (int i = 0; i < dsa->GetNumberOfArrays(); i++)
+    {
+    if ( dsa->GetAbstractArray(i)->GetDataType() == VTK_BIT )
+      {
+      return true;
+      }
+    }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+// Copy the points, cells and attributes of a range of unstructured grid
+// inputs. Every input is written into its own, preallocated, range of the
+// output.
+static VTK_THREAD_RETURN_TYPE vtkAppendFilterThreadedAppend(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkAppendFilterThreadStruct *str =
+    static_cast<vtkAppendFilterThreadStruct *>(info->UserData);
+
+  int first = str->FirstInput[info->ThreadID];
+  int last = str->FirstInput[info->ThreadID+1];
+  for (int idx = first; idx < last; ++idx)
+    {
+    if ( str->Filter->GetAbortExecute() )
+      {
+      break;
+      }
+    if ( info->ThreadID == 0 )
+      {
+      str->Filter->UpdateProgress(static_cast<double>(idx - first) /
+                                  (last - first));
+      }
+
+    vtkAppendFilterInput &in = str->Inputs[idx];
+    vtkUnstructuredGrid *ug = in.Input;
+    vtkIdType numPts = ug->GetNumberOfPoints();
+    vtkIdType numCells = ug->GetNumberOfCells();
+
+    // copy points and point data
+    if ( numPts > 0 )
+      {
+      vtkAppendFilterCopyPoints(ug->GetPoints()->GetData(), str->Points,
+                                in.PointOffset);
+      }
+    str->OutputPD->CopyData(*str->PointList, ug->GetPointData(), in.Index,
+                            0, in.PointOffset, numPts);
+
+    if ( numCells <= 0 )
+      {
+      continue;
+      }
+
+    // copy cells: the connectivity is offset by the point offset, and the
+    // cell locations by the connectivity offset.
+    vtkCellArray *cells = ug->GetCells();
+    vtkIdType *pSrc = cells->GetPointer();
+    vtkIdType *end = pSrc + cells->GetNumberOfConnectivityEntries();
+    vtkIdType *pDest = str->Connectivity + in.ConnectivityOffset;
+    vtkIdType npts;
+    while ( pSrc < end )
+      {
+      npts = *pSrc++;
+      *pDest++ = npts;
+      for ( ; npts > 0; npts-- )
+        {
+        *pDest++ = *pSrc++ + in.PointOffset;
+        }
+      }
+
+    memcpy(str->Types + in.CellOffset,
+           ug->GetCellTypesArray()->GetPointer(0),
+           static_cast<size_t>(numCells) * sizeof(unsigned char));
+
+    vtkIdType *inLocations = ug->GetCellLocationsArray()->GetPointer(0);
+    vtkIdType *outLocations = str->Locations + in.CellOffset;
+    for (vtkIdType cellId = 0; cellId < numCells; cellId++)
+      {
+      outLocations[cellId] = inLocations[cellId] + in.ConnectivityOffset;
+      }
+
+    // copy cell data
+    str->OutputCD->CopyData(*str->CellList, ug->GetCellData(), in.Index,
+                            0, in.CellOffset, numCells);
+    }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
 //----------------------------------------------------------------------------
 vtkAppendFilter::vtkAppendFilter()
 {
   this->InputList = NULL;
   this->MergePoints = 0;
   this->OutputPointsPrecision = DEFAULT_PRECISION;
+  this->Threader = vtkMultiThreader::New();
+  this->NumberOfThreads = this->Threader->GetNumberOfThreads();
 }
 
 //----------------------------------------------------------------------------
@@ -44,6 +209,7 @@ vtkAppendFilter::~vtkAppendFilter()
     this->InputList->Delete();
     this->InputList = NULL;
     }
+  this->Threader->Delete();
 }
 
 //----------------------------------------------------------------------------
@@ -215,6 +381,140 @@ int vtkAppendFilter::RequestData(
     return 1;
     }
 
+  // Unstructured grids without polyhedra (e.g. blocks being gathered) can
+  // be appended with bulk copies of points, connectivity and attributes.
+  std::vector<vtkAppendFilterInput> bulkInputs;
+  vtkIdType connectivitySize = 0;
+  bool bulk = true, pointTypeSet = false;
+  int outputPointType = VTK_FLOAT;
+  if (this->OutputPointsPrecision == vtkAlgorithm::DOUBLE_PRECISION)
+    {
+    outputPointType = VTK_DOUBLE;
+    }
+  for (idx = 0; bulk && idx < numInputs; ++idx)
+    {
+    inInfo = inputVector[0]->GetInformationObject(idx);
+    ds = 0;
+    if (inInfo)
+      {
+      ds = vtkDataSet::SafeDownCast(inInfo->Get(vtkDataObject::DATA_OBJECT()));
+      }
+    if ( ds == NULL ||
+         (ds->GetNumberOfPoints() <= 0 && ds->GetNumberOfCells() <= 0) )
+      {
+      continue;
+      }
+    vtkUnstructuredGrid *ug = vtkUnstructuredGrid::SafeDownCast(ds);
+    if ( !ug || ug->GetFaces() || !ug->GetPoints() ||
+         (ug->GetNumberOfCells() > 0 && !ug->GetCells()) )
+      {
+      bulk = false;
+      break;
+      }
+    int type = ug->GetPoints()->GetDataType();
+    if ( !pointTypeSet && ug->GetNumberOfPoints() > 0 &&
+         this->OutputPointsPrecision == vtkAlgorithm::DEFAULT_PRECISION )
+      {
+      outputPointType = type; // same rule as below
+      pointTypeSet = true;
+      }
+    if ( type != outputPointType &&
+         !((type == VTK_FLOAT || type == VTK_DOUBLE) &&
+           (outputPointType == VTK_FLOAT || outputPointType == VTK_DOUBLE)) )
+      {
+      bulk = false;
+      break;
+      }
+    vtkAppendFilterInput in;
+    in.Input = ug;
+    in.Index = static_cast<int>(bulkInputs.size());
+    in.PointOffset = bulkInputs.empty() ? 0 :
+      bulkInputs.back().PointOffset +
+      bulkInputs.back().Input->GetNumberOfPoints();
+    in.CellOffset = bulkInputs.empty() ? 0 :
+      bulkInputs.back().CellOffset +
+      bulkInputs.back().Input->GetNumberOfCells();
+    in.ConnectivityOffset = connectivitySize;
+    if ( ug->GetNumberOfCells() > 0 )
+      {
+      connectivitySize += ug->GetCells()->GetNumberOfConnectivityEntries();
+      }
+    bulkInputs.push_back(in);
+    }
+  if ( bulk && !bulkInputs.empty() )
+    {
+    outputPD->CopyGlobalIdsOn();
+    outputPD->CopyAllocate(ptList,numPts);
+    outputPD->SetNumberOfTuples(numPts);
+    outputCD->CopyGlobalIdsOn();
+    outputCD->CopyAllocate(cellList,numCells);
+    outputCD->SetNumberOfTuples(numCells);
+
+    newPts = vtkPoints::New(outputPointType);
+    newPts->SetNumberOfPoints(numPts);
+    vtkCellArray *newCells = vtkCellArray::New();
+    vtkIdType *pConn = newCells->WritePointer(numCells, connectivitySize);
+    vtkUnsignedCharArray *newTypes = vtkUnsignedCharArray::New();
+    newTypes->SetNumberOfTuples(numCells);
+    vtkIdTypeArray *newLocations = vtkIdTypeArray::New();
+    newLocations->SetNumberOfTuples(numCells);
+
+    // Distribute the inputs over the threads so that each thread copies
+    // roughly the same amount of data.
+    int numBulkInputs = static_cast<int>(bulkInputs.size());
+    int numThreads = this->NumberOfThreads;
+    numThreads = (numThreads > numBulkInputs ? numBulkInputs : numThreads);
+    if ( vtkAppendFilterHasBitArrays(outputPD) ||
+         vtkAppendFilterHasBitArrays(outputCD) )
+      {
+      numThreads = 1; // bits of adjacent ranges share bytes
+      }
+    numThreads = (numThreads < 1 ? 1 : numThreads);
+
+    vtkIdType totalWork = numPts + connectivitySize;
+    std::vector<int> firstInput(numThreads+1);
+    int thread = 1;
+    firstInput[0] = 0;
+    for (idx = 0; idx < numBulkInputs; ++idx)
+      {
+      vtkIdType work = bulkInputs[idx].PointOffset +
+        bulkInputs[idx].ConnectivityOffset;
+      while ( thread < numThreads && work >= thread*totalWork/numThreads )
+        {
+        firstInput[thread++] = idx;
+        }
+      }
+    while ( thread <= numThreads )
+      {
+      firstInput[thread++] = numBulkInputs;
+      }
+
+    vtkAppendFilterThreadStruct str;
+    str.Inputs = &bulkInputs[0];
+    str.FirstInput = &firstInput[0];
+    str.Points = newPts->GetData();
+    str.Connectivity = pConn;
+    str.Types = newTypes->GetPointer(0);
+    str.Locations = newLocations->GetPointer(0);
+    str.OutputPD = outputPD;
+    str.OutputCD = outputCD;
+    str.PointList = &ptList;
+    str.CellList = &cellList;
+    str.Filter = this;
+
+    this->Threader->SetNumberOfThreads(numThreads);
+    this->Threader->SetSingleMethod(vtkAppendFilterThreadedAppend, &str);
+    this->Threader->SingleMethodExecute();
+
+    output->SetPoints(newPts);
+    output->SetCells(newTypes, newLocations, newCells);
+    newPts->Delete();
+    newCells->Delete();
+    newTypes->Delete();
+    newLocations->Delete();
+    return 1;
+    }
+
   // Now can allocate memory
   output->Allocate(numCells); //allocate storage for geometry/topology
   outputPD->CopyGlobalIdsOn();
@@ -702,4 +1002,5 @@ void vtkAppendFilter::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "MergePoints:" << (this->MergePoints?"On":"Off") << "\n";
   os << indent << "Precision of the output points: "
      << this->OutputPointsPrecision << "\n";
+  os << indent << "Number Of Threads: " << this->NumberOfThreads << "\n";
 }
@@ -31,6 +31,7 @@
 #include "vtkUnstructuredGridAlgorithm.h"
 
 class vtkDataSetCollection;
+class vtkMultiThreader;
 
 class VTKFILTERSCORE_EXPORT vtkAppendFilter : public vtkUnstructuredGridAlgorithm
 {
@@ -78,6 +79,15 @@ public:
   vtkSetClampMacro(OutputPointsPrecision, int, SINGLE_PRECISION, DEFAULT_PRECISION);
   vtkGetMacro(OutputPointsPrecision, int);
 
+  // Description:
+  // Set/Get the number of threads used to copy the inputs into the output
+  // when all inputs are unstructured grids without polyhedra (and points
+  // are not merged). The output is then allocated up front, and each input
+  // is copied with bulk copies into its own range of the output. By
+  // default, the number of threads is set to the number of processors.
+  vtkSetClampMacro(NumberOfThreads, int, 1, VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads, int);
+
 protected:
   vtkAppendFilter();
   ~vtkAppendFilter();
@@ -106,6 +116,9 @@ protected:
 
   int OutputPointsPrecision;
 
+  vtkMultiThreader *Threader;
+  int NumberOfThreads;
+
 private:
   vtkAppendFilter(const vtkAppendFilter&);  // Not implemented.
   void operator=(const vtkAppendFilter&);  // Not implemented.
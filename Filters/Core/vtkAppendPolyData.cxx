@@ -20,24 +20,80 @@
 #include "vtkDataSetAttributes.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
 #include "vtkPolyData.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
 #include "vtkTrivialProducer.h"
 
+#include <vector>
+
 vtkStandardNewMacro(vtkAppendPolyData);
 
+// Where an input goes in the output. This is computed for all the inputs
+// before anything is copied, so that the inputs can then be copied
+// independently (and concurrently) into their own ranges of the output.
+struct vtkAppendPolyDataInput
+{
+  vtkPolyData *Input;
+  int PointIndex; // index of the input in the point field list, or -1
+  int CellIndex;  // index of the input in the cell field list, or -1
+  vtkCellArray *Cells[4]; // verts, lines, polys and strips
+  vtkIdType PointOffset;
+  vtkIdType CellOffset[4]; // output id of the first vert, line, poly, strip
+  vtkIdType ConnectivityOffset[4];
+};
+
+struct vtkAppendPolyDataThreadStruct
+{
+  vtkAppendPolyData *Filter;
+  vtkAppendPolyDataInput *Inputs;
+  int *FirstInput; // thread i copies inputs FirstInput[i]...FirstInput[i+1]-1
+  vtkPoints *Points;
+  int AllSame;
+  vtkDataArray *PointAttributes[5];
+  vtkPointData *OutputPD;
+  vtkCellData *OutputCD;
+  vtkDataSetAttributes::FieldList *PointList;
+  vtkDataSetAttributes::FieldList *CellList;
+  vtkIdType *Connectivity[4];
+};
+
+// Attribute types of vtkAppendPolyDataThreadStruct::PointAttributes
+static const int vtkAppendPolyDataAttributeTypes[5] = {
+  vtkDataSetAttributes::SCALARS,
+  vtkDataSetAttributes::VECTORS,
+  vtkDataSetAttributes::NORMALS,
+  vtkDataSetAttributes::TCOORDS,
+  vtkDataSetAttributes::TENSORS };
+
+//----------------------------------------------------------------------------
+static bool vtkAppendPolyDataHasBitArrays(vtkDataSetAttributes *dsa)
+{
+  for (int i = 0; i < dsa->GetNumberOfArrays(); i++)
+    {
+    if ( dsa->GetAbstractArray(i)->GetDataType() == VTK_BIT )
+      {
+      return true;
+      }
+    }
+  return false;
+}
+
 //----------------------------------------------------------------------------
 vtkAppendPolyData::vtkAppendPolyData()
 {
   this->ParallelStreaming = 0;
   this->UserManagedInputs = 0;
+  this->Threader = vtkMultiThreader::New();
+  this->NumberOfThreads = this->Threader->GetNumberOfThreads();
 }
 
 //----------------------------------------------------------------------------
 vtkAppendPolyData::~vtkAppendPolyData()
 {
+  this->Threader->Delete();
 }
 
 //----------------------------------------------------------------------------
@@ -124,15 +180,11 @@ void vtkAppendPolyData::SetInputConnectionByNumber(int num,
 int vtkAppendPolyData::ExecuteAppend(vtkPolyData* output,
     vtkPolyData* inputs[], int numInputs)
 {
-  int idx;
+  int idx, type;
   vtkPolyData *ds;
-  vtkPoints  *inPts;
   vtkPoints *newPts;
-  vtkCellArray *inVerts, *newVerts;
-  vtkCellArray *inLines, *newLines;
-  vtkCellArray *inPolys, *newPolys;
-  vtkIdType sizePolys, numPolys;
-  vtkCellArray *inStrips, *newStrips;
+  vtkCellArray *newCells[4];
+  vtkIdType *newConn[4];
   vtkIdType numPts, numCells;
   vtkPointData *inPD = NULL;
   vtkCellData *inCD = NULL;
@@ -143,23 +195,20 @@ int vtkAppendPolyData::ExecuteAppend(vtkPolyData* output,
   vtkDataArray *newPtNormals = NULL;
   vtkDataArray *newPtTCoords = NULL;
   vtkDataArray *newPtTensors = NULL;
-  int i;
-  vtkIdType *pts = 0;
-  vtkIdType *pPolys;
-  vtkIdType npts = 0;
-  vtkIdType ptId, cellId;
 
   vtkDebugMacro(<<"Appending polydata");
 
   // loop over all data sets, checking to see what point data is available.
   numPts = 0;
   numCells = 0;
-  sizePolys = numPolys = 0;
 
   int countPD=0;
   int countCD=0;
 
-  vtkIdType numVerts = 0, numLines = 0, numStrips = 0;
+  // Number of cells and size of the connectivity of verts, lines, polys
+  // and strips (in that order, which is also the order of cell ids).
+  vtkIdType numTypeCells[4] = {0, 0, 0, 0};
+  vtkIdType sizeTypeCells[4] = {0, 0, 0, 0};
 
   // These Field lists are very picky.  Count the number of non empty inputs
   // so we can initialize them properly.
@@ -183,10 +232,23 @@ int vtkAppendPolyData::ExecuteAppend(vtkPolyData* output,
   vtkDataSetAttributes::FieldList ptList(countPD);
   vtkDataSetAttributes::FieldList cellList(countCD);
 
+  // Where each input goes in the output
+  std::vector<vtkAppendPolyDataInput> info(numInputs);
+
   countPD = countCD = 0;
   for (idx = 0; idx < numInputs; ++idx)
     {
     ds = inputs[idx];
+    info[idx].Input = NULL;
+    info[idx].PointIndex = -1;
+    info[idx].CellIndex = -1;
+    info[idx].PointOffset = numPts;
+    for (type = 0; type < 4; type++)
+      {
+      info[idx].Cells[type] = NULL;
+      info[idx].CellOffset[type] = numTypeCells[type];
+      info[idx].ConnectivityOffset[type] = sizeTypeCells[type];
+      }
     if (ds != NULL)
       {
       // Skip points and cells if there are no points.  Empty inputs may have no arrays.
@@ -203,25 +265,28 @@ int vtkAppendPolyData::ExecuteAppend(vtkPolyData* output,
           {
           ptList.IntersectFieldList(inPD);
           }
+        info[idx].Input = ds;
+        info[idx].PointIndex = countPD;
         ++countPD;
         } // for a data set that has points
 
       // Although we cannot have cells without points ... let's not nest.
       if (ds->GetNumberOfCells() > 0 )
         {
-        // keep track of the size of the poly cell array
-        if (ds->GetPolys())
+        numCells += ds->GetNumberOfCells();
+        // Keep track of the number and connectivity size of the cells of
+        // each type. This is used to ensure that cells and cell data are
+        // copied at the correct locations in the output.
+        info[idx].Cells[0] = ds->GetVerts();
+        info[idx].Cells[1] = ds->GetLines();
+        info[idx].Cells[2] = ds->GetPolys();
+        info[idx].Cells[3] = ds->GetStrips();
+        for (type = 0; type < 4; type++)
           {
-          sizePolys += ds->GetPolys()->GetNumberOfConnectivityEntries();
+          numTypeCells[type] += info[idx].Cells[type]->GetNumberOfCells();
+          sizeTypeCells[type] +=
+            info[idx].Cells[type]->GetNumberOfConnectivityEntries();
           }
-        numCells += ds->GetNumberOfCells();
-        // Count the cells of each type.
-        // This is used to ensure that cell data is copied at the correct
-        // locations in the output.
-        numVerts += ds->GetNumberOfVerts();
-        numLines += ds->GetNumberOfLines();
-        numPolys += ds->GetNumberOfPolys();
-        numStrips += ds->GetNumberOfStrips();
 
         inCD = ds->GetCellData();
         if ( countCD == 0 )
@@ -232,6 +297,8 @@ int vtkAppendPolyData::ExecuteAppend(vtkPolyData* output,
           {
           cellList.IntersectFieldList(inCD);
           }
+        info[idx].Input = ds;
+        info[idx].CellIndex = countCD;
         ++countCD;
         } // for a data set that has cells
       } // for a non NULL input
@@ -244,6 +311,16 @@ int vtkAppendPolyData::ExecuteAppend(vtkPolyData* output,
     }
   this->UpdateProgress(0.10);
 
+  // Output cell ids of the cells of each type start after all the cells of
+  // the preceding types.
+  for (idx = 0; idx < numInputs; ++idx)
+    {
+    info[idx].CellOffset[1] += numTypeCells[0];
+    info[idx].CellOffset[2] += numTypeCells[0] + numTypeCells[1];
+    info[idx].CellOffset[3] +=
+      numTypeCells[0] + numTypeCells[1] + numTypeCells[2];
+    }
+
   // Examine the points and check if they're the same type. If not,
   // use highest (double probably), otherwise the type of the first
   // array (float no doubt). Depends on defs in vtkSetGet.h - Warning.
@@ -272,26 +349,26 @@ int vtkAppendPolyData::ExecuteAppend(vtkPolyData* output,
       }
     }
 
-  // Allocate geometry/topology
+  // Allocate geometry/topology. All the cell arrays are allocated to their
+  // final size so that every input can write into its own range.
   newPts = vtkPoints::New(pointtype);
   newPts->SetNumberOfPoints(numPts);
 
-  newVerts = vtkCellArray::New();
-  newVerts->Allocate(numCells*4);
-
-  newLines = vtkCellArray::New();
-  newLines->Allocate(numCells*4);
-
-  newStrips = vtkCellArray::New();
-  newStrips->Allocate(numCells*4);
-
-  newPolys = vtkCellArray::New();
-  pPolys = newPolys->WritePointer(numPolys, sizePolys);
-
-  if (!pPolys && sizePolys > 0)
+  for (type = 0; type < 4; type++)
     {
-    vtkErrorMacro(<<"Memory allocation failed in append filter");
-    return 0;
+    newCells[type] = vtkCellArray::New();
+    newConn[type] = newCells[type]->WritePointer(numTypeCells[type],
+                                                 sizeTypeCells[type]);
+    if (!newConn[type] && sizeTypeCells[type] > 0)
+      {
+      vtkErrorMacro(<<"Memory allocation failed in append filter");
+      for (int j = 0; j <= type; j++)
+        {
+        newCells[j]->Delete();
+        }
+      newPts->Delete();
+      return 0;
+      }
     }
 
   // These are created manually for faster execution
@@ -368,164 +445,81 @@ int vtkAppendPolyData::ExecuteAppend(vtkPolyData* output,
       }
     }
 
-  // Allocate the point and cell data
+  // Allocate the point and cell data. The arrays are sized up front so
+  // that each input can be copied into its own range of tuples.
   outputPD->CopyAllocate(ptList,numPts);
   outputCD->CopyAllocate(cellList,numCells);
+  outputPD->SetNumberOfTuples(numPts);
+  outputCD->SetNumberOfTuples(numCells);
 
-  // loop over all input sets
-  vtkIdType ptOffset = 0;
-  vtkIdType vertOffset = 0;
-  vtkIdType linesOffset = 0;
-  vtkIdType polysOffset = 0;
-  vtkIdType stripsOffset = 0;
-  countPD = countCD = 0;
+  // Distribute the inputs over the threads so that each thread copies
+  // roughly the same amount of data.
+  vtkIdType totalWork = numPts;
+  for (type = 0; type < 4; type++)
+    {
+    totalWork += sizeTypeCells[type];
+    }
+  int numThreads = this->NumberOfThreads;
+  numThreads = (numThreads > numInputs ? numInputs : numThreads);
+  if ( vtkAppendPolyDataHasBitArrays(outputPD) ||
+       vtkAppendPolyDataHasBitArrays(outputCD) )
+    {
+    numThreads = 1; // bits of adjacent ranges share bytes
+    }
+  numThreads = (numThreads < 1 ? 1 : numThreads);
+
+  std::vector<int> firstInput(numThreads+1);
+  vtkIdType work = 0;
+  int thread = 1;
+  firstInput[0] = 0;
   for (idx = 0; idx < numInputs; ++idx)
     {
-    this->UpdateProgress(0.2 + 0.8*idx/numInputs);
-    ds = inputs[idx];
-    // this check is not necessary, but I'll put it in anyway
-    if (ds != NULL)
+    while ( thread < numThreads && work >= thread*totalWork/numThreads )
       {
-      numPts = ds->GetNumberOfPoints();
-      numCells = ds->GetNumberOfCells();
-      if ( numPts <= 0 && numCells <= 0 )
-        {
-        continue; //no input, just skip
-        }
-
-      inPD = ds->GetPointData();
-      inCD = ds->GetCellData();
-
-      inPts = ds->GetPoints();
-      inVerts = ds->GetVerts();
-      inLines = ds->GetLines();
-      inPolys = ds->GetPolys();
-      inStrips = ds->GetStrips();
-
-      if (ds->GetNumberOfPoints() > 0)
-        {
-        // copy points directly
-        if (AllSame)
-          {
-          this->AppendData(newPts->GetData(),
-                           inPts->GetData(), ptOffset);
-          }
-        else
-          {
-          this->AppendDifferentPoints(newPts->GetData(),
-                                      inPts->GetData(), ptOffset);
-          }
-        // copy scalars directly
-        if (newPtScalars)
-          {
-          this->AppendData(newPtScalars,inPD->GetScalars(), ptOffset);
-          }
-        // copy normals directly
-        if (newPtNormals)
-          {
-          this->AppendData(newPtNormals, inPD->GetNormals(), ptOffset);
-          }
-        // copy vectors directly
-        if (newPtVectors)
-          {
-          this->AppendData(newPtVectors, inPD->GetVectors(), ptOffset);
-          }
-        // copy tcoords directly
-        if (newPtTCoords)
-          {
-          this->AppendData(newPtTCoords, inPD->GetTCoords() , ptOffset);
-          }
-        // copy tensors directly
-        if (newPtTensors)
-          {
-          this->AppendData(newPtTensors, inPD->GetTensors(), ptOffset);
-          }
-        // append the remainder of the field data
-        for (ptId=0; ptId < numPts; ptId++)
-          {
-          outputPD->CopyData(ptList,inPD,countPD,ptId,ptId+ptOffset);
-          }
-        ++countPD;
-        }
-
-
-      if (ds->GetNumberOfCells() > 0)
+      firstInput[thread++] = idx;
+      }
+    if (info[idx].Input)
+      {
+      work += info[idx].Input->GetNumberOfPoints();
+      for (type = 0; type < 4; type++)
         {
-        // These are the cellIDs at which each of the cell types start.
-        vtkIdType linesIndex = ds->GetNumberOfVerts();
-        vtkIdType polysIndex = linesIndex + ds->GetNumberOfLines();
-        vtkIdType stripsIndex = polysIndex + ds->GetNumberOfPolys();
-
-        // cell data could be made efficient like the point data,
-        // but I will wait on that.
-        // copy cell data
-        for (cellId=0; cellId < numCells; cellId++)
-          {
-          vtkIdType outCellId = 0;
-          if (cellId < linesIndex)
-            {
-            outCellId = vertOffset;
-            vertOffset++;
-            }
-          else if (cellId < polysIndex)
-            {
-            // outCellId = number of lines we already added + total number of
-            // verts expected in the output.
-            outCellId = linesOffset + numVerts;
-            linesOffset++;
-            }
-          else if (cellId < stripsIndex)
-            {
-            // outCellId = number of polys we already added + total number of
-            // verts and lines expected in the output.
-            outCellId = polysOffset + numLines + numVerts;
-            polysOffset++;
-            }
-          else
-            {
-            // outCellId = number of tstrips we already added + total number of
-            // polys, verts and lines expected in the output.
-            outCellId = stripsOffset + numPolys + numLines + numVerts;
-            stripsOffset++;
-            }
-          outputCD->CopyData(cellList,inCD,countCD,cellId,outCellId);
-          }
-        ++countCD;
-
-        // copy the cells
-        pPolys = this->AppendCells(pPolys, inPolys, ptOffset);
-
-        // These other cell arrays could be made efficient like polys ...
-        for (inVerts->InitTraversal(); inVerts->GetNextCell(npts,pts); )
+        if (info[idx].Cells[type])
           {
-          newVerts->InsertNextCell(npts);
-          for (i=0; i < npts; i++)
-            {
-            newVerts->InsertCellPoint(pts[i]+ptOffset);
-            }
-          }
-
-        for (inLines->InitTraversal(); inLines->GetNextCell(npts,pts); )
-          {
-          newLines->InsertNextCell(npts);
-          for (i=0; i < npts; i++)
-            {
-            newLines->InsertCellPoint(pts[i]+ptOffset);
-            }
-          }
-
-        for (inStrips->InitTraversal(); inStrips->GetNextCell(npts,pts); )
-          {
-          newStrips->InsertNextCell(npts);
-          for (i=0; i < npts; i++)
-            {
-            newStrips->InsertCellPoint(pts[i]+ptOffset);
-            }
+          work += info[idx].Cells[type]->GetNumberOfConnectivityEntries();
           }
         }
-      ptOffset += numPts;
       }
     }
+  while ( thread <= numThreads )
+    {
+    firstInput[thread++] = numInputs;
+    }
+
+  // Copy the inputs
+  vtkAppendPolyDataThreadStruct str;
+  str.Filter = this;
+  str.Inputs = &info[0];
+  str.FirstInput = &firstInput[0];
+  str.Points = newPts;
+  str.AllSame = AllSame;
+  str.PointAttributes[0] = newPtScalars;
+  str.PointAttributes[1] = newPtVectors;
+  str.PointAttributes[2] = newPtNormals;
+  str.PointAttributes[3] = newPtTCoords;
+  str.PointAttributes[4] = newPtTensors;
+  str.OutputPD = outputPD;
+  str.OutputCD = outputCD;
+  str.PointList = &ptList;
+  str.CellList = &cellList;
+  for (type = 0; type < 4; type++)
+    {
+    str.Connectivity[type] = newConn[type];
+    }
+
+  this->Threader->SetNumberOfThreads(numThreads);
+  this->Threader->SetSingleMethod(vtkAppendPolyData::ThreadedAppend, &str);
+  this->Threader->SingleMethodExecute();
+  this->UpdateProgress(0.90);
 
   // Update ourselves and release memory
   //
@@ -558,29 +552,26 @@ int vtkAppendPolyData::ExecuteAppend(vtkPolyData* output,
     newPtTensors->Delete();
     }
 
-  if ( newVerts->GetNumberOfCells() > 0 )
+  if ( newCells[0]->GetNumberOfCells() > 0 )
     {
-    output->SetVerts(newVerts);
+    output->SetVerts(newCells[0]);
     }
-  newVerts->Delete();
-
-  if ( newLines->GetNumberOfCells() > 0 )
+  if ( newCells[1]->GetNumberOfCells() > 0 )
     {
-    output->SetLines(newLines);
+    output->SetLines(newCells[1]);
     }
-  newLines->Delete();
-
-  if ( newPolys->GetNumberOfCells() > 0 )
+  if ( newCells[2]->GetNumberOfCells() > 0 )
     {
-    output->SetPolys(newPolys);
+    output->SetPolys(newCells[2]);
     }
-  newPolys->Delete();
-
-  if ( newStrips->GetNumberOfCells() > 0 )
+  if ( newCells[3]->GetNumberOfCells() > 0 )
+    {
+    output->SetStrips(newCells[3]);
+    }
+  for (type = 0; type < 4; type++)
     {
-    output->SetStrips(newStrips);
+    newCells[type]->Delete();
     }
-  newStrips->Delete();
 
   // When all optimizations are complete, this squeeze will be unnecessary.
   // (But it does not seem to cost much.)
@@ -589,6 +580,88 @@ int vtkAppendPolyData::ExecuteAppend(vtkPolyData* output,
   return 1;
 }
 
+//----------------------------------------------------------------------------
+// Copy the points, cells and attributes of a range of inputs. Every input
+// is written into its own, preallocated, range of the output.
+VTK_THREAD_RETURN_TYPE vtkAppendPolyData::ThreadedAppend(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkAppendPolyDataThreadStruct *str =
+    static_cast<vtkAppendPolyDataThreadStruct *>(info->UserData);
+  vtkAppendPolyData *self = str->Filter;
+
+  int first = str->FirstInput[info->ThreadID];
+  int last = str->FirstInput[info->ThreadID+1];
+  for (int idx = first; idx < last; ++idx)
+    {
+    if ( self->GetAbortExecute() )
+      {
+      break;
+      }
+    if ( info->ThreadID == 0 )
+      {
+      self->UpdateProgress(0.10 + 0.80 * (idx - first) / (last - first));
+      }
+
+    vtkAppendPolyDataInput &in = str->Inputs[idx];
+    vtkPolyData *ds = in.Input;
+    if ( ds == NULL )
+      {
+      continue;
+      }
+
+    if ( in.PointIndex >= 0 )
+      {
+      vtkPointData *inPD = ds->GetPointData();
+
+      // copy points directly
+      if (str->AllSame)
+        {
+        self->AppendData(str->Points->GetData(),
+                         ds->GetPoints()->GetData(), in.PointOffset);
+        }
+      else
+        {
+        self->AppendDifferentPoints(str->Points->GetData(),
+                                    ds->GetPoints()->GetData(),
+                                    in.PointOffset);
+        }
+      // copy scalars, vectors, normals, tcoords and tensors directly
+      for (int i = 0; i < 5; i++)
+        {
+        if (str->PointAttributes[i])
+          {
+          self->AppendData(str->PointAttributes[i],
+            inPD->GetAttribute(vtkAppendPolyDataAttributeTypes[i]),
+            in.PointOffset);
+          }
+        }
+      // append the remainder of the field data
+      str->OutputPD->CopyData(*str->PointList, inPD, in.PointIndex,
+                              0, in.PointOffset, ds->GetNumberOfPoints());
+      }
+
+    if ( in.CellIndex >= 0 )
+      {
+      // copy the cells and cell data of each type
+      vtkIdType cellId = 0;
+      for (int type = 0; type < 4; type++)
+        {
+        vtkIdType n = in.Cells[type]->GetNumberOfCells();
+        str->OutputCD->CopyData(*str->CellList, ds->GetCellData(),
+                                in.CellIndex, cellId, in.CellOffset[type], n);
+        cellId += n;
+        self->AppendCells(str->Connectivity[type] +
+                          in.ConnectivityOffset[type],
+                          in.Cells[type], in.PointOffset);
+        }
+      }
+    }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
 //----------------------------------------------------------------------------
 // This method is much too long, and has to be broken up!
 // Append data sets into single polygonal data set.
@@ -690,6 +763,7 @@ void vtkAppendPolyData::PrintSelf(ostream& os, vtkIndent indent)
 
   os << "ParallelStreaming:" << (this->ParallelStreaming?"On":"Off") << endl;
   os << "UserManagedInputs:" << (this->UserManagedInputs?"On":"Off") << endl;
+  os << "NumberOfThreads:" << this->NumberOfThreads << endl;
 }
 
 //----------------------------------------------------------------------------
@@ -33,6 +33,7 @@
 
 class vtkCellArray;
 class vtkDataArray;
+class vtkMultiThreader;
 class vtkPoints;
 class vtkPolyData;
 
@@ -92,6 +93,15 @@ public:
   vtkGetMacro(ParallelStreaming, int);
   vtkBooleanMacro(ParallelStreaming, int);
 
+  // Description:
+  // Set/Get the number of threads used to copy the inputs into the output.
+  // The output is allocated up front and the inputs are distributed over
+  // the threads, each input being copied with bulk copies into its own
+  // range of the output. By default, the number of threads is set to the
+  // number of processors.
+  vtkSetClampMacro(NumberOfThreads, int, 1, VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads, int);
+
 //BTX
   int ExecuteAppend(vtkPolyData* output,
     vtkPolyData* inputs[], int numInputs);
@@ -117,6 +127,11 @@ protected:
   vtkIdType *AppendCells(vtkIdType *pDest, vtkCellArray *src,
                          vtkIdType offset);
 
+  // Used to copy the inputs concurrently
+  static VTK_THREAD_RETURN_TYPE ThreadedAppend(void *arg);
+  vtkMultiThreader *Threader;
+  int NumberOfThreads;
+
  private:
   // hide the superclass' AddInput() from the user and the compiler
   void AddInputData(vtkDataObject *)
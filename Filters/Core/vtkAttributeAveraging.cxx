@@ -0,0 +1,493 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    vtkAttributeAveraging.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkAttributeAveraging.h"
+
+#include "vtkAlgorithm.h"
+#include "vtkBitArray.h"
+#include "vtkDataArray.h"
+#include "vtkDataSet.h"
+#include "vtkIdList.h"
+#include "vtkIdTypeArray.h"
+#include "vtkMultiThreader.h"
+#include "vtkSmartPointer.h"
+
+#include <algorithm>
+#include <vector>
+
+// Inputs with fewer tuples per thread are processed by less threads
+#define VTK_ATTRIBUTE_AVERAGING_TUPLES_PER_THREAD 4096
+
+// The tuples are processed by tiles, between which the abort flag is checked
+// and the progress updated
+#define VTK_ATTRIBUTE_AVERAGING_TILE_SIZE 1024
+
+struct vtkAttributeAveragingThreadStruct
+{
+  // The numeric arrays averaged by the threads
+  std::vector<vtkDataArray *> From;
+  std::vector<vtkDataArray *> To;
+
+  // The lists of input tuples in compressed rows, or the dimensions of the
+  // points of a structured grid when Ids is NULL
+  const vtkIdType *Offsets;
+  const vtkIdType *Ids;
+  int Dimensions[3];
+  int CellsToPoints;
+
+  vtkIdType NumberOfTuples;
+  int NumberOfThreads;
+
+  // The filter checked for abort and reporting progress, if any
+  vtkAlgorithm *Filter;
+  double ProgressStart;
+};
+
+namespace
+{
+//----------------------------------------------------------------------------
+// Integer values are rounded, as in vtkDataArray::InterpolateTuple().
+template <class T>
+inline void vtkAttributeAveragingRound(double value, T *result)
+{
+  *result = static_cast<T>((value >= 0.0) ? (value + 0.5) : (value - 0.5));
+}
+
+inline void vtkAttributeAveragingRound(double value, float *result)
+{
+  *result = static_cast<float>(value);
+}
+
+inline void vtkAttributeAveragingRound(double value, double *result)
+{
+  *result = value;
+}
+
+//----------------------------------------------------------------------------
+// The cells using a point, in the order of vtkStructuredData::GetPointCells(),
+// or the points of a cell, in the order of vtkStructuredData::GetCellPoints().
+// Returns their number.
+int vtkAttributeAveragingStencil(vtkAttributeAveragingThreadStruct *str,
+                                 vtkIdType id, vtkIdType ids[8])
+{
+  static const int offset[8][3] = {{-1,0,0}, {-1,-1,0}, {-1,-1,-1},
+                                   {-1,0,-1}, {0,0,0}, {0,-1,0}, {0,-1,-1},
+                                   {0,0,-1}};
+  const int *dims = str->Dimensions;
+  vtkIdType cellDims[3];
+  for (int i = 0; i < 3; ++i)
+    {
+    cellDims[i] = (dims[i] > 1) ? dims[i] - 1 : 1;
+    }
+
+  int n = 0;
+  if (str->CellsToPoints)
+    {
+    vtkIdType loc[3];
+    loc[0] = id % dims[0];
+    loc[1] = (id / dims[0]) % dims[1];
+    loc[2] = id / (static_cast<vtkIdType>(dims[0]) * dims[1]);
+    for (int j = 0; j < 8; ++j)
+      {
+      vtkIdType cellLoc[3];
+      int i;
+      for (i = 0; i < 3; ++i)
+        {
+        cellLoc[i] = loc[i] + offset[j][i];
+        if (cellLoc[i] < 0 || cellLoc[i] >= cellDims[i])
+          {
+          break;
+          }
+        }
+      if (i == 3)
+        {
+        ids[n++] = cellLoc[0] + cellLoc[1] * cellDims[0] +
+          cellLoc[2] * cellDims[0] * cellDims[1];
+        }
+      }
+    }
+  else
+    {
+    vtkIdType loc[3], max[3];
+    loc[0] = id % cellDims[0];
+    loc[1] = (id / cellDims[0]) % cellDims[1];
+    loc[2] = id / (cellDims[0] * cellDims[1]);
+    for (int i = 0; i < 3; ++i)
+      {
+      max[i] = (dims[i] > 1) ? loc[i] + 1 : loc[i];
+      }
+    vtkIdType d01 = static_cast<vtkIdType>(dims[0]) * dims[1];
+    for (vtkIdType k = loc[2]; k <= max[2]; ++k)
+      {
+      for (vtkIdType j = loc[1]; j <= max[1]; ++j)
+        {
+        for (vtkIdType i = loc[0]; i <= max[0]; ++i)
+          {
+          ids[n++] = i + j * dims[0] + k * d01;
+          }
+        }
+      }
+    }
+  return n;
+}
+
+//----------------------------------------------------------------------------
+// Average the tuples of an array in the range [begin, end[, summing the
+// weighted components in the order of vtkDataArray::InterpolateTuple() so
+// that the results do not depend on the path taken.
+template <class T>
+void vtkAttributeAveragingExecute(vtkAttributeAveragingThreadStruct *str,
+                                  const T *from, T *to, int numComp,
+                                  vtkIdType begin, vtkIdType end)
+{
+  vtkIdType stencil[8];
+  const vtkIdType *ids;
+  vtkIdType numIds;
+  to += begin * numComp;
+  for (vtkIdType id = begin; id < end; ++id)
+    {
+    if (str->Ids)
+      {
+      ids = str->Ids + str->Offsets[id];
+      numIds = str->Offsets[id + 1] - str->Offsets[id];
+      }
+    else
+      {
+      numIds = vtkAttributeAveragingStencil(str, id, stencil);
+      ids = stencil;
+      }
+
+    if (numIds == 0)
+      {
+      for (int c = 0; c < numComp; ++c)
+        {
+        *to++ = static_cast<T>(0);
+        }
+      continue;
+      }
+
+    double weight = 1.0 / numIds;
+    for (int c = 0; c < numComp; ++c)
+      {
+      double value = 0.0;
+      for (vtkIdType j = 0; j < numIds; ++j)
+        {
+        value += weight * static_cast<double>(from[ids[j] * numComp + c]);
+        }
+      vtkAttributeAveragingRound(value, to++);
+      }
+    }
+}
+
+} // end anonymous namespace
+
+//----------------------------------------------------------------------------
+// Each thread averages a contiguous range of tuples of every array, tile by
+// tile. Thread 0 reports the progress.
+static VTK_THREAD_RETURN_TYPE vtkAttributeAveragingThreadedExecute(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkAttributeAveragingThreadStruct *str =
+    static_cast<vtkAttributeAveragingThreadStruct *>(info->UserData);
+
+  vtkIdType begin = str->NumberOfTuples * info->ThreadID /
+    str->NumberOfThreads;
+  vtkIdType end = str->NumberOfTuples * (info->ThreadID + 1) /
+    str->NumberOfThreads;
+  for (vtkIdType tileBegin = begin; tileBegin < end;
+       tileBegin += VTK_ATTRIBUTE_AVERAGING_TILE_SIZE)
+    {
+    if (str->Filter && str->Filter->GetAbortExecute())
+      {
+      break;
+      }
+    vtkIdType tileEnd = tileBegin + VTK_ATTRIBUTE_AVERAGING_TILE_SIZE;
+    if (tileEnd > end)
+      {
+      tileEnd = end;
+      }
+    for (size_t a = 0; a < str->From.size(); ++a)
+      {
+      vtkDataArray *from = str->From[a];
+      vtkDataArray *to = str->To[a];
+      switch (from->GetDataType())
+        {
+        vtkTemplateMacro(
+          vtkAttributeAveragingExecute(str,
+            static_cast<const VTK_TT *>(from->GetVoidPointer(0)),
+            static_cast<VTK_TT *>(to->GetVoidPointer(0)),
+            from->GetNumberOfComponents(), tileBegin, tileEnd));
+        }
+      }
+    if (str->Filter && info->ThreadID == 0)
+      {
+      str->Filter->UpdateProgress(str->ProgressStart +
+        (1.0 - str->ProgressStart) * (tileEnd - begin) / (end - begin));
+      }
+    }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+// Average the numeric arrays with the threads, and interpolate the other
+// arrays tuple by tuple.
+static void vtkAttributeAveragingFields(vtkAttributeAveragingThreadStruct *str,
+                                        vtkDataSetAttributes *fromData,
+                                        vtkDataSetAttributes *toData,
+                                        vtkDataSetAttributes::FieldList &list,
+                                        vtkMultiThreader *threader,
+                                        int numThreads)
+{
+  std::vector<vtkAbstractArray *> otherFrom;
+  std::vector<vtkAbstractArray *> otherTo;
+  for (int i = 0; i < list.GetNumberOfFields(); ++i)
+    {
+    int fromIdx = list.GetDSAIndex(0, i);
+    int toIdx = list.GetFieldIndex(i);
+    if (fromIdx < 0 || toIdx < 0)
+      {
+      continue;
+      }
+    vtkAbstractArray *from = fromData->GetAbstractArray(fromIdx);
+    vtkAbstractArray *to = toData->GetAbstractArray(toIdx);
+    if (!from || !to)
+      {
+      continue;
+      }
+    to->SetNumberOfTuples(str->NumberOfTuples);
+
+    vtkDataArray *fromArray = vtkDataArray::SafeDownCast(from);
+    vtkDataArray *toArray = vtkDataArray::SafeDownCast(to);
+    if (fromArray && toArray && !vtkBitArray::SafeDownCast(fromArray) &&
+        fromArray->GetDataType() == toArray->GetDataType() &&
+        fromArray->GetNumberOfComponents() ==
+        toArray->GetNumberOfComponents())
+      {
+      str->From.push_back(fromArray);
+      str->To.push_back(toArray);
+      }
+    else
+      {
+      otherFrom.push_back(from);
+      otherTo.push_back(to);
+      }
+    }
+
+  if (!str->From.empty() && str->NumberOfTuples > 0)
+    {
+    vtkIdType maxThreads =
+      str->NumberOfTuples / VTK_ATTRIBUTE_AVERAGING_TUPLES_PER_THREAD + 1;
+    if (numThreads > maxThreads)
+      {
+      numThreads = static_cast<int>(maxThreads);
+      }
+    if (!threader || numThreads <= 1)
+      {
+      str->NumberOfThreads = 1;
+      vtkMultiThreader::ThreadInfo info;
+      info.ThreadID = 0;
+      info.NumberOfThreads = 1;
+      info.UserData = str;
+      vtkAttributeAveragingThreadedExecute(&info);
+      }
+    else
+      {
+      str->NumberOfThreads = numThreads;
+      threader->SetNumberOfThreads(numThreads);
+      threader->SetSingleMethod(vtkAttributeAveragingThreadedExecute, str);
+      threader->SingleMethodExecute();
+      }
+    }
+
+  if (otherFrom.empty())
+    {
+    return;
+    }
+  vtkSmartPointer<vtkIdList> idList = vtkSmartPointer<vtkIdList>::New();
+  std::vector<double> weights;
+  std::vector<double> zeros;
+  vtkIdType stencil[8];
+  for (vtkIdType id = 0; id < str->NumberOfTuples; ++id)
+    {
+    if (str->Filter && id % VTK_ATTRIBUTE_AVERAGING_TILE_SIZE == 0 &&
+        str->Filter->GetAbortExecute())
+      {
+      break;
+      }
+    const vtkIdType *ids;
+    vtkIdType numIds;
+    if (str->Ids)
+      {
+      ids = str->Ids + str->Offsets[id];
+      numIds = str->Offsets[id + 1] - str->Offsets[id];
+      }
+    else
+      {
+      numIds = vtkAttributeAveragingStencil(str, id, stencil);
+      ids = stencil;
+      }
+    idList->SetNumberOfIds(numIds);
+    weights.assign(numIds > 0 ? numIds : 1, numIds > 0 ? 1.0 / numIds : 0.0);
+    for (vtkIdType j = 0; j < numIds; ++j)
+      {
+      idList->SetId(j, ids[j]);
+      }
+
+    for (size_t a = 0; a < otherFrom.size(); ++a)
+      {
+      if (numIds > 0)
+        {
+        otherTo[a]->InterpolateTuple(id, idList, otherFrom[a], &weights[0]);
+        }
+      else if (vtkDataArray *toArray = vtkDataArray::SafeDownCast(otherTo[a]))
+        {
+        zeros.assign(toArray->GetNumberOfComponents(), 0.0);
+        toArray->SetTuple(id, &zeros[0]);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkAttributeAveraging::BuildCellPoints(vtkDataSet *input,
+                                            vtkIdTypeArray *offsets,
+                                            vtkIdTypeArray *ids)
+{
+  vtkIdType numCells = input->GetNumberOfCells();
+  offsets->SetNumberOfComponents(1);
+  offsets->SetNumberOfTuples(numCells + 1);
+  ids->SetNumberOfComponents(1);
+  ids->Reset();
+
+  vtkSmartPointer<vtkIdList> cellPts = vtkSmartPointer<vtkIdList>::New();
+  vtkIdType *offset = offsets->GetPointer(0);
+  offset[0] = 0;
+  for (vtkIdType cellId = 0; cellId < numCells; ++cellId)
+    {
+    input->GetCellPoints(cellId, cellPts);
+    vtkIdType numPts = cellPts->GetNumberOfIds();
+    for (vtkIdType i = 0; i < numPts; ++i)
+      {
+      ids->InsertNextValue(cellPts->GetId(i));
+      }
+    offset[cellId + 1] = offset[cellId] + numPts;
+    }
+}
+
+//----------------------------------------------------------------------------
+// The lists of points of the cells are transposed, a point used twice by a
+// cell appearing twice as in vtkCellLinks.
+void vtkAttributeAveraging::BuildPointCells(vtkDataSet *input,
+                                            vtkIdTypeArray *offsets,
+                                            vtkIdTypeArray *ids)
+{
+  vtkIdType numPts = input->GetNumberOfPoints();
+  vtkIdType numCells = input->GetNumberOfCells();
+  vtkSmartPointer<vtkIdTypeArray> cellOffsets =
+    vtkSmartPointer<vtkIdTypeArray>::New();
+  vtkSmartPointer<vtkIdTypeArray> cellPts =
+    vtkSmartPointer<vtkIdTypeArray>::New();
+  vtkAttributeAveraging::BuildCellPoints(input, cellOffsets, cellPts);
+  const vtkIdType *cellOffset = cellOffsets->GetPointer(0);
+  const vtkIdType *cellPt = cellPts->GetPointer(0);
+  vtkIdType size = cellOffset[numCells];
+
+  offsets->SetNumberOfComponents(1);
+  offsets->SetNumberOfTuples(numPts + 1);
+  vtkIdType *offset = offsets->GetPointer(0);
+  std::fill(offset, offset + numPts + 1, 0);
+  for (vtkIdType i = 0; i < size; ++i)
+    {
+    offset[cellPt[i] + 1]++;
+    }
+  for (vtkIdType ptId = 0; ptId < numPts; ++ptId)
+    {
+    offset[ptId + 1] += offset[ptId];
+    }
+
+  ids->SetNumberOfComponents(1);
+  ids->SetNumberOfTuples(size);
+  vtkIdType *id = ids->GetPointer(0);
+  std::vector<vtkIdType> next(offset, offset + numPts);
+  for (vtkIdType cellId = 0; cellId < numCells; ++cellId)
+    {
+    for (vtkIdType i = cellOffset[cellId]; i < cellOffset[cellId + 1]; ++i)
+      {
+      id[next[cellPt[i]]++] = cellId;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkAttributeAveraging::Average(vtkDataSetAttributes *fromData,
+                                    vtkDataSetAttributes *toData,
+                                    vtkDataSetAttributes::FieldList &list,
+                                    vtkIdType numTuples,
+                                    vtkIdTypeArray *offsets,
+                                    vtkIdTypeArray *ids,
+                                    vtkMultiThreader *threader,
+                                    int numThreads, vtkAlgorithm *filter)
+{
+  vtkAttributeAveragingThreadStruct str;
+  str.Offsets = offsets->GetPointer(0);
+  str.Ids = ids->GetPointer(0);
+  str.Dimensions[0] = str.Dimensions[1] = str.Dimensions[2] = 0;
+  str.CellsToPoints = 0;
+  str.NumberOfTuples = numTuples;
+  str.NumberOfThreads = 1;
+  str.Filter = filter;
+  str.ProgressStart = filter ? filter->GetProgress() : 0.0;
+
+  // An empty list of ids still marks the compressed rows
+  static const vtkIdType noIds = 0;
+  if (!str.Ids)
+    {
+    str.Ids = &noIds;
+    }
+  vtkAttributeAveragingFields(&str, fromData, toData, list, threader,
+                              numThreads);
+}
+
+//----------------------------------------------------------------------------
+void vtkAttributeAveraging::AverageStructured(
+  vtkDataSetAttributes *fromData, vtkDataSetAttributes *toData,
+  vtkDataSetAttributes::FieldList &list, int dims[3], int cellsToPoints,
+  vtkMultiThreader *threader, int numThreads, vtkAlgorithm *filter)
+{
+  vtkAttributeAveragingThreadStruct str;
+  str.Offsets = NULL;
+  str.Ids = NULL;
+  str.CellsToPoints = cellsToPoints;
+  str.NumberOfTuples = 1;
+  str.NumberOfThreads = 1;
+  str.Filter = filter;
+  str.ProgressStart = filter ? filter->GetProgress() : 0.0;
+  for (int i = 0; i < 3; ++i)
+    {
+    str.Dimensions[i] = dims[i];
+    if (dims[i] < 1)
+      {
+      str.NumberOfTuples = 0;
+      }
+    else
+      {
+      str.NumberOfTuples *= (cellsToPoints || dims[i] == 1) ?
+        dims[i] : dims[i] - 1;
+      }
+    }
+  vtkAttributeAveragingFields(&str, fromData, toData, list, threader,
+                              numThreads);
+}
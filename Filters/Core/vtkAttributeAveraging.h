@@ -0,0 +1,86 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    vtkAttributeAveraging.h
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// .NAME vtkAttributeAveraging - average point data into cell data, and back
+// .SECTION Description
+// vtkAttributeAveraging is a small utility class used by
+// vtkCellDataToPointData and vtkPointDataToCellData. Every output tuple is
+// the average of a list of input tuples: the cells using a point, or the
+// points of a cell. The lists are either stored once for all the arrays in
+// compressed rows (the ids of the list of tuple i are ids[offsets[i]] to
+// ids[offsets[i+1]-1]), or follow from the dimensions of a structured
+// grid.
+//
+// The numeric arrays are averaged in double precision by type specific
+// loops, over contiguous ranges of tuples split among the threads of a
+// vtkMultiThreader; integer values are rounded as by
+// vtkDataArray::InterpolateTuple(). The other arrays are interpolated one
+// tuple at a time. The tuples with an empty list are set to 0.
+//
+// When given the filter calling it, the averaging stops as soon as the
+// AbortExecute flag of the filter is set, and updates the progress of the
+// filter from its current value to 1.
+// .SECTION See Also
+// vtkCellDataToPointData vtkPointDataToCellData
+
+#ifndef __vtkAttributeAveraging_h
+#define __vtkAttributeAveraging_h
+
+#include "vtkDataSetAttributes.h" // for FieldList
+
+class vtkAlgorithm;
+class vtkDataSet;
+class vtkIdTypeArray;
+class vtkMultiThreader;
+
+class vtkAttributeAveraging
+{
+public:
+  // Description:
+  // Fill offsets and ids with the cells using each point of the input, in
+  // the order of vtkDataSet::GetPointCells().
+  static void BuildPointCells(vtkDataSet *input, vtkIdTypeArray *offsets,
+                              vtkIdTypeArray *ids);
+
+  // Description:
+  // Fill offsets and ids with the points of each cell of the input, in the
+  // order of vtkDataSet::GetCellPoints().
+  static void BuildCellPoints(vtkDataSet *input, vtkIdTypeArray *offsets,
+                              vtkIdTypeArray *ids);
+
+  // Description:
+  // Average the arrays of fromData into numTuples tuples of the arrays of
+  // toData, allocated by toData->InterpolateAllocate(list, ...) from a list
+  // initialized with fromData only.
+  static void Average(vtkDataSetAttributes *fromData,
+                      vtkDataSetAttributes *toData,
+                      vtkDataSetAttributes::FieldList &list,
+                      vtkIdType numTuples, vtkIdTypeArray *offsets,
+                      vtkIdTypeArray *ids, vtkMultiThreader *threader,
+                      int numThreads, vtkAlgorithm *filter = NULL);
+
+  // Description:
+  // Same as above, for a structured grid of the given point dimensions:
+  // average the cell data over the cells using each point if cellsToPoints
+  // is on, the point data over the points of each cell otherwise.
+  static void AverageStructured(vtkDataSetAttributes *fromData,
+                                vtkDataSetAttributes *toData,
+                                vtkDataSetAttributes::FieldList &list,
+                                int dims[3], int cellsToPoints,
+                                vtkMultiThreader *threader, int numThreads,
+                                vtkAlgorithm *filter = NULL);
+};
+
+#endif
+// VTK-HeaderTest-Exclude: vtkAttributeAveraging.h
@@ -19,6 +19,12 @@
 // points). The method of transformation is based on averaging the data
 // values of all cells using a particular point. Optionally, the input cell
 // data can be passed through to the output as well.
+//
+// The cells using each point are found once for all the arrays: from the
+// dimensions of image data, rectilinear and structured grids, and from a
+// compact map built from the cells of the other datasets. The numeric arrays
+// are then averaged by NumberOfThreads threads, and the result does not
+// depend on their number.
 
 // .SECTION Caveats
 // This filter is an abstract filter, that is, the output is an abstract type
@@ -37,6 +43,7 @@
 #include "vtkDataSetAlgorithm.h"
 
 class vtkDataSet;
+class vtkMultiThreader;
 
 class VTKFILTERSCORE_EXPORT vtkCellDataToPointData : public vtkDataSetAlgorithm
 {
@@ -53,19 +60,28 @@ public:
   vtkGetMacro(PassCellData,int);
   vtkBooleanMacro(PassCellData,int);
 
+  // Description:
+  // Get/Set the number of threads averaging the cell data. It defaults to
+  // the number of threads of vtkMultiThreader.
+  vtkSetClampMacro(NumberOfThreads, int, 1, VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads, int);
+
 protected:
   vtkCellDataToPointData();
-  ~vtkCellDataToPointData() {};
+  ~vtkCellDataToPointData();
 
   virtual int RequestData(vtkInformation* request,
                           vtkInformationVector** inputVector,
                           vtkInformationVector* outputVector);
 
-  // Special traversal algorithm for unstructured grid
+  // Unstructured grids used to take a special path, they are now handled
+  // by RequestData() like the other datasets.
   int RequestDataForUnstructuredGrid
     (vtkInformation*, vtkInformationVector**, vtkInformationVector*);
 
   int PassCellData;
+  int NumberOfThreads;
+  vtkMultiThreader *Threader;
 private:
   vtkCellDataToPointData(const vtkCellDataToPointData&);  // Not implemented.
   void operator=(const vtkCellDataToPointData&);  // Not implemented.
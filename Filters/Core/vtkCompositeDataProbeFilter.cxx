@@ -27,6 +27,8 @@
 #include "vtkPointData.h"
 #include "vtkSmartPointer.h"
 
+#include <vector>
+
 vtkStandardNewMacro(vtkCompositeDataProbeFilter);
 //----------------------------------------------------------------------------
 vtkCompositeDataProbeFilter::vtkCompositeDataProbeFilter()
@@ -108,7 +110,7 @@ int vtkCompositeDataProbeFilter::RequestData(
   iter.TakeReference(sourceComposite->NewIterator());
   // We do reverse traversal, so that for hierarchical datasets, we traverse the
   // higher resolution blocks first.
-  int idx=0;
+  std::vector<vtkDataSet*> sources;
   for (iter->InitReverseTraversal(); !iter->IsDoneWithTraversal(); iter->GoToNextItem())
     {
     sourceDS = vtkDataSet::SafeDownCast(iter->GetCurrentDataObject());
@@ -122,13 +124,16 @@ int vtkCompositeDataProbeFilter::RequestData(
       {
       continue;
       }
+    sources.push_back(sourceDS);
+    }
 
-    if (idx==0)
-      {
-      this->InitializeForProbing(input, output);
-      }
-    this->ProbeEmptyPoints(input, idx, sourceDS, output);
-    idx++;
+  // All the blocks are probed at once: each point only visits the blocks
+  // whose bounds contain it, and takes the values of the first that does.
+  if (!sources.empty())
+    {
+    this->InitializeForProbing(input, output);
+    this->ProbeEmptyPoints(input, 0, &sources[0],
+                           static_cast<int>(sources.size()), output);
     }
 
   return 1;
@@ -16,10 +16,12 @@
 // composite datasets in the input.
 // .SECTION Description
 // vtkCompositeDataProbeFilter supports probing into multi-group datasets.
-// It sequentially probes through each concrete dataset within the composite
-// probing at only those locations at which there were no hits when probing
-// earlier datasets. For Hierarchical datasets, this traversal through leaf
-// datasets is done in reverse order of levels i.e. highest level first.
+// It probes all the concrete datasets within the composite at once: each
+// location is only searched in the datasets whose bounds contain it, and
+// takes the values of the first of them in which it is found. For
+// Hierarchical datasets, the leaf datasets are ordered in reverse order of
+// levels i.e. highest level first. The locations are probed by several
+// threads, as in vtkProbeFilter.
 //
 // When dealing with composite datasets, partial arrays are common i.e.
 // data-arrays that are not available in all of the blocks. By default, this
@@ -0,0 +1,261 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    vtkConnectedCellLabeling.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkConnectedCellLabeling.h"
+
+#include "vtkCell.h"
+#include "vtkIdList.h"
+#include "vtkIdTypeArray.h"
+#include "vtkMultiThreader.h"
+#include "vtkPolyData.h"
+#include "vtkUnstructuredGrid.h"
+
+#include <vector>
+
+namespace
+{
+// The forests below keep the smallest id of a set as its root, so that
+// parent[x] <= x always holds. Unused entries are -1.
+inline vtkIdType vtkFindRoot(vtkIdType *parent, vtkIdType x)
+{
+  while ( parent[x] != x )
+    {
+    parent[x] = parent[parent[x]]; //path halving
+    x = parent[x];
+    }
+  return x;
+}
+
+inline void vtkMergeSets(vtkIdType *parent, vtkIdType a, vtkIdType b)
+{
+  if ( parent[a] < 0 )
+    {
+    parent[a] = a;
+    }
+  if ( parent[b] < 0 )
+    {
+    parent[b] = b;
+    }
+  a = vtkFindRoot(parent, a);
+  b = vtkFindRoot(parent, b);
+  if ( a < b )
+    {
+    parent[b] = a;
+    }
+  else if ( b < a )
+    {
+    parent[a] = b;
+    }
+}
+
+struct vtkConnectedCellLabelingThreadStruct
+{
+  vtkDataSet *Input;
+  vtkIdType NumberOfCells;
+  int NumberOfThreads;
+  vtkIdType *FirstPoints;
+  std::vector<vtkIdType> *Forests;
+  vtkIdType *Offsets;
+};
+}
+
+//----------------------------------------------------------------------------
+// Merge the points of a range of cells into a private forest spanning the
+// point ids used by these cells. The first point of each cell is recorded
+// so that the cells can be labeled once all the forests are merged.
+static VTK_THREAD_RETURN_TYPE vtkConnectedCellLabelingExecute(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkConnectedCellLabelingThreadStruct *str =
+    static_cast<vtkConnectedCellLabelingThreadStruct *>(info->UserData);
+
+  int thread = info->ThreadID;
+  vtkIdType begin = str->NumberOfCells * thread / str->NumberOfThreads;
+  vtkIdType end = str->NumberOfCells * (thread+1) / str->NumberOfThreads;
+  vtkIdType cellId, i, npts, minId = VTK_LARGE_ID, maxId = -1;
+
+  vtkIdList *ptIds = vtkIdList::New();
+  ptIds->Allocate(VTK_CELL_SIZE);
+
+  // Range of point ids used by this range of cells. Meshes usually number
+  // neighboring cells and points alike, so the range is small.
+  for ( cellId=begin; cellId < end; cellId++ )
+    {
+    str->Input->GetCellPoints(cellId, ptIds);
+    npts = ptIds->GetNumberOfIds();
+    for ( i=0; i < npts; i++ )
+      {
+      minId = ( ptIds->GetId(i) < minId ? ptIds->GetId(i) : minId );
+      maxId = ( ptIds->GetId(i) > maxId ? ptIds->GetId(i) : maxId );
+      }
+    }
+
+  std::vector<vtkIdType> &forest = str->Forests[thread];
+  if ( maxId < 0 )
+    {
+    minId = 0;
+    }
+  forest.assign(maxId - minId + 1, -1);
+  str->Offsets[thread] = minId;
+
+  for ( cellId=begin; cellId < end; cellId++ )
+    {
+    str->Input->GetCellPoints(cellId, ptIds);
+    npts = ptIds->GetNumberOfIds();
+    if ( npts < 1 )
+      {
+      str->FirstPoints[cellId] = -1;
+      continue;
+      }
+    str->FirstPoints[cellId] = ptIds->GetId(0);
+    vtkIdType *parent = &forest[0];
+    vtkIdType first = ptIds->GetId(0) - minId;
+    if ( parent[first] < 0 )
+      {
+      parent[first] = first;
+      }
+    for ( i=1; i < npts; i++ )
+      {
+      vtkMergeSets(parent, first, ptIds->GetId(i) - minId);
+      }
+    }
+
+  ptIds->Delete();
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkConnectedCellLabeling::Label(vtkDataSet *input,
+                                          vtkMultiThreader *threader,
+                                          int numThreads,
+                                          vtkIdType *cellRegions,
+                                          vtkIdType *pointRegions,
+                                          vtkIdTypeArray *regionSizes)
+{
+  vtkIdType numCells = input->GetNumberOfCells();
+  vtkIdType numPts = input->GetNumberOfPoints();
+  vtkIdType cellId, ptId;
+  int thread;
+
+  regionSizes->Reset();
+  for ( ptId=0; ptId < numPts; ptId++ )
+    {
+    pointRegions[ptId] = -1;
+    }
+  if ( numCells < 1 )
+    {
+    return 0;
+    }
+
+  // Other datasets update cached information (e.g., their dimensions) when
+  // asked for the points of a cell.
+  if ( !vtkUnstructuredGrid::SafeDownCast(input) &&
+       !vtkPolyData::SafeDownCast(input) )
+    {
+    numThreads = 1;
+    }
+  numThreads = ( numThreads > numCells ? static_cast<int>(numCells) :
+                 numThreads );
+  numThreads = ( numThreads < 1 ? 1 : numThreads );
+
+  // Make sure that lazily built cell structures exist before the threads
+  // start querying the cells.
+  vtkIdList *ptIds = vtkIdList::New();
+  input->GetCellPoints(0, ptIds);
+  ptIds->Delete();
+
+  std::vector<std::vector<vtkIdType> > forests(numThreads);
+  std::vector<vtkIdType> offsets(numThreads);
+
+  vtkConnectedCellLabelingThreadStruct str;
+  str.Input = input;
+  str.NumberOfCells = numCells;
+  str.NumberOfThreads = numThreads;
+  str.FirstPoints = cellRegions;
+  str.Forests = &forests[0];
+  str.Offsets = &offsets[0];
+
+  threader->SetNumberOfThreads(numThreads);
+  threader->SetSingleMethod(vtkConnectedCellLabelingExecute, &str);
+  threader->SingleMethodExecute();
+
+  // Merge the forests of the threads into a single one over all points.
+  std::vector<vtkIdType> parents(numPts, -1);
+  vtkIdType *parent = &parents[0];
+  for ( thread=0; thread < numThreads; thread++ )
+    {
+    std::vector<vtkIdType> &forest = forests[thread];
+    vtkIdType size = static_cast<vtkIdType>(forest.size());
+    vtkIdType offset = offsets[thread];
+    for ( vtkIdType i=0; i < size; i++ )
+      {
+      if ( forest[i] >= 0 )
+        {
+        vtkMergeSets(parent, offset + i,
+                     offset + vtkFindRoot(&forest[0], i));
+        }
+      }
+    std::vector<vtkIdType>().swap(forest);
+    }
+
+  // Point every point directly at its root. Since roots are the smallest
+  // ids of their sets, a single ascending pass is enough.
+  for ( ptId=0; ptId < numPts; ptId++ )
+    {
+    if ( parent[ptId] >= 0 )
+      {
+      parent[ptId] = parent[parent[ptId]];
+      }
+    }
+
+  // Number the regions in the order of their first cell, and count their
+  // cells. The region id of a set is kept at its root.
+  std::vector<vtkIdType> sizes;
+  vtkIdType numRegions = 0;
+  for ( cellId=0; cellId < numCells; cellId++ )
+    {
+    vtkIdType first = cellRegions[cellId];
+    if ( first < 0 ) //a cell without points is a region on its own
+      {
+      cellRegions[cellId] = numRegions++;
+      sizes.push_back(1);
+      continue;
+      }
+    vtkIdType root = parent[first];
+    if ( pointRegions[root] < 0 )
+      {
+      pointRegions[root] = numRegions++;
+      sizes.push_back(0);
+      }
+    cellRegions[cellId] = pointRegions[root];
+    sizes[pointRegions[root]]++;
+    }
+
+  for ( ptId=0; ptId < numPts; ptId++ )
+    {
+    if ( parent[ptId] >= 0 )
+      {
+      pointRegions[ptId] = pointRegions[parent[ptId]];
+      }
+    }
+
+  regionSizes->SetNumberOfValues(numRegions);
+  for ( vtkIdType regionId=0; regionId < numRegions; regionId++ )
+    {
+    regionSizes->SetValue(regionId, sizes[regionId]);
+    }
+
+  return numRegions;
+}
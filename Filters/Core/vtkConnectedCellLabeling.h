@@ -0,0 +1,59 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    vtkConnectedCellLabeling.h
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// .NAME vtkConnectedCellLabeling - label connected regions with union-find
+// .SECTION Description
+// vtkConnectedCellLabeling is a small utility class used by the
+// connectivity filters (vtkConnectivityFilter and
+// vtkPolyDataConnectivityFilter) to label all the connected regions of a
+// dataset at once. Two cells are connected when they share a point. Rather
+// than growing each region with a wave front over the point-to-cell links,
+// the points of every cell are merged into disjoint sets (union-find), so
+// no cell links are needed.
+//
+// The cells are split into contiguous ranges, one per thread. Each thread
+// merges the points of its cells into a private forest that only spans the
+// point ids its cells use; the forests are then merged into a single one.
+// Regions are numbered in the order of their lowest cell id, which is the
+// numbering of the wave front traversal.
+// .SECTION See Also
+// vtkConnectivityFilter vtkPolyDataConnectivityFilter
+
+#ifndef __vtkConnectedCellLabeling_h
+#define __vtkConnectedCellLabeling_h
+
+#include "vtkType.h" //for vtkIdType
+
+class vtkDataSet;
+class vtkIdTypeArray;
+class vtkMultiThreader;
+
+class vtkConnectedCellLabeling
+{
+public:
+  // Description:
+  // Label the connected regions of the cells of the input. On return,
+  // cellRegions[0...numCells-1] holds the region id of each cell and
+  // pointRegions[0...numPts-1] the region id of each point (-1 for points
+  // not used by any cell). The size (in cells) of each region is stored in
+  // regionSizes. Threads are only used with vtkUnstructuredGrid and
+  // vtkPolyData inputs, whose cell point queries do not modify the
+  // dataset once the cells are built. Returns the number of regions.
+  static vtkIdType Label(vtkDataSet *input, vtkMultiThreader *threader,
+                         int numThreads, vtkIdType *cellRegions,
+                         vtkIdType *pointRegions, vtkIdTypeArray *regionSizes);
+};
+
+#endif
+// VTK-HeaderTest-Exclude: vtkConnectedCellLabeling.h
@@ -16,12 +16,14 @@
 
 #include "vtkCell.h"
 #include "vtkCellData.h"
+#include "vtkConnectedCellLabeling.h"
 #include "vtkDataSet.h"
 #include "vtkFloatArray.h"
 #include "vtkIdList.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkMath.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
 #include "vtkPointData.h"
@@ -55,6 +57,9 @@ vtkConnectivityFilter::vtkConnectivityFilter()
 
   this->NewScalars = 0;
   this->NewCellScalars = 0;
+
+  this->Threader = vtkMultiThreader::New();
+  this->NumberOfThreads = this->Threader->GetNumberOfThreads();
 }
 
 vtkConnectivityFilter::~vtkConnectivityFilter()
@@ -64,6 +69,7 @@ vtkConnectivityFilter::~vtkConnectivityFilter()
   this->NeighborCellPointIds->Delete();
   this->Seeds->Delete();
   this->SpecifiedRegionIds->Delete();
+  this->Threader->Delete();
 }
 
 int vtkConnectivityFilter::RequestData(
@@ -163,29 +169,46 @@ int vtkConnectivityFilter::RequestData(
   this->ExtractionMode != VTK_EXTRACT_CELL_SEEDED_REGIONS &&
   this->ExtractionMode != VTK_EXTRACT_CLOSEST_POINT_REGION )
     { //visit all cells marking with region number
-    for (cellId=0; cellId < numCells; cellId++)
+    if ( this->InScalars )
       {
-      if ( cellId && !(cellId % 5000) )
+      for (cellId=0; cellId < numCells; cellId++)
         {
-        this->UpdateProgress (0.1 + 0.8*cellId/numCells);
-        }
+        if ( cellId && !(cellId % 5000) )
+          {
+          this->UpdateProgress (0.1 + 0.8*cellId/numCells);
+          }
 
-      if ( this->Visited[cellId] < 0 )
-        {
-        this->NumCellsInRegion = 0;
-        this->Wave->InsertNextId(cellId);
-        this->TraverseAndMark (input);
+        if ( this->Visited[cellId] < 0 )
+          {
+          this->NumCellsInRegion = 0;
+          this->Wave->InsertNextId(cellId);
+          this->TraverseAndMark (input);
+
+          if ( this->NumCellsInRegion > maxCellsInRegion )
+            {
+            maxCellsInRegion = this->NumCellsInRegion;
+            largestRegionId = this->RegionNumber;
+            }
 
-        if ( this->NumCellsInRegion > maxCellsInRegion )
+          this->RegionSizes->InsertValue(this->RegionNumber++,
+                                         this->NumCellsInRegion);
+          this->Wave->Reset();
+          this->Wave2->Reset();
+          }
+        }
+      }
+    else
+      {
+      // Geometric connectivity only: label all regions at once
+      this->LabelRegions(input);
+      this->UpdateProgress (0.9);
+      for (i=0; i < this->RegionNumber; i++)
+        {
+        if ( this->RegionSizes->GetValue(i) > maxCellsInRegion )
           {
-          maxCellsInRegion = this->NumCellsInRegion;
-          largestRegionId = this->RegionNumber;
+          maxCellsInRegion = this->RegionSizes->GetValue(i);
+          largestRegionId = i;
           }
-
-        this->RegionSizes->InsertValue(this->RegionNumber++,
-                                       this->NumCellsInRegion);
-        this->Wave->Reset();
-        this->Wave2->Reset();
         }
       }
     }
@@ -499,6 +522,38 @@ void vtkConnectivityFilter::TraverseAndMark (vtkDataSet *input)
   return;
 }
 
+// Label all the regions at once, merging the cells that share points (see
+// vtkConnectedCellLabeling). Points are numbered in the order of their ids.
+//
+void vtkConnectivityFilter::LabelRegions (vtkDataSet *input)
+{
+  vtkIdType cellId, ptId;
+  vtkIdType numCells = input->GetNumberOfCells();
+  vtkIdType numPts = input->GetNumberOfPoints();
+  vtkIdType *pointRegions = new vtkIdType[numPts];
+
+  this->RegionNumber =
+    vtkConnectedCellLabeling::Label(input, this->Threader,
+                                    this->NumberOfThreads, this->Visited,
+                                    pointRegions, this->RegionSizes);
+
+  vtkIdType *cellScalars = this->NewCellScalars->GetPointer(0);
+  for ( cellId=0; cellId < numCells; cellId++ )
+    {
+    cellScalars[cellId] = this->Visited[cellId];
+    }
+  for ( ptId=0; ptId < numPts; ptId++ )
+    {
+    if ( pointRegions[ptId] >= 0 )
+      {
+      this->PointMap[ptId] = this->PointNumber;
+      this->NewScalars->SetValue(this->PointNumber++, pointRegions[ptId]);
+      }
+    }
+
+  delete [] pointRegions;
+}
+
 // Obtain the number of connected regions.
 int vtkConnectivityFilter::GetNumberOfExtractedRegions()
 {
@@ -570,5 +625,7 @@ void vtkConnectivityFilter::PrintSelf(ostream& os, vtkIndent indent)
 
   double *range = this->GetScalarRange();
   os << indent << "Scalar Range: (" << range[0] << ", " << range[1] << ")\n";
+
+  os << indent << "Number Of Threads: " << this->NumberOfThreads << "\n";
 }
 
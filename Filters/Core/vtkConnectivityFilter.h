@@ -40,6 +40,11 @@
 // connectivity will pull out all voxels "containing" the anatomical
 // structure. These voxels can then be contoured or processed by other
 // visualization filters.
+//
+// Without ScalarConnectivity, the largest, specified and all regions modes
+// label all the regions at once with a (multithreaded) union-find over the
+// cell points, which does not need the point to cell links of the input.
+// The output points are then in the order of the input point ids.
 
 // .SECTION See Also
 // vtkPolyDataConnectivityFilter
@@ -62,6 +67,7 @@ class vtkFloatArray;
 class vtkIdList;
 class vtkIdTypeArray;
 class vtkIntArray;
+class vtkMultiThreader;
 
 class VTKFILTERSCORE_EXPORT vtkConnectivityFilter : public vtkUnstructuredGridAlgorithm
 {
@@ -145,6 +151,13 @@ public:
   vtkGetMacro(ColorRegions,int);
   vtkBooleanMacro(ColorRegions,int);
 
+  // Description:
+  // Set/Get the number of threads used to label the regions when
+  // ScalarConnectivity is off. Defaults to the number of available
+  // processors.
+  vtkSetClampMacro(NumberOfThreads, int, 1, VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads, int);
+
 protected:
   vtkConnectivityFilter();
   ~vtkConnectivityFilter();
@@ -164,7 +177,11 @@ protected:
   int ScalarConnectivity;
   double ScalarRange[2];
 
+  vtkMultiThreader *Threader;
+  int NumberOfThreads;
+
   void TraverseAndMark(vtkDataSet *input);
+  void LabelRegions(vtkDataSet *input);
 
 private:
   // used to support algorithm execution
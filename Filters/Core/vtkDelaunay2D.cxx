@@ -25,6 +25,7 @@
 #include "vtkPointData.h"
 #include "vtkPolyData.h"
 #include "vtkPolygon.h"
+#include "vtkSpatialPointOrdering.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
 #include "vtkTriangle.h"
 #include "vtkTransform.h"
@@ -40,6 +41,7 @@ vtkDelaunay2D::vtkDelaunay2D()
   this->Tolerance = 0.00001;
   this->BoundingTriangulation = 0;
   this->Offset = 1.0;
+  this->SpatialSorting = 0;
   this->Transform = NULL;
   this->ProjectionPlaneMode = VTK_DELAUNAY_XY_PLANE;
 
@@ -443,13 +445,23 @@ int vtkDelaunay2D::RequestData(
   this->Mesh->SetPolys(triangles);
   this->Mesh->BuildLinks(); //build cell structure
 
+  // Optionally compute a spatially coherent insertion order of the
+  // (projected) points. Point ids are not changed.
+  vtkIdType *order = NULL;
+  if ( this->SpatialSorting )
+    {
+    order = new vtkIdType[numPoints];
+    vtkSpatialPointOrdering::BRIO(points, numPoints, 2, order);
+    }
+
   // For each point; find triangle containing point. Then evaluate three
   // neighboring triangles for Delaunay criterion. Triangles that do not
   // satisfy criterion have their edges swapped. This continues recursively
   // until all triangles have been shown to be Delaunay.
   //
-  for (ptId=0; ptId < numPoints; ptId++)
+  for (vtkIdType idx=0; idx < numPoints; idx++)
     {
+    ptId = ( order ? order[idx] : idx );
     this->GetPoint(ptId,x);
     nei[0] = (-1); //where we are coming from...nowhere initially
 
@@ -530,10 +542,10 @@ int vtkDelaunay2D::RequestData(
       tri[0] = 0; //no triangle found
       }
 
-    if ( ! (ptId % 1000) )
+    if ( ! (idx % 1000) )
       {
-      vtkDebugMacro(<<"point #" << ptId);
-      this->UpdateProgress (static_cast<double>(ptId)/numPoints);
+      vtkDebugMacro(<<"point #" << idx);
+      this->UpdateProgress (static_cast<double>(idx)/numPoints);
       if (this->GetAbortExecute())
         {
         break;
@@ -542,6 +554,8 @@ int vtkDelaunay2D::RequestData(
 
     }//for all points
 
+  delete [] order;
+
   vtkDebugMacro(<<"Triangulated " << numPoints <<" points, "
                 << this->NumberOfDuplicatePoints
                 << " of which were duplicates");
@@ -1460,4 +1474,6 @@ void vtkDelaunay2D::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "Offset: " << this->Offset << "\n";
   os << indent << "Bounding Triangulation: "
      << (this->BoundingTriangulation ? "On\n" : "Off\n");
+  os << indent << "Spatial Sorting: "
+     << (this->SpatialSorting ? "On\n" : "Off\n");
 }
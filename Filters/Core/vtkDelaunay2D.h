@@ -195,6 +195,19 @@ public:
   vtkGetMacro(BoundingTriangulation,int);
   vtkBooleanMacro(BoundingTriangulation,int);
 
+  // Description:
+  // Boolean controls whether the input points are inserted in a spatially
+  // coherent order rather than in input order. When on, the (projected)
+  // points are inserted in a biased randomized order along a Hilbert curve
+  // (see vtkSpatialPointOrdering), which keeps the walk towards the
+  // enclosing triangle short and gives near-linear behavior on large,
+  // scattered inputs. Point ids in the output are not affected, however in
+  // degenerate cases the triangulation may differ from the one obtained
+  // with the input order. Off by default.
+  vtkSetMacro(SpatialSorting,int);
+  vtkGetMacro(SpatialSorting,int);
+  vtkBooleanMacro(SpatialSorting,int);
+
   // Description:
   // Set / get the transform which is applied to points to generate a
   // 2D problem.  This maps a 3D dataset into a 2D dataset where
@@ -225,6 +238,7 @@ protected:
   double Tolerance;
   int BoundingTriangulation;
   double Offset;
+  int SpatialSorting;
 
   vtkAbstractTransform *Transform;
 
@@ -23,6 +23,7 @@
 #include "vtkPointData.h"
 #include "vtkPointLocator.h"
 #include "vtkPolyData.h"
+#include "vtkSpatialPointOrdering.h"
 #include "vtkTetra.h"
 #include "vtkTriangle.h"
 #include "vtkUnstructuredGrid.h"
@@ -136,8 +137,10 @@ vtkDelaunay3D::vtkDelaunay3D()
   this->Tolerance = 0.001;
   this->BoundingTriangulation = 0;
   this->Offset = 2.5;
+  this->SpatialSorting = 0;
   this->Locator = NULL;
   this->TetraArray = NULL;
+  this->LastTetraId = -1;
 
   // added for performance
   this->Tetras = vtkIdList::New();
@@ -199,26 +202,37 @@ vtkIdType vtkDelaunay3D::FindEnclosingFaces(double x[3],
     return 0;
     }
 
-  closestPoint = locator->FindClosestInsertedPoint(x);
-  vtkCellLinks *links = Mesh->GetCellLinks();
-  int numCells = links->GetNcells(closestPoint);
-  vtkIdType *cells = links->GetCells(closestPoint);
-  if ( numCells <= 0 ) //shouldn't happen
-    {
-    this->NumberOfDegeneracies++;
-    return 0;
-    }
-  else
+  // When points are inserted in spatially coherent order, the last created
+  // tetra is usually close to the point, so try to walk from there first.
+  tetraId = -1;
+  if ( this->SpatialSorting && this->LastTetraId >= 0 )
     {
-    tetraId = cells[0];
+    tetraId = this->FindTetra(Mesh,xd,this->LastTetraId,0);
     }
 
-  // Okay, walk towards the containing tetrahedron
-  tetraId = this->FindTetra(Mesh,xd,tetraId,0);
   if ( tetraId < 0 )
     {
-    this->NumberOfDegeneracies++;
-    return 0;
+    closestPoint = locator->FindClosestInsertedPoint(x);
+    vtkCellLinks *links = Mesh->GetCellLinks();
+    int numCells = links->GetNcells(closestPoint);
+    vtkIdType *cells = links->GetCells(closestPoint);
+    if ( numCells <= 0 ) //shouldn't happen
+      {
+      this->NumberOfDegeneracies++;
+      return 0;
+      }
+    else
+      {
+      tetraId = cells[0];
+      }
+
+    // Okay, walk towards the containing tetrahedron
+    tetraId = this->FindTetra(Mesh,xd,tetraId,0);
+    if ( tetraId < 0 )
+      {
+      this->NumberOfDegeneracies++;
+      return 0;
+      }
     }
 
   // Initialize the list of tetras who contain the point according
@@ -454,20 +468,30 @@ int vtkDelaunay3D::RequestData(
   Mesh = this->InitPointInsertion(center, this->Offset*tol,
                                   numPoints, points);
 
+  // Optionally compute a spatially coherent insertion order. The point ids
+  // are not changed, only the order in which they are inserted.
+  vtkIdType *order = NULL;
+  if ( this->SpatialSorting )
+    {
+    order = new vtkIdType[numPoints];
+    vtkSpatialPointOrdering::BRIO(inPoints, numPoints, 3, order);
+    }
+
   // Insert each point into triangulation. Points laying "inside"
   // of tetra cause tetra to be deleted, leaving a void with bounding
   // faces. Combination of point and each face is used to form new
   // tetrahedra.
-  for (ptId=0; ptId < numPoints; ptId++)
+  for (i=0; i < numPoints; i++)
     {
+    ptId = ( order ? order[i] : i );
     inPoints->GetPoint(ptId,x);
 
     this->InsertPoint(Mesh, points, ptId, x, holeTetras);
 
-    if ( ! (ptId % 250) )
+    if ( ! (i % 250) )
       {
-      vtkDebugMacro(<<"point #" << ptId);
-      this->UpdateProgress (static_cast<double>(ptId)/numPoints);
+      vtkDebugMacro(<<"point #" << i);
+      this->UpdateProgress (static_cast<double>(i)/numPoints);
       if (this->GetAbortExecute())
         {
         break;
@@ -476,6 +500,7 @@ int vtkDelaunay3D::RequestData(
 
     }//for all points
 
+  delete [] order;
   this->EndPointInsertion();
 
   vtkDebugMacro(<<"Triangulated " << numPoints <<" points, "
@@ -724,6 +749,7 @@ vtkUnstructuredGrid *vtkDelaunay3D::InitPointInsertion(double center[3],
 
   this->NumberOfDuplicatePoints = 0;
   this->NumberOfDegeneracies = 0;
+  this->LastTetraId = -1;
 
   points = vtkPoints::New();
   points->Allocate(numPtsToInsert+6);
@@ -885,6 +911,7 @@ void vtkDelaunay3D::InsertPoint(vtkUnstructuredGrid *Mesh, vtkPoints *points,
         }
 
       this->InsertTetra(Mesh, points, tetraId);
+      this->LastTetraId = tetraId;
 
       }//for each face
 
@@ -977,6 +1004,8 @@ void vtkDelaunay3D::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "Offset: " << this->Offset << "\n";
   os << indent << "Bounding Triangulation: "
      << (this->BoundingTriangulation ? "On\n" : "Off\n");
+  os << indent << "Spatial Sorting: "
+     << (this->SpatialSorting ? "On\n" : "Off\n");
 
   if ( this->Locator )
     {
@@ -75,7 +75,9 @@
 // is quite different. In the 3D case, the closest previously inserted point
 // point is found, and then the connected tetrahedra are searched to find
 // the containing one. (In 2D, a "walk" towards the enclosing triangle is
-// performed.) If the triangulation is Delaunay, then an enclosing tetrahedron
+// performed.) When SpatialSorting is on, the walk instead starts from the
+// most recently created tetrahedron, falling back to the closest point if
+// needed. If the triangulation is Delaunay, then an enclosing tetrahedron
 // will be found. However, in degenerate cases an enclosing tetrahedron may
 // not be found and the point will be rejected.
 
@@ -136,6 +138,19 @@ public:
   vtkGetMacro(BoundingTriangulation,int);
   vtkBooleanMacro(BoundingTriangulation,int);
 
+  // Description:
+  // Boolean controls whether the input points are inserted in a spatially
+  // coherent order rather than in input order. When on, the points are
+  // inserted in a biased randomized order along a Hilbert curve (see
+  // vtkSpatialPointOrdering), and the search for the enclosing tetrahedron
+  // walks from the most recently created tetrahedron. This greatly reduces
+  // the cost of point location for large, scattered inputs. Point ids in the
+  // output are not affected, however in degenerate cases the triangulation
+  // may differ from the one obtained with the input order. Off by default.
+  vtkSetMacro(SpatialSorting,int);
+  vtkGetMacro(SpatialSorting,int);
+  vtkBooleanMacro(SpatialSorting,int);
+
   // Description:
   // Set / get a spatial locator for merging points. By default,
   // an instance of vtkPointLocator is used.
@@ -194,6 +209,7 @@ protected:
   double Tolerance;
   int BoundingTriangulation;
   double Offset;
+  int SpatialSorting;
 
   vtkIncrementalPointLocator *Locator;  //help locate points faster
 
@@ -221,6 +237,7 @@ private: //members added for performance
   vtkIdList *BoundaryPts; //used by InsertPoint
   vtkIdList *CheckedTetras; //used by InsertPoint
   vtkIdList *NeiTetras; //used by InsertPoint
+  vtkIdType LastTetraId; //start of the walk in FindEnclosingFaces
 
 private:
   vtkDelaunay3D(const vtkDelaunay3D&);  // Not implemented.
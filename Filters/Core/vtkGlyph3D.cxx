@@ -14,15 +14,20 @@
 =========================================================================*/
 #include "vtkGlyph3D.h"
 
+#include "vtkCellArray.h"
 #include "vtkCellData.h"
 #include "vtkCell.h"
 #include "vtkDataSet.h"
+#include "vtkDoubleArray.h"
 #include "vtkFloatArray.h"
 #include "vtkIdList.h"
 #include "vtkIdTypeArray.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
+#include "vtkIntArray.h"
 #include "vtkMath.h"
+#include "vtkMatrix4x4.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
 #include "vtkPolyData.h"
@@ -32,9 +37,368 @@
 #include "vtkTrivialProducer.h"
 #include "vtkUnsignedCharArray.h"
 
+#include <vector>
+
 vtkStandardNewMacro(vtkGlyph3D);
 vtkCxxSetObjectMacro(vtkGlyph3D, SourceTransform, vtkTransform);
 
+// Number of glyphs whose transformations are computed before they are
+// written to the output, so that the glyphs can be written concurrently
+// without keeping the transformations of all the glyphs.
+#define VTK_GLYPH3D_BATCH_SIZE 10000
+
+// A glyph, as computed by the pass over the input points.
+struct vtkGlyph3DInstance
+{
+  vtkIdType PointId; // generating input point
+  int Index; // index of the source
+  double Point[3];
+  double Matrix[16]; // maps the (transformed) source to the glyph
+  double Vector[3];
+  double VectorMagnitude;
+  double Scale; // data scale, before the scale factor (used for coloring)
+};
+
+struct vtkGlyph3DThreadStruct
+{
+  std::vector<vtkGlyph3DInstance> *Instances; // the current batch
+  vtkIdType FirstGlyph; // output id of the first glyph of the batch
+  int NumberOfThreads;
+  int OutputInstances;
+  int ColorMode;
+  vtkDataArray *CScalars;
+  vtkPointData *InputPD;
+  vtkPointData *OutputPD;
+  vtkCellData *OutputCD;
+
+  // output arrays
+  vtkPoints *Points;
+  vtkDataArray *Scalars;
+  vtkDataArray *Vectors;
+  vtkDataArray *Normals;
+  vtkDataArray *TCoords;
+  vtkIdTypeArray *PointIds;
+
+  // output cells (the vertices of the instance table)
+  vtkCellArray *Cells;
+
+  // instance table
+  vtkIntArray *SourceIndices;
+  vtkDoubleArray *Transforms;
+  double *SourceMatrix;
+
+  // glyph geometry
+  vtkPoints *SourcePoints;
+  vtkDataArray *SourceNormals;
+  vtkDataArray *SourceTCoords;
+  vtkIdType NumberOfSourceCells;
+  vtkCellArray *SourceCells;
+  vtkIdType *Connectivity;
+  int FillCellData;
+};
+
+//----------------------------------------------------------------------------
+// Return (in cells) the only non-empty cell array of the source. Returns
+// false if the source mixes kinds of cells, since their order would not be
+// preserved when the output cells are built kind by kind.
+static bool vtkGlyph3DGetSourceCells(vtkPolyData *source, vtkCellArray *&cells)
+{
+  vtkCellArray *arrays[4];
+  arrays[0] = source->GetVerts();
+  arrays[1] = source->GetLines();
+  arrays[2] = source->GetPolys();
+  arrays[3] = source->GetStrips();
+
+  cells = NULL;
+  for (int i=0; i < 4; i++)
+    {
+    if ( arrays[i]->GetNumberOfCells() > 0 )
+      {
+      if ( cells )
+        {
+        return false;
+        }
+      cells = arrays[i];
+      }
+    }
+
+  // types that do not survive a rebuild of the cells
+  for (vtkIdType cellId=0; cellId < source->GetNumberOfCells(); cellId++)
+    {
+    int type = source->GetCellType(cellId);
+    if ( type == VTK_PIXEL || type == VTK_EMPTY_CELL )
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+static bool vtkGlyph3DHasBitArrays(vtkDataSetAttributes *dsa)
+{
+  for (int i=0; i < dsa->GetNumberOfArrays(); i++)
+    {
+    if ( dsa->GetAbstractArray(i)->GetDataType() == VTK_BIT )
+      {
+      return true;
+      }
+    }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+// Set the color scalars of the numPts output points starting at ptId.
+static void vtkGlyph3DFillScalars(vtkGlyph3DThreadStruct *str,
+                                  const vtkGlyph3DInstance &glyph,
+                                  vtkIdType ptId, vtkIdType numPts)
+{
+  vtkIdType i;
+  if ( !str->Scalars )
+    {
+    return;
+    }
+  if ( str->ColorMode == VTK_COLOR_BY_SCALAR )
+    {
+    for (i=0; i < numPts; i++)
+      {
+      str->OutputPD->CopyTuple(str->CScalars, str->Scalars, glyph.PointId,
+                               ptId+i);
+      }
+    }
+  else
+    {
+    double value = ( str->ColorMode == VTK_COLOR_BY_VECTOR ?
+                     glyph.VectorMagnitude : glyph.Scale );
+    for (i=0; i < numPts; i++)
+      {
+      str->Scalars->SetTuple(ptId+i, &value);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Write the instance table entry of a glyph of the batch.
+static void vtkGlyph3DWriteInstance(vtkGlyph3DThreadStruct *str,
+                                    vtkIdType batchId)
+{
+  const vtkGlyph3DInstance &glyph = (*str->Instances)[batchId];
+  vtkIdType glyphId = str->FirstGlyph + batchId;
+
+  str->Points->SetPoint(glyphId, glyph.Point);
+  vtkIdType *vert = str->Cells->GetPointer() + 2*glyphId;
+  vert[0] = 1;
+  vert[1] = glyphId;
+  str->SourceIndices->SetValue(glyphId, glyph.Index);
+  double *m = str->Transforms->GetPointer(16*glyphId);
+  if ( str->SourceMatrix )
+    {
+    vtkMatrix4x4::Multiply4x4(glyph.Matrix, str->SourceMatrix, m);
+    }
+  else
+    {
+    memcpy(m, glyph.Matrix, 16*sizeof(double));
+    }
+
+  if ( str->Vectors )
+    {
+    str->Vectors->SetTuple(glyphId, glyph.Vector);
+    }
+  vtkGlyph3DFillScalars(str, glyph, glyphId, 1);
+  if ( str->InputPD )
+    {
+    str->OutputPD->FillData(str->InputPD, glyph.PointId, glyphId, 1);
+    }
+  if ( str->PointIds )
+    {
+    str->PointIds->SetValue(glyphId, glyph.PointId);
+    }
+}
+
+//----------------------------------------------------------------------------
+// Write the geometry and attributes of a glyph of the batch. The points and
+// normals are transformed the same way as vtkLinearTransform does.
+static void vtkGlyph3DWriteGlyph(vtkGlyph3DThreadStruct *str,
+                                 vtkIdType batchId)
+{
+  const vtkGlyph3DInstance &glyph = (*str->Instances)[batchId];
+  vtkIdType glyphId = str->FirstGlyph + batchId;
+  vtkIdType numSourcePts = str->SourcePoints->GetNumberOfPoints();
+  vtkIdType ptIncr = glyphId * numSourcePts;
+  const double (*m)[4] = reinterpret_cast<const double (*)[4]>(glyph.Matrix);
+  double x[3], y[3];
+  vtkIdType i;
+
+  for (i=0; i < numSourcePts; i++)
+    {
+    str->SourcePoints->GetPoint(i, x);
+    y[0] = m[0][0]*x[0] + m[0][1]*x[1] + m[0][2]*x[2] + m[0][3];
+    y[1] = m[1][0]*x[0] + m[1][1]*x[1] + m[1][2]*x[2] + m[1][3];
+    y[2] = m[2][0]*x[0] + m[2][1]*x[1] + m[2][2]*x[2] + m[2][3];
+    str->Points->SetPoint(ptIncr+i, y);
+    }
+
+  if ( str->Normals )
+    {
+    // normals are multiplied by the transposed inverse matrix
+    double n[4][4];
+    vtkMatrix4x4::Invert(glyph.Matrix, *n);
+    vtkMatrix4x4::Transpose(*n, *n);
+    for (i=0; i < numSourcePts; i++)
+      {
+      str->SourceNormals->GetTuple(i, x);
+      y[0] = n[0][0]*x[0] + n[0][1]*x[1] + n[0][2]*x[2];
+      y[1] = n[1][0]*x[0] + n[1][1]*x[1] + n[1][2]*x[2];
+      y[2] = n[2][0]*x[0] + n[2][1]*x[1] + n[2][2]*x[2];
+      vtkMath::Normalize(y);
+      str->Normals->SetTuple(ptIncr+i, y);
+      }
+    }
+
+  if ( str->Vectors )
+    {
+    for (i=0; i < numSourcePts; i++)
+      {
+      str->Vectors->SetTuple(ptIncr+i, glyph.Vector);
+      }
+    }
+  if ( str->TCoords )
+    {
+    double tc[3];
+    for (i=0; i < numSourcePts; i++)
+      {
+      str->SourceTCoords->GetTuple(i, tc);
+      str->TCoords->SetTuple(ptIncr+i, tc);
+      }
+    }
+  vtkGlyph3DFillScalars(str, glyph, ptIncr, numSourcePts);
+  if ( str->InputPD )
+    {
+    str->OutputPD->FillData(str->InputPD, glyph.PointId, ptIncr,
+                            numSourcePts);
+    if ( str->FillCellData )
+      {
+      str->OutputCD->FillData(str->InputPD, glyph.PointId,
+                              glyphId*str->NumberOfSourceCells,
+                              str->NumberOfSourceCells);
+      }
+    }
+  if ( str->PointIds )
+    {
+    for (i=0; i < numSourcePts; i++)
+      {
+      str->PointIds->SetValue(ptIncr+i, glyph.PointId);
+      }
+    }
+
+  // topology (the source cells offset to the glyph points)
+  if ( str->SourceCells )
+    {
+    vtkIdType connSize = str->SourceCells->GetNumberOfConnectivityEntries();
+    vtkIdType *pSrc = str->SourceCells->GetPointer();
+    vtkIdType *end = pSrc + connSize;
+    vtkIdType *pDest = str->Connectivity + glyphId*connSize;
+    vtkIdType npts;
+    while ( pSrc < end )
+      {
+      npts = *pSrc++;
+      *pDest++ = npts;
+      for ( ; npts > 0; npts-- )
+        {
+        *pDest++ = *pSrc++ + ptIncr;
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+static VTK_THREAD_RETURN_TYPE vtkGlyph3DThreadedExecute(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkGlyph3DThreadStruct *str =
+    static_cast<vtkGlyph3DThreadStruct *>(info->UserData);
+
+  vtkIdType numGlyphs = static_cast<vtkIdType>(str->Instances->size());
+  vtkIdType first = numGlyphs * info->ThreadID / str->NumberOfThreads;
+  vtkIdType last = numGlyphs * (info->ThreadID+1) / str->NumberOfThreads;
+  for (vtkIdType batchId = first; batchId < last; batchId++)
+    {
+    if ( str->OutputInstances )
+      {
+      vtkGlyph3DWriteInstance(str, batchId);
+      }
+    else
+      {
+      vtkGlyph3DWriteGlyph(str, batchId);
+      }
+    }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+// Write the current batch of glyphs concurrently, each glyph into its own
+// range of the output arrays, then start a new batch. The output arrays are
+// extended to hold the batch; their memory is allocated for all the input
+// points up front, so this keeps the glyphs of the previous batches.
+static void vtkGlyph3DWriteBatch(vtkGlyph3DThreadStruct *str,
+                                 vtkMultiThreader *threader)
+{
+  vtkIdType numBatchGlyphs = static_cast<vtkIdType>(str->Instances->size());
+  vtkIdType numGlyphs = str->FirstGlyph + numBatchGlyphs;
+  vtkIdType numNewPts = numGlyphs;
+  vtkIdType numNewCells = numGlyphs;
+
+  if ( str->OutputInstances )
+    {
+    str->Cells->WritePointer(numGlyphs, 2*numGlyphs);
+    }
+  else
+    {
+    numNewPts *= str->SourcePoints->GetNumberOfPoints();
+    numNewCells *= str->NumberOfSourceCells;
+    if ( str->SourceCells )
+      {
+      str->Connectivity = str->Cells->WritePointer(numNewCells,
+        numGlyphs*str->SourceCells->GetNumberOfConnectivityEntries());
+      }
+    if ( str->FillCellData )
+      {
+      str->OutputCD->SetNumberOfTuples(numNewCells);
+      }
+    }
+
+  str->Points->SetNumberOfPoints(numNewPts);
+  str->OutputPD->SetNumberOfTuples(numNewPts);
+  if ( str->Scalars )
+    {
+    str->Scalars->SetNumberOfTuples(numNewPts);
+    }
+  if ( str->Vectors )
+    {
+    str->Vectors->SetNumberOfTuples(numNewPts);
+    }
+  if ( str->Normals )
+    {
+    str->Normals->SetNumberOfTuples(numNewPts);
+    }
+  if ( str->TCoords )
+    {
+    str->TCoords->SetNumberOfTuples(numNewPts);
+    }
+
+  if ( numBatchGlyphs > 0 )
+    {
+    threader->SetNumberOfThreads(str->NumberOfThreads);
+    threader->SetSingleMethod(vtkGlyph3DThreadedExecute, str);
+    threader->SingleMethodExecute();
+    }
+
+  str->FirstGlyph = numGlyphs;
+  str->Instances->clear();
+}
+
 //----------------------------------------------------------------------------
 // Construct object with scaling on, scaling mode is by scalar value,
 // scale factor = 1.0, the range is (0,1), orient geometry is on, and
@@ -58,6 +422,9 @@ vtkGlyph3D::vtkGlyph3D()
   this->SetNumberOfInputPorts(2);
   this->FillCellData = 0;
   this->SourceTransform = 0;
+  this->OutputInstances = 0;
+  this->Threader = vtkMultiThreader::New();
+  this->NumberOfThreads = this->Threader->GetNumberOfThreads();
 
   // by default process active point scalars
   this->SetInputArrayToProcess(0,0,0,vtkDataObject::FIELD_ASSOCIATION_POINTS,
@@ -81,6 +448,7 @@ vtkGlyph3D::~vtkGlyph3D()
     delete []PointIdsName;
     }
   this->SetSourceTransform(NULL);
+  this->Threader->Delete();
 }
 
 //----------------------------------------------------------------------------
@@ -130,6 +498,7 @@ int vtkGlyph3D::RequestData(
   vtkDataArray *newNormals=NULL;
   vtkDataArray *newTCoords = NULL;
   double x[3], v[3], vNew[3], s = 0.0, vMag = 0.0, value, tc[3];
+  double colorScale;
   vtkTransform *trans = vtkTransform::New();
   vtkCell *cell;
   vtkIdList *cellPts;
@@ -302,13 +671,40 @@ int vtkGlyph3D::RequestData(
 
     // Prepare to copy output.
     pd = input->GetPointData();
-    outputPD->CopyAllocate(pd,numPts*numSourcePts);
-    if (this->FillCellData)
+    if ( this->OutputInstances )
       {
-      outputCD->CopyAllocate(pd,numPts*numSourceCells);
+      outputPD->CopyAllocate(pd,numPts);
+      }
+    else
+      {
+      outputPD->CopyAllocate(pd,numPts*numSourcePts);
+      if (this->FillCellData)
+        {
+        outputCD->CopyAllocate(pd,numPts*numSourceCells);
+        }
       }
     }
 
+  if ( this->OutputInstances )
+    {
+    // the instance table has one point per glyph, and no source attributes
+    numSourcePts = numSourceCells = 1;
+    haveNormals = haveTCoords = 0;
+    }
+
+  // Glyphs are either output as an instance table, or, when a single
+  // source made of one kind of cells is used, replicated concurrently once
+  // all the transformations are known. Otherwise they are generated in a
+  // single pass.
+  std::vector<vtkGlyph3DInstance> instances;
+  vtkCellArray *sourceCells = NULL;
+  int deferGlyphs = this->OutputInstances;
+  if ( !this->OutputInstances && this->IndexMode == VTK_INDEXING_OFF &&
+       vtkGlyph3DGetSourceCells(source, sourceCells) )
+    {
+    deferGlyphs = 1;
+    }
+
   newPts = vtkPoints::New();
   newPts->Allocate(numPts*numSourcePts);
   if ( this->GeneratePointIds )
@@ -365,8 +761,88 @@ int vtkGlyph3D::RequestData(
     newTCoords->SetName("TCoords");
     }
 
+  transformedSourcePts->SetDataTypeToDouble();
+  transformedSourcePts->Allocate(numSourcePts);
+
+  // The deferred glyphs are written in batches into output arrays
+  // allocated for all the input points.
+  vtkGlyph3DThreadStruct str;
+  vtkCellArray *newCells = NULL;
+  if ( deferGlyphs )
+    {
+    instances.reserve(numPts < VTK_GLYPH3D_BATCH_SIZE ?
+                      numPts : VTK_GLYPH3D_BATCH_SIZE);
+    newCells = vtkCellArray::New();
+
+    str.Instances = &instances;
+    str.FirstGlyph = 0;
+    str.OutputInstances = this->OutputInstances;
+    str.ColorMode = this->ColorMode;
+    str.CScalars = inCScalars;
+    str.InputPD = pd;
+    str.OutputPD = outputPD;
+    str.OutputCD = outputCD;
+    str.Points = newPts;
+    str.Scalars = newScalars;
+    str.Vectors = newVectors;
+    str.Normals = newNormals;
+    str.TCoords = newTCoords;
+    str.PointIds = pointIds;
+    str.Cells = newCells;
+    str.SourceIndices = NULL;
+    str.Transforms = NULL;
+    str.SourceMatrix = NULL;
+    str.SourcePoints = sourcePts;
+    str.SourceNormals = sourceNormals;
+    str.SourceTCoords = sourceTCoords;
+    str.NumberOfSourceCells = numSourceCells;
+    str.SourceCells = sourceCells;
+    str.Connectivity = NULL;
+    str.FillCellData = this->FillCellData;
+
+    if ( this->OutputInstances )
+      {
+      newCells->Allocate(2*numPts);
+      str.SourceIndices = vtkIntArray::New();
+      str.SourceIndices->SetName("GlyphSourceIndex");
+      str.SourceIndices->Allocate(numPts);
+      outputPD->AddArray(str.SourceIndices);
+      str.SourceIndices->Delete();
+      str.Transforms = vtkDoubleArray::New();
+      str.Transforms->SetName("GlyphTransform");
+      str.Transforms->SetNumberOfComponents(16);
+      str.Transforms->Allocate(16*numPts);
+      outputPD->AddArray(str.Transforms);
+      str.Transforms->Delete();
+      if ( this->SourceTransform )
+        {
+        str.SourceMatrix = *this->SourceTransform->GetMatrix()->Element;
+        }
+      }
+    else
+      {
+      if ( sourceCells )
+        {
+        newCells->Allocate(
+          numPts*sourceCells->GetNumberOfConnectivityEntries());
+        }
+      if ( this->SourceTransform )
+        {
+        this->SourceTransform->TransformPoints(sourcePts,
+                                               transformedSourcePts);
+        str.SourcePoints = transformedSourcePts;
+        }
+      }
+
+    str.NumberOfThreads = this->NumberOfThreads;
+    if ( vtkGlyph3DHasBitArrays(outputPD) ||
+         vtkGlyph3DHasBitArrays(outputCD) )
+      {
+      str.NumberOfThreads = 1; // bits of adjacent ranges share bytes
+      }
+    }
   // Setting up for calls to PolyData::InsertNextCell()
-  if (this->IndexMode != VTK_INDEXING_OFF )
+  else if (this->IndexMode != VTK_INDEXING_OFF )
     {
     output->Allocate(3*numPts*numSourceCells,numPts*numSourceCells);
     }
@@ -376,9 +852,6 @@ int vtkGlyph3D::RequestData(
                      3*numPts*numSourceCells, numPts*numSourceCells);
     }
 
-  transformedSourcePts->SetDataTypeToDouble();
-  transformedSourcePts->Allocate(numSourcePts);
-
   // Traverse all Input points, transforming Source points and copying
   // point attributes.
   //
@@ -423,6 +896,10 @@ int vtkGlyph3D::RequestData(
           {
           newVectors->Delete();
           }
+        if(newCells)
+          {
+          newCells->Delete();
+          }
         return 0;
         }
 
@@ -514,6 +991,85 @@ int vtkGlyph3D::RequestData(
     // Now begin copying/transforming glyph
     trans->Identity();
 
+    // translate Source to Input point
+    input->GetPoint(inPtId, x);
+    trans->Translate(x[0], x[1], x[2]);
+
+    if ( haveVectors && this->Orient && (vMag > 0.0) )
+      {
+      // if there is no y or z component
+      if ( v[1] == 0.0 && v[2] == 0.0 )
+        {
+        if (v[0] < 0) //just flip x if we need to
+          {
+          trans->RotateWXYZ(180.0,0,1,0);
+          }
+        }
+      else
+        {
+        vNew[0] = (v[0]+vMag) / 2.0;
+        vNew[1] = v[1] / 2.0;
+        vNew[2] = v[2] / 2.0;
+        trans->RotateWXYZ(180.0,vNew[0],vNew[1],vNew[2]);
+        }
+      }
+
+    // determine scale factor from scalars if appropriate
+    colorScale = scalex; // = scaley = scalez
+
+    // scale data if appropriate
+    if ( this->Scaling )
+      {
+      if ( this->ScaleMode == VTK_DATA_SCALING_OFF )
+        {
+        scalex = scaley = scalez = this->ScaleFactor;
+        }
+      else
+        {
+        scalex *= this->ScaleFactor;
+        scaley *= this->ScaleFactor;
+        scalez *= this->ScaleFactor;
+        }
+
+      if ( scalex == 0.0 )
+        {
+        scalex = 1.0e-10;
+        }
+      if ( scaley == 0.0 )
+        {
+        scaley = 1.0e-10;
+        }
+      if ( scalez == 0.0 )
+        {
+        scalez = 1.0e-10;
+        }
+      trans->Scale(scalex,scaley,scalez);
+      }
+
+    // Keep the glyph for later
+    if ( deferGlyphs )
+      {
+      vtkGlyph3DInstance glyph;
+      glyph.PointId = inPtId;
+      glyph.Index = index;
+      glyph.Point[0] = x[0];
+      glyph.Point[1] = x[1];
+      glyph.Point[2] = x[2];
+      memcpy(glyph.Matrix, *trans->GetMatrix()->Element, 16*sizeof(double));
+      for (i=0; i < 3; i++)
+        {
+        glyph.Vector[i] = ( haveVectors ? v[i] : 0.0 );
+        }
+      glyph.VectorMagnitude = vMag;
+      glyph.Scale = colorScale;
+      instances.push_back(glyph);
+      if ( static_cast<int>(instances.size()) == VTK_GLYPH3D_BATCH_SIZE )
+        {
+        vtkGlyph3DWriteBatch(&str, this->Threader);
+        }
+      continue;
+      }
+
     // Copy all topology (transformation independent)
     for (cellId=0; cellId < numSourceCells; cellId++)
       {
@@ -527,10 +1083,6 @@ int vtkGlyph3D::RequestData(
       output->InsertNextCell(cell->GetCellType(),pts);
       }
 
-    // translate Source to Input point
-    input->GetPoint(inPtId, x);
-    trans->Translate(x[0], x[1], x[2]);
-
     if ( haveVectors )
       {
       // Copy Input vector
@@ -538,24 +1090,6 @@ int vtkGlyph3D::RequestData(
         {
         newVectors->InsertTuple(i+ptIncr, v);
         }
-      if (this->Orient && (vMag > 0.0))
-        {
-        // if there is no y or z component
-        if ( v[1] == 0.0 && v[2] == 0.0 )
-          {
-          if (v[0] < 0) //just flip x if we need to
-            {
-            trans->RotateWXYZ(180.0,0,1,0);
-            }
-          }
-        else
-          {
-          vNew[0] = (v[0]+vMag) / 2.0;
-          vNew[1] = v[1] / 2.0;
-          vNew[2] = v[2] / 2.0;
-          trans->RotateWXYZ(180.0,vNew[0],vNew[1],vNew[2]);
-          }
-        }
       }
 
     if (haveTCoords)
@@ -567,13 +1101,12 @@ int vtkGlyph3D::RequestData(
         }
       }
 
-    // determine scale factor from scalars if appropriate
     // Copy scalar value
     if (inSScalars && (this->ColorMode == VTK_COLOR_BY_SCALE))
       {
       for (i=0; i < numSourcePts; i++)
         {
-        newScalars->InsertTuple(i+ptIncr, &scalex); // = scaley = scalez
+        newScalars->InsertTuple(i+ptIncr, &colorScale);
         }
       }
     else if (inCScalars && (this->ColorMode == VTK_COLOR_BY_SCALAR))
@@ -591,35 +1124,6 @@ int vtkGlyph3D::RequestData(
         }
       }
 
-    // scale data if appropriate
-    if ( this->Scaling )
-      {
-      if ( this->ScaleMode == VTK_DATA_SCALING_OFF )
-        {
-        scalex = scaley = scalez = this->ScaleFactor;
-        }
-      else
-        {
-        scalex *= this->ScaleFactor;
-        scaley *= this->ScaleFactor;
-        scalez *= this->ScaleFactor;
-        }
-
-      if ( scalex == 0.0 )
-        {
-        scalex = 1.0e-10;
-        }
-      if ( scaley == 0.0 )
-        {
-        scaley = 1.0e-10;
-        }
-      if ( scalez == 0.0 )
-        {
-        scalez = 1.0e-10;
-        }
-      trans->Scale(scalex,scaley,scalez);
-      }
-
     // multiply points and normals by resulting matrix
     if (this->SourceTransform)
       {
@@ -666,6 +1170,34 @@ int vtkGlyph3D::RequestData(
     cellIncr += numSourceCells;
     }
 
+  // Write the last batch of deferred glyphs (or of the instance table).
+  if ( deferGlyphs )
+    {
+    vtkGlyph3DWriteBatch(&str, this->Threader);
+
+    if ( this->OutputInstances )
+      {
+      output->SetVerts(newCells);
+      }
+    else if ( sourceCells == source->GetVerts() )
+      {
+      output->SetVerts(newCells);
+      }
+    else if ( sourceCells == source->GetLines() )
+      {
+      output->SetLines(newCells);
+      }
+    else if ( sourceCells == source->GetPolys() )
+      {
+      output->SetPolys(newCells);
+      }
+    else if ( sourceCells == source->GetStrips() )
+      {
+      output->SetStrips(newCells);
+      }
+    newCells->Delete();
+    }
+
   // Update ourselves and release memory
   //
   output->SetPoints(newPts);
@@ -850,6 +1382,9 @@ void vtkGlyph3D::PrintSelf(ostream& os, vtkIndent indent)
     }
 
   os << indent << "Fill Cell Data: " << (this->FillCellData ? "On\n" : "Off\n");
+  os << indent << "Output Instances: "
+     << (this->OutputInstances ? "On\n" : "Off\n");
+  os << indent << "Number Of Threads: " << this->NumberOfThreads << "\n";
 
   os << indent << "SourceTransform: ";
   if (this->SourceTransform)
@@ -65,6 +65,14 @@
 // color scalars by using the SetInputArrayToProcess methods in
 // vtkAlgorithm. The first array is scalars, the next vectors, the next
 // normals and finally color scalars.
+//
+// Replicating the source for every point can produce very large outputs.
+// With OutputInstances on, the filter instead generates an instance table:
+// one point (and vertex) per glyph, with the transformation, source index
+// and color of the glyph as point data. The table can be rendered with
+// vtkGlyph3DMapper (orientation mode MATRIX) or processed by other
+// consumers that apply the transformations themselves. The exporters do
+// not: they export the table as vertices.
 
 // .SECTION See Also
 // vtkTensorGlyph
@@ -92,6 +100,7 @@
 #define VTK_INDEXING_BY_SCALAR 1
 #define VTK_INDEXING_BY_VECTOR 2
 
+class vtkMultiThreader;
 class vtkTransform;
 
 class VTKFILTERSCORE_EXPORT vtkGlyph3D : public vtkPolyDataAlgorithm
@@ -231,6 +240,31 @@ public:
   vtkGetMacro(FillCellData,int);
   vtkBooleanMacro(FillCellData,int);
 
+  // Description:
+  // Enable/disable the generation of an instance table instead of the
+  // glyph geometry. The output then has one point per glyph, located at the
+  // input point, and one vertex per point. The point data holds the
+  // "GlyphTransform" array (16 components: the 4x4 matrix, in row-major
+  // order, that maps the source to the glyph, including the
+  // SourceTransform), the "GlyphSourceIndex" array (index of the glyph in
+  // the table of sources), plus the color scalars, vectors, point ids and
+  // input point data that would be copied to each point of the glyph.
+  // Off by default.
+  vtkSetMacro(OutputInstances,int);
+  vtkGetMacro(OutputInstances,int);
+  vtkBooleanMacro(OutputInstances,int);
+
+  // Description:
+  // Set/Get the number of threads used to replicate the source (or to
+  // fill the instance table). The transformations of a batch of glyphs are
+  // computed first, then the glyphs of the batch are written concurrently
+  // into preallocated output arrays. This applies when indexing is off and
+  // the cells of the source are all of the same kind (vertices, lines,
+  // polygons or strips). By default, the number of threads is set to the
+  // number of processors.
+  vtkSetClampMacro(NumberOfThreads, int, 1, VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads, int);
+
   // Description:
   // This can be overwritten by subclass to return 0 when a point is
   // blanked. Default implementation is to always return 1;
@@ -271,6 +305,9 @@ protected:
   int FillCellData; // whether to fill output cell data
   char *PointIdsName;
   vtkTransform* SourceTransform;
+  int OutputInstances; // generate an instance table instead of geometry
+  vtkMultiThreader *Threader;
+  int NumberOfThreads;
 
 private:
   vtkGlyph3D(const vtkGlyph3D&);  // Not implemented.
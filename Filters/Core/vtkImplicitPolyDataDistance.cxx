@@ -16,9 +16,13 @@
 
 #include "vtkCellData.h"
 #include "vtkCellLocator.h"
+#include "vtkDoubleArray.h"
 #include "vtkGenericCell.h"
+#include "vtkIdList.h"
 #include "vtkMath.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
+#include "vtkPoints.h"
 #include "vtkPolyData.h"
 #include "vtkPolygon.h"
 #include "vtkTriangleFilter.h"
@@ -26,6 +30,16 @@
 
 vtkStandardNewMacro(vtkImplicitPolyDataDistance);
 
+// A batch of points evaluated by EvaluatePoints().
+struct vtkImplicitPolyDataDistanceBatch
+{
+  vtkImplicitPolyDataDistance *Self;
+  vtkPoints *Points;
+  double *Distances;
+  double *Gradients;
+  int NumberOfThreads;
+};
+
 //-----------------------------------------------------------------------------
 vtkImplicitPolyDataDistance::vtkImplicitPolyDataDistance()
 {
@@ -38,6 +52,12 @@ vtkImplicitPolyDataDistance::vtkImplicitPolyDataDistance()
   this->Input = NULL;
   this->Locator = NULL;
   this->Tolerance = 1e-12;
+
+  this->FaceNormals = vtkDoubleArray::New();
+  this->VertexNormals = vtkDoubleArray::New();
+
+  this->Threader = vtkMultiThreader::New();
+  this->NumberOfThreads = this->Threader->GetNumberOfThreads();
 }
 
 //-----------------------------------------------------------------------------
@@ -72,6 +92,8 @@ void vtkImplicitPolyDataDistance::SetInput(vtkPolyData* input)
     this->Locator->CacheCellBoundsOn();
     this->Locator->AutomaticOn();
     this->Locator->BuildLocator();
+
+    this->ComputePseudoNormals();
     }
 }
 
@@ -97,6 +119,9 @@ vtkImplicitPolyDataDistance::~vtkImplicitPolyDataDistance()
     {
     this->Locator->Delete();
     }
+  this->FaceNormals->Delete();
+  this->VertexNormals->Delete();
+  this->Threader->Delete();
 }
 
 //-----------------------------------------------------------------------------
@@ -114,6 +139,17 @@ void vtkImplicitPolyDataDistance::EvaluateGradient(double x[3], double n[3])
 
 //-----------------------------------------------------------------------------
 double vtkImplicitPolyDataDistance::SharedEvaluate(double x[3], double n[3])
+{
+  vtkSmartPointer<vtkGenericCell> cell =
+    vtkSmartPointer<vtkGenericCell>::New();
+  vtkSmartPointer<vtkIdList> idList = vtkSmartPointer<vtkIdList>::New();
+  return this->EvaluateFunctionAndGradient(x, n, cell, idList);
+}
+
+//-----------------------------------------------------------------------------
+double vtkImplicitPolyDataDistance
+::EvaluateFunctionAndGradient(double x[3], double n[3], vtkGenericCell *cell,
+                              vtkIdList *idList)
 {
   double ret = this->NoValue;
   for( int i=0; i < 3; i++ )
@@ -133,16 +169,9 @@ double vtkImplicitPolyDataDistance::SharedEvaluate(double x[3], double n[3])
   int subId;
   double vlen2;
 
-  vtkDataArray* cnorms = 0;
-  if ( this->Input->GetCellData() && this->Input->GetCellData()->GetNormals() )
-    {
-    cnorms = this->Input->GetCellData()->GetNormals();
-    }
-
   // Get point id of closest point in data set.
-  vtkSmartPointer<vtkGenericCell> cell =
-    vtkSmartPointer<vtkGenericCell>::New();
-  this->Locator->FindClosestPoint(x, p, cell, cellId, subId, vlen2);
+  this->Locator->FindClosestPointConcurrently(x, p, cell, cellId, subId,
+                                              vlen2);
 
   if (cellId != -1)	// point located
     {
@@ -158,7 +187,6 @@ double vtkImplicitPolyDataDistance::SharedEvaluate(double x[3], double n[3])
     double closestPoint[3];
     cell->EvaluatePosition(p, closestPoint, subId, pcoords, dist2, weights);
 
-    vtkIdList* idList = vtkIdList::New();
     int count = 0;
     for (int i = 0; i < 3; i++)
       {
@@ -167,23 +195,15 @@ double vtkImplicitPolyDataDistance::SharedEvaluate(double x[3], double n[3])
     // if weights contains no 0s
     if ( count == 0 || count == 1 )
       {
-      // Compute face normal.
-      // For count == 0, this is all we need.
-      // For count = 1, we'll add in the normals from adjacent faces.
-      if ( cnorms )
-        {
-        cnorms->GetTuple(cellId, awnorm);
-        }
-      else
-        {
-        vtkPolygon::ComputeNormal(cell->Points, awnorm);
-        }
+      // Face normal. For count == 0, this is all we need. For count = 1,
+      // we'll add in the normals from adjacent faces.
+      this->FaceNormals->GetTuple(cellId, awnorm);
       }
 
     // if weights contains 1 0s
     if ( count == 1 )
       {
-      // ... edge ... get two adjacent faces, compute average normal
+      // ... edge ... get the adjacent faces, compute average normal
       int a = -1, b = -1;
       for ( int edge = 0; edge < 3; edge++ )
         {
@@ -202,18 +222,10 @@ double vtkImplicitPolyDataDistance::SharedEvaluate(double x[3], double n[3])
         return this->NoValue;
         }
 
-      this->Input->GetCellEdgeNeighbors(0, a, b, idList);
+      this->Input->GetCellEdgeNeighbors(cellId, a, b, idList);
       for (int i = 0; i < idList->GetNumberOfIds(); i++)
         {
-        double norm[3];
-        if (cnorms)
-          {
-          cnorms->GetTuple(idList->GetId(i), norm);
-          }
-        else
-          {
-          vtkPolygon::ComputeNormal(this->Input->GetCell(idList->GetId(i))->GetPoints(), norm);
-          }
+        double *norm = this->FaceNormals->GetPointer(3*idList->GetId(i));
         awnorm[0] += norm[0];
         awnorm[1] += norm[1];
         awnorm[2] += norm[2];
@@ -224,9 +236,8 @@ double vtkImplicitPolyDataDistance::SharedEvaluate(double x[3], double n[3])
     // If weights contains 2 0s
     else if ( count == 2 )
       {
-      // ... vertex ... this is the expensive case, get all adjacent
-      // faces and compute sum(a_i * n_i) Angle-Weighted Pseudo
-      // Normals, J. Andreas Baerentzen and Henrik Aanaes
+      // ... vertex ... use the angle-weighted pseudonormal of the vertex,
+      // computed when the input was set.
       int a = -1;
       for (int i = 0; i < 3; i++)
         {
@@ -243,45 +254,8 @@ double vtkImplicitPolyDataDistance::SharedEvaluate(double x[3], double n[3])
         return this->NoValue;
         }
 
-      this->Input->GetPointCells(a, idList);
-      for (int i = 0; i < idList->GetNumberOfIds(); i++)
-        {
-        double norm[3];
-        if ( cnorms )
-          {
-          cnorms->GetTuple(idList->GetId(i), norm);
-          }
-        else
-          {
-          vtkPolygon::ComputeNormal(this->Input->GetCell(idList->GetId(i))->GetPoints(), norm);
-          }
-
-        // Compute angle at point a
-        int b = this->Input->GetCell(idList->GetId(i))->GetPointId(0);
-        int c = this->Input->GetCell(idList->GetId(i))->GetPointId(1);
-        if (a == b)
-          {
-          b = this->Input->GetCell(idList->GetId(i))->GetPointId(2);
-          }
-        else if (a == c)
-          {
-          c = this->Input->GetCell(idList->GetId(i))->GetPointId(2);
-          }
-        double pa[3], pb[3], pc[3];
-        this->Input->GetPoint(a, pa);
-        this->Input->GetPoint(b, pb);
-        this->Input->GetPoint(c, pc);
-        for (int j = 0; j < 3; j++) { pb[j] -= pa[j]; pc[j] -= pa[j]; }
-        vtkMath::Normalize(pb);
-        vtkMath::Normalize(pc);
-        double alpha = acos(vtkMath::Dot(pb, pc));
-        awnorm[0] += alpha * norm[0];
-        awnorm[1] += alpha * norm[1];
-        awnorm[2] += alpha * norm[2];
-        }
-      vtkMath::Normalize(awnorm);
+      this->VertexNormals->GetTuple(a, awnorm);
       }
-    idList->Delete();
 
     // sign(dist) = dot(grad, cell normal)
     if (ret == 0)
@@ -305,6 +279,163 @@ double vtkImplicitPolyDataDistance::SharedEvaluate(double x[3], double n[3])
   return ret;
 }
 
+//-----------------------------------------------------------------------------
+// Compute the normal of every face, and the angle-weighted pseudonormal of
+// every vertex (Baerentzen and Aanaes), once per input.
+void vtkImplicitPolyDataDistance::ComputePseudoNormals()
+{
+  vtkIdType numCells = this->Input->GetNumberOfCells();
+  vtkIdType numPts = this->Input->GetNumberOfPoints();
+  vtkDataArray *cnorms = this->Input->GetCellData()->GetNormals();
+
+  this->FaceNormals->SetNumberOfComponents(3);
+  this->FaceNormals->SetNumberOfTuples(numCells);
+  this->VertexNormals->SetNumberOfComponents(3);
+  this->VertexNormals->SetNumberOfTuples(numPts);
+  double *vnorms = this->VertexNormals->GetPointer(0);
+  for (vtkIdType i = 0; i < 3*numPts; i++)
+    {
+    vnorms[i] = 0.0;
+    }
+
+  vtkSmartPointer<vtkGenericCell> cell =
+    vtkSmartPointer<vtkGenericCell>::New();
+  for (vtkIdType cellId = 0; cellId < numCells; cellId++)
+    {
+    double norm[3];
+    this->Input->GetCell(cellId, cell);
+    if ( cnorms )
+      {
+      cnorms->GetTuple(cellId, norm);
+      }
+    else
+      {
+      vtkPolygon::ComputeNormal(cell->Points, norm);
+      }
+    this->FaceNormals->SetTupleValue(cellId, norm);
+
+    if ( cell->GetNumberOfPoints() != 3 )
+      {
+      continue;
+      }
+
+    // Add the face normal to each vertex, weighted by the angle of the
+    // face at the vertex.
+    double pts[3][3];
+    for (int i = 0; i < 3; i++)
+      {
+      cell->Points->GetPoint(i, pts[i]);
+      }
+    for (int i = 0; i < 3; i++)
+      {
+      double pb[3], pc[3];
+      for (int j = 0; j < 3; j++)
+        {
+        pb[j] = pts[(i+1)%3][j] - pts[i][j];
+        pc[j] = pts[(i+2)%3][j] - pts[i][j];
+        }
+      vtkMath::Normalize(pb);
+      vtkMath::Normalize(pc);
+      double cosine = vtkMath::Dot(pb, pc);
+      cosine = ( cosine > 1.0 ? 1.0 : ( cosine < -1.0 ? -1.0 : cosine ) );
+      double alpha = acos(cosine);
+      double *vnorm = vnorms + 3*cell->PointIds->GetId(i);
+      vnorm[0] += alpha * norm[0];
+      vnorm[1] += alpha * norm[1];
+      vnorm[2] += alpha * norm[2];
+      }
+    }
+
+  for (vtkIdType ptId = 0; ptId < numPts; ptId++)
+    {
+    vtkMath::Normalize(vnorms + 3*ptId);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Evaluate a range of the points of a batch. Each thread has its own cell
+// and id list; the locator and the input are only read.
+static VTK_THREAD_RETURN_TYPE vtkImplicitPolyDataDistanceEvaluate(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkImplicitPolyDataDistanceBatch *batch =
+    static_cast<vtkImplicitPolyDataDistanceBatch *>(info->UserData);
+
+  vtkIdType numPts = batch->Points->GetNumberOfPoints();
+  vtkIdType begin = numPts * info->ThreadID / batch->NumberOfThreads;
+  vtkIdType end = numPts * (info->ThreadID + 1) / batch->NumberOfThreads;
+
+  vtkGenericCell *cell = vtkGenericCell::New();
+  vtkIdList *idList = vtkIdList::New();
+  double x[3], n[3];
+  for (vtkIdType ptId = begin; ptId < end; ptId++)
+    {
+    batch->Points->GetPoint(ptId, x);
+    batch->Distances[ptId] =
+      batch->Self->EvaluateFunctionAndGradient(x, n, cell, idList);
+    if ( batch->Gradients )
+      {
+      batch->Gradients[3*ptId] = n[0];
+      batch->Gradients[3*ptId+1] = n[1];
+      batch->Gradients[3*ptId+2] = n[2];
+      }
+    }
+  idList->Delete();
+  cell->Delete();
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//-----------------------------------------------------------------------------
+void vtkImplicitPolyDataDistance::EvaluatePoints(vtkPoints *points,
+                                                 vtkDoubleArray *distances,
+                                                 vtkDoubleArray *gradients)
+{
+  vtkIdType numPts = points->GetNumberOfPoints();
+  distances->SetNumberOfComponents(1);
+  distances->SetNumberOfTuples(numPts);
+  if ( gradients )
+    {
+    gradients->SetNumberOfComponents(3);
+    gradients->SetNumberOfTuples(numPts);
+    }
+  if ( numPts < 1 )
+    {
+    return;
+    }
+
+  // See if data set with polygons has been specified
+  if (this->Input == NULL || Input->GetNumberOfCells() == 0)
+    {
+    vtkErrorMacro(<<"No polygons to evaluate function!");
+    distances->FillComponent(0, this->NoValue);
+    for (int i = 0; gradients && i < 3; i++)
+      {
+      gradients->FillComponent(i, this->NoGradient[i]);
+      }
+    return;
+    }
+
+  // The locator must not be built by the threads
+  this->Locator->BuildLocatorIfNeeded();
+
+  int numThreads = this->NumberOfThreads;
+  numThreads = ( numThreads > numPts ? static_cast<int>(numPts) :
+                 numThreads );
+
+  vtkImplicitPolyDataDistanceBatch batch;
+  batch.Self = this;
+  batch.Points = points;
+  batch.Distances = distances->GetPointer(0);
+  batch.Gradients = ( gradients ? gradients->GetPointer(0) : NULL );
+  batch.NumberOfThreads = numThreads;
+
+  this->Threader->SetNumberOfThreads(numThreads);
+  this->Threader->SetSingleMethod(vtkImplicitPolyDataDistanceEvaluate, &batch);
+  this->Threader->SingleMethodExecute();
+}
+
 //-----------------------------------------------------------------------------
 void vtkImplicitPolyDataDistance::PrintSelf(ostream& os, vtkIndent indent)
 {
@@ -314,6 +445,7 @@ void vtkImplicitPolyDataDistance::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "NoGradient: (" << this->NoGradient[0] << ", "
      << this->NoGradient[1] << ", " << this->NoGradient[2] << ")\n";
   os << indent << "Tolerance: " << this->Tolerance << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
 
   if (this->Input)
     {
@@ -22,7 +22,11 @@
 // Points interior to the geometry have a negative distance, points on
 // the exterior have a positive distance, and points on the input
 // vtkPolyData have a distance of zero. The gradient of the function
-// is the angle-weighted pseudonormal at the nearest point.
+// is the angle-weighted pseudonormal at the nearest point. The face and
+// vertex pseudonormals are computed once, when the input is set.
+//
+// EvaluatePoints() evaluates the function at a whole array of points,
+// distributing them over several threads that share the locator.
 //
 // Baerentzen, J. A. and Aanaes, H. (2005). Signed distance
 // computation using the angle weighted pseudonormal. IEEE
@@ -41,6 +45,11 @@
 #include "vtkImplicitFunction.h"
 
 class vtkCellLocator;
+class vtkDoubleArray;
+class vtkGenericCell;
+class vtkIdList;
+class vtkMultiThreader;
+class vtkPoints;
 class vtkPolyData;
 
 class VTKFILTERSCORE_EXPORT vtkImplicitPolyDataDistance : public vtkImplicitFunction
@@ -62,6 +71,21 @@ public:
   // Evaluate function gradient of nearest triangle to point x[3].
   void EvaluateGradient(double x[3], double g[3]);
 
+  // Description:
+  // Evaluate the function at every point, and optionally its gradient.
+  // The distances (and gradients, with three components) are resized to
+  // the number of points. The points are split over NumberOfThreads
+  // threads.
+  void EvaluatePoints(vtkPoints *points, vtkDoubleArray *distances,
+                      vtkDoubleArray *gradients=NULL);
+
+  // Description:
+  // Evaluate the function and its gradient at x, using the given cell and
+  // id list as scratch space. Once the input is set, this may be called
+  // from several threads at once, each with its own scratch space.
+  double EvaluateFunctionAndGradient(double x[3], double g[3],
+                                     vtkGenericCell *cell, vtkIdList *idList);
+
   // Description:
   // Set the input vtkPolyData used for the implicit function
   // evaluation.  Passes input through an internal instance of
@@ -86,12 +110,20 @@ public:
   vtkGetMacro(Tolerance, double);
   vtkSetMacro(Tolerance, double);
 
+  // Description:
+  // Set/Get the number of threads used by EvaluatePoints(). Defaults to
+  // the number of available processors.
+  vtkSetClampMacro(NumberOfThreads, int, 1, VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads, int);
+
 protected:
   vtkImplicitPolyDataDistance();
   ~vtkImplicitPolyDataDistance();
 
   double SharedEvaluate( double x[3], double n[3] );
 
+  void ComputePseudoNormals();
+
 private:
   vtkImplicitPolyDataDistance(const vtkImplicitPolyDataDistance&);  // Not implemented.
   void operator=(const vtkImplicitPolyDataDistance&);  // Not implemented.
@@ -103,6 +135,12 @@ private:
   vtkPolyData       *Input;
   vtkCellLocator    *Locator;
 
+  vtkDoubleArray    *FaceNormals;
+  vtkDoubleArray    *VertexNormals;
+
+  vtkMultiThreader  *Threader;
+  int                NumberOfThreads;
+
 };
 
 #endif
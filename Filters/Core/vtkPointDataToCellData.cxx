@@ -14,13 +14,19 @@
 =========================================================================*/
 #include "vtkPointDataToCellData.h"
 
+#include "vtkAttributeAveraging.h"
 #include "vtkCellData.h"
 #include "vtkDataSet.h"
-#include "vtkIdList.h"
+#include "vtkIdTypeArray.h"
+#include "vtkImageData.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
+#include "vtkRectilinearGrid.h"
+#include "vtkSmartPointer.h"
+#include "vtkStructuredGrid.h"
 
 vtkStandardNewMacro(vtkPointDataToCellData);
 
@@ -29,6 +35,14 @@ vtkStandardNewMacro(vtkPointDataToCellData);
 vtkPointDataToCellData::vtkPointDataToCellData()
 {
   this->PassPointData = 0;
+  this->Threader = vtkMultiThreader::New();
+  this->NumberOfThreads = this->Threader->GetNumberOfThreads();
+}
+
+//----------------------------------------------------------------------------
+vtkPointDataToCellData::~vtkPointDataToCellData()
+{
+  this->Threader->Delete();
 }
 
 //----------------------------------------------------------------------------
@@ -45,14 +59,9 @@ int vtkPointDataToCellData::RequestData(
   vtkDataSet *input = vtkDataSet::SafeDownCast(
     inInfo->Get(vtkDataObject::DATA_OBJECT()));
 
-  vtkIdType cellId, ptId;
-  vtkIdType numCells, numPts;
+  vtkIdType numCells;
   vtkPointData *inPD=input->GetPointData();
   vtkCellData *outCD=output->GetCellData();
-  int maxCellSize=input->GetMaxCellSize();
-  vtkIdList *cellPts;
-  double weight;
-  double *weights;
 
   vtkDebugMacro(<<"Mapping point data to cell data");
 
@@ -64,42 +73,60 @@ int vtkPointDataToCellData::RequestData(
     vtkDebugMacro(<<"No input cells!");
     return 1;
     }
-  weights=new double[maxCellSize];
-
-  cellPts = vtkIdList::New();
-  cellPts->Allocate(maxCellSize);
 
   // Pass the cell data first. The fields and attributes
   // which also exist in the point data of the input will
-  // be over-written during CopyAllocate
-  output->GetCellData()->CopyGlobalIdsOff();
-  output->GetCellData()->PassData(input->GetCellData());
-  output->GetCellData()->CopyFieldOff("vtkGhostLevels");
+  // be over-written during InterpolateAllocate
+  outCD->CopyGlobalIdsOff();
+  outCD->PassData(input->GetCellData());
+  outCD->CopyFieldOff("vtkGhostLevels");
 
   // notice that inPD and outCD are vtkPointData and vtkCellData; respectively.
   // It's weird, but it works.
-  outCD->InterpolateAllocate(inPD,numCells);
-
-  int abort=0;
-  vtkIdType progressInterval=numCells/20 + 1;
-  for (cellId=0; cellId < numCells && !abort; cellId++)
+  vtkDataSetAttributes::FieldList pfl(1);
+  pfl.InitializeFieldList(inPD);
+  outCD->InterpolateAllocate(pfl, numCells, numCells);
+
+  // The points of the cells of structured datasets follow from their
+  // dimensions, the others are gathered once for all the arrays.
+  int dims[3];
+  int structured = 1;
+  if (vtkImageData *image = vtkImageData::SafeDownCast(input))
     {
-    if ( !(cellId % progressInterval) )
-      {
-      this->UpdateProgress((double)cellId/numCells);
-      abort = GetAbortExecute();
-      }
+    image->GetDimensions(dims);
+    }
+  else if (vtkRectilinearGrid *rgrid = vtkRectilinearGrid::SafeDownCast(input))
+    {
+    rgrid->GetDimensions(dims);
+    }
+  else if (vtkStructuredGrid *sgrid = vtkStructuredGrid::SafeDownCast(input))
+    {
+    sgrid->GetDimensions(dims);
+    }
+  else
+    {
+    structured = 0;
+    }
 
-    input->GetCellPoints(cellId, cellPts);
-    numPts = cellPts->GetNumberOfIds();
-    if ( numPts > 0 )
+  if (structured)
+    {
+    vtkAttributeAveraging::AverageStructured(
+      inPD, outCD, pfl, dims, 0, this->Threader, this->NumberOfThreads,
+      this);
+    }
+  else
+    {
+    vtkSmartPointer<vtkIdTypeArray> offsets =
+      vtkSmartPointer<vtkIdTypeArray>::New();
+    vtkSmartPointer<vtkIdTypeArray> ptIds =
+      vtkSmartPointer<vtkIdTypeArray>::New();
+    vtkAttributeAveraging::BuildCellPoints(input, offsets, ptIds);
+    this->UpdateProgress(0.5);
+    if ( !this->GetAbortExecute() )
       {
-      weight = 1.0 / numPts;
-      for (ptId=0; ptId < numPts; ptId++)
-        {
-        weights[ptId] = weight;
-        }
-      outCD->InterpolatePoint(inPD, cellId, cellPts, weights);
+      vtkAttributeAveraging::Average(
+        inPD, outCD, pfl, numCells, offsets, ptIds,
+        this->Threader, this->NumberOfThreads, this);
       }
     }
 
@@ -110,9 +137,6 @@ int vtkPointDataToCellData::RequestData(
     }
   output->GetPointData()->PassData(input->GetPointData());
 
-  cellPts->Delete();
-  delete [] weights;
-
   return 1;
 }
 
@@ -122,4 +146,5 @@ void vtkPointDataToCellData::PrintSelf(ostream& os, vtkIndent indent)
   this->Superclass::PrintSelf(os,indent);
 
   os << indent << "Pass Point Data: " << (this->PassPointData ? "On\n" : "Off\n");
+  os << indent << "Number Of Threads: " << this->NumberOfThreads << endl;
 }
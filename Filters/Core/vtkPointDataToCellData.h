@@ -19,6 +19,12 @@
 // The method of transformation is based on averaging the data
 // values of all points defining a particular cell. Optionally, the input point
 // data can be passed through to the output as well.
+//
+// The points of the cells of image data, rectilinear and structured grids
+// follow from their dimensions; the points of the cells of the other
+// datasets are gathered once for all the arrays. The numeric arrays are
+// then averaged by NumberOfThreads threads, and the result does not depend
+// on their number.
 
 // .SECTION Caveats
 // This filter is an abstract filter, that is, the output is an abstract type
@@ -36,6 +42,8 @@
 #include "vtkFiltersCoreModule.h" // For export macro
 #include "vtkDataSetAlgorithm.h"
 
+class vtkMultiThreader;
+
 class VTKFILTERSCORE_EXPORT vtkPointDataToCellData : public vtkDataSetAlgorithm
 {
 public:
@@ -51,15 +59,23 @@ public:
   vtkGetMacro(PassPointData,int);
   vtkBooleanMacro(PassPointData,int);
 
+  // Description:
+  // Get/Set the number of threads averaging the point data. It defaults to
+  // the number of threads of vtkMultiThreader.
+  vtkSetClampMacro(NumberOfThreads, int, 1, VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads, int);
+
 protected:
   vtkPointDataToCellData();
-  ~vtkPointDataToCellData() {};
+  ~vtkPointDataToCellData();
 
   virtual int RequestData(vtkInformation* request,
                           vtkInformationVector** inputVector,
                           vtkInformationVector* outputVector);
 
   int PassPointData;
+  int NumberOfThreads;
+  vtkMultiThreader *Threader;
 private:
   vtkPointDataToCellData(const vtkPointDataToCellData&);  // Not implemented.
   void operator=(const vtkPointDataToCellData&);  // Not implemented.
@@ -17,12 +17,14 @@
 #include "vtkCellArray.h"
 #include "vtkCellData.h"
 #include "vtkCell.h"
+#include "vtkConnectedCellLabeling.h"
 #include "vtkFloatArray.h"
 #include "vtkIdList.h"
 #include "vtkIdTypeArray.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkMath.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
 #include "vtkPolyData.h"
@@ -54,6 +56,9 @@ vtkPolyDataConnectivityFilter::vtkPolyDataConnectivityFilter()
 
   this->MarkVisitedPointIds = 0;
   this->VisitedPointIds = vtkIdList::New();
+
+  this->Threader = vtkMultiThreader::New();
+  this->NumberOfThreads = this->Threader->GetNumberOfThreads();
 }
 
 vtkPolyDataConnectivityFilter::~vtkPolyDataConnectivityFilter()
@@ -64,6 +69,7 @@ vtkPolyDataConnectivityFilter::~vtkPolyDataConnectivityFilter()
   this->Seeds->Delete();
   this->SpecifiedRegionIds->Delete();
   this->VisitedPointIds->Delete();
+  this->Threader->Delete();
 }
 
 int vtkPolyDataConnectivityFilter::RequestData(
@@ -129,11 +135,25 @@ int vtkPolyDataConnectivityFilter::RequestData(
       }
     }
 
+  // Without scalar connectivity, all the regions are labeled at once and
+  // the wave front traversal (and its cell links) is not needed.
+  int labelRegions = ( !this->InScalars &&
+    this->ExtractionMode != VTK_EXTRACT_POINT_SEEDED_REGIONS &&
+    this->ExtractionMode != VTK_EXTRACT_CELL_SEEDED_REGIONS &&
+    this->ExtractionMode != VTK_EXTRACT_CLOSEST_POINT_REGION );
+
   // Build cell structure
   //
   this->Mesh = vtkPolyData::New();
   this->Mesh->CopyStructure(input);
-  this->Mesh->BuildLinks();
+  if ( labelRegions )
+    {
+    this->Mesh->BuildCells();
+    }
+  else
+    {
+    this->Mesh->BuildLinks();
+    }
   this->UpdateProgress(0.10);
 
   // Remove all visited point ids
@@ -181,30 +201,46 @@ int vtkPolyDataConnectivityFilter::RequestData(
   this->ExtractionMode != VTK_EXTRACT_CELL_SEEDED_REGIONS &&
   this->ExtractionMode != VTK_EXTRACT_CLOSEST_POINT_REGION )
     { //visit all cells marking with region number
-    for (cellId=0; cellId < numCells; cellId++)
+    if ( labelRegions )
       {
-      if ( cellId && !(cellId % 5000) )
+      this->LabelRegions();
+      this->UpdateProgress (0.9);
+      for (i=0; i < this->RegionNumber; i++)
         {
-        this->UpdateProgress (0.1 + 0.8*cellId/numCells);
+        if ( this->RegionSizes->GetValue(i) > maxCellsInRegion )
+          {
+          maxCellsInRegion = this->RegionSizes->GetValue(i);
+          largestRegionId = i;
+          }
         }
-
-      if ( this->Visited[cellId] < 0 )
+      }
+    else
+      {
+      for (cellId=0; cellId < numCells; cellId++)
         {
-        this->NumCellsInRegion = 0;
-        this->Wave->InsertNextId(cellId);
-        this->TraverseAndMark ();
-
-        if ( this->NumCellsInRegion > maxCellsInRegion )
+        if ( cellId && !(cellId % 5000) )
           {
-          maxCellsInRegion = this->NumCellsInRegion;
-          largestRegionId = this->RegionNumber;
+          this->UpdateProgress (0.1 + 0.8*cellId/numCells);
           }
 
-        this->RegionSizes->InsertValue(this->RegionNumber++,
-                                       this->NumCellsInRegion);
-        this->Wave->Reset();
-        this->Wave2->Reset();
-       }
+        if ( this->Visited[cellId] < 0 )
+          {
+          this->NumCellsInRegion = 0;
+          this->Wave->InsertNextId(cellId);
+          this->TraverseAndMark ();
+
+          if ( this->NumCellsInRegion > maxCellsInRegion )
+            {
+            maxCellsInRegion = this->NumCellsInRegion;
+            largestRegionId = this->RegionNumber;
+            }
+
+          this->RegionSizes->InsertValue(this->RegionNumber++,
+                                         this->NumCellsInRegion);
+          this->Wave->Reset();
+          this->Wave2->Reset();
+         }
+        }
       }
     }
   else // regions have been seeded, everything considered in same region
@@ -501,6 +537,33 @@ void vtkPolyDataConnectivityFilter::TraverseAndMark ()
   return;
 }
 
+// Label all the regions at once, merging the cells that share points (see
+// vtkConnectedCellLabeling). Points are numbered in the order of their ids.
+//
+void vtkPolyDataConnectivityFilter::LabelRegions ()
+{
+  vtkIdType ptId;
+  vtkIdType numPts = this->Mesh->GetNumberOfPoints();
+  vtkIdType *pointRegions = new vtkIdType[numPts];
+  vtkIdTypeArray *newScalars = vtkIdTypeArray::SafeDownCast(this->NewScalars);
+
+  this->RegionNumber =
+    vtkConnectedCellLabeling::Label(this->Mesh, this->Threader,
+                                    this->NumberOfThreads, this->Visited,
+                                    pointRegions, this->RegionSizes);
+
+  for ( ptId=0; ptId < numPts; ptId++ )
+    {
+    if ( pointRegions[ptId] >= 0 )
+      {
+      this->PointMap[ptId] = this->PointNumber;
+      newScalars->SetValue(this->PointNumber++, pointRegions[ptId]);
+      }
+    }
+
+  delete [] pointRegions;
+}
+
 // --------------------------------------------------------------------------
 int vtkPolyDataConnectivityFilter::IsScalarConnected( vtkIdType cellId )
 {
@@ -635,6 +698,8 @@ void vtkPolyDataConnectivityFilter::PrintSelf(ostream& os, vtkIndent indent)
   double *range = this->GetScalarRange();
   os << indent << "Scalar Range: (" << range[0] << ", " << range[1] << ")\n";
 
+  os << indent << "Number Of Threads: " << this->NumberOfThreads << "\n";
+
   os << indent << "RegionSizes: ";
   if (this->GetNumberOfExtractedRegions() > 10)
     {
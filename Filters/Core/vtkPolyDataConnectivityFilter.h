@@ -41,6 +41,11 @@
 // This use of ScalarConnectivity is particularly useful for selecting cells
 // for later processing.
 //
+// Without ScalarConnectivity, the largest, specified and all regions modes
+// label all the regions at once with a (multithreaded) union-find over the
+// cell points, which does not need the point to cell links of the input.
+// The output points are then in the order of the input point ids.
+//
 // .SECTION See Also
 // vtkConnectivityFilter
 
@@ -60,6 +65,7 @@
 class vtkDataArray;
 class vtkIdList;
 class vtkIdTypeArray;
+class vtkMultiThreader;
 
 class VTKFILTERSCORE_EXPORT vtkPolyDataConnectivityFilter : public vtkPolyDataAlgorithm
 {
@@ -173,6 +179,13 @@ public:
   // has been set.
   vtkGetObjectMacro( VisitedPointIds, vtkIdList );
 
+  // Description:
+  // Set/Get the number of threads used to label the regions when
+  // ScalarConnectivity is off. Defaults to the number of available
+  // processors.
+  vtkSetClampMacro(NumberOfThreads, int, 1, VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads, int);
+
 protected:
   vtkPolyDataConnectivityFilter();
   ~vtkPolyDataConnectivityFilter();
@@ -197,6 +210,7 @@ protected:
   double ScalarRange[2];
 
   void TraverseAndMark();
+  void LabelRegions();
 
   // used to support algorithm execution
   vtkDataArray *CellScalars;
@@ -217,6 +231,9 @@ protected:
 
   int MarkVisitedPointIds;
 
+  vtkMultiThreader *Threader;
+  int NumberOfThreads;
+
 private:
   vtkPolyDataConnectivityFilter(const vtkPolyDataConnectivityFilter&);  // Not implemented.
   void operator=(const vtkPolyDataConnectivityFilter&);  // Not implemented.
@@ -14,21 +14,28 @@
 =========================================================================*/
 #include "vtkProbeFilter.h"
 
+#include "vtkAbstractCellLocator.h"
 #include "vtkCell.h"
 #include "vtkCellData.h"
 #include "vtkCharArray.h"
+#include "vtkDoubleArray.h"
+#include "vtkGenericCell.h"
+#include "vtkIdList.h"
 #include "vtkIdTypeArray.h"
 #include "vtkImageData.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkMath.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
+#include "vtkPoints.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
 
 #include <vector>
 
 vtkStandardNewMacro(vtkProbeFilter);
+vtkCxxSetObjectMacro(vtkProbeFilter, CellLocator, vtkAbstractCellLocator);
 
 class vtkProbeFilter::vtkVectorOfArrays :
   public std::vector<vtkDataArray*>
@@ -52,6 +59,10 @@ vtkProbeFilter::vtkProbeFilter()
   this->CellList = 0;
 
   this->UseNullPoint = true;
+
+  this->CellLocator = NULL;
+  this->Threader = vtkMultiThreader::New();
+  this->NumberOfThreads = this->Threader->GetNumberOfThreads();
 }
 
 //----------------------------------------------------------------------------
@@ -66,6 +77,9 @@ vtkProbeFilter::~vtkProbeFilter()
 
   delete this->PointList;
   delete this->CellList;
+
+  this->SetCellLocator(NULL);
+  this->Threader->Delete();
 }
 
 //----------------------------------------------------------------------------
@@ -91,6 +105,18 @@ vtkDataObject *vtkProbeFilter::GetSource()
   return this->GetExecutive()->GetInputData(1, 0);
 }
 
+//----------------------------------------------------------------------------
+unsigned long vtkProbeFilter::GetMTime()
+{
+  unsigned long mTime = this->Superclass::GetMTime();
+  if (this->CellLocator)
+    {
+    unsigned long time = this->CellLocator->GetMTime();
+    mTime = ( time > mTime ? time : mTime );
+    }
+  return mTime;
+}
+
 //----------------------------------------------------------------------------
 int vtkProbeFilter::RequestData(
   vtkInformation *vtkNotUsed(request),
@@ -198,43 +224,708 @@ void vtkProbeFilter::Probe(vtkDataSet *input, vtkDataSet *source,
 }
 
 //----------------------------------------------------------------------------
-void vtkProbeFilter::ProbeEmptyPoints(vtkDataSet *input,
-  int srcIdx,
-  vtkDataSet *source, vtkDataSet *output)
+// The probe points are processed in batches of VTK_PROBE_BATCH_SIZE
+// points, and the batches in blocks of VTK_PROBE_BATCHES_PER_BLOCK batches
+// per thread. The batches do not depend on the number of threads.
+#define VTK_PROBE_BATCH_SIZE 1024
+#define VTK_PROBE_BATCHES_PER_BLOCK 64
+
+namespace
 {
-  vtkIdType ptId, numPts;
-  double x[3], tol2;
-  vtkCell *cell;
-  vtkPointData *pd, *outPD;
-  vtkCellData* cd;
+// A source array and the output array it is interpolated (or copied) to.
+// Numeric arrays are accessed through their pointers by the threads; the
+// others go through the vtkAbstractArray API, with a single thread.
+struct vtkProbeFilterArrays
+{
+  vtkAbstractArray *From;
+  vtkAbstractArray *To;
+  void *FromPointer;
+  void *ToPointer;
+  int DataType;
+  int NumberOfComponents;
+  bool Numeric;
+};
+
+// A dataset probed into, with its tolerance, its bounds padded by the
+// tolerance and its arrays
+struct vtkProbeFilterSource
+{
+  vtkDataSet *DataSet;
+  double Tol2;
+  double Bounds[6];
+  std::vector<vtkProbeFilterArrays> PointArrays;
+  std::vector<vtkProbeFilterArrays> CellArrays;
+};
+
+// A uniform grid of bins over the bounds of the sources. Each bin lists the
+// sources whose bounds overlap it, in probing order, so that a point is only
+// searched in the few sources that may contain it.
+class vtkProbeFilterSourceIndex
+{
+public:
+  void Build(const std::vector<vtkProbeFilterSource> &sources);
+
+  // The sources whose bounds contain x, in probing order
+  void GetCandidates(const std::vector<vtkProbeFilterSource> &sources,
+                     const double x[3], std::vector<int> &candidates) const;
+
+private:
+  int GetBin(int axis, double x) const;
+
+  double Bounds[6];
+  double Spacing[3];
+  int Divisions[3];
+  std::vector<vtkIdType> Offsets;
+  std::vector<int> SourceIds;
+};
+
+// What the threads share to probe a block of points
+struct vtkProbeFilterWork
+{
+  vtkDataSet *Input;
+  std::vector<vtkProbeFilterSource> Sources;
+  vtkProbeFilterSourceIndex Index;
+  int MaxCellSize;
+  char *Mask;
+  bool UseNullPoint;
+  std::vector<vtkProbeFilterArrays> NullArrays;
+  // With a cell locator, the cells and weights of the points of the block,
+  // found before the threads start
+  vtkIdType *LocatedCells;
+  double *LocatedWeights;
+  vtkIdType BlockBegin;
+  vtkIdType BlockEnd;
+  int NumberOfThreads;
+};
+
+// The points of a batch found in the sources: their sources and cells, and
+// the ids and weights of the points of their cells, which start at
+// Offsets[i]. Each thread has its own.
+struct vtkProbeFilterBatch
+{
+  vtkProbeFilterBatch() { this->IdList = vtkIdList::New(); }
+  ~vtkProbeFilterBatch() { this->IdList->Delete(); }
+
+  void Reset()
+  {
+    this->PointIds.clear();
+    this->SourceIds.clear();
+    this->CellIds.clear();
+    this->Offsets.assign(1, 0);
+    this->CellPointIds.clear();
+    this->Weights.clear();
+    this->Missed.clear();
+  }
+
+  // Order the points by source, keeping their order within a source: the
+  // points of source s are Order[SourceOffsets[s]] to
+  // Order[SourceOffsets[s+1]-1].
+  void GroupBySource(int numSources)
+  {
+    this->SourceOffsets.assign(numSources+1, 0);
+    size_t i;
+    for (i = 0; i < this->SourceIds.size(); i++)
+      {
+      this->SourceOffsets[this->SourceIds[i]+1]++;
+      }
+    for (int s = 0; s < numSources; s++)
+      {
+      this->SourceOffsets[s+1] += this->SourceOffsets[s];
+      }
+    this->Order.resize(this->SourceIds.size());
+    std::vector<vtkIdType> next(this->SourceOffsets.begin(),
+                                this->SourceOffsets.end() - 1);
+    for (i = 0; i < this->SourceIds.size(); i++)
+      {
+      this->Order[next[this->SourceIds[i]]++] = static_cast<vtkIdType>(i);
+      }
+  }
+
+  std::vector<vtkIdType> PointIds;
+  std::vector<int> SourceIds;
+  std::vector<vtkIdType> CellIds;
+  std::vector<vtkIdType> Offsets;
+  std::vector<vtkIdType> CellPointIds;
+  std::vector<double> Weights;
+  std::vector<vtkIdType> Missed;
+  std::vector<vtkIdType> Order;
+  std::vector<vtkIdType> SourceOffsets;
+  vtkIdList *IdList;
+};
+
+//----------------------------------------------------------------------------
+void vtkProbeFilterSourceIndex::Build(
+  const std::vector<vtkProbeFilterSource> &sources)
+{
+  int i, s;
+  size_t numSources = sources.size();
+  for (i = 0; i < 3; i++)
+    {
+    this->Bounds[2*i] = VTK_DOUBLE_MAX;
+    this->Bounds[2*i+1] = -VTK_DOUBLE_MAX;
+    }
+  for (s = 0; s < static_cast<int>(numSources); s++)
+    {
+    const double *b = sources[s].Bounds;
+    for (i = 0; i < 3; i++)
+      {
+      if (b[2*i] <= b[2*i+1])
+        {
+        this->Bounds[2*i] = ( b[2*i] < this->Bounds[2*i] ?
+                              b[2*i] : this->Bounds[2*i] );
+        this->Bounds[2*i+1] = ( b[2*i+1] > this->Bounds[2*i+1] ?
+                                b[2*i+1] : this->Bounds[2*i+1] );
+        }
+      }
+    }
+
+  // About 8 bins per source, with at most 64 bins along an axis
+  int div = static_cast<int>(2.0*pow(static_cast<double>(numSources),
+                                     1.0/3.0) + 0.5);
+  div = ( div < 1 ? 1 : ( div > 64 ? 64 : div ) );
+  for (i = 0; i < 3; i++)
+    {
+    double length = this->Bounds[2*i+1] - this->Bounds[2*i];
+    this->Divisions[i] = ( length > 0.0 ? div : 1 );
+    this->Spacing[i] = ( length > 0.0 ? length / div : 1.0 );
+    }
+
+  // Count the sources of each bin, then list them
+  vtkIdType numBins = static_cast<vtkIdType>(this->Divisions[0]) *
+    this->Divisions[1] * this->Divisions[2];
+  this->Offsets.assign(numBins+1, 0);
+  this->SourceIds.clear();
+  for (int pass = 0; pass < 2; pass++)
+    {
+    std::vector<vtkIdType> next(this->Offsets.begin(), this->Offsets.end()-1);
+    for (s = 0; s < static_cast<int>(numSources); s++)
+      {
+      const double *b = sources[s].Bounds;
+      if (b[0] > b[1] || b[2] > b[3] || b[4] > b[5])
+        {
+        continue;
+        }
+      int lo[3], hi[3];
+      for (i = 0; i < 3; i++)
+        {
+        lo[i] = this->GetBin(i, b[2*i]);
+        hi[i] = this->GetBin(i, b[2*i+1]);
+        }
+      for (int k = lo[2]; k <= hi[2]; k++)
+        {
+        for (int j = lo[1]; j <= hi[1]; j++)
+          {
+          for (i = lo[0]; i <= hi[0]; i++)
+            {
+            vtkIdType bin = i + this->Divisions[0] *
+              (j + static_cast<vtkIdType>(this->Divisions[1])*k);
+            if (pass == 0)
+              {
+              this->Offsets[bin+1]++;
+              }
+            else
+              {
+              this->SourceIds[next[bin]++] = s;
+              }
+            }
+          }
+        }
+      }
+    if (pass == 0)
+      {
+      for (vtkIdType bin = 0; bin < numBins; bin++)
+        {
+        this->Offsets[bin+1] += this->Offsets[bin];
+        }
+      this->SourceIds.resize(this->Offsets[numBins]);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkProbeFilterSourceIndex::GetBin(int axis, double x) const
+{
+  int bin = static_cast<int>(floor((x - this->Bounds[2*axis]) /
+                                   this->Spacing[axis]));
+  return ( bin < 0 ? 0 : ( bin >= this->Divisions[axis] ?
+                           this->Divisions[axis] - 1 : bin ) );
+}
+
+//----------------------------------------------------------------------------
+void vtkProbeFilterSourceIndex::GetCandidates(
+  const std::vector<vtkProbeFilterSource> &sources,
+  const double x[3], std::vector<int> &candidates) const
+{
+  candidates.clear();
+  int i;
+  for (i = 0; i < 3; i++)
+    {
+    if (x[i] < this->Bounds[2*i] || x[i] > this->Bounds[2*i+1])
+      {
+      return;
+      }
+    }
+  vtkIdType bin = this->GetBin(0, x[0]) + this->Divisions[0] *
+    (this->GetBin(1, x[1]) +
+     static_cast<vtkIdType>(this->Divisions[1])*this->GetBin(2, x[2]));
+  for (vtkIdType j = this->Offsets[bin]; j < this->Offsets[bin+1]; j++)
+    {
+    const double *b = sources[this->SourceIds[j]].Bounds;
+    if (x[0] >= b[0] && x[0] <= b[1] && x[1] >= b[2] && x[1] <= b[3] &&
+        x[2] >= b[4] && x[2] <= b[5])
+      {
+      candidates.push_back(this->SourceIds[j]);
+      }
+    }
+}
+}
+
+//----------------------------------------------------------------------------
+// The types handled by vtkTemplateMacro
+static bool vtkProbeFilterIsNumeric(int dataType)
+{
+  switch (dataType)
+    {
+    case VTK_DOUBLE:
+    case VTK_FLOAT:
+#if defined(VTK_TYPE_USE_LONG_LONG)
+    case VTK_LONG_LONG:
+    case VTK_UNSIGNED_LONG_LONG:
+#endif
+#if defined(VTK_TYPE_USE___INT64)
+    case VTK___INT64:
+# if defined(VTK_TYPE_CONVERT_UI64_TO_DOUBLE)
+    case VTK_UNSIGNED___INT64:
+# endif
+#endif
+    case VTK_ID_TYPE:
+    case VTK_LONG:
+    case VTK_UNSIGNED_LONG:
+    case VTK_INT:
+    case VTK_UNSIGNED_INT:
+    case VTK_SHORT:
+    case VTK_UNSIGNED_SHORT:
+    case VTK_CHAR:
+    case VTK_SIGNED_CHAR:
+    case VTK_UNSIGNED_CHAR:
+      return true;
+    default:
+      return false;
+    }
+}
+
+//----------------------------------------------------------------------------
+// from may be NULL for the arrays that are only nulled
+static vtkProbeFilterArrays vtkProbeFilterMakeArrays(vtkAbstractArray *from,
+                                                     vtkAbstractArray *to)
+{
+  vtkProbeFilterArrays arrays;
+  arrays.From = from;
+  arrays.To = to;
+  arrays.DataType = to->GetDataType();
+  arrays.NumberOfComponents = to->GetNumberOfComponents();
+  arrays.Numeric = ( to->IsA("vtkDataArray") &&
+                     vtkProbeFilterIsNumeric(arrays.DataType) &&
+                     ( !from ||
+                       ( from->IsA("vtkDataArray") &&
+                         from->GetDataType() == arrays.DataType &&
+                         from->GetNumberOfComponents() ==
+                         arrays.NumberOfComponents ) ) );
+  arrays.FromPointer = ( arrays.Numeric && from ?
+                         from->GetVoidPointer(0) : NULL );
+  arrays.ToPointer = ( arrays.Numeric ? to->GetVoidPointer(0) : NULL );
+  return arrays;
+}
+
+//----------------------------------------------------------------------------
+// Round as vtkDataArray::InterpolateTuple() does, so that the threaded
+// interpolation gives the same values.
+template <class T>
+inline void vtkProbeFilterRound(double val, T *retVal)
+{
+  *retVal = static_cast<T>((val>=0.0)?(val + 0.5):(val - 0.5));
+}
+
+inline void vtkProbeFilterRound(double val, double *retVal)
+{
+  *retVal = val;
+}
+
+inline void vtkProbeFilterRound(double val, float *retVal)
+{
+  *retVal = static_cast<float>(val);
+}
+
+//----------------------------------------------------------------------------
+// The batch points are those from Order[first] to Order[last-1]
+template <class T>
+void vtkProbeFilterInterpolate(const T *from, T *to, int numComp,
+                               const vtkProbeFilterBatch &batch,
+                               vtkIdType first, vtkIdType last)
+{
+  for (vtkIdType k = first; k < last; k++)
+    {
+    vtkIdType i = batch.Order[k];
+    T *out = to + batch.PointIds[i]*numComp;
+    vtkIdType begin = batch.Offsets[i];
+    vtkIdType end = batch.Offsets[i+1];
+    for (int c = 0; c < numComp; c++)
+      {
+      double val = 0;
+      for (vtkIdType j = begin; j < end; j++)
+        {
+        val += batch.Weights[j] *
+          static_cast<double>(from[batch.CellPointIds[j]*numComp+c]);
+        }
+      vtkProbeFilterRound(val, out + c);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+void vtkProbeFilterCopyCellTuples(const T *from, T *to, int numComp,
+                                  const vtkProbeFilterBatch &batch,
+                                  vtkIdType first, vtkIdType last)
+{
+  for (vtkIdType k = first; k < last; k++)
+    {
+    vtkIdType i = batch.Order[k];
+    const T *in = from + batch.CellIds[i]*numComp;
+    T *out = to + batch.PointIds[i]*numComp;
+    for (int c = 0; c < numComp; c++)
+      {
+      out[c] = in[c];
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+void vtkProbeFilterNullTuples(T *to, int numComp,
+                              const std::vector<vtkIdType> &ptIds)
+{
+  for (size_t i = 0; i < ptIds.size(); i++)
+    {
+    T *out = to + ptIds[i]*numComp;
+    for (int c = 0; c < numComp; c++)
+      {
+      out[c] = static_cast<T>(0);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Interpolate the point arrays and copy the cell arrays of a source to the
+// points of the batch found in it, one array at a time.
+static void vtkProbeFilterInterpolateSource(const vtkProbeFilterSource &source,
+                                            vtkProbeFilterBatch &batch,
+                                            vtkIdType first, vtkIdType last)
+{
+  size_t a;
+  vtkIdType k;
+  for (a = 0; a < source.PointArrays.size(); a++)
+    {
+    const vtkProbeFilterArrays &arrays = source.PointArrays[a];
+    if (arrays.Numeric)
+      {
+      switch (arrays.DataType)
+        {
+        vtkTemplateMacro(vtkProbeFilterInterpolate(
+                           static_cast<VTK_TT*>(arrays.FromPointer),
+                           static_cast<VTK_TT*>(arrays.ToPointer),
+                           arrays.NumberOfComponents, batch, first, last));
+        }
+      continue;
+      }
+    for (k = first; k < last; k++)
+      {
+      vtkIdType i = batch.Order[k];
+      vtkIdType begin = batch.Offsets[i];
+      vtkIdType numIds = batch.Offsets[i+1] - begin;
+      batch.IdList->SetNumberOfIds(numIds);
+      for (vtkIdType j = 0; j < numIds; j++)
+        {
+        batch.IdList->SetId(j, batch.CellPointIds[begin+j]);
+        }
+      arrays.To->InterpolateTuple(batch.PointIds[i], batch.IdList,
+                                  arrays.From, &batch.Weights[begin]);
+      }
+    }
+
+  for (a = 0; a < source.CellArrays.size(); a++)
+    {
+    const vtkProbeFilterArrays &arrays = source.CellArrays[a];
+    if (arrays.Numeric)
+      {
+      switch (arrays.DataType)
+        {
+        vtkTemplateMacro(vtkProbeFilterCopyCellTuples(
+                           static_cast<VTK_TT*>(arrays.FromPointer),
+                           static_cast<VTK_TT*>(arrays.ToPointer),
+                           arrays.NumberOfComponents, batch, first, last));
+        }
+      continue;
+      }
+    for (k = first; k < last; k++)
+      {
+      vtkIdType i = batch.Order[k];
+      arrays.To->InsertTuple(batch.PointIds[i], batch.CellIds[i],
+                             arrays.From);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Interpolate the points of the batch found in the sources, source by
+// source. Null the others.
+static void vtkProbeFilterInterpolateBatch(vtkProbeFilterWork *work,
+                                           vtkProbeFilterBatch &batch)
+{
+  int numSources = static_cast<int>(work->Sources.size());
+  batch.GroupBySource(numSources);
+  for (int s = 0; s < numSources; s++)
+    {
+    if (batch.SourceOffsets[s] < batch.SourceOffsets[s+1])
+      {
+      vtkProbeFilterInterpolateSource(work->Sources[s], batch,
+                                      batch.SourceOffsets[s],
+                                      batch.SourceOffsets[s+1]);
+      }
+    }
+
+  size_t i, a;
+  if (!work->UseNullPoint)
+    {
+    return;
+    }
+  for (a = 0; a < work->NullArrays.size() && !batch.Missed.empty(); a++)
+    {
+    const vtkProbeFilterArrays &arrays = work->NullArrays[a];
+    if (arrays.Numeric)
+      {
+      switch (arrays.DataType)
+        {
+        vtkTemplateMacro(vtkProbeFilterNullTuples(
+                           static_cast<VTK_TT*>(arrays.ToPointer),
+                           arrays.NumberOfComponents, batch.Missed));
+        }
+      continue;
+      }
+    vtkDataArray *da = static_cast<vtkDataArray *>(arrays.To);
+    std::vector<double> nullTuple(arrays.NumberOfComponents, 0.0);
+    for (i = 0; i < batch.Missed.size(); i++)
+      {
+      da->InsertTuple(batch.Missed[i], &nullTuple[0]);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Probe the points of [begin,end), batch by batch. A point is searched in
+// the sources whose bounds contain it, in order, until one contains it.
+// Within a batch, the cell of a point is searched starting from the cell of
+// the previous point, when they are searched in the same source. The points
+// found are marked 2 in the mask.
+static void vtkProbeFilterProbeRange(vtkProbeFilterWork *work,
+                                     vtkIdType begin, vtkIdType end,
+                                     vtkGenericCell *cell,
+                                     vtkProbeFilterBatch &batch)
+{
+  // vtkImageData::FindCell() always computes the 8 weights of a voxel
+  int mcs = work->MaxCellSize;
+  std::vector<double> fastWeights(mcs > 8 ? mcs : 8);
+  std::vector<int> candidates;
+  double x[3], pcoords[3], *weights;
   int subId;
-  double pcoords[3], *weights;
-  double fastweights[256];
 
-  vtkDebugMacro(<<"Probing data");
+  for (vtkIdType batchBegin = begin; batchBegin < end;
+       batchBegin += VTK_PROBE_BATCH_SIZE)
+    {
+    vtkIdType batchEnd = batchBegin + VTK_PROBE_BATCH_SIZE;
+    batchEnd = ( batchEnd > end ? end : batchEnd );
+    batch.Reset();
 
-  pd = source->GetPointData();
-  cd = source->GetCellData();
+    vtkIdType hint = -1;
+    int hintSource = -1;
+    for (vtkIdType ptId = batchBegin; ptId < batchEnd; ptId++)
+      {
+      if (work->Mask[ptId] == static_cast<char>(1))
+        {
+        // skip points which have already been probed with success.
+        // This is helpful for multiblock dataset probing.
+        continue;
+        }
 
-  // lets use a stack allocated array if possible for performance reasons
-  int mcs = source->GetMaxCellSize();
-  if (mcs<=256)
+      vtkIdType cellId = -1;
+      int s = 0;
+      if (work->LocatedCells)
+        {
+        cellId = work->LocatedCells[ptId - work->BlockBegin];
+        weights = work->LocatedWeights + (ptId - work->BlockBegin)*mcs;
+        }
+      else
+        {
+        work->Input->GetPoint(ptId, x);
+        weights = &fastWeights[0];
+        work->Index.GetCandidates(work->Sources, x, candidates);
+        for (size_t c = 0; c < candidates.size() && cellId < 0; c++)
+          {
+          s = candidates[c];
+          const vtkProbeFilterSource &source = work->Sources[s];
+          vtkIdType start = ( s == hintSource ? hint : -1 );
+          cellId = source.DataSet->FindCell(x, (start >= 0 ? cell : NULL),
+                                            cell, start, source.Tol2, subId,
+                                            pcoords, weights);
+          // A failed search may leave another cell in the generic cell
+          hint = ( cellId < 0 ? -1 : hint );
+          }
+        }
+      if (cellId < 0)
+        {
+        hint = -1;
+        batch.Missed.push_back(ptId);
+        continue;
+        }
+
+      // The cell becomes the hint of the next point
+      work->Sources[s].DataSet->GetCell(cellId, cell);
+      hint = cellId;
+      hintSource = s;
+
+      vtkIdType numIds = cell->PointIds->GetNumberOfIds();
+      for (vtkIdType j = 0; j < numIds; j++)
+        {
+        batch.CellPointIds.push_back(cell->PointIds->GetId(j));
+        batch.Weights.push_back(weights[j]);
+        }
+      batch.Offsets.push_back(static_cast<vtkIdType>(
+                                batch.CellPointIds.size()));
+      batch.PointIds.push_back(ptId);
+      batch.SourceIds.push_back(s);
+      batch.CellIds.push_back(cellId);
+      work->Mask[ptId] = static_cast<char>(2);
+      }
+
+    vtkProbeFilterInterpolateBatch(work, batch);
+    }
+}
+
+//----------------------------------------------------------------------------
+static VTK_THREAD_RETURN_TYPE vtkProbeFilterProbeExecute(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkProbeFilterWork *work = static_cast<vtkProbeFilterWork *>(info->UserData);
+
+  // Each thread probes whole batches of the block
+  vtkIdType numBatches = (work->BlockEnd - work->BlockBegin +
+                          VTK_PROBE_BATCH_SIZE - 1) / VTK_PROBE_BATCH_SIZE;
+  vtkIdType begin = work->BlockBegin + VTK_PROBE_BATCH_SIZE *
+    (numBatches * info->ThreadID / work->NumberOfThreads);
+  vtkIdType end = work->BlockBegin + VTK_PROBE_BATCH_SIZE *
+    (numBatches * (info->ThreadID+1) / work->NumberOfThreads);
+  end = ( end > work->BlockEnd ? work->BlockEnd : end );
+
+  vtkGenericCell *cell = vtkGenericCell::New();
+  vtkProbeFilterBatch batch;
+  vtkProbeFilterProbeRange(work, begin, end, cell, batch);
+  cell->Delete();
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+// Return 1 if GetCell() of the source, and FindCell() when findCell is set,
+// may be called from several threads at once with a generic cell each.
+// vtkImageData computes its cells from its extent. vtkPolyData and
+// vtkUnstructuredGrid only read themselves once their cells, links and
+// point locator are built, which is done here.
+static int vtkProbeFilterPrepareConcurrentSource(vtkDataSet *source,
+                                                 int findCell)
+{
+  if (source->IsA("vtkImageData"))
     {
-    weights = fastweights;
+    return 1;
     }
-  else
+  if (!source->IsA("vtkPolyData") && !source->IsA("vtkUnstructuredGrid"))
+    {
+    return 0;
+    }
+  if (source->GetNumberOfCells() < 1 || source->GetNumberOfPoints() < 1)
     {
-    weights = new double[mcs];
+    return 1;
     }
 
-  numPts = input->GetNumberOfPoints();
-  outPD = output->GetPointData();
+  double bounds[6];
+  source->GetCellBounds(0, bounds);
+  if (findCell)
+    {
+    vtkIdList *cellIds = vtkIdList::New();
+    source->GetPointCells(0, cellIds);
+    cellIds->Delete();
+    double x[3];
+    source->GetPoint(0, x);
+    source->FindPoint(x);
+    }
+  return 1;
+}
 
-  char* maskArray = this->MaskPoints->GetPointer(0);
+//----------------------------------------------------------------------------
+// Find the cells of the points of the block not probed yet with the batch
+// FindCells() of the locator.
+static void vtkProbeFilterLocateBlock(vtkAbstractCellLocator *locator,
+                                      vtkProbeFilterWork *work,
+                                      std::vector<vtkIdType> &cells,
+                                      std::vector<double> &weights)
+{
+  vtkIdType numPts = work->BlockEnd - work->BlockBegin;
+  int mcs = work->MaxCellSize;
+  cells.assign(numPts, -1);
+  weights.resize(numPts*mcs);
+
+  vtkPoints *points = vtkPoints::New();
+  points->SetDataTypeToDouble();
+  points->Allocate(numPts);
+  std::vector<vtkIdType> located;
+  double x[3];
+  for (vtkIdType ptId = work->BlockBegin; ptId < work->BlockEnd; ptId++)
+    {
+    if (work->Mask[ptId] != static_cast<char>(1))
+      {
+      work->Input->GetPoint(ptId, x);
+      points->InsertNextPoint(x);
+      located.push_back(ptId - work->BlockBegin);
+      }
+    }
 
-  // Use tolerance as a function of size of source data
-  //
-  tol2 = source->GetLength();
+  vtkIdList *cellIds = vtkIdList::New();
+  vtkDoubleArray *cellWeights = vtkDoubleArray::New();
+  locator->FindCells(points, cellIds, NULL, cellWeights);
+  int numWeights = cellWeights->GetNumberOfComponents();
+  numWeights = ( numWeights > mcs ? mcs : numWeights );
+  for (size_t i = 0; i < located.size(); i++)
+    {
+    cells[located[i]] = cellIds->GetId(static_cast<vtkIdType>(i));
+    for (int j = 0; j < numWeights; j++)
+      {
+      weights[located[i]*mcs+j] =
+        cellWeights->GetComponent(static_cast<vtkIdType>(i), j);
+      }
+    }
+  cellWeights->Delete();
+  cellIds->Delete();
+  points->Delete();
+
+  work->LocatedCells = ( numPts > 0 ? &cells[0] : NULL );
+  work->LocatedWeights = ( numPts*mcs > 0 ? &weights[0] : NULL );
+}
+
+//----------------------------------------------------------------------------
+// Use tolerance as a function of size of source data
+static double vtkProbeFilterTolerance(vtkDataSet *source, vtkIdType numPts)
+{
+  double tol2 = source->GetLength();
   tol2 = tol2 ? tol2*tol2 / 1000.0 : 0.001;
 
   // the actual sampling rate needs to be considered for a
@@ -256,70 +947,204 @@ void vtkProbeFilter::ProbeEmptyPoints(vtkDataSet *input,
 
   // Don't go below epsilon for a double
   tol2 = (tol2 < VTK_DBL_EPSILON) ? VTK_DBL_EPSILON : tol2;
+  return tol2;
+}
 
-  // Loop over all input points, interpolating source data
-  //
-  int abort=0;
-  vtkIdType progressInterval=numPts/20 + 1;
-  for (ptId=0; ptId < numPts && !abort; ptId++)
+//----------------------------------------------------------------------------
+void vtkProbeFilter::ProbeEmptyPoints(vtkDataSet *input,
+  int srcIdx,
+  vtkDataSet *source, vtkDataSet *output)
+{
+  this->ProbeEmptyPoints(input, srcIdx, &source, 1, output);
+}
+
+//----------------------------------------------------------------------------
+void vtkProbeFilter::ProbeEmptyPoints(vtkDataSet *input,
+  int srcIdx,
+  vtkDataSet **sources, int numSources,
+  vtkDataSet *output)
+{
+  vtkIdType ptId, numPts;
+  vtkPointData *outPD;
+
+  if (this->CellLocator && numSources > 1)
     {
-    if ( !(ptId % progressInterval) )
+    // The locator holds a single dataset: probe the sources one at a time
+    for (int s = 0; s < numSources; s++)
       {
-      this->UpdateProgress(static_cast<double>(ptId)/numPts);
-      abort = GetAbortExecute();
+      this->ProbeEmptyPoints(input, srcIdx + s, sources + s, 1, output);
       }
+    return;
+    }
 
-    if (maskArray[ptId] == static_cast<char>(1))
-      {
-      // skip points which have already been probed with success.
-      // This is helpful for multiblock dataset probing.
-      continue;
-      }
+  vtkDebugMacro(<<"Probing data");
 
-    // Get the xyz coordinate of the point in the input dataset
-    input->GetPoint(ptId, x);
+  numPts = input->GetNumberOfPoints();
+  outPD = output->GetPointData();
+
+  char* maskArray = this->MaskPoints->GetPointer(0);
 
-    // Find the cell that contains xyz and get it
-    vtkIdType cellId = source->FindCell(x,NULL,-1,tol2,subId,pcoords,weights);
-    if (cellId >= 0)
+  if (numPts < 1 || numSources < 1)
+    {
+    return;
+    }
+
+  // The output arrays get all their tuples up front: the points are then
+  // written in place, by whichever thread probes them.
+  int i;
+  for (i = 0; i < outPD->GetNumberOfArrays(); i++)
+    {
+    vtkAbstractArray *array = outPD->GetAbstractArray(i);
+    if (array && array != this->MaskPoints &&
+        array->GetNumberOfTuples() < numPts)
       {
-      cell = source->GetCell(cellId);
+      array->Resize(numPts);
+      array->SetNumberOfTuples(numPts);
       }
-    else
+    }
+
+  vtkProbeFilterWork work;
+  work.Input = input;
+  work.MaxCellSize = 1;
+  work.Mask = maskArray;
+  work.UseNullPoint = this->UseNullPoint;
+  work.LocatedCells = NULL;
+  work.LocatedWeights = NULL;
+
+  // The arrays of each source, and its bounds padded by twice the tolerance
+  // distance so that rounding never excludes a point FindCell() accepts
+  work.Sources.resize(numSources);
+  vtkDataSetAttributes::FieldList &pointList = *this->PointList;
+  int s;
+  for (s = 0; s < numSources; s++)
+    {
+    vtkDataSet *source = sources[s];
+    vtkProbeFilterSource &probed = work.Sources[s];
+    probed.DataSet = source;
+    probed.Tol2 = vtkProbeFilterTolerance(source, numPts);
+    source->GetBounds(probed.Bounds);
+    double pad = 2.0 * sqrt(probed.Tol2);
+    for (i = 0; i < 3; i++)
       {
-      cell = 0;
+      probed.Bounds[2*i] -= pad;
+      probed.Bounds[2*i+1] += pad;
       }
-    if (cell)
+    int maxCellSize = source->GetMaxCellSize();
+    work.MaxCellSize = ( maxCellSize > work.MaxCellSize ?
+                         maxCellSize : work.MaxCellSize );
+
+    vtkPointData *pd = source->GetPointData();
+    vtkCellData *cd = source->GetCellData();
+    for (i = 0; i < pointList.GetNumberOfFields(); i++)
       {
-      // Interpolate the point data
-      outPD->InterpolatePoint((*this->PointList), pd, srcIdx, ptId,
-        cell->PointIds, weights);
-      this->ValidPoints->InsertNextValue(ptId);
-      this->NumberOfValidPoints++;
-      vtkVectorOfArrays::iterator iter;
-      for (iter = this->CellArrays->begin(); iter != this->CellArrays->end();
-        ++iter)
+      if (pointList.GetFieldIndex(i) >= 0 &&
+          pointList.GetDSAIndex(srcIdx + s, i) >= 0)
         {
-        vtkDataArray* inArray = cd->GetArray((*iter)->GetName());
-        if (inArray)
-          {
-          outPD->CopyTuple(inArray, *iter, cellId, ptId);
-          }
+        probed.PointArrays.push_back(vtkProbeFilterMakeArrays(
+          pd->GetAbstractArray(pointList.GetDSAIndex(srcIdx + s, i)),
+          outPD->GetAbstractArray(pointList.GetFieldIndex(i))));
         }
-      maskArray[ptId] = static_cast<char>(1);
       }
-    else
+    vtkVectorOfArrays::iterator iter;
+    for (iter = this->CellArrays->begin(); iter != this->CellArrays->end();
+      ++iter)
       {
-      if (this->UseNullPoint)
+      vtkDataArray* inArray = cd->GetArray((*iter)->GetName());
+      if (inArray)
         {
-        outPD->NullPoint(ptId);
+        probed.CellArrays.push_back(vtkProbeFilterMakeArrays(inArray, *iter));
         }
       }
     }
+  work.Index.Build(work.Sources);
+  for (i = 0; i < outPD->GetNumberOfArrays(); i++)
+    {
+    vtkDataArray *array = outPD->GetArray(i);
+    if (array && array != this->MaskPoints)
+      {
+      work.NullArrays.push_back(vtkProbeFilterMakeArrays(NULL, array));
+      }
+    }
+
+  // Threads need numeric arrays, an input whose points can be read
+  // concurrently, and sources whose cells can be.
+  int numThreads = this->NumberOfThreads;
+  size_t a;
+  for (s = 0; s < numSources; s++)
+    {
+    for (a = 0; a < work.Sources[s].PointArrays.size(); a++)
+      {
+      numThreads = ( work.Sources[s].PointArrays[a].Numeric ? numThreads : 1 );
+      }
+    for (a = 0; a < work.Sources[s].CellArrays.size(); a++)
+      {
+      numThreads = ( work.Sources[s].CellArrays[a].Numeric ? numThreads : 1 );
+      }
+    }
+  for (a = 0; a < work.NullArrays.size(); a++)
+    {
+    numThreads = ( work.NullArrays[a].Numeric ? numThreads : 1 );
+    }
+  if (!input->IsA("vtkPointSet") && !input->IsA("vtkImageData") &&
+      !input->IsA("vtkRectilinearGrid"))
+    {
+    numThreads = 1;
+    }
+  for (s = 0; s < numSources && numThreads > 1; s++)
+    {
+    if (!vtkProbeFilterPrepareConcurrentSource(sources[s], !this->CellLocator))
+      {
+      numThreads = 1;
+      }
+    }
+
+  if (this->CellLocator)
+    {
+    this->CellLocator->SetDataSet(sources[0]);
+    this->CellLocator->Update();
+    }
+  std::vector<vtkIdType> locatedCells;
+  std::vector<double> locatedWeights;
 
-  if (mcs>256)
+  // Loop over blocks of input points, interpolating source data
+  //
+  vtkIdType blockSize = static_cast<vtkIdType>(VTK_PROBE_BATCH_SIZE) *
+    VTK_PROBE_BATCHES_PER_BLOCK * numThreads;
+  for (vtkIdType blockBegin = 0; blockBegin < numPts; blockBegin += blockSize)
     {
-    delete [] weights;
+    this->UpdateProgress(static_cast<double>(blockBegin)/numPts);
+    if (this->GetAbortExecute())
+      {
+      break;
+      }
+
+    work.BlockBegin = blockBegin;
+    work.BlockEnd = ( numPts - blockBegin > blockSize ?
+                      blockBegin + blockSize : numPts );
+    if (this->CellLocator)
+      {
+      vtkProbeFilterLocateBlock(this->CellLocator, &work, locatedCells,
+                                locatedWeights);
+      }
+
+    vtkIdType numBatches = (work.BlockEnd - work.BlockBegin +
+                            VTK_PROBE_BATCH_SIZE - 1) / VTK_PROBE_BATCH_SIZE;
+    work.NumberOfThreads = ( numThreads > numBatches ?
+                             static_cast<int>(numBatches) : numThreads );
+    this->Threader->SetNumberOfThreads(work.NumberOfThreads);
+    this->Threader->SetSingleMethod(vtkProbeFilterProbeExecute, &work);
+    this->Threader->SingleMethodExecute();
+
+    // Record the points found, in order
+    for (ptId = work.BlockBegin; ptId < work.BlockEnd; ptId++)
+      {
+      if (maskArray[ptId] == static_cast<char>(2))
+        {
+        maskArray[ptId] = static_cast<char>(1);
+        this->ValidPoints->InsertNextValue(ptId);
+        this->NumberOfValidPoints++;
+        }
+      }
     }
 }
 
@@ -514,4 +1339,6 @@ void vtkProbeFilter::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "ValidPointMaskArrayName: " << (this->ValidPointMaskArrayName?
     this->ValidPointMaskArrayName : "vtkValidPointMask") << "\n";
   os << indent << "ValidPoints: " << this->ValidPoints << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+  os << indent << "CellLocator: " << this->CellLocator << "\n";
 }
@@ -31,6 +31,11 @@
 // rendering techniques can be used to visualize the results. Another example:
 // a line or curve can be used to probe data to produce x-y plots along
 // that line or curve.
+//
+// The probe points are processed in fixed-size batches distributed over
+// several threads. Each batch locates its points starting from the cell of
+// the previous point, then interpolates every array over the whole batch,
+// so the output does not depend on the number of threads.
 
 #ifndef __vtkProbeFilter_h
 #define __vtkProbeFilter_h
@@ -39,9 +44,11 @@
 #include "vtkDataSetAlgorithm.h"
 #include "vtkDataSetAttributes.h" // needed for vtkDataSetAttributes::FieldList
 
+class vtkAbstractCellLocator;
 class vtkIdTypeArray;
 class vtkCharArray;
 class vtkMaskPoints;
+class vtkMultiThreader;
 
 class VTKFILTERSCORE_EXPORT vtkProbeFilter : public vtkDataSetAlgorithm
 {
@@ -86,12 +93,36 @@ public:
   vtkSetStringMacro(ValidPointMaskArrayName)
   vtkGetStringMacro(ValidPointMaskArrayName)
 
+  // Description:
+  // Set/Get the number of threads used to probe the points. Threads are
+  // used when the source is a vtkImageData, a vtkPolyData or a
+  // vtkUnstructuredGrid and all probed arrays are numeric. Defaults to the
+  // number of available processors.
+  vtkSetClampMacro(NumberOfThreads, int, 1, VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads, int);
+
+  // Description:
+  // Set/Get a cell locator used to find the source cells containing the
+  // probe points. The locator is given the source, rebuilt when needed, and
+  // queried with its batch FindCells() for every block of points. By
+  // default no locator is set and the cells are found with the FindCell()
+  // method of the source.
+  virtual void SetCellLocator(vtkAbstractCellLocator*);
+  vtkGetObjectMacro(CellLocator, vtkAbstractCellLocator);
+
+  // Description:
+  // Take the cell locator into account in the modified time.
+  unsigned long GetMTime();
+
 //BTX
 protected:
   vtkProbeFilter();
   ~vtkProbeFilter();
 
   int SpatialMatch;
+  int NumberOfThreads;
+  vtkAbstractCellLocator *CellLocator;
+  vtkMultiThreader *Threader;
 
   virtual int RequestData(vtkInformation *, vtkInformationVector **,
     vtkInformationVector *);
@@ -120,6 +151,15 @@ protected:
   void ProbeEmptyPoints(vtkDataSet *input, int srcIdx, vtkDataSet *source,
     vtkDataSet *output);
 
+  // Description:
+  // Probe the points not probed yet into several sources at once, such as
+  // the blocks of a composite dataset. A point takes the values of the first
+  // source that contains it, and is only searched in the sources whose
+  // bounds contain it. The sources are at srcIdx to srcIdx+numSources-1 in
+  // the PointList. With a CellLocator, they are probed one after the other.
+  void ProbeEmptyPoints(vtkDataSet *input, int srcIdx, vtkDataSet **sources,
+    int numSources, vtkDataSet *output);
+
   char* ValidPointMaskArrayName;
   vtkIdTypeArray *ValidPoints;
   vtkCharArray* MaskPoints;
@@ -0,0 +1,203 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    vtkSpatialPointOrdering.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkSpatialPointOrdering.h"
+
+#include "vtkMinimalStandardRandomSequence.h"
+#include "vtkPoints.h"
+
+#include <algorithm>
+#include <vector>
+
+// Number of bits per coordinate used to quantize points onto the curve.
+#define VTK_BRIO_BITS 21
+
+// Maximum number of BRIO rounds. Each round is (roughly) twice the size of
+// the previous one, so this is plenty for any practical number of points.
+#define VTK_BRIO_MAX_ROUNDS 32
+
+namespace
+{
+// Sort record: the round a point is inserted in, and its curve position.
+struct vtkBRIOEntry
+{
+  int Round;
+  vtkTypeUInt64 Key;
+  vtkIdType Id;
+};
+
+// Smaller rounds are inserted first. Within a round the direction of the
+// curve alternates so that the end of one round is close to the start of
+// the next one.
+bool vtkBRIOLess(const vtkBRIOEntry& a, const vtkBRIOEntry& b)
+{
+  if ( a.Round != b.Round )
+    {
+    return a.Round > b.Round;
+    }
+  if ( a.Key != b.Key )
+    {
+    return ( (a.Round % 2) ? (a.Key > b.Key) : (a.Key < b.Key) );
+    }
+  return a.Id < b.Id;
+}
+}
+
+//----------------------------------------------------------------------------
+// Uses Skilling's transposition algorithm ("Programming the Hilbert curve",
+// AIP Conf. Proc. 707, 2004) followed by bit interleaving.
+vtkTypeUInt64 vtkSpatialPointOrdering::HilbertKey(unsigned int x[3],
+                                                  int dimension, int bits)
+{
+  unsigned int m = 1u << (bits-1), p, q, t;
+  int i;
+
+  // Inverse undo
+  for ( q=m; q > 1; q >>= 1 )
+    {
+    p = q - 1;
+    for ( i=0; i < dimension; i++ )
+      {
+      if ( x[i] & q )
+        {
+        x[0] ^= p; //invert
+        }
+      else
+        {
+        t = (x[0] ^ x[i]) & p; //exchange
+        x[0] ^= t;
+        x[i] ^= t;
+        }
+      }
+    }
+
+  // Gray encode
+  for ( i=1; i < dimension; i++ )
+    {
+    x[i] ^= x[i-1];
+    }
+  t = 0;
+  for ( q=m; q > 1; q >>= 1 )
+    {
+    if ( x[dimension-1] & q )
+      {
+      t ^= q - 1;
+      }
+    }
+  for ( i=0; i < dimension; i++ )
+    {
+    x[i] ^= t;
+    }
+
+  // Interleave the transposed bits into a single key
+  vtkTypeUInt64 key = 0;
+  for ( int b=bits-1; b >= 0; b-- )
+    {
+    for ( i=0; i < dimension; i++ )
+      {
+      key = (key << 1) | ((x[i] >> b) & 1u);
+      }
+    }
+  return key;
+}
+
+//----------------------------------------------------------------------------
+void vtkSpatialPointOrdering::BRIO(vtkPoints *points, vtkIdType numPts,
+                                   int dimension, vtkIdType *order)
+{
+  vtkIdType ptId;
+  double x[3], bounds[6], scale[3];
+  unsigned int ix[3];
+  int i;
+
+  if ( numPts <= 0 )
+    {
+    return;
+    }
+  dimension = ( dimension == 2 ? 2 : 3 );
+
+  // Bounds of the points being ordered (points past numPts, e.g. those of a
+  // bounding triangulation, are ignored).
+  points->GetPoint(0, x);
+  for ( i=0; i < 3; i++ )
+    {
+    bounds[2*i] = bounds[2*i+1] = x[i];
+    }
+  for ( ptId=1; ptId < numPts; ptId++ )
+    {
+    points->GetPoint(ptId, x);
+    for ( i=0; i < 3; i++ )
+      {
+      bounds[2*i] = ( x[i] < bounds[2*i] ? x[i] : bounds[2*i] );
+      bounds[2*i+1] = ( x[i] > bounds[2*i+1] ? x[i] : bounds[2*i+1] );
+      }
+    }
+
+  // Quantize with the same scale along all axes so that the curve does not
+  // get stretched along the thin directions of the bounding box.
+  double maxLength = 0.0;
+  for ( i=0; i < dimension; i++ )
+    {
+    maxLength = ( (bounds[2*i+1] - bounds[2*i]) > maxLength ?
+                  (bounds[2*i+1] - bounds[2*i]) : maxLength );
+    }
+  const double maxCoord = static_cast<double>((1u << VTK_BRIO_BITS) - 1);
+  for ( i=0; i < 3; i++ )
+    {
+    scale[i] = ( maxLength > 0.0 ? maxCoord / maxLength : 0.0 );
+    }
+
+  // Assign each point to a round. A point lands in the last (largest)
+  // round with probability 1/2, in the one before with probability 1/4,
+  // and so on. A fixed seed keeps the output reproducible.
+  vtkMinimalStandardRandomSequence *random =
+    vtkMinimalStandardRandomSequence::New();
+  random->SetSeed(1);
+
+  std::vector<vtkBRIOEntry> entries(numPts);
+  for ( ptId=0; ptId < numPts; ptId++ )
+    {
+    points->GetPoint(ptId, x);
+    for ( i=0; i < 3; i++ )
+      {
+      double c = (x[i] - bounds[2*i]) * scale[i];
+      c = ( c < 0.0 ? 0.0 : (c > maxCoord ? maxCoord : c) );
+      ix[i] = static_cast<unsigned int>(c);
+      }
+
+    int round = 0;
+    random->Next();
+    while ( round < VTK_BRIO_MAX_ROUNDS && random->GetValue() < 0.5 )
+      {
+      round++;
+      random->Next();
+      }
+
+    entries[ptId].Round = round;
+    entries[ptId].Key = vtkSpatialPointOrdering::HilbertKey(ix, dimension,
+                                                            VTK_BRIO_BITS);
+    entries[ptId].Id = ptId;
+    }
+  random->Delete();
+
+  std::sort(entries.begin(), entries.end(), vtkBRIOLess);
+
+  for ( ptId=0; ptId < numPts; ptId++ )
+    {
+    order[ptId] = entries[ptId].Id;
+    }
+}
+
+#undef VTK_BRIO_BITS
+#undef VTK_BRIO_MAX_ROUNDS
@@ -0,0 +1,57 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    vtkSpatialPointOrdering.h
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// .NAME vtkSpatialPointOrdering - compute spatially coherent point orderings
+// .SECTION Description
+// vtkSpatialPointOrdering is a small utility class used by incremental
+// algorithms (e.g., vtkDelaunay2D and vtkDelaunay3D) to reorder their
+// input points before insertion. The ordering is a biased randomized
+// insertion order (BRIO): points are randomly distributed over a sequence
+// of rounds of (roughly) doubling size, and the points of each round are
+// sorted along a Hilbert space-filling curve. Consecutive points are thus
+// close to one another, which keeps point location walks short, while the
+// randomization retains the expected complexity of randomized incremental
+// construction. The ordering is deterministic for a given input.
+// .SECTION See Also
+// vtkDelaunay2D vtkDelaunay3D
+
+#ifndef __vtkSpatialPointOrdering_h
+#define __vtkSpatialPointOrdering_h
+
+#include "vtkType.h" //for vtkIdType
+
+class vtkPoints;
+
+class vtkSpatialPointOrdering
+{
+public:
+  // Description:
+  // Compute a biased randomized insertion order of the first numPts points
+  // of the points provided. The dimension (2 or 3) controls whether the
+  // z-coordinate is considered; with dimension 2 the points are ordered in
+  // the x-y plane. On return, order[0...numPts-1] is a permutation of the
+  // point ids 0...numPts-1.
+  static void BRIO(vtkPoints *points, vtkIdType numPts, int dimension,
+                   vtkIdType *order);
+
+  // Description:
+  // Compute the Hilbert key of the integer coordinates x (dimension 2 or 3,
+  // each coordinate using the given number of bits). The keys of the cells
+  // of a regular grid follow the Hilbert curve through the grid.
+  static vtkTypeUInt64 HilbertKey(unsigned int x[3], int dimension,
+                                  int bits);
+};
+
+#endif
+// VTK-HeaderTest-Exclude: vtkSpatialPointOrdering.h
@@ -19,6 +19,7 @@
 #include "vtkCell.h"
 #include "vtkCellArray.h"
 #include "vtkDataSet.h"
+#include "vtkDoubleArray.h"
 #include "vtkExecutive.h"
 #include "vtkFloatArray.h"
 #include "vtkMath.h"
@@ -46,6 +47,7 @@ vtkTensorGlyph::vtkTensorGlyph()
   this->ThreeGlyphs = 0;
   this->Symmetric = 0;
   this->Length = 1.0;
+  this->OutputInstances = 0;
 
   this->SetNumberOfInputPorts(2);
 
@@ -125,6 +127,9 @@ int vtkTensorGlyph::RequestData(
   vtkPoints *newPts;
   vtkFloatArray *newScalars=NULL;
   vtkFloatArray *newNormals=NULL;
+  vtkDoubleArray *newTransforms=NULL;
+  vtkCellArray *newVerts=NULL;
+  vtkIdType glyphId;
   double x[3], s;
   vtkTransform *trans;
   vtkCell *cell;
@@ -172,32 +177,52 @@ int vtkTensorGlyph::RequestData(
   numSourcePts = sourcePts->GetNumberOfPoints();
   numSourceCells = source->GetNumberOfCells();
 
+  // The instance table has one point (and vertex) per glyph, and no source
+  // attributes.
+  if ( this->OutputInstances )
+    {
+    numSourcePts = 1;
+    numSourceCells = 0;
+    newVerts = vtkCellArray::New();
+    newVerts->Allocate(2*numDirs*numPts);
+    output->SetVerts(newVerts);
+    newVerts->Delete();
+    newTransforms = vtkDoubleArray::New();
+    newTransforms->SetNumberOfComponents(16);
+    newTransforms->Allocate(16*numDirs*numPts);
+    newTransforms->SetName("GlyphTransform");
+    }
+
   newPts = vtkPoints::New();
   newPts->Allocate(numDirs*numPts*numSourcePts);
 
   // Setting up for calls to PolyData::InsertNextCell()
-  if ( (sourceCells=source->GetVerts())->GetNumberOfCells() > 0 )
+  if ( !this->OutputInstances &&
+       (sourceCells=source->GetVerts())->GetNumberOfCells() > 0 )
     {
     cells = vtkCellArray::New();
     cells->Allocate(numDirs*numPts*sourceCells->GetSize());
     output->SetVerts(cells);
     cells->Delete();
     }
-  if ( (sourceCells=this->GetSource()->GetLines())->GetNumberOfCells() > 0 )
+  if ( !this->OutputInstances &&
+       (sourceCells=this->GetSource()->GetLines())->GetNumberOfCells() > 0 )
     {
     cells = vtkCellArray::New();
     cells->Allocate(numDirs*numPts*sourceCells->GetSize());
     output->SetLines(cells);
     cells->Delete();
     }
-  if ( (sourceCells=this->GetSource()->GetPolys())->GetNumberOfCells() > 0 )
+  if ( !this->OutputInstances &&
+       (sourceCells=this->GetSource()->GetPolys())->GetNumberOfCells() > 0 )
     {
     cells = vtkCellArray::New();
     cells->Allocate(numDirs*numPts*sourceCells->GetSize());
     output->SetPolys(cells);
     cells->Delete();
     }
-  if ( (sourceCells=this->GetSource()->GetStrips())->GetNumberOfCells() > 0 )
+  if ( !this->OutputInstances &&
+       (sourceCells=this->GetSource()->GetStrips())->GetNumberOfCells() > 0 )
     {
     cells = vtkCellArray::New();
     cells->Allocate(numDirs*numPts*sourceCells->GetSize());
@@ -223,13 +248,13 @@ int vtkTensorGlyph::RequestData(
       newScalars->SetName(inScalars->GetName());
       }
     }
-  else
+  else if ( !this->OutputInstances )
     {
     outPD->CopyAllOff();
     outPD->CopyScalarsOn();
     outPD->CopyAllocate(pd,numDirs*numPts*numSourcePts);
     }
-  if ( (sourceNormals = pd->GetNormals()) )
+  if ( (sourceNormals = pd->GetNormals()) && !this->OutputInstances )
     {
     newNormals = vtkFloatArray::New();
     newNormals->SetNumberOfComponents(3);
@@ -409,6 +434,21 @@ int vtkTensorGlyph::RequestData(
         trans->Translate(-this->Length, 0., 0.);
         }
 
+      // Keep the glyph transformation and color in the instance table
+      if ( this->OutputInstances )
+        {
+        glyphId = newPts->InsertNextPoint(x);
+        newVerts->InsertNextCell(1, &glyphId);
+        newTransforms->InsertNextTuple(*trans->GetMatrix()->Element);
+        if ( newScalars )
+          {
+          s = ( this->ColorMode == COLOR_BY_SCALARS ?
+                inScalars->GetComponent(inPtId, 0) : w[eigen_dir] );
+          newScalars->InsertNextTuple(&s);
+          }
+        continue;
+        }
+
       // multiply points (and normals if available) by resulting
       // matrix
       trans->TransformPoints(sourcePts,newPts);
@@ -481,6 +521,12 @@ int vtkTensorGlyph::RequestData(
     newNormals->Delete();
     }
 
+  if ( newTransforms )
+    {
+    outPD->AddArray(newTransforms);
+    newTransforms->Delete();
+    }
+
   output->Squeeze();
   trans->Delete();
   matrix->Delete();
@@ -558,4 +604,6 @@ void vtkTensorGlyph::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "Three Glyphs: " << (this->ThreeGlyphs ? "On\n" : "Off\n");
   os << indent << "Symmetric: " << (this->Symmetric ? "On\n" : "Off\n");
   os << indent << "Length: " << this->Length << "\n";
+  os << indent << "Output Instances: "
+     << (this->OutputInstances ? "On\n" : "Off\n");
 }
@@ -59,6 +59,12 @@
 // (SetColorModeToScalars), which is the default, or colored using the
 // eigenvalues (SetColorModeToEigenvalues).
 //
+// With OutputInstances on, the source is not replicated: the output is an
+// instance table with one point and vertex per glyph, and the 4x4
+// transformation of each glyph stored in the "GlyphTransform" point data
+// array. The table can be rendered with vtkGlyph3DMapper (orientation mode
+// MATRIX, scaling off).
+//
 // Another instance variable, ExtractEigenvalues, has been provided to
 // control extraction of eigenvalues/eigenvectors. If this boolean is
 // false, then eigenvalues/eigenvectors are not extracted, and the
@@ -191,6 +197,17 @@ public:
   vtkSetMacro(MaxScaleFactor,double);
   vtkGetMacro(MaxScaleFactor,double);
 
+  // Description:
+  // Enable/disable the generation of an instance table instead of the
+  // glyph geometry. The output then has one point per glyph, located at the
+  // input point, and one vertex per point. The point data holds the
+  // "GlyphTransform" array (16 components: the 4x4 matrix, in row-major
+  // order, that maps the source to the glyph) and the scalars used to color
+  // the glyph, if any. Off by default.
+  vtkSetMacro(OutputInstances,int);
+  vtkGetMacro(OutputInstances,int);
+  vtkBooleanMacro(OutputInstances,int);
+
 protected:
   vtkTensorGlyph();
   ~vtkTensorGlyph();
@@ -209,6 +226,7 @@ protected:
   int ThreeGlyphs; // Boolean controls drawing 1 or 3 glyphs
   int Symmetric; // Boolean controls drawing a "mirror" of each glyph
   double Length; // Distance, in x, from the origin to the end of the glyph
+  int OutputInstances; // generate an instance table instead of geometry
 private:
   vtkTensorGlyph(const vtkTensorGlyph&);  // Not implemented.
   void operator=(const vtkTensorGlyph&);  // Not implemented.
@@ -0,0 +1,192 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestCellLocatorsThreadedBuild.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// This tests that vtkCellTreeLocator and vtkModifiedBSPTree build the same
+// tree whatever the number of threads, and that the trees locate points
+// correctly.
+
+#include <vtkCellArray.h>
+#include <vtkCellTreeLocator.h>
+#include <vtkDataSetTriangleFilter.h>
+#include <vtkIdList.h>
+#include <vtkIdListCollection.h>
+#include <vtkImageData.h>
+#include <vtkIntArray.h>
+#include <vtkMinimalStandardRandomSequence.h>
+#include <vtkModifiedBSPTree.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkUnstructuredGrid.h>
+
+// vtkCellTreeLocator adds the boxes to the given points, lines and array
+static vtkSmartPointer<vtkPolyData> NewRepresentation()
+{
+  vtkSmartPointer<vtkPolyData> pd = vtkSmartPointer<vtkPolyData>::New();
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
+  vtkSmartPointer<vtkIntArray> levels = vtkSmartPointer<vtkIntArray>::New();
+  pd->SetPoints(points);
+  pd->SetLines(lines);
+  pd->GetPointData()->AddArray(levels);
+  return pd;
+}
+
+static bool SameRepresentation(vtkAbstractCellLocator *a,
+                               vtkAbstractCellLocator *b)
+{
+  vtkSmartPointer<vtkPolyData> pa = NewRepresentation();
+  vtkSmartPointer<vtkPolyData> pb = NewRepresentation();
+  a->GenerateRepresentation(-1, pa);
+  b->GenerateRepresentation(-1, pb);
+  if (pa->GetNumberOfPoints() == 0 ||
+      pa->GetNumberOfPoints() != pb->GetNumberOfPoints())
+    {
+    return false;
+    }
+  for (vtkIdType i = 0; i < pa->GetNumberOfPoints(); ++i)
+    {
+    double xa[3], xb[3];
+    pa->GetPoint(i, xa);
+    pb->GetPoint(i, xb);
+    if (xa[0] != xb[0] || xa[1] != xb[1] || xa[2] != xb[2])
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+static bool SameCells(vtkAbstractCellLocator *a, vtkAbstractCellLocator *b,
+                      vtkImageData *image, vtkPoints *points)
+{
+  for (vtkIdType i = 0; i < points->GetNumberOfPoints(); ++i)
+    {
+    double x[3];
+    points->GetPoint(i, x);
+    vtkIdType cellA = a->FindCell(x);
+    vtkIdType cellB = b->FindCell(x);
+    bool inside = (image->FindPoint(x) >= 0 &&
+                   x[0] >= 0.0 && x[0] <= 1.0 && x[1] >= 0.0 &&
+                   x[1] <= 1.0 && x[2] >= 0.0 && x[2] <= 1.0);
+    if (cellA != cellB || (cellA >= 0) != inside)
+      {
+      std::cerr << "Error: " << a->GetClassName() << " located point " << i
+                << " in cell " << cellA << " and " << cellB << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+int TestCellLocatorsThreadedBuild(int, char*[])
+{
+  // A tetrahedral mesh of the unit cube
+  vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+  image->SetDimensions(21, 21, 21);
+  image->SetSpacing(0.05, 0.05, 0.05);
+  vtkSmartPointer<vtkDataSetTriangleFilter> tetrahedralize =
+    vtkSmartPointer<vtkDataSetTriangleFilter>::New();
+  tetrahedralize->SetInputData(image);
+  tetrahedralize->Update();
+  vtkUnstructuredGrid *grid = tetrahedralize->GetOutput();
+
+  vtkSmartPointer<vtkMinimalStandardRandomSequence> random =
+    vtkSmartPointer<vtkMinimalStandardRandomSequence>::New();
+  random->SetSeed(2718);
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  for (int i = 0; i < 2000; ++i)
+    {
+    double x[3];
+    for (int j = 0; j < 3; ++j)
+      {
+      random->Next();
+      x[j] = random->GetRangeValue(-0.1, 1.1);
+      }
+    points->InsertNextPoint(x);
+    }
+
+  // vtkCellTreeLocator, with and without cached cell bounds
+  for (int cache = 0; cache < 2; ++cache)
+    {
+    vtkSmartPointer<vtkCellTreeLocator> serial =
+      vtkSmartPointer<vtkCellTreeLocator>::New();
+    serial->SetDataSet(grid);
+    serial->SetCacheCellBounds(cache);
+    serial->SetNumberOfThreads(1);
+    serial->BuildLocator();
+
+    vtkSmartPointer<vtkCellTreeLocator> threaded =
+      vtkSmartPointer<vtkCellTreeLocator>::New();
+    threaded->SetDataSet(grid);
+    threaded->SetCacheCellBounds(cache);
+    threaded->SetNumberOfThreads(4);
+    threaded->BuildLocator();
+
+    if (!SameRepresentation(serial, threaded))
+      {
+      std::cerr << "Error: the cell trees differ with 4 threads" << std::endl;
+      return EXIT_FAILURE;
+      }
+    if (!SameCells(serial, threaded, image, points))
+      {
+      return EXIT_FAILURE;
+      }
+    }
+
+  // vtkModifiedBSPTree
+  vtkSmartPointer<vtkModifiedBSPTree> serial =
+    vtkSmartPointer<vtkModifiedBSPTree>::New();
+  serial->SetDataSet(grid);
+  serial->SetNumberOfThreads(1);
+  serial->LazyEvaluationOff();
+  serial->BuildLocator();
+
+  vtkSmartPointer<vtkModifiedBSPTree> threaded =
+    vtkSmartPointer<vtkModifiedBSPTree>::New();
+  threaded->SetDataSet(grid);
+  threaded->SetNumberOfThreads(4);
+  threaded->LazyEvaluationOff();
+  threaded->BuildLocator();
+
+  vtkSmartPointer<vtkIdListCollection> serialLeaves;
+  serialLeaves.TakeReference(serial->GetLeafNodeCellInformation());
+  vtkSmartPointer<vtkIdListCollection> threadedLeaves;
+  threadedLeaves.TakeReference(threaded->GetLeafNodeCellInformation());
+  if (serialLeaves->GetNumberOfItems() < 2 ||
+      serial->GetLevel() != threaded->GetLevel() ||
+      !SameRepresentation(serial, threaded))
+    {
+    std::cerr << "Error: the BSP trees differ with 4 threads" << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkIdType numIds = 0;
+  for (int i = 0; i < serialLeaves->GetNumberOfItems(); ++i)
+    {
+    numIds += serialLeaves->GetItem(i)->GetNumberOfIds();
+    }
+  if (numIds < grid->GetNumberOfCells())
+    {
+    std::cerr << "Error: the BSP tree leaves hold " << numIds << " of "
+              << grid->GetNumberOfCells() << " cells" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!SameCells(serial, threaded, image, points))
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
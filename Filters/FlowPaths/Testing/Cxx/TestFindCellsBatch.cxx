@@ -0,0 +1,144 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestFindCellsBatch.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// This tests that vtkAbstractCellLocator::FindCells() gives the same cells,
+// parametric coordinates and weights as FindCell() called point by point,
+// for vtkCellLocator, vtkCellTreeLocator and vtkModifiedBSPTree, whatever
+// the number of threads.
+
+#include <vtkCellLocator.h>
+#include <vtkCellTreeLocator.h>
+#include <vtkDataSetTriangleFilter.h>
+#include <vtkDoubleArray.h>
+#include <vtkGenericCell.h>
+#include <vtkIdList.h>
+#include <vtkImageData.h>
+#include <vtkMinimalStandardRandomSequence.h>
+#include <vtkModifiedBSPTree.h>
+#include <vtkPoints.h>
+#include <vtkSmartPointer.h>
+#include <vtkUnstructuredGrid.h>
+
+#include <vector>
+
+static bool TestLocator(vtkAbstractCellLocator *locator, vtkDataSet *input,
+                        vtkPoints *points)
+{
+  locator->SetDataSet(input);
+  locator->BuildLocator();
+
+  // Reference: one point at a time
+  vtkIdType numPts = points->GetNumberOfPoints();
+  int numWeights = input->GetMaxCellSize();
+  std::vector<vtkIdType> cellIds(numPts);
+  std::vector<double> pcoords(3*numPts), weights(numWeights*numPts, 0.0);
+  vtkSmartPointer<vtkGenericCell> cell = vtkSmartPointer<vtkGenericCell>::New();
+  vtkIdType numFound = 0;
+  for (vtkIdType i = 0; i < numPts; ++i)
+    {
+    double x[3];
+    points->GetPoint(i, x);
+    cellIds[i] = locator->FindCell(x, 0.0, cell, &pcoords[3*i],
+                                   &weights[numWeights*i]);
+    numFound += (cellIds[i] >= 0 ? 1 : 0);
+    }
+  if (numFound == 0 || numFound == numPts)
+    {
+    std::cerr << "Error: " << locator->GetClassName() << " found " << numFound
+              << " points inside" << std::endl;
+    return false;
+    }
+
+  for (int numThreads = 1; numThreads <= 4; numThreads += 3)
+    {
+    locator->SetNumberOfThreads(numThreads);
+    vtkSmartPointer<vtkIdList> ids = vtkSmartPointer<vtkIdList>::New();
+    vtkSmartPointer<vtkDoubleArray> p = vtkSmartPointer<vtkDoubleArray>::New();
+    vtkSmartPointer<vtkDoubleArray> w = vtkSmartPointer<vtkDoubleArray>::New();
+    locator->FindCells(points, ids, p, w);
+
+    if (ids->GetNumberOfIds() != numPts ||
+        w->GetNumberOfComponents() != numWeights)
+      {
+      std::cerr << "Error: " << locator->GetClassName()
+                << " returned arrays of the wrong size" << std::endl;
+      return false;
+      }
+    for (vtkIdType i = 0; i < numPts; ++i)
+      {
+      bool same = (ids->GetId(i) == cellIds[i]);
+      for (int j = 0; same && cellIds[i] >= 0 && j < 3; ++j)
+        {
+        same = (p->GetComponent(i, j) == pcoords[3*i+j]);
+        }
+      for (int j = 0; same && cellIds[i] >= 0 && j < numWeights; ++j)
+        {
+        same = (w->GetComponent(i, j) == weights[numWeights*i+j]);
+        }
+      if (!same)
+        {
+        std::cerr << "Error: " << locator->GetClassName() << " with "
+                  << numThreads << " thread(s) located point " << i
+                  << " in cell " << ids->GetId(i) << " instead of "
+                  << cellIds[i] << std::endl;
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+int TestFindCellsBatch(int, char*[])
+{
+  // A tetrahedral mesh of the unit cube
+  vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+  image->SetDimensions(11, 11, 11);
+  image->SetSpacing(0.1, 0.1, 0.1);
+  vtkSmartPointer<vtkDataSetTriangleFilter> tetrahedralize =
+    vtkSmartPointer<vtkDataSetTriangleFilter>::New();
+  tetrahedralize->SetInputData(image);
+  tetrahedralize->Update();
+  vtkUnstructuredGrid *grid = tetrahedralize->GetOutput();
+
+  // Random points, some of them outside of the cube
+  vtkSmartPointer<vtkMinimalStandardRandomSequence> random =
+    vtkSmartPointer<vtkMinimalStandardRandomSequence>::New();
+  random->SetSeed(1177);
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  for (int i = 0; i < 5000; ++i)
+    {
+    double x[3];
+    for (int j = 0; j < 3; ++j)
+      {
+      random->Next();
+      x[j] = random->GetRangeValue(-0.1, 1.1);
+      }
+    points->InsertNextPoint(x);
+    }
+
+  vtkSmartPointer<vtkCellLocator> cellLocator =
+    vtkSmartPointer<vtkCellLocator>::New();
+  vtkSmartPointer<vtkCellTreeLocator> cellTreeLocator =
+    vtkSmartPointer<vtkCellTreeLocator>::New();
+  vtkSmartPointer<vtkModifiedBSPTree> bspTree =
+    vtkSmartPointer<vtkModifiedBSPTree>::New();
+  if (!TestLocator(cellLocator, grid, points) ||
+      !TestLocator(cellTreeLocator, grid, points) ||
+      !TestLocator(bspTree, grid, points))
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,183 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestInterpolatedVelocityFieldBlocks.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// This tests that vtkInterpolatedVelocityField and
+// vtkCellLocatorInterpolatedVelocityField interpolate a linear field over
+// blocks of tetrahedra and images, along a path going back and forth
+// between the blocks and out of them, and that the cell locator field finds
+// most cells among the neighbors of the previous one.
+
+#include <vtkCellLocatorInterpolatedVelocityField.h>
+#include <vtkDataSetTriangleFilter.h>
+#include <vtkDoubleArray.h>
+#include <vtkImageData.h>
+#include <vtkInterpolatedVelocityField.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+#include <vtkUnstructuredGrid.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+static void LinearField(const double x[3], double f[3])
+{
+  f[0] = x[0] + 2.0*x[1];
+  f[1] = x[1] - x[2];
+  f[2] = 0.5 + x[0] - x[2];
+}
+
+// The block of the octant of [-1,1]^3 given by the bits of b, as tetrahedra
+// but for the last octant
+static vtkSmartPointer<vtkDataSet> MakeBlock(int b)
+{
+  vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+  image->SetOrigin((b & 1) - 1.0, ((b >> 1) & 1) - 1.0, ((b >> 2) & 1) - 1.0);
+  image->SetSpacing(0.1, 0.1, 0.1);
+  image->SetDimensions(11, 11, 11);
+  vtkSmartPointer<vtkDoubleArray> velocity =
+    vtkSmartPointer<vtkDoubleArray>::New();
+  velocity->SetName("Velocity");
+  velocity->SetNumberOfComponents(3);
+  for (vtkIdType i = 0; i < image->GetNumberOfPoints(); ++i)
+    {
+    double f[3];
+    LinearField(image->GetPoint(i), f);
+    velocity->InsertNextTuple(f);
+    }
+  image->GetPointData()->SetVectors(velocity);
+  if (b == 7)
+    {
+    return image;
+    }
+
+  vtkSmartPointer<vtkDataSetTriangleFilter> tetra =
+    vtkSmartPointer<vtkDataSetTriangleFilter>::New();
+  tetra->SetInputData(image);
+  tetra->Update();
+  return tetra->GetOutput();
+}
+
+static bool TestField(vtkCompositeInterpolatedVelocityField *field,
+                      const std::vector<double> &path)
+{
+  field->SelectVectors(vtkDataObject::FIELD_ASSOCIATION_POINTS, "Velocity");
+  field->SetLastCellId(-1, 0);
+
+  int numInside = 0, numOutside = 0;
+  for (size_t p = 0; p < path.size(); p += 3)
+    {
+    double x[4] = { path[p], path[p+1], path[p+2], 0.0 }, f[3], expected[3];
+    int valid = field->FunctionValues(x, f);
+
+    // The points close to the boundary of the domain may go either way
+    double distance = 1.0 - std::fabs(x[0]);
+    for (int i = 1; i < 3; ++i)
+      {
+      distance = std::min(distance, 1.0 - std::fabs(x[i]));
+      }
+    if (std::fabs(distance) < 1e-3)
+      {
+      continue;
+      }
+    if ((distance > 0) != (valid != 0))
+      {
+      std::cerr << "Error: " << field->GetClassName() << " finds point "
+                << p / 3 << " " << (valid ? "inside" : "outside") << std::endl;
+      return false;
+      }
+    if (!valid)
+      {
+      numOutside++;
+      continue;
+      }
+    numInside++;
+
+    LinearField(x, expected);
+    for (int i = 0; i < 3; ++i)
+      {
+      if (std::fabs(f[i] - expected[i]) > 1e-5)
+        {
+        std::cerr << "Error: " << field->GetClassName() << " interpolates "
+                  << f[0] << " " << f[1] << " " << f[2] << " at point "
+                  << p / 3 << " instead of " << expected[0] << " "
+                  << expected[1] << " " << expected[2] << std::endl;
+        return false;
+        }
+      }
+    }
+
+  if (numInside < 100 || numOutside < 10)
+    {
+    std::cerr << "Error: the path has " << numInside << " points inside and "
+              << numOutside << " points outside" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+int TestInterpolatedVelocityFieldBlocks(int, char*[])
+{
+  std::vector<vtkSmartPointer<vtkDataSet> > blocks;
+  for (int b = 0; b < 8; ++b)
+    {
+    blocks.push_back(MakeBlock(b));
+    }
+
+  // A spiral around the z axis, in small steps going back and forth across
+  // the blocks, with a radius growing out of the domain
+  std::vector<double> path;
+  for (int i = 0; i < 6000; ++i)
+    {
+    double t = 0.002 * i;
+    double r = 0.1 + 0.12 * t;
+    double back = 0.02 * std::sin(40.0 * t);
+    path.push_back(r * std::cos(3.0 * t) + back);
+    path.push_back(r * std::sin(3.0 * t) + back);
+    path.push_back(-0.9 + 0.15 * t);
+    }
+
+  vtkSmartPointer<vtkInterpolatedVelocityField> interpolated =
+    vtkSmartPointer<vtkInterpolatedVelocityField>::New();
+  vtkSmartPointer<vtkCellLocatorInterpolatedVelocityField> located =
+    vtkSmartPointer<vtkCellLocatorInterpolatedVelocityField>::New();
+  for (int b = 0; b < 8; ++b)
+    {
+    interpolated->AddDataSet(blocks[b]);
+    located->AddDataSet(blocks[b]);
+    }
+
+  if (!TestField(interpolated, path) || !TestField(located, path))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Most of the cells left by the path are found among their neighbors
+  if (located->GetNeighborHit() < located->GetCacheMiss() / 2)
+    {
+    std::cerr << "Error: " << located->GetNeighborHit() << " of "
+              << located->GetCacheMiss() << " cells found among neighbors"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The same without caching
+  interpolated->SetCaching(false);
+  if (!TestField(interpolated, path))
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
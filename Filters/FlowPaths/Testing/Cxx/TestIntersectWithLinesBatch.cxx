@@ -0,0 +1,156 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestIntersectWithLinesBatch.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// This tests that vtkAbstractCellLocator::IntersectWithLines() returns
+// the intersections of the single line queries of vtkOBBTree and
+// vtkModifiedBSPTree, whatever the number of threads.
+
+#include <vtkDoubleArray.h>
+#include <vtkGenericCell.h>
+#include <vtkIdList.h>
+#include <vtkMath.h>
+#include <vtkMinimalStandardRandomSequence.h>
+#include <vtkModifiedBSPTree.h>
+#include <vtkOBBTree.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkSphereSource.h>
+
+#include <cmath>
+
+static bool SameAsSingleQueries(vtkAbstractCellLocator *locator,
+                                vtkPoints *p1, vtkPoints *p2,
+                                vtkIdList *cellIds, vtkDoubleArray *t,
+                                vtkPoints *points)
+{
+  vtkSmartPointer<vtkGenericCell> cell =
+    vtkSmartPointer<vtkGenericCell>::New();
+  for (vtkIdType i = 0; i < p1->GetNumberOfPoints(); ++i)
+    {
+    double a[3], b[3], x[3], pcoords[3], tHit;
+    int subId;
+    vtkIdType cellId = -1;
+    p1->GetPoint(i, a);
+    p2->GetPoint(i, b);
+    if (!locator->IntersectWithLine(a, b, 0.0001, tHit, x, pcoords, subId,
+                                    cellId, cell))
+      {
+      if (cellIds->GetId(i) != -1 || t->GetValue(i) != -1.0)
+        {
+        return false;
+        }
+      continue;
+      }
+    double y[3];
+    points->GetPoint(i, y);
+    if (cellIds->GetId(i) != cellId || t->GetValue(i) != tHit ||
+        x[0] != y[0] || x[1] != y[1] || x[2] != y[2])
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+int TestIntersectWithLinesBatch(int, char*[])
+{
+  vtkSmartPointer<vtkSphereSource> sphere =
+    vtkSmartPointer<vtkSphereSource>::New();
+  sphere->SetRadius(1.0);
+  sphere->SetPhiResolution(40);
+  sphere->SetThetaResolution(40);
+  sphere->Update();
+
+  // Lines from outside the sphere to random points of a larger box: some
+  // cross the sphere, some miss it
+  vtkSmartPointer<vtkMinimalStandardRandomSequence> random =
+    vtkSmartPointer<vtkMinimalStandardRandomSequence>::New();
+  random->SetSeed(3141);
+  vtkSmartPointer<vtkPoints> p1 = vtkSmartPointer<vtkPoints>::New();
+  vtkSmartPointer<vtkPoints> p2 = vtkSmartPointer<vtkPoints>::New();
+  for (int i = 0; i < 2000; ++i)
+    {
+    double a[3], b[3];
+    for (int j = 0; j < 3; ++j)
+      {
+      random->Next();
+      a[j] = random->GetRangeValue(-1.0, 1.0);
+      random->Next();
+      b[j] = random->GetRangeValue(-2.0, 2.0);
+      }
+    vtkMath::Normalize(a);
+    a[0] *= 3.0; a[1] *= 3.0; a[2] *= 3.0;
+    p1->InsertNextPoint(a);
+    p2->InsertNextPoint(b);
+    }
+
+  vtkSmartPointer<vtkOBBTree> obb = vtkSmartPointer<vtkOBBTree>::New();
+  obb->SetDataSet(sphere->GetOutput());
+  obb->BuildLocator();
+  vtkSmartPointer<vtkModifiedBSPTree> bsp =
+    vtkSmartPointer<vtkModifiedBSPTree>::New();
+  bsp->SetDataSet(sphere->GetOutput());
+  bsp->BuildLocator();
+
+  vtkAbstractCellLocator *locators[2] = { obb, bsp };
+  vtkSmartPointer<vtkDoubleArray> hits[2];
+  for (int l = 0; l < 2; ++l)
+    {
+    for (int numThreads = 1; numThreads <= 4; numThreads += 3)
+      {
+      locators[l]->SetNumberOfThreads(numThreads);
+      vtkSmartPointer<vtkIdList> cellIds = vtkSmartPointer<vtkIdList>::New();
+      vtkSmartPointer<vtkDoubleArray> t =
+        vtkSmartPointer<vtkDoubleArray>::New();
+      vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+      points->SetDataTypeToDouble();
+      locators[l]->IntersectWithLines(p1, p2, 0.0001, cellIds, t, points);
+      if (cellIds->GetNumberOfIds() != p1->GetNumberOfPoints() ||
+          !SameAsSingleQueries(locators[l], p1, p2, cellIds, t, points))
+        {
+        std::cerr << "Error: " << locators[l]->GetClassName()
+                  << " batch intersections differ with " << numThreads
+                  << " thread(s)" << std::endl;
+        return EXIT_FAILURE;
+        }
+      hits[l] = t;
+      }
+    }
+
+  // Both locators find the first intersection, on the sphere
+  vtkIdType numHits = 0;
+  for (vtkIdType i = 0; i < p1->GetNumberOfPoints(); ++i)
+    {
+    double tObb = hits[0]->GetValue(i);
+    double tBsp = hits[1]->GetValue(i);
+    if ((tObb < 0.0) != (tBsp < 0.0) ||
+        (tObb >= 0.0 && std::fabs(tObb - tBsp) > 1e-6))
+      {
+      std::cerr << "Error: line " << i << " hits at t = " << tObb
+                << " with vtkOBBTree and at t = " << tBsp
+                << " with vtkModifiedBSPTree" << std::endl;
+      return EXIT_FAILURE;
+      }
+    numHits += (tObb >= 0.0 ? 1 : 0);
+    }
+  if (numHits == 0 || numHits == p1->GetNumberOfPoints())
+    {
+    std::cerr << "Error: " << numHits << " lines hit the sphere"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
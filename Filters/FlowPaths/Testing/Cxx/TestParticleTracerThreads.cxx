@@ -0,0 +1,270 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestParticleTracerThreads.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// This tests that vtkParticleTracer, vtkParticlePathFilter and
+// vtkStreaklineFilter give the same output whatever the number of threads
+// advecting the particles, through an image and a tetrahedral mesh, with
+// particles leaving the domain.
+
+#include <vtkCellArray.h>
+#include <vtkDataSetTriangleFilter.h>
+#include <vtkDoubleArray.h>
+#include <vtkImageData.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkMinimalStandardRandomSequence.h>
+#include <vtkObjectFactory.h>
+#include <vtkParticlePathFilter.h>
+#include <vtkParticleTracer.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkStreaklineFilter.h>
+#include <vtkStreamingDemandDrivenPipeline.h>
+#include <vtkUnstructuredGrid.h>
+
+// A swirling velocity field over [-1,1]^3 which speeds up with time, given
+// as an image or as tetrahedra
+class TestSwirlSource : public vtkAlgorithm
+{
+public:
+  static TestSwirlSource *New();
+  vtkTypeMacro(TestSwirlSource, vtkAlgorithm);
+
+  vtkSetMacro(Unstructured, bool);
+
+protected:
+  TestSwirlSource()
+  {
+    this->Unstructured = false;
+    this->SetNumberOfInputPorts(0);
+    this->SetNumberOfOutputPorts(1);
+  }
+
+  int ProcessRequest(vtkInformation* request,
+                     vtkInformationVector** inputVector,
+                     vtkInformationVector* outputVector)
+  {
+    if (request->Has(vtkDemandDrivenPipeline::REQUEST_DATA()))
+      {
+      return this->RequestData(outputVector);
+      }
+    if (request->Has(vtkDemandDrivenPipeline::REQUEST_INFORMATION()))
+      {
+      return this->RequestInformation(outputVector);
+      }
+    return this->Superclass::ProcessRequest(request, inputVector,
+                                            outputVector);
+  }
+
+  int FillOutputPortInformation(int, vtkInformation *info)
+  {
+    info->Set(vtkDataObject::DATA_TYPE_NAME(), this->Unstructured ?
+              "vtkUnstructuredGrid" : "vtkImageData");
+    return 1;
+  }
+
+  int RequestInformation(vtkInformationVector *outputVector)
+  {
+    vtkInformation *outInfo = outputVector->GetInformationObject(0);
+    double timeSteps[6] = { 0.0, 1.0, 2.0, 3.0, 4.0, 5.0 };
+    double range[2] = { 0.0, 5.0 };
+    outInfo->Set(vtkStreamingDemandDrivenPipeline::TIME_STEPS(),
+                 timeSteps, 6);
+    outInfo->Set(vtkStreamingDemandDrivenPipeline::TIME_RANGE(), range, 2);
+    if (!this->Unstructured)
+      {
+      int extent[6] = { 0, 10, 0, 10, 0, 10 };
+      outInfo->Set(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(),
+                   extent, 6);
+      }
+    return 1;
+  }
+
+  int RequestData(vtkInformationVector *outputVector)
+  {
+    vtkInformation *outInfo = outputVector->GetInformationObject(0);
+    double t = outInfo->Get(
+      vtkStreamingDemandDrivenPipeline::UPDATE_TIME_STEP());
+
+    vtkSmartPointer<vtkImageData> image =
+      vtkSmartPointer<vtkImageData>::New();
+    image->SetExtent(0, 10, 0, 10, 0, 10);
+    image->SetOrigin(-1.0, -1.0, -1.0);
+    image->SetSpacing(0.2, 0.2, 0.2);
+    vtkSmartPointer<vtkDoubleArray> velocity =
+      vtkSmartPointer<vtkDoubleArray>::New();
+    velocity->SetName("Velocity");
+    velocity->SetNumberOfComponents(3);
+    vtkSmartPointer<vtkDoubleArray> scalars =
+      vtkSmartPointer<vtkDoubleArray>::New();
+    scalars->SetName("Scalars");
+    double s = 0.2 * (1.0 + 0.1*t);
+    for (vtkIdType i = 0; i < image->GetNumberOfPoints(); ++i)
+      {
+      double x[3];
+      image->GetPoint(i, x);
+      velocity->InsertNextTuple3(s*(-x[1] + 0.3*x[2]), s*x[0],
+                                 s*(0.5 + x[0]*x[1]));
+      scalars->InsertNextValue(x[0]*x[0] + x[1] - x[2] + t);
+      }
+    image->GetPointData()->SetVectors(velocity);
+    image->GetPointData()->AddArray(scalars);
+
+    vtkDataObject *output = outInfo->Get(vtkDataObject::DATA_OBJECT());
+    if (this->Unstructured)
+      {
+      vtkSmartPointer<vtkDataSetTriangleFilter> tetra =
+        vtkSmartPointer<vtkDataSetTriangleFilter>::New();
+      tetra->SetInputData(image);
+      tetra->Update();
+      output->ShallowCopy(tetra->GetOutput());
+      }
+    else
+      {
+      output->ShallowCopy(image);
+      }
+    output->GetInformation()->Set(vtkDataObject::DATA_TIME_STEP(), t);
+    return 1;
+  }
+
+private:
+  TestSwirlSource(const TestSwirlSource&); // Not implemented.
+  void operator=(const TestSwirlSource&);  // Not implemented.
+
+  bool Unstructured;
+};
+
+vtkStandardNewMacro(TestSwirlSource);
+
+static bool SameArrays(vtkDataArray *a, vtkDataArray *b)
+{
+  if (!a || !b || a->GetNumberOfTuples() != b->GetNumberOfTuples() ||
+      a->GetNumberOfComponents() != b->GetNumberOfComponents())
+    {
+    return false;
+    }
+  for (vtkIdType i = 0; i < a->GetNumberOfTuples(); ++i)
+    {
+    for (int c = 0; c < a->GetNumberOfComponents(); ++c)
+      {
+      if (a->GetComponent(i, c) != b->GetComponent(i, c))
+        {
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+static bool SameOutputs(vtkPolyData *a, vtkPolyData *b)
+{
+  if (a->GetNumberOfPoints() != b->GetNumberOfPoints() ||
+      !SameArrays(a->GetPoints()->GetData(), b->GetPoints()->GetData()) ||
+      !SameArrays(a->GetVerts()->GetData(), b->GetVerts()->GetData()) ||
+      !SameArrays(a->GetLines()->GetData(), b->GetLines()->GetData()) ||
+      a->GetPointData()->GetNumberOfArrays() !=
+      b->GetPointData()->GetNumberOfArrays())
+    {
+    return false;
+    }
+  for (int i = 0; i < a->GetPointData()->GetNumberOfArrays(); ++i)
+    {
+    if (!SameArrays(a->GetPointData()->GetArray(i),
+                    b->GetPointData()->GetArray(i)))
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+template <class TFilter>
+static bool TestFilter(bool unstructured, vtkPolyData *seeds,
+                       const char *name)
+{
+  vtkSmartPointer<TestSwirlSource> source =
+    vtkSmartPointer<TestSwirlSource>::New();
+  source->SetUnstructured(unstructured);
+
+  vtkSmartPointer<vtkPolyData> reference;
+  for (int numThreads = 1; numThreads <= 4; numThreads += 3)
+    {
+    vtkSmartPointer<TFilter> filter = vtkSmartPointer<TFilter>::New();
+    filter->SetInputConnection(0, source->GetOutputPort());
+    filter->SetInputData(1, seeds);
+    filter->SetStartTime(0.0);
+    filter->SetTerminationTime(4.5);
+    filter->SetNumberOfThreads(numThreads);
+    filter->Update();
+    if (numThreads == 1)
+      {
+      reference = filter->GetOutput();
+      // Some of the particles leave the domain, but most stay inside
+      if (2*reference->GetNumberOfPoints() < seeds->GetNumberOfPoints())
+        {
+        std::cerr << "Error: " << name << " output "
+                  << reference->GetNumberOfPoints() << " points through the "
+                  << (unstructured ? "tetrahedra" : "image") << std::endl;
+        return false;
+        }
+      }
+    else if (!SameOutputs(reference, filter->GetOutput()))
+      {
+      std::cerr << "Error: " << name << " output through the "
+                << (unstructured ? "tetrahedra" : "image") << " differs with "
+                << numThreads << " threads" << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+int TestParticleTracerThreads(int, char*[])
+{
+  // Enough seeds for several chunks of particles, some of which leave
+  // the domain
+  vtkSmartPointer<vtkMinimalStandardRandomSequence> random =
+    vtkSmartPointer<vtkMinimalStandardRandomSequence>::New();
+  random->SetSeed(2718);
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  for (int i = 0; i < 700; ++i)
+    {
+    double x[3];
+    for (int j = 0; j < 3; ++j)
+      {
+      random->Next();
+      x[j] = random->GetRangeValue(-0.9, 0.9);
+      }
+    points->InsertNextPoint(x);
+    }
+  vtkSmartPointer<vtkPolyData> seeds = vtkSmartPointer<vtkPolyData>::New();
+  seeds->SetPoints(points);
+
+  for (int unstructured = 0; unstructured < 2; ++unstructured)
+    {
+    if (!TestFilter<vtkParticleTracer>(unstructured != 0, seeds,
+                                       "vtkParticleTracer") ||
+        !TestFilter<vtkParticlePathFilter>(unstructured != 0, seeds,
+                                           "vtkParticlePathFilter") ||
+        !TestFilter<vtkStreaklineFilter>(unstructured != 0, seeds,
+                                         "vtkStreaklineFilter"))
+      {
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,213 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestStreamTracerThreads.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// This tests that vtkStreamTracer gives the same streamlines whatever the
+// number of threads, through an image, a tetrahedral mesh and a multiblock
+// of two images, integrating in both directions.
+
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkDataSetTriangleFilter.h>
+#include <vtkDoubleArray.h>
+#include <vtkImageData.h>
+#include <vtkMinimalStandardRandomSequence.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkRungeKutta45.h>
+#include <vtkSmartPointer.h>
+#include <vtkStreamTracer.h>
+#include <vtkUnstructuredGrid.h>
+
+#include <cstring>
+
+// A swirling field with some shear, so that streamlines have different
+// lengths and leave the domain at different places
+static vtkSmartPointer<vtkImageData> MakeField(int xMin, int xMax)
+{
+  vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+  image->SetExtent(xMin, xMax, -10, 10, -10, 10);
+  image->SetSpacing(0.1, 0.1, 0.1);
+  vtkSmartPointer<vtkDoubleArray> velocity =
+    vtkSmartPointer<vtkDoubleArray>::New();
+  velocity->SetName("Velocity");
+  velocity->SetNumberOfComponents(3);
+  vtkSmartPointer<vtkDoubleArray> scalars =
+    vtkSmartPointer<vtkDoubleArray>::New();
+  scalars->SetName("Scalars");
+  for (vtkIdType i = 0; i < image->GetNumberOfPoints(); ++i)
+    {
+    double x[3];
+    image->GetPoint(i, x);
+    velocity->InsertNextTuple3(-x[1] + 0.1*x[2], x[0], 0.3 + 0.2*x[0]*x[1]);
+    scalars->InsertNextValue(x[0]*x[0] + x[2]);
+    }
+  image->GetPointData()->SetVectors(velocity);
+  image->GetPointData()->AddArray(scalars);
+  return image;
+}
+
+static bool SameArrays(vtkDataArray *a, vtkDataArray *b)
+{
+  if (!a || !b || a->GetNumberOfTuples() != b->GetNumberOfTuples() ||
+      a->GetNumberOfComponents() != b->GetNumberOfComponents() ||
+      (a->GetName() &&
+       (!b->GetName() || strcmp(a->GetName(), b->GetName()))))
+    {
+    return false;
+    }
+  for (vtkIdType i = 0; i < a->GetNumberOfTuples(); ++i)
+    {
+    for (int c = 0; c < a->GetNumberOfComponents(); ++c)
+      {
+      if (a->GetComponent(i, c) != b->GetComponent(i, c))
+        {
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+static bool SameStreamlines(vtkPolyData *a, vtkPolyData *b)
+{
+  if (a->GetNumberOfPoints() != b->GetNumberOfPoints() ||
+      a->GetNumberOfLines() != b->GetNumberOfLines() ||
+      !SameArrays(a->GetPoints()->GetData(), b->GetPoints()->GetData()) ||
+      !SameArrays(a->GetLines()->GetData(), b->GetLines()->GetData()))
+    {
+    return false;
+    }
+  vtkFieldData *data[2][2] = { { a->GetPointData(), b->GetPointData() },
+                               { a->GetCellData(), b->GetCellData() } };
+  for (int d = 0; d < 2; ++d)
+    {
+    if (data[d][0]->GetNumberOfArrays() != data[d][1]->GetNumberOfArrays())
+      {
+      return false;
+      }
+    for (int i = 0; i < data[d][0]->GetNumberOfArrays(); ++i)
+      {
+      if (!SameArrays(data[d][0]->GetArray(i), data[d][1]->GetArray(i)))
+        {
+        return false;
+        }
+      }
+    }
+  return a->GetPointData()->GetVectors() && b->GetPointData()->GetVectors() &&
+    !strcmp(a->GetPointData()->GetVectors()->GetName(),
+            b->GetPointData()->GetVectors()->GetName());
+}
+
+static bool TestInput(vtkDataObject *input, vtkDataSet *seeds,
+                      const char *name)
+{
+  vtkSmartPointer<vtkStreamTracer> serial =
+    vtkSmartPointer<vtkStreamTracer>::New();
+  serial->SetInputData(input);
+  serial->SetSourceData(seeds);
+  serial->SetIntegrationDirectionToBoth();
+  serial->SetMaximumPropagation(5.0);
+  serial->SetNumberOfThreads(1);
+  serial->Update();
+  if (serial->GetOutput()->GetNumberOfLines() < seeds->GetNumberOfPoints())
+    {
+    std::cerr << "Error: " << serial->GetOutput()->GetNumberOfLines()
+              << " streamlines through the " << name << std::endl;
+    return false;
+    }
+
+  for (int numThreads = 2; numThreads <= 8; numThreads *= 2)
+    {
+    vtkSmartPointer<vtkStreamTracer> threaded =
+      vtkSmartPointer<vtkStreamTracer>::New();
+    threaded->SetInputData(input);
+    threaded->SetSourceData(seeds);
+    threaded->SetIntegrationDirectionToBoth();
+    threaded->SetMaximumPropagation(5.0);
+    threaded->SetNumberOfThreads(numThreads);
+    threaded->Update();
+    if (!SameStreamlines(serial->GetOutput(), threaded->GetOutput()))
+      {
+      std::cerr << "Error: the streamlines through the " << name
+                << " differ with " << numThreads << " threads" << std::endl;
+      return false;
+      }
+    }
+
+  // Same with an adaptive integrator
+  vtkSmartPointer<vtkRungeKutta45> rk45 =
+    vtkSmartPointer<vtkRungeKutta45>::New();
+  serial->SetIntegrator(rk45);
+  serial->Update();
+  vtkSmartPointer<vtkStreamTracer> threaded =
+    vtkSmartPointer<vtkStreamTracer>::New();
+  threaded->SetInputData(input);
+  threaded->SetSourceData(seeds);
+  threaded->SetIntegrator(rk45);
+  threaded->SetIntegrationDirectionToBoth();
+  threaded->SetMaximumPropagation(5.0);
+  threaded->SetNumberOfThreads(4);
+  threaded->Update();
+  if (!SameStreamlines(serial->GetOutput(), threaded->GetOutput()))
+    {
+    std::cerr << "Error: the Runge-Kutta 4-5 streamlines through the "
+              << name << " differ with 4 threads" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+int TestStreamTracerThreads(int, char*[])
+{
+  // Seeds inside the field, and a few outside of it
+  vtkSmartPointer<vtkMinimalStandardRandomSequence> random =
+    vtkSmartPointer<vtkMinimalStandardRandomSequence>::New();
+  random->SetSeed(4242);
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  for (int i = 0; i < 150; ++i)
+    {
+    double x[3];
+    for (int j = 0; j < 3; ++j)
+      {
+      random->Next();
+      x[j] = random->GetRangeValue(-1.1, 1.1);
+      }
+    points->InsertNextPoint(x);
+    }
+  vtkSmartPointer<vtkPolyData> seeds = vtkSmartPointer<vtkPolyData>::New();
+  seeds->SetPoints(points);
+
+  vtkSmartPointer<vtkImageData> image = MakeField(-10, 10);
+  vtkSmartPointer<vtkDataSetTriangleFilter> tetra =
+    vtkSmartPointer<vtkDataSetTriangleFilter>::New();
+  tetra->SetInputData(image);
+  tetra->Update();
+
+  vtkSmartPointer<vtkMultiBlockDataSet> blocks =
+    vtkSmartPointer<vtkMultiBlockDataSet>::New();
+  blocks->SetNumberOfBlocks(2);
+  blocks->SetBlock(0, MakeField(-10, 0));
+  blocks->SetBlock(1, MakeField(0, 10));
+
+  if (!TestInput(image, seeds, "image") ||
+      !TestInput(tetra->GetOutput(), seeds, "tetrahedra") ||
+      !TestInput(blocks, seeds, "blocks"))
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -24,11 +24,14 @@
 #include "vtkSmartPointer.h"
 #include "vtkFloatArray.h"
 #include "vtkDoubleArray.h"
+#include "vtkIdList.h"
+#include "vtkUnstructuredGrid.h"
 
 #include "vtkCellLocator.h"
 #define Custom_TreeType vtkCellLocator
 
 #include <vector>
+#include <cmath>
 #ifdef JB_BSP_TREE
  #include "vtkModifiedBSPTree.h"
  #undef  Custom_TreeType
@@ -61,6 +64,21 @@ void IVFDataSetInfo::SetDataSet(vtkDataSet *data, char *velocity, bool staticdat
   }
   this->Tolerance =
     this->DataSet->GetLength() * IVFDataSetInfo::TOLERANCE_SCALE;
+  // a point is found in a cell up to a parametric tolerance, relative to
+  // the size of the cell, hence the margin relative to the dataset size
+  this->DataSet->GetBounds(this->Bounds);
+  if (this->DataSet->GetNumberOfCells() > 0 &&
+      this->Bounds[0] <= this->Bounds[1]) {
+    double margin = this->DataSet->GetLength() * 0.01 + sqrt(this->Tolerance);
+    for (int i=0; i<3; i++) {
+      this->Bounds[2*i]   -= margin;
+      this->Bounds[2*i+1] += margin;
+    }
+  }
+  else {
+    this->Bounds[0] = this->Bounds[2] = this->Bounds[4] = 1.0;
+    this->Bounds[1] = this->Bounds[3] = this->Bounds[5] = -1.0;
+  }
   //
   vtkDataArray *vectors = this->DataSet->GetPointData()->GetArray(velocity);
   if (vtkFloatArray::SafeDownCast(vectors)) {
@@ -82,6 +100,9 @@ IVFDataSetInfo::IVFDataSetInfo(const IVFDataSetInfo &ivfci)
   this->Cell           = ivfci.Cell;
   this->BSPTree        = ivfci.BSPTree;
   this->Tolerance      = ivfci.Tolerance;
+  for (int i=0; i<6; i++) {
+    this->Bounds[i]    = ivfci.Bounds[i];
+  }
   this->StaticDataSet  = ivfci.StaticDataSet;
 }
 //---------------------------------------------------------------------------
@@ -93,10 +114,20 @@ IVFDataSetInfo &IVFDataSetInfo::operator=(const IVFDataSetInfo &ivfci)
   this->Cell           = ivfci.Cell;
   this->BSPTree        = ivfci.BSPTree;
   this->Tolerance      = ivfci.Tolerance;
+  for (int i=0; i<6; i++) {
+    this->Bounds[i]    = ivfci.Bounds[i];
+  }
   this->StaticDataSet  = ivfci.StaticDataSet;
   return *this;
 }
 //---------------------------------------------------------------------------
+bool IVFDataSetInfo::InsideBounds(double *x) const
+{
+  return x[0] >= this->Bounds[0] && x[0] <= this->Bounds[1] &&
+         x[1] >= this->Bounds[2] && x[1] <= this->Bounds[3] &&
+         x[2] >= this->Bounds[4] && x[2] <= this->Bounds[5];
+}
+//---------------------------------------------------------------------------
 //---------------------------------------------------------------------------
 //---------------------------------------------------------------------------
 vtkCachingInterpolatedVelocityField::vtkCachingInterpolatedVelocityField()
@@ -108,6 +139,9 @@ vtkCachingInterpolatedVelocityField::vtkCachingInterpolatedVelocityField()
   this->CellCacheHit     = 0;
   this->DataSetCacheHit  = 0;
   this->CacheMiss        = 0;
+  this->NeighborCacheHit = 0;
+  this->FacePoints       = vtkIdList::New();
+  this->Neighbors        = vtkIdList::New();
   this->LastCacheIndex   = 0;
   this->Cache            = NULL;
   this->LastCellId       = -1;
@@ -118,6 +152,8 @@ vtkCachingInterpolatedVelocityField::~vtkCachingInterpolatedVelocityField()
   this->NumFuncs     = 0;
   this->NumIndepVars = 0;
   this->TempCell->Delete();
+  this->FacePoints->Delete();
+  this->Neighbors->Delete();
   this->SetVectorsSelection(0);
 }
 //---------------------------------------------------------------------------
@@ -162,6 +198,44 @@ vtkGenericCell *vtkCachingInterpolatedVelocityField::GetLastCell()
   return NULL;
 }
 //---------------------------------------------------------------------------
+int vtkCachingInterpolatedVelocityField::PrepareConcurrentDataSetAccess()
+{
+  for (size_t i=0; i<this->CacheList.size(); i++)
+    {
+    IVFDataSetInfo *data = &this->CacheList[i];
+    if (data->BSPTree)
+      {
+      // only the locators created here are known to search concurrently
+      if (!Custom_TreeType::SafeDownCast(data->BSPTree) ||
+          !data->DataSet->IsA("vtkUnstructuredGrid"))
+        {
+        return 0;
+        }
+      // the links give the neighbors of the cells
+      vtkUnstructuredGrid *grid = vtkUnstructuredGrid::SafeDownCast(data->DataSet);
+      if (!grid->GetCellLinks())
+        {
+        grid->BuildLinks();
+        }
+      // a first search builds the lazily evaluated locator
+      if (data->DataSet->GetNumberOfCells() > 0 && !this->Weights.empty())
+        {
+        double x[3], pcoords[3];
+        data->DataSet->GetPoint(0, x);
+        data->BSPTree->FindCell(x, data->Tolerance, this->TempCell,
+                                pcoords, &this->Weights[0]);
+        }
+      }
+    else if (!data->DataSet->IsA("vtkImageData"))
+      {
+      return 0;
+      }
+    // the bounds are computed on first access
+    data->DataSet->GetLength();
+    }
+  return 1;
+}
+//---------------------------------------------------------------------------
 // Evaluate {u,v,w} at {x,y,z,t}
 int vtkCachingInterpolatedVelocityField::FunctionValues(double* x, double* f)
 {
@@ -182,7 +256,7 @@ int vtkCachingInterpolatedVelocityField::FunctionValues(double* x, double* f)
        this->LastCacheIndex++)
     {
     IVFDataSetInfo *data = &this->CacheList[this->LastCacheIndex];
-    if (data==this->Cache) continue;
+    if (data==this->Cache || !data->InsideBounds(x)) continue;
     //
     this->LastCellId = -1;
     if (this->FunctionValues(data, x, f))
@@ -221,7 +295,7 @@ int vtkCachingInterpolatedVelocityField::InsideTest(double* x)
        this->LastCacheIndex++)
     {
     IVFDataSetInfo *data = &this->CacheList[this->LastCacheIndex];
-    if (data==this->Cache) continue;
+    if (data==this->Cache || !data->InsideBounds(x)) continue;
     //
     this->LastCellId = -1;
     if (this->InsideTest(data,  x))
@@ -250,7 +324,7 @@ int vtkCachingInterpolatedVelocityField::InsideTest(IVFDataSetInfo *data, double
 int vtkCachingInterpolatedVelocityField::FunctionValues(
   IVFDataSetInfo *data, double *x, double *f)
 {
-  int    subId;
+  int    subId = -1;
   double dist2;
 
   if (this->LastCellId>=0)
@@ -259,20 +333,27 @@ int vtkCachingInterpolatedVelocityField::FunctionValues(
     if (data->BSPTree && !data->BSPTree->InsideCellBounds(x, this->LastCellId)) {
       inbox = false;
     }
-    if (inbox && data->Cell->EvaluatePosition(
-      x, 0, subId, data->PCoords, dist2, &this->Weights[0])==1)
+    int inside = 0;
+    if (inbox && (inside = data->Cell->EvaluatePosition(
+      x, 0, subId, data->PCoords, dist2, &this->Weights[0]))==1)
       {
       this->FastCompute(data, f);
       this->CellCacheHit++;
       return 1;
       }
+    // only keep the location of x relative to the cell if it is valid
+    subId = (inbox && inside==0) ? subId : -1;
     }
 
-  // we need to search the whole dataset
+  // we need to search the whole dataset, unless x is in a neighbor
   if (data->BSPTree)
     {
-    int cellId = data->BSPTree->FindCell(x, data->Tolerance,
-      data->Cell, data->PCoords, &this->Weights[0]);
+    int cellId = this->FindNeighborCell(data, x, subId);
+    if (cellId==-1)
+      {
+      cellId = data->BSPTree->FindCell(x, data->Tolerance,
+        data->Cell, data->PCoords, &this->Weights[0]);
+      }
     this->LastCellId = cellId;
     }
   else
@@ -300,6 +381,49 @@ int vtkCachingInterpolatedVelocityField::FunctionValues(
   return 1;
 }
 //---------------------------------------------------------------------------
+int vtkCachingInterpolatedVelocityField::FindNeighborCell(
+  IVFDataSetInfo *data, double *x, int subId)
+{
+  if (this->LastCellId<0 || data->Cell->GetCellDimension()!=3 ||
+      !data->DataSet->IsA("vtkUnstructuredGrid"))
+    {
+    return -1;
+    }
+
+  // x out of the cell bounds is not located relative to the cell yet
+  double dist2;
+  if (subId<0)
+    {
+    int inside = data->Cell->EvaluatePosition(
+      x, 0, subId, data->PCoords, dist2, &this->Weights[0]);
+    if (inside==1)
+      {
+      return this->LastCellId;
+      }
+    else if (inside==-1)
+      {
+      return -1;
+      }
+    }
+
+  // the face closest to x, from its parametric coordinates
+  data->Cell->CellBoundary(subId, data->PCoords, this->FacePoints);
+  data->DataSet->GetCellNeighbors(
+    this->LastCellId, this->FacePoints, this->Neighbors);
+  for (vtkIdType i=0; i<this->Neighbors->GetNumberOfIds(); i++)
+    {
+    vtkIdType cellId = this->Neighbors->GetId(i);
+    data->DataSet->GetCell(cellId, data->Cell);
+    if (data->Cell->EvaluatePosition(
+      x, 0, subId, data->PCoords, dist2, &this->Weights[0])==1)
+      {
+      this->NeighborCacheHit++;
+      return static_cast<int>(cellId);
+      }
+    }
+  return -1;
+}
+//---------------------------------------------------------------------------
 void vtkCachingInterpolatedVelocityField::FastCompute(
   IVFDataSetInfo *data, double f[3])
 {
@@ -402,6 +526,7 @@ void vtkCachingInterpolatedVelocityField::PrintSelf(ostream& os, vtkIndent inden
   os << indent << "Cell Cache hit: " << this->CellCacheHit << endl;
   os << indent << "DataSet Cache hit: " << this->DataSetCacheHit << endl;
   os << indent << "Cache miss: " << this->CacheMiss << endl;
+  os << indent << "Neighbor Cache hit: " << this->NeighborCacheHit << endl;
   os << indent << "VectorsSelection: "
      << (this->VectorsSelection?this->VectorsSelection:"(none)") << endl;
 
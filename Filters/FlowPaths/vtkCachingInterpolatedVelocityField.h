@@ -27,6 +27,10 @@
 // integration, the next evaluation is usually in the same or a neighbour
 // cell. For this reason, vtkCachingInterpolatedVelocityField stores the last
 // cell id. If caching is turned on, it uses this id as the starting point.
+// When the point is out of the last cell of a vtkUnstructuredGrid, the
+// neighbors of this cell across its face closest to the point are tried
+// before searching the whole dataset, and the datasets whose bounds do not
+// contain the point are not searched at all.
 
 // .SECTION Caveats
 // vtkCachingInterpolatedVelocityField is not thread safe. A new instance should
@@ -53,6 +57,7 @@ class vtkDataArray;
 class vtkPointData;
 class vtkGenericCell;
 class vtkAbstractCellLocator;
+class vtkIdList;
 //BTX
 //---------------------------------------------------------------------------
 class IVFDataSetInfo;
@@ -110,6 +115,7 @@ public:
   vtkGetMacro(CellCacheHit, int);
   vtkGetMacro(DataSetCacheHit, int);
   vtkGetMacro(CacheMiss, int);
+  vtkGetMacro(NeighborCacheHit, int);
 
 protected:
   vtkCachingInterpolatedVelocityField();
@@ -119,11 +125,14 @@ protected:
   int                      CellCacheHit;
   int                      DataSetCacheHit;
   int                      CacheMiss;
+  int                      NeighborCacheHit;
   int                      LastCacheIndex;
   int                      LastCellId;
   IVFDataSetInfo          *Cache;
   IVFCacheList          CacheList;
   char                    *VectorsSelection;
+  vtkIdList               *FacePoints;
+  vtkIdList               *Neighbors;
 //BTX
   std::vector<double>   Weights;
 //ETX
@@ -135,6 +144,14 @@ protected:
   int FunctionValues(IVFDataSetInfo *cache, double *x, double *f);
   int InsideTest(IVFDataSetInfo *cache, double* x);
 
+  // Description:
+  // Look for x in the neighbors of the last cell of a vtkUnstructuredGrid,
+  // across the face closest to x, given by subId and the parametric
+  // coordinates of x in this cell if they are known, i.e., subId >= 0.
+  // Return the id of the cell containing x, which becomes the cached cell,
+  // or -1 if none does.
+  int FindNeighborCell(IVFDataSetInfo *cache, double *x, int subId);
+
 //BTX
   friend class vtkTemporalInterpolatedVelocityField;
   // Description:
@@ -146,6 +163,12 @@ protected:
   void FastCompute(IVFDataSetInfo *cache, double f[3]);
   bool InterpolatePoint(vtkPointData *outPD, vtkIdType outIndex);
   vtkGenericCell *GetLastCell();
+
+  // Description:
+  // Build the cell locators now and return 1 if the datasets may be
+  // searched from several threads at once, each with its own instance of
+  // this class sharing the datasets and locators.
+  int PrepareConcurrentDataSetAccess();
 //ETX
 
 private:
@@ -172,11 +195,15 @@ public:
   float                                  *VelocityFloat;
   double                                 *VelocityDouble;
   double                                  Tolerance;
+  double                                  Bounds[6];
   bool                                    StaticDataSet;
   IVFDataSetInfo();
   IVFDataSetInfo(const IVFDataSetInfo &ivfci);
   IVFDataSetInfo &operator=(const IVFDataSetInfo &ivfci);
   void SetDataSet(vtkDataSet *data, char *velocity, bool staticdataset, vtkAbstractCellLocator *locator);
+  // whether the bounds of the dataset, enlarged by the search tolerance,
+  // contain x
+  bool InsideBounds(double *x) const;
   //
   static const double TOLERANCE_SCALE;
 };
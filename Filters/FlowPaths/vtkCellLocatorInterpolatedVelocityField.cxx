@@ -19,6 +19,7 @@
 #include "vtkDataArray.h"
 #include "vtkPointData.h"
 #include "vtkGenericCell.h"
+#include "vtkIdList.h"
 #include "vtkCellLocator.h"
 #include "vtkSmartPointer.h"
 #include "vtkObjectFactory.h"
@@ -37,6 +38,9 @@ vtkCellLocatorInterpolatedVelocityField::vtkCellLocatorInterpolatedVelocityField
   this->LastCellLocator  = 0;
   this->CellLocatorPrototype = 0;
   this->CellLocators = new vtkCellLocatorInterpolatedVelocityFieldCellLocatorsType;
+  this->FacePoints = vtkIdList::New();
+  this->Neighbors = vtkIdList::New();
+  this->NeighborHit = 0;
 }
 
 //----------------------------------------------------------------------------
@@ -50,6 +54,9 @@ vtkCellLocatorInterpolatedVelocityField::~vtkCellLocatorInterpolatedVelocityFiel
     delete this->CellLocators;
     this->CellLocators = 0;
     }
+
+  this->FacePoints->Delete();
+  this->Neighbors->Delete();
 }
 
 //----------------------------------------------------------------------------
@@ -67,6 +74,11 @@ void vtkCellLocatorInterpolatedVelocityField::SetLastCellId
   {
     this->LastDataSet->GetCell( this->LastCellId, this->GenCell );
   }
+  else
+  {
+    // a reset starts over, e.g., with a new streamline
+    this->ForgetRememberedCells();
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -90,8 +102,14 @@ int vtkCellLocatorInterpolatedVelocityField::FunctionValues
     loc = this->LastCellLocator;
     }
 
-  int retVal;
-  if ( loc )
+  // skip the dataset at once if the point is out of its bounds
+  vtkIdType lastCellId = this->LastCellId;
+  int retVal = 0;
+  if ( !this->DataSetBoundsContain( this->LastDataSetIndex, x ) )
+    {
+    f[0] = f[1] = f[2] = 0.0;
+    }
+  else if ( loc )
     {
     // resort to vtkAbstractCellLocator::FindCell()
     retVal = this->FunctionValues( vds, loc, x, f );
@@ -104,12 +122,38 @@ int vtkCellLocatorInterpolatedVelocityField::FunctionValues
 
   if ( !retVal )
     {
-    for( this->LastDataSetIndex = 0;
-         this->LastDataSetIndex < static_cast<int>( this->DataSets->size() );
-         this->LastDataSetIndex ++ )
+    this->ClearLastCellId();
+
+    // the point may come back to a cell it left in another dataset
+    int dataindex = -1;
+    if ( lastCellId != -1 )
+      {
+      this->RememberCell( this->LastDataSetIndex, lastCellId );
+      }
+    if ( ( dataindex = this->FindRememberedCell( x ) ) != -1 )
+      {
+      vds = ( *this->DataSets )[dataindex];
+      loc = ( *this->CellLocators )[dataindex].GetPointer();
+      retVal = loc ? this->FunctionValues( vds, loc, x, f ) :
+                     this->FunctionValues( vds, x, f );
+      if ( retVal )
+        {
+        this->LastDataSet      = vds;
+        this->LastCellLocator  = loc;
+        this->LastDataSetIndex = dataindex;
+        vds = NULL;
+        loc = NULL;
+        return retVal;
+        }
+      }
+
+    // otherwise search the datasets whose bounds contain the point
+    const int * indices;
+    int numDataSets = this->FindDataSets( x, indices );
+    for ( int i = 0; i < numDataSets; i ++ )
       {
-      vds = this->DataSets->operator[]( this->LastDataSetIndex );
-      loc = this->CellLocators->operator[]( this->LastDataSetIndex ).GetPointer();
+      vds = this->DataSets->operator[]( indices[i] );
+      loc = this->CellLocators->operator[]( indices[i] ).GetPointer();
       if( vds && vds != this->LastDataSet )
         {
         this->ClearLastCellId();
@@ -127,8 +171,9 @@ int vtkCellLocatorInterpolatedVelocityField::FunctionValues
 
         if ( retVal )
           {
-          this->LastDataSet     = vds;
-          this->LastCellLocator = loc;
+          this->LastDataSet      = vds;
+          this->LastCellLocator  = loc;
+          this->LastDataSetIndex = indices[i];
           vds = NULL;
           loc = NULL;
           return retVal;
@@ -173,6 +218,7 @@ int vtkCellLocatorInterpolatedVelocityField::FunctionValues
   int    numPts;
   int    pntIdx;
   int    bFound = 0;
+  int    inside = -1;
   double vector[3];
   double dstns2 = 0.0;
   double toler2 = dataset->GetLength() *
@@ -180,8 +226,8 @@ int vtkCellLocatorInterpolatedVelocityField::FunctionValues
 
   // check if the point is in the cached cell AND can be successfully evaluated
   if ( this->LastCellId != -1 &&
-       this->GenCell->EvaluatePosition
-             ( x, 0, subIdx, this->LastPCoords, dstns2, this->Weights ) == 1
+       ( inside = this->GenCell->EvaluatePosition
+             ( x, 0, subIdx, this->LastPCoords, dstns2, this->Weights ) ) == 1
      )
     {
     bFound = 1;
@@ -190,10 +236,20 @@ int vtkCellLocatorInterpolatedVelocityField::FunctionValues
 
   if ( !bFound )
     {
-    // cache missing or evaluation failure and then we have to find the cell
+    // cache missing or evaluation failure and then we have to find the cell,
+    // most likely the neighbor across the face the point went through
+    vtkIdType cellId = -1;
     this->CacheMiss += !(  !( this->LastCellId + 1 )  );
-    this->LastCellId = loc->FindCell( x, toler2, this->GenCell,
-                                      this->LastPCoords, this->Weights );
+    if ( inside == 0 )
+      {
+      cellId = this->FindNeighborCell( dataset, x, subIdx );
+      }
+    if ( cellId == -1 )
+      {
+      cellId = loc->FindCell( x, toler2, this->GenCell,
+                              this->LastPCoords, this->Weights );
+      }
+    this->LastCellId = cellId;
     bFound = !(  !( this->LastCellId + 1 )  );
     }
 
@@ -220,6 +276,38 @@ int vtkCellLocatorInterpolatedVelocityField::FunctionValues
   return  bFound;
 }
 
+//----------------------------------------------------------------------------
+vtkIdType vtkCellLocatorInterpolatedVelocityField::FindNeighborCell
+  ( vtkDataSet * dataset, double * x, int subId )
+{
+  // the neighbors are cheaply found through the links of unstructured grids
+  if ( this->LastCellId == -1 || this->GenCell->GetCellDimension() != 3 ||
+       !dataset->IsA( "vtkUnstructuredGrid" ) )
+    {
+    return -1;
+    }
+
+  // the face closest to the point, from its parametric coordinates
+  this->GenCell->CellBoundary( subId, this->LastPCoords, this->FacePoints );
+  dataset->GetCellNeighbors( this->LastCellId, this->FacePoints,
+                             this->Neighbors );
+
+  double dist2;
+  for ( vtkIdType i = 0; i < this->Neighbors->GetNumberOfIds(); i ++ )
+    {
+    vtkIdType cellId = this->Neighbors->GetId( i );
+    dataset->GetCell( cellId, this->GenCell );
+    if ( this->GenCell->EvaluatePosition
+           ( x, 0, subId, this->LastPCoords, dist2, this->Weights ) == 1 )
+      {
+      this->NeighborHit ++;
+      return cellId;
+      }
+    }
+
+  return -1;
+}
+
 //----------------------------------------------------------------------------
 void vtkCellLocatorInterpolatedVelocityField::AddDataSet( vtkDataSet * dataset )
 {
@@ -231,6 +319,7 @@ void vtkCellLocatorInterpolatedVelocityField::AddDataSet( vtkDataSet * dataset )
 
   // insert the dataset (do NOT register the dataset to 'this')
   this->DataSets->push_back( dataset );
+  this->AddDataSetBounds( dataset );
 
   // We need to attach a valid vtkAbstractCellLocator to any vtkPointSet for
   // robust cell location as vtkPointSet::FindCell() may incur failures. For
@@ -299,4 +388,5 @@ void vtkCellLocatorInterpolatedVelocityField::PrintSelf( ostream & os, vtkIndent
     }
   os << indent << "LastCellLocator: "      << this->LastCellLocator      << endl;
   os << indent << "CellLocatorPrototype: " << this->CellLocatorPrototype << endl;
+  os << indent << "NeighborHit: "          << this->NeighborHit          << endl;
 }
@@ -27,12 +27,14 @@
 //  within the previous cell, cell location is then simply skipped and vtkCell::
 //  EvaluatePosition() is called to obtain the new parametric coordinates and
 //  weights that are used to interpolate the velocity function values across the
-//  vertices of this cell. Otherwise a global cell (the target containing the next
-//  point) location is instead directly invoked, without exploiting the clue that
-//  vtkInterpolatedVelocityField makes use of from the previous cell (an immediate
-//  neighbor). Although ignoring the neighbor cell may incur a relatively high
-//  computational cost, vtkCellLocatorInterpolatedVelocityField is more robust in
-//  locating the target cell than its sibling class vtkInterpolatedVelocityField.
+//  vertices of this cell. Otherwise, for a vtkUnstructuredGrid, the neighbors of
+//  the previous cell across its face closest to the next point are tried, as the
+//  point usually moves to an immediate neighbor. If the point is not in any of
+//  them, a global cell (the target containing the next point) location is then
+//  invoked. Using the locator instead of the clue that vtkInterpolatedVelocityField
+//  takes from the previous cell, vtkCellLocatorInterpolatedVelocityField is more
+//  robust in locating the target cell than its sibling class
+//  vtkInterpolatedVelocityField.
 
 // .SECTION Caveats
 //  vtkCellLocatorInterpolatedVelocityField is not thread safe. A new instance
@@ -50,6 +52,7 @@
 #include "vtkCompositeInterpolatedVelocityField.h"
 
 class vtkAbstractCellLocator;
+class vtkIdList;
 class vtkCellLocatorInterpolatedVelocityFieldCellLocatorsType;
 
 class VTKFILTERSFLOWPATHS_EXPORT vtkCellLocatorInterpolatedVelocityField : public vtkCompositeInterpolatedVelocityField
@@ -78,6 +81,11 @@ public:
   // velocity field during integration.
   void SetCellLocatorPrototype( vtkAbstractCellLocator * prototype );
 
+  // Description:
+  // Get the number of cache misses resolved in a neighbor of the cached
+  // cell, across the face closest to the point, without a locator search.
+  vtkGetMacro( NeighborHit, int );
+
   // Description:
   // Import parameters. Sub-classes can add more after chaining.
   virtual void CopyParameters( vtkAbstractInterpolatedVelocityField * from );
@@ -121,7 +129,20 @@ protected:
   virtual int FunctionValues( vtkDataSet * ds, double * x, double * f )
     { return this->Superclass::FunctionValues( ds, x, f ); }
 
+  // Description:
+  // Look for the point x, just found out of the cached cell with subId and
+  // this->LastPCoords, in the neighbors of this cell across its face closest
+  // to x. This is done for vtkUnstructuredGrid only, whose cell links give
+  // the neighbors. Return the id of the cell containing x, which becomes
+  // this->GenCell, or -1 if none does.
+  vtkIdType FindNeighborCell( vtkDataSet * ds, double * x, int subId );
+
+  int NeighborHit;
+
 private:
+  vtkIdList * FacePoints;
+  vtkIdList * Neighbors;
+
   vtkAbstractCellLocator * LastCellLocator;
   vtkAbstractCellLocator * CellLocatorPrototype;
   vtkCellLocatorInterpolatedVelocityFieldCellLocatorsType * CellLocators;
@@ -21,17 +21,143 @@
 #include "vtkGenericCell.h"
 #include "vtkObjectFactory.h"
 
+#include <cmath>
+
+// The number of cells remembered in the datasets left by the point
+#define VTK_COMPOSITE_IVF_REMEMBERED_CELLS 4
 
 const double vtkCompositeInterpolatedVelocityField::TOLERANCE_SCALE = 1.0E-8;
 
+//----------------------------------------------------------------------------
+// The bounds of the datasets with a uniform grid of bins over them, each bin
+// listing the datasets overlapping it, and the cells remembered in the
+// datasets left by the point.
+class vtkCompositeInterpolatedVelocityFieldBlockIndex
+{
+public:
+  vtkCompositeInterpolatedVelocityFieldBlockIndex()
+    {
+    this->Valid = false;
+    this->NumberOfRemembered = 0;
+    this->NextRemembered = 0;
+    }
+
+  void Build();
+  int  GetBin( double * x );
+
+  // Six per dataset, inverted for empty datasets
+  std::vector< double > Bounds;
+  bool   Valid;
+  double Origin[3];
+  double BinSize[3];
+  int    Divisions[3];
+  std::vector< std::vector< int > > Bins;
+  std::vector< int > Found;
+
+  int       RememberedDataSets[VTK_COMPOSITE_IVF_REMEMBERED_CELLS];
+  vtkIdType RememberedCells[VTK_COMPOSITE_IVF_REMEMBERED_CELLS];
+  int       NumberOfRemembered;
+  int       NextRemembered;
+};
+
+//----------------------------------------------------------------------------
+void vtkCompositeInterpolatedVelocityFieldBlockIndex::Build()
+{
+  int i, j, numBlocks = 0;
+  int numDataSets = static_cast<int>( this->Bounds.size() / 6 );
+  double bounds[6] = { VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX, VTK_DOUBLE_MAX,
+                       -VTK_DOUBLE_MAX, VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX };
+  for ( i = 0; i < numDataSets; i ++ )
+    {
+    const double * b = &this->Bounds[6 * i];
+    if ( b[0] > b[1] )
+      {
+      continue;
+      }
+    numBlocks ++;
+    for ( j = 0; j < 3; j ++ )
+      {
+      bounds[2 * j]     = ( b[2 * j] < bounds[2 * j] ) ? b[2 * j] : bounds[2 * j];
+      bounds[2 * j + 1] = ( b[2 * j + 1] > bounds[2 * j + 1] ) ?
+                          b[2 * j + 1] : bounds[2 * j + 1];
+      }
+    }
+
+  this->Bins.clear();
+  this->Valid = true;
+  if ( !numBlocks )
+    {
+    return;
+    }
 
+  // about one bin per dataset, as the datasets usually tile the domain
+  int divisions = static_cast<int>
+    (  ceil( pow( static_cast<double>( numBlocks ), 1.0 / 3.0 ) - 1.0E-6 )  );
+  for ( j = 0; j < 3; j ++ )
+    {
+    this->Origin[j]    = bounds[2 * j];
+    this->Divisions[j] = ( bounds[2 * j + 1] > bounds[2 * j] ) ? divisions : 1;
+    this->BinSize[j]   = ( bounds[2 * j + 1] - bounds[2 * j] ) /
+                         this->Divisions[j];
+    }
+  this->Bins.resize( this->Divisions[0] * this->Divisions[1] *
+                     this->Divisions[2] );
+
+  double lo[3], hi[3];
+  for ( i = 0; i < numDataSets; i ++ )
+    {
+    const double * b = &this->Bounds[6 * i];
+    if ( b[0] > b[1] )
+      {
+      continue;
+      }
+    lo[0] = b[0]; lo[1] = b[2]; lo[2] = b[4];
+    hi[0] = b[1]; hi[1] = b[3]; hi[2] = b[5];
+    int first = this->GetBin( lo );
+    int last  = this->GetBin( hi );
+    int firstIjk[3] = { first % this->Divisions[0],
+                        ( first / this->Divisions[0] ) % this->Divisions[1],
+                        first / ( this->Divisions[0] * this->Divisions[1] ) };
+    int lastIjk[3]  = { last % this->Divisions[0],
+                        ( last / this->Divisions[0] ) % this->Divisions[1],
+                        last / ( this->Divisions[0] * this->Divisions[1] ) };
+    for ( int k = firstIjk[2]; k <= lastIjk[2]; k ++ )
+      {
+      for ( int jj = firstIjk[1]; jj <= lastIjk[1]; jj ++ )
+        {
+        for ( int ii = firstIjk[0]; ii <= lastIjk[0]; ii ++ )
+          {
+          this->Bins[ ii + this->Divisions[0] *
+                      ( jj + this->Divisions[1] * k ) ].push_back( i );
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkCompositeInterpolatedVelocityFieldBlockIndex::GetBin( double * x )
+{
+  int ijk[3];
+  for ( int j = 0; j < 3; j ++ )
+    {
+    ijk[j] = ( this->BinSize[j] > 0.0 ) ? static_cast<int>
+      (  floor( ( x[j] - this->Origin[j] ) / this->BinSize[j] )  ) : 0;
+    ijk[j] = ( ijk[j] < 0 ) ? 0 : ijk[j];
+    ijk[j] = ( ijk[j] >= this->Divisions[j] ) ? this->Divisions[j] - 1 : ijk[j];
+    }
+  return ijk[0] + this->Divisions[0] * ( ijk[1] + this->Divisions[1] * ijk[2] );
+}
+
+//----------------------------------------------------------------------------
 vtkCompositeInterpolatedVelocityField::vtkCompositeInterpolatedVelocityField()
 {
   this->LastDataSetIndex = 0;
   this->DataSets = new vtkCompositeInterpolatedVelocityFieldDataSetsType;
+  this->BlockIndex = new vtkCompositeInterpolatedVelocityFieldBlockIndex;
 }
 
-
+//----------------------------------------------------------------------------
 vtkCompositeInterpolatedVelocityField::~vtkCompositeInterpolatedVelocityField()
 {
   if ( this->DataSets )
@@ -39,12 +165,168 @@ vtkCompositeInterpolatedVelocityField::~vtkCompositeInterpolatedVelocityField()
     delete this->DataSets;
     this->DataSets = NULL;
     }
+
+  delete this->BlockIndex;
+  this->BlockIndex = NULL;
+}
+
+//----------------------------------------------------------------------------
+void vtkCompositeInterpolatedVelocityField::AddDataSetBounds
+  ( vtkDataSet * dataset )
+{
+  // a point is found in a cell up to a parametric tolerance, relative to the
+  // size of the cell, hence the margin relative to the size of the dataset
+  double bounds[6];
+  dataset->GetBounds( bounds );
+  if ( dataset->GetNumberOfCells() > 0 && bounds[0] <= bounds[1] )
+    {
+    double length = dataset->GetLength();
+    double margin = length * 0.01 +
+      sqrt( length * vtkCompositeInterpolatedVelocityField::TOLERANCE_SCALE );
+    for ( int j = 0; j < 3; j ++ )
+      {
+      bounds[2 * j]     -= margin;
+      bounds[2 * j + 1] += margin;
+      }
+    }
+  else
+    {
+    bounds[0] = bounds[2] = bounds[4] = 1.0;
+    bounds[1] = bounds[3] = bounds[5] = -1.0;
+    }
+
+  this->BlockIndex->Bounds.insert( this->BlockIndex->Bounds.end(),
+                                   bounds, bounds + 6 );
+  this->BlockIndex->Valid = false;
+}
+
+//----------------------------------------------------------------------------
+bool vtkCompositeInterpolatedVelocityField::DataSetBoundsContain
+  ( int dataindex, double * x )
+{
+  // a dataset added without its bounds may contain any point
+  if ( 6 * dataindex + 6 > static_cast<int>( this->BlockIndex->Bounds.size() ) )
+    {
+    return true;
+    }
+
+  const double * bounds = &this->BlockIndex->Bounds[6 * dataindex];
+  return x[0] >= bounds[0] && x[0] <= bounds[1] &&
+         x[1] >= bounds[2] && x[1] <= bounds[3] &&
+         x[2] >= bounds[4] && x[2] <= bounds[5];
+}
+
+//----------------------------------------------------------------------------
+int vtkCompositeInterpolatedVelocityField::FindDataSets
+  ( double * x, const int * & indices )
+{
+  vtkCompositeInterpolatedVelocityFieldBlockIndex * index = this->BlockIndex;
+  int numDataSets = static_cast<int>( this->DataSets->size() );
+  index->Found.clear();
+
+  if ( static_cast<int>( index->Bounds.size() ) != 6 * numDataSets )
+    {
+    // without the bounds of every dataset, all of them are searched
+    for ( int i = 0; i < numDataSets; i ++ )
+      {
+      index->Found.push_back( i );
+      }
+    }
+  else
+    {
+    if ( !index->Valid )
+      {
+      index->Build();
+      }
+    if ( !index->Bins.empty() )
+      {
+      const std::vector< int > & bin = index->Bins[ index->GetBin( x ) ];
+      for ( size_t i = 0; i < bin.size(); i ++ )
+        {
+        if ( this->DataSetBoundsContain( bin[i], x ) )
+          {
+          index->Found.push_back( bin[i] );
+          }
+        }
+      }
+    }
+
+  indices = index->Found.empty() ? NULL : &index->Found[0];
+  return static_cast<int>( index->Found.size() );
+}
+
+//----------------------------------------------------------------------------
+void vtkCompositeInterpolatedVelocityField::RememberCell
+  ( int dataindex, vtkIdType cellId )
+{
+  vtkCompositeInterpolatedVelocityFieldBlockIndex * index = this->BlockIndex;
+  for ( int i = 0; i < index->NumberOfRemembered; i ++ )
+    {
+    if ( index->RememberedDataSets[i] == dataindex )
+      {
+      index->RememberedCells[i] = cellId;
+      return;
+      }
+    }
+
+  index->RememberedDataSets[index->NextRemembered] = dataindex;
+  index->RememberedCells[index->NextRemembered] = cellId;
+  index->NextRemembered = ( index->NextRemembered + 1 ) %
+                          VTK_COMPOSITE_IVF_REMEMBERED_CELLS;
+  if ( index->NumberOfRemembered < VTK_COMPOSITE_IVF_REMEMBERED_CELLS )
+    {
+    index->NumberOfRemembered ++;
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkCompositeInterpolatedVelocityField::FindRememberedCell( double * x )
+{
+  vtkCompositeInterpolatedVelocityFieldBlockIndex * index = this->BlockIndex;
+  int    subId;
+  double dist2;
+
+  // the most recently remembered cells first
+  for ( int i = 0; i < index->NumberOfRemembered; i ++ )
+    {
+    int entry = ( index->NextRemembered - 1 - i +
+                  VTK_COMPOSITE_IVF_REMEMBERED_CELLS ) %
+                VTK_COMPOSITE_IVF_REMEMBERED_CELLS;
+    int dataindex = index->RememberedDataSets[entry];
+    if ( dataindex == this->LastDataSetIndex ||
+         dataindex >= static_cast<int>( this->DataSets->size() ) ||
+         !this->DataSetBoundsContain( dataindex, x ) )
+      {
+      continue;
+      }
+
+    ( *this->DataSets )[dataindex]->GetCell( index->RememberedCells[entry],
+                                             this->GenCell );
+    if ( this->GenCell->EvaluatePosition( x, 0, subId, this->LastPCoords,
+                                          dist2, this->Weights ) == 1 )
+      {
+      this->LastCellId = index->RememberedCells[entry];
+      return dataindex;
+      }
+    }
+
+  return -1;
+}
+
+//----------------------------------------------------------------------------
+void vtkCompositeInterpolatedVelocityField::ForgetRememberedCells()
+{
+  this->BlockIndex->NumberOfRemembered = 0;
+  this->BlockIndex->NextRemembered = 0;
 }
 
+//----------------------------------------------------------------------------
 void vtkCompositeInterpolatedVelocityField::PrintSelf( ostream & os, vtkIndent indent )
 {
   this->Superclass::PrintSelf( os, indent );
 
   os << indent << "DataSets: "           << this->DataSets         << endl;
   os << indent << "Last Dataset Index: " << this->LastDataSetIndex << endl;
+  os << indent << "Remembered Cells: "
+     << this->BlockIndex->NumberOfRemembered << endl;
 }
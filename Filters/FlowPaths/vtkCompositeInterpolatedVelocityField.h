@@ -52,6 +52,14 @@
 //  fast robust cell location). Without the involvement of vtkPointLocator, robust
 //  cell location is achieved for vtkPointSet.
 //
+//  When the point leaves the most recently visited dataset, the datasets are
+//  searched through a uniform grid of bins over their bounds, so that only
+//  those whose bounds contain the point are searched, in the order they were
+//  added. Before that, the cells last visited in a few other datasets are
+//  tried, as a streamline crossing the boundary between two datasets often
+//  comes back to them. These cells are forgotten when the last cell is reset
+//  through SetLastCellId( -1, index ), e.g., at the start of a streamline.
+//
 // .SECTION Caveats
 //  vtkCompositeInterpolatedVelocityField is not thread safe. A new instance
 //  should be created by each thread.
@@ -78,6 +86,7 @@ class vtkDataArray;
 class vtkPointData;
 class vtkGenericCell;
 class vtkCompositeInterpolatedVelocityFieldDataSetsType;
+class vtkCompositeInterpolatedVelocityFieldBlockIndex;
 
 class VTKFILTERSFLOWPATHS_EXPORT vtkCompositeInterpolatedVelocityField : public vtkAbstractInterpolatedVelocityField
 {
@@ -113,7 +122,41 @@ protected:
   int       LastDataSetIndex;
   vtkCompositeInterpolatedVelocityFieldDataSetsType * DataSets;
 
+  // Description:
+  // Record the bounds of the dataset just added to this->DataSets. They are
+  // enlarged by the tolerance of the cell search, so that a point outside of
+  // them can not be found in the dataset.
+  void AddDataSetBounds( vtkDataSet * dataset );
+
+  // Description:
+  // Return whether the bounds of a dataset contain the point x.
+  bool DataSetBoundsContain( int dataindex, double * x );
+
+  // Description:
+  // Find the datasets whose bounds contain the point x, through the bins
+  // built over the bounds of all the datasets. Return their number, with
+  // their indices in increasing order in indices, which remain valid until
+  // the next call.
+  int FindDataSets( double * x, const int * & indices );
+
+  // Description:
+  // Remember a cell of a dataset, left by the point, replacing the cell last
+  // remembered for this dataset or the oldest one remembered.
+  void RememberCell( int dataindex, vtkIdType cellId );
+
+  // Description:
+  // Look for the point x in the cells remembered for the datasets other than
+  // the most recently visited one. Return the index of the dataset of the
+  // cell containing x, which becomes the last cell, or -1 if none does.
+  int FindRememberedCell( double * x );
+
+  // Description:
+  // Forget all the remembered cells.
+  void ForgetRememberedCells();
+
 private:
+  vtkCompositeInterpolatedVelocityFieldBlockIndex * BlockIndex;
+
   vtkCompositeInterpolatedVelocityField
     ( const vtkCompositeInterpolatedVelocityField & );  // Not implemented.
   void operator = ( const vtkCompositeInterpolatedVelocityField & );  // Not implemented.
@@ -31,6 +31,7 @@ void vtkInterpolatedVelocityField::AddDataSet( vtkDataSet * dataset )
 
   // insert the dataset (do NOT register the dataset to 'this')
   this->DataSets->push_back( dataset );
+  this->AddDataSetBounds( dataset );
 
   int size = dataset->GetMaxCellSize();
   if ( size > this->WeightsSize )
@@ -59,6 +60,12 @@ void vtkInterpolatedVelocityField::SetLastCellId( vtkIdType c, int dataindex )
   }
 
   this->LastDataSetIndex = dataindex;
+
+  // a reset starts over, e.g., with a new streamline
+  if ( this->LastCellId == -1 )
+    {
+    this->ForgetRememberedCells();
+    }
 }
 
 //----------------------------------------------------------------------------
@@ -76,22 +83,54 @@ int vtkInterpolatedVelocityField::FunctionValues( double * x, double * f )
     ds = this->LastDataSet;
     }
 
-  int retVal = this->FunctionValues( ds, x, f );
+  // skip the dataset at once if the point is out of its bounds
+  vtkIdType lastCellId = this->LastCellId;
+  int retVal = 0;
+  if ( this->DataSetBoundsContain( this->LastDataSetIndex, x ) )
+    {
+    retVal = this->FunctionValues( ds, x, f );
+    }
+  else
+    {
+    f[0] = f[1] = f[2] = 0.0;
+    }
 
   if ( !retVal )
     {
-    for( this->LastDataSetIndex = 0;
-         this->LastDataSetIndex < static_cast<int>( this->DataSets->size() );
-         this->LastDataSetIndex ++ )
+    this->ClearLastCellId();
+
+    // the point may come back to a cell it left in another dataset
+    if ( this->Caching )
+      {
+      if ( lastCellId != -1 )
+        {
+        this->RememberCell( this->LastDataSetIndex, lastCellId );
+        }
+      int dataindex = this->FindRememberedCell( x );
+      if ( dataindex != -1 &&
+           ( retVal = this->FunctionValues( ( *this->DataSets )[dataindex],
+                                            x, f ) ) )
+        {
+        this->LastDataSet      = ( *this->DataSets )[dataindex];
+        this->LastDataSetIndex = dataindex;
+        return retVal;
+        }
+      }
+
+    // otherwise search the datasets whose bounds contain the point
+    const int * indices;
+    int numDataSets = this->FindDataSets( x, indices );
+    for ( int i = 0; i < numDataSets; i ++ )
       {
-      ds = this->DataSets->operator[]( this->LastDataSetIndex );
+      ds = ( *this->DataSets )[ indices[i] ];
       if( ds && ds != this->LastDataSet )
         {
         this->ClearLastCellId();
         retVal = this->FunctionValues( ds, x, f );
         if ( retVal )
           {
-          this->LastDataSet = ds;
+          this->LastDataSet      = ds;
+          this->LastDataSetIndex = indices[i];
           return retVal;
           }
         }
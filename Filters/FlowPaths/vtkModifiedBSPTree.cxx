@@ -18,6 +18,8 @@
 #include "vtkPolyData.h"
 #include "vtkGenericCell.h"
 #include "vtkIdListCollection.h"
+#include "vtkMultiThreader.h"
+#include "vtkCriticalSection.h"
 
 #include <stack>
 #include <vector>
@@ -45,6 +47,7 @@ vtkModifiedBSPTree::vtkModifiedBSPTree(void)
   this->mRoot                      = NULL;
   this->UseExistingSearchStructure = 0;
   this->LazyEvaluation             = 1;
+  this->Tasks                      = NULL;
   //
   this->npn = this->nln = this->tot_depth = 0;
 }
@@ -79,8 +82,6 @@ public:
 
 typedef cell_extents *cell_extents_List;
 
-static int global_list_count = 0;
-
 class Sorted_cell_extents_Lists
 {
 public:
@@ -94,7 +95,6 @@ public:
       Mins[i] = new cell_extents[nCells]; // max num <= nCells/2 ?
       Maxs[i] = new cell_extents[nCells];
       }
-    global_list_count += 1;
   };
   ~Sorted_cell_extents_Lists(void)
   {
@@ -103,7 +103,6 @@ public:
       delete [](Mins[i]);
       delete [](Maxs[i]);
       }
-    global_list_count -= 1;
   }
 };
 
@@ -135,6 +134,102 @@ extern "C" int __compareMax(const void *pA, const void *B )
     }
 }
 
+typedef std::stack<BSPNode*, std::vector<BSPNode*> > nodestack;
+
+//////////////////////////////////////////////////////////////////////////////
+// Parallel construction : the lists of the root are sorted concurrently,
+// then the top levels are subdivided serially, leaving the nodes below
+// them as tasks that the threads take in turn.
+//////////////////////////////////////////////////////////////////////////////
+class vtkModifiedBSPTreeTasks
+{
+public:
+  struct Task
+  {
+    BSPNode                   *Node;
+    Sorted_cell_extents_Lists *Lists;
+    vtkIdType                  NumberOfCells;
+    int                        Depth;
+  };
+  //
+  vtkModifiedBSPTree       *Tree;
+  std::vector<Task>         Tasks;
+  int                       Depth;     // depth of the deferred nodes
+  Sorted_cell_extents_Lists *RootLists; // lists sorted by the threads
+  vtkIdType                 NumberOfCells;
+  int                       NumberOfThreads;
+  size_t                    NextTask;
+  vtkSimpleCriticalSection  Lock;
+  //
+  // Keep a copy of the lists, the caller deletes them
+  void Defer(BSPNode *node, Sorted_cell_extents_Lists *lists,
+             vtkIdType nCells, int depth)
+  {
+    Task task;
+    task.Node = node;
+    task.Lists = new Sorted_cell_extents_Lists(nCells);
+    for (int i=0; i<3; i++)
+      {
+      std::copy(lists->Mins[i], lists->Mins[i]+nCells, task.Lists->Mins[i]);
+      std::copy(lists->Maxs[i], lists->Maxs[i]+nCells, task.Lists->Maxs[i]);
+      }
+    task.NumberOfCells = nCells;
+    task.Depth = depth;
+    this->Tasks.push_back(task);
+  }
+  //
+  void Run()
+  {
+    int maxDepth = 0; // the tree depth is computed once it is built
+    while (true)
+      {
+      this->Lock.Lock();
+      size_t next = this->NextTask++;
+      this->Lock.Unlock();
+      if (next >= this->Tasks.size())
+        {
+        break;
+        }
+      Task &task = this->Tasks[next];
+      this->Tree->Subdivide(task.Node, task.Lists, this->Tree->DataSet,
+                            task.NumberOfCells, task.Depth,
+                            this->Tree->MaxLevel,
+                            this->Tree->NumberOfCellsPerNode, maxDepth);
+      delete task.Lists;
+      task.Lists = NULL;
+      }
+  }
+};
+
+static VTK_THREAD_RETURN_TYPE vtkModifiedBSPTreeSortExecute(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkModifiedBSPTreeTasks *tasks =
+    static_cast<vtkModifiedBSPTreeTasks *>(info->UserData);
+  Sorted_cell_extents_Lists *lists = tasks->RootLists;
+  for (int k=info->ThreadID; k<6; k+=tasks->NumberOfThreads)
+    {
+    if (k<3)
+      {
+      qsort( lists->Mins[k], tasks->NumberOfCells, sizeof(cell_extents), __compareMin) ;
+      }
+    else
+      {
+      qsort( lists->Maxs[k-3], tasks->NumberOfCells, sizeof(cell_extents), __compareMax) ;
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+static VTK_THREAD_RETURN_TYPE vtkModifiedBSPTreeSubdivideExecute(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  static_cast<vtkModifiedBSPTreeTasks *>(info->UserData)->Run();
+  return VTK_THREAD_RETURN_VALUE;
+}
+
 //---------------------------------------------------------------------------
 //---------------------------------------------------------------------------
 //---------------------------------------------------------------------------
@@ -200,7 +295,7 @@ void vtkModifiedBSPTree::BuildLocatorInternal()
 
   // create the root node
   this->mRoot = new BSPNode();
-  this->mRoot->mAxis = rand() % 3;
+  this->mRoot->mAxis = 0; // the tree must not depend on rand()
   this->mRoot->depth = 0;
   //
   if (numCells==0)
@@ -210,6 +305,22 @@ void vtkModifiedBSPTree::BuildLocatorInternal()
   //
   this->StoreCellBounds();
   //
+  int numThreads = this->NumberOfThreads;
+  if (numThreads > numCells)
+    {
+    numThreads = static_cast<int>(numCells);
+    }
+  vtkModifiedBSPTreeTasks tasks;
+  tasks.Tree = this;
+  tasks.NumberOfCells = numCells;
+  tasks.NumberOfThreads = numThreads;
+  tasks.NextTask = 0;
+  tasks.Depth = 0;
+  while ((1 << tasks.Depth) < 8*numThreads)
+    {
+    tasks.Depth++;
+    }
+  //
   // sort the cells into 6 lists using structure for subdividing tests
   Sorted_cell_extents_Lists *lists = new Sorted_cell_extents_Lists(numCells);
   for (int i=0; i<3; i++)
@@ -224,23 +335,68 @@ void vtkModifiedBSPTree::BuildLocatorInternal()
       lists->Maxs[i][j].max   = CellBounds[j][i*2+1];
       lists->Maxs[i][j].cell_ID = j;
       }
-    // Sort
-    qsort( lists->Mins[i], numCells, sizeof(cell_extents), __compareMin) ;
-    qsort( lists->Maxs[i], numCells, sizeof(cell_extents), __compareMax) ;
     }
+  // Sort, one list per thread
+  tasks.RootLists = lists;
+  vtkMultiThreader *threader = vtkMultiThreader::New();
+  threader->SetNumberOfThreads(numThreads < 6 ? numThreads : 6);
+  tasks.NumberOfThreads = threader->GetNumberOfThreads();
+  threader->SetSingleMethod(vtkModifiedBSPTreeSortExecute, &tasks);
+  threader->SingleMethodExecute();
+  tasks.NumberOfThreads = numThreads;
   //
   // call the recursive subdivision routine
   //
   vtkDebugMacro( << "Beginning Subdivision" );
   //
-  if (numCells>0)
+  int maxDepth = 0;
+  if (numThreads > 1)
     {
-    Subdivide(this->mRoot, lists, this->DataSet, numCells, 0,
-              this->MaxLevel, this->NumberOfCellsPerNode, this->Level);
+    this->Tasks = &tasks;
     }
+  Subdivide(this->mRoot, lists, this->DataSet, numCells, 0,
+            this->MaxLevel, this->NumberOfCellsPerNode, maxDepth);
+  this->Tasks = NULL;
   delete lists;
   // Child nodes are responsible for freeing the temporary sorted lists
   //
+  if (!tasks.Tasks.empty())
+    {
+    threader->SetNumberOfThreads(numThreads);
+    threader->SetSingleMethod(vtkModifiedBSPTreeSubdivideExecute, &tasks);
+    threader->SingleMethodExecute();
+    }
+  threader->Delete();
+  //
+  // Gather the statistics of the tree
+  nodestack ns;
+  ns.push(this->mRoot);
+  while (!ns.empty())
+    {
+    BSPNode *node = ns.top();
+    ns.pop();
+    if (node->depth > this->Level)
+      {
+      this->Level = node->depth;
+      }
+    if (node->mChild[0])
+      {
+      npn += 1; // Parent node
+      for (int i=0; i<3; i++)
+        {
+        if (node->mChild[i])
+          {
+          ns.push(node->mChild[i]);
+          }
+        }
+      }
+    else
+      {
+      nln += 1; // Leaf node
+      tot_depth += node->depth;
+      }
+    }
+  //
   this->BuildTime.Modified();
   //
   double av_depth = (double)tot_depth/nln; (void)av_depth;
@@ -281,6 +437,14 @@ void vtkModifiedBSPTree::Subdivide(BSPNode *node,
   // Make sure child nodes are clear to start with
   node->mChild[2] = node->mChild[1] = node->mChild[0] = NULL;
   //
+  // Leave the nodes below the top levels to the threads
+  if (this->Tasks && depth == this->Tasks->Depth &&
+      (nCells > maxCells) && (depth < maxlevel))
+    {
+    this->Tasks->Defer(node, lists, nCells, depth);
+    return;
+    }
+  //
   // Do we want to subdivide this node ?
   //
   double pDiv = 0.0;
@@ -327,7 +491,8 @@ void vtkModifiedBSPTree::Subdivide(BSPNode *node,
         {
         node->mChild[i]    = new BSPNode();
         node->mChild[i]->depth = node->depth+1;
-        node->mChild[i]->mAxis = rand() % 3;
+        // rand() is not thread-safe: rotate the first axis tested instead
+        node->mChild[i]->mAxis = (node->mAxis + 1 + i) % 3;
         }
       Daxis = node->mAxis;
       Sorted_cell_extents_Lists *left  = new Sorted_cell_extents_Lists(nCells);
@@ -498,8 +663,6 @@ void vtkModifiedBSPTree::Subdivide(BSPNode *node,
                   }
                 delete right;
                 //
-                npn += 1; // Parent node
-                //
                 // we've done all we were asked to do
                 //
                 return;
@@ -511,8 +674,6 @@ void vtkModifiedBSPTree::Subdivide(BSPNode *node,
   //
   // Copy the cell IDs into the actual node structure for proper use
   node->num_cells = nCells;
-  nln += 1; // Leaf node
-  tot_depth += node->depth;
   for (int i=0; i<6; i++)
     {
     node->sorted_cell_lists[i] = new vtkIdType[nCells];
@@ -549,7 +710,6 @@ public:
 };
 
 typedef std::vector<_box> boxlist;
-typedef std::stack<BSPNode*, std::vector<BSPNode*> > nodestack;
 
 void vtkModifiedBSPTree::GenerateRepresentation(int level, vtkPolyData *pd)
 {
@@ -656,6 +816,13 @@ int BSPNode::getDominantAxis(const double dir[3])
     }
 }
 //---------------------------------------------------------------------------
+int vtkModifiedBSPTree::IntersectWithLine(double p1[3], double p2[3], double tol,
+                                          double &t, double x[3], double pcoords[3], int &subId, vtkIdType &cellId)
+{
+  return this->IntersectWithLine(p1, p2, tol, t, x, pcoords, subId, cellId,
+                                 this->GenericCell);
+}
+//---------------------------------------------------------------------------
 int vtkModifiedBSPTree::IntersectWithLine(double p1[3],
                                           double p2[3],
                                           double tol,
@@ -665,17 +832,6 @@ int vtkModifiedBSPTree::IntersectWithLine(double p1[3],
                                           int &subId,
                                           vtkIdType &cellId,
                                           vtkGenericCell *cell)
-{
-  int hit = this->IntersectWithLine(p1, p2, tol, t, x, pcoords, subId, cellId);
-  if (hit)
-    {
-    this->DataSet->GetCell(cellId, cell);
-    }
-  return hit;
-}
-//---------------------------------------------------------------------------
-int vtkModifiedBSPTree::IntersectWithLine(double p1[3], double p2[3], double tol,
-                                          double &t, double x[3], double pcoords[3], int &subId, vtkIdType &cellId)
 {
   //
   BSPNode  *node, *Near, *Mid, *Far;
@@ -759,7 +915,8 @@ int vtkModifiedBSPTree::IntersectWithLine(double p1[3], double p2[3], double tol
         node = Near;
         }
       }
-    double t_hit, ipt[3];
+    double t_hit, ipt[3], ipcoords[3];
+    int isubId;
     // Ok, so we're a leaf node, first check the BBox against the ray
     // then test the candidates in our sorted ray direction order
     _tmin = tmin; _tmax = tmax;
@@ -779,7 +936,7 @@ int vtkModifiedBSPTree::IntersectWithLine(double p1[3], double p2[3], double tol
       ctmin = _tmin; ctmax = _tmax;
       if (BSPNode::RayMinMaxT(CellBounds[cell_ID], p1, ray_vec, ctmin, ctmax))
         {
-        if (this->IntersectCellInternal(cell_ID, p1, p2, tol, t_hit, ipt, pcoords, subId))
+        if (this->IntersectCellInternal(cell_ID, p1, p2, tol, t_hit, ipt, ipcoords, isubId, cell))
           {
           if (t_hit<closest_intersection)
             {
@@ -789,6 +946,10 @@ int vtkModifiedBSPTree::IntersectWithLine(double p1[3], double p2[3], double tol
             x[0] = ipt[0];
             x[1] = ipt[1];
             x[2] = ipt[2];
+            pcoords[0] = ipcoords[0];
+            pcoords[1] = ipcoords[1];
+            pcoords[2] = ipcoords[2];
+            subId = isubId;
             }
           }
         }
@@ -798,6 +959,8 @@ int vtkModifiedBSPTree::IntersectWithLine(double p1[3], double p2[3], double tol
   if (HIT)
     {
     t = closest_intersection;
+    // the cell last tested may not be the closest one
+    this->DataSet->GetCell(cellId, cell);
     }
   //
   return HIT;
@@ -933,7 +1096,7 @@ int vtkModifiedBSPTree::IntersectWithLine(
       ctmin = _tmin; ctmax = _tmax;
       if (BSPNode::RayMinMaxT(CellBounds[cell_ID], p1, ray_vec, ctmin, ctmax))
         {
-        if (this->IntersectCellInternal(cell_ID, p1, p2, tol, t_hit, ipt, pcoords, subId))
+        if (this->IntersectCellInternal(cell_ID, p1, p2, tol, t_hit, ipt, pcoords, subId, this->GenericCell))
           {
           if (points)
             {
@@ -987,10 +1150,20 @@ int vtkModifiedBSPTree::IntersectCellInternal(
   double &t,
   double ipt[3],
   double pcoords[3],
-  int &subId)
+  int &subId,
+  vtkGenericCell *cell)
+{
+  this->DataSet->GetCell(cell_ID, cell);
+  return cell->IntersectWithLine(const_cast<double*>(p1), const_cast<double*>(p2), tol, t, ipt, pcoords, subId);
+}
+
+//---------------------------------------------------------------------------
+vtkModifiedBSPTree::RemovedIntersectCellInternal
+vtkModifiedBSPTree::IntersectCellInternal(
+  vtkIdType, const double[3], const double[3], const double, double &,
+  double[3], double[3], int &)
 {
-  this->DataSet->GetCell(cell_ID, this->GenericCell);
-  return this->GenericCell->IntersectWithLine(const_cast<double*>(p1), const_cast<double*>(p2), tol, t, ipt, pcoords, subId);
+  return RemovedIntersectCellInternal();
 }
 //////////////////////////////////////////////////////////////////////////////
 // FindCell stuff
@@ -150,6 +150,7 @@ class BSPNode;
 class vtkGenericCell;
 class vtkIdList;
 class vtkIdListCollection;
+class vtkModifiedBSPTreeTasks;
 //ETX
 
 class VTKFILTERSFLOWPATHS_EXPORT vtkModifiedBSPTree : public vtkAbstractCellLocator {
@@ -204,6 +205,8 @@ class VTKFILTERSFLOWPATHS_EXPORT vtkModifiedBSPTree : public vtkAbstractCellLoca
   // Description:
   // Return intersection point (if any) AND the cell which was intersected by
   // the finite line. The cell is returned as a cell id and as a generic cell.
+  // The cells are tested with the given generic cell, so several threads
+  // may call this method at once, each with its own cell.
   virtual int IntersectWithLine(
     double p1[3], double p2[3], double tol, double &t, double x[3],
     double pcoords[3], int &subId, vtkIdType &cellId, vtkGenericCell *cell);
@@ -259,12 +262,23 @@ class VTKFILTERSFLOWPATHS_EXPORT vtkModifiedBSPTree : public vtkAbstractCellLoca
   protected:
    vtkModifiedBSPTree();
   ~vtkModifiedBSPTree();
+
+  // Description:
+  // FindCell() traverses the tree with a stack of its own.
+  virtual int IsFindCellThreadSafe() { return 1; }
+
+  // Description:
+  // IntersectWithLine() tests the cells with the caller's generic cell.
+  virtual int IsIntersectWithLineThreadSafe() { return 1; }
   //
   BSPNode  *mRoot;               // bounding box root node
   int       npn;
   int       nln;
   int       tot_depth;
 //BTX
+  // Nodes left to subdivide by the threads, while the top levels are built
+  vtkModifiedBSPTreeTasks *Tasks;
+  friend class vtkModifiedBSPTreeTasks;
   //
   // The main subdivision routine
   void Subdivide(BSPNode *node, Sorted_cell_extents_Lists *lists, vtkDataSet *dataSet,
@@ -273,15 +287,29 @@ class VTKFILTERSFLOWPATHS_EXPORT vtkModifiedBSPTree : public vtkAbstractCellLoca
   // We provide a function which does the cell/ray test so that
   // it can be overriden by subclasses to perform special treatment
   // (Example : Particles stored in tree, have no dimension, so we must
-  // override the cell test to return a value based on some particle size
+  // override the cell test to return a value based on some particle size.
+  // The cell is loaded into the given generic cell, which belongs to the
+  // calling thread.
   virtual int IntersectCellInternal(vtkIdType cell_ID, const double p1[3], const double p2[3],
-    const double tol, double &t, double ipt[3], double pcoords[3], int &subId);
+    const double tol, double &t, double ipt[3], double pcoords[3], int &subId,
+    vtkGenericCell *cell);
 
 //ETX
   void BuildLocatorIfNeeded();
   void ForceBuildLocator();
   void BuildLocatorInternal();
 private:
+//BTX
+  // The cell test without a generic cell was removed, as the traversals
+  // only call the one taking the generic cell. Declaring it with another return type turns
+  // the overrides left in subclasses into compile errors, instead of
+  // silently bypassing them.
+  struct RemovedIntersectCellInternal {};
+  virtual RemovedIntersectCellInternal IntersectCellInternal(
+    vtkIdType cell_ID, const double p1[3], const double p2[3],
+    const double tol, double &t, double ipt[3], double pcoords[3],
+    int &subId);
+//ETX
   vtkModifiedBSPTree(const vtkModifiedBSPTree&);  // Not implemented.
   void operator=(const vtkModifiedBSPTree&);      // Not implemented.
 };
@@ -18,6 +18,7 @@ PURPOSE.  See the above copyright notice for more information.
 #include "vtkCellData.h"
 #include "vtkCompositeDataIterator.h"
 #include "vtkCompositeDataPipeline.h"
+#include "vtkCriticalSection.h"
 #include "vtkDataSetAttributes.h"
 #include "vtkDoubleArray.h"
 #include "vtkExecutive.h"
@@ -31,6 +32,7 @@ PURPOSE.  See the above copyright notice for more information.
 #include "vtkCharArray.h"
 #include "vtkMath.h"
 #include "vtkMultiBlockDataSet.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
 #include "vtkPointSet.h"
@@ -108,6 +110,149 @@ namespace
   }
 };
 
+//---------------------------------------------------------------------------
+namespace
+{
+  // Remove the flagged tuples of an array of numComp components per tuple
+  template <class T>
+  void CompactArray(std::vector<T> &a, const std::vector<char> &removed,
+                    int numComp)
+  {
+    size_t n = 0;
+    for (size_t i=0; i<removed.size(); i++)
+      {
+      if (!removed[i])
+        {
+        if (n != i)
+          {
+          for (int c=0; c<numComp; c++)
+            {
+            a[n*numComp+c] = a[i*numComp+c];
+            }
+          }
+        n++;
+        }
+      }
+    a.resize(n*numComp);
+  }
+};
+
+//---------------------------------------------------------------------------
+void vtkParticleTracerBaseNamespace::ParticleStore::clear()
+{
+  this->Position.clear();
+  this->CachedDataSetId.clear();
+  this->CachedCellId.clear();
+  this->LocationState.clear();
+  this->SourceID.clear();
+  this->TimeStepAge.clear();
+  this->InjectedPointId.clear();
+  this->InjectedStepId.clear();
+  this->UniqueParticleId.clear();
+  this->ErrorCode.clear();
+  this->Age.clear();
+  this->Rotation.clear();
+  this->AngularVel.clear();
+  this->Time.clear();
+  this->Speed.clear();
+  this->PointId.clear();
+}
+
+//---------------------------------------------------------------------------
+void vtkParticleTracerBaseNamespace::ParticleStore::push_back(const ParticleInformation &info)
+{
+  this->Position.insert(this->Position.end(), info.CurrentPosition.x,
+                        info.CurrentPosition.x + 4);
+  this->CachedDataSetId.insert(this->CachedDataSetId.end(),
+                               info.CachedDataSetId, info.CachedDataSetId + 2);
+  this->CachedCellId.insert(this->CachedCellId.end(),
+                            info.CachedCellId, info.CachedCellId + 2);
+  this->LocationState.push_back(info.LocationState);
+  this->SourceID.push_back(info.SourceID);
+  this->TimeStepAge.push_back(info.TimeStepAge);
+  this->InjectedPointId.push_back(info.InjectedPointId);
+  this->InjectedStepId.push_back(info.InjectedStepId);
+  this->UniqueParticleId.push_back(info.UniqueParticleId);
+  this->ErrorCode.push_back(info.ErrorCode);
+  this->Age.push_back(info.age);
+  this->Rotation.push_back(info.rotation);
+  this->AngularVel.push_back(info.angularVel);
+  this->Time.push_back(info.time);
+  this->Speed.push_back(info.speed);
+  this->PointId.push_back(info.PointId);
+}
+
+//---------------------------------------------------------------------------
+void vtkParticleTracerBaseNamespace::ParticleStore::Get(size_t i, ParticleInformation &info) const
+{
+  memcpy(info.CurrentPosition.x, &this->Position[4*i], 4*sizeof(double));
+  info.CachedDataSetId[0] = this->CachedDataSetId[2*i];
+  info.CachedDataSetId[1] = this->CachedDataSetId[2*i+1];
+  info.CachedCellId[0]    = this->CachedCellId[2*i];
+  info.CachedCellId[1]    = this->CachedCellId[2*i+1];
+  info.LocationState      = this->LocationState[i];
+  info.SourceID           = this->SourceID[i];
+  info.TimeStepAge        = this->TimeStepAge[i];
+  info.InjectedPointId    = this->InjectedPointId[i];
+  info.InjectedStepId     = this->InjectedStepId[i];
+  info.UniqueParticleId   = this->UniqueParticleId[i];
+  info.ErrorCode          = this->ErrorCode[i];
+  info.age                = this->Age[i];
+  info.rotation           = this->Rotation[i];
+  info.angularVel         = this->AngularVel[i];
+  info.time               = this->Time[i];
+  info.speed              = this->Speed[i];
+  info.PointId            = this->PointId[i];
+}
+
+//---------------------------------------------------------------------------
+void vtkParticleTracerBaseNamespace::ParticleStore::Set(size_t i, const ParticleInformation &info)
+{
+  memcpy(&this->Position[4*i], info.CurrentPosition.x, 4*sizeof(double));
+  this->CachedDataSetId[2*i]   = info.CachedDataSetId[0];
+  this->CachedDataSetId[2*i+1] = info.CachedDataSetId[1];
+  this->CachedCellId[2*i]      = info.CachedCellId[0];
+  this->CachedCellId[2*i+1]    = info.CachedCellId[1];
+  this->LocationState[i]       = info.LocationState;
+  this->SourceID[i]            = info.SourceID;
+  this->TimeStepAge[i]         = info.TimeStepAge;
+  this->InjectedPointId[i]     = info.InjectedPointId;
+  this->InjectedStepId[i]      = info.InjectedStepId;
+  this->UniqueParticleId[i]    = info.UniqueParticleId;
+  this->ErrorCode[i]           = info.ErrorCode;
+  this->Age[i]                 = info.age;
+  this->Rotation[i]            = info.rotation;
+  this->AngularVel[i]          = info.angularVel;
+  this->Time[i]                = info.time;
+  this->Speed[i]               = info.speed;
+  this->PointId[i]             = info.PointId;
+}
+
+//---------------------------------------------------------------------------
+void vtkParticleTracerBaseNamespace::ParticleStore::Compact(const std::vector<char> &removed)
+{
+  if (std::find(removed.begin(), removed.end(), 1) == removed.end())
+    {
+    return;
+    }
+  CompactArray(this->Position, removed, 4);
+  CompactArray(this->CachedDataSetId, removed, 2);
+  CompactArray(this->CachedCellId, removed, 2);
+  CompactArray(this->LocationState, removed, 1);
+  CompactArray(this->SourceID, removed, 1);
+  CompactArray(this->TimeStepAge, removed, 1);
+  CompactArray(this->InjectedPointId, removed, 1);
+  CompactArray(this->InjectedStepId, removed, 1);
+  CompactArray(this->UniqueParticleId, removed, 1);
+  CompactArray(this->ErrorCode, removed, 1);
+  CompactArray(this->Age, removed, 1);
+  CompactArray(this->Rotation, removed, 1);
+  CompactArray(this->AngularVel, removed, 1);
+  CompactArray(this->Time, removed, 1);
+  CompactArray(this->Speed, removed, 1);
+  CompactArray(this->PointId, removed, 1);
+}
+
 //---------------------------------------------------------------------------
 vtkParticleTracerBase::vtkParticleTracerBase()
 {
@@ -149,6 +294,9 @@ vtkParticleTracerBase::vtkParticleTracerBase()
   //
   this->Interpolator = vtkSmartPointer<vtkTemporalInterpolatedVelocityField>::New();
   //
+  this->Threader = vtkMultiThreader::New();
+  this->NumberOfThreads = this->Threader->GetNumberOfThreads();
+  //
   this->SetNumberOfInputPorts(2);
 
 #ifdef JB_H5PART_PARTICLE_OUTPUT
@@ -181,7 +329,7 @@ vtkParticleTracerBase::~vtkParticleTracerBase()
 
   this->SetIntegrator(0);
   this->SetInterpolatorPrototype(0);
-
+  this->Threader->Delete();
 }
 //----------------------------------------------------------------------------
 int vtkParticleTracerBase::FillInputPortInformation(
@@ -818,13 +966,6 @@ vtkPolyData* vtkParticleTracerBase::Execute(vtkInformationVector** inputVector)
       }
     }
 
-  //
-  // Setup some variables
-  //
-  vtkSmartPointer<vtkInitialValueProblemSolver> integrator;
-  integrator.TakeReference(this->GetIntegrator()->NewInstance());
-  integrator->SetFunctionSet(this->Interpolator);
-
   //
   // Make sure the Particle Positions are initialized with Seed particles
   //
@@ -853,21 +994,22 @@ vtkPolyData* vtkParticleTracerBase::Execute(vtkInformationVector** inputVector)
 
   if(this->CurrentTimeStep==this->StartTimeStep) //just add all the particles
     {
-    for(ParticleListIterator itr = this->ParticleHistories.begin();  itr!=this->ParticleHistories.end();itr++)
+    for(size_t i=0; i<this->ParticleHistories.size(); i++)
       {
-      ParticleInformation& info(*itr);
+      ParticleInformation info;
+      this->ParticleHistories.Get(i, info);
       this->Interpolator->TestPoint(info.CurrentPosition.x);
       double velocity[3];
       this->Interpolator->GetLastGoodVelocity(velocity);
       info.speed = vtkMath::Norm(velocity);
-      this->AddParticle(*itr,velocity);
+      this->AddParticle(info,velocity);
+      this->ParticleHistories.Set(i, info);
       }
     }
   else
    {
-    ParticleListIterator  it_first = this->ParticleHistories.begin();
-    ParticleListIterator  it_last  = this->ParticleHistories.end();
-    ParticleListIterator  it_next;
+    vtkIdType first = 0;
+    vtkIdType last = static_cast<vtkIdType>(this->ParticleHistories.size());
 
     //
     // Perform 2 passes
@@ -883,43 +1025,17 @@ vtkPolyData* vtkParticleTracerBase::Execute(vtkInformationVector** inputVector)
     for (int pass=0; pass<PASSES; pass++)
       {
       vtkDebugMacro(<<"Begin Pass " << pass << " with " << this->ParticleHistories.size() << " Particles");
-      for (ParticleListIterator it=it_first; it!=it_last;)
-        {
-        // Keep the 'next' iterator handy because if a particle is terminated
-        // or leaves the domain, the 'current' iterator will be deleted.
-        it_next = it;
-        it_next++;
-        this->IntegrateParticle(it, from, this->CurrentTime, integrator);
-        if (this->GetAbortExecute())
-          {
-          break;
-          }
-        it = it_next;
-        }
+      this->IntegrateParticles(first, last, from, this->CurrentTime);
       // Particles might have been deleted during the first pass as they move
       // out of domain or age. Before adding any new particles that are sent
       // to us, we must know the starting point ready for the second pass
-      bool list_valid = (this->ParticleHistories.size()>0);
-      if (list_valid)
-        {
-        // point to one before the end
-        it_first = --this->ParticleHistories.end();
-        }
+      first = static_cast<vtkIdType>(this->ParticleHistories.size());
       // Send and receive any particles which exited/entered the domain
       if (pass<(PASSES-1))
         {
         this->UpdateParticleListFromOtherProcesses();
         }
-      it_last = this->ParticleHistories.end();
-      if (list_valid)
-        {
-        // increment to point to first new entry
-        it_first++;
-        }
-      else
-        {
-        it_first = this->ParticleHistories.begin();
-        }
+      last = static_cast<vtkIdType>(this->ParticleHistories.size());
       }//end of pass
     }
 
@@ -933,11 +1049,7 @@ vtkPolyData* vtkParticleTracerBase::Execute(vtkInformationVector** inputVector)
     {
     this->ReinjectionCounter += 1;
 
-    ParticleListIterator lastParticle = this->ParticleHistories.end();
-    if (!this->ParticleHistories.empty())
-      {
-      lastParticle--;
-      }
+    size_t firstInjected = this->ParticleHistories.size();
     int seedPointId=0;
     this->LocalSeeds.clear();
     for (size_t i=0; i<seedSources.size(); i++)
@@ -947,24 +1059,16 @@ vtkPolyData* vtkParticleTracerBase::Execute(vtkInformationVector** inputVector)
     this->ParticleInjectionTime.Modified();
     this->UpdateParticleList(this->LocalSeeds);
 
-    ParticleListIterator itr = lastParticle;
-    if(itr!=this->ParticleHistories.end())
+    for(size_t i=firstInjected; i<this->ParticleHistories.size(); i++)
       {
-      itr++;
-      }
-    else
-      {
-      itr = this->ParticleHistories.begin();
-      }
-
-    for(; itr!=this->ParticleHistories.end(); ++itr)
-      {
-      ParticleInformation& info(*lastParticle);
+      ParticleInformation info;
+      this->ParticleHistories.Get(i, info);
       this->Interpolator->TestPoint(info.CurrentPosition.x);
       double velocity[3];
       this->Interpolator->GetLastGoodVelocity(velocity);
       info.speed = vtkMath::Norm(velocity);
-      this->AddParticle(*itr,velocity);
+      this->AddParticle(info,velocity);
+      this->ParticleHistories.Set(i, info);
       }
     }
 
@@ -1067,177 +1171,532 @@ int vtkParticleTracerBase::RequestData(
   return 1;
 }
 //---------------------------------------------------------------------------
-void vtkParticleTracerBase::IntegrateParticle(
-  ParticleListIterator &it,
-  double currenttime, double targettime,
-  vtkInitialValueProblemSolver* integrator)
+namespace
 {
+  // The number of particles a thread advects before fetching more
+  const vtkIdType ParticleChunkSize = 256;
 
-  double epsilon = (targettime-currenttime)/100.0;
-  double velocity[3], point1[4], point2[4] = {0.0, 0.0, 0.0, 0.0};
-  double minStep=0, maxStep=0;
-  double stepWanted, stepTaken=0.0;
-  int substeps = 0;
-
+  // The outcome of the advection of a particle over a time step
+  enum
+  {
+    PARTICLE_NOT_ADVECTED = 0, // the execution was aborted first
+    PARTICLE_ADVECTED,         // the particle ended up inside the domain
+    PARTICLE_LOST,             // the integration failed, even with a push
+    PARTICLE_OUTSIDE           // the particle ended up outside the domain
+  };
+
+  // The particles [First, First+n) of the store as they are after a time
+  // step, with one array per member. The particles themselves are only
+  // updated once all of them have been advected, so that the ones which
+  // are sent away still have their previous state. The scalars of the
+  // particles ending up inside the domain are interpolated by the thread
+  // which advected them, in the row Row of the point data of the thread.
+  struct ParticleAdvection
+  {
+    void Allocate(vtkIdType n)
+    {
+      this->Position.resize(4*n);
+      this->Velocity.resize(3*n);
+      this->CachedCellId.resize(2*n);
+      this->CachedDataSetId.resize(2*n);
+      this->LocationState.resize(n);
+      this->ErrorCode.resize(n);
+      this->Age.resize(n);
+      this->Speed.resize(n);
+      this->Status.assign(n, PARTICLE_NOT_ADVECTED);
+      this->Thread.resize(n);
+      this->Row.assign(n, -1);
+      this->Vorticity.resize(3*n);
+      this->AngularVel.resize(n);
+    }
+
+    std::vector<double>    Position;
+    std::vector<double>    Velocity;
+    std::vector<vtkIdType> CachedCellId;
+    std::vector<int>       CachedDataSetId;
+    std::vector<int>       LocationState;
+    std::vector<int>       ErrorCode;
+    std::vector<float>     Age;
+    std::vector<float>     Speed;
+    std::vector<char>      Status;
+    std::vector<int>       Thread;
+    std::vector<vtkIdType> Row;
+    std::vector<double>    Vorticity;
+    std::vector<double>    AngularVel;
+  };
+
+  struct IntegrateParticlesThreadStruct
+  {
+    vtkParticleTracerBase *Filter;
+    const ParticleStore *Particles;
+    ParticleAdvection *Advection;
+    vtkIdType First;
+    vtkIdType NumberOfParticles;
+    double CurrentTime;
+    double TargetTime;
+    double IntegrationStep;
+    double MaximumError;
+    double TerminalSpeed;
+    double RotationScale;
+    bool ComputeVorticity;
+    vtkTemporalInterpolatedVelocityField *Functions[VTK_MAX_THREADS];
+    vtkInitialValueProblemSolver *Integrators[VTK_MAX_THREADS];
+    vtkPointData *PointData[VTK_MAX_THREADS];
+    vtkDoubleArray *CellVectors[VTK_MAX_THREADS];
+    vtkIdType NextChunk;
+    vtkSimpleCriticalSection Lock;
+  };
+
+  // RetryWithPush adds a small push to a particle along its current
+  // velocity vector, this helps get over cracks in dynamic/rotating meshes.
+  // Returns true if the particle is back inside a dataset.
+  bool RetryWithPush(vtkTemporalInterpolatedVelocityField *interpolator,
+                     double point[4], double delT, int substeps,
+                     float &age, int &errorCode, int &locationState)
+  {
+    double velocity[3];
+    interpolator->ClearCache();
 
-  ParticleInformation &info = (*it);
-  ParticleInformation previous = (*it);
-  bool particle_good = true;
+    locationState = interpolator->TestPoint(point);
 
-  info.ErrorCode = 0;
+    if (locationState==ID_OUTSIDE_ALL)
+      {
+      // something is wrong, the particle has left the building completely
+      // we can't get the last good velocity as it won't be valid
+      // send the particle 'as is' and hope it lands in another process
+      if (substeps>0)
+        {
+        interpolator->GetLastGoodVelocity(velocity);
+        }
+      else
+        {
+        velocity[0] = velocity[1] = velocity[2] = 0.0;
+        }
+      errorCode = 3;
+      }
+    else if (locationState==ID_OUTSIDE_T0)
+      {
+      // the particle left the volume but can be tested at T2, so use the velocity at T2
+      interpolator->GetLastGoodVelocity(velocity);
+      errorCode = 4;
+      }
+    else if (locationState==ID_OUTSIDE_T1)
+      {
+      // the particle left the volume but can be tested at T1, so use the velocity at T1
+      interpolator->GetLastGoodVelocity(velocity);
+      errorCode = 5;
+      }
+    else
+      {
+      // The test returned INSIDE_ALL, so test failed near start of integration,
+      interpolator->GetLastGoodVelocity(velocity);
+      }
 
-  // Get the Initial point {x,y,z,t}
-  memcpy(point1, &info.CurrentPosition, sizeof(Position));
+    // try adding a one increment push to the particle to get over a rotating/moving boundary
+    for (int v=0; v<3; v++)
+      {
+      point[v] += velocity[v]*delT;
+      }
 
-  //
-  // begin interpolation between available time values, if the particle has
-  // a cached cell ID and dataset - try to use it,
-  //
-  this->Interpolator->SetCachedCellIds(info.CachedCellId, info.CachedDataSetId);
+    point[3] += delT;
+    locationState = interpolator->TestPoint(point);
 
-  if(currenttime==targettime)
-    {
-    Assert(point1[3]==currenttime);
-    }
-  else
-    {
-    Assert (point1[3]>=(currenttime-epsilon) && point1[3]<=(targettime+epsilon));
+    if (locationState!=ID_OUTSIDE_ALL)
+      {
+      // a push helped the particle get back into a dataset,
+      age += delT;
+      errorCode = 6;
+      return true;
+      }
+    return false;
+  }
 
-    double delT = (targettime-currenttime) * this->IntegrationStep;
-    epsilon = delT*1E-3;
+  // Runge-Kutta integration of the particle i of the store between the two
+  // times, with the given function set and integrator. Only reads the
+  // store, the result goes to the advection arrays.
+  void AdvectParticle(IntegrateParticlesThreadStruct *str, vtkIdType i,
+                      vtkTemporalInterpolatedVelocityField *interpolator,
+                      vtkInitialValueProblemSolver *integrator)
+  {
+    const ParticleStore *particles = str->Particles;
+    ParticleAdvection *advection = str->Advection;
+    vtkIdType k = i - str->First;
+    double currenttime = str->CurrentTime;
+    double targettime = str->TargetTime;
+
+    double *point1 = &advection->Position[4*k];
+    double point2[4] = {0.0, 0.0, 0.0, 0.0};
+    double minStep=0, maxStep=0;
+    double stepWanted, stepTaken=0.0;
+    int substeps = 0;
+    float age = particles->Age[i];
+    int errorCode = 0;
+    int locationState = particles->LocationState[i];
+    char status = PARTICLE_ADVECTED;
+
+    // Get the Initial point {x,y,z,t}
+    memcpy(point1, &particles->Position[4*i], 4*sizeof(double));
 
-    while (point1[3] < (targettime-epsilon))
+    //
+    // begin interpolation between available time values, if the particle
+    // has a cached cell ID and dataset - try to use it. The cache is first
+    // cleared so that the particles do not depend on each other.
+    //
+    vtkIdType cellIds[2] = { particles->CachedCellId[2*i],
+                             particles->CachedCellId[2*i+1] };
+    int dataSetIds[2] = { particles->CachedDataSetId[2*i],
+                          particles->CachedDataSetId[2*i+1] };
+    interpolator->ClearCache();
+    interpolator->SetCachedCellIds(cellIds, dataSetIds);
+
+    if(currenttime!=targettime)
       {
-      //
-      // Here beginneth the real work
-      //
-      double error = 0;
-
-      // If, with the next step, propagation will be larger than
-      // max, reduce it so that it is (approximately) equal to max.
-      stepWanted = delT;
-      if ( (point1[3] + stepWanted) > targettime )
-        {
-        stepWanted = targettime - point1[3];
-        maxStep = stepWanted;
-        }
+      double delT = (targettime-currenttime) * str->IntegrationStep;
+      double epsilon = delT*1E-3;
 
-
-      // Calculate the next step using the integrator provided.
-      // If the next point is out of bounds, send it to another process
-      if (integrator->ComputeNextStep(
-            point1, point2, point1[3], stepWanted,
-            stepTaken, minStep, maxStep,
-            this->MaximumError, error) != 0)
+      while (point1[3] < (targettime-epsilon))
         {
-        // if the particle is sent, remove it from the list
-        info.ErrorCode = 1;
+        //
+        // Here beginneth the real work
+        //
+        double error = 0;
+
+        // If, with the next step, propagation will be larger than
+        // max, reduce it so that it is (approximately) equal to max.
+        stepWanted = delT;
+        if ( (point1[3] + stepWanted) > targettime )
+          {
+          stepWanted = targettime - point1[3];
+          maxStep = stepWanted;
+          }
 
-        if (!this->RetryWithPush(info, point1, delT, substeps))
+        // Calculate the next step using the integrator provided.
+        // If the next point is out of bounds, send it to another process
+        if (integrator->ComputeNextStep(
+              point1, point2, point1[3], stepWanted,
+              stepTaken, minStep, maxStep,
+              str->MaximumError, error) != 0)
           {
-          if(previous.PointId <0)
-            {
-            vtkWarningMacro("the particle should have been added");
-            }
-          else
+          errorCode = 1;
+          if (!RetryWithPush(interpolator, point1, delT, substeps,
+                             age, errorCode, locationState))
             {
-            this->SendParticleToAnotherProcess(info,previous, this->ParticlePointData);
+            status = PARTICLE_LOST;
+            break;
             }
-          this->ParticleHistories.erase(it);
-          particle_good = false;
-          break;
+          // particle was not sent, retry saved it
+          substeps++;
           }
-        else
+        else // success, increment position/time
           {
-          // particle was not sent, retry saved it, so copy info back
           substeps++;
-          memcpy(point1, &info.CurrentPosition, sizeof(Position));
-          }
-        }
-      else // success, increment position/time
-        {
-        substeps++;
 
-        // increment the particle time
-        point2[3] = point1[3] + stepTaken;
-        info.age += stepTaken;
+          // increment the particle time
+          point2[3] = point1[3] + stepTaken;
+          age += stepTaken;
 
-        // Point is valid. Insert it.
-        memcpy(&info.CurrentPosition, point2, sizeof(Position));
-        memcpy(point1, point2, sizeof(Position));
+          // Point is valid. Insert it.
+          memcpy(point1, point2, 4*sizeof(double));
+          }
         }
 
-      // If the solver is adaptive and the next time step (delT.Interval)
-      // that the solver wants to use is smaller than minStep or larger
-      // than maxStep, re-adjust it. This has to be done every step
-      // because minStep and maxStep can change depending on the Cell
-      // size (unless it is specified in time units)
-      if (integrator->IsAdaptive())
+      if (status==PARTICLE_ADVECTED)
         {
-        // code removed. Put it back when this is stable
+        // The integration succeeded, but check the computed final position
+        // is actually inside the domain (the intermediate steps taken inside
+        // the integrator were ok, but the final step may just pass out)
+        // if it moves out, we can't interpolate scalars, so we must send it away
+        locationState = interpolator->TestPoint(point1);
+        if (locationState==ID_OUTSIDE_ALL)
+          {
+          errorCode = 2;
+          status = PARTICLE_OUTSIDE;
+          }
         }
       }
 
-    if (particle_good)
+    interpolator->GetLastGoodVelocity(&advection->Velocity[3*k]);
+    interpolator->GetCachedCellIds(&advection->CachedCellId[2*k],
+                                   &advection->CachedDataSetId[2*k]);
+    advection->LocationState[k] = locationState;
+    advection->ErrorCode[k] = errorCode;
+    advection->Age[k] = age;
+    advection->Status[k] = status;
+  }
+};
+
+//---------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkParticleTracerBase::ThreadedIntegrateParticles(
+  void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  IntegrateParticlesThreadStruct *str =
+    static_cast<IntegrateParticlesThreadStruct *>(info->UserData);
+  int threadId = info->ThreadID;
+
+  for (;;)
+    {
+    str->Lock.Lock();
+    vtkIdType begin = str->NextChunk;
+    str->NextChunk += ParticleChunkSize;
+    str->Lock.Unlock();
+    if (begin >= str->NumberOfParticles || str->Filter->GetAbortExecute())
       {
-      // The integration succeeded, but check the computed final position
-      // is actually inside the domain (the intermediate steps taken inside
-      // the integrator were ok, but the final step may just pass out)
-      // if it moves out, we can't interpolate scalars, so we must send it away
-      info.LocationState = this->Interpolator->TestPoint(info.CurrentPosition.x);
-      if (info.LocationState==ID_OUTSIDE_ALL)
+      break;
+      }
+    vtkIdType end = begin + ParticleChunkSize;
+    if (end > str->NumberOfParticles)
+      {
+      end = str->NumberOfParticles;
+      }
+    for (vtkIdType k=begin; k<end; k++)
+      {
+      vtkTemporalInterpolatedVelocityField *interpolator =
+        str->Functions[threadId];
+      AdvectParticle(str, str->First + k, interpolator,
+                     str->Integrators[threadId]);
+
+      // Interpolate the scalars of the particles which are to be added to
+      // the output, at the cell the interpolator has just found
+      ParticleAdvection *advection = str->Advection;
+      if (advection->Status[k]!=PARTICLE_ADVECTED ||
+          str->CurrentTime==str->TargetTime)
+        {
+        continue;
+        }
+      double *velocity = &advection->Velocity[3*k];
+      float speed = vtkMath::Norm(velocity);
+      advection->Speed[k] = speed;
+      if (speed <= str->TerminalSpeed)
         {
-        info.ErrorCode = 2;
-        // if the particle is sent, remove it from the list
-        if (this->SendParticleToAnotherProcess(info,previous,this->OutputPointData))
+        continue;
+        }
+      vtkPointData *pd = str->PointData[threadId];
+      vtkIdType row = pd->GetNumberOfTuples();
+      // have to use T0 if particle is out at T1, otherwise use T1
+      int T = (advection->LocationState[k]==ID_OUTSIDE_T1) ? 0 : 1;
+      interpolator->InterpolatePoint(T, pd, row);
+      advection->Thread[k] = threadId;
+      advection->Row[k] = row;
+      if (str->ComputeVorticity)
+        {
+        vtkGenericCell *cell(NULL);
+        double pcoords[3], weights[256];
+        double *vorticity = &advection->Vorticity[3*k];
+        interpolator->GetVorticityData(
+          T, pcoords, weights, cell, str->CellVectors[threadId]);
+        str->Filter->CalculateVorticity(
+          cell, pcoords, str->CellVectors[threadId], vorticity);
+        // local rotation = vorticity . unit tangent ( i.e. velocity/speed )
+        double omega = 0.0;
+        if (speed != 0.0)
           {
-          this->ParticleHistories.erase(it);
-          particle_good = false;
+          omega = vtkMath::Dot(vorticity, velocity);
+          omega /= speed;
+          omega *= str->RotationScale;
           }
+        advection->AngularVel[k] = omega;
+        }
+      }
+    }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//---------------------------------------------------------------------------
+void vtkParticleTracerBase::IntegrateParticles(
+  vtkIdType first, vtkIdType last,
+  double currenttime, double targettime)
+{
+  vtkIdType numParticles = last - first;
+  if (numParticles <= 0)
+    {
+    return;
+    }
+
+  ParticleAdvection advection;
+  advection.Allocate(numParticles);
+
+  IntegrateParticlesThreadStruct str;
+  str.Filter = this;
+  str.Particles = &this->ParticleHistories;
+  str.Advection = &advection;
+  str.First = first;
+  str.NumberOfParticles = numParticles;
+  str.CurrentTime = currenttime;
+  str.TargetTime = targettime;
+  str.IntegrationStep = this->IntegrationStep;
+  str.MaximumError = this->MaximumError;
+  str.TerminalSpeed = this->TerminalSpeed;
+  str.RotationScale = this->RotationScale;
+  str.ComputeVorticity = this->ComputeVorticity!=0;
+  str.NextChunk = 0;
+
+  int numThreads = this->NumberOfThreads;
+  vtkIdType numChunks = (numParticles + ParticleChunkSize - 1) /
+    ParticleChunkSize;
+  if (numThreads > numChunks)
+    {
+    numThreads = static_cast<int>(numChunks);
+    }
+  if (numThreads > 1 && !this->Interpolator->PrepareConcurrentDataSetAccess())
+    {
+    numThreads = 1;
+    }
+
+  // Each thread evaluates the velocity with its own caches and integrator,
+  // and interpolates the scalars into its own point data
+  str.Functions[0] = this->Interpolator;
+  for (int t=1; t<numThreads; t++)
+    {
+    str.Functions[t] = vtkTemporalInterpolatedVelocityField::New();
+    str.Functions[t]->CopyDataSets(this->Interpolator);
+    }
+  for (int t=0; t<numThreads; t++)
+    {
+    str.Integrators[t] = this->GetIntegrator()->NewInstance();
+    str.Integrators[t]->SetFunctionSet(str.Functions[t]);
+    str.PointData[t] = vtkPointData::New();
+    str.PointData[t]->InterpolateAllocate(
+      this->DataReferenceT[0]->GetPointData());
+    str.CellVectors[t] = vtkDoubleArray::New();
+    str.CellVectors[t]->SetNumberOfComponents(3);
+    str.CellVectors[t]->Allocate(3*VTK_CELL_SIZE);
+    }
+
+  if (numThreads > 1)
+    {
+    this->Threader->SetNumberOfThreads(numThreads);
+    this->Threader->SetSingleMethod(
+      vtkParticleTracerBase::ThreadedIntegrateParticles, &str);
+    this->Threader->SingleMethodExecute();
+    }
+  else
+    {
+    vtkMultiThreader::ThreadInfo info;
+    info.ThreadID = 0;
+    info.NumberOfThreads = 1;
+    info.UserData = &str;
+    vtkParticleTracerBase::ThreadedIntegrateParticles(&info);
+    }
+
+  for (int t=0; t<numThreads; t++)
+    {
+    str.Integrators[t]->Delete();
+    str.CellVectors[t]->Delete();
+    if (t > 0)
+      {
+      str.Functions[t]->Delete();
+      }
+    }
+
+  //
+  // In particle order:
+  // Send the particles which left the domain to the other processes,
+  // terminate the stagnating ones, and insert the others into the output,
+  // creating any new scalars and interpolating existing ones
+  //
+  std::vector<char> removed(this->ParticleHistories.size(), 0);
+  for (vtkIdType k=0; k<numParticles; k++)
+    {
+    vtkIdType i = first + k;
+    int status = advection.Status[k];
+    if (status==PARTICLE_NOT_ADVECTED)
+      {
+      continue;
+      }
+
+    ParticleInformation previous;
+    this->ParticleHistories.Get(i, previous);
+    ParticleInformation info = previous;
+    memcpy(&info.CurrentPosition, &advection.Position[4*k], sizeof(Position));
+    info.age = advection.Age[k];
+    info.ErrorCode = advection.ErrorCode[k];
+    info.LocationState = advection.LocationState[k];
+    double *velocity = &advection.Velocity[3*k];
+    bool particle_good = true;
+
+    if (status==PARTICLE_LOST)
+      {
+      // if the particle is sent, remove it from the list
+      if(previous.PointId <0)
+        {
+        vtkWarningMacro("the particle should have been added");
+        }
+      else
+        {
+        this->SendParticleToAnotherProcess(info,previous, this->ParticlePointData);
+        }
+      particle_good = false;
+      }
+    else if (status==PARTICLE_OUTSIDE)
+      {
+      // if the particle is sent, remove it from the list
+      if (this->SendParticleToAnotherProcess(info,previous,this->OutputPointData))
+        {
+        particle_good = false;
         }
       }
 
     // Has this particle stagnated
     //
-    if (particle_good)
+    if (particle_good && currenttime!=targettime)
       {
-      this->Interpolator->GetLastGoodVelocity(velocity);
-      info.speed = vtkMath::Norm(velocity);
-      if (it->speed <= this->TerminalSpeed)
+      info.speed = advection.Speed[k];
+      if (info.speed <= this->TerminalSpeed)
         {
-        this->ParticleHistories.erase(it);
         particle_good = false;
         }
       }
-    }
 
-  //
-  // We got this far without error :
-  // Insert the point into the output
-  // Create any new scalars and interpolate existing ones
-  // Cache cell ids and datasets
-  //
-  if (particle_good)
-    {
+    if (!particle_good)
+      {
+      removed[i] = 1;
+      continue;
+      }
+
     //
     // store the last Cell Ids and dataset indices for next time particle is updated
     //
-    this->Interpolator->GetCachedCellIds(info.CachedCellId, info.CachedDataSetId);
+    memcpy(info.CachedCellId, &advection.CachedCellId[2*k], 2*sizeof(vtkIdType));
+    memcpy(info.CachedDataSetId, &advection.CachedDataSetId[2*k], 2*sizeof(int));
     //
     info.TimeStepAge += 1;
     //
-    // Now generate the output geometry and scalars
+    // Generate the output geometry and scalars, from the ones interpolated
+    // by the thread if any, or else by finding the cells of the particle
+    // again from its cache
     //
-    this->AddParticle(info,velocity);
+    if (advection.Row[k]>=0)
+      {
+      this->AddParticle(info,
+                        str.PointData[advection.Thread[k]], advection.Row[k],
+                        &advection.Vorticity[3*k], advection.AngularVel[k]);
+      }
+    else
+      {
+      this->Interpolator->ClearCache();
+      this->Interpolator->SetCachedCellIds(info.CachedCellId, info.CachedDataSetId);
+      this->Interpolator->TestPoint(info.CurrentPosition.x);
+      this->AddParticle(info,velocity);
+      }
+    this->ParticleHistories.Set(i, info);
     }
-  else
+
+  for (int t=0; t<numThreads; t++)
     {
-    this->Interpolator->ClearCache();
+    str.PointData[t]->Delete();
     }
+  this->ParticleHistories.Compact(removed);
 
 #ifdef DEBUGPARTICLETRACE
   double eps = (this->GetCacheDataTime(1)-this->GetCacheDataTime(0))/100;
-  Assert (point1[3]>=(this->GetCacheDataTime(0)-eps) && point1[3]<=(this->GetCacheDataTime(1)+eps));
+  for (size_t i=first; i<this->ParticleHistories.size(); i++)
+    {
+    double t = this->ParticleHistories.Position[4*i+3];
+    Assert (t>=(this->GetCacheDataTime(0)-eps) && t<=(this->GetCacheDataTime(1)+eps));
+    }
 #endif
 }
 //---------------------------------------------------------------------------
@@ -1256,6 +1715,7 @@ void vtkParticleTracerBase::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "StaticMesh: " << this->StaticMesh << endl;
   os << indent << "TerminationTime: " << this->TerminationTime << endl;
   os << indent << "StaticSeeds: " << this->StaticSeeds << endl;
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << endl;
 }
 //---------------------------------------------------------------------------
 bool vtkParticleTracerBase::ComputeDomainExitLocation(
@@ -1424,71 +1884,7 @@ void vtkParticleTracerBase::CreateProtoPD(vtkDataObject* input)
   this->ProtoPD->InterpolateAllocate(inputData->GetPointData());
 }
 
-//---------------------------------------------------------------------------
-bool vtkParticleTracerBase::RetryWithPush(ParticleInformation &info,  double* point1,double delT, int substeps)
-{
-  double velocity[3];
-  this->Interpolator->ClearCache();
-  if (info.UniqueParticleId==3)
-    {
-    vtkDebugMacro(<< "3 is about to be sent");
-    }
-
-  info.LocationState = this->Interpolator->TestPoint(point1);
-
-  if (info.LocationState==ID_OUTSIDE_ALL)
-    {
-    // something is wrong, the particle has left the building completely
-    // we can't get the last good velocity as it won't be valid
-    // send the particle 'as is' and hope it lands in another process
-    if (substeps>0)
-      {
-      this->Interpolator->GetLastGoodVelocity(velocity);
-      }
-    else
-      {
-      velocity[0] = velocity[1] = velocity[2] = 0.0;
-      }
-    info.ErrorCode = 3;
-    }
-  else if (info.LocationState==ID_OUTSIDE_T0)
-    {
-    // the particle left the volume but can be tested at T2, so use the velocity at T2
-    this->Interpolator->GetLastGoodVelocity(velocity);
-    info.ErrorCode = 4;
-    }
-  else if (info.LocationState==ID_OUTSIDE_T1)
-    {
-    // the particle left the volume but can be tested at T1, so use the velocity at T1
-    this->Interpolator->GetLastGoodVelocity(velocity);
-    info.ErrorCode = 5;
-    }
-  else
-    {
-    // The test returned INSIDE_ALL, so test failed near start of integration,
-    this->Interpolator->GetLastGoodVelocity(velocity);
-    }
-
-  // try adding a one increment push to the particle to get over a rotating/moving boundary
-  for (int v=0; v<3; v++)
-    {
-    info.CurrentPosition.x[v] += velocity[v]*delT;
-    }
-
-  info.CurrentPosition.x[3] += delT;
-  info.LocationState = this->Interpolator->TestPoint(info.CurrentPosition.x);
-
-  if (info.LocationState!=ID_OUTSIDE_ALL)
-    {
-    // a push helped the particle get back into a dataset,
-    info.age += delT;
-    info.ErrorCode = 6;
-    return 1;
-    }
-  return 0;
-}
-
-void vtkParticleTracerBase::AddParticle( vtkParticleTracerBaseNamespace::ParticleInformation &info, double* velocity)
+vtkIdType vtkParticleTracerBase::InsertParticle( vtkParticleTracerBaseNamespace::ParticleInformation &info)
 {
   const double    *coord = info.CurrentPosition.x;
   vtkIdType tempId = this->OutputCoordinates->InsertNextPoint(coord);
@@ -1502,6 +1898,31 @@ void vtkParticleTracerBase::AddParticle( vtkParticleTracerBaseNamespace::Particl
   this->ErrorCode->InsertNextValue(info.ErrorCode);
   this->ParticleAge->InsertNextValue(info.age);
   info.PointId = tempId;
+  return tempId;
+}
+
+void vtkParticleTracerBase::InsertVorticity( vtkParticleTracerBaseNamespace::ParticleInformation &info, double vorticity[3], double omega)
+{
+  double rotation;
+  this->ParticleVorticity->InsertNextTuple(vorticity);
+  vtkIdType index = this->ParticleAngularVel->InsertNextValue(omega);
+  if (index>0)
+    {
+    rotation     = info.rotation + (info.angularVel + omega)/2 * (info.CurrentPosition.x[3] - info.time);
+    }
+  else
+    {
+    rotation     = 0.0;
+    }
+  this->ParticleRotation->InsertNextValue(rotation);
+  info.rotation   = rotation;
+  info.angularVel = omega;
+  info.time       = info.CurrentPosition.x[3];
+}
+
+void vtkParticleTracerBase::AddParticle( vtkParticleTracerBaseNamespace::ParticleInformation &info, double* velocity)
+{
+  vtkIdType tempId = this->InsertParticle(info);
 
   //
   // Interpolate all existing point attributes
@@ -1525,7 +1946,7 @@ void vtkParticleTracerBase::AddParticle( vtkParticleTracerBaseNamespace::Particl
     {
     vtkGenericCell *cell(NULL);
     double pcoords[3], vorticity[3], weights[256];
-    double rotation, omega;
+    double omega;
     // have to use T0 if particle is out at T1, otherwise use T1
     if (info.LocationState==ID_OUTSIDE_T1)
       {
@@ -1539,7 +1960,6 @@ void vtkParticleTracerBase::AddParticle( vtkParticleTracerBaseNamespace::Particl
       }
 
     this->CalculateVorticity(cell, pcoords, CellVectors, vorticity);
-    this->ParticleVorticity->InsertNextTuple(vorticity);
     // local rotation = vorticity . unit tangent ( i.e. velocity/speed )
     if (info.speed != 0.0)
       {
@@ -1551,23 +1971,27 @@ void vtkParticleTracerBase::AddParticle( vtkParticleTracerBaseNamespace::Particl
       {
       omega = 0.0;
       }
-    vtkIdType index = this->ParticleAngularVel->InsertNextValue(omega);
-    if (index>0)
-      {
-      rotation     = info.rotation + (info.angularVel + omega)/2 * (info.CurrentPosition.x[3] - info.time);
-      }
-    else
-      {
-      rotation     = 0.0;
-      }
-    this->ParticleRotation->InsertNextValue(rotation);
-    info.rotation   = rotation;
-    info.angularVel = omega;
-    info.time       = info.CurrentPosition.x[3];
+    this->InsertVorticity(info, vorticity, omega);
     }
 
 }
 
+void vtkParticleTracerBase::AddParticle( vtkParticleTracerBaseNamespace::ParticleInformation &info, vtkPointData *pd, vtkIdType row, double vorticity[3], double omega)
+{
+  vtkIdType tempId = this->InsertParticle(info);
+
+  // the arrays of pd are allocated as the first ones of the output
+  for (int i=0; i<pd->GetNumberOfArrays(); i++)
+    {
+    this->OutputPointData->GetAbstractArray(i)->InsertTuple(
+      tempId, row, pd->GetAbstractArray(i));
+    }
+  if (this->ComputeVorticity)
+    {
+    this->InsertVorticity(info, vorticity, omega);
+    }
+}
+
 vtkFloatArray*  vtkParticleTracerBase::GetParticleAge(vtkPointData* pd)
 {
   return vtkFloatArray::SafeDownCast(pd->GetArray("ParticleAge"));
@@ -1616,10 +2040,9 @@ vtkFloatArray*  vtkParticleTracerBase::GetParticleAngularVel(vtkPointData* pd)
 void vtkParticleTracerBase::PrintParticleHistories()
 {
   cout<<"Particle id, ages: "<<endl;
-  for(ParticleListIterator itr = this->ParticleHistories.begin();  itr!=this->ParticleHistories.end();itr++)
+  for(size_t i=0; i<this->ParticleHistories.size(); i++)
     {
-    ParticleInformation& info(*itr);
-    cout<<info.InjectedPointId<<" "<<info.age<<" "<<endl;
+    cout<<this->ParticleHistories.InjectedPointId[i]<<" "<<this->ParticleHistories.Age[i]<<" "<<endl;
     }
   cout<<endl;
 }
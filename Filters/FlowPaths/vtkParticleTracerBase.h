@@ -29,10 +29,10 @@
 #include "vtkPolyDataAlgorithm.h"
 //BTX
 #include <vector> // STL Header
-#include <list>   // STL Header
 //ETX
 
 class vtkMultiProcessController;
+class vtkMultiThreader;
 
 class vtkMultiBlockDataSet;
 class vtkDataArray;
@@ -83,8 +83,43 @@ namespace vtkParticleTracerBaseNamespace
 
   typedef std::vector<ParticleInformation>  ParticleVector;
   typedef ParticleVector::iterator             ParticleIterator;
-  typedef std::list<ParticleInformation>    ParticleDataList;
-  typedef ParticleDataList::iterator           ParticleListIterator;
+
+  // The particles held between time steps, with one array per member of
+  // ParticleInformation, so that they are advected in contiguous chunks
+  // and the terminated ones are removed in a single pass.
+  class VTKFILTERSFLOWPATHS_EXPORT ParticleStore
+  {
+  public:
+    size_t size() const { return this->PointId.size(); }
+    bool empty() const { return this->PointId.empty(); }
+    void clear();
+    void push_back(const ParticleInformation &info);
+
+    // Gather/scatter the members of the i-th particle
+    void Get(size_t i, ParticleInformation &info) const;
+    void Set(size_t i, const ParticleInformation &info);
+
+    // Remove the particles whose flag is set, keeping the order of the
+    // others. There is one flag per particle.
+    void Compact(const std::vector<char> &removed);
+
+    std::vector<double>    Position; // x, y, z, t
+    std::vector<int>       CachedDataSetId; // 2 per particle
+    std::vector<vtkIdType> CachedCellId; // 2 per particle
+    std::vector<int>       LocationState;
+    std::vector<int>       SourceID;
+    std::vector<int>       TimeStepAge;
+    std::vector<int>       InjectedPointId;
+    std::vector<int>       InjectedStepId;
+    std::vector<int>       UniqueParticleId;
+    std::vector<int>       ErrorCode;
+    std::vector<float>     Age;
+    std::vector<float>     Rotation;
+    std::vector<float>     AngularVel;
+    std::vector<float>     Time;
+    std::vector<float>     Speed;
+    std::vector<vtkIdType> PointId;
+  };
 };
 //ETX
 
@@ -213,6 +248,15 @@ public:
   vtkGetMacro(DisableResetCache,int);
   vtkBooleanMacro(DisableResetCache,int);
 
+  // Description:
+  // Set/Get the number of threads advecting the particles. Each thread
+  // advects its own chunks of particles, and the output does not depend
+  // on the number of threads. Threads are only used when all the datasets
+  // are images or unstructured grids searched with a cell locator.
+  // Defaults to the number of threads of vtkMultiThreader.
+  vtkSetClampMacro(NumberOfThreads, int, 1, VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads, int);
+
   // Description:
   // Provide support for multiple see sources
   void AddSourceConnection(vtkAlgorithmOutput* input);
@@ -222,7 +266,7 @@ public:
   vtkSmartPointer<vtkPolyData> Output; //managed by child classes
   vtkSmartPointer<vtkPointData> ProtoPD;
   vtkIdType UniqueIdCounter;// global Id counter used to give particles a stamp
-  vtkParticleTracerBaseNamespace::ParticleDataList  ParticleHistories;
+  vtkParticleTracerBaseNamespace::ParticleStore  ParticleHistories;
   vtkSmartPointer<vtkPointData>     ParticlePointData; //the current particle point data consistent
                                                        //with particle history
   int           ReinjectionCounter;
@@ -332,12 +376,14 @@ public:
   // of the main loop as particles leave each processor domain
   virtual void UpdateParticleListFromOtherProcesses(){};
 
-  // Description : The main loop performing Runge-Kutta integration of a single
-  // particle between the two times supplied.
-  void IntegrateParticle(
-    vtkParticleTracerBaseNamespace::ParticleListIterator &it,
-    double currenttime, double terminationtime,
-    vtkInitialValueProblemSolver* integrator);
+  // Description : The main loop performing Runge-Kutta integration of the
+  // particles [first, last) of ParticleHistories between the two times
+  // supplied. The particles are advected on NumberOfThreads threads, then
+  // those still inside are added to the output in order, those which left
+  // the domain are sent to the other processes, and the list is compacted.
+  void IntegrateParticles(
+    vtkIdType first, vtkIdType last,
+    double currenttime, double terminationtime);
 
   // if the particle is added to send list, then returns value is 1,
   // if it is kept on this process after a retry return value is 0
@@ -389,19 +435,27 @@ public:
   virtual void ResetCache();
   void AddParticle(vtkParticleTracerBaseNamespace::ParticleInformation &info, double* velocity);
 
+  // Description:
+  // Same as above, with the scalars already interpolated into the given
+  // row of pd, and the vorticity and angular velocity already computed
+  void AddParticle(vtkParticleTracerBaseNamespace::ParticleInformation &info,
+                   vtkPointData *pd, vtkIdType row,
+                   double vorticity[3], double omega);
+
 private:
+  // Description:
+  // Insert the point, cell and particle scalars of a particle into the
+  // output, and update its rotation from its vorticity
+  vtkIdType InsertParticle(vtkParticleTracerBaseNamespace::ParticleInformation &info);
+  void InsertVorticity(vtkParticleTracerBaseNamespace::ParticleInformation &info,
+                       double vorticity[3], double omega);
+
   // Description:
   // Hide this because we require a new interpolator type
   void SetInterpolatorPrototype(vtkAbstractInterpolatedVelocityField*) {};
 
-  // Description : When particle leave the domain, they must be collected
-  // and sent to the other processors for possible continuation.
-  // These routines manage the collection and sending after each main iteration.
-  // RetryWithPush adds a small pusj to aparticle along it's current velocity
-  // vector, this helps get over cracks in dynamic/rotating meshes
-  bool RetryWithPush(
-    vtkParticleTracerBaseNamespace::ParticleInformation &info, double* point1,double delT, int subSteps);
-
+  // Description : The thread function of IntegrateParticles()
+  static VTK_THREAD_RETURN_TYPE ThreadedIntegrateParticles(void *arg);
 
 private:
   //Parameters of tracing
@@ -444,6 +498,9 @@ private:
 
   // The velocity interpolator
   vtkSmartPointer<vtkTemporalInterpolatedVelocityField>  Interpolator;
+
+  int NumberOfThreads;
+  vtkMultiThreader *Threader;
   vtkAbstractInterpolatedVelocityField * InterpolatorPrototype;
 
   // Data for time step CurrentTimeStep-1 and CurrentTimeStep
@@ -20,6 +20,7 @@ PURPOSE.  See the above copyright notice for more information.
 #include "vtkCompositeDataIterator.h"
 #include "vtkCompositeDataPipeline.h"
 #include "vtkCompositeDataSet.h"
+#include "vtkCriticalSection.h"
 #include "vtkDataSetAttributes.h"
 #include "vtkDoubleArray.h"
 #include "vtkExecutive.h"
@@ -35,6 +36,7 @@ PURPOSE.  See the above copyright notice for more information.
 #include "vtkCellLocatorInterpolatedVelocityField.h"
 #include "vtkMath.h"
 #include "vtkMultiBlockDataSet.h"
+#include "vtkMultiThreader.h"
 #include "vtkNew.h"
 #include "vtkObjectFactory.h"
 #include "vtkOverlappingAMR.h"
@@ -116,9 +118,13 @@ vtkStreamTracer::vtkStreamTracer()
   this->LastUsedStepSize = 0.0;
 
   this->GenerateNormalsInIntegrate = true;
+  this->IntegratingInThreads = false;
 
   this->InterpolatorPrototype = 0;
 
+  this->Threader = vtkMultiThreader::New();
+  this->NumberOfThreads = this->Threader->GetNumberOfThreads();
+
   this->SetNumberOfInputPorts(2);
 
   // by default process active point vectors
@@ -132,6 +138,7 @@ vtkStreamTracer::~vtkStreamTracer()
 {
   this->SetIntegrator(0);
   this->SetInterpolatorPrototype(0);
+  this->Threader->Delete();
 }
 
 void vtkStreamTracer::SetSourceConnection(vtkAlgorithmOutput* algOutput)
@@ -514,12 +521,18 @@ int vtkStreamTracer::RequestData(
       const char *vecName = vectors->GetName();
       double propagation = 0;
       vtkIdType numSteps = 0;
-      this->Integrate(input0->GetPointData(), output,
-                      seeds, seedIds,
-                      integrationDirections,
-                      lastPoint, func,
-                      maxCellSize, vecType,vecName,
-                      propagation, numSteps);
+      if (!this->IntegrateInThreads(input0->GetPointData(), output,
+                                    seeds, seedIds,
+                                    integrationDirections, func,
+                                    maxCellSize, vecType, vecName))
+        {
+        this->Integrate(input0->GetPointData(), output,
+                        seeds, seedIds,
+                        integrationDirections,
+                        lastPoint, func,
+                        maxCellSize, vecType,vecName,
+                        propagation, numSteps);
+        }
       }
     func->Delete();
     seeds->Delete();
@@ -772,7 +785,10 @@ void vtkStreamTracer::Integrate(vtkPointData *input0Data,
     {
 
     double progress = static_cast<double>(currentLine)/numLines;
-    this->UpdateProgress(progress);
+    if (!this->IntegratingInThreads)
+      {
+      this->UpdateProgress(progress);
+      }
 
     switch (integrationDirections->GetValue(currentLine))
       {
@@ -789,8 +805,19 @@ void vtkStreamTracer::Integrate(vtkPointData *input0Data,
     vtkIdType index, numPts=0;
 
     // Clear the last cell to avoid starting a search from
-    // the last point in the streamline
-    func->ClearLastCellId();
+    // the last point in the streamline. The datasets are searched from the
+    // first one, so that the streamline does not depend on the previous
+    // ones, nor on the thread integrating it.
+    vtkCompositeInterpolatedVelocityField *compositeFunc =
+      vtkCompositeInterpolatedVelocityField::SafeDownCast(func);
+    if (compositeFunc)
+      {
+      compositeFunc->SetLastCellId(-1, 0);
+      }
+    else
+      {
+      func->ClearLastCellId();
+      }
 
     // Initial point
     seedSource->GetTuple(seedIds->GetId(currentLine), point1);
@@ -894,7 +921,7 @@ void vtkStreamTracer::Integrate(vtkPointData *input0Data,
         break;
         }
 
-      if ( numSteps++ % 1000 == 1 )
+      if ( numSteps++ % 1000 == 1 && !this->IntegratingInThreads )
         {
         progress =
           ( currentLine + propagation / this->MaximumPropagation ) / numLines;
@@ -931,7 +958,10 @@ void vtkStreamTracer::Integrate(vtkPointData *input0Data,
           }
         maxStep = stepSize.Interval;
         }
-      this->LastUsedStepSize = stepSize.Interval;
+      if (!this->IntegratingInThreads)
+        {
+        this->LastUsedStepSize = stepSize.Interval;
+        }
 
       // Calculate the next step using the integrator provided
       // Break if the next point is out of bounds.
@@ -1151,6 +1181,318 @@ void vtkStreamTracer::Integrate(vtkPointData *input0Data,
   return;
 }
 
+//---------------------------------------------------------------------------
+// The seeds are handed to the threads in batches of
+// VTK_STREAM_TRACER_BATCH_SIZE as the threads become free. Each batch is
+// integrated into a polydata of its own, and the batches are appended in
+// seed order once all are done.
+#define VTK_STREAM_TRACER_BATCH_SIZE 16
+
+namespace
+{
+  struct vtkStreamTracerThreadStruct
+  {
+    vtkStreamTracer *Filter;
+    vtkPointData *InputData;
+    vtkDataArray *SeedSource;
+    vtkIdList *SeedIds;
+    vtkIntArray *IntegrationDirections;
+    int MaxCellSize;
+    int VectorType;
+    const char *VectorName;
+    // The velocity field of each thread
+    std::vector<vtkAbstractInterpolatedVelocityField*> Functions;
+    std::vector<vtkPolyData*> Batches;
+    vtkIdType NextBatch;
+    vtkSimpleCriticalSection Lock;
+  };
+
+  // Return 1 if FindCell() and GetCell() of the dataset may be called from
+  // several threads at once, building first whatever vtkPolyData and
+  // vtkUnstructuredGrid build on the first search.
+  int PrepareConcurrentDataSet(vtkDataSet *ds)
+  {
+    if (!ds->IsA("vtkImageData") && !ds->IsA("vtkPolyData") &&
+        !ds->IsA("vtkUnstructuredGrid"))
+      {
+      return 0;
+      }
+    ds->GetLength();
+    if (ds->IsA("vtkImageData") ||
+        ds->GetNumberOfCells() < 1 || ds->GetNumberOfPoints() < 1)
+      {
+      return 1;
+      }
+    double bounds[6], x[3];
+    ds->GetCellBounds(0, bounds);
+    vtkIdList *cellIds = vtkIdList::New();
+    ds->GetPointCells(0, cellIds);
+    cellIds->Delete();
+    ds->GetPoint(0, x);
+    ds->FindPoint(x);
+    return 1;
+  }
+
+  // The array of a batch matching the array of the output, by name, or by
+  // index when the array has no name.
+  vtkAbstractArray *GetBatchArray(vtkDataSetAttributes *batchPD,
+                                  vtkDataSetAttributes *outputPD, int index)
+  {
+    const char *name = outputPD->GetAbstractArray(index)->GetName();
+    return name ? batchPD->GetAbstractArray(name) :
+      batchPD->GetAbstractArray(index);
+  }
+}
+
+VTK_THREAD_RETURN_TYPE vtkStreamTracer::ThreadedIntegrate( void *arg )
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkStreamTracerThreadStruct *str =
+    static_cast<vtkStreamTracerThreadStruct *>(info->UserData);
+  vtkStreamTracer *self = str->Filter;
+  vtkAbstractInterpolatedVelocityField *func =
+    str->Functions[info->ThreadID];
+
+  vtkIdType numLines = str->SeedIds->GetNumberOfIds();
+  vtkIdType numBatches = static_cast<vtkIdType>(str->Batches.size());
+  vtkIdList *seedIds = vtkIdList::New();
+  vtkIntArray *directions = vtkIntArray::New();
+  double lastPoint[3];
+
+  for (;;)
+    {
+    str->Lock.Lock();
+    vtkIdType batch = str->NextBatch++;
+    str->Lock.Unlock();
+    if (batch >= numBatches)
+      {
+      break;
+      }
+    if (info->ThreadID == 0)
+      {
+      self->UpdateProgress(static_cast<double>(batch)/numBatches);
+      }
+    if (self->GetAbortExecute())
+      {
+      break;
+      }
+
+    vtkIdType begin = batch * VTK_STREAM_TRACER_BATCH_SIZE;
+    vtkIdType end = begin + VTK_STREAM_TRACER_BATCH_SIZE;
+    end = ( end > numLines ? numLines : end );
+    seedIds->SetNumberOfIds(end - begin);
+    directions->SetNumberOfTuples(end - begin);
+    for (vtkIdType i = begin; i < end; i++)
+      {
+      seedIds->SetId(i - begin, str->SeedIds->GetId(i));
+      directions->SetValue(i - begin,
+                           str->IntegrationDirections->GetValue(i));
+      }
+
+    vtkPolyData *output = vtkPolyData::New();
+    double propagation = 0;
+    vtkIdType numSteps = 0;
+    self->Integrate(str->InputData, output, str->SeedSource, seedIds,
+                    directions, lastPoint, func, str->MaxCellSize,
+                    str->VectorType, str->VectorName, propagation, numSteps);
+    str->Batches[batch] = output;
+    }
+
+  directions->Delete();
+  seedIds->Delete();
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+int vtkStreamTracer::IntegrateInThreads(vtkPointData *input0Data,
+                                        vtkPolyData* output,
+                                        vtkDataArray* seedSource,
+                                        vtkIdList* seedIds,
+                                        vtkIntArray* integrationDirections,
+                                        vtkAbstractInterpolatedVelocityField* func,
+                                        int maxCellSize,
+                                        int vecType,
+                                        const char *vecName)
+{
+  vtkIdType numLines = seedIds->GetNumberOfIds();
+  vtkIdType numBatches = ( numLines + VTK_STREAM_TRACER_BATCH_SIZE - 1 ) /
+    VTK_STREAM_TRACER_BATCH_SIZE;
+  int numThreads = this->NumberOfThreads;
+  numThreads = ( numThreads > numBatches ?
+                 static_cast<int>(numBatches) : numThreads );
+  if (numThreads < 2 || !this->GetIntegrator() ||
+      !func->IsA("vtkInterpolatedVelocityField"))
+    {
+    return 0;
+    }
+
+  // All the threads search the datasets at once
+  vtkSmartPointer<vtkCompositeDataIterator> iter;
+  iter.TakeReference(this->InputData->NewIterator());
+  for (iter->GoToFirstItem(); !iter->IsDoneWithTraversal();
+       iter->GoToNextItem())
+    {
+    vtkDataSet* ds = vtkDataSet::SafeDownCast(iter->GetCurrentDataObject());
+    if (ds && !PrepareConcurrentDataSet(ds))
+      {
+      return 0;
+      }
+    }
+
+  vtkStreamTracerThreadStruct str;
+  str.Filter = this;
+  str.InputData = input0Data;
+  str.SeedSource = seedSource;
+  str.SeedIds = seedIds;
+  str.IntegrationDirections = integrationDirections;
+  str.MaxCellSize = maxCellSize;
+  str.VectorType = vecType;
+  str.VectorName = vecName;
+  str.Functions.push_back(func);
+  int t;
+  for (t = 1; t < numThreads; t++)
+    {
+    vtkAbstractInterpolatedVelocityField* threadFunc = 0;
+    int threadMaxCellSize = 0;
+    this->CheckInputs(threadFunc, &threadMaxCellSize);
+    str.Functions.push_back(threadFunc);
+    }
+  str.Batches.assign(numBatches, static_cast<vtkPolyData*>(0));
+  str.NextBatch = 0;
+
+  // The normals are generated once the streamlines are gathered
+  bool generateNormals = this->GenerateNormalsInIntegrate;
+  this->GenerateNormalsInIntegrate = false;
+  this->IntegratingInThreads = true;
+  this->Threader->SetNumberOfThreads(numThreads);
+  this->Threader->SetSingleMethod(vtkStreamTracer::ThreadedIntegrate, &str);
+  this->Threader->SingleMethodExecute();
+  this->IntegratingInThreads = false;
+  this->GenerateNormalsInIntegrate = generateNormals;
+
+  for (t = 1; t < numThreads; t++)
+    {
+    str.Functions[t]->Delete();
+    }
+
+  // Append the batches, unless aborted
+  size_t b;
+  vtkIdType numPts = 0;
+  bool complete = true;
+  for (b = 0; b < str.Batches.size(); b++)
+    {
+    complete = complete && str.Batches[b];
+    numPts += ( str.Batches[b] ? str.Batches[b]->GetNumberOfPoints() : 0 );
+    }
+  if (complete)
+    {
+    vtkPoints* outputPoints = vtkPoints::New();
+    outputPoints->SetNumberOfPoints(numPts);
+    vtkCellArray* outputLines = vtkCellArray::New();
+    vtkIntArray* retVals = vtkIntArray::New();
+    retVals->SetName("ReasonForTermination");
+
+    // The interpolated arrays kept by all the batches, then the arrays
+    // computed along the streamlines, as Integrate() orders them
+    vtkDataSetAttributes* outputPD = output->GetPointData();
+    outputPD->InterpolateAllocate(input0Data, numPts);
+    int i;
+    for (i = outputPD->GetNumberOfArrays() - 1; i >= 0; i--)
+      {
+      for (b = 0; b < str.Batches.size(); b++)
+        {
+        if (!GetBatchArray(str.Batches[b]->GetPointData(), outputPD, i))
+          {
+          outputPD->RemoveArray(i);
+          break;
+          }
+        }
+      }
+    vtkPointData* batchPD = str.Batches[0]->GetPointData();
+    for (i = 0; i < batchPD->GetNumberOfArrays(); i++)
+      {
+      vtkAbstractArray* array = batchPD->GetAbstractArray(i);
+      if (array->GetName() && !outputPD->GetAbstractArray(array->GetName()))
+        {
+        vtkAbstractArray* newArray = array->NewInstance();
+        newArray->SetName(array->GetName());
+        newArray->SetNumberOfComponents(array->GetNumberOfComponents());
+        outputPD->AddArray(newArray);
+        newArray->Delete();
+        }
+      }
+    for (i = 0; i < outputPD->GetNumberOfArrays(); i++)
+      {
+      outputPD->GetAbstractArray(i)->SetNumberOfTuples(numPts);
+      }
+
+    vtkIdType offset = 0;
+    for (b = 0; b < str.Batches.size(); b++)
+      {
+      vtkPolyData* batch = str.Batches[b];
+      vtkIdType numBatchPts = batch->GetNumberOfPoints();
+      vtkIdType j;
+      for (j = 0; j < numBatchPts; j++)
+        {
+        outputPoints->SetPoint(offset + j, batch->GetPoint(j));
+        }
+      for (i = 0; i < outputPD->GetNumberOfArrays(); i++)
+        {
+        vtkAbstractArray* from =
+          GetBatchArray(batch->GetPointData(), outputPD, i);
+        vtkAbstractArray* to = outputPD->GetAbstractArray(i);
+        for (j = 0; j < numBatchPts; j++)
+          {
+          to->SetTuple(offset + j, j, from);
+          }
+        }
+
+      vtkIdType npts, *pts;
+      vtkCellArray* lines = batch->GetLines();
+      for (lines->InitTraversal(); lines->GetNextCell(npts, pts); )
+        {
+        outputLines->InsertNextCell(static_cast<int>(npts));
+        for (j = 0; j < npts; j++)
+          {
+          outputLines->InsertCellPoint(offset + pts[j]);
+          }
+        }
+      vtkDataArray* batchRetVals =
+        batch->GetCellData()->GetArray("ReasonForTermination");
+      for (j = 0; batchRetVals && j < batchRetVals->GetNumberOfTuples(); j++)
+        {
+        retVals->InsertNextTuple(j, batchRetVals);
+        }
+      offset += numBatchPts;
+      }
+
+    output->SetPoints(outputPoints);
+    if ( numPts > 1 )
+      {
+      output->SetLines(outputLines);
+      if (this->GenerateNormalsInIntegrate)
+        {
+        this->GenerateNormals(output, 0, vecName);
+        }
+      output->GetCellData()->AddArray(retVals);
+      }
+    retVals->Delete();
+    outputLines->Delete();
+    outputPoints->Delete();
+    }
+
+  for (b = 0; b < str.Batches.size(); b++)
+    {
+    if (str.Batches[b])
+      {
+      str.Batches[b]->Delete();
+      }
+    }
+
+  output->Squeeze();
+  return 1;
+}
+
 void vtkStreamTracer::GenerateNormals(vtkPolyData* output, double* firstNormal,
                                       const char *vecName)
 {
@@ -1361,6 +1703,7 @@ void vtkStreamTracer::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "Vorticity computation: "
      << (this->ComputeVorticity ? " On" : " Off") << endl;
   os << indent << "Rotation scale: " << this->RotationScale << endl;
+  os << indent << "Number of threads: " << this->NumberOfThreads << endl;
 }
 
 vtkExecutive* vtkStreamTracer::CreateDefaultExecutive()
@@ -67,6 +67,14 @@
 // a source object, traces will be generated from each point in the source
 // that is inside the dataset.
 //
+// The seeds are integrated by several threads, each with its own copy of
+// the velocity field, taking batches of seeds as they become free. The
+// streamlines are gathered in seed order, so the output does not depend on
+// the number of threads. Threads are used with the default
+// vtkInterpolatedVelocityField over vtkImageData, vtkPolyData and
+// vtkUnstructuredGrid datasets; other inputs and interpolators are
+// integrated by a single thread.
+//
 // .SECTION See Also
 // vtkRibbonFilter vtkRuledSurfaceFilter vtkInitialValueProblemSolver
 // vtkRungeKutta2 vtkRungeKutta4 vtkRungeKutta45 vtkTemporalStreamTracer
@@ -90,6 +98,7 @@ class vtkGenericCell;
 class vtkIdList;
 class vtkIntArray;
 class vtkAbstractInterpolatedVelocityField;
+class vtkMultiThreader;
 
 class VTKFILTERSFLOWPATHS_EXPORT vtkStreamTracer : public vtkPolyDataAlgorithm
 {
@@ -282,6 +291,12 @@ public:
   vtkSetMacro(RotationScale, double);
   vtkGetMacro(RotationScale, double);
 
+  // Description:
+  // Set/Get the number of threads integrating the seeds. It defaults to
+  // the number of processors.
+  vtkSetClampMacro(NumberOfThreads, int, 1, VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads, int);
+
   // Description:
   // The object used to interpolate the velocity field during
   // integration is of the same class as this prototype.
@@ -332,10 +347,33 @@ protected:
                        vtkAbstractInterpolatedVelocityField* func);
   int CheckInputs(vtkAbstractInterpolatedVelocityField*& func,
                   int* maxCellSize);
+
+  // Description:
+  // Integrate the seeds as Integrate() does, in batches over
+  // NumberOfThreads threads each with its own copy of func, and append the
+  // streamlines to the output in seed order. Returns 0, doing nothing, if
+  // func or the input can not be used by several threads at once.
+  int IntegrateInThreads(vtkPointData *inputData,
+                         vtkPolyData* output,
+                         vtkDataArray* seedSource,
+                         vtkIdList* seedIds,
+                         vtkIntArray* integrationDirections,
+                         vtkAbstractInterpolatedVelocityField* func,
+                         int maxCellSize,
+                         int vecType,
+                         const char *vecFieldName);
+  static VTK_THREAD_RETURN_TYPE ThreadedIntegrate( void *arg );
   void GenerateNormals(vtkPolyData* output, double* firstNormal, const char *vecName);
 
   bool GenerateNormalsInIntegrate;
 
+  // Set while threads call Integrate(), which then leaves progress and
+  // LastUsedStepSize alone.
+  bool IntegratingInThreads;
+
+  int NumberOfThreads;
+  vtkMultiThreader *Threader;
+
   // starting from global x-y-z position
   double StartPosition[3];
 
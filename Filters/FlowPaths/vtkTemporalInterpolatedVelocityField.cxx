@@ -128,6 +128,33 @@ void vtkTemporalInterpolatedVelocityField::AdvanceOneTimeStep()
   }
 }
 //---------------------------------------------------------------------------
+int vtkTemporalInterpolatedVelocityField::PrepareConcurrentDataSetAccess()
+{
+  return this->ivf[0]->PrepareConcurrentDataSetAccess() &&
+    this->ivf[1]->PrepareConcurrentDataSetAccess();
+}
+//---------------------------------------------------------------------------
+void vtkTemporalInterpolatedVelocityField::CopyDataSets(
+  vtkTemporalInterpolatedVelocityField *from)
+{
+  this->times[0] = from->times[0];
+  this->times[1] = from->times[1];
+  this->ScaleCoeff = from->ScaleCoeff;
+  this->StaticDataSets = from->StaticDataSets;
+  for (int T=0; T<2; T++)
+    {
+    vtkCachingInterpolatedVelocityField *source = from->ivf[T];
+    this->ivf[T] = vtkSmartPointer<vtkCachingInterpolatedVelocityField>::New();
+    this->ivf[T]->SelectVectors(source->GetVectorsSelection());
+    for (size_t i=0; i<source->CacheList.size(); i++)
+      {
+      IVFDataSetInfo *data = &source->CacheList[i];
+      this->ivf[T]->SetDataSet(static_cast<int>(i), data->DataSet,
+                               data->StaticDataSet, data->BSPTree);
+      }
+    }
+}
+//---------------------------------------------------------------------------
 void vtkTemporalInterpolatedVelocityField::ShowCacheResults()
 {
   vtkErrorMacro(<< ")\n"
@@ -133,6 +133,18 @@ public:
 
   void AdvanceOneTimeStep();
 
+  // Description:
+  // Build the cell locators of the datasets now, and return 1 if the
+  // datasets may then be searched from several threads at once, each
+  // thread using its own function set set up by CopyDataSets(). This
+  // holds for images and for datasets searched with a cell locator.
+  int PrepareConcurrentDataSetAccess();
+
+  // Description:
+  // Use the datasets, times, vectors and cell locators of another function
+  // set. The cell caches of the two function sets remain independent.
+  void CopyDataSets(vtkTemporalInterpolatedVelocityField *from);
+
 protected:
   vtkTemporalInterpolatedVelocityField();
   ~vtkTemporalInterpolatedVelocityField();
@@ -0,0 +1,165 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestBooleanOperationOpenSurface.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// This tests vtkBooleanOperationPolyDataFilter on a closed sphere and an
+// open partial sphere: the union and the intersection must keep the cells
+// that vtkDistancePolyDataFilter classifies on the same side of the other
+// surface, with the same distances. Ray parity is then checked to keep the
+// same cells as the default classification on two closed spheres.
+
+#include <vtkBooleanOperationPolyDataFilter.h>
+#include <vtkCellData.h>
+#include <vtkDistancePolyDataFilter.h>
+#include <vtkDoubleArray.h>
+#include <vtkIntArray.h>
+#include <vtkIntersectionPolyDataFilter.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkSphereSource.h>
+
+#include <cmath>
+#include <vector>
+
+int TestBooleanOperationOpenSurface(int, char *[])
+{
+  vtkSmartPointer<vtkSphereSource> sphere0 =
+    vtkSmartPointer<vtkSphereSource>::New();
+  sphere0->SetRadius(2.0);
+  sphere0->SetPhiResolution(31);
+  sphere0->SetThetaResolution(41);
+
+  // A sphere with a wedge cut out, so that its seams are open.
+  vtkSmartPointer<vtkSphereSource> sphere1 =
+    vtkSmartPointer<vtkSphereSource>::New();
+  sphere1->SetCenter(1.0, 0.3, 0.2);
+  sphere1->SetRadius(1.5);
+  sphere1->SetPhiResolution(27);
+  sphere1->SetThetaResolution(33);
+  sphere1->SetStartTheta(20.0);
+  sphere1->SetEndTheta(250.0);
+
+  // Baseline: the distances of vtkDistancePolyDataFilter between the split
+  // surfaces.
+  vtkSmartPointer<vtkIntersectionPolyDataFilter> intersection =
+    vtkSmartPointer<vtkIntersectionPolyDataFilter>::New();
+  intersection->SetInputConnection(0, sphere0->GetOutputPort());
+  intersection->SetInputConnection(1, sphere1->GetOutputPort());
+  intersection->SplitFirstOutputOn();
+  intersection->SplitSecondOutputOn();
+
+  vtkSmartPointer<vtkDistancePolyDataFilter> distance =
+    vtkSmartPointer<vtkDistancePolyDataFilter>::New();
+  distance->SetInputConnection(0, intersection->GetOutputPort(1));
+  distance->SetInputConnection(1, intersection->GetOutputPort(2));
+  distance->ComputeSecondDistanceOn();
+  distance->Update();
+
+  vtkDoubleArray *baseline[2] = {
+    vtkDoubleArray::SafeDownCast(
+      distance->GetOutput()->GetCellData()->GetArray("Distance")),
+    vtkDoubleArray::SafeDownCast(
+      distance->GetSecondDistanceOutput()->GetCellData()->GetArray(
+        "Distance")) };
+  if (!baseline[0] || !baseline[1])
+    {
+    std::cerr << "Error: missing baseline distances" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  int operations[2] = {
+    vtkBooleanOperationPolyDataFilter::VTK_UNION,
+    vtkBooleanOperationPolyDataFilter::VTK_INTERSECTION };
+  for (int op = 0; op < 2; ++op)
+    {
+    vtkSmartPointer<vtkBooleanOperationPolyDataFilter> boolean =
+      vtkSmartPointer<vtkBooleanOperationPolyDataFilter>::New();
+    boolean->SetInputConnection(0, sphere0->GetOutputPort());
+    boolean->SetInputConnection(1, sphere1->GetOutputPort());
+    boolean->SetOperation(operations[op]);
+    boolean->Update();
+    double tolerance = boolean->GetTolerance();
+
+    // The cells kept from each surface, in order.
+    std::vector<double> expected;
+    std::vector<int> expectedSource;
+    for (int idx = 0; idx < 2; ++idx)
+      {
+      for (vtkIdType i = 0; i < baseline[idx]->GetNumberOfTuples(); ++i)
+        {
+        double d = baseline[idx]->GetValue(i);
+        if ((d > tolerance) == (op == 0))
+          {
+          expected.push_back(d);
+          expectedSource.push_back(idx);
+          }
+        }
+      }
+
+    vtkPolyData *output = boolean->GetOutput();
+    vtkDoubleArray *actual = vtkDoubleArray::SafeDownCast(
+      output->GetCellData()->GetArray("Distance"));
+    vtkIntArray *source = vtkIntArray::SafeDownCast(
+      output->GetCellData()->GetArray("CellSource"));
+    if (!actual || !source ||
+        output->GetNumberOfCells() != static_cast<vtkIdType>(expected.size()))
+      {
+      std::cerr << "Error: operation " << operations[op] << " keeps "
+                << output->GetNumberOfCells() << " cells instead of "
+                << expected.size() << std::endl;
+      return EXIT_FAILURE;
+      }
+    for (vtkIdType i = 0; i < output->GetNumberOfCells(); ++i)
+      {
+      if (source->GetValue(i) != expectedSource[i] ||
+          std::fabs(actual->GetValue(i) - expected[i]) > 1e-8)
+        {
+        std::cerr << "Error: operation " << operations[op] << ", cell " << i
+                  << " has distance " << actual->GetValue(i) << " instead of "
+                  << expected[i] << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  // On closed surfaces, ray parity keeps the same cells as the
+  // pseudonormals, except maybe for cells whose centers lie on the other
+  // surface.
+  sphere1->SetStartTheta(0.0);
+  sphere1->SetEndTheta(360.0);
+  vtkIdType kept[2];
+  for (int parity = 0; parity < 2; ++parity)
+    {
+    vtkSmartPointer<vtkBooleanOperationPolyDataFilter> boolean =
+      vtkSmartPointer<vtkBooleanOperationPolyDataFilter>::New();
+    boolean->SetInputConnection(0, sphere0->GetOutputPort());
+    boolean->SetInputConnection(1, sphere1->GetOutputPort());
+    boolean->SetUseRayParity(parity);
+    boolean->Update();
+    vtkDataArray *distances =
+      boolean->GetOutput()->GetCellData()->GetArray("Distance");
+    kept[parity] = 0;
+    for (vtkIdType i = 0; distances && i < distances->GetNumberOfTuples(); ++i)
+      {
+      kept[parity] += (distances->GetTuple1(i) > 1e-3 ? 1 : 0);
+      }
+    }
+  if (kept[0] == 0 || kept[0] != kept[1])
+    {
+    std::cerr << "Error: the union keeps " << kept[1] << " cells with ray "
+              << "parity instead of " << kept[0] << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,181 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestBooleanOperationThreads.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// This tests that vtkIntersectionPolyDataFilter and
+// vtkBooleanOperationPolyDataFilter produce the same output whatever the
+// number of threads, and that the boolean classification agrees with
+// vtkDistancePolyDataFilter.
+
+#include <vtkBooleanOperationPolyDataFilter.h>
+#include <vtkCellData.h>
+#include <vtkDistancePolyDataFilter.h>
+#include <vtkDoubleArray.h>
+#include <vtkIntArray.h>
+#include <vtkIntersectionPolyDataFilter.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkSphereSource.h>
+
+#include <cmath>
+
+static bool SamePolyData(vtkPolyData *a, vtkPolyData *b)
+{
+  if (a->GetNumberOfPoints() != b->GetNumberOfPoints() ||
+      a->GetNumberOfCells() != b->GetNumberOfCells())
+    {
+    return false;
+    }
+  for (vtkIdType i = 0; i < a->GetNumberOfPoints(); ++i)
+    {
+    double pa[3], pb[3];
+    a->GetPoint(i, pa);
+    b->GetPoint(i, pb);
+    if (pa[0] != pb[0] || pa[1] != pb[1] || pa[2] != pb[2])
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+int TestBooleanOperationThreads(int, char *[])
+{
+  vtkSmartPointer<vtkSphereSource> sphere0 =
+    vtkSmartPointer<vtkSphereSource>::New();
+  sphere0->SetRadius(2.0);
+  sphere0->SetPhiResolution(31);
+  sphere0->SetThetaResolution(41);
+
+  vtkSmartPointer<vtkSphereSource> sphere1 =
+    vtkSmartPointer<vtkSphereSource>::New();
+  sphere1->SetCenter(1.0, 0.3, 0.2);
+  sphere1->SetRadius(1.5);
+  sphere1->SetPhiResolution(27);
+  sphere1->SetThetaResolution(33);
+
+  // Intersection: same lines and split surfaces for any number of threads
+  vtkSmartPointer<vtkIntersectionPolyDataFilter> reference =
+    vtkSmartPointer<vtkIntersectionPolyDataFilter>::New();
+  reference->SetInputConnection(0, sphere0->GetOutputPort());
+  reference->SetInputConnection(1, sphere1->GetOutputPort());
+  reference->SetNumberOfThreads(1);
+  reference->Update();
+
+  if (reference->GetOutput()->GetNumberOfLines() == 0)
+    {
+    std::cerr << "Error: no intersection lines found" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  vtkSmartPointer<vtkIntersectionPolyDataFilter> threaded =
+    vtkSmartPointer<vtkIntersectionPolyDataFilter>::New();
+  threaded->SetInputConnection(0, sphere0->GetOutputPort());
+  threaded->SetInputConnection(1, sphere1->GetOutputPort());
+  threaded->SetNumberOfThreads(4);
+  threaded->Update();
+
+  for (int port = 0; port < 3; ++port)
+    {
+    if (!SamePolyData(reference->GetOutput(port), threaded->GetOutput(port)))
+      {
+      std::cerr << "Error: output " << port << " of the intersection "
+                << "differs with 4 threads" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // Boolean union: same surface for any number of threads
+  vtkSmartPointer<vtkBooleanOperationPolyDataFilter> booleanReference =
+    vtkSmartPointer<vtkBooleanOperationPolyDataFilter>::New();
+  booleanReference->SetInputConnection(0, sphere0->GetOutputPort());
+  booleanReference->SetInputConnection(1, sphere1->GetOutputPort());
+  booleanReference->SetOperationToUnion();
+  booleanReference->SetNumberOfThreads(1);
+  booleanReference->Update();
+
+  vtkSmartPointer<vtkBooleanOperationPolyDataFilter> booleanThreaded =
+    vtkSmartPointer<vtkBooleanOperationPolyDataFilter>::New();
+  booleanThreaded->SetInputConnection(0, sphere0->GetOutputPort());
+  booleanThreaded->SetInputConnection(1, sphere1->GetOutputPort());
+  booleanThreaded->SetOperationToUnion();
+  booleanThreaded->SetNumberOfThreads(4);
+  booleanThreaded->Update();
+
+  if (booleanReference->GetOutput()->GetNumberOfCells() == 0 ||
+      !SamePolyData(booleanReference->GetOutput(),
+                    booleanThreaded->GetOutput()))
+    {
+    std::cerr << "Error: the union differs with 4 threads" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The cells of the first surface kept in the union agree with the
+  // distances of vtkDistancePolyDataFilter, except maybe for cells whose
+  // centers lie on the second surface.
+  vtkSmartPointer<vtkDistancePolyDataFilter> distance =
+    vtkSmartPointer<vtkDistancePolyDataFilter>::New();
+  distance->SetInputConnection(0, reference->GetOutputPort(1));
+  distance->SetInputConnection(1, reference->GetOutputPort(2));
+  distance->Update();
+
+  vtkDoubleArray *expected = vtkDoubleArray::SafeDownCast(
+    distance->GetOutput()->GetCellData()->GetArray("Distance"));
+  vtkDoubleArray *actual = vtkDoubleArray::SafeDownCast(
+    booleanReference->GetOutput()->GetCellData()->GetArray("Distance"));
+  vtkIntArray *source = vtkIntArray::SafeDownCast(
+    booleanReference->GetOutput()->GetCellData()->GetArray("CellSource"));
+  if (!expected || !actual || !source)
+    {
+    std::cerr << "Error: missing cell arrays" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  vtkIdType outside = 0, onSurface = 0;
+  for (vtkIdType i = 0; i < expected->GetNumberOfTuples(); ++i)
+    {
+    if (std::fabs(expected->GetValue(i)) < 1e-3)
+      {
+      ++onSurface;
+      }
+    else if (expected->GetValue(i) > 0.0)
+      {
+      ++outside;
+      }
+    }
+
+  vtkIdType kept = 0;
+  for (vtkIdType i = 0; i < source->GetNumberOfTuples(); ++i)
+    {
+    if (source->GetValue(i) != 0)
+      {
+      continue;
+      }
+    if (actual->GetValue(i) <= booleanReference->GetTolerance())
+      {
+      std::cerr << "Error: cell " << i << " of the union is not outside of "
+                << "the second surface" << std::endl;
+      return EXIT_FAILURE;
+      }
+    ++kept;
+    }
+
+  if (kept < outside || kept > outside + onSurface)
+    {
+    std::cerr << "Error: the union keeps " << kept << " cells of the first "
+              << "surface instead of " << outside << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,524 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestGradientFilterThreads.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// This tests that vtkGradientFilter and vtkCellDerivatives compute the
+// gradients, vorticity, Q-criterion and divergence of a linear field at the
+// points and cells of image data, rectilinear, structured and unstructured
+// grids, and that they compute the same values whatever the number of
+// threads. It also compares the finite differences used on structured data
+// with the interpolation functions of the same cells in an unstructured
+// grid, for a quadratic field and for a random field.
+
+#include "vtkAppendFilter.h"
+#include "vtkCell.h"
+#include "vtkCellData.h"
+#include "vtkCellDerivatives.h"
+#include "vtkDataSetTriangleFilter.h"
+#include "vtkDoubleArray.h"
+#include "vtkGradientFilter.h"
+#include "vtkImageData.h"
+#include "vtkMath.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkRectilinearGrid.h"
+#include "vtkSmartPointer.h"
+#include "vtkStructuredGrid.h"
+#include "vtkUnstructuredGrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+// The gradient of the linear field, A[i][j] = dv_i/dx_j
+static const double A[3][3] = { {  0.5, 2.0, -1.0 },
+                                { -3.0, 0.25, 1.5 },
+                                {  1.0, -2.0, 0.75 } };
+
+static void LinearField(const double x[3], double v[3])
+{
+  for (int i = 0; i < 3; ++i)
+    {
+    v[i] = 0.1 * i + A[i][0]*x[0] + A[i][1]*x[1] + A[i][2]*x[2];
+    }
+}
+
+static void QuadraticField(const double x[3], double v[3])
+{
+  LinearField(x, v);
+  v[0] += x[0] * x[1] - 0.5 * x[2] * x[2];
+  v[1] += 2.0 * x[0] * x[0] + x[1] * x[2];
+  v[2] += -x[0] * x[2] + 0.75 * x[1] * x[1];
+}
+
+static void RandomField(const double *, double v[3])
+{
+  for (int i = 0; i < 3; ++i)
+    {
+    v[i] = vtkMath::Random(-1.0, 1.0);
+    }
+}
+
+// Add the linear field at the points and at the cell centers
+static void AddFields(vtkDataSet *data,
+                      void (*field)(const double *, double *) = LinearField)
+{
+  vtkSmartPointer<vtkDoubleArray> pointField =
+    vtkSmartPointer<vtkDoubleArray>::New();
+  pointField->SetName("Field");
+  pointField->SetNumberOfComponents(3);
+  pointField->SetNumberOfTuples(data->GetNumberOfPoints());
+  for (vtkIdType i = 0; i < data->GetNumberOfPoints(); ++i)
+    {
+    double v[3];
+    field(data->GetPoint(i), v);
+    pointField->SetTuple(i, v);
+    }
+  data->GetPointData()->AddArray(pointField);
+
+  vtkSmartPointer<vtkDoubleArray> cellField =
+    vtkSmartPointer<vtkDoubleArray>::New();
+  cellField->SetName("Field");
+  cellField->SetNumberOfComponents(3);
+  cellField->SetNumberOfTuples(data->GetNumberOfCells());
+  for (vtkIdType i = 0; i < data->GetNumberOfCells(); ++i)
+    {
+    vtkCell *cell = data->GetCell(i);
+    double center[3] = { 0.0, 0.0, 0.0 }, v[3];
+    for (int p = 0; p < cell->GetNumberOfPoints(); ++p)
+      {
+      double *x = data->GetPoint(cell->GetPointId(p));
+      for (int c = 0; c < 3; ++c)
+        {
+        center[c] += x[c] / cell->GetNumberOfPoints();
+        }
+      }
+    field(center, v);
+    cellField->SetTuple(i, v);
+    }
+  data->GetCellData()->AddArray(cellField);
+}
+
+static bool Near(double value, double expected, const char *what,
+                 vtkIdType id)
+{
+  if (std::fabs(value - expected) > 1e-6 * (1.0 + std::fabs(expected)))
+    {
+    std::cerr << "Error: " << what << " " << id << " is " << value
+              << " instead of " << expected << std::endl;
+    return false;
+    }
+  return true;
+}
+
+// Check the gradient, vorticity, Q-criterion and divergence of the linear
+// field, where the field is not degenerate along the axes given by mask
+static bool CheckDerivatives(vtkDataSetAttributes *data, const char *name,
+                             const bool mask[3])
+{
+  vtkDataArray *gradients = data->GetArray("Gradients");
+  vtkDataArray *vorticity = data->GetArray("Vorticity");
+  vtkDataArray *qCriterion = data->GetArray("Q-criterion");
+  vtkDataArray *divergence = data->GetArray("Divergence");
+  if (!gradients || !vorticity || !qCriterion || !divergence ||
+      gradients->GetNumberOfTuples() != data->GetArray("Field")->
+        GetNumberOfTuples())
+    {
+    std::cerr << "Error: missing " << name << " arrays" << std::endl;
+    return false;
+    }
+
+  double g[9];
+  for (int i = 0; i < 3; ++i)
+    {
+    for (int j = 0; j < 3; ++j)
+      {
+      g[3*i+j] = mask[j] ? A[i][j] : 0.0;
+      }
+    }
+  double w[3] = { g[7] - g[5], g[2] - g[6], g[3] - g[1] };
+  double q = 0.5 * (0.5 * (w[0]*w[0] + w[1]*w[1] + w[2]*w[2]) -
+                    (g[0]*g[0] + g[4]*g[4] + g[8]*g[8] +
+                     0.5 * ((g[3]+g[1])*(g[3]+g[1]) +
+                            (g[6]+g[2])*(g[6]+g[2]) +
+                            (g[7]+g[5])*(g[7]+g[5]))));
+  for (vtkIdType id = 0; id < gradients->GetNumberOfTuples(); ++id)
+    {
+    for (int c = 0; c < 9; ++c)
+      {
+      if (!Near(gradients->GetComponent(id, c), g[c], name, id))
+        {
+        return false;
+        }
+      }
+    for (int c = 0; c < 3; ++c)
+      {
+      if (!Near(vorticity->GetComponent(id, c), w[c], name, id))
+        {
+        return false;
+        }
+      }
+    if (!Near(qCriterion->GetComponent(id, 0), q, name, id) ||
+        !Near(divergence->GetComponent(id, 0), g[0] + g[4] + g[8], name, id))
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+static bool SameArrays(vtkDataSetAttributes *data1,
+                       vtkDataSetAttributes *data2, const char *name)
+{
+  for (int a = 0; a < data1->GetNumberOfArrays(); ++a)
+    {
+    vtkDataArray *array1 = data1->GetArray(a);
+    vtkDataArray *array2 = data2->GetArray(array1->GetName());
+    if (!array2 ||
+        array1->GetNumberOfTuples() != array2->GetNumberOfTuples() ||
+        array1->GetNumberOfComponents() != array2->GetNumberOfComponents())
+      {
+      std::cerr << "Error: different " << name << " " << array1->GetName()
+                << " arrays" << std::endl;
+      return false;
+      }
+    for (vtkIdType id = 0; id < array1->GetNumberOfTuples(); ++id)
+      {
+      for (int c = 0; c < array1->GetNumberOfComponents(); ++c)
+        {
+        if (array1->GetComponent(id, c) != array2->GetComponent(id, c))
+          {
+          std::cerr << "Error: " << name << " " << array1->GetName() << " "
+                    << id << " depends on the number of threads"
+                    << std::endl;
+          return false;
+          }
+        }
+      }
+    }
+  return true;
+}
+
+static vtkSmartPointer<vtkDataSet> Gradients(vtkDataSet *input,
+                                             int fieldAssociation,
+                                             int numThreads,
+                                             bool faster = false)
+{
+  vtkSmartPointer<vtkGradientFilter> gradients =
+    vtkSmartPointer<vtkGradientFilter>::New();
+  gradients->SetInputData(input);
+  gradients->SetInputScalars(fieldAssociation, "Field");
+  gradients->ComputeVorticityOn();
+  gradients->ComputeQCriterionOn();
+  gradients->ComputeDivergenceOn();
+  gradients->SetFasterApproximation(faster);
+  gradients->SetNumberOfThreads(numThreads);
+  gradients->Update();
+  return gradients->GetOutput();
+}
+
+// Compare the derivatives with the gradient of the linear field, with one
+// and with four threads
+static bool TestGradients(vtkDataSet *input, const char *name,
+                          const bool mask[3])
+{
+  for (int cells = 0; cells < 2; ++cells)
+    {
+    int fieldAssociation = cells ? vtkDataObject::FIELD_ASSOCIATION_CELLS :
+      vtkDataObject::FIELD_ASSOCIATION_POINTS;
+    vtkSmartPointer<vtkDataSet> serial = Gradients(input, fieldAssociation, 1);
+    vtkSmartPointer<vtkDataSet> threaded =
+      Gradients(input, fieldAssociation, 4);
+    vtkDataSetAttributes *serialData = serial->GetPointData();
+    vtkDataSetAttributes *threadedData = threaded->GetPointData();
+    if (cells)
+      {
+      serialData = serial->GetCellData();
+      threadedData = threaded->GetCellData();
+      }
+    // the field at the cell centers of unstructured grids is converted to
+    // points, which is not exact at the boundary
+    if ((!cells || !input->IsA("vtkUnstructuredGrid")) &&
+        !CheckDerivatives(serialData, name, mask))
+      {
+      return false;
+      }
+    if (!SameArrays(serialData, threadedData, name))
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+// The same cells and fields in an unstructured grid
+static vtkSmartPointer<vtkDataSet> ToUnstructured(vtkDataSet *input)
+{
+  vtkSmartPointer<vtkAppendFilter> append =
+    vtkSmartPointer<vtkAppendFilter>::New();
+  append->AddInputData(input);
+  append->SetOutputPointsPrecision(vtkAlgorithm::DOUBLE_PRECISION);
+  append->Update();
+  return append->GetOutput();
+}
+
+// Compare two arrays up to tolerance times the largest value
+static bool CloseArrays(vtkDataArray *array1, vtkDataArray *array2,
+                        double tolerance, const char *name)
+{
+  double range[2], scale = 0.0;
+  for (int c = 0; c < array1->GetNumberOfComponents(); ++c)
+    {
+    array1->GetRange(range, c);
+    scale = std::max(scale, std::max(std::fabs(range[0]),
+                                     std::fabs(range[1])));
+    }
+  for (vtkIdType id = 0; id < array1->GetNumberOfTuples(); ++id)
+    {
+    for (int c = 0; c < array1->GetNumberOfComponents(); ++c)
+      {
+      if (std::fabs(array1->GetComponent(id, c) -
+                    array2->GetComponent(id, c)) > tolerance * scale)
+        {
+        std::cerr << "Error: " << name << " " << id << " is "
+                  << array1->GetComponent(id, c) << " instead of "
+                  << array2->GetComponent(id, c) << " with the cells"
+                  << std::endl;
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+// Compare the point gradients of the field, unless the tolerance is
+// negative, and the cell derivatives of its vectors, with those computed
+// through the cells of an unstructured grid
+static bool TestGenericCells(vtkDataSet *input, const char *name,
+                             double tolerance)
+{
+  vtkSmartPointer<vtkDataSet> unstructured = ToUnstructured(input);
+  vtkDataSet *inputs[2] = { input, unstructured };
+  vtkSmartPointer<vtkDataSet> gradients[2], derivatives[2];
+  for (int i = 0; i < 2; ++i)
+    {
+    gradients[i] = Gradients(inputs[i],
+      vtkDataObject::FIELD_ASSOCIATION_POINTS, 4);
+    inputs[i]->GetPointData()->SetVectors(
+      inputs[i]->GetPointData()->GetArray("Field"));
+    vtkSmartPointer<vtkCellDerivatives> cellDerivatives =
+      vtkSmartPointer<vtkCellDerivatives>::New();
+    cellDerivatives->SetInputData(inputs[i]);
+    cellDerivatives->SetTensorModeToComputeGradient();
+    cellDerivatives->SetNumberOfThreads(4);
+    cellDerivatives->Update();
+    derivatives[i] = cellDerivatives->GetOutput();
+    }
+  std::string pointName = std::string(name) + " point gradients";
+  std::string cellName = std::string(name) + " cell derivatives";
+  return (tolerance < 0.0 ||
+          CloseArrays(gradients[0]->GetPointData()->GetArray("Gradients"),
+                      gradients[1]->GetPointData()->GetArray("Gradients"),
+                      tolerance, pointName.c_str())) &&
+    CloseArrays(derivatives[0]->GetCellData()->GetArray("VectorGradient"),
+                derivatives[1]->GetCellData()->GetArray("VectorGradient"),
+                1e-10, cellName.c_str());
+}
+
+int TestGradientFilterThreads(int, char*[])
+{
+  const bool all[3] = { true, true, true };
+
+  // Image data, with an extent not starting at 0
+  vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+  image->SetExtent(2, 31, -5, 19, 0, 19);
+  image->SetOrigin(-1.0, -0.5, 0.2);
+  image->SetSpacing(0.1, 0.07, -0.05);
+  AddFields(image);
+  if (!TestGradients(image, "image", all))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // A single layer of image data, whose cells are pixels
+  vtkSmartPointer<vtkImageData> slice = vtkSmartPointer<vtkImageData>::New();
+  slice->SetExtent(0, 99, 0, 79, 0, 0);
+  slice->SetSpacing(0.01, 0.02, 1.0);
+  AddFields(slice);
+  const bool planar[3] = { true, true, false };
+  if (!TestGradients(slice, "slice", planar))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Rectilinear grid with varying spacing
+  vtkSmartPointer<vtkRectilinearGrid> rectilinear =
+    vtkSmartPointer<vtkRectilinearGrid>::New();
+  rectilinear->SetDimensions(30, 25, 20);
+  vtkSmartPointer<vtkDoubleArray> coordinates[3];
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    coordinates[axis] = vtkSmartPointer<vtkDoubleArray>::New();
+    double x = -1.0;
+    for (int i = 0; i < rectilinear->GetDimensions()[axis]; ++i)
+      {
+      coordinates[axis]->InsertNextValue(x);
+      x += 0.05 + 0.01 * ((i * (axis + 3)) % 7);
+      }
+    }
+  rectilinear->SetXCoordinates(coordinates[0]);
+  rectilinear->SetYCoordinates(coordinates[1]);
+  rectilinear->SetZCoordinates(coordinates[2]);
+  AddFields(rectilinear);
+  if (!TestGradients(rectilinear, "rectilinear", all))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Curvilinear grid
+  vtkSmartPointer<vtkStructuredGrid> structured =
+    vtkSmartPointer<vtkStructuredGrid>::New();
+  structured->SetDimensions(30, 25, 20);
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  for (int k = 0; k < 20; ++k)
+    {
+    for (int j = 0; j < 25; ++j)
+      {
+      for (int i = 0; i < 30; ++i)
+        {
+        double r = 1.0 + 0.1 * i, theta = 0.05 * j;
+        points->InsertNextPoint(r * std::cos(theta), r * std::sin(theta),
+                                0.1 * k + 0.02 * i);
+        }
+      }
+    }
+  structured->SetPoints(points);
+  AddFields(structured);
+  if (!TestGradients(structured, "structured", all))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Tetrahedra
+  vtkSmartPointer<vtkDataSetTriangleFilter> tetrahedra =
+    vtkSmartPointer<vtkDataSetTriangleFilter>::New();
+  tetrahedra->SetInputData(rectilinear);
+  tetrahedra->Update();
+  vtkSmartPointer<vtkUnstructuredGrid> unstructured =
+    vtkSmartPointer<vtkUnstructuredGrid>::New();
+  unstructured->ShallowCopy(tetrahedra->GetOutput());
+  unstructured->GetPointData()->Initialize();
+  unstructured->GetCellData()->Initialize();
+  AddFields(unstructured);
+  if (!TestGradients(unstructured, "unstructured", all))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // The faster approximation converts all the derived arrays to points
+  vtkSmartPointer<vtkDataSet> faster = Gradients(
+    unstructured, vtkDataObject::FIELD_ASSOCIATION_POINTS, 4, true);
+  if (!CheckDerivatives(faster->GetPointData(), "faster", all))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // vtkCellDerivatives, with the vector gradient stored as by vtkTensor
+  vtkDataSet *inputs[3] = { image, structured, unstructured };
+  for (int i = 0; i < 3; ++i)
+    {
+    vtkSmartPointer<vtkDoubleArray> scalars =
+      vtkSmartPointer<vtkDoubleArray>::New();
+    scalars->SetName("Scalars");
+    vtkDataArray *field = inputs[i]->GetPointData()->GetArray("Field");
+    for (vtkIdType id = 0; id < field->GetNumberOfTuples(); ++id)
+      {
+      scalars->InsertNextValue(field->GetComponent(id, 1));
+      }
+    inputs[i]->GetPointData()->SetScalars(scalars);
+    inputs[i]->GetPointData()->SetVectors(field);
+
+    vtkSmartPointer<vtkDataSet> outputs[2];
+    for (int t = 0; t < 2; ++t)
+      {
+      vtkSmartPointer<vtkCellDerivatives> derivatives =
+        vtkSmartPointer<vtkCellDerivatives>::New();
+      derivatives->SetInputData(inputs[i]);
+      derivatives->SetTensorModeToComputeGradient();
+      derivatives->SetVectorModeToComputeGradient();
+      derivatives->SetNumberOfThreads(t ? 4 : 1);
+      derivatives->Update();
+      outputs[t] = derivatives->GetOutput();
+      }
+    vtkDataArray *gradient =
+      outputs[0]->GetCellData()->GetArray("ScalarGradient");
+    vtkDataArray *tensors =
+      outputs[0]->GetCellData()->GetArray("VectorGradient");
+    if (!gradient || !tensors ||
+        !SameArrays(outputs[0]->GetCellData(), outputs[1]->GetCellData(),
+                    "cell derivatives"))
+      {
+      std::cerr << "Error: wrong cell derivatives" << std::endl;
+      return EXIT_FAILURE;
+      }
+    for (vtkIdType id = 0; id < inputs[i]->GetNumberOfCells(); ++id)
+      {
+      for (int j = 0; j < 3; ++j)
+        {
+        if (!Near(gradient->GetComponent(id, j), A[1][j], "scalar gradient",
+                  id))
+          {
+          return EXIT_FAILURE;
+          }
+        for (int k = 0; k < 3; ++k)
+          {
+          if (!Near(tensors->GetComponent(id, j + 3*k), A[j][k],
+                    "vector gradient", id))
+            {
+            return EXIT_FAILURE;
+            }
+          }
+        }
+      }
+    }
+
+  // Nonlinear fields. On image data the finite differences match the
+  // interpolation functions of the voxels up to rounding, on the curvilinear
+  // grid closely for a quadratic field. The varying spacing of the
+  // rectilinear grid only lets the derivatives at the cell centers match.
+  vtkMath::RandomSeed(8775);
+  vtkSmartPointer<vtkImageData> quadratic =
+    vtkSmartPointer<vtkImageData>::New();
+  quadratic->CopyStructure(image);
+  AddFields(quadratic, QuadraticField);
+  vtkSmartPointer<vtkImageData> random = vtkSmartPointer<vtkImageData>::New();
+  random->CopyStructure(image);
+  AddFields(random, RandomField);
+  vtkSmartPointer<vtkRectilinearGrid> randomRectilinear =
+    vtkSmartPointer<vtkRectilinearGrid>::New();
+  randomRectilinear->CopyStructure(rectilinear);
+  AddFields(randomRectilinear, RandomField);
+  vtkSmartPointer<vtkStructuredGrid> quadraticStructured =
+    vtkSmartPointer<vtkStructuredGrid>::New();
+  quadraticStructured->CopyStructure(structured);
+  AddFields(quadraticStructured, QuadraticField);
+  if (!TestGenericCells(quadratic, "quadratic image", 1e-10) ||
+      !TestGenericCells(random, "random image", 1e-10) ||
+      !TestGenericCells(randomRectilinear, "random rectilinear", -1.0) ||
+      !TestGenericCells(quadraticStructured, "quadratic structured", 1e-6))
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,320 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestLocatorCache.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// This tests that vtkCellLocator, vtkCellTreeLocator, vtkKdTree and
+// vtkOctreePointLocator load their search structure from CacheFileName
+// when it was written for the same data and parameters, answer queries as
+// if they had built it, and build it again when the data changed or the
+// file is truncated or holds an index out of range.
+
+#include <vtkCellLocator.h>
+#include <vtkCellTreeLocator.h>
+#include <vtkIdList.h>
+#include <vtkKdTree.h>
+#include <vtkMinimalStandardRandomSequence.h>
+#include <vtkOctreePointLocator.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkSphereSource.h>
+#include <vtkTestUtilities.h>
+
+#include <vtksys/SystemTools.hxx>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+// A locator that records whether its search structure was read from the
+// cache file
+template <class T>
+class CacheRecordingLocator : public T
+{
+public:
+  static CacheRecordingLocator *New() { return new CacheRecordingLocator; }
+  int Loaded;
+
+protected:
+  CacheRecordingLocator() { this->Loaded = 0; }
+  virtual int ReadSearchStructure(istream &is)
+  {
+    this->Loaded = T::ReadSearchStructure(is);
+    return this->Loaded;
+  }
+};
+
+// The random points at which the locators are queried
+static vtkSmartPointer<vtkPoints> QueryPoints()
+{
+  vtkSmartPointer<vtkMinimalStandardRandomSequence> random =
+    vtkSmartPointer<vtkMinimalStandardRandomSequence>::New();
+  random->SetSeed(2357);
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  for (int i = 0; i < 200; ++i)
+    {
+    double x[3];
+    for (int j = 0; j < 3; ++j)
+      {
+      random->Next();
+      x[j] = random->GetRangeValue(-1.2, 1.2);
+      }
+    points->InsertNextPoint(x);
+    }
+  return points;
+}
+
+// Query answers that depend on the search structure
+static std::vector<vtkIdType> Answers(vtkLocator *locator, vtkPoints *points)
+{
+  std::vector<vtkIdType> answers;
+  vtkSmartPointer<vtkIdList> ids = vtkSmartPointer<vtkIdList>::New();
+  vtkAbstractCellLocator *cellLocator =
+    vtkAbstractCellLocator::SafeDownCast(locator);
+  vtkKdTree *kdTree = vtkKdTree::SafeDownCast(locator);
+  vtkOctreePointLocator *pointLocator =
+    vtkOctreePointLocator::SafeDownCast(locator);
+  for (vtkIdType i = 0; i < points->GetNumberOfPoints(); ++i)
+    {
+    double x[3];
+    points->GetPoint(i, x);
+    if (cellLocator)
+      {
+      double box[6] = { x[0] - 0.1, x[0] + 0.1, x[1] - 0.1, x[1] + 0.1,
+                        x[2] - 0.1, x[2] + 0.1 };
+      cellLocator->FindCellsWithinBounds(box, ids);
+      answers.push_back(ids->GetNumberOfIds());
+      for (vtkIdType j = 0; j < ids->GetNumberOfIds(); ++j)
+        {
+        answers.push_back(ids->GetId(j));
+        }
+      }
+    else if (kdTree)
+      {
+      answers.push_back(kdTree->GetRegionContainingPoint(x[0], x[1], x[2]));
+      }
+    else if (pointLocator)
+      {
+      answers.push_back(pointLocator->FindClosestPoint(x));
+      pointLocator->FindPointsWithinRadius(0.2, x, ids);
+      answers.push_back(ids->GetNumberOfIds());
+      }
+    }
+  if (kdTree)
+    {
+    answers.push_back(kdTree->GetNumberOfRegions());
+    }
+  return answers;
+}
+
+template <class T>
+static bool TestCache(const std::string &fileName, vtkPolyData *mesh,
+                      vtkPolyData *moved)
+{
+  vtkSmartPointer<vtkPoints> queries = QueryPoints();
+  vtksys::SystemTools::RemoveFile(fileName.c_str());
+
+  // The first build writes the cache file
+  vtkSmartPointer<CacheRecordingLocator<T> > first =
+    vtkSmartPointer<CacheRecordingLocator<T> >::New();
+  first->SetDataSet(mesh);
+  first->SetCacheFileName(fileName.c_str());
+  first->BuildLocator();
+  if (first->Loaded || !vtksys::SystemTools::FileExists(fileName.c_str()))
+    {
+    std::cerr << "Error: " << first->GetClassName()
+              << " did not write its cache file" << std::endl;
+    return false;
+    }
+
+  // The same data, in another data set, is read back from the cache file
+  vtkSmartPointer<vtkPolyData> copy = vtkSmartPointer<vtkPolyData>::New();
+  copy->DeepCopy(mesh);
+  vtkSmartPointer<CacheRecordingLocator<T> > second =
+    vtkSmartPointer<CacheRecordingLocator<T> >::New();
+  second->SetDataSet(copy);
+  second->SetCacheFileName(fileName.c_str());
+  second->BuildLocator();
+  if (!second->Loaded || Answers(first, queries) != Answers(second, queries))
+    {
+    std::cerr << "Error: " << second->GetClassName()
+              << " did not read its cache file back" << std::endl;
+    return false;
+    }
+
+  // Other data are not read from the cache file, which is then replaced
+  vtkSmartPointer<T> reference = vtkSmartPointer<T>::New();
+  reference->SetDataSet(moved);
+  reference->BuildLocator();
+  vtkSmartPointer<CacheRecordingLocator<T> > third =
+    vtkSmartPointer<CacheRecordingLocator<T> >::New();
+  third->SetDataSet(moved);
+  third->SetCacheFileName(fileName.c_str());
+  third->BuildLocator();
+  if (third->Loaded ||
+      Answers(reference, queries) != Answers(third, queries))
+    {
+    std::cerr << "Error: " << third->GetClassName()
+              << " used a cache file written for other data" << std::endl;
+    return false;
+    }
+
+  // A truncated cache file is not read either
+  unsigned long length = vtksys::SystemTools::FileLength(fileName.c_str());
+  vtksys::SystemTools::CopyFileAlways(fileName.c_str(),
+                                      (fileName + ".tmp").c_str());
+  {
+  std::ifstream is((fileName + ".tmp").c_str(), std::ios::binary);
+  std::vector<char> bytes(length);
+  is.read(&bytes[0], length);
+  is.close();
+  std::ofstream os(fileName.c_str(), std::ios::binary | std::ios::trunc);
+  os.write(&bytes[0], length - 8);
+  }
+  vtksys::SystemTools::RemoveFile((fileName + ".tmp").c_str());
+  vtkSmartPointer<CacheRecordingLocator<T> > fourth =
+    vtkSmartPointer<CacheRecordingLocator<T> >::New();
+  fourth->SetDataSet(moved);
+  fourth->SetCacheFileName(fileName.c_str());
+  fourth->BuildLocator();
+  if (fourth->Loaded ||
+      Answers(reference, queries) != Answers(fourth, queries))
+    {
+    std::cerr << "Error: " << fourth->GetClassName()
+              << " used a truncated cache file" << std::endl;
+    return false;
+    }
+
+  vtksys::SystemTools::RemoveFile(fileName.c_str());
+  return true;
+}
+
+// The bytes of a value to write into a cache file
+template <class V>
+static std::string Bytes(V value)
+{
+  return std::string(reinterpret_cast<char *>(&value), sizeof(V));
+}
+
+// Where an invalid value is written into the cache file of each locator,
+// counted from the end of the file, and the value. vtkCellLocator and
+// vtkCellTreeLocator files end with cell ids.
+static std::streamoff Corruption(vtkCellLocator *, vtkPolyData *mesh,
+                                 std::string &bytes)
+{
+  bytes = Bytes(mesh->GetNumberOfCells());
+  return sizeof(vtkIdType);
+}
+
+static std::streamoff Corruption(vtkCellTreeLocator *, vtkPolyData *mesh,
+                                 std::string &bytes)
+{
+  bytes = Bytes(static_cast<unsigned int>(mesh->GetNumberOfCells()));
+  return sizeof(unsigned int);
+}
+
+// The nodes of a k-d tree are stored as six ints each, then twelve doubles
+// each: give the root more cells than the data set has
+static std::streamoff Corruption(vtkKdTree *kdTree, vtkPolyData *mesh,
+                                 std::string &bytes)
+{
+  std::streamoff numNodes = 2 * kdTree->GetNumberOfRegions() - 1;
+  bytes = Bytes(static_cast<int>(mesh->GetNumberOfCells() + 1));
+  return numNodes * (6 * sizeof(int) + 12 * sizeof(double)) - 5 * sizeof(int);
+}
+
+// An octree file ends with the point ids, then the points
+static std::streamoff Corruption(vtkOctreePointLocator *, vtkPolyData *mesh,
+                                 std::string &bytes)
+{
+  bytes = Bytes(static_cast<int>(mesh->GetNumberOfPoints()));
+  return sizeof(int) + 3 * mesh->GetNumberOfPoints() * sizeof(float);
+}
+
+// A cache file with an index out of range is not read
+template <class T>
+static bool TestCorruptCache(const std::string &fileName, vtkPolyData *mesh)
+{
+  vtksys::SystemTools::RemoveFile(fileName.c_str());
+  vtkSmartPointer<T> first = vtkSmartPointer<T>::New();
+  first->SetDataSet(mesh);
+  first->SetCacheFileName(fileName.c_str());
+  first->BuildLocator();
+
+  {
+  std::string bytes;
+  std::streamoff offset = Corruption(first.GetPointer(), mesh, bytes);
+  std::fstream fs(fileName.c_str(),
+                  std::ios::in | std::ios::out | std::ios::binary);
+  fs.seekp(-offset, std::ios::end);
+  fs.write(bytes.data(), bytes.size());
+  }
+
+  vtkSmartPointer<CacheRecordingLocator<T> > second =
+    vtkSmartPointer<CacheRecordingLocator<T> >::New();
+  second->SetDataSet(mesh);
+  second->SetCacheFileName(fileName.c_str());
+  second->BuildLocator();
+  vtkSmartPointer<vtkPoints> queries = QueryPoints();
+  vtksys::SystemTools::RemoveFile(fileName.c_str());
+  if (second->Loaded || Answers(first, queries) != Answers(second, queries))
+    {
+    std::cerr << "Error: " << first->GetClassName()
+              << " used a cache file with an invalid index" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+int TestLocatorCache(int argc, char *argv[])
+{
+  char *tempDir = vtkTestUtilities::GetArgOrEnvOrDefault(
+    "-T", argc, argv, "VTK_TEMP_DIR", "Testing/Temporary");
+  std::string dirName = tempDir;
+  delete [] tempDir;
+  if (!vtksys::SystemTools::MakeDirectory(dirName.c_str()))
+    {
+    std::cerr << "Error: cannot create " << dirName << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string fileName = dirName + "/TestLocatorCache.bin";
+
+  vtkSmartPointer<vtkSphereSource> sphere =
+    vtkSmartPointer<vtkSphereSource>::New();
+  sphere->SetPhiResolution(60);
+  sphere->SetThetaResolution(80);
+  sphere->Update();
+  vtkPolyData *mesh = sphere->GetOutput();
+
+  // The same mesh with a point moved
+  vtkSmartPointer<vtkPolyData> moved = vtkSmartPointer<vtkPolyData>::New();
+  moved->DeepCopy(mesh);
+  double x[3];
+  moved->GetPoint(100, x);
+  x[0] += 0.01;
+  moved->GetPoints()->SetPoint(100, x);
+
+  if (!TestCache<vtkCellLocator>(fileName, mesh, moved) ||
+      !TestCache<vtkCellTreeLocator>(fileName, mesh, moved) ||
+      !TestCache<vtkKdTree>(fileName, mesh, moved) ||
+      !TestCache<vtkOctreePointLocator>(fileName, mesh, moved) ||
+      !TestCorruptCache<vtkCellLocator>(fileName, mesh) ||
+      !TestCorruptCache<vtkCellTreeLocator>(fileName, mesh) ||
+      !TestCorruptCache<vtkKdTree>(fileName, mesh) ||
+      !TestCorruptCache<vtkOctreePointLocator>(fileName, mesh))
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
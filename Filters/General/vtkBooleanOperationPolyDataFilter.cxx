@@ -15,16 +15,18 @@
 #include "vtkBooleanOperationPolyDataFilter.h"
 
 #include "vtkCellData.h"
-#include "vtkDistancePolyDataFilter.h"
 #include "vtkDoubleArray.h"
 #include "vtkFloatArray.h"
 #include "vtkGenericCell.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkIntersectionPolyDataFilter.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
+#include "vtkPoints.h"
 #include "vtkSmartPointer.h"
+#include "vtkTriangleBVH.h"
 
 vtkStandardNewMacro(vtkBooleanOperationPolyDataFilter);
 
@@ -35,15 +37,74 @@ vtkBooleanOperationPolyDataFilter::vtkBooleanOperationPolyDataFilter() :
   this->Tolerance = 1e-6;
   this->Operation = VTK_UNION;
   this->ReorientDifferenceCells = 1;
+  this->UseRayParity = 0;
 
   this->SetNumberOfInputPorts(2);
   this->SetNumberOfOutputPorts(2);
 
+  this->Threader = vtkMultiThreader::New();
+  this->NumberOfThreads = this->Threader->GetNumberOfThreads();
 }
 
 //-----------------------------------------------------------------------------
 vtkBooleanOperationPolyDataFilter::~vtkBooleanOperationPolyDataFilter()
 {
+  this->Threader->Delete();
+}
+
+//-----------------------------------------------------------------------------
+void vtkBooleanOperationPolyDataFilter::ComputeDistances(vtkPolyData* mesh,
+                                                         vtkPolyData* src)
+{
+  if (mesh->GetNumberOfPolys() == 0 || mesh->GetNumberOfPoints() == 0)
+    {
+    vtkErrorMacro(<<"No points/cells to operate on");
+    return;
+    }
+
+  if (src->GetNumberOfPolys() == 0 || src->GetNumberOfPoints() == 0)
+    {
+    vtkErrorMacro(<<"No points/cells to difference from");
+    return;
+    }
+
+  vtkTriangleBVH bvh;
+  bvh.Build(src, 4);
+
+  // Signed distance of the points, positive outside of src.
+  vtkDoubleArray* pointArray = vtkDoubleArray::New();
+  pointArray->SetName( "Distance" );
+  bvh.ComputeSignedDistances( mesh->GetPoints(), pointArray, this->Threader,
+                              this->NumberOfThreads, this->UseRayParity );
+  mesh->GetPointData()->AddArray( pointArray );
+  pointArray->Delete();
+  mesh->GetPointData()->SetActiveScalars( "Distance" );
+
+  // Signed distance of the cell centers, queried as a single batch.
+  vtkIdType numCells = mesh->GetNumberOfCells();
+  vtkSmartPointer< vtkPoints > centers = vtkSmartPointer< vtkPoints >::New();
+  centers->SetDataTypeToDouble();
+  centers->SetNumberOfPoints( numCells );
+  vtkSmartPointer< vtkGenericCell > cell =
+    vtkSmartPointer< vtkGenericCell >::New();
+  double weights[VTK_CELL_SIZE];
+  for (vtkIdType cellId = 0; cellId < numCells; cellId++)
+    {
+    mesh->GetCell( cellId, cell );
+    int subId;
+    double pcoords[3], x[3];
+    cell->GetParametricCenter( pcoords );
+    cell->EvaluateLocation( subId, pcoords, x, weights );
+    centers->SetPoint( cellId, x );
+    }
+
+  vtkDoubleArray* cellArray = vtkDoubleArray::New();
+  cellArray->SetName( "Distance" );
+  bvh.ComputeSignedDistances( centers, cellArray, this->Threader,
+                              this->NumberOfThreads, this->UseRayParity );
+  mesh->GetCellData()->AddArray( cellArray );
+  cellArray->Delete();
+  mesh->GetCellData()->SetActiveScalars( "Distance" );
 }
 
 //-----------------------------------------------------------------------------
@@ -110,25 +171,28 @@ int vtkBooleanOperationPolyDataFilter::RequestData(vtkInformation*        vtkNot
     (1, this->GetInputConnection(1, 0));
   PolyDataIntersection->SplitFirstOutputOn();
   PolyDataIntersection->SplitSecondOutputOn();
+  PolyDataIntersection->SetNumberOfThreads(this->NumberOfThreads);
   PolyDataIntersection->Update();
 
   outputIntersection->CopyStructure(PolyDataIntersection->GetOutput());
   outputIntersection->GetPointData()->PassData(PolyDataIntersection->GetOutput()->GetPointData());
   outputIntersection->GetCellData()->PassData(PolyDataIntersection->GetOutput()->GetCellData());
 
-  // Compute distances
-  vtkSmartPointer<vtkDistancePolyDataFilter> PolyDataDistance =
-    vtkSmartPointer<vtkDistancePolyDataFilter>::New();
-
-  PolyDataDistance->SetInputConnection
-    (0, PolyDataIntersection->GetOutputPort( 1 ));
-  PolyDataDistance->SetInputConnection
-    (1, PolyDataIntersection->GetOutputPort( 2 ));
-  PolyDataDistance->ComputeSecondDistanceOn();
-  PolyDataDistance->Update();
-
-  vtkPolyData* pd0 = PolyDataDistance->GetOutput();
-  vtkPolyData* pd1 = PolyDataDistance->GetSecondDistanceOutput();
+  // Compute distances of each split surface to the other one
+  vtkSmartPointer< vtkPolyData > pd0 = vtkSmartPointer< vtkPolyData >::New();
+  vtkSmartPointer< vtkPolyData > pd1 = vtkSmartPointer< vtkPolyData >::New();
+  vtkPolyData* splitSurfaces[2] = { PolyDataIntersection->GetOutput( 1 ),
+                                    PolyDataIntersection->GetOutput( 2 ) };
+  vtkPolyData* pds[2] = { pd0, pd1 };
+  for (int idx = 0; idx < 2; idx++)
+    {
+    pds[idx]->CopyStructure( splitSurfaces[idx] );
+    pds[idx]->GetPointData()->PassData( splitSurfaces[idx]->GetPointData() );
+    pds[idx]->GetCellData()->PassData( splitSurfaces[idx]->GetCellData() );
+    pds[idx]->BuildCells();
+    }
+  this->ComputeDistances( pd0, pd1 );
+  this->ComputeDistances( pd1, pd0 );
 
   pd0->BuildCells();
   pd0->BuildLinks();
@@ -252,6 +316,8 @@ void vtkBooleanOperationPolyDataFilter::PrintSelf(ostream& os, vtkIndent indent)
     }
   os << "\n";
   os << indent << "ReorientDifferenceCells: " << this->ReorientDifferenceCells << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+  os << indent << "UseRayParity: " << this->UseRayParity << "\n";
 }
 
 //-----------------------------------------------------------------------------
@@ -28,6 +28,11 @@
 // by Cory Quammen, Chris Weigle C., Russ Taylor
 // http://hdl.handle.net/10380/3262
 // http://www.midasjournal.org/browse/publication/797
+//
+// Each split surface is classified against the other with signed distances
+// computed in batches over a bounding volume hierarchy of the other
+// surface's triangles; the sign is given by an inside/outside test, so the
+// surfaces should be closed.
 
 #ifndef __vtkBooleanOperationPolyDataFilter_h
 #define __vtkBooleanOperationPolyDataFilter_h
@@ -38,6 +43,7 @@
 #include "vtkDataSetAttributes.h" // Needed for CopyCells() method
 
 class vtkIdList;
+class vtkMultiThreader;
 
 class VTKFILTERSGENERAL_EXPORT vtkBooleanOperationPolyDataFilter : public vtkPolyDataAlgorithm
 {
@@ -82,6 +88,23 @@ public:
   vtkSetMacro(Tolerance, double);
   vtkGetMacro(Tolerance, double);
 
+  // Description:
+  // Set/Get the number of threads used to intersect the surfaces and to
+  // compute the distances. Defaults to the number of available processors.
+  vtkSetClampMacro(NumberOfThreads, int, 1, VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads, int);
+
+  // Description:
+  // Turn on/off the classification of the points and cells of each surface
+  // by counting the crossings of rays with the other surface. By default
+  // they are classified by the pseudonormal of the closest feature of the
+  // other surface, as vtkImplicitPolyDataDistance does, which relies on its
+  // orientation but applies to open surfaces. Ray parity only applies to
+  // closed surfaces, but does not rely on their orientation. Defaults to off.
+  vtkSetMacro(UseRayParity, int);
+  vtkGetMacro(UseRayParity, int);
+  vtkBooleanMacro(UseRayParity, int);
+
 protected:
   vtkBooleanOperationPolyDataFilter();
   ~vtkBooleanOperationPolyDataFilter();
@@ -91,6 +114,11 @@ protected:
   void SortPolyData(vtkPolyData* input, vtkIdList* intersectionList,
                     vtkIdList* unionList);
 
+  // Description:
+  // Adds the "Distance" point and cell arrays to mesh: the signed distance
+  // of its points and cell centers to src, positive outside of src.
+  void ComputeDistances(vtkPolyData* mesh, vtkPolyData* src);
+
   int RequestData(vtkInformation*, vtkInformationVector**, vtkInformationVector*);
   int FillInputPortInformation(int, vtkInformation*);
 
@@ -121,6 +149,11 @@ private:
   // Determines if cells from the intersection surface should be
   // reversed in the difference surface.
   int ReorientDifferenceCells;
+
+  vtkMultiThreader *Threader;
+  int NumberOfThreads;
+
+  int UseRayParity;
 };
 
 #endif
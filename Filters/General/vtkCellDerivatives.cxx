@@ -18,14 +18,12 @@
 #include "vtkCellData.h"
 #include "vtkDataSet.h"
 #include "vtkDoubleArray.h"
-#include "vtkGenericCell.h"
+#include "vtkGradientKernels.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
-#include "vtkTensor.h"
-
-#include <math.h>
 
 vtkStandardNewMacro(vtkCellDerivatives);
 
@@ -33,6 +31,8 @@ vtkCellDerivatives::vtkCellDerivatives()
 {
   this->VectorMode = VTK_VECTOR_MODE_COMPUTE_GRADIENT;
   this->TensorMode = VTK_TENSOR_MODE_COMPUTE_GRADIENT;
+  this->Threader = vtkMultiThreader::New();
+  this->NumberOfThreads = this->Threader->GetNumberOfThreads();
 
   // by default process active point scalars
   this->SetInputArrayToProcess(0,0,0,vtkDataObject::FIELD_ASSOCIATION_POINTS,
@@ -43,6 +43,11 @@ vtkCellDerivatives::vtkCellDerivatives()
                                vtkDataSetAttributes::VECTORS);
 }
 
+vtkCellDerivatives::~vtkCellDerivatives()
+{
+  this->Threader->Delete();
+}
+
 int vtkCellDerivatives::RequestData(
   vtkInformation *vtkNotUsed(request),
   vtkInformationVector **inputVector,
@@ -66,7 +71,7 @@ int vtkCellDerivatives::RequestData(
   vtkDoubleArray *outVorticity=NULL;
   vtkDoubleArray *outTensors=NULL;
   vtkIdType numCells=input->GetNumberOfCells();
-  int computeScalarDerivs=1, computeVectorDerivs=1, computeVorticity=1, subId;
+  int computeScalarDerivs=1, computeVectorDerivs=1, computeVorticity=1;
 
   // Initialize
   vtkDebugMacro(<<"Computing cell derivatives");
@@ -94,6 +99,12 @@ int vtkCellDerivatives::RequestData(
     computeScalarDerivs = 0;
     }
 
+  if ( inVectors && inVectors->GetNumberOfComponents() != 3 )
+    {
+    vtkWarningMacro("Input vectors must have three components");
+    inVectors = NULL;
+    }
+
   if ( inVectors && this->VectorMode == VTK_VECTOR_MODE_COMPUTE_VORTICITY )
     {
     outVorticity = vtkDoubleArray::New();
@@ -126,101 +137,64 @@ int vtkCellDerivatives::RequestData(
     computeVectorDerivs = 0;
     }
 
-  // If just passing data forget the loop
-  if ( computeScalarDerivs || computeVectorDerivs || computeVorticity )
+  // The derivatives of the scalars and vectors are computed by threads, in
+  // double precision.
+  if ( computeScalarDerivs )
     {
-    double pcoords[3], derivs[9], w[3], *scalars, *vectors;
-    vtkGenericCell *cell = vtkGenericCell::New();
-    vtkIdType cellId;
-    vtkDoubleArray *cellScalars=vtkDoubleArray::New();
-    if ( computeScalarDerivs )
+    vtkDoubleArray *scalars = vtkDoubleArray::New();
+    scalars->SetNumberOfTuples(inScalars->GetNumberOfTuples());
+    scalars->CopyComponent(0, inScalars, 0);
+    if ( !vtkGradientKernels::ComputeCellGradients(
+           input, scalars, outGradients, NULL, NULL, NULL,
+           this->Threader, this->NumberOfThreads) )
       {
-      cellScalars->SetNumberOfComponents(inScalars->GetNumberOfComponents());
-      cellScalars->Allocate(cellScalars->GetNumberOfComponents()*VTK_CELL_SIZE);
-      cellScalars->SetName("Scalars");
+      vtkErrorMacro("Could not compute the scalar gradients");
       }
-    vtkDoubleArray *cellVectors=vtkDoubleArray::New();
-    cellVectors->SetNumberOfComponents(3);
-    cellVectors->Allocate(3*VTK_CELL_SIZE);
-    cellVectors->SetName("Vectors");
-    vtkTensor* tens = vtkTensor::New();
-
-    // Loop over all cells computing derivatives
-    vtkIdType progressInterval = numCells/20 + 1;
-    for (cellId=0; cellId < numCells; cellId++)
-      {
-      if ( ! (cellId % progressInterval) )
-        {
-        vtkDebugMacro(<<"Computing cell #" << cellId);
-        this->UpdateProgress (static_cast<double>(cellId)/numCells);
-        }
-
-      input->GetCell(cellId, cell);
-      subId = cell->GetParametricCenter(pcoords);
+    scalars->Delete();
+    }
 
-      if ( computeScalarDerivs )
-        {
-        inScalars->GetTuples(cell->PointIds, cellScalars);
-        scalars = cellScalars->GetPointer(0);
-        cell->Derivatives(subId, pcoords, scalars, 1, derivs);
-        outGradients->SetTuple(cellId, derivs);
-        }
+  if ( computeVectorDerivs || computeVorticity )
+    {
+    vtkDoubleArray *vectors = vtkDoubleArray::New();
+    vectors->DeepCopy(inVectors);
+    vtkDoubleArray *gradients = vtkDoubleArray::New();
+    gradients->SetNumberOfComponents(9);
+    gradients->SetNumberOfTuples(numCells);
+    if ( !vtkGradientKernels::ComputeCellGradients(
+           input, vectors, gradients, outVorticity, NULL, NULL,
+           this->Threader, this->NumberOfThreads) )
+      {
+      vtkErrorMacro("Could not compute the vector gradients");
+      }
 
-      if ( computeVectorDerivs || computeVorticity )
+    // Insert appropriate tensor, stored as by vtkTensor::SetComponent
+    if ( computeVectorDerivs )
+      {
+      double *derivs = gradients->GetPointer(0);
+      double *tensors = outTensors->GetPointer(0);
+      for (vtkIdType cellId=0; cellId < numCells; cellId++)
         {
-        inVectors->GetTuples(cell->PointIds, cellVectors);
-        vectors = cellVectors->GetPointer(0);
-        cell->Derivatives(0, pcoords, vectors, 3, derivs);
-
-        // Insert appropriate tensor
-        if ( this->TensorMode == VTK_TENSOR_MODE_COMPUTE_GRADIENT)
-          {
-          tens->SetComponent(0,0, derivs[0]);
-          tens->SetComponent(0,1, derivs[1]);
-          tens->SetComponent(0,2, derivs[2]);
-          tens->SetComponent(1,0, derivs[3]);
-          tens->SetComponent(1,1, derivs[4]);
-          tens->SetComponent(1,2, derivs[5]);
-          tens->SetComponent(2,0, derivs[6]);
-          tens->SetComponent(2,1, derivs[7]);
-          tens->SetComponent(2,2, derivs[8]);
-
-          outTensors->InsertTuple(cellId, tens->T);
-          }
-        else if (this->TensorMode == VTK_TENSOR_MODE_COMPUTE_STRAIN)
-          {
-          tens->SetComponent(0,0, derivs[0]);
-          tens->SetComponent(0,1, 0.5*(derivs[1]+derivs[3]));
-          tens->SetComponent(0,2, 0.5*(derivs[2]+derivs[6]));
-          tens->SetComponent(1,0, 0.5*(derivs[1]+derivs[3]));
-          tens->SetComponent(1,1, derivs[4]);
-          tens->SetComponent(1,2, 0.5*(derivs[5]+derivs[7]));
-          tens->SetComponent(2,0, 0.5*(derivs[2]+derivs[6]));
-          tens->SetComponent(2,1, 0.5*(derivs[5]+derivs[7]));
-          tens->SetComponent(2,2, derivs[8]);
-
-          outTensors->InsertTuple(cellId, tens->T);
-          }
-        else if (this->TensorMode == VTK_TENSOR_MODE_PASS_TENSORS)
+        double *d = derivs + 9*cellId;
+        double *t = tensors + 9*cellId;
+        for (int i=0; i < 3; i++)
           {
-          // do nothing.
-          }
-
-        if ( computeVorticity )
-          {
-          w[0] = derivs[7] - derivs[5];
-          w[1] = derivs[2] - derivs[6];
-          w[2] = derivs[3] - derivs[1];
-          outVorticity->SetTuple(cellId, w);
+          for (int j=0; j < 3; j++)
+            {
+            if ( this->TensorMode == VTK_TENSOR_MODE_COMPUTE_STRAIN && i != j )
+              {
+              t[i+3*j] = 0.5*(d[3*i+j]+d[3*j+i]);
+              }
+            else
+              {
+              t[i+3*j] = d[3*i+j];
+              }
+            }
           }
         }
-      }//for all cells
-
-    cell->Delete();
-    cellScalars->Delete();
-    cellVectors->Delete();
-    tens->Delete();
-    }//if something to compute
+      }
+    vectors->Delete();
+    gradients->Delete();
+    }
 
   // Pass appropriate data through to output
   outPD->PassData(pd);
@@ -285,5 +259,7 @@ void vtkCellDerivatives::PrintSelf(ostream& os, vtkIndent indent)
 
   os << indent << "Tensor Mode: " << this->GetTensorModeAsString()
      << endl;
+
+  os << indent << "Number Of Threads: " << this->NumberOfThreads << endl;
 }
 
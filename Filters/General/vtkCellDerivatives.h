@@ -24,7 +24,9 @@
 // Note that it is assumed that on input scalars and vector point data
 // is available, which are then used to generate cell vectors and tensors.
 // (The interpolation functions of the cells are used to compute the
-// derivatives which is why point data is required.)
+// derivatives which is why point data is required.) The derivatives are
+// computed by NumberOfThreads threads, along the edges of the pixels and
+// voxels of image data and rectilinear grids.
 
 // .SECTION Caveats
 // The computed derivatives are cell attribute data; you can convert them to
@@ -44,6 +46,8 @@
 #include "vtkFiltersGeneralModule.h" // For export macro
 #include "vtkDataSetAlgorithm.h"
 
+class vtkMultiThreader;
+
 #define VTK_VECTOR_MODE_PASS_VECTORS      0
 #define VTK_VECTOR_MODE_COMPUTE_GRADIENT  1
 #define VTK_VECTOR_MODE_COMPUTE_VORTICITY 2
@@ -94,13 +98,21 @@ public:
     {this->SetTensorMode(VTK_TENSOR_MODE_COMPUTE_STRAIN);};
   const char *GetTensorModeAsString();
 
+  // Description:
+  // Get/Set the number of threads computing the derivatives. It defaults to
+  // the number of threads of vtkMultiThreader.
+  vtkSetClampMacro(NumberOfThreads, int, 1, VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads, int);
+
 protected:
   vtkCellDerivatives();
-  ~vtkCellDerivatives() {};
+  ~vtkCellDerivatives();
   int RequestData(vtkInformation *, vtkInformationVector **, vtkInformationVector *);
 
   int VectorMode;
   int TensorMode;
+  int NumberOfThreads;
+  vtkMultiThreader *Threader;
 private:
   vtkCellDerivatives(const vtkCellDerivatives&);  // Not implemented.
   void operator=(const vtkCellDerivatives&);  // Not implemented.
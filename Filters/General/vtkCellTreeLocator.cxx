@@ -29,6 +29,8 @@
 #include "vtkPolyData.h"
 #include "vtkBoundingBox.h"
 #include "vtkPointData.h"
+#include "vtkMultiThreader.h"
+#include "vtkCriticalSection.h"
 
 vtkStandardNewMacro(vtkCellTreeLocator);
 
@@ -307,18 +309,133 @@ class vtkCellTreeBuilder
         }
       }
 
+    // A subtree left to split by one of the threads. Its nodes are
+    // numbered locally, its root being node 0.
+    struct Subtree
+      {
+      unsigned int Index;
+      float Min[3];
+      float Max[3];
+      std::vector<vtkCellTreeLocator::vtkCellTreeNode> Nodes;
+      };
+
+    struct ThreadData
+      {
+      vtkCellTreeBuilder *Builder;
+      vtkDataSet *DataSet;
+      double (*CellBounds)[6];
+      std::vector<float> Bounds; // min and max of the cells of each thread
+      vtkSimpleCriticalSection Lock;
+      size_t NextSubtree;
+      int NumberOfThreads;
+      };
+
+    // -------------------------------------------------------------------------
+
+    void GatherCells( vtkDataSet* ds, double (*cachedBounds)[6],
+      vtkIdType begin, vtkIdType end, float* min, float* max )
+      {
+      double cellBounds[6];
+      for( vtkIdType i=begin; i<end; ++i )
+        {
+        this->m_pc[i].Ind = i;
+
+        double *boundsPtr = cellBounds;
+        if (cachedBounds)
+          {
+          boundsPtr = cachedBounds[i];
+          }
+        else
+          {
+          ds->GetCellBounds(i, boundsPtr);
+          }
+
+        for( int d=0; d<3; ++d )
+          {
+          this->m_pc[i].Min[d] = boundsPtr[2*d+0];
+          this->m_pc[i].Max[d] = boundsPtr[2*d+1];
+
+          if( this->m_pc[i].Min[d] < min[d] )
+            {
+            min[d] = this->m_pc[i].Min[d];
+            }
+
+          if( this->m_pc[i].Max[d] > max[d] )  /// This can be m_pc[i].max[d] instead of min
+            {
+            max[d] = this->m_pc[i].Max[d];
+            }
+          }
+        }
+      }
+
+    static VTK_THREAD_RETURN_TYPE GatherCellsExecute( void *arg )
+      {
+      vtkMultiThreader::ThreadInfo *info =
+        static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+      ThreadData *td = static_cast<ThreadData *>(info->UserData);
+
+      const vtkIdType size = static_cast<vtkIdType>(td->Builder->m_pc.size());
+      vtkIdType begin = size * info->ThreadID / td->NumberOfThreads;
+      vtkIdType end = size * (info->ThreadID + 1) / td->NumberOfThreads;
+      float *bounds = &td->Bounds[6*info->ThreadID];
+      td->Builder->GatherCells( td->DataSet, td->CellBounds, begin, end,
+                                bounds, bounds+3 );
+
+      return VTK_THREAD_RETURN_VALUE;
+      }
+
+    // The subtrees cover disjoint ranges of m_pc, so that they can be split
+    // concurrently. The threads take the next subtree as they finish one.
+    static VTK_THREAD_RETURN_TYPE SplitSubtreesExecute( void *arg )
+      {
+      vtkMultiThreader::ThreadInfo *info =
+        static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+      ThreadData *td = static_cast<ThreadData *>(info->UserData);
+      vtkCellTreeBuilder *builder = td->Builder;
+
+      while( true )
+        {
+        td->Lock.Lock();
+        size_t next = td->NextSubtree++;
+        td->Lock.Unlock();
+        if( next >= builder->m_subtrees.size() )
+          {
+          break;
+          }
+        Subtree &st = builder->m_subtrees[next];
+        st.Nodes.push_back( builder->m_nodes[st.Index] );
+        builder->Split( st.Nodes, 0, st.Min, st.Max, -1 );
+        }
+
+      return VTK_THREAD_RETURN_VALUE;
+      }
+
     // -------------------------------------------------------------------------
 
-    void Split( unsigned int index, float min[3], float max[3] )
+    // Split the node and its children. Below the given number of levels
+    // (unless it is negative) the nodes still to be split are appended to
+    // m_subtrees instead.
+    void Split( std::vector<vtkCellTreeLocator::vtkCellTreeNode>& nodes,
+      unsigned int index, float min[3], float max[3], int levels )
       {
-      unsigned int start = this->m_nodes[index].Start();
-      unsigned int size  = this->m_nodes[index].Size();
+      unsigned int start = nodes[index].Start();
+      unsigned int size  = nodes[index].Size();
 
       if( size < this->m_leafsize )
         {
         return;
         }
 
+      if( levels == 0 )
+        {
+        Subtree st;
+        st.Index = index;
+        std::copy( min, min+3, st.Min );
+        std::copy( max, max+3, st.Max );
+        this->m_subtrees.push_back( st );
+        return;
+        }
+
       PerCell* begin = &(this->m_pc[start]);
       PerCell* end   = &(this->m_pc[0])+start + size;
       PerCell* mid = begin;
@@ -429,11 +546,11 @@ class vtkCellTreeBuilder
       child[0].MakeLeaf( begin - &(this->m_pc[0]), mid-begin );
       child[1].MakeLeaf( mid   - &(this->m_pc[0]), end-mid );
 
-      this->m_nodes[index].MakeNode( (int)m_nodes.size(), dim, clip );
-      this->m_nodes.insert( m_nodes.end(), child, child+2 );
+      nodes[index].MakeNode( (int)nodes.size(), dim, clip );
+      nodes.insert( nodes.end(), child, child+2 );
 
-      Split( this->m_nodes[index].GetLeftChildIndex(), lmin, lmax );
-      Split( this->m_nodes[index].GetRightChildIndex(), rmin, rmax );
+      Split( nodes, nodes[index].GetLeftChildIndex(), lmin, lmax, levels-1 );
+      Split( nodes, nodes[index].GetRightChildIndex(), rmin, rmax, levels-1 );
       }
 
   public:
@@ -442,6 +559,8 @@ class vtkCellTreeBuilder
       {
       this->m_buckets =  5;
       this->m_leafsize = 8;
+      this->m_threads = 1;
+      this->m_concurrent = false;
       }
 
     void Build( vtkCellTreeLocator *ctl, vtkCellTreeLocator::vtkCellTree& ct, vtkDataSet* ds )
@@ -451,7 +570,6 @@ class vtkCellTreeBuilder
         {
         vtkGenericWarningMacro("Too many cells.");
         }
-      double cellBounds[6];
       this->m_pc.resize(size);
 
       float min[3] =
@@ -468,36 +586,48 @@ class vtkCellTreeBuilder
         -std::numeric_limits<float>::max(),
         };
 
-      for( vtkIdType i=0; i<size; ++i )
+      int numThreads = this->m_threads;
+      if( numThreads > size )
         {
-        this->m_pc[i].Ind = i;
+        numThreads = static_cast<int>(size);
+        }
 
-        double *boundsPtr = cellBounds;
-        if (ctl->CellBounds)
+      vtkMultiThreader *threader = NULL;
+      ThreadData td;
+      td.Builder = this;
+      td.DataSet = ds;
+      td.CellBounds = ctl->CellBounds;
+      td.NextSubtree = 0;
+      if( numThreads > 1 )
+        {
+        threader = vtkMultiThreader::New();
+        }
+
+      if( threader && (this->m_concurrent || ctl->CellBounds) )
+        {
+        td.NumberOfThreads = numThreads;
+        td.Bounds.resize( 6*numThreads );
+        for( int t=0; t<numThreads; ++t )
           {
-          boundsPtr = ctl->CellBounds[i];
+          std::copy( min, min+3, &td.Bounds[6*t] );
+          std::copy( max, max+3, &td.Bounds[6*t+3] );
           }
-        else
+        threader->SetNumberOfThreads( numThreads );
+        threader->SetSingleMethod( GatherCellsExecute, &td );
+        threader->SingleMethodExecute();
+        for( int t=0; t<numThreads; ++t )
           {
-          ds->GetCellBounds(i, boundsPtr);
-          }
-
-        for( int d=0; d<3; ++d )
-          {
-          this->m_pc[i].Min[d] = boundsPtr[2*d+0];
-          this->m_pc[i].Max[d] = boundsPtr[2*d+1];
-
-          if( this->m_pc[i].Min[d] < min[d] )
+          for( int d=0; d<3; ++d )
             {
-            min[d] = this->m_pc[i].Min[d];
-            }
-
-          if( this->m_pc[i].Max[d] > max[d] )  /// This can be m_pc[i].max[d] instead of min
-            {
-            max[d] = this->m_pc[i].Max[d];
+            min[d] = std::min( min[d], td.Bounds[6*t+d] );
+            max[d] = std::max( max[d], td.Bounds[6*t+3+d] );
             }
           }
         }
+      else
+        {
+        this->GatherCells( ds, ctl->CellBounds, 0, size, min, max );
+        }
 
       ct.DataBBox[0] = min[0];
       ct.DataBBox[1] = max[0];
@@ -510,7 +640,48 @@ class vtkCellTreeBuilder
       root.MakeLeaf( 0, size );
       this->m_nodes.push_back( root );
 
-      Split( 0, min, max );
+      if( threader )
+        {
+        // Split the top levels, then the resulting subtrees in parallel.
+        // Each subtree is then appended to m_nodes, in order: the tree is
+        // the same whatever the number of threads.
+        int levels = 0;
+        while( (1 << levels) < 8*numThreads )
+          {
+          ++levels;
+          }
+        Split( this->m_nodes, 0, min, max, levels );
+
+        td.NumberOfThreads = numThreads;
+        threader->SetNumberOfThreads( numThreads );
+        threader->SetSingleMethod( SplitSubtreesExecute, &td );
+        threader->SingleMethodExecute();
+
+        for( size_t s=0; s<this->m_subtrees.size(); ++s )
+          {
+          Subtree &st = this->m_subtrees[s];
+          // local node 0 is the subtree root, local node i>0 is appended
+          unsigned int offset = static_cast<unsigned int>(this->m_nodes.size()) - 1;
+          for( size_t i=0; i<st.Nodes.size(); ++i )
+            {
+            vtkCellTreeLocator::vtkCellTreeNode &n = st.Nodes[i];
+            if( n.IsNode() )
+              {
+              n.SetChildren( n.GetLeftChildIndex() + offset );
+              }
+            }
+          this->m_nodes[st.Index] = st.Nodes[0];
+          this->m_nodes.insert( this->m_nodes.end(), st.Nodes.begin()+1,
+                                st.Nodes.end() );
+          std::vector<vtkCellTreeLocator::vtkCellTreeNode>().swap( st.Nodes );
+          }
+        this->m_subtrees.clear();
+        threader->Delete();
+        }
+      else
+        {
+        Split( this->m_nodes, 0, min, max, -1 );
+        }
 
       ct.Nodes.resize( this->m_nodes.size() );
       ct.Nodes[0] = this->m_nodes[0];
@@ -546,8 +717,11 @@ class vtkCellTreeBuilder
   public:
     unsigned int     m_buckets;
     unsigned int     m_leafsize;
+    int              m_threads;
+    bool             m_concurrent; // whether the dataset may be read by threads
     std::vector<PerCell>   m_pc;
     std::vector<vtkCellTreeLocator::vtkCellTreeNode>    m_nodes;
+    std::vector<Subtree>   m_subtrees;
 };
 
 //----------------------------------------------------------------------------
@@ -616,19 +790,118 @@ void vtkCellTreeLocator::BuildLocatorInternal()
     return;
     }
   //
+  int cached = this->ReadCacheFile();
   if (this->CacheCellBounds)
     {
     this->StoreCellBounds();
     }
   //
-  this->Tree = new vtkCellTree;
-  vtkCellTreeBuilder builder;
-  builder.m_leafsize = this->NumberOfCellsPerNode;
-  builder.m_buckets  = NumberOfBuckets;
-  builder.Build( this, *(Tree), this->DataSet );
+  if (!cached)
+    {
+    this->Tree = new vtkCellTree;
+    vtkCellTreeBuilder builder;
+    builder.m_leafsize = this->NumberOfCellsPerNode;
+    builder.m_buckets  = NumberOfBuckets;
+    builder.m_threads  = this->NumberOfThreads;
+    builder.m_concurrent = (this->PrepareConcurrentDataSetAccess() != 0);
+    builder.Build( this, *(Tree), this->DataSet );
+    this->WriteCacheFile();
+    }
   this->BuildTime.Modified();
 }
 
+//----------------------------------------------------------------------------
+// The nodes and leaves are plain arrays, written as they are in memory.
+int vtkCellTreeLocator::WriteSearchStructure(ostream &os)
+{
+  int params[2] = { this->NumberOfCellsPerNode, this->NumberOfBuckets };
+  vtkIdType sizes[2] = { static_cast<vtkIdType>(this->Tree->Nodes.size()),
+                         static_cast<vtkIdType>(this->Tree->Leaves.size()) };
+  int nodeSize = static_cast<int>(sizeof(vtkCellTreeNode));
+  vtkLocator::WriteCacheBlock(os, params, sizeof(params));
+  vtkLocator::WriteCacheBlock(os, &nodeSize, sizeof(int));
+  vtkLocator::WriteCacheBlock(os, this->Tree->DataBBox, 6*sizeof(float));
+  vtkLocator::WriteCacheBlock(os, sizes, sizeof(sizes));
+  if (sizes[0] > 0)
+    {
+    vtkLocator::WriteCacheBlock(os, &this->Tree->Nodes[0],
+                                sizes[0]*sizeof(vtkCellTreeNode));
+    }
+  if (sizes[1] > 0)
+    {
+    vtkLocator::WriteCacheBlock(os, &this->Tree->Leaves[0],
+                                sizes[1]*sizeof(unsigned int));
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkCellTreeLocator::ReadSearchStructure(istream &is)
+{
+  int params[2], nodeSize;
+  vtkIdType sizes[2];
+  float bbox[6];
+  if ( !vtkLocator::ReadCacheBlock(is, params, sizeof(params)) ||
+       params[0] != this->NumberOfCellsPerNode ||
+       params[1] != this->NumberOfBuckets ||
+       !vtkLocator::ReadCacheBlock(is, &nodeSize, sizeof(int)) ||
+       nodeSize != static_cast<int>(sizeof(vtkCellTreeNode)) ||
+       !vtkLocator::ReadCacheBlock(is, bbox, sizeof(bbox)) ||
+       !vtkLocator::ReadCacheBlock(is, sizes, sizeof(sizes)) ||
+       sizes[0] < 1 || sizes[1] != this->DataSet->GetNumberOfCells() )
+    {
+    return 0;
+    }
+
+  this->Tree = new vtkCellTree;
+  for (int i = 0; i < 6; i++)
+    {
+    this->Tree->DataBBox[i] = bbox[i];
+    }
+  this->Tree->Nodes.resize(sizes[0]);
+  this->Tree->Leaves.resize(sizes[1]);
+  if ( !vtkLocator::ReadCacheBlock(is, &this->Tree->Nodes[0],
+                                   sizes[0]*sizeof(vtkCellTreeNode)) )
+    {
+    return 0;
+    }
+  if ( sizes[1] > 0 &&
+       !vtkLocator::ReadCacheBlock(is, &this->Tree->Leaves[0],
+                                   sizes[1]*sizeof(unsigned int)) )
+    {
+    return 0;
+    }
+
+  // The traversals index the nodes and the leaves without checking them:
+  // the children of a node come after it, and the cells of a leaf are a
+  // range of valid cell ids
+  for (vtkIdType i = 0; i < sizes[1]; i++)
+    {
+    if (this->Tree->Leaves[i] >= static_cast<unsigned int>(sizes[1]))
+      {
+      return 0;
+      }
+    }
+  for (vtkIdType i = 0; i < sizes[0]; i++)
+    {
+    const vtkCellTreeNode &node = this->Tree->Nodes[i];
+    if (node.IsNode())
+      {
+      vtkIdType left = node.GetLeftChildIndex();
+      if (left <= i || left + 1 >= sizes[0])
+        {
+        return 0;
+        }
+      }
+    else if (!node.IsLeaf() ||
+             static_cast<vtkIdType>(node.Start()) + node.Size() > sizes[1])
+      {
+      return 0;
+      }
+    }
+  return 1;
+}
+
 void vtkCellTreeLocator::BuildLocator()
 {
   if (this->LazyEvaluation)
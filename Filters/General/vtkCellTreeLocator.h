@@ -191,6 +191,16 @@ protected:
      vtkCellTreeLocator();
     ~vtkCellTreeLocator();
 
+  // Description:
+  // FindCell() traverses the tree with a stack of its own.
+  virtual int IsFindCellThreadSafe() { return 1; }
+
+  // Description:
+  // Write/read the nodes and leaves of the tree to/from a cache file (see
+  // CacheFileName).
+  virtual int WriteSearchStructure(ostream &os);
+  virtual int ReadSearchStructure(istream &is);
+
    // Test ray against node BBox : clip t values to extremes
   bool RayMinMaxT(const double origin[3],
     const double dir[3],
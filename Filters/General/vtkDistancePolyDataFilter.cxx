@@ -16,11 +16,15 @@
 
 #include "vtkCellData.h"
 #include "vtkDoubleArray.h"
+#include "vtkGenericCell.h"
 #include "vtkImplicitPolyDataDistance.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkSmartPointer.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
 #include "vtkTriangle.h"
 
@@ -32,6 +36,7 @@ vtkDistancePolyDataFilter::vtkDistancePolyDataFilter() : vtkPolyDataAlgorithm()
   this->SignedDistance = 1;
   this->NegateDistance = 0;
   this->ComputeSecondDistance = 1;
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
 
   this->SetNumberOfInputPorts(2);
   this->SetNumberOfOutputPorts(2);
@@ -106,20 +111,18 @@ void vtkDistancePolyDataFilter::GetPolyDataDistance(vtkPolyData* mesh, vtkPolyDa
 
   vtkImplicitPolyDataDistance* imp = vtkImplicitPolyDataDistance::New();
   imp->SetInput( src );
+  imp->SetNumberOfThreads( this->NumberOfThreads );
 
   // Calculate distance from points.
-  int numPts = mesh->GetNumberOfPoints();
+  vtkIdType numPts = mesh->GetNumberOfPoints();
 
   vtkDoubleArray* pointArray = vtkDoubleArray::New();
   pointArray->SetName( "Distance" );
-  pointArray->SetNumberOfComponents( 1 );
-  pointArray->SetNumberOfTuples( numPts );
+  imp->EvaluatePoints( mesh->GetPoints(), pointArray );
 
   for (vtkIdType ptId = 0; ptId < numPts; ptId++)
     {
-    double pt[3];
-    mesh->GetPoint( ptId, pt );
-    double val = imp->EvaluateFunction( pt );
+    double val = pointArray->GetValue( ptId );
     double dist = SignedDistance ? (NegateDistance ? -val : val) : fabs(val);
     pointArray->SetValue( ptId, dist );
     }
@@ -129,23 +132,32 @@ void vtkDistancePolyDataFilter::GetPolyDataDistance(vtkPolyData* mesh, vtkPolyDa
   mesh->GetPointData()->SetActiveScalars( "Distance" );
 
   // Calculate distance from cell centers.
-  int numCells = mesh->GetNumberOfCells();
+  vtkIdType numCells = mesh->GetNumberOfCells();
 
-  vtkDoubleArray* cellArray = vtkDoubleArray::New();
-  cellArray->SetName( "Distance" );
-  cellArray->SetNumberOfComponents( 1 );
-  cellArray->SetNumberOfTuples( numCells );
+  vtkSmartPointer<vtkPoints> centers = vtkSmartPointer<vtkPoints>::New();
+  centers->SetDataTypeToDouble();
+  centers->SetNumberOfPoints( numCells );
+  vtkSmartPointer<vtkGenericCell> cell = vtkSmartPointer<vtkGenericCell>::New();
+  double weights[VTK_CELL_SIZE];
 
   for (vtkIdType cellId = 0; cellId < numCells; cellId++)
     {
-    vtkCell *cell = mesh->GetCell( cellId );
+    mesh->GetCell( cellId, cell );
     int subId;
-    double pcoords[3], x[3], weights[256];
+    double pcoords[3], x[3];
 
     cell->GetParametricCenter( pcoords );
     cell->EvaluateLocation( subId, pcoords, x, weights );
+    centers->SetPoint( cellId, x );
+    }
+
+  vtkDoubleArray* cellArray = vtkDoubleArray::New();
+  cellArray->SetName( "Distance" );
+  imp->EvaluatePoints( centers, cellArray );
 
-    double val = imp->EvaluateFunction( x );
+  for (vtkIdType cellId = 0; cellId < numCells; cellId++)
+    {
+    double val = cellArray->GetValue( cellId );
     double dist = SignedDistance ? (NegateDistance ? -val : val) : fabs(val);
     cellArray->SetValue( cellId, dist );
     }
@@ -195,4 +207,5 @@ void vtkDistancePolyDataFilter::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "SignedDistance: " << this->SignedDistance << "\n";
   os << indent << "NegateDistance: " << this->NegateDistance << "\n";
   os << indent << "ComputeSecondDistance: " << this->ComputeSecondDistance << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
 }
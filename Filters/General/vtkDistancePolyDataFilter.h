@@ -26,6 +26,9 @@
 // computed by calling SignedDistanceOff(). The signed distance field
 // may be negated by calling NegateDistanceOn();
 //
+// The distances of the points and of the cell centers are each evaluated
+// as a single batch, split over NumberOfThreads threads.
+//
 // This code was contributed in the VTK Journal paper:
 // "Boolean Operations on Surfaces in VTK Without External Libraries"
 // by Cory Quammen, Chris Weigle C., Russ Taylor
@@ -70,6 +73,12 @@ public:
   // additional distance scalar field.
   vtkPolyData* GetSecondDistanceOutput();
 
+  // Description:
+  // Set/Get the number of threads used to evaluate the distances.
+  // Defaults to the number of available processors.
+  vtkSetClampMacro(NumberOfThreads,int,1,VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads,int);
+
 protected:
   vtkDistancePolyDataFilter();
   ~vtkDistancePolyDataFilter();
@@ -86,6 +95,7 @@ private:
   int SignedDistance;
   int NegateDistance;
   int ComputeSecondDistance;
+  int NumberOfThreads;
 };
 
 #endif
@@ -28,7 +28,13 @@
 // 3*number of components of the input data array.  The ordering for the
 // output tuple will be {du/dx, du/dy, du/dz, dv/dx, dv/dy, dv/dz, dw/dx,
 // dw/dy, dw/dz} for an input array {u, v, w}. There are also the options
-// to additionally compute the vorticity and Q criterion of a vector field.
+// to additionally compute the vorticity, Q criterion and divergence of a
+// vector field, in the same pass as the gradient.
+//
+// Image data, rectilinear grids and structured grids use finite differences
+// along their axes. Other datasets use the derivatives of their cells. The
+// gradients are computed by NumberOfThreads threads, and are the same
+// whatever the number of threads.
 
 #ifndef __vtkGradientFilter_h
 #define __vtkGradientFilter_h
@@ -36,6 +42,8 @@
 #include "vtkFiltersGeneralModule.h" // For export macro
 #include "vtkDataSetAlgorithm.h"
 
+class vtkMultiThreader;
+
 class VTKFILTERSGENERAL_EXPORT vtkGradientFilter : public vtkDataSetAlgorithm
 {
 public:
@@ -72,6 +80,13 @@ public:
   vtkGetStringMacro(QCriterionArrayName);
   vtkSetStringMacro(QCriterionArrayName);
 
+  // Description:
+  // Get/Set the name of the divergence array to create. This is only
+  // used if ComputeDivergence is non-zero. If NULL (the
+  // default) then the output array will be named "Divergence".
+  vtkGetStringMacro(DivergenceArrayName);
+  vtkSetStringMacro(DivergenceArrayName);
+
  // Description:
   // When this flag is on (default is off), the gradient filter will provide a
   // less accurate (but close) algorithm that performs fewer derivative
@@ -101,6 +116,20 @@ public:
   vtkGetMacro(ComputeQCriterion, int);
   vtkBooleanMacro(ComputeQCriterion, int);
 
+  // Description:
+  // Add the divergence of the input array to the output, with the same
+  // type as the input array.  The input array must have 3 components in
+  // order to compute this.
+  vtkSetMacro(ComputeDivergence, int);
+  vtkGetMacro(ComputeDivergence, int);
+  vtkBooleanMacro(ComputeDivergence, int);
+
+  // Description:
+  // Get/Set the number of threads computing the gradients. It defaults to
+  // the number of threads of vtkMultiThreader.
+  vtkSetClampMacro(NumberOfThreads, int, 1, VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads, int);
+
 protected:
   vtkGradientFilter();
   ~vtkGradientFilter();
@@ -117,7 +146,8 @@ protected:
   // Returns non-zero if the operation was successful.
   virtual int ComputeUnstructuredGridGradient(
     vtkDataArray* Array, int fieldAssociation, vtkDataSet* input,
-    bool computeVorticity, bool computeQCriterion, vtkDataSet* output);
+    bool computeVorticity, bool computeQCriterion, bool computeDivergence,
+    vtkDataSet* output);
 
   // Description:
   // Compute the gradients for either a vtkImageData, vtkRectilinearGrid or
@@ -125,7 +155,7 @@ protected:
   // Returns non-zero if the operation was successful.
   virtual int ComputeRegularGridGradient(
     vtkDataArray* Array, int fieldAssociation, bool computeVorticity,
-    bool computeQCriterion, vtkDataSet* output);
+    bool computeQCriterion, bool computeDivergence, vtkDataSet* output);
 
   // Description:
   // If non-null then it contains the name of the outputted gradient array.
@@ -142,6 +172,11 @@ protected:
   // By derault it is "Q-criterion".
   char *QCriterionArrayName;
 
+  // Description:
+  // If non-null then it contains the name of the outputted divergence array.
+  // By default it is "Divergence".
+  char *DivergenceArrayName;
+
   // Description:
   // When this flag is on (default is off), the gradient filter will provide a
   // less accurate (but close) algorithm that performs fewer derivative
@@ -164,6 +199,15 @@ protected:
   // 3 components.  By default ComputeVorticity is off.
   int ComputeVorticity;
 
+  // Description:
+  // Flag to indicate that the divergence of the input vector is to
+  // be computed.  The input array to be processed must have
+  // 3 components.  By default ComputeDivergence is off.
+  int ComputeDivergence;
+
+  int NumberOfThreads;
+  vtkMultiThreader *Threader;
+
 private:
   vtkGradientFilter(const vtkGradientFilter &); // Not implemented
   void operator=(const vtkGradientFilter &);    // Not implemented
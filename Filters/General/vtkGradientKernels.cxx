@@ -0,0 +1,889 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    vtkGradientKernels.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkGradientKernels.h"
+
+#include "vtkCell.h"
+#include "vtkDataArray.h"
+#include "vtkDataObject.h"
+#include "vtkDoubleArray.h"
+#include "vtkGenericCell.h"
+#include "vtkIdList.h"
+#include "vtkImageData.h"
+#include "vtkMultiThreader.h"
+#include "vtkPolyData.h"
+#include "vtkRectilinearGrid.h"
+#include "vtkSmartPointer.h"
+#include "vtkStructuredGrid.h"
+#include "vtkUnstructuredGrid.h"
+
+#include <vector>
+
+// Inputs with fewer tuples per thread are processed by less threads
+#define VTK_GRADIENT_KERNELS_TUPLES_PER_THREAD 4096
+
+struct vtkGradientKernelsThreadStruct;
+typedef void (*vtkGradientKernelsMethod)(vtkGradientKernelsThreadStruct *,
+                                         vtkIdType, vtkIdType);
+
+struct vtkGradientKernelsThreadStruct
+{
+  vtkDataSet *DataSet;
+  int NumberOfComponents;
+  void *Array;
+  void *Gradients;
+  void *Vorticity;
+  void *QCriterion;
+  void *Divergence;
+
+  // The dimensions of the points of a structured grid, and of the points
+  // or cells whose gradients are computed
+  int PointDimensions[3];
+  int Dimensions[3];
+
+  // The coordinates along each axis of image data and rectilinear grids,
+  // or the coordinates of the points or cells of structured grids
+  std::vector<double> AxisCoordinates[3];
+  vtkDataArray *Coordinates;
+  double *CellCenters;
+
+  vtkIdType NumberOfTuples;
+  int NumberOfThreads;
+  vtkGradientKernelsMethod Execute;
+};
+
+namespace
+{
+//----------------------------------------------------------------------------
+// Store the gradients of a tuple, and the vorticity, Q-criterion and
+// divergence derived from them.
+template <class T>
+inline void vtkGradientKernelsStore(vtkGradientKernelsThreadStruct *str,
+                                    vtkIdType id, const double *g, T *)
+{
+  int numComp = 3*str->NumberOfComponents;
+  T *gradients = static_cast<T *>(str->Gradients) + id*numComp;
+  for (int i = 0; i < numComp; i++)
+    {
+    gradients[i] = static_cast<T>(g[i]);
+    }
+
+  if (str->Vorticity)
+    {
+    T *vorticity = static_cast<T *>(str->Vorticity) + 3*id;
+    vorticity[0] = static_cast<T>(g[7] - g[5]);
+    vorticity[1] = static_cast<T>(g[2] - g[6]);
+    vorticity[2] = static_cast<T>(g[3] - g[1]);
+    }
+  if (str->QCriterion)
+    {
+    double t1 = ( (g[7]-g[5])*(g[7]-g[5]) +
+                  (g[3]-g[1])*(g[3]-g[1]) +
+                  (g[2]-g[6])*(g[2]-g[6]) ) / 2;
+    double t2 = g[0]*g[0] + g[4]*g[4] + g[8]*g[8] + (
+      (g[3]+g[1])*(g[3]+g[1]) +
+      (g[6]+g[2])*(g[6]+g[2]) +
+      (g[7]+g[5])*(g[7]+g[5]) ) / 2;
+    static_cast<T *>(str->QCriterion)[id] = static_cast<T>((t1 - t2) / 2);
+    }
+  if (str->Divergence)
+    {
+    static_cast<T *>(str->Divergence)[id] =
+      static_cast<T>(g[0] + g[4] + g[8]);
+    }
+}
+
+//----------------------------------------------------------------------------
+// Finite differences at the points or cells of image data and rectilinear
+// grids, whose axes are orthogonal: the derivative along an axis only
+// depends on the values and coordinates along that axis.
+template <class T>
+void vtkGradientKernelsSeparable(vtkGradientKernelsThreadStruct *str,
+                                 vtkIdType begin, vtkIdType end)
+{
+  const T *array = static_cast<const T *>(str->Array);
+  int numComp = str->NumberOfComponents;
+  const int *dims = str->Dimensions;
+  vtkIdType strides[3] = { 1, dims[0],
+                           static_cast<vtkIdType>(dims[0])*dims[1] };
+  std::vector<double> g(3*numComp);
+
+  for (vtkIdType id = begin; id < end; id++)
+    {
+    int ijk[3];
+    ijk[0] = static_cast<int>(id % dims[0]);
+    ijk[1] = static_cast<int>((id / dims[0]) % dims[1]);
+    ijk[2] = static_cast<int>(id / strides[2]);
+
+    for (int axis = 0; axis < 3; axis++)
+      {
+      int n = ijk[axis];
+      int lo = (n > 0 ? n-1 : n);
+      int hi = (n < dims[axis]-1 ? n+1 : n);
+      double dx = 0.0;
+      if (hi != lo)
+        {
+        dx = str->AxisCoordinates[axis][hi] - str->AxisCoordinates[axis][lo];
+        }
+      if (dx == 0.0)
+        {
+        // 2D in this direction, or a degenerate grid
+        for (int c = 0; c < numComp; c++)
+          {
+          g[3*c+axis] = 0.0;
+          }
+        continue;
+        }
+      const T *plus = array + (id + (hi-n)*strides[axis])*numComp;
+      const T *minus = array + (id + (lo-n)*strides[axis])*numComp;
+      for (int c = 0; c < numComp; c++)
+        {
+        g[3*c+axis] = (static_cast<double>(plus[c]) -
+                       static_cast<double>(minus[c])) / dx;
+        }
+      }
+    vtkGradientKernelsStore(str, id, &g[0], static_cast<T *>(0));
+    }
+}
+
+//----------------------------------------------------------------------------
+// Finite differences at the points or cells of structured grids, through
+// the metrics of their curvilinear coordinates.
+template <class T>
+void vtkGradientKernelsCurvilinear(vtkGradientKernelsThreadStruct *str,
+                                   vtkIdType begin, vtkIdType end)
+{
+  const T *array = static_cast<const T *>(str->Array);
+  int numComp = str->NumberOfComponents;
+  const int *dims = str->Dimensions;
+  vtkIdType strides[3] = { 1, dims[0],
+                           static_cast<vtkIdType>(dims[0])*dims[1] };
+  std::vector<double> g(3*numComp);
+  // the derivatives of the coordinates and the values along xi, eta, zeta
+  double dxdxi[3][3];
+  std::vector<double> dValues(3*numComp);
+
+  for (vtkIdType id = begin; id < end; id++)
+    {
+    int ijk[3];
+    ijk[0] = static_cast<int>(id % dims[0]);
+    ijk[1] = static_cast<int>((id / dims[0]) % dims[1]);
+    ijk[2] = static_cast<int>(id / strides[2]);
+
+    for (int axis = 0; axis < 3; axis++)
+      {
+      if (dims[axis] == 1) // 2D in this direction
+        {
+        dxdxi[axis][0] = dxdxi[axis][1] = dxdxi[axis][2] = 0.0;
+        dxdxi[axis][axis] = 1.0;
+        for (int c = 0; c < numComp; c++)
+          {
+          dValues[3*c+axis] = 0.0;
+          }
+        continue;
+        }
+      int n = ijk[axis];
+      int lo = (n > 0 ? n-1 : n);
+      int hi = (n < dims[axis]-1 ? n+1 : n);
+      double factor = (hi - lo == 2 ? 0.5 : 1.0);
+      vtkIdType plusId = id + (hi-n)*strides[axis];
+      vtkIdType minusId = id + (lo-n)*strides[axis];
+      double xp[3], xm[3];
+      if (str->CellCenters)
+        {
+        for (int i = 0; i < 3; i++)
+          {
+          xp[i] = str->CellCenters[3*plusId+i];
+          xm[i] = str->CellCenters[3*minusId+i];
+          }
+        }
+      else
+        {
+        str->Coordinates->GetTuple(plusId, xp);
+        str->Coordinates->GetTuple(minusId, xm);
+        }
+      for (int i = 0; i < 3; i++)
+        {
+        dxdxi[axis][i] = factor * (xp[i] - xm[i]);
+        }
+      const T *plus = array + plusId*numComp;
+      const T *minus = array + minusId*numComp;
+      for (int c = 0; c < numComp; c++)
+        {
+        dValues[3*c+axis] = factor * (static_cast<double>(plus[c]) -
+                                      static_cast<double>(minus[c]));
+        }
+      }
+
+    double xxi = dxdxi[0][0], yxi = dxdxi[0][1], zxi = dxdxi[0][2];
+    double xeta = dxdxi[1][0], yeta = dxdxi[1][1], zeta = dxdxi[1][2];
+    double xzeta = dxdxi[2][0], yzeta = dxdxi[2][1], zzeta = dxdxi[2][2];
+
+    // Now calculate the Jacobian.  Grids occasionally have
+    // singularities, or points where the Jacobian is infinite (the
+    // inverse is zero).  For these cases, we'll set the Jacobian to
+    // zero, which will result in a zero derivative.
+    double aj =  xxi*yeta*zzeta+yxi*zeta*xzeta+zxi*xeta*yzeta
+      -zxi*yeta*xzeta-yxi*xeta*zzeta-xxi*zeta*yzeta;
+    if (aj != 0.0)
+      {
+      aj = 1. / aj;
+      }
+
+    //  Xi metrics.
+    double xix  =  aj*(yeta*zzeta-zeta*yzeta);
+    double xiy  = -aj*(xeta*zzeta-zeta*xzeta);
+    double xiz  =  aj*(xeta*yzeta-yeta*xzeta);
+
+    //  Eta metrics.
+    double etax = -aj*(yxi*zzeta-zxi*yzeta);
+    double etay =  aj*(xxi*zzeta-zxi*xzeta);
+    double etaz = -aj*(xxi*yzeta-yxi*xzeta);
+
+    //  Zeta metrics.
+    double zetax=  aj*(yxi*zeta-zxi*yeta);
+    double zetay= -aj*(xxi*zeta-zxi*xeta);
+    double zetaz=  aj*(xxi*yeta-yxi*xeta);
+
+    for (int c = 0; c < numComp; c++)
+      {
+      const double *d = &dValues[3*c];
+      g[3*c]   = xix*d[0] + etax*d[1] + zetax*d[2];
+      g[3*c+1] = xiy*d[0] + etay*d[1] + zetay*d[2];
+      g[3*c+2] = xiz*d[0] + etaz*d[1] + zetaz*d[2];
+      }
+    vtkGradientKernelsStore(str, id, &g[0], static_cast<T *>(0));
+    }
+}
+
+//----------------------------------------------------------------------------
+// The centers of the cells of a structured grid, as the averages of their
+// corners (the parametric centers of their hexahedra, quads or lines).
+void vtkGradientKernelsCellCenters(vtkGradientKernelsThreadStruct *str,
+                                   vtkIdType begin, vtkIdType end)
+{
+  const int *dims = str->Dimensions;
+  const int *pdims = str->PointDimensions;
+  vtkIdType pointStrides[3] = { 1, pdims[0],
+                                static_cast<vtkIdType>(pdims[0])*pdims[1] };
+  int numCorners[3];
+  for (int axis = 0; axis < 3; axis++)
+    {
+    numCorners[axis] = (pdims[axis] > 1 ? 2 : 1);
+    }
+  double weight = 1.0 / (numCorners[0]*numCorners[1]*numCorners[2]);
+
+  for (vtkIdType id = begin; id < end; id++)
+    {
+    vtkIdType i = id % dims[0];
+    vtkIdType j = (id / dims[0]) % dims[1];
+    vtkIdType k = id / (static_cast<vtkIdType>(dims[0])*dims[1]);
+    vtkIdType ptId = i + j*pointStrides[1] + k*pointStrides[2];
+
+    double center[3] = { 0.0, 0.0, 0.0 }, x[3];
+    for (int kk = 0; kk < numCorners[2]; kk++)
+      {
+      for (int jj = 0; jj < numCorners[1]; jj++)
+        {
+        for (int ii = 0; ii < numCorners[0]; ii++)
+          {
+          str->Coordinates->GetTuple(
+            ptId + ii + jj*pointStrides[1] + kk*pointStrides[2], x);
+          center[0] += x[0];
+          center[1] += x[1];
+          center[2] += x[2];
+          }
+        }
+      }
+    for (int c = 0; c < 3; c++)
+      {
+      str->CellCenters[3*id+c] = center[c] * weight;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// The derivatives at the centers of the pixels and voxels of image data and
+// rectilinear grids, as the averages of the differences along their edges.
+// This gives the derivatives of their interpolation functions.
+template <class T>
+void vtkGradientKernelsRegularCells(vtkGradientKernelsThreadStruct *str,
+                                    vtkIdType begin, vtkIdType end)
+{
+  const T *array = static_cast<const T *>(str->Array);
+  int numComp = str->NumberOfComponents;
+  const int *dims = str->Dimensions;
+  const int *pdims = str->PointDimensions;
+  vtkIdType pointStrides[3] = { 1, pdims[0],
+                                static_cast<vtkIdType>(pdims[0])*pdims[1] };
+  int numCorners[3], numEdges = 1;
+  for (int axis = 0; axis < 3; axis++)
+    {
+    numCorners[axis] = (pdims[axis] > 1 ? 2 : 1);
+    numEdges *= numCorners[axis];
+    }
+  numEdges /= 2;
+  std::vector<double> g(3*numComp);
+
+  for (vtkIdType id = begin; id < end; id++)
+    {
+    int ijk[3];
+    ijk[0] = static_cast<int>(id % dims[0]);
+    ijk[1] = static_cast<int>((id / dims[0]) % dims[1]);
+    ijk[2] = static_cast<int>(id / (static_cast<vtkIdType>(dims[0])*dims[1]));
+    vtkIdType ptId = ijk[0] + ijk[1]*pointStrides[1] + ijk[2]*pointStrides[2];
+
+    for (int axis = 0; axis < 3; axis++)
+      {
+      for (int c = 0; c < numComp; c++)
+        {
+        g[3*c+axis] = 0.0;
+        }
+      if (numCorners[axis] == 1)
+        {
+        continue;
+        }
+      int n = ijk[axis];
+      double dx = str->AxisCoordinates[axis][n+1] -
+        str->AxisCoordinates[axis][n];
+      if (dx == 0.0)
+        {
+        continue;
+        }
+      // the edges along this axis start at the corners where it is 0
+      int a1 = (axis+1)%3, a2 = (axis+2)%3;
+      for (int o2 = 0; o2 < numCorners[a2]; o2++)
+        {
+        for (int o1 = 0; o1 < numCorners[a1]; o1++)
+          {
+          vtkIdType minusId = ptId + o1*pointStrides[a1] + o2*pointStrides[a2];
+          const T *minus = array + minusId*numComp;
+          const T *plus = array + (minusId + pointStrides[axis])*numComp;
+          for (int c = 0; c < numComp; c++)
+            {
+            g[3*c+axis] += static_cast<double>(plus[c]) -
+              static_cast<double>(minus[c]);
+            }
+          }
+        }
+      for (int c = 0; c < numComp; c++)
+        {
+        g[3*c+axis] /= numEdges*dx;
+        }
+      }
+    vtkGradientKernelsStore(str, id, &g[0], static_cast<T *>(0));
+    }
+}
+
+//----------------------------------------------------------------------------
+// The derivatives at the parametric centers of any cells.
+template <class T>
+void vtkGradientKernelsCells(vtkGradientKernelsThreadStruct *str,
+                             vtkIdType begin, vtkIdType end)
+{
+  const T *array = static_cast<const T *>(str->Array);
+  int numComp = str->NumberOfComponents;
+  vtkGenericCell *cell = vtkGenericCell::New();
+  std::vector<double> values(8*numComp);
+  std::vector<double> g(3*numComp);
+
+  for (vtkIdType id = begin; id < end; id++)
+    {
+    str->DataSet->GetCell(id, cell);
+    for (int i = 0; i < 3*numComp; i++)
+      {
+      g[i] = 0.0;
+      }
+    int numPts = cell->GetNumberOfPoints();
+    if (numPts > 0)
+      {
+      double pcoords[3];
+      int subId = cell->GetParametricCenter(pcoords);
+      if (static_cast<size_t>(numPts*numComp) > values.size())
+        {
+        values.resize(numPts*numComp);
+        }
+      for (int p = 0; p < numPts; p++)
+        {
+        const T *tuple = array + cell->GetPointId(p)*numComp;
+        for (int c = 0; c < numComp; c++)
+          {
+          values[p*numComp+c] = static_cast<double>(tuple[c]);
+          }
+        }
+      cell->Derivatives(subId, pcoords, &values[0], numComp, &g[0]);
+      }
+    vtkGradientKernelsStore(str, id, &g[0], static_cast<T *>(0));
+    }
+
+  cell->Delete();
+}
+
+//----------------------------------------------------------------------------
+// Find the parametric coordinates of a point in a cell using it.
+int vtkGradientKernelsCellParametricData(
+  vtkIdType pointId, double pointCoord[3], vtkCell *cell, int &subId,
+  double parametricCoord[3], std::vector<double> &weights)
+{
+  // Watch out for degenerate cells.  They make the derivative calculation
+  // fail.
+  vtkIdList *pointIds = cell->GetPointIds();
+  int timesPointRegistered = 0;
+  for (int i = 0; i < pointIds->GetNumberOfIds(); i++)
+    {
+    if (pointId == pointIds->GetId(i))
+      {
+      timesPointRegistered++;
+      }
+    }
+  if (timesPointRegistered != 1)
+    {
+    // The cell should have the point exactly once.  Not good.
+    return 0;
+    }
+
+  double dummy;
+  size_t numPts = static_cast<size_t>(cell->GetNumberOfPoints());
+  if (numPts > weights.size())
+    {
+    weights.resize(numPts);
+    }
+  // Get parametric position of point.
+  cell->EvaluatePosition(pointCoord, NULL, subId, parametricCoord,
+                         dummy, &weights[0]);
+
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+// The sum of the derivatives at the points of the cells using them, divided
+// by the number of these cells.
+template <class T>
+void vtkGradientKernelsPoints(vtkGradientKernelsThreadStruct *str,
+                              vtkIdType begin, vtkIdType end)
+{
+  const T *array = static_cast<const T *>(str->Array);
+  int numComp = str->NumberOfComponents;
+  vtkGenericCell *cell = vtkGenericCell::New();
+  vtkIdList *cellIds = vtkIdList::New();
+  std::vector<double> values(8*numComp), weights(8);
+  std::vector<double> g(3*numComp), derivs(3*numComp);
+
+  for (vtkIdType id = begin; id < end; id++)
+    {
+    double x[3];
+    str->DataSet->GetPoint(id, x);
+    // Get all cells touching this point.
+    str->DataSet->GetPointCells(id, cellIds);
+    vtkIdType numCells = cellIds->GetNumberOfIds();
+    for (int i = 0; i < 3*numComp; i++)
+      {
+      g[i] = 0.0;
+      }
+
+    for (vtkIdType n = 0; n < numCells; n++)
+      {
+      str->DataSet->GetCell(cellIds->GetId(n), cell);
+      int subId;
+      double pcoords[3];
+      if (!vtkGradientKernelsCellParametricData(id, x, cell, subId, pcoords,
+                                                weights))
+        {
+        continue;
+        }
+      int numPts = cell->GetNumberOfPoints();
+      if (static_cast<size_t>(numPts*numComp) > values.size())
+        {
+        values.resize(numPts*numComp);
+        }
+      for (int p = 0; p < numPts; p++)
+        {
+        const T *tuple = array + cell->GetPointId(p)*numComp;
+        for (int c = 0; c < numComp; c++)
+          {
+          values[p*numComp+c] = static_cast<double>(tuple[c]);
+          }
+        }
+      // Get derivative of cell at point.
+      cell->Derivatives(subId, pcoords, &values[0], numComp, &derivs[0]);
+      for (int i = 0; i < 3*numComp; i++)
+        {
+        g[i] += derivs[i];
+        }
+      }
+
+    if (numCells > 0)
+      {
+      for (int i = 0; i < 3*numComp; i++)
+        {
+        g[i] /= numCells;
+        }
+      }
+    vtkGradientKernelsStore(str, id, &g[0], static_cast<T *>(0));
+    }
+
+  cellIds->Delete();
+  cell->Delete();
+}
+
+//----------------------------------------------------------------------------
+// Check the arrays, and point the thread structure to them. The outputs
+// must have the type of the input, and the vorticity, Q-criterion and
+// divergence need 3 components.
+int vtkGradientKernelsSetArrays(vtkGradientKernelsThreadStruct *str,
+                                vtkDataArray *array, vtkDataArray *gradients,
+                                vtkDataArray *vorticity,
+                                vtkDataArray *qCriterion,
+                                vtkDataArray *divergence,
+                                vtkIdType numTuples)
+{
+  int numComp = array->GetNumberOfComponents();
+  if (numComp < 1 ||
+      gradients->GetDataType() != array->GetDataType() ||
+      gradients->GetNumberOfComponents() != 3*numComp ||
+      gradients->GetNumberOfTuples() < numTuples)
+    {
+    return 0;
+    }
+  vtkDataArray *derived[3] = { vorticity, qCriterion, divergence };
+  void **pointers[3] = { &str->Vorticity, &str->QCriterion,
+                         &str->Divergence };
+  int numDerivedComp[3] = { 3, 1, 1 };
+  for (int i = 0; i < 3; i++)
+    {
+    *pointers[i] = NULL;
+    if (!derived[i])
+      {
+      continue;
+      }
+    if (numComp != 3 ||
+        derived[i]->GetDataType() != array->GetDataType() ||
+        derived[i]->GetNumberOfComponents() != numDerivedComp[i] ||
+        derived[i]->GetNumberOfTuples() < numTuples)
+      {
+      return 0;
+      }
+    *pointers[i] = derived[i]->GetVoidPointer(0);
+    }
+  str->NumberOfComponents = numComp;
+  str->Array = array->GetVoidPointer(0);
+  str->Gradients = gradients->GetVoidPointer(0);
+  str->NumberOfTuples = numTuples;
+  str->Coordinates = NULL;
+  str->CellCenters = NULL;
+  return 1;
+}
+
+} // end anonymous namespace
+
+//----------------------------------------------------------------------------
+// Each thread computes a contiguous range of tuples.
+static VTK_THREAD_RETURN_TYPE vtkGradientKernelsThreadedExecute(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkGradientKernelsThreadStruct *str =
+    static_cast<vtkGradientKernelsThreadStruct *>(info->UserData);
+
+  vtkIdType begin = str->NumberOfTuples * info->ThreadID /
+    str->NumberOfThreads;
+  vtkIdType end = str->NumberOfTuples * (info->ThreadID + 1) /
+    str->NumberOfThreads;
+  str->Execute(str, begin, end);
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+static void vtkGradientKernelsExecute(vtkGradientKernelsThreadStruct *str,
+                                      vtkMultiThreader *threader,
+                                      int numThreads)
+{
+  vtkIdType maxThreads =
+    str->NumberOfTuples / VTK_GRADIENT_KERNELS_TUPLES_PER_THREAD + 1;
+  if (numThreads > maxThreads)
+    {
+    numThreads = static_cast<int>(maxThreads);
+    }
+  if (!threader || numThreads <= 1)
+    {
+    str->NumberOfThreads = 1;
+    str->Execute(str, 0, str->NumberOfTuples);
+    return;
+    }
+  str->NumberOfThreads = numThreads;
+  threader->SetNumberOfThreads(numThreads);
+  threader->SetSingleMethod(vtkGradientKernelsThreadedExecute, str);
+  threader->SingleMethodExecute();
+}
+
+//----------------------------------------------------------------------------
+// The coordinates of the points or cell centers along an axis of image data
+static void vtkGradientKernelsImageAxis(vtkImageData *image, int axis,
+                                        int numEntities, double shift,
+                                        std::vector<double> &coordinates)
+{
+  double *origin = image->GetOrigin();
+  double *spacing = image->GetSpacing();
+  int *extent = image->GetExtent();
+  coordinates.resize(numEntities);
+  for (int n = 0; n < numEntities; n++)
+    {
+    coordinates[n] = origin[axis] + spacing[axis]*(extent[2*axis] + n + shift);
+    }
+}
+
+//----------------------------------------------------------------------------
+// The coordinates of the points or cell centers along an axis of a
+// rectilinear grid
+static void vtkGradientKernelsRectilinearAxis(vtkRectilinearGrid *grid,
+                                              int axis, bool cells,
+                                              int numEntities,
+                                              std::vector<double> &coordinates)
+{
+  vtkDataArray *axisCoordinates = (axis == 0 ? grid->GetXCoordinates() :
+                                   axis == 1 ? grid->GetYCoordinates() :
+                                   grid->GetZCoordinates());
+  coordinates.resize(numEntities);
+  for (int n = 0; n < numEntities; n++)
+    {
+    coordinates[n] = axisCoordinates->GetComponent(n, 0);
+    if (cells && grid->GetDimensions()[axis] > 1)
+      {
+      coordinates[n] = 0.5 * (coordinates[n] +
+                              axisCoordinates->GetComponent(n+1, 0));
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkGradientKernels::ComputeStructuredGradients(
+  vtkDataSet *grid, vtkDataArray *array, int fieldAssociation,
+  vtkDataArray *gradients, vtkDataArray *vorticity, vtkDataArray *qCriterion,
+  vtkDataArray *divergence, vtkMultiThreader *threader, int numThreads)
+{
+  vtkImageData *image = vtkImageData::SafeDownCast(grid);
+  vtkRectilinearGrid *rectilinear = vtkRectilinearGrid::SafeDownCast(grid);
+  vtkStructuredGrid *structured = vtkStructuredGrid::SafeDownCast(grid);
+  if (!image && !rectilinear && !structured)
+    {
+    return 0;
+    }
+
+  vtkGradientKernelsThreadStruct str;
+  str.DataSet = grid;
+  int *pdims = (image ? image->GetDimensions() :
+                rectilinear ? rectilinear->GetDimensions() :
+                structured->GetDimensions());
+  bool cells = (fieldAssociation == vtkDataObject::FIELD_ASSOCIATION_CELLS);
+  vtkIdType numTuples = 1;
+  for (int axis = 0; axis < 3; axis++)
+    {
+    str.PointDimensions[axis] = pdims[axis];
+    // the cells of a grid of a single point along an axis still have one
+    // layer along it
+    str.Dimensions[axis] = pdims[axis];
+    if (cells && pdims[axis] > 1)
+      {
+      str.Dimensions[axis]--;
+      }
+    numTuples *= str.Dimensions[axis];
+    }
+  if (pdims[0] < 1 || pdims[1] < 1 || pdims[2] < 1)
+    {
+    numTuples = 0;
+    }
+  if (numTuples != array->GetNumberOfTuples() ||
+      !vtkGradientKernelsSetArrays(&str, array, gradients, vorticity,
+                                   qCriterion, divergence, numTuples))
+    {
+    return 0;
+    }
+  if (numTuples == 0)
+    {
+    return 1;
+    }
+
+  vtkSmartPointer<vtkDoubleArray> cellCenters;
+  if (structured)
+    {
+    str.Coordinates = structured->GetPoints()->GetData();
+    if (cells)
+      {
+      cellCenters = vtkSmartPointer<vtkDoubleArray>::New();
+      cellCenters->SetNumberOfComponents(3);
+      cellCenters->SetNumberOfTuples(numTuples);
+      str.CellCenters = cellCenters->GetPointer(0);
+      str.Execute = vtkGradientKernelsCellCenters;
+      vtkGradientKernelsExecute(&str, threader, numThreads);
+      }
+    switch (array->GetDataType())
+      {
+      vtkTemplateMacro(str.Execute = &vtkGradientKernelsCurvilinear<VTK_TT>);
+      default:
+        return 0;
+      }
+    }
+  else
+    {
+    for (int axis = 0; axis < 3; axis++)
+      {
+      if (image)
+        {
+        vtkGradientKernelsImageAxis(image, axis, str.Dimensions[axis],
+                                    (cells && pdims[axis] > 1 ? 0.5 : 0.0),
+                                    str.AxisCoordinates[axis]);
+        }
+      else
+        {
+        vtkGradientKernelsRectilinearAxis(rectilinear, axis, cells,
+                                          str.Dimensions[axis],
+                                          str.AxisCoordinates[axis]);
+        }
+      }
+    switch (array->GetDataType())
+      {
+      vtkTemplateMacro(str.Execute = &vtkGradientKernelsSeparable<VTK_TT>);
+      default:
+        return 0;
+      }
+    }
+
+  vtkGradientKernelsExecute(&str, threader, numThreads);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkGradientKernels::ComputeCellGradients(
+  vtkDataSet *input, vtkDataArray *array, vtkDataArray *gradients,
+  vtkDataArray *vorticity, vtkDataArray *qCriterion, vtkDataArray *divergence,
+  vtkMultiThreader *threader, int numThreads)
+{
+  vtkGradientKernelsThreadStruct str;
+  str.DataSet = input;
+  vtkIdType numCells = input->GetNumberOfCells();
+  if (array->GetNumberOfTuples() != input->GetNumberOfPoints() ||
+      !vtkGradientKernelsSetArrays(&str, array, gradients, vorticity,
+                                   qCriterion, divergence, numCells))
+    {
+    return 0;
+    }
+  if (numCells == 0)
+    {
+    return 1;
+    }
+
+  vtkImageData *image = vtkImageData::SafeDownCast(input);
+  vtkRectilinearGrid *rectilinear = vtkRectilinearGrid::SafeDownCast(input);
+  if (image || rectilinear)
+    {
+    // pixels and voxels along the axes
+    int *pdims = (image ? image->GetDimensions() :
+                  rectilinear->GetDimensions());
+    for (int axis = 0; axis < 3; axis++)
+      {
+      str.PointDimensions[axis] = pdims[axis];
+      str.Dimensions[axis] = (pdims[axis] > 1 ? pdims[axis]-1 : 1);
+      if (image)
+        {
+        vtkGradientKernelsImageAxis(image, axis, pdims[axis], 0.0,
+                                    str.AxisCoordinates[axis]);
+        }
+      else
+        {
+        vtkGradientKernelsRectilinearAxis(rectilinear, axis, false,
+                                          pdims[axis],
+                                          str.AxisCoordinates[axis]);
+        }
+      }
+    switch (array->GetDataType())
+      {
+      vtkTemplateMacro(str.Execute = &vtkGradientKernelsRegularCells<VTK_TT>);
+      default:
+        return 0;
+      }
+    }
+  else
+    {
+    switch (array->GetDataType())
+      {
+      vtkTemplateMacro(str.Execute = &vtkGradientKernelsCells<VTK_TT>);
+      default:
+        return 0;
+      }
+    // Only the cells of these datasets can be read from several threads,
+    // once they are built.
+    if (vtkUnstructuredGrid::SafeDownCast(input) ||
+        vtkPolyData::SafeDownCast(input))
+      {
+      vtkGenericCell *cell = vtkGenericCell::New();
+      input->GetCell(0, cell);
+      cell->Delete();
+      }
+    else
+      {
+      numThreads = 1;
+      }
+    }
+
+  vtkGradientKernelsExecute(&str, threader, numThreads);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkGradientKernels::ComputePointGradients(
+  vtkDataSet *input, vtkDataArray *array, vtkDataArray *gradients,
+  vtkDataArray *vorticity, vtkDataArray *qCriterion, vtkDataArray *divergence,
+  vtkMultiThreader *threader, int numThreads)
+{
+  vtkGradientKernelsThreadStruct str;
+  str.DataSet = input;
+  vtkIdType numPts = input->GetNumberOfPoints();
+  if (array->GetNumberOfTuples() != numPts ||
+      !vtkGradientKernelsSetArrays(&str, array, gradients, vorticity,
+                                   qCriterion, divergence, numPts))
+    {
+    return 0;
+    }
+  if (numPts == 0)
+    {
+    return 1;
+    }
+  switch (array->GetDataType())
+    {
+    vtkTemplateMacro(str.Execute = &vtkGradientKernelsPoints<VTK_TT>);
+    default:
+      return 0;
+    }
+
+  // Only the cells and links of these datasets can be read from several
+  // threads, once they are built.
+  if ((vtkUnstructuredGrid::SafeDownCast(input) ||
+       vtkPolyData::SafeDownCast(input)) && input->GetNumberOfCells() > 0)
+    {
+    vtkGenericCell *cell = vtkGenericCell::New();
+    vtkIdList *cellIds = vtkIdList::New();
+    input->GetCell(0, cell);
+    input->GetPointCells(0, cellIds);
+    cellIds->Delete();
+    cell->Delete();
+    }
+  else
+    {
+    numThreads = 1;
+    }
+
+  vtkGradientKernelsExecute(&str, threader, numThreads);
+  return 1;
+}
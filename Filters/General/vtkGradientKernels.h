@@ -0,0 +1,79 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    vtkGradientKernels.h
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// .NAME vtkGradientKernels - gradient kernels shared by the gradient filters
+// .SECTION Description
+// vtkGradientKernels is a small utility class used by vtkGradientFilter and
+// vtkCellDerivatives. It computes the gradients of a point or cell array,
+// and in the same pass the vorticity, Q-criterion and divergence of a three
+// component array. The tuples are split in contiguous ranges over the
+// threads of a vtkMultiThreader, and every tuple is computed by one thread
+// in the same way whatever the number of threads.
+//
+// Structured inputs use finite differences, central inside the grid and one
+// sided on its boundary: image data and rectilinear grids through the
+// coordinates along each axis, structured grids through the metrics of their
+// curvilinear coordinates. The derivatives at the center of the cells of
+// image data and rectilinear grids are the averages of the differences
+// along their edges. Other inputs use the interpolation functions of their
+// cells.
+//
+// The output arrays must have the type of the input array. The gradients
+// have 3 components per input component, ordered {du/dx, du/dy, du/dz,
+// dv/dx, ...}; the vorticity has 3 components, the Q-criterion and the
+// divergence 1, and they are only computed when they are not NULL.
+// .SECTION See Also
+// vtkGradientFilter vtkCellDerivatives
+
+#ifndef __vtkGradientKernels_h
+#define __vtkGradientKernels_h
+
+class vtkDataArray;
+class vtkDataSet;
+class vtkMultiThreader;
+
+class vtkGradientKernels
+{
+public:
+  // Description:
+  // Compute the gradients of a point or cell array (given by
+  // fieldAssociation) of a vtkImageData, vtkRectilinearGrid or
+  // vtkStructuredGrid with finite differences. Returns 0 if the grid or the
+  // arrays are not supported.
+  static int ComputeStructuredGradients(
+    vtkDataSet *grid, vtkDataArray *array, int fieldAssociation,
+    vtkDataArray *gradients, vtkDataArray *vorticity,
+    vtkDataArray *qCriterion, vtkDataArray *divergence,
+    vtkMultiThreader *threader, int numThreads);
+
+  // Description:
+  // Compute the gradients of a point array at the parametric center of
+  // every cell. Returns 0 if the arrays are not supported.
+  static int ComputeCellGradients(
+    vtkDataSet *input, vtkDataArray *array, vtkDataArray *gradients,
+    vtkDataArray *vorticity, vtkDataArray *qCriterion,
+    vtkDataArray *divergence, vtkMultiThreader *threader, int numThreads);
+
+  // Description:
+  // Compute the gradients of a point array at every point, as the sum of the
+  // derivatives at the point of the cells using it divided by their number.
+  // Returns 0 if the arrays are not supported.
+  static int ComputePointGradients(
+    vtkDataSet *input, vtkDataArray *array, vtkDataArray *gradients,
+    vtkDataArray *vorticity, vtkDataArray *qCriterion,
+    vtkDataArray *divergence, vtkMultiThreader *threader, int numThreads);
+};
+
+#endif
+// VTK-HeaderTest-Exclude: vtkGradientKernels.h
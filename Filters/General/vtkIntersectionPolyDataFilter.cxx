@@ -21,8 +21,8 @@
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkLine.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
-#include "vtkOBBTree.h"
 #include "vtkPlane.h"
 #include "vtkPointData.h"
 #include "vtkPointLocator.h"
@@ -30,9 +30,11 @@
 #include "vtkSortDataArray.h"
 #include "vtkTransform.h"
 #include "vtkTriangle.h"
+#include "vtkTriangleBVH.h"
 
 #include <map>
 #include <queue>
+#include <vector>
 
 //----------------------------------------------------------------------------
 // Helper typedefs and data structure.
@@ -59,8 +61,10 @@ public:
   Impl();
   virtual ~Impl();
 
-  static int FindTriangleIntersections(vtkOBBNode *node0, vtkOBBNode *node1,
-                                       vtkMatrix4x4 *transform, void *arg);
+  static VTK_THREAD_RETURN_TYPE IntersectPairs(void *arg);
+
+  void AddIntersection(vtkIdType cellId0, vtkIdType cellId1,
+                       double outpt0[3], double outpt1[3]);
 
   int SplitMesh(int inputIndex, vtkPolyData *output,
                 vtkPolyData *intersectionLines);
@@ -81,7 +85,14 @@ protected:
 
 public:
   vtkPolyData         *Mesh[2];
-  vtkOBBTree          *OBBTree1;
+
+  // Pairs of triangles whose bounding boxes overlap, and for each pair
+  // whether the triangles intersect and the end points of the
+  // intersection line.
+  vtkIdTypeArray      *CandidatePairs;
+  char                *Intersects;
+  double              *IntersectionPoints;
+  int                  NumberOfThreads;
 
   // Stores the intersection lines.
   vtkCellArray        *IntersectionLines;
@@ -115,7 +126,8 @@ protected:
 
 //----------------------------------------------------------------------------
 vtkIntersectionPolyDataFilter::Impl::Impl() :
-  OBBTree1(0), IntersectionLines(0), PointMerger(0)
+  CandidatePairs(0), Intersects(0), IntersectionPoints(0), NumberOfThreads(1),
+  IntersectionLines(0), PointMerger(0)
 {
   for (int i = 0; i < 2; i++)
     {
@@ -138,124 +150,98 @@ vtkIntersectionPolyDataFilter::Impl::~Impl()
 
 
 //----------------------------------------------------------------------------
-int vtkIntersectionPolyDataFilter::Impl
-::FindTriangleIntersections(vtkOBBNode *node0, vtkOBBNode *node1,
-                            vtkMatrix4x4 *transform, void *arg)
+// Intersect a range of the candidate triangle pairs. Each thread writes the
+// results of its own range; they are merged in pair order afterwards.
+VTK_THREAD_RETURN_TYPE vtkIntersectionPolyDataFilter::Impl
+::IntersectPairs(void *arg)
 {
-  vtkIntersectionPolyDataFilter::Impl *info =
-    reinterpret_cast<vtkIntersectionPolyDataFilter::Impl*>(arg);
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkIntersectionPolyDataFilter::Impl *impl =
+    static_cast<vtkIntersectionPolyDataFilter::Impl *>(info->UserData);
+
+  vtkIdType numPairs = impl->CandidatePairs->GetNumberOfTuples();
+  vtkIdType begin = numPairs * info->ThreadID / impl->NumberOfThreads;
+  vtkIdType end = numPairs * (info->ThreadID + 1) / impl->NumberOfThreads;
+  vtkIdType *pair = impl->CandidatePairs->GetPointer(2*begin);
+  vtkIdType npts, *triPtIds;
+  double triPts0[3][3], triPts1[3][3];
+
+  for (vtkIdType pairId = begin; pairId < end; pairId++, pair += 2)
+    {
+    impl->Mesh[0]->GetCellPoints(pair[0], npts, triPtIds);
+    for (vtkIdType id = 0; id < 3; id++)
+      {
+      impl->Mesh[0]->GetPoint(triPtIds[id], triPts0[id]);
+      }
+    impl->Mesh[1]->GetCellPoints(pair[1], npts, triPtIds);
+    for (vtkIdType id = 0; id < 3; id++)
+      {
+      impl->Mesh[1]->GetPoint(triPtIds[id], triPts1[id]);
+      }
 
-  vtkPolyData     *mesh0                = info->Mesh[0];
-  vtkPolyData     *mesh1                = info->Mesh[1];
-  vtkOBBTree      *obbTree1             = info->OBBTree1;
-  vtkCellArray    *intersectionLines    = info->IntersectionLines;
-  vtkIdTypeArray  *intersectionCellIds0 = info->CellIds[0];
-  vtkIdTypeArray  *intersectionCellIds1 = info->CellIds[1];
-  vtkPointLocator *pointMerger          = info->PointMerger;
+    int coplanar = 0;
+    double *outpt0 = impl->IntersectionPoints + 6*pairId;
+    double *outpt1 = outpt0 + 3;
+    int intersects =
+      vtkIntersectionPolyDataFilter::TriangleTriangleIntersection
+      (triPts0[0], triPts0[1], triPts0[2],
+       triPts1[0], triPts1[1], triPts1[2],
+       coplanar, outpt0, outpt1);
+
+    // Coplanar triangle intersection is not handled. This intersection
+    // will not be included in the output.
+    impl->Intersects[pairId] = ( !coplanar && intersects &&
+                                 ( outpt0[0] != outpt1[0] ||
+                                   outpt0[1] != outpt1[1] ||
+                                   outpt0[2] != outpt1[2] ) );
+    }
 
-  int numCells0 = node0->Cells->GetNumberOfIds();
-  int retval = 0;
+  return VTK_THREAD_RETURN_VALUE;
+}
 
-  for (vtkIdType id0 = 0; id0 < numCells0; id0++)
-    {
-    vtkIdType cellId0 = node0->Cells->GetId(id0);
-    int type0 = mesh0->GetCellType(cellId0);
+//----------------------------------------------------------------------------
+void vtkIntersectionPolyDataFilter::Impl
+::AddIntersection(vtkIdType cellId0, vtkIdType cellId1, double outpt0[3],
+                  double outpt1[3])
+{
+  vtkIdType npts0, *triPtIds0, npts1, *triPtIds1;
+  this->Mesh[0]->GetCellPoints(cellId0, npts0, triPtIds0);
+  this->Mesh[1]->GetCellPoints(cellId1, npts1, triPtIds1);
 
-    if (type0 == VTK_TRIANGLE)
-      {
-      vtkIdType npts0, *triPtIds0;
-      mesh0->GetCellPoints(cellId0, npts0, triPtIds0);
-      double triPts0[3][3];
-      for (vtkIdType id = 0; id < npts0; id++)
-        {
-        mesh0->GetPoint(triPtIds0[id], triPts0[id]);
-        }
+  vtkIdType lineId = this->IntersectionLines->GetNumberOfCells();
+  this->IntersectionLines->InsertNextCell(2);
 
-      if (obbTree1->TriangleIntersectsNode
-          (node1, triPts0[0], triPts0[1], triPts0[2], transform))
-        {
-        int numCells1 = node1->Cells->GetNumberOfIds();
-        for (vtkIdType id1 = 0; id1 < numCells1; id1++)
-          {
-          vtkIdType cellId1 = node1->Cells->GetId(id1);
-          int type1 = mesh1->GetCellType(cellId1);
-          if (type1 == VTK_TRIANGLE)
-            {
-            // See if the two cells actually intersect. If they do,
-            // add an entry into the intersection maps and add an
-            // intersection line.
-            vtkIdType npts1, *triPtIds1;
-            mesh1->GetCellPoints(cellId1, npts1, triPtIds1);
-
-            double triPts1[3][3];
-            for (vtkIdType id = 0; id < npts1; id++)
-              {
-              mesh1->GetPoint(triPtIds1[id], triPts1[id]);
-              }
+  vtkIdType ptId0, ptId1;
+  this->PointMerger->InsertUniquePoint(outpt0, ptId0);
+  this->PointMerger->InsertUniquePoint(outpt1, ptId1);
+  this->IntersectionLines->InsertCellPoint(ptId0);
+  this->IntersectionLines->InsertCellPoint(ptId1);
 
-            int coplanar = 0;
-            double outpt0[3], outpt1[3];
-            int intersects =
-              vtkIntersectionPolyDataFilter::TriangleTriangleIntersection
-              (triPts0[0], triPts0[1], triPts0[2],
-               triPts1[0], triPts1[1], triPts1[2],
-               coplanar, outpt0, outpt1);
+  this->CellIds[0]->InsertNextValue(cellId0);
+  this->CellIds[1]->InsertNextValue(cellId1);
 
-            if ( coplanar )
-              {
-              // Coplanar triangle intersection is not handled.
-              // This intersection will not be included in the output.
-              intersects = 0;
-              continue;
-              }
+  this->PointCellIds[0]->InsertValue( ptId0, cellId0 );
+  this->PointCellIds[0]->InsertValue( ptId1, cellId0 );
+  this->PointCellIds[1]->InsertValue( ptId0, cellId1 );
+  this->PointCellIds[1]->InsertValue( ptId1, cellId1 );
 
-            if ( intersects &&
-                 ( outpt0[0] != outpt1[0] ||
-                   outpt0[1] != outpt1[1] ||
-                   outpt0[2] != outpt1[2] ) )
-              {
-              vtkIdType lineId = intersectionLines->GetNumberOfCells();
-              intersectionLines->InsertNextCell(2);
-
-              vtkIdType ptId0, ptId1;
-              pointMerger->InsertUniquePoint(outpt0, ptId0);
-              pointMerger->InsertUniquePoint(outpt1, ptId1);
-              intersectionLines->InsertCellPoint(ptId0);
-              intersectionLines->InsertCellPoint(ptId1);
-
-              intersectionCellIds0->InsertNextValue(cellId0);
-              intersectionCellIds1->InsertNextValue(cellId1);
-
-              info->PointCellIds[0]->InsertValue( ptId0, cellId0 );
-              info->PointCellIds[0]->InsertValue( ptId1, cellId0 );
-              info->PointCellIds[1]->InsertValue( ptId0, cellId1 );
-              info->PointCellIds[1]->InsertValue( ptId1, cellId1 );
-
-              info->IntersectionMap[0]->insert(std::make_pair(cellId0, lineId));
-              info->IntersectionMap[1]->insert(std::make_pair(cellId1, lineId));
-
-              // Check which edges of cellId0 and cellId1 outpt0 and
-              // outpt1 are on, if any.
-              for (vtkIdType edgeId = 0; edgeId < 3; edgeId++)
-                {
-                info->AddToPointEdgeMap(0, ptId0, outpt0, mesh0, cellId0,
-                                        edgeId, lineId, triPtIds0);
-                info->AddToPointEdgeMap(0, ptId1, outpt1, mesh0, cellId0,
-                                        edgeId, lineId, triPtIds0);
-                info->AddToPointEdgeMap(1, ptId0, outpt0, mesh1, cellId1,
-                                        edgeId, lineId, triPtIds1);
-                info->AddToPointEdgeMap(1, ptId1, outpt1, mesh1, cellId1,
-                                        edgeId, lineId, triPtIds1);
-                }
-              retval++;
-              }
-            }
-          }
-        }
-      }
-    }
+  this->IntersectionMap[0]->insert(std::make_pair(cellId0, lineId));
+  this->IntersectionMap[1]->insert(std::make_pair(cellId1, lineId));
 
-  return retval;
+  // Check which edges of cellId0 and cellId1 outpt0 and outpt1 are on, if
+  // any.
+  for (vtkIdType edgeId = 0; edgeId < 3; edgeId++)
+    {
+    this->AddToPointEdgeMap(0, ptId0, outpt0, this->Mesh[0], cellId0,
+                            edgeId, lineId, triPtIds0);
+    this->AddToPointEdgeMap(0, ptId1, outpt1, this->Mesh[0], cellId0,
+                            edgeId, lineId, triPtIds0);
+    this->AddToPointEdgeMap(1, ptId0, outpt0, this->Mesh[1], cellId1,
+                            edgeId, lineId, triPtIds1);
+    this->AddToPointEdgeMap(1, ptId1, outpt1, this->Mesh[1], cellId1,
+                            edgeId, lineId, triPtIds1);
+    }
 }
 
 
@@ -897,11 +883,15 @@ vtkIntersectionPolyDataFilter::vtkIntersectionPolyDataFilter()
 {
   this->SetNumberOfInputPorts(2);
   this->SetNumberOfOutputPorts(3);
+
+  this->Threader = vtkMultiThreader::New();
+  this->NumberOfThreads = this->Threader->GetNumberOfThreads();
 }
 
 //----------------------------------------------------------------------------
 vtkIntersectionPolyDataFilter::~vtkIntersectionPolyDataFilter()
 {
+  this->Threader->Delete();
 }
 
 //----------------------------------------------------------------------------
@@ -911,6 +901,7 @@ void vtkIntersectionPolyDataFilter::PrintSelf(ostream &os, vtkIndent indent)
 
   os << indent << "SplitFirstOutput: " << this->SplitFirstOutput << "\n";
   os << indent << "SplitSecondOutput: " << this->SplitSecondOutput << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
 }
 
 //----------------------------------------------------------------------------
@@ -1102,29 +1093,20 @@ int vtkIntersectionPolyDataFilter::RequestData(vtkInformation*        vtkNotUsed
   vtkSmartPointer< vtkPolyData > mesh1 = vtkSmartPointer< vtkPolyData >::New();
   mesh1->DeepCopy(input1);
 
-  // Find the triangle-triangle intersections between mesh0 and mesh1
-  vtkSmartPointer< vtkOBBTree > obbTree0 = vtkSmartPointer< vtkOBBTree >::New();
-  obbTree0->SetDataSet(mesh0);
-  obbTree0->SetNumberOfCellsPerNode(10);
-  obbTree0->SetMaxLevel(1000000);
-  obbTree0->SetTolerance(1e-6);
-  obbTree0->AutomaticOn();
-  obbTree0->BuildLocator();
-
-  vtkSmartPointer< vtkOBBTree > obbTree1 = vtkSmartPointer< vtkOBBTree >::New();
-  obbTree1->SetDataSet(mesh1);
-  obbTree1->SetNumberOfCellsPerNode(10);
-  obbTree1->SetMaxLevel(1000000);
-  obbTree1->SetTolerance(1e-6);
-  obbTree1->AutomaticOn();
-  obbTree1->BuildLocator();
+  // Find the pairs of triangles of mesh0 and mesh1 that may intersect
+  vtkTriangleBVH bvh0, bvh1;
+  bvh0.Build(mesh0, 4);
+  bvh1.Build(mesh1, 4);
+  vtkSmartPointer< vtkIdTypeArray > candidatePairs =
+    vtkSmartPointer< vtkIdTypeArray >::New();
+  bvh0.FindOverlappingPairs(&bvh1, 1e-6, this->Threader,
+                            this->NumberOfThreads, candidatePairs);
 
   // Set up the structure for determining exact triangle-triangle
   // intersections.
   vtkIntersectionPolyDataFilter::Impl *impl = new vtkIntersectionPolyDataFilter::Impl();
   impl->Mesh[0]  = mesh0;
   impl->Mesh[1]  = mesh1;
-  impl->OBBTree1 = obbTree1;
 
   vtkSmartPointer< vtkCellArray > lines = vtkSmartPointer< vtkCellArray >::New();
   outputIntersection->SetLines(lines);
@@ -1169,10 +1151,37 @@ int vtkIntersectionPolyDataFilter::RequestData(vtkInformation*        vtkNotUsed
   pointMerger->InitPointInsertion(outputIntersection->GetPoints(), bounds0);
   impl->PointMerger = pointMerger;
 
-  // This performs the triangle intersection search
-  obbTree0->IntersectWithOBBTree
-    (obbTree1, 0, vtkIntersectionPolyDataFilter::Impl::FindTriangleIntersections,
-     impl);
+  // Intersect the candidate pairs in parallel, then add the intersection
+  // lines in pair order.
+  vtkIdType numPairs = candidatePairs->GetNumberOfTuples();
+  if ( numPairs > 0 )
+    {
+    std::vector<char> intersects(numPairs);
+    std::vector<double> intersectionPoints(6*numPairs);
+    int numThreads = this->NumberOfThreads;
+    numThreads = ( numThreads > numPairs ? static_cast<int>(numPairs) :
+                   numThreads );
+    impl->CandidatePairs = candidatePairs;
+    impl->Intersects = &intersects[0];
+    impl->IntersectionPoints = &intersectionPoints[0];
+    impl->NumberOfThreads = numThreads;
+
+    this->Threader->SetNumberOfThreads(numThreads);
+    this->Threader->SetSingleMethod(
+      vtkIntersectionPolyDataFilter::Impl::IntersectPairs, impl);
+    this->Threader->SingleMethodExecute();
+
+    vtkIdType *pair = candidatePairs->GetPointer(0);
+    for (vtkIdType pairId = 0; pairId < numPairs; pairId++, pair += 2)
+      {
+      if ( intersects[pairId] )
+        {
+        impl->AddIntersection(pair[0], pair[1],
+                              &intersectionPoints[6*pairId],
+                              &intersectionPoints[6*pairId+3]);
+        }
+      }
+    }
 
   // Split the first output if so desired
   if ( this->SplitFirstOutput )
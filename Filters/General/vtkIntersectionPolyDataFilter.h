@@ -27,6 +27,11 @@
 // by Cory Quammen, Chris Weigle C., Russ Taylor
 // http://hdl.handle.net/10380/3262
 // http://www.insight-journal.org/browse/publication/797
+//
+// Candidate pairs of triangles are found with a bounding volume hierarchy
+// (vtkTriangleBVH) over each input, and are intersected in parallel. The
+// intersection lines are then merged in a fixed order, so the output does
+// not depend on the number of threads.
 
 #ifndef __vtkIntersectionPolyDataFilter_h
 #define __vtkIntersectionPolyDataFilter_h
@@ -34,6 +39,8 @@
 #include "vtkFiltersGeneralModule.h" // For export macro
 #include "vtkPolyDataAlgorithm.h"
 
+class vtkMultiThreader;
+
 class VTKFILTERSGENERAL_EXPORT vtkIntersectionPolyDataFilter : public vtkPolyDataAlgorithm
 {
 public:
@@ -55,6 +62,12 @@ public:
   vtkSetMacro(SplitSecondOutput, int);
   vtkBooleanMacro(SplitSecondOutput, int);
 
+  // Description:
+  // Set/Get the number of threads used to find and intersect the pairs of
+  // triangles. Defaults to the number of available processors.
+  vtkSetClampMacro(NumberOfThreads, int, 1, VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads, int);
+
   // Description:
   // Given two triangles defined by points (p1, q1, r1) and (p2, q2,
   // r2), returns whether the two triangles intersect. If they do,
@@ -79,6 +92,9 @@ private:
   int SplitFirstOutput;
   int SplitSecondOutput;
 
+  vtkMultiThreader *Threader;
+  int NumberOfThreads;
+
   class Impl;
 };
 
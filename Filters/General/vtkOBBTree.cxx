@@ -901,7 +901,7 @@ int vtkOBBTree::IntersectWithLine(double a0[3], double a1[3], double tol,
 {
   vtkOBBNode **OBBstack, *node;
   vtkIdList *cells;
-  int depth, ii, foundIntersection = 0, bestIntersection = 0;
+  int depth, ii, foundIntersection = 0;
   double tBest = VTK_DOUBLE_MAX, xBest[3], pcoordsBest[3];
   int subIdBest = -1;
   vtkIdType thisId, cellIdBest = -1;
@@ -935,7 +935,6 @@ int vtkOBBTree::IntersectWithLine(double a0[3], double a1[3], double tol,
             foundIntersection++;
             if ( t < tBest )
               { // Yes, it's the best.
-              bestIntersection = foundIntersection;
               tBest = t;
               xBest[0] = x[0]; xBest[1] = x[1]; xBest[2] = x[2];
               pcoordsBest[0] = pcoords[0]; pcoordsBest[1] = pcoords[1];
@@ -955,13 +954,16 @@ int vtkOBBTree::IntersectWithLine(double a0[3], double a1[3], double tol,
       }
     } // end while
 
-  if ( foundIntersection != bestIntersection )
+  // Always restore the best intersection: the cells tested after it may
+  // have written to t, x, pcoords and the cell even though they were missed.
+  if ( foundIntersection )
     {
     t = tBest;
     x[0] = xBest[0]; x[1] = xBest[1]; x[2] = xBest[2];
     pcoords[0] = pcoordsBest[0]; pcoords[1] = pcoordsBest[1];
     pcoords[2] = pcoordsBest[2];
     subId= subIdBest ;
+    this->DataSet->GetCell( cellIdBest, cell );
     }
 
   delete [] OBBstack;
@@ -287,6 +287,10 @@ protected:
   void GeneratePolygons(vtkOBBNode *OBBptr, int level, int repLevel,
                         vtkPoints* pts, vtkCellArray *polys);
 
+  // IntersectWithLine() only reads the tree, and tests the cells with the
+  // caller's generic cell.
+  virtual int IsIntersectWithLineThreadSafe() { return 1; }
+
   //ETX
 private:
   vtkOBBTree(const vtkOBBTree&);  // Not implemented.
@@ -0,0 +1,1114 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    vtkTriangleBVH.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+#include "vtkTriangleBVH.h"
+
+#include "vtkCellType.h"
+#include "vtkDoubleArray.h"
+#include "vtkIdTypeArray.h"
+#include "vtkMath.h"
+#include "vtkMultiThreader.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+
+#include <algorithm>
+#include <vector>
+
+// Number of bins used to evaluate the surface area heuristic.
+#define VTK_BVH_BINS 16
+
+// The pair traversal is split into (at least) this many tasks. It does not
+// depend on the number of threads, so neither does the output order.
+#define VTK_BVH_PAIR_TASKS 256
+
+// Tolerance on the barycentric coordinates of ray hits, below which a ray
+// is considered to graze an edge or a vertex.
+#define VTK_BVH_RAY_TOLERANCE 1.0e-10
+
+//----------------------------------------------------------------------------
+// Nodes are stored in an array. The children of an interior node are
+// stored next to each other, starting at Child; a leaf holds the Count
+// triangles starting at Child in the triangle arrays.
+struct vtkTriangleBVHNode
+{
+  double Bounds[6];
+  vtkIdType Child;
+  vtkIdType Count;
+};
+
+class vtkTriangleBVHInternals
+{
+public:
+  std::vector<vtkTriangleBVHNode> Nodes;
+  std::vector<double> Triangles; //nine coordinates per triangle
+  std::vector<vtkIdType> CellIds;
+  std::vector<vtkIdType> PointIds; //three per triangle
+  vtkIdType NumberOfPoints;
+
+  // Pseudonormals of the face, of the edges and of the vertices of every
+  // triangle, indexed by feature (seven per triangle). They are computed by
+  // the first signed distance query after a build.
+  std::vector<double> Normals;
+};
+
+// Features of a triangle (a,b,c) on which a closest point can lie.
+enum
+{
+  VTK_BVH_FACE = 0,
+  VTK_BVH_EDGE_AB, VTK_BVH_EDGE_BC, VTK_BVH_EDGE_CA,
+  VTK_BVH_VERTEX_A, VTK_BVH_VERTEX_B, VTK_BVH_VERTEX_C
+};
+
+namespace
+{
+// Triangle being sorted into the hierarchy.
+struct vtkBVHBuildTriangle
+{
+  double Bounds[6];
+  double Center[3];
+  vtkIdType Index;
+  int Bin;
+};
+
+// Partition predicate: triangles in the bins left of a split
+struct vtkBVHLowerBins
+{
+  int Bin;
+  bool operator()(const vtkBVHBuildTriangle& t) const
+    {
+    return t.Bin <= this->Bin;
+    }
+};
+
+inline void vtkBVHInitBounds(double bounds[6])
+{
+  bounds[0] = bounds[2] = bounds[4] = VTK_DOUBLE_MAX;
+  bounds[1] = bounds[3] = bounds[5] = -VTK_DOUBLE_MAX;
+}
+
+inline void vtkBVHAddBounds(double bounds[6], const double b[6])
+{
+  for ( int i=0; i < 3; i++ )
+    {
+    bounds[2*i] = ( b[2*i] < bounds[2*i] ? b[2*i] : bounds[2*i] );
+    bounds[2*i+1] = ( b[2*i+1] > bounds[2*i+1] ? b[2*i+1] : bounds[2*i+1] );
+    }
+}
+
+inline double vtkBVHHalfArea(const double b[6])
+{
+  double dx = b[1] - b[0], dy = b[3] - b[2], dz = b[5] - b[4];
+  if ( dx < 0.0 || dy < 0.0 || dz < 0.0 )
+    {
+    return 0.0;
+    }
+  return dx*dy + dy*dz + dz*dx;
+}
+
+inline bool vtkBVHOverlap(const double a[6], const double b[6], double tol)
+{
+  return ( a[0] - tol <= b[1] && b[0] <= a[1] + tol &&
+           a[2] - tol <= b[3] && b[2] <= a[3] + tol &&
+           a[4] - tol <= b[5] && b[4] <= a[5] + tol );
+}
+
+inline void vtkBVHTriangleBounds(const double *tri, double bounds[6])
+{
+  for ( int i=0; i < 3; i++ )
+    {
+    bounds[2*i] = bounds[2*i+1] = tri[i];
+    for ( int j=1; j < 3; j++ )
+      {
+      double x = tri[3*j+i];
+      bounds[2*i] = ( x < bounds[2*i] ? x : bounds[2*i] );
+      bounds[2*i+1] = ( x > bounds[2*i+1] ? x : bounds[2*i+1] );
+      }
+    }
+}
+
+inline double vtkBVHBoxDistance2(const double b[6], const double x[3])
+{
+  double d2 = 0.0, d;
+  for ( int i=0; i < 3; i++ )
+    {
+    if ( x[i] < b[2*i] )
+      {
+      d = b[2*i] - x[i];
+      d2 += d*d;
+      }
+    else if ( x[i] > b[2*i+1] )
+      {
+      d = x[i] - b[2*i+1];
+      d2 += d*d;
+      }
+    }
+  return d2;
+}
+
+// Closest point to p on triangle (a,b,c), following the Voronoi region
+// classification of Ericson, "Real-Time Collision Detection", 5.1.5.
+// Returns the feature of the triangle the closest point lies on.
+int vtkBVHClosestPointOnTriangle(const double p[3], const double *a,
+                                 const double *b, const double *c,
+                                 double closest[3])
+{
+  double ab[3], ac[3], ap[3], bp[3], cp[3];
+  int i;
+  for ( i=0; i < 3; i++ )
+    {
+    ab[i] = b[i] - a[i];
+    ac[i] = c[i] - a[i];
+    ap[i] = p[i] - a[i];
+    bp[i] = p[i] - b[i];
+    cp[i] = p[i] - c[i];
+    }
+
+  double d1 = vtkMath::Dot(ab, ap), d2 = vtkMath::Dot(ac, ap);
+  if ( d1 <= 0.0 && d2 <= 0.0 )
+    {
+    closest[0] = a[0]; closest[1] = a[1]; closest[2] = a[2];
+    return VTK_BVH_VERTEX_A;
+    }
+
+  double d3 = vtkMath::Dot(ab, bp), d4 = vtkMath::Dot(ac, bp);
+  if ( d3 >= 0.0 && d4 <= d3 )
+    {
+    closest[0] = b[0]; closest[1] = b[1]; closest[2] = b[2];
+    return VTK_BVH_VERTEX_B;
+    }
+
+  double vc = d1*d4 - d3*d2;
+  if ( vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0 )
+    {
+    double v = ( d1 - d3 > 0.0 ? d1 / (d1 - d3) : 0.0 );
+    for ( i=0; i < 3; i++ )
+      {
+      closest[i] = a[i] + v*ab[i];
+      }
+    return VTK_BVH_EDGE_AB;
+    }
+
+  double d5 = vtkMath::Dot(ab, cp), d6 = vtkMath::Dot(ac, cp);
+  if ( d6 >= 0.0 && d5 <= d6 )
+    {
+    closest[0] = c[0]; closest[1] = c[1]; closest[2] = c[2];
+    return VTK_BVH_VERTEX_C;
+    }
+
+  double vb = d5*d2 - d1*d6;
+  if ( vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0 )
+    {
+    double w = ( d2 - d6 > 0.0 ? d2 / (d2 - d6) : 0.0 );
+    for ( i=0; i < 3; i++ )
+      {
+      closest[i] = a[i] + w*ac[i];
+      }
+    return VTK_BVH_EDGE_CA;
+    }
+
+  double va = d3*d6 - d5*d4;
+  if ( va <= 0.0 && (d4 - d3) >= 0.0 && (d5 - d6) >= 0.0 )
+    {
+    double den = (d4 - d3) + (d5 - d6);
+    double w = ( den > 0.0 ? (d4 - d3) / den : 0.0 );
+    for ( i=0; i < 3; i++ )
+      {
+      closest[i] = b[i] + w*(c[i] - b[i]);
+      }
+    return VTK_BVH_EDGE_BC;
+    }
+
+  double sum = va + vb + vc;
+  if ( sum == 0.0 ) //degenerate triangle
+    {
+    closest[0] = a[0]; closest[1] = a[1]; closest[2] = a[2];
+    return VTK_BVH_VERTEX_A;
+    }
+  double v = vb / sum, w = vc / sum;
+  for ( i=0; i < 3; i++ )
+    {
+    closest[i] = a[i] + ab[i]*v + ac[i]*w;
+    }
+  return VTK_BVH_FACE;
+}
+
+// Intersect the ray o + t*d (t > 0) with triangle tri. Returns 0 when the
+// ray misses, 1 when it crosses the interior of the triangle and -1 when it
+// grazes an edge or a vertex.
+int vtkBVHRayTriangle(const double o[3], const double d[3], const double *tri)
+{
+  double e1[3], e2[3], pvec[3], tvec[3], qvec[3];
+  for ( int i=0; i < 3; i++ )
+    {
+    e1[i] = tri[3+i] - tri[i];
+    e2[i] = tri[6+i] - tri[i];
+    tvec[i] = o[i] - tri[i];
+    }
+  vtkMath::Cross(d, e2, pvec);
+  double det = vtkMath::Dot(e1, pvec);
+  double scale = vtkMath::Norm(e1) * vtkMath::Norm(e2);
+  if ( fabs(det) <= 1.0e-12 * scale ) //parallel or degenerate
+    {
+    return 0;
+    }
+  double inv = 1.0 / det;
+  double u = vtkMath::Dot(tvec, pvec) * inv;
+  if ( u < -VTK_BVH_RAY_TOLERANCE || u > 1.0 + VTK_BVH_RAY_TOLERANCE )
+    {
+    return 0;
+    }
+  vtkMath::Cross(tvec, e1, qvec);
+  double v = vtkMath::Dot(d, qvec) * inv;
+  if ( v < -VTK_BVH_RAY_TOLERANCE || u + v > 1.0 + VTK_BVH_RAY_TOLERANCE )
+    {
+    return 0;
+    }
+  if ( vtkMath::Dot(e2, qvec) * inv <= 0.0 )
+    {
+    return 0;
+    }
+  if ( u < VTK_BVH_RAY_TOLERANCE || v < VTK_BVH_RAY_TOLERANCE ||
+       u + v > 1.0 - VTK_BVH_RAY_TOLERANCE )
+    {
+    return -1;
+    }
+  return 1;
+}
+
+inline bool vtkBVHRayBox(const double o[3], const double invDir[3],
+                         const double b[6])
+{
+  double tmin = 0.0, tmax = VTK_DOUBLE_MAX;
+  for ( int i=0; i < 3; i++ )
+    {
+    double t0 = (b[2*i] - o[i]) * invDir[i];
+    double t1 = (b[2*i+1] - o[i]) * invDir[i];
+    if ( t0 > t1 )
+      {
+      std::swap(t0, t1);
+      }
+    tmin = ( t0 > tmin ? t0 : tmin );
+    tmax = ( t1 < tmax ? t1 : tmax );
+    if ( tmin > tmax )
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+// Ray directions used by IsInside(), away from the axes and diagonals along
+// which meshes tend to be aligned.
+const double vtkBVHRayDirections[5][3] = {
+  { 0.6010,  0.5408,  0.5886},
+  {-0.4327,  0.7531,  0.4954},
+  { 0.3213, -0.8470,  0.4235},
+  {-0.5719, -0.3928, -0.7201},
+  { 0.8164,  0.2981, -0.4946} };
+
+// A node waiting to be split by vtkBVHBuildNodes(), with its triangles
+// [Begin,End).
+struct vtkBVHBuildTask
+{
+  vtkIdType NodeId;
+  vtkIdType Begin;
+  vtkIdType End;
+};
+
+//----------------------------------------------------------------------------
+// Set the bounds of node nodeId from its triangles [begin,end), and split
+// them in two if worth it. Returns the index of the first triangle of the
+// second child, or -1 if the node is a leaf.
+vtkIdType vtkBVHSplitNode(std::vector<vtkTriangleBVHNode> &nodes,
+                          vtkIdType nodeId, vtkBVHBuildTriangle *tris,
+                          vtkIdType begin, vtkIdType end, int maxPerLeaf)
+{
+  double bounds[6], centers[6];
+  vtkIdType i;
+  int axis, bin;
+
+  vtkBVHInitBounds(bounds);
+  vtkBVHInitBounds(centers);
+  for ( i=begin; i < end; i++ )
+    {
+    double c[6] = { tris[i].Center[0], tris[i].Center[0],
+                    tris[i].Center[1], tris[i].Center[1],
+                    tris[i].Center[2], tris[i].Center[2] };
+    vtkBVHAddBounds(bounds, tris[i].Bounds);
+    vtkBVHAddBounds(centers, c);
+    }
+  for ( i=0; i < 6; i++ )
+    {
+    nodes[nodeId].Bounds[i] = bounds[i];
+    }
+  nodes[nodeId].Child = begin;
+  nodes[nodeId].Count = end - begin;
+
+  // Split along the longest extent of the triangle centers
+  axis = 0;
+  for ( i=1; i < 3; i++ )
+    {
+    if ( centers[2*i+1] - centers[2*i] > centers[2*axis+1] - centers[2*axis] )
+      {
+      axis = i;
+      }
+    }
+  double extent = centers[2*axis+1] - centers[2*axis];
+  if ( end - begin <= maxPerLeaf || extent <= 0.0 )
+    {
+    return -1;
+    }
+
+  // Bin the triangles by center and sweep the bins to evaluate the cost
+  // of every split.
+  vtkIdType counts[VTK_BVH_BINS];
+  double binBounds[VTK_BVH_BINS][6];
+  for ( bin=0; bin < VTK_BVH_BINS; bin++ )
+    {
+    counts[bin] = 0;
+    vtkBVHInitBounds(binBounds[bin]);
+    }
+  double scale = VTK_BVH_BINS / extent;
+  for ( i=begin; i < end; i++ )
+    {
+    bin = static_cast<int>((tris[i].Center[axis] - centers[2*axis]) * scale);
+    bin = ( bin >= VTK_BVH_BINS ? VTK_BVH_BINS-1 : bin );
+    tris[i].Bin = bin;
+    counts[bin]++;
+    vtkBVHAddBounds(binBounds[bin], tris[i].Bounds);
+    }
+
+  double rightArea[VTK_BVH_BINS];
+  vtkIdType rightCount[VTK_BVH_BINS];
+  double acc[6];
+  vtkIdType count = 0;
+  vtkBVHInitBounds(acc);
+  for ( bin=VTK_BVH_BINS-1; bin > 0; bin-- )
+    {
+    vtkBVHAddBounds(acc, binBounds[bin]);
+    count += counts[bin];
+    rightArea[bin] = vtkBVHHalfArea(acc);
+    rightCount[bin] = count;
+    }
+
+  int bestBin = -1;
+  double bestCost = VTK_DOUBLE_MAX;
+  vtkBVHInitBounds(acc);
+  count = 0;
+  for ( bin=0; bin < VTK_BVH_BINS-1; bin++ )
+    {
+    vtkBVHAddBounds(acc, binBounds[bin]);
+    count += counts[bin];
+    if ( count == 0 || rightCount[bin+1] == 0 )
+      {
+      continue;
+      }
+    double cost = vtkBVHHalfArea(acc) * count +
+      rightArea[bin+1] * rightCount[bin+1];
+    if ( cost < bestCost )
+      {
+      bestCost = cost;
+      bestBin = bin;
+      }
+    }
+
+  vtkIdType middle;
+  if ( bestBin < 0 ) //all centers in one bin: split in the middle
+    {
+    middle = (begin + end) / 2;
+    }
+  else
+    {
+    vtkBVHLowerBins lower;
+    lower.Bin = bestBin;
+    middle = std::partition(tris + begin, tris + end, lower) - tris;
+    }
+
+  return middle;
+}
+
+//----------------------------------------------------------------------------
+// Split the triangles [0,numTris) from the root node down to the leaves.
+// The nodes are split depth first with an explicit stack, in the same order
+// as a recursion would, so that degenerate inputs cannot overflow the call
+// stack.
+void vtkBVHBuildNodes(std::vector<vtkTriangleBVHNode> &nodes,
+                      vtkBVHBuildTriangle *tris, vtkIdType numTris,
+                      int maxPerLeaf)
+{
+  std::vector<vtkBVHBuildTask> stack;
+  vtkBVHBuildTask task = { 0, 0, numTris };
+  nodes.resize(1);
+  stack.push_back(task);
+  while ( !stack.empty() )
+    {
+    task = stack.back();
+    stack.pop_back();
+    vtkIdType middle = vtkBVHSplitNode(nodes, task.NodeId, tris, task.Begin,
+                                       task.End, maxPerLeaf);
+    if ( middle < 0 )
+      {
+      continue;
+      }
+    vtkIdType child = static_cast<vtkIdType>(nodes.size());
+    nodes[task.NodeId].Child = child;
+    nodes[task.NodeId].Count = 0;
+    nodes.resize(child + 2);
+    vtkBVHBuildTask right = { child + 1, middle, task.End };
+    vtkBVHBuildTask left = { child, task.Begin, middle };
+    stack.push_back(right);
+    stack.push_back(left);
+    }
+}
+
+//----------------------------------------------------------------------------
+struct vtkBVHPairThreadStruct
+{
+  vtkTriangleBVHInternals *A;
+  vtkTriangleBVHInternals *B;
+  double Tolerance;
+  std::vector<std::pair<vtkIdType,vtkIdType> > *Tasks;
+  std::vector<std::vector<vtkIdType> > *Results;
+  int NumberOfThreads;
+};
+
+// Which node of a pair to descend into: the interior one, or the larger.
+inline bool vtkBVHDescendA(const vtkTriangleBVHNode &a,
+                           const vtkTriangleBVHNode &b)
+{
+  if ( a.Count > 0 )
+    {
+    return false;
+    }
+  return ( b.Count > 0 ||
+           vtkBVHHalfArea(a.Bounds) >= vtkBVHHalfArea(b.Bounds) );
+}
+
+void vtkBVHFindPairs(vtkTriangleBVHInternals *A, vtkTriangleBVHInternals *B,
+                     vtkIdType nodeA, vtkIdType nodeB, double tol,
+                     std::vector<vtkIdType> &result)
+{
+  std::vector<std::pair<vtkIdType,vtkIdType> > stack;
+  stack.push_back(std::make_pair(nodeA, nodeB));
+  double boundsA[6], boundsB[6];
+
+  while ( !stack.empty() )
+    {
+    vtkIdType idA = stack.back().first, idB = stack.back().second;
+    const vtkTriangleBVHNode &a = A->Nodes[idA];
+    const vtkTriangleBVHNode &b = B->Nodes[idB];
+    stack.pop_back();
+    if ( !vtkBVHOverlap(a.Bounds, b.Bounds, tol) )
+      {
+      continue;
+      }
+    if ( a.Count > 0 && b.Count > 0 )
+      {
+      for ( vtkIdType i=a.Child; i < a.Child + a.Count; i++ )
+        {
+        vtkBVHTriangleBounds(&A->Triangles[9*i], boundsA);
+        if ( !vtkBVHOverlap(boundsA, b.Bounds, tol) )
+          {
+          continue;
+          }
+        for ( vtkIdType j=b.Child; j < b.Child + b.Count; j++ )
+          {
+          vtkBVHTriangleBounds(&B->Triangles[9*j], boundsB);
+          if ( vtkBVHOverlap(boundsA, boundsB, tol) )
+            {
+            result.push_back(A->CellIds[i]);
+            result.push_back(B->CellIds[j]);
+            }
+          }
+        }
+      }
+    else if ( vtkBVHDescendA(a, b) )
+      {
+      stack.push_back(std::make_pair(a.Child + 1, idB));
+      stack.push_back(std::make_pair(a.Child, idB));
+      }
+    else
+      {
+      stack.push_back(std::make_pair(idA, b.Child + 1));
+      stack.push_back(std::make_pair(idA, b.Child));
+      }
+    }
+}
+
+struct vtkBVHDistanceThreadStruct
+{
+  vtkTriangleBVH *BVH;
+  vtkTriangleBVHInternals *Internals;
+  vtkPoints *Points;
+  double *Distances;
+  int RayParity;
+  int NumberOfThreads;
+};
+
+// Edge of a triangle keyed by its sorted point ids, used to gather the
+// triangles sharing every edge.
+struct vtkBVHEdge
+{
+  vtkIdType Points[2];
+  vtkIdType Triangle;
+  int Edge;
+
+  bool operator<(const vtkBVHEdge &other) const
+    {
+    return this->Points[0] < other.Points[0] ||
+      ( this->Points[0] == other.Points[0] &&
+        this->Points[1] < other.Points[1] );
+    }
+};
+}
+
+//----------------------------------------------------------------------------
+// Process the tasks ThreadID, ThreadID + NumberOfThreads, ... of the pair
+// traversal.
+static VTK_THREAD_RETURN_TYPE vtkTriangleBVHFindPairs(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkBVHPairThreadStruct *str =
+    static_cast<vtkBVHPairThreadStruct *>(info->UserData);
+
+  vtkIdType numTasks = static_cast<vtkIdType>(str->Tasks->size());
+  for ( vtkIdType task=info->ThreadID; task < numTasks;
+        task += str->NumberOfThreads )
+    {
+    vtkBVHFindPairs(str->A, str->B, (*str->Tasks)[task].first,
+                    (*str->Tasks)[task].second, str->Tolerance,
+                    (*str->Results)[task]);
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+vtkTriangleBVH::vtkTriangleBVH()
+{
+  this->Internals = new vtkTriangleBVHInternals;
+  this->Internals->NumberOfPoints = 0;
+}
+
+//----------------------------------------------------------------------------
+vtkTriangleBVH::~vtkTriangleBVH()
+{
+  delete this->Internals;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkTriangleBVH::GetNumberOfTriangles()
+{
+  return static_cast<vtkIdType>(this->Internals->CellIds.size());
+}
+
+//----------------------------------------------------------------------------
+void vtkTriangleBVH::Build(vtkPolyData *mesh, int maxTrianglesPerLeaf)
+{
+  vtkTriangleBVHInternals *internals = this->Internals;
+  vtkIdType numCells = mesh->GetNumberOfCells();
+  vtkIdType cellId, npts, *pts, i;
+  double x[3];
+  int j, k;
+
+  internals->Nodes.clear();
+  internals->Triangles.clear();
+  internals->CellIds.clear();
+  internals->PointIds.clear();
+  internals->NumberOfPoints = mesh->GetNumberOfPoints();
+  internals->Normals.clear();
+
+  std::vector<vtkBVHBuildTriangle> tris;
+  std::vector<double> coords;
+  std::vector<vtkIdType> ids;
+  tris.reserve(numCells);
+  coords.reserve(9*numCells);
+  ids.reserve(3*numCells);
+  for ( cellId=0; cellId < numCells; cellId++ )
+    {
+    if ( mesh->GetCellType(cellId) != VTK_TRIANGLE )
+      {
+      continue;
+      }
+    mesh->GetCellPoints(cellId, npts, pts);
+    vtkBVHBuildTriangle t;
+    for ( j=0; j < 3; j++ )
+      {
+      mesh->GetPoint(pts[j], x);
+      for ( k=0; k < 3; k++ )
+        {
+        coords.push_back(x[k]);
+        }
+      ids.push_back(pts[j]);
+      }
+    vtkBVHTriangleBounds(&coords[coords.size()-9], t.Bounds);
+    for ( k=0; k < 3; k++ )
+      {
+      t.Center[k] = 0.5 * (t.Bounds[2*k] + t.Bounds[2*k+1]);
+      }
+    t.Index = cellId;
+    t.Bin = 0;
+    tris.push_back(t);
+    }
+
+  vtkIdType numTris = static_cast<vtkIdType>(tris.size());
+  if ( numTris == 0 )
+    {
+    return;
+    }
+
+  // Remember where the coordinates of each triangle are, since the build
+  // reorders the triangles.
+  std::vector<vtkIdType> offsets(numCells, -1);
+  for ( i=0; i < numTris; i++ )
+    {
+    offsets[tris[i].Index] = 9*i;
+    }
+
+  maxTrianglesPerLeaf = ( maxTrianglesPerLeaf < 1 ? 1 : maxTrianglesPerLeaf );
+  internals->Nodes.reserve(2*numTris);
+  vtkBVHBuildNodes(internals->Nodes, &tris[0], numTris, maxTrianglesPerLeaf);
+
+  // Store the triangles in leaf order
+  internals->Triangles.resize(9*numTris);
+  internals->CellIds.resize(numTris);
+  internals->PointIds.resize(3*numTris);
+  for ( i=0; i < numTris; i++ )
+    {
+    vtkIdType offset = offsets[tris[i].Index];
+    internals->CellIds[i] = tris[i].Index;
+    std::copy(&coords[offset], &coords[offset] + 9,
+              &internals->Triangles[9*i]);
+    std::copy(&ids[offset/3], &ids[offset/3] + 3,
+              &internals->PointIds[3*i]);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkTriangleBVH::FindOverlappingPairs(vtkTriangleBVH *other,
+                                          double tolerance,
+                                          vtkMultiThreader *threader,
+                                          int numThreads,
+                                          vtkIdTypeArray *pairs)
+{
+  vtkTriangleBVHInternals *A = this->Internals;
+  vtkTriangleBVHInternals *B = other->Internals;
+
+  pairs->Reset();
+  pairs->SetNumberOfComponents(2);
+  if ( A->Nodes.empty() || B->Nodes.empty() )
+    {
+    return;
+    }
+
+  // Expand the overlapping node pairs breadth first into a set of tasks.
+  std::vector<std::pair<vtkIdType,vtkIdType> > tasks, next;
+  tasks.push_back(std::make_pair(0, 0));
+  bool expanded = true;
+  while ( expanded && tasks.size() < VTK_BVH_PAIR_TASKS )
+    {
+    expanded = false;
+    next.clear();
+    for ( size_t t=0; t < tasks.size(); t++ )
+      {
+      const vtkTriangleBVHNode &a = A->Nodes[tasks[t].first];
+      const vtkTriangleBVHNode &b = B->Nodes[tasks[t].second];
+      if ( !vtkBVHOverlap(a.Bounds, b.Bounds, tolerance) )
+        {
+        continue;
+        }
+      if ( a.Count > 0 && b.Count > 0 )
+        {
+        next.push_back(tasks[t]);
+        }
+      else if ( vtkBVHDescendA(a, b) )
+        {
+        next.push_back(std::make_pair(a.Child, tasks[t].second));
+        next.push_back(std::make_pair(a.Child + 1, tasks[t].second));
+        expanded = true;
+        }
+      else
+        {
+        next.push_back(std::make_pair(tasks[t].first, b.Child));
+        next.push_back(std::make_pair(tasks[t].first, b.Child + 1));
+        expanded = true;
+        }
+      }
+    tasks.swap(next);
+    }
+  if ( tasks.empty() )
+    {
+    return;
+    }
+
+  std::vector<std::vector<vtkIdType> > results(tasks.size());
+  numThreads = ( numThreads > static_cast<int>(tasks.size()) ?
+                 static_cast<int>(tasks.size()) : numThreads );
+  numThreads = ( numThreads < 1 ? 1 : numThreads );
+
+  vtkBVHPairThreadStruct str;
+  str.A = A;
+  str.B = B;
+  str.Tolerance = tolerance;
+  str.Tasks = &tasks;
+  str.Results = &results;
+  str.NumberOfThreads = numThreads;
+
+  threader->SetNumberOfThreads(numThreads);
+  threader->SetSingleMethod(vtkTriangleBVHFindPairs, &str);
+  threader->SingleMethodExecute();
+
+  // Concatenate the results in task order
+  size_t size = 0, t;
+  for ( t=0; t < results.size(); t++ )
+    {
+    size += results[t].size();
+    }
+  pairs->SetNumberOfTuples(static_cast<vtkIdType>(size / 2));
+  vtkIdType *ptr = pairs->GetPointer(0);
+  for ( t=0; t < results.size(); t++ )
+    {
+    if ( !results[t].empty() )
+      {
+      ptr = std::copy(results[t].begin(), results[t].end(), ptr);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Find the closest point on the triangles to x. Returns the index of the
+// triangle containing it in the leaf order, or -1 if there is none, and
+// sets the squared distance and the feature of the triangle it lies on.
+static vtkIdType vtkBVHFindClosestTriangle(vtkTriangleBVHInternals *internals,
+                                           const double x[3],
+                                           double closest[3], double &best,
+                                           int &feature)
+{
+  double p[3];
+  vtkIdType closestTri = -1;
+  best = VTK_DOUBLE_MAX;
+  if ( internals->Nodes.empty() )
+    {
+    return closestTri;
+    }
+
+  std::vector<vtkIdType> stack;
+  stack.reserve(64);
+  stack.push_back(0);
+  while ( !stack.empty() )
+    {
+    const vtkTriangleBVHNode &node = internals->Nodes[stack.back()];
+    stack.pop_back();
+    if ( vtkBVHBoxDistance2(node.Bounds, x) >= best )
+      {
+      continue;
+      }
+    if ( node.Count > 0 )
+      {
+      for ( vtkIdType i=node.Child; i < node.Child + node.Count; i++ )
+        {
+        const double *tri = &internals->Triangles[9*i];
+        int f = vtkBVHClosestPointOnTriangle(x, tri, tri+3, tri+6, p);
+        double d2 = vtkMath::Distance2BetweenPoints(x, p);
+        if ( d2 < best )
+          {
+          best = d2;
+          closestTri = i;
+          feature = f;
+          closest[0] = p[0]; closest[1] = p[1]; closest[2] = p[2];
+          }
+        }
+      }
+    else
+      {
+      // Visit the nearer child first
+      double d0 = vtkBVHBoxDistance2(internals->Nodes[node.Child].Bounds, x);
+      double d1 = vtkBVHBoxDistance2(internals->Nodes[node.Child+1].Bounds, x);
+      if ( d0 <= d1 )
+        {
+        stack.push_back(node.Child + 1);
+        stack.push_back(node.Child);
+        }
+      else
+        {
+        stack.push_back(node.Child);
+        stack.push_back(node.Child + 1);
+        }
+      }
+    }
+  return closestTri;
+}
+
+//----------------------------------------------------------------------------
+double vtkTriangleBVH::FindClosestPoint(const double x[3], double closest[3],
+                                        vtkIdType &cellId)
+{
+  double best;
+  int feature;
+  vtkIdType tri = vtkBVHFindClosestTriangle(this->Internals, x, closest, best,
+                                            feature);
+  cellId = ( tri < 0 ? -1 : this->Internals->CellIds[tri] );
+  return best;
+}
+
+//----------------------------------------------------------------------------
+int vtkTriangleBVH::IsInside(const double x[3])
+{
+  vtkTriangleBVHInternals *internals = this->Internals;
+  if ( internals->Nodes.empty() )
+    {
+    return 0;
+    }
+
+  std::vector<vtkIdType> stack;
+  stack.reserve(64);
+  for ( int dir=0; dir < 5; dir++ )
+    {
+    const double *d = vtkBVHRayDirections[dir];
+    double invDir[3] = { 1.0 / d[0], 1.0 / d[1], 1.0 / d[2] };
+    int crossings = 0;
+    bool grazing = false;
+
+    stack.clear();
+    stack.push_back(0);
+    while ( !stack.empty() && !grazing )
+      {
+      const vtkTriangleBVHNode &node = internals->Nodes[stack.back()];
+      stack.pop_back();
+      if ( !vtkBVHRayBox(x, invDir, node.Bounds) )
+        {
+        continue;
+        }
+      if ( node.Count > 0 )
+        {
+        for ( vtkIdType i=node.Child; i < node.Child + node.Count; i++ )
+          {
+          int hit = vtkBVHRayTriangle(x, d, &internals->Triangles[9*i]);
+          if ( hit < 0 )
+            {
+            grazing = true;
+            break;
+            }
+          crossings += hit;
+          }
+        }
+      else
+        {
+        stack.push_back(node.Child + 1);
+        stack.push_back(node.Child);
+        }
+      }
+
+    if ( !grazing )
+      {
+      return crossings % 2;
+      }
+    }
+
+  // Every ray grazed an edge or a vertex: x is inside if it lies behind the
+  // plane of the closest triangle, which assumes outward triangles as
+  // vtkImplicitPolyDataDistance does.
+  double closest[3], dist2, e1[3], e2[3], n[3], v[3];
+  int feature;
+  vtkIdType tri = vtkBVHFindClosestTriangle(internals, x, closest, dist2,
+                                            feature);
+  const double *t = &internals->Triangles[9*tri];
+  for ( int i=0; i < 3; i++ )
+    {
+    e1[i] = t[3+i] - t[i];
+    e2[i] = t[6+i] - t[i];
+    v[i] = x[i] - closest[i];
+    }
+  vtkMath::Cross(e1, e2, n);
+  return ( vtkMath::Dot(v, n) < 0.0 ? 1 : 0 );
+}
+
+//----------------------------------------------------------------------------
+// Compute the angle-weighted pseudonormals of the triangles (Baerentzen and
+// Aanaes), as vtkImplicitPolyDataDistance does: the normal of the face, the
+// normalized sum of the normals of the faces sharing each edge, and the sum
+// of the normals of the faces around each vertex, weighted by their angle at
+// the vertex.
+static void vtkBVHComputePseudoNormals(vtkTriangleBVHInternals *internals)
+{
+  vtkIdType numTris = static_cast<vtkIdType>(internals->CellIds.size());
+  std::vector<double> &normals = internals->Normals;
+  std::vector<double> vertexNormals(3*internals->NumberOfPoints, 0.0);
+  std::vector<vtkBVHEdge> edges(3*numTris);
+  vtkIdType i, e;
+  int j, k;
+
+  normals.assign(21*numTris, 0.0);
+  for ( i=0; i < numTris; i++ )
+    {
+    const double *t = &internals->Triangles[9*i];
+    const vtkIdType *ids = &internals->PointIds[3*i];
+    double *n = &normals[21*i];
+    double e1[3], e2[3];
+    for ( k=0; k < 3; k++ )
+      {
+      e1[k] = t[3+k] - t[k];
+      e2[k] = t[6+k] - t[k];
+      }
+    vtkMath::Cross(e1, e2, n);
+    vtkMath::Normalize(n);
+
+    for ( j=0; j < 3; j++ )
+      {
+      const double *a = t + 3*j;
+      const double *b = t + 3*((j+1)%3);
+      const double *c = t + 3*((j+2)%3);
+      double ab[3], ac[3];
+      for ( k=0; k < 3; k++ )
+        {
+        ab[k] = b[k] - a[k];
+        ac[k] = c[k] - a[k];
+        }
+      vtkMath::Normalize(ab);
+      vtkMath::Normalize(ac);
+      double cosine = vtkMath::Dot(ab, ac);
+      cosine = ( cosine > 1.0 ? 1.0 : ( cosine < -1.0 ? -1.0 : cosine ) );
+      double alpha = acos(cosine);
+      for ( k=0; k < 3; k++ )
+        {
+        vertexNormals[3*ids[j]+k] += alpha * n[k];
+        }
+
+      vtkBVHEdge &edge = edges[3*i+j];
+      edge.Points[0] = std::min(ids[j], ids[(j+1)%3]);
+      edge.Points[1] = std::max(ids[j], ids[(j+1)%3]);
+      edge.Triangle = i;
+      edge.Edge = VTK_BVH_EDGE_AB + j;
+      }
+    }
+
+  // Sum the face normals of the triangles sharing each edge
+  std::sort(edges.begin(), edges.end());
+  for ( e=0; e < 3*numTris; )
+    {
+    vtkIdType last = e + 1;
+    while ( last < 3*numTris && !(edges[e] < edges[last]) )
+      {
+      last++;
+      }
+    double sum[3] = { 0.0, 0.0, 0.0 };
+    for ( i=e; i < last; i++ )
+      {
+      const double *n = &normals[21*edges[i].Triangle];
+      sum[0] += n[0]; sum[1] += n[1]; sum[2] += n[2];
+      }
+    vtkMath::Normalize(sum);
+    for ( i=e; i < last; i++ )
+      {
+      double *n = &normals[21*edges[i].Triangle + 3*edges[i].Edge];
+      n[0] = sum[0]; n[1] = sum[1]; n[2] = sum[2];
+      }
+    e = last;
+    }
+
+  for ( i=0; i < numTris; i++ )
+    {
+    for ( j=0; j < 3; j++ )
+      {
+      double *n = &normals[21*i + 3*(VTK_BVH_VERTEX_A + j)];
+      const double *vn = &vertexNormals[3*internals->PointIds[3*i+j]];
+      n[0] = vn[0]; n[1] = vn[1]; n[2] = vn[2];
+      vtkMath::Normalize(n);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+static VTK_THREAD_RETURN_TYPE vtkTriangleBVHSignedDistances(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkBVHDistanceThreadStruct *str =
+    static_cast<vtkBVHDistanceThreadStruct *>(info->UserData);
+
+  vtkIdType numPts = str->Points->GetNumberOfPoints();
+  vtkIdType begin = numPts * info->ThreadID / str->NumberOfThreads;
+  vtkIdType end = numPts * (info->ThreadID + 1) / str->NumberOfThreads;
+  double x[3], closest[3], dist2, v[3];
+  int feature;
+
+  for ( vtkIdType ptId=begin; ptId < end; ptId++ )
+    {
+    str->Points->GetPoint(ptId, x);
+    vtkIdType tri = vtkBVHFindClosestTriangle(str->Internals, x, closest,
+                                              dist2, feature);
+    double dist = sqrt(dist2);
+    if ( tri >= 0 && dist > 0.0 )
+      {
+      int inside;
+      if ( str->RayParity )
+        {
+        inside = str->BVH->IsInside(x);
+        }
+      else
+        {
+        // x is inside when it lies behind the pseudonormal of the feature
+        // its closest point lies on.
+        const double *n = &str->Internals->Normals[21*tri + 3*feature];
+        v[0] = x[0] - closest[0];
+        v[1] = x[1] - closest[1];
+        v[2] = x[2] - closest[2];
+        inside = ( vtkMath::Dot(v, n) <= 0.0 );
+        }
+      dist = ( inside ? -dist : dist );
+      }
+    str->Distances[ptId] = dist;
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+void vtkTriangleBVH::ComputeSignedDistances(vtkPoints *points,
+                                            vtkDoubleArray *distances,
+                                            vtkMultiThreader *threader,
+                                            int numThreads, int rayParity)
+{
+  vtkIdType numPts = points->GetNumberOfPoints();
+  distances->SetNumberOfComponents(1);
+  distances->SetNumberOfTuples(numPts);
+  if ( numPts < 1 )
+    {
+    return;
+    }
+
+  numThreads = ( numThreads > numPts ? static_cast<int>(numPts) :
+                 numThreads );
+  numThreads = ( numThreads < 1 ? 1 : numThreads );
+
+  if ( !rayParity && this->Internals->Normals.empty() )
+    {
+    vtkBVHComputePseudoNormals(this->Internals);
+    }
+
+  vtkBVHDistanceThreadStruct str;
+  str.BVH = this;
+  str.Internals = this->Internals;
+  str.Points = points;
+  str.Distances = distances->GetPointer(0);
+  str.RayParity = rayParity;
+  str.NumberOfThreads = numThreads;
+
+  threader->SetNumberOfThreads(numThreads);
+  threader->SetSingleMethod(vtkTriangleBVHSignedDistances, &str);
+  threader->SingleMethodExecute();
+}
+
+#undef VTK_BVH_BINS
+#undef VTK_BVH_PAIR_TASKS
+#undef VTK_BVH_RAY_TOLERANCE
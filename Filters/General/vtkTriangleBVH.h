@@ -0,0 +1,112 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    vtkTriangleBVH.h
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// .NAME vtkTriangleBVH - bounding volume hierarchy over mesh triangles
+// .SECTION Description
+// vtkTriangleBVH is a small utility class used by the surface intersection
+// and boolean filters (vtkIntersectionPolyDataFilter and
+// vtkBooleanOperationPolyDataFilter). It builds a binary hierarchy of
+// axis-aligned boxes over the triangles of a vtkPolyData, choosing every
+// split with the surface area heuristic (SAH) evaluated over a fixed number
+// of bins. The triangle coordinates are copied into the leaves, so that
+// queries do not touch the mesh and are safe to run from several threads
+// at once.
+//
+// The hierarchy answers three kinds of queries: pairs of triangles of two
+// hierarchies whose boxes overlap (candidates for triangle-triangle
+// intersection), closest point, and signed distance of points to the
+// surface. The pair and signed distance queries are batched and distributed
+// over a vtkMultiThreader.
+//
+// Only cells of type VTK_TRIANGLE are considered.
+// .SECTION See Also
+// vtkIntersectionPolyDataFilter vtkBooleanOperationPolyDataFilter vtkOBBTree
+
+#ifndef __vtkTriangleBVH_h
+#define __vtkTriangleBVH_h
+
+#include "vtkType.h" //for vtkIdType
+
+class vtkDoubleArray;
+class vtkIdTypeArray;
+class vtkMultiThreader;
+class vtkPoints;
+class vtkPolyData;
+class vtkTriangleBVHInternals;
+
+class vtkTriangleBVH
+{
+public:
+  vtkTriangleBVH();
+  ~vtkTriangleBVH();
+
+  // Description:
+  // Build the hierarchy over the triangles of the mesh. Leaves hold at most
+  // maxTrianglesPerLeaf triangles, unless their triangles cannot be told
+  // apart by their centroids.
+  void Build(vtkPolyData *mesh, int maxTrianglesPerLeaf);
+
+  // Description:
+  // Return the number of triangles in the hierarchy.
+  vtkIdType GetNumberOfTriangles();
+
+  // Description:
+  // Find all pairs of triangles, one from this hierarchy and one from the
+  // other, whose bounding boxes overlap once enlarged by the tolerance. The
+  // pairs are returned as (cell id, other cell id) tuples of a two
+  // component array. The traversal is split into a fixed set of tasks that
+  // are distributed over the threads, and the results of the tasks are
+  // concatenated in order: the output does not depend on the number of
+  // threads.
+  void FindOverlappingPairs(vtkTriangleBVH *other, double tolerance,
+                            vtkMultiThreader *threader, int numThreads,
+                            vtkIdTypeArray *pairs);
+
+  // Description:
+  // Find the closest point on the triangles to x. Returns the squared
+  // distance and sets the closest point and the id of the cell containing
+  // it (-1 if the hierarchy is empty).
+  double FindClosestPoint(const double x[3], double closest[3],
+                          vtkIdType &cellId);
+
+  // Description:
+  // Return 1 if x is inside the closed surface formed by the triangles, 0
+  // otherwise. The crossings of a ray with the surface are counted; rays
+  // that graze an edge or a vertex are cast again in another direction.
+  // When all the directions graze, x is classified by the side of the
+  // closest triangle it lies on, assuming the triangles face outward.
+  int IsInside(const double x[3]);
+
+  // Description:
+  // Compute the signed distance of every point to the surface: positive
+  // outside, negative inside. The points are distributed over the threads.
+  // By default the sign is given by the angle-weighted pseudonormal of the
+  // face, edge or vertex of the closest triangle the closest point lies on,
+  // as in vtkImplicitPolyDataDistance, which also applies to open surfaces.
+  // When rayParity is set, points are classified by IsInside() instead,
+  // which requires a closed surface but not consistently oriented
+  // triangles.
+  void ComputeSignedDistances(vtkPoints *points, vtkDoubleArray *distances,
+                              vtkMultiThreader *threader, int numThreads,
+                              int rayParity);
+
+private:
+  vtkTriangleBVHInternals *Internals;
+
+  vtkTriangleBVH(const vtkTriangleBVH&);  // Not implemented.
+  void operator=(const vtkTriangleBVH&);  // Not implemented.
+};
+
+#endif
+// VTK-HeaderTest-Exclude: vtkTriangleBVH.h
@@ -0,0 +1,176 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestTemporalCacheMemory.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// This tests that vtkTemporalDataSetCache keeps the least recently used time
+// steps within its memory limit, and counts the time steps found in the
+// cache and those read from the input.
+
+#include "vtkDoubleArray.h"
+#include "vtkInformation.h"
+#include "vtkInformationVector.h"
+#include "vtkObjectFactory.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "vtkPolyDataAlgorithm.h"
+#include "vtkSmartPointer.h"
+#include "vtkStreamingDemandDrivenPipeline.h"
+#include "vtkTemporalDataSetCache.h"
+
+//-------------------------------------------------------------------------
+// A point cloud at the time steps 0 to 9, whose first point is at x = t,
+// which counts how many times it executes
+//-------------------------------------------------------------------------
+class TestCountingSource : public vtkPolyDataAlgorithm
+{
+public:
+  static TestCountingSource *New();
+  vtkTypeMacro(TestCountingSource, vtkPolyDataAlgorithm);
+
+  int NumberOfExecutions;
+
+protected:
+  TestCountingSource()
+  {
+    this->NumberOfExecutions = 0;
+    this->SetNumberOfInputPorts(0);
+  }
+
+  int RequestInformation(vtkInformation *, vtkInformationVector **,
+                         vtkInformationVector *outputVector)
+  {
+    vtkInformation *outInfo = outputVector->GetInformationObject(0);
+    double timeSteps[10];
+    for (int i = 0; i < 10; ++i)
+      {
+      timeSteps[i] = i;
+      }
+    double range[2] = { 0.0, 9.0 };
+    outInfo->Set(vtkStreamingDemandDrivenPipeline::TIME_STEPS(),
+                 timeSteps, 10);
+    outInfo->Set(vtkStreamingDemandDrivenPipeline::TIME_RANGE(), range, 2);
+    return 1;
+  }
+
+  int RequestData(vtkInformation *, vtkInformationVector **,
+                  vtkInformationVector *outputVector)
+  {
+    vtkInformation *outInfo = outputVector->GetInformationObject(0);
+    vtkPolyData *output = vtkPolyData::GetData(outInfo);
+    double t = outInfo->Get(
+      vtkStreamingDemandDrivenPipeline::UPDATE_TIME_STEP());
+    this->NumberOfExecutions++;
+
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    vtkSmartPointer<vtkDoubleArray> values =
+      vtkSmartPointer<vtkDoubleArray>::New();
+    values->SetName("Values");
+    for (int i = 0; i < 2000; ++i)
+      {
+      points->InsertNextPoint(t + i, 0.0, 0.0);
+      values->InsertNextValue(t * i);
+      }
+    output->SetPoints(points);
+    output->GetPointData()->AddArray(values);
+    output->GetInformation()->Set(vtkDataObject::DATA_TIME_STEP(), t);
+    return 1;
+  }
+
+private:
+  TestCountingSource(const TestCountingSource&); // Not implemented.
+  void operator=(const TestCountingSource&);     // Not implemented.
+};
+
+vtkStandardNewMacro(TestCountingSource);
+
+static bool Request(vtkTemporalDataSetCache *cache, double t)
+{
+  cache->UpdateInformation();
+  vtkStreamingDemandDrivenPipeline::SetUpdateTimeStep(
+    cache->GetOutputInformation(0), t);
+  cache->Update();
+  vtkPolyData *output =
+    vtkPolyData::SafeDownCast(cache->GetOutputDataObject(0));
+  if (!output || output->GetNumberOfPoints() != 2000 ||
+      output->GetPoint(0)[0] != t ||
+      output->GetInformation()->Get(vtkDataObject::DATA_TIME_STEP()) != t)
+    {
+    std::cerr << "Error: wrong output at time " << t << std::endl;
+    return false;
+    }
+  return true;
+}
+
+static bool Check(vtkTemporalDataSetCache *cache, TestCountingSource *source,
+                  const char *name, int numExecutions, int numHits,
+                  int numMisses)
+{
+  if (source->NumberOfExecutions != numExecutions ||
+      cache->GetCacheHits() != numHits ||
+      cache->GetCacheMisses() != numMisses)
+    {
+    std::cerr << "Error: " << name << ": " << source->NumberOfExecutions
+              << " executions, " << cache->GetCacheHits() << " hits and "
+              << cache->GetCacheMisses() << " misses instead of "
+              << numExecutions << ", " << numHits << " and " << numMisses
+              << std::endl;
+    return false;
+    }
+  return true;
+}
+
+int TestTemporalCacheMemory(int, char*[])
+{
+  // Least recently used time steps within a memory limit of 3 time steps
+  vtkSmartPointer<TestCountingSource> source =
+    vtkSmartPointer<TestCountingSource>::New();
+  vtkSmartPointer<vtkTemporalDataSetCache> cache =
+    vtkSmartPointer<vtkTemporalDataSetCache>::New();
+  cache->SetInputConnection(source->GetOutputPort());
+  if (!Request(cache, 0.0))
+    {
+    return EXIT_FAILURE;
+    }
+  unsigned long stepSize = cache->GetCacheMemorySize();
+  cache->SetCacheMemoryLimit(3 * stepSize);
+  for (int t = 1; t < 10; ++t)
+    {
+    if (!Request(cache, t) || cache->GetCacheMemorySize() > 3 * stepSize)
+      {
+      std::cerr << "Error: " << cache->GetCacheMemorySize() << " KiB cached "
+                << "instead of " << 3 * stepSize << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  if (!Check(cache, source, "forward", 10, 0, 10) ||
+      !Request(cache, 7.0) || !Request(cache, 8.0) || !Request(cache, 9.0) ||
+      !Check(cache, source, "last steps", 10, 3, 10) ||
+      !Request(cache, 6.0) || !Request(cache, 8.0) ||
+      !Check(cache, source, "evicted step", 11, 4, 11) ||
+      !Request(cache, 7.0) ||
+      !Check(cache, source, "least recently used step", 12, 4, 12))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // The statistics restart from 0, the cached steps stay
+  cache->ResetCacheStatistics();
+  if (!Request(cache, 8.0) || !Request(cache, 2.0) ||
+      !Check(cache, source, "reset statistics", 13, 1, 1))
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,202 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestTemporalInterpolatorShared.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// This tests that vtkTemporalInterpolator passes exact time steps, and the
+// points and arrays shared by the time steps, without copying them, and
+// that it interpolates the other arrays the same whatever the number of
+// threads.
+
+#include "vtkCellArray.h"
+#include "vtkCellData.h"
+#include "vtkDoubleArray.h"
+#include "vtkFloatArray.h"
+#include "vtkInformation.h"
+#include "vtkInformationVector.h"
+#include "vtkIntArray.h"
+#include "vtkObjectFactory.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkPolyDataAlgorithm.h"
+#include "vtkPolyData.h"
+#include "vtkSmartPointer.h"
+#include "vtkStreamingDemandDrivenPipeline.h"
+#include "vtkTemporalInterpolator.h"
+
+#include <cmath>
+
+#define NUMBER_OF_POINTS 100000
+
+//-------------------------------------------------------------------------
+// A point cloud with static points and a static array, and a point and a
+// cell array changing with time, at the time steps 0, 1, 2 and 3
+//-------------------------------------------------------------------------
+class TestStaticArraysSource : public vtkPolyDataAlgorithm
+{
+public:
+  static TestStaticArraysSource *New();
+  vtkTypeMacro(TestStaticArraysSource, vtkPolyDataAlgorithm);
+
+  vtkSmartPointer<vtkPoints> Points;
+  vtkSmartPointer<vtkIntArray> Static;
+
+  static double Value(vtkIdType i, int c, double t)
+  {
+    return std::sin(0.001 * i + c) * (1.0 + t * t);
+  }
+
+protected:
+  TestStaticArraysSource()
+  {
+    this->SetNumberOfInputPorts(0);
+    this->Points = vtkSmartPointer<vtkPoints>::New();
+    this->Static = vtkSmartPointer<vtkIntArray>::New();
+    this->Static->SetName("Static");
+    for (vtkIdType i = 0; i < NUMBER_OF_POINTS; ++i)
+      {
+      this->Points->InsertNextPoint(0.001 * i, std::sin(0.01 * i), 0.0);
+      this->Static->InsertNextValue(static_cast<int>(i % 7));
+      }
+  }
+
+  int RequestInformation(vtkInformation *, vtkInformationVector **,
+                         vtkInformationVector *outputVector)
+  {
+    vtkInformation *outInfo = outputVector->GetInformationObject(0);
+    double timeSteps[4] = { 0.0, 1.0, 2.0, 3.0 };
+    double range[2] = { 0.0, 3.0 };
+    outInfo->Set(vtkStreamingDemandDrivenPipeline::TIME_STEPS(),
+                 timeSteps, 4);
+    outInfo->Set(vtkStreamingDemandDrivenPipeline::TIME_RANGE(), range, 2);
+    return 1;
+  }
+
+  int RequestData(vtkInformation *, vtkInformationVector **,
+                  vtkInformationVector *outputVector)
+  {
+    vtkInformation *outInfo = outputVector->GetInformationObject(0);
+    vtkPolyData *output = vtkPolyData::GetData(outInfo);
+    double t = outInfo->Get(
+      vtkStreamingDemandDrivenPipeline::UPDATE_TIME_STEP());
+
+    vtkSmartPointer<vtkDoubleArray> dynamic =
+      vtkSmartPointer<vtkDoubleArray>::New();
+    dynamic->SetName("Dynamic");
+    dynamic->SetNumberOfComponents(3);
+    dynamic->SetNumberOfTuples(NUMBER_OF_POINTS);
+    for (vtkIdType i = 0; i < NUMBER_OF_POINTS; ++i)
+      {
+      for (int c = 0; c < 3; ++c)
+        {
+        dynamic->SetComponent(i, c, Value(i, c, t));
+        }
+      }
+    vtkSmartPointer<vtkFloatArray> cellValues =
+      vtkSmartPointer<vtkFloatArray>::New();
+    cellValues->SetName("CellValues");
+    cellValues->InsertNextValue(static_cast<float>(t));
+
+    vtkSmartPointer<vtkCellArray> verts = vtkSmartPointer<vtkCellArray>::New();
+    verts->InsertNextCell(1);
+    verts->InsertCellPoint(0);
+    output->SetPoints(this->Points);
+    output->SetVerts(verts);
+    output->GetPointData()->AddArray(this->Static);
+    output->GetPointData()->AddArray(dynamic);
+    output->GetCellData()->AddArray(cellValues);
+    output->GetInformation()->Set(vtkDataObject::DATA_TIME_STEP(), t);
+    return 1;
+  }
+
+private:
+  TestStaticArraysSource(const TestStaticArraysSource&); // Not implemented.
+  void operator=(const TestStaticArraysSource&);         // Not implemented.
+};
+
+vtkStandardNewMacro(TestStaticArraysSource);
+
+static vtkSmartPointer<vtkPolyData> Interpolate(TestStaticArraysSource *source,
+                                                double t, int numThreads)
+{
+  vtkSmartPointer<vtkTemporalInterpolator> interpolator =
+    vtkSmartPointer<vtkTemporalInterpolator>::New();
+  interpolator->SetInputConnection(source->GetOutputPort());
+  interpolator->SetNumberOfThreads(numThreads);
+  interpolator->UpdateInformation();
+  vtkStreamingDemandDrivenPipeline::SetUpdateTimeStep(
+    interpolator->GetOutputInformation(0), t);
+  interpolator->Update();
+  vtkSmartPointer<vtkPolyData> output =
+    vtkPolyData::SafeDownCast(interpolator->GetOutputDataObject(0));
+  return output;
+}
+
+int TestTemporalInterpolatorShared(int, char*[])
+{
+  vtkSmartPointer<TestStaticArraysSource> source =
+    vtkSmartPointer<TestStaticArraysSource>::New();
+
+  double times[3] = { 1.0, 1.25, 2.8 };
+  for (int i = 0; i < 3; ++i)
+    {
+    double t = times[i];
+    vtkSmartPointer<vtkPolyData> serial = Interpolate(source, t, 1);
+    vtkSmartPointer<vtkPolyData> threaded = Interpolate(source, t, 4);
+    vtkPolyData *outputs[2] = { serial, threaded };
+    for (int o = 0; o < 2; ++o)
+      {
+      vtkPolyData *output = outputs[o];
+      if (!output || output->GetPoints() != source->Points.GetPointer() ||
+          output->GetPointData()->GetArray("Static") !=
+          source->Static.GetPointer())
+        {
+        std::cerr << "Error: the static points or array are copied at time "
+                  << t << std::endl;
+        return EXIT_FAILURE;
+        }
+
+      vtkDataArray *dynamic = output->GetPointData()->GetArray("Dynamic");
+      vtkDataArray *cellValues = output->GetCellData()->GetArray("CellValues");
+      if (!dynamic || dynamic->GetNumberOfTuples() != NUMBER_OF_POINTS ||
+          !cellValues || std::fabs(cellValues->GetComponent(0, 0) - t) > 1e-6)
+        {
+        std::cerr << "Error: wrong arrays at time " << t << std::endl;
+        return EXIT_FAILURE;
+        }
+      double t0 = std::floor(t);
+      for (vtkIdType p = 0; p < NUMBER_OF_POINTS; ++p)
+        {
+        for (int c = 0; c < 3; ++c)
+          {
+          // linear between the time steps
+          double expected = TestStaticArraysSource::Value(p, c, t0) +
+            (t - t0) * (TestStaticArraysSource::Value(p, c, t0 + 1.0) -
+                        TestStaticArraysSource::Value(p, c, t0));
+          double value = dynamic->GetComponent(p, c);
+          if ((t == t0 && value != expected) ||
+              std::fabs(value - expected) > 1e-9 ||
+              value != serial->GetPointData()->GetArray("Dynamic")->
+                GetComponent(p, c))
+            {
+            std::cerr << "Error: value " << p << ", " << c << " is " << value
+                      << " instead of " << expected << " at time " << t
+                      << std::endl;
+            return EXIT_FAILURE;
+            }
+          }
+        }
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
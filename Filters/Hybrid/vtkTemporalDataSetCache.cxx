@@ -22,18 +22,33 @@
 #include "vtkCompositeDataSet.h"
 #include "vtkCompositeDataIterator.h"
 #include "vtkSmartPointer.h"
+#include "vtkTimeStamp.h"
 
 #include <vector>
 
 //---------------------------------------------------------------------------
 vtkStandardNewMacro(vtkTemporalDataSetCache);
 
+//----------------------------------------------------------------------------
+// A new access time, more recent than any modification so far, so that the
+// cache entries stay valid until the pipeline is modified, and ordered by
+// their last use.
+static unsigned long vtkTemporalDataSetCacheNewAccessTime()
+{
+  vtkTimeStamp stamp;
+  stamp.Modified();
+  return stamp.GetMTime();
+}
 
 //----------------------------------------------------------------------------
 //----------------------------------------------------------------------------
 vtkTemporalDataSetCache::vtkTemporalDataSetCache()
 {
   this->CacheSize = 10;
+  this->CacheMemoryLimit = 0;
+  this->CacheHits = 0;
+  this->CacheMisses = 0;
+  this->CacheMemorySize = 0;
   this->SetNumberOfInputPorts(1);
   this->SetNumberOfOutputPorts(1);
 }
@@ -44,8 +59,7 @@ vtkTemporalDataSetCache::~vtkTemporalDataSetCache()
   CacheType::iterator pos = this->Cache.begin();
   for (; pos != this->Cache.end();)
     {
-    pos->second.second->UnRegister(this);
-    this->Cache.erase(pos++);
+    this->RemoveFromCache(pos++);
     }
 }
 
@@ -103,6 +117,10 @@ void vtkTemporalDataSetCache::PrintSelf(ostream& os, vtkIndent indent)
   this->Superclass::PrintSelf(os,indent);
 
   os << indent << "CacheSize: " << this->CacheSize << endl;
+  os << indent << "CacheMemoryLimit: " << this->CacheMemoryLimit << endl;
+  os << indent << "CacheHits: " << this->CacheHits << endl;
+  os << indent << "CacheMisses: " << this->CacheMisses << endl;
+  os << indent << "CacheMemorySize: " << this->CacheMemorySize << endl;
 }
 //----------------------------------------------------------------------------
 void vtkTemporalDataSetCache::SetCacheSize(int size)
@@ -113,24 +131,85 @@ void vtkTemporalDataSetCache::SetCacheSize(int size)
     return;
     }
 
-  // if growing the cache, there is no need to do anything
+  // if shrinking, get rid of the least recently used data
   this->CacheSize = size;
-  if (this->Cache.size() <= static_cast<unsigned long>(size))
+  this->TrimCache(VTK_UNSIGNED_LONG_MAX);
+}
+
+//----------------------------------------------------------------------------
+void vtkTemporalDataSetCache::SetCacheMemoryLimit(unsigned long limit)
+{
+  this->CacheMemoryLimit = limit;
+  this->TrimCache(VTK_UNSIGNED_LONG_MAX);
+}
+
+//----------------------------------------------------------------------------
+void vtkTemporalDataSetCache::ResetCacheStatistics()
+{
+  this->CacheHits = 0;
+  this->CacheMisses = 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkTemporalDataSetCache::RemoveFromCache(CacheType::iterator pos)
+{
+  this->CacheMemorySize -= pos->second.MemorySize;
+  pos->second.Data->UnRegister(this);
+  this->Cache.erase(pos);
+}
+
+//----------------------------------------------------------------------------
+void vtkTemporalDataSetCache::TrimCache(unsigned long accessTime)
+{
+  while (this->Cache.size() > static_cast<size_t>(this->CacheSize) ||
+         (this->CacheMemoryLimit > 0 &&
+          this->CacheMemorySize > this->CacheMemoryLimit))
     {
-    return;
+    // get rid of the least recently used data, if it was not used since
+    // accessTime
+    CacheType::iterator oldestpos = this->Cache.end();
+    CacheType::iterator pos = this->Cache.begin();
+    for (; pos != this->Cache.end(); ++pos)
+      {
+      if (pos->second.AccessTime < accessTime &&
+          (oldestpos == this->Cache.end() ||
+           pos->second.AccessTime < oldestpos->second.AccessTime))
+        {
+        oldestpos = pos;
+        }
+      }
+    if (oldestpos == this->Cache.end())
+      {
+      return;
+      }
+    this->RemoveFromCache(oldestpos);
     }
+}
 
-  // skrinking, have to get rid of some old data, to be easy just chuck the
-  // first entries
-  int i = static_cast<int>(this->Cache.size()) - size;
-  CacheType::iterator pos = this->Cache.begin();
-  for (; i > 0; --i)
+//----------------------------------------------------------------------------
+int vtkTemporalDataSetCache::AddToCache(double time, vtkDataObject *data)
+{
+  CacheEntry entry;
+  entry.AccessTime = vtkTemporalDataSetCacheNewAccessTime();
+  entry.Data = data->NewInstance();
+  entry.Data->ShallowCopy(data);
+  entry.MemorySize = entry.Data->GetActualMemorySize();
+  this->Cache[time] = entry;
+  this->CacheMemorySize += entry.MemorySize;
+
+  // make room for it, or give up if it does not fit on its own
+  this->TrimCache(entry.AccessTime);
+  if (this->Cache.size() > static_cast<size_t>(this->CacheSize) ||
+      (this->CacheMemoryLimit > 0 &&
+       this->CacheMemorySize > this->CacheMemoryLimit))
     {
-    pos->second.second->UnRegister(this);
-    this->Cache.erase(pos++);
+    this->RemoveFromCache(this->Cache.find(time));
+    return 0;
     }
+  return 1;
 }
 
+//----------------------------------------------------------------------------
 int vtkTemporalDataSetCache::RequestDataObject( vtkInformation*,
                                              vtkInformationVector** inputVector ,
                                              vtkInformationVector* outputVector)
@@ -190,10 +269,9 @@ int vtkTemporalDataSetCache
   unsigned long pmt = ddp->GetPipelineMTime();
   for (pos = this->Cache.begin(); pos != this->Cache.end();)
     {
-    if (pos->second.first < pmt)
+    if (pos->second.AccessTime < pmt)
       {
-      pos->second.second->Delete();
-      this->Cache.erase(pos++);
+      this->RemoveFromCache(pos++);
       }
     else
       {
@@ -274,16 +352,13 @@ int vtkTemporalDataSetCache::RequestData(
   vtkInformation     *outInfo = outputVector->GetInformationObject(0);
   vtkDataObject       *output = NULL;
 
-  unsigned long outputUpdateTime = outInfo->Get(vtkDataObject::DATA_OBJECT())->GetUpdateTime();
-
   vtkDataObject *input = inInfo->Get(vtkDataObject::DATA_OBJECT());
+  double inTime =  input->GetInformation()->Get(vtkDataObject::DATA_TIME_STEP());
 
   // get some time informationX
   double upTime =
     outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_TIME_STEP());
 
-  double inTime =  input->GetInformation()->Get(vtkDataObject::DATA_TIME_STEP());
-
   // // fill in the request by using the cached data and input data
   // outData->Initialize();
 
@@ -291,28 +366,30 @@ int vtkTemporalDataSetCache::RequestData(
   CacheType::iterator pos = this->Cache.find(upTime);
   if (pos != this->Cache.end())
     {
-    vtkDataObject* cachedData = pos->second.second;
+    vtkDataObject* cachedData = pos->second.Data;
     output = cachedData->NewInstance();
     output->ShallowCopy(cachedData);
 //  outData->SetTimeStep(0, pos->second.second);
-    // update the m time in the cache
-    pos->second.first = outputUpdateTime;
+    // update the access time in the cache
+    pos->second.AccessTime = vtkTemporalDataSetCacheNewAccessTime();
+    this->CacheHits++;
     }
   // otherwise it better be in the input
   else
     {
-    int found = 0;
+    this->CacheMisses++;
     if(input->GetInformation()->Has(vtkDataObject::DATA_TIME_STEP()))
       {
       if (inTime == upTime)
         {
         output = input->NewInstance();
         output->ShallowCopy(input);
-        found = 1;
         }
       }
-    if (!found)
+    if (!output)
       {
+      vtkErrorMacro("The input does not have the requested time " << upTime);
+      return 0;
       }
     }
   // set the data times
@@ -321,46 +398,10 @@ int vtkTemporalDataSetCache::RequestData(
   output->GetInformation()->Set(vtkDataObject::DATA_TIME_STEP(), upTime);
 
   // now we need to update the cache, based on the new data and the cache
-  // size add the requested data to the cache first
-  if(input->GetInformation()->Has(vtkDataObject::DATA_TIME_STEP()))
+  // limits, add the requested data to the cache first
+  if (pos == this->Cache.end())
     {
-
-// is the input time not already in the cache?
-    CacheType::iterator pos1 = this->Cache.find(inTime);
-    if (pos1 == this->Cache.end())
-      {
-      // if we have room in the Cache then just add the new data
-      if (this->Cache.size() < static_cast<unsigned long>(this->CacheSize))
-        {
-        vtkDataObject* cachedData  = input->NewInstance();
-        cachedData->ShallowCopy(input);
-
-        this->Cache[inTime] =
-          std::pair<unsigned long, vtkDataObject *>
-          (outputUpdateTime, cachedData);
-        }
-      // no room in the cache, we need to get rid of something
-      else
-        {
-        // get rid of the oldest data in the cache
-        CacheType::iterator pos2 = this->Cache.begin();
-        CacheType::iterator oldestpos = this->Cache.begin();
-        for (; pos2 != this->Cache.end(); ++pos2)
-          {
-          if (pos2->second.first < oldestpos->second.first)
-            {
-            oldestpos = pos2;
-            }
-          }
-        //was there old data?
-        if (oldestpos->second.first < outputUpdateTime)
-          {
-          oldestpos->second.second->UnRegister(this);
-          this->Cache.erase(oldestpos);
-          }
-        // if no old data and no room then we are done
-        }
-      }
+    this->AddToCache(inTime, input);
     }
   return 1;
 }
@@ -16,6 +16,8 @@
 // .SECTION Description
 // vtkTemporalDataSetCache cache time step requests of a temporal dataset,
 // when cached data is requested it is returned using a shallow copy.
+// The cache is bounded by a number of time steps and optionally by an amount
+// of memory, and the least recently used time steps are removed first.
 // .SECTION Thanks
 // Ken Martin (Kitware) and John Bidiscombe of
 // CSCS - Swiss National Supercomputing Centre
@@ -46,18 +48,59 @@ public:
   void SetCacheSize(int size);
   vtkGetMacro(CacheSize,int);
 
+  // Description:
+  // This is the maximum amount of memory, in kibibytes, that the time steps
+  // retained in memory may use, as given by
+  // vtkDataObject::GetActualMemorySize(). Data shared by several time steps
+  // is counted for each of them. It defaults to 0, which means no limit.
+  void SetCacheMemoryLimit(unsigned long limit);
+  vtkGetMacro(CacheMemoryLimit,unsigned long);
+
+  // Description:
+  // Statistics of the cache: the number of requested time steps found in
+  // the cache and of those read from the input, and the memory used by the
+  // cached time steps, in kibibytes.
+  vtkGetMacro(CacheHits,int);
+  vtkGetMacro(CacheMisses,int);
+  vtkGetMacro(CacheMemorySize,unsigned long);
+  void ResetCacheStatistics();
+
 protected:
   vtkTemporalDataSetCache();
   ~vtkTemporalDataSetCache();
 
   int CacheSize;
+  unsigned long CacheMemoryLimit;
+
+  int CacheHits;
+  int CacheMisses;
+  unsigned long CacheMemorySize;
 
 //BTX
-  typedef std::map<double,std::pair<unsigned long,vtkDataObject *> >
-  CacheType;
+  struct CacheEntry
+  {
+    unsigned long AccessTime;
+    unsigned long MemorySize;
+    vtkDataObject *Data;
+  };
+  typedef std::map<double,CacheEntry> CacheType;
   CacheType Cache;
+
+  // Remove an entry and update the memory used by the cache
+  void RemoveFromCache(CacheType::iterator pos);
 //ETX
 
+  // Description:
+  // Add a shallow copy of data to the cache, removing the least recently
+  // used entries to make room for it. Return 0 when it does not fit in the
+  // cache.
+  int AddToCache(double time, vtkDataObject *data);
+
+  // Description:
+  // Remove the least recently used entries accessed before the given time,
+  // until the cache is within its limits.
+  void TrimCache(unsigned long accessTime);
+
 
   // Description:
   // see vtkAlgorithm for details
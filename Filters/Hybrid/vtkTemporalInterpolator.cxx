@@ -21,6 +21,7 @@
 #include "vtkFloatArray.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
 #include "vtkPointSet.h"
@@ -34,6 +35,9 @@
 
 vtkStandardNewMacro(vtkTemporalInterpolator);
 
+// Arrays with fewer values per thread are interpolated by less threads
+#define VTK_TEMPORAL_INTERPOLATOR_VALUES_PER_THREAD 65536
+
 //----------------------------------------------------------------------------
 vtkTemporalInterpolator::vtkTemporalInterpolator()
 {
@@ -42,6 +46,8 @@ vtkTemporalInterpolator::vtkTemporalInterpolator()
   this->Ratio  = 0.0;
   this->DeltaT = 0.0;
   this->Tfrac  = 0.0;
+  this->Threader = vtkMultiThreader::New();
+  this->NumberOfThreads = this->Threader->GetNumberOfThreads();
 
   this->SetNumberOfInputPorts(1);
   this->SetNumberOfOutputPorts(1);
@@ -51,6 +57,7 @@ vtkTemporalInterpolator::vtkTemporalInterpolator()
 //----------------------------------------------------------------------------
 vtkTemporalInterpolator::~vtkTemporalInterpolator()
 {
+  this->Threader->Delete();
 }
 
 //----------------------------------------------------------------------------
@@ -62,6 +69,8 @@ void vtkTemporalInterpolator::PrintSelf(ostream& os, vtkIndent indent)
      << this->ResampleFactor << "\n";
   os << indent << "DiscreteTimeStepInterval: "
      << this->DiscreteTimeStepInterval << "\n";
+  os << indent << "NumberOfThreads: "
+     << this->NumberOfThreads << "\n";
 }
 
 //----------------------------------------------------------------------------
@@ -223,16 +232,19 @@ int vtkTemporalInterpolator::RequestData(
   vtkMultiBlockDataSet *inData = vtkMultiBlockDataSet::SafeDownCast(inInfo->Get(vtkDataObject::DATA_OBJECT()));
   int numTimeSteps  = inData->GetNumberOfBlocks();
 
-  // below the range
+  // out of the range, or exactly on a time step
   if (numTimeSteps==1)
     {
-    // pass the lowest data
-    outData = inData->GetBlock(0);
-    if (outData->GetInformation()->Has(vtkDataObject::DATA_GEOMETRY_UNMODIFIED()))
+    // pass the data without copying its arrays
+    vtkDataObject *data0 = inData->GetBlock(0);
+    outData = data0->NewInstance();
+    outData->ShallowCopy(data0);
+    if (data0->GetInformation()->Has(vtkDataObject::DATA_GEOMETRY_UNMODIFIED()))
       {
       outData->GetInformation()->Set(vtkDataObject::DATA_GEOMETRY_UNMODIFIED(),1);
       }
     outInfo->Set(vtkDataObject::DATA_OBJECT(),outData);
+    outData->Delete();
     }
   else
     {
@@ -319,7 +331,11 @@ int vtkTemporalInterpolator::RequestUpdateExtent (
           {
           ++i;
           }
-        inUpTimes[numInUpTimes++] = inTimes[i-1];
+        // a time step matching exactly needs no interpolation
+        if (upTime < inTimes[i])
+          {
+          inUpTimes[numInUpTimes++] = inTimes[i-1];
+          }
         inUpTimes[numInUpTimes++] = inTimes[i];
         }
 
@@ -351,6 +367,28 @@ bool vtkTemporalInterpolator
   return true;
 }
 
+//----------------------------------------------------------------------------
+bool vtkTemporalInterpolator
+::SharedArrays(vtkDataArray **arrays, int N)
+{
+  for (int i=1; i<N; ++i)
+    {
+    if (arrays[i]==arrays[0])
+      {
+      continue;
+      }
+    if (arrays[i]->GetDataType()!=arrays[0]->GetDataType() ||
+        arrays[i]->GetNumberOfComponents()!=arrays[0]->GetNumberOfComponents() ||
+        arrays[i]->GetNumberOfTuples()!=arrays[0]->GetNumberOfTuples() ||
+        arrays[0]->GetNumberOfTuples()==0 ||
+        arrays[i]->GetVoidPointer(0)!=arrays[0]->GetVoidPointer(0))
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
 //----------------------------------------------------------------------------
 vtkDataObject *vtkTemporalInterpolator
 ::InterpolateDataObject( vtkDataObject *in1, vtkDataObject *in2, double ratio)
@@ -427,6 +465,20 @@ vtkDataSet *vtkTemporalInterpolator
 
   //
   vtkDataSet *output = input[0]->NewInstance();
+  //
+  // The same dataset at both time steps, or a ratio matching one time
+  // step exactly, is passed through without copying its arrays
+  //
+  if (in1==in2 || ratio==0.0 || ratio==1.0)
+    {
+    output->ShallowCopy(ratio==1.0 ? in2 : in1);
+    if (in1->GetInformation()->Has(vtkDataObject::DATA_GEOMETRY_UNMODIFIED()) &&
+        in2->GetInformation()->Has(vtkDataObject::DATA_GEOMETRY_UNMODIFIED()))
+      {
+      output->GetInformation()->Set(vtkDataObject::DATA_GEOMETRY_UNMODIFIED(),1);
+      }
+    return output;
+    }
   output->CopyStructure(input[0]);
   //
   // Interpolate points if the dataset is a vtkPointSet
@@ -434,7 +486,16 @@ vtkDataSet *vtkTemporalInterpolator
   vtkPointSet *inPointSet1 = vtkPointSet::SafeDownCast(input[0]);
   vtkPointSet *inPointSet2 = vtkPointSet::SafeDownCast(input[1]);
   vtkPointSet *outPointSet = vtkPointSet::SafeDownCast(output);
-  if (inPointSet1 && inPointSet2)
+  vtkDataArray *pointArrays[2] = { NULL, NULL };
+  if (inPointSet1 && inPointSet2 &&
+      inPointSet1->GetNumberOfPoints()>0 && inPointSet2->GetNumberOfPoints()>0)
+    {
+    pointArrays[0] = inPointSet1->GetPoints()->GetData();
+    pointArrays[1] = inPointSet2->GetPoints()->GetData();
+    }
+  // static points are kept from the structure of the first time step
+  if (inPointSet1 && inPointSet2 &&
+      !(pointArrays[0] && this->SharedArrays(pointArrays, 2)))
     {
     vtkDataArray *outarray = NULL;
     vtkPoints *outpoints;
@@ -504,7 +565,7 @@ vtkDataSet *vtkTemporalInterpolator
       if (i==0 || (scalarname==NULL))
         {
         vtkDataArray *dataarray = input[i]->GetPointData()->GetArray(s);
-        scalarname = dataarray->GetName();
+        scalarname = dataarray ? dataarray->GetName() : NULL;
         arrays.push_back(dataarray);
         }
       else
@@ -514,6 +575,12 @@ vtkDataSet *vtkTemporalInterpolator
         arrays.push_back(dataarray);
         }
       }
+    // non numeric arrays are passed from the first time step, as well as
+    // the arrays shared by both time steps
+    if (!arrays[0] || !arrays[1] || this->SharedArrays(&arrays[0], 2))
+      {
+      continue;
+      }
     // do a quick check to see if all arrays have the same number of tuples
     if (!this->VerifyArrays(&arrays[0], 2))
       {
@@ -521,13 +588,17 @@ vtkDataSet *vtkTemporalInterpolator
         << (scalarname ? scalarname : "(unnamed array)")
         << " because the number of tuples/components"
         << " in each time step are different");
+      continue;
       }
     // allocate double for output if input is double - otherwise float
     vtkDataArray *outarray =
       this->InterpolateDataArray(ratio, &arrays[0],
                                  arrays[0]->GetNumberOfTuples());
-    output->GetPointData()->AddArray(outarray);
-    outarray->Delete();
+    if (outarray)
+      {
+      output->GetPointData()->AddArray(outarray);
+      outarray->Delete();
+      }
     }
   //
   // Interpolate celldata if present
@@ -548,7 +619,7 @@ vtkDataSet *vtkTemporalInterpolator
       if (i==0 || (scalarname==NULL))
         {
         vtkDataArray *dataarray = input[i]->GetCellData()->GetArray(s);
-        scalarname = dataarray->GetName();
+        scalarname = dataarray ? dataarray->GetName() : NULL;
         arrays.push_back(dataarray);
         }
       else
@@ -558,6 +629,12 @@ vtkDataSet *vtkTemporalInterpolator
         arrays.push_back(dataarray);
         }
       }
+    // non numeric arrays are passed from the first time step, as well as
+    // the arrays shared by both time steps
+    if (!arrays[0] || !arrays[1] || this->SharedArrays(&arrays[0], 2))
+      {
+      continue;
+      }
     // do a quick check to see if all arrays have the same number of tuples
     if (!this->VerifyArrays(&arrays[0], 2))
       {
@@ -565,13 +642,17 @@ vtkDataSet *vtkTemporalInterpolator
                       << (scalarname ? scalarname : "(unnamed array)")
                       << " because the number of tuples/components"
                       << " in each time step are different");
+      continue;
       }
     // allocate double for output if input is double - otherwise float
     vtkDataArray *outarray =
       this->InterpolateDataArray(ratio, &arrays[0],
                                  arrays[0]->GetNumberOfTuples());
-    output->GetCellData()->AddArray(outarray);
-    outarray->Delete();
+    if (outarray)
+      {
+      output->GetCellData()->AddArray(outarray);
+      outarray->Delete();
+      }
     }
   if (in1->GetInformation()->Has(vtkDataObject::DATA_GEOMETRY_UNMODIFIED()) &&
       in2->GetInformation()->Has(vtkDataObject::DATA_GEOMETRY_UNMODIFIED()))
@@ -583,30 +664,61 @@ vtkDataSet *vtkTemporalInterpolator
 
 
 //----------------------------------------------------------------------------
-// This templated function executes the filter for any type of data.
+// This templated function interpolates the values begin to end of the
+// arrays, for any type of data.
 template <class T>
-void vtkTemporalInterpolatorExecute(vtkTemporalInterpolator *,
-                                    double ratio,
+void vtkTemporalInterpolatorExecute(double ratio,
                                     vtkDataArray *output,
                                     vtkDataArray **arrays,
-                                    int numComp,
-                                    int numTuple,
+                                    vtkIdType begin,
+                                    vtkIdType end,
                                     T *)
 {
   T *outData = static_cast<T*>(output->GetVoidPointer(0));
-  T *inData0 = static_cast<T*>(arrays[0]->GetVoidPointer(0));
-  T *inData1 = static_cast<T*>(arrays[1]->GetVoidPointer(0));
+  const T *inData0 = static_cast<T*>(arrays[0]->GetVoidPointer(0));
+  const T *inData1 = static_cast<T*>(arrays[1]->GetVoidPointer(0));
 
   double oneMinusRatio = 1.0 - ratio;
 
-  unsigned long idx;
-  for (idx = 0; idx < static_cast<unsigned long>(numTuple*numComp); ++idx)
+  for (vtkIdType idx = begin; idx < end; ++idx)
     {
-    *outData = static_cast<T>((*inData0)*oneMinusRatio + (*inData1)*ratio);
-    outData++;
-    inData0++;
-    inData1++;
-  }
+    outData[idx] =
+      static_cast<T>(inData0[idx]*oneMinusRatio + inData1[idx]*ratio);
+    }
+}
+
+//----------------------------------------------------------------------------
+struct vtkTemporalInterpolatorThreadStruct
+{
+  double Ratio;
+  vtkDataArray *Output;
+  vtkDataArray **Arrays;
+  vtkIdType NumberOfValues;
+  int NumberOfThreads;
+};
+
+//----------------------------------------------------------------------------
+// Each thread interpolates a contiguous range of the values.
+static VTK_THREAD_RETURN_TYPE vtkTemporalInterpolatorThreadedExecute(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkTemporalInterpolatorThreadStruct *str =
+    static_cast<vtkTemporalInterpolatorThreadStruct *>(info->UserData);
+
+  vtkIdType begin = str->NumberOfValues * info->ThreadID /
+    str->NumberOfThreads;
+  vtkIdType end = str->NumberOfValues * (info->ThreadID + 1) /
+    str->NumberOfThreads;
+
+  switch (str->Output->GetDataType())
+    {
+    vtkTemplateMacro(vtkTemporalInterpolatorExecute
+                     (str->Ratio, str->Output, str->Arrays, begin, end,
+                      static_cast<VTK_TT *>(0)));
+    }
+
+  return VTK_THREAD_RETURN_VALUE;
 }
 
 
@@ -629,14 +741,35 @@ vtkDataArray *vtkTemporalInterpolator
   output->SetNumberOfTuples(N);
   output->SetName(arrays[0]->GetName());
 
-  // now do the interpolation
+  // now do the interpolation, split among the threads for large arrays
+  // of the types handled through their pointers
+  vtkTemporalInterpolatorThreadStruct str;
+  str.Ratio = ratio;
+  str.Output = output;
+  str.Arrays = arrays;
+  str.NumberOfValues = N * Nc;
+  vtkIdType maxThreads =
+    str.NumberOfValues / VTK_TEMPORAL_INTERPOLATOR_VALUES_PER_THREAD;
+  str.NumberOfThreads = ( maxThreads < this->NumberOfThreads ?
+                          static_cast<int>(maxThreads) :
+                          this->NumberOfThreads );
+  if (str.NumberOfThreads > 1 && arrays[0]->GetDataType() != VTK_BIT)
+    {
+    this->Threader->SetNumberOfThreads(str.NumberOfThreads);
+    this->Threader->SetSingleMethod(vtkTemporalInterpolatorThreadedExecute,
+                                    &str);
+    this->Threader->SingleMethodExecute();
+    return output;
+    }
+
   switch (arrays[0]->GetDataType())
     {
     vtkTemplateMacro(vtkTemporalInterpolatorExecute
-                     (this, ratio, output, arrays, Nc, N,
+                     (ratio, output, arrays, 0, str.NumberOfValues,
                       static_cast<VTK_TT *>(0)));
     default:
       vtkErrorMacro(<< "Execute: Unknown ScalarType");
+      output->Delete();
       return 0;
     }
 
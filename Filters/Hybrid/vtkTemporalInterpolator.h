@@ -36,6 +36,12 @@
 // will produce an irregular sequence of regular steps between
 // each of the original irregular steps (clear enough, yes?).
 //
+// A requested time matching an input time step exactly is passed through
+// as a shallow copy of that step, without interpolation. Arrays (and
+// points) shared by both time steps, i.e. the same array or arrays sharing
+// the same memory, are passed through as well. The other arrays are
+// interpolated with several threads.
+//
 // @TODO
 // Higher order interpolation schemes will require changes to the API
 // as most calls assume only two timesteps are used.
@@ -56,6 +62,7 @@
 #include "vtkMultiTimeStepAlgorithm.h"
 
 class vtkDataSet;
+class vtkMultiThreader;
 class VTKFILTERSHYBRID_EXPORT vtkTemporalInterpolator : public vtkMultiTimeStepAlgorithm
 {
 public:
@@ -85,6 +92,13 @@ public:
   vtkSetMacro(ResampleFactor, int);
   vtkGetMacro(ResampleFactor, int);
 
+  // Description:
+  // Set/Get the number of threads used to interpolate the arrays. Large
+  // arrays are split among the threads, small ones are interpolated by a
+  // single thread. Defaults to the number of available processors.
+  vtkSetClampMacro(NumberOfThreads, int, 1, VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads, int);
+
 protected:
   vtkTemporalInterpolator();
   ~vtkTemporalInterpolator();
@@ -92,6 +106,8 @@ protected:
 
   double DiscreteTimeStepInterval;
   int    ResampleFactor;
+  int    NumberOfThreads;
+  vtkMultiThreader *Threader;
 
   virtual int FillInputPortInformation(int port, vtkInformation* info);
   virtual int FillOutputPortInformation(int vtkNotUsed(port), vtkInformation* info);
@@ -139,6 +155,12 @@ protected:
   // each data array has the same number of tuples/components etc
   virtual bool VerifyArrays(vtkDataArray **arrays, int N);
 
+  // Description:
+  // Return whether the arrays of each time step hold the same values
+  // because they are the same array, or share the same memory, in which
+  // case they are passed through instead of being interpolated.
+  virtual bool SharedArrays(vtkDataArray **arrays, int N);
+
   // internally used : Ratio is {0,1} between two time steps
   // DeltaT is time between current 2 steps.
   // These are only valid when 2 time steps are interpolated
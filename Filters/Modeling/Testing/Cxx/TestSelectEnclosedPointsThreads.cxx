@@ -0,0 +1,176 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestSelectEnclosedPointsThreads.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// This tests that vtkSelectEnclosedPoints selects the same points whatever
+// the number of threads, that the voxel classification does not change the
+// selection away from the surface, and that the selection is correct. A
+// small tolerance is used, so that rays seldom hit two cells at an edge.
+// It also tests that the search grid kept between executions is rebuilt
+// when the surface is modified.
+
+#include <vtkMath.h>
+#include <vtkMinimalStandardRandomSequence.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSelectEnclosedPoints.h>
+#include <vtkSmartPointer.h>
+#include <vtkSphereSource.h>
+
+#include <cmath>
+
+// Check the selection away from a sphere of the given radius
+static bool CheckSelection(vtkSelectEnclosedPoints *select, vtkPoints *points,
+                           double radius)
+{
+  for (vtkIdType i = 0; i < points->GetNumberOfPoints(); ++i)
+    {
+    double x[3];
+    points->GetPoint(i, x);
+    double r = sqrt(vtkMath::Dot(x, x));
+    if (fabs(r - radius) > 0.05 * radius &&
+        select->IsInside(i) != (r < radius ? 1 : 0))
+      {
+      std::cerr << "Error: point " << i << " at radius " << r
+                << " is classified " << select->IsInside(i)
+                << " for a sphere of radius " << radius << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+int TestSelectEnclosedPointsThreads(int, char*[])
+{
+  vtkSmartPointer<vtkSphereSource> sphere =
+    vtkSmartPointer<vtkSphereSource>::New();
+  sphere->SetRadius(1.0);
+  sphere->SetPhiResolution(24);
+  sphere->SetThetaResolution(32);
+
+  // Random points in a box around the sphere
+  vtkSmartPointer<vtkMinimalStandardRandomSequence> random =
+    vtkSmartPointer<vtkMinimalStandardRandomSequence>::New();
+  random->SetSeed(4357);
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  for (int i = 0; i < 5000; ++i)
+    {
+    double x[3];
+    for (int j = 0; j < 3; ++j)
+      {
+      random->Next();
+      x[j] = random->GetRangeValue(-1.5, 1.5);
+      }
+    points->InsertNextPoint(x);
+    }
+  vtkSmartPointer<vtkPolyData> input = vtkSmartPointer<vtkPolyData>::New();
+  input->SetPoints(points);
+
+  vtkSmartPointer<vtkSelectEnclosedPoints> reference =
+    vtkSmartPointer<vtkSelectEnclosedPoints>::New();
+  reference->SetInputData(input);
+  reference->SetSurfaceConnection(sphere->GetOutputPort());
+  reference->SetTolerance(1e-6);
+  reference->SetNumberOfThreads(1);
+  reference->Update();
+
+  vtkSmartPointer<vtkSelectEnclosedPoints> select =
+    vtkSmartPointer<vtkSelectEnclosedPoints>::New();
+  select->SetInputData(input);
+  select->SetSurfaceConnection(sphere->GetOutputPort());
+  select->SetTolerance(1e-6);
+
+  for (int classify = 0; classify < 2; ++classify)
+    {
+    for (int numThreads = 1; numThreads <= 4; numThreads += 3)
+      {
+      select->SetVoxelClassification(classify);
+      select->SetNumberOfThreads(numThreads);
+      select->Update();
+
+      for (vtkIdType i = 0; i < points->GetNumberOfPoints(); ++i)
+        {
+        double x[3];
+        points->GetPoint(i, x);
+        double r = sqrt(vtkMath::Dot(x, x));
+        bool nearSurface = (r > 0.95 && r < 1.05);
+        if (!classify && select->IsInside(i) != reference->IsInside(i))
+          {
+          std::cerr << "Error: point " << i << " is classified differently "
+                    << "with " << numThreads << " thread(s)" << std::endl;
+          return EXIT_FAILURE;
+          }
+        if (!nearSurface &&
+            (select->IsInside(i) != reference->IsInside(i) ||
+             select->IsInside(i) != (r < 1.0 ? 1 : 0)))
+          {
+          std::cerr << "Error: point " << i << " at radius " << r
+                    << " is classified " << select->IsInside(i)
+                    << " with voxel classification " << classify
+                    << " and " << numThreads << " thread(s)" << std::endl;
+          return EXIT_FAILURE;
+          }
+        }
+      }
+    }
+
+  // The search grid is reused while the surface is unchanged, and rebuilt
+  // when it is modified in place or replaced by the pipeline.
+  sphere->Update();
+  vtkSmartPointer<vtkPolyData> surface = vtkSmartPointer<vtkPolyData>::New();
+  surface->DeepCopy(sphere->GetOutput());
+  select->SetSurfaceData(surface);
+  double radius = 1.0;
+  for (int classify = 0; classify < 2; ++classify)
+    {
+    select->SetVoxelClassification(classify);
+    select->Update();
+    if (!CheckSelection(select, points, radius))
+      {
+      return EXIT_FAILURE;
+      }
+    select->SetNumberOfThreads(classify + 2);
+    select->Update();
+    if (!CheckSelection(select, points, radius))
+      {
+      return EXIT_FAILURE;
+      }
+
+    vtkPoints *surfacePoints = surface->GetPoints();
+    double scale = classify ? 1.0 / 0.6 : 0.6;
+    radius *= scale;
+    for (vtkIdType i = 0; i < surfacePoints->GetNumberOfPoints(); ++i)
+      {
+      double x[3];
+      surfacePoints->GetPoint(i, x);
+      surfacePoints->SetPoint(i, scale * x[0], scale * x[1], scale * x[2]);
+      }
+    surfacePoints->Modified();
+    surface->Modified();
+    select->Update();
+    if (!CheckSelection(select, points, radius))
+      {
+      return EXIT_FAILURE;
+      }
+    }
+
+  select->SetSurfaceConnection(sphere->GetOutputPort());
+  sphere->SetRadius(1.3);
+  select->Update();
+  if (!CheckSelection(select, points, 1.3))
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -29,9 +29,530 @@
 #include "vtkGenericCell.h"
 #include "vtkMath.h"
 #include "vtkGarbageCollector.h"
+#include "vtkBox.h"
+#include "vtkMinimalStandardRandomSequence.h"
+#include "vtkMultiThreader.h"
+
+#include <algorithm>
+#include <vector>
 
 vtkStandardNewMacro(vtkSelectEnclosedPoints);
 
+#define VTK_CERTAIN 1
+#define VTK_UNCERTAIN 0
+#define VTK_MAX_ITER 10    //Maximum iterations for ray-firing
+#define VTK_VOTE_THRESHOLD 3
+#define VTK_MAX_GRID_DIVISIONS 512
+#define VTK_CLASSIFICATION_VOTES 5
+
+//----------------------------------------------------------------------------
+// Uniform grid of voxels over the surface. Each voxel lists the cells whose
+// bounding box, enlarged by the tolerance, overlaps it. The grid is padded
+// with a layer of empty voxels, so that the voxels without cells can be
+// classified by flooding the outside from the border. Once built, the grid is only read, and rays can
+// be cast from several threads at once.
+class vtkSelectEnclosedPointsInternals
+{
+public:
+  vtkSelectEnclosedPointsInternals() :
+    Surface(NULL), Tolerance(0.0), VoxelClassification(0) {}
+
+  void Build(vtkPolyData *surface, double tolerance, int classify);
+  int NeedsBuild(vtkPolyData *surface, double tolerance, int classify);
+  vtkIdType GetVoxel(const double x[3]);
+  int IsInside(double x[3], vtkIdType seed, vtkGenericCell *cell,
+               vtkMinimalStandardRandomSequence *random,
+               std::vector<vtkIdType> &candidates);
+
+  vtkPolyData *Surface;
+  vtkTimeStamp BuildTime;
+  double Tolerance; //as a fraction of Length
+  int VoxelClassification;
+
+  double Bounds[6];
+  double Length;
+  double Origin[3];
+  double Spacing[3];
+  int Dimensions[3];
+
+  std::vector<vtkIdType> Offsets; //into CellIds, per voxel
+  std::vector<vtkIdType> CellIds;
+  std::vector<double> CellBounds;
+  std::vector<signed char> Classes; //1 inside, 0 outside, -1 crossed
+
+protected:
+  int CastRays(double x[3], vtkIdType seed, vtkGenericCell *cell,
+               vtkMinimalStandardRandomSequence *random,
+               std::vector<vtkIdType> &candidates);
+  int CountIntersections(double x[3], double xray[3], vtkGenericCell *cell,
+                         std::vector<vtkIdType> &candidates);
+};
+
+//----------------------------------------------------------------------------
+int vtkSelectEnclosedPointsInternals::NeedsBuild(vtkPolyData *surface,
+                                                 double tolerance,
+                                                 int classify)
+{
+  return ( surface != this->Surface ||
+           surface->GetMTime() > this->BuildTime ||
+           tolerance != this->Tolerance ||
+           classify != this->VoxelClassification );
+}
+
+//----------------------------------------------------------------------------
+void vtkSelectEnclosedPointsInternals::Build(vtkPolyData *surface,
+                                             double tolerance, int classify)
+{
+  this->Surface = surface;
+  this->Tolerance = tolerance;
+  this->VoxelClassification = classify;
+  this->BuildTime.Modified();
+
+  surface->GetBounds(this->Bounds);
+  this->Length = surface->GetLength();
+  double tol = tolerance*this->Length;
+  vtkIdType numCells = surface->GetNumberOfCells();
+  vtkIdType cellId, voxel;
+  int i, j, k;
+
+  // Size the voxels so that there are about as many voxels as cells.
+  double extent[3], volume = 1.0, minExtent = 0.001*this->Length;
+  for ( i=0; i < 3; i++ )
+    {
+    extent[i] = this->Bounds[2*i+1] - this->Bounds[2*i];
+    extent[i] = ( extent[i] > minExtent ? extent[i] : minExtent );
+    volume *= extent[i];
+    }
+  double h = ( numCells > 0 && volume > 0.0 ?
+               pow(volume / numCells, 1.0/3.0) : 1.0 );
+  for ( i=0; i < 3; i++ )
+    {
+    int divs = ( volume > 0.0 ? static_cast<int>(ceil(extent[i] / h)) : 1 );
+    divs = ( divs < 1 ? 1 : ( divs > VTK_MAX_GRID_DIVISIONS ?
+                              VTK_MAX_GRID_DIVISIONS : divs ) );
+    this->Spacing[i] = ( extent[i] > 0.0 ? extent[i] / divs : 1.0 );
+    this->Dimensions[i] = divs + 2;
+    this->Origin[i] = this->Bounds[2*i] - this->Spacing[i];
+    }
+  vtkIdType numVoxels = static_cast<vtkIdType>(this->Dimensions[0]) *
+    this->Dimensions[1] * this->Dimensions[2];
+
+  // Bucket the cells (counting sort on the voxels)
+  this->CellBounds.resize(6*numCells);
+  std::vector<int> ranges(6*numCells);
+  this->Offsets.assign(numVoxels+1, 0);
+  for ( cellId=0; cellId < numCells; cellId++ )
+    {
+    double *bounds = &this->CellBounds[6*cellId];
+    int *range = &ranges[6*cellId];
+    surface->GetCellBounds(cellId, bounds);
+    for ( i=0; i < 3; i++ )
+      {
+      bounds[2*i] -= tol;
+      bounds[2*i+1] += tol;
+      for ( j=0; j < 2; j++ )
+        {
+        int idx = static_cast<int>(
+          floor((bounds[2*i+j] - this->Origin[i]) / this->Spacing[i]));
+        range[2*i+j] = ( idx < 0 ? 0 : ( idx >= this->Dimensions[i] ?
+                                         this->Dimensions[i]-1 : idx ) );
+        }
+      }
+    for ( k=range[4]; k <= range[5]; k++ )
+      {
+      for ( j=range[2]; j <= range[3]; j++ )
+        {
+        for ( i=range[0]; i <= range[1]; i++ )
+          {
+          voxel = i + this->Dimensions[0]*(j + this->Dimensions[1]*k);
+          this->Offsets[voxel+1]++;
+          }
+        }
+      }
+    }
+  for ( voxel=0; voxel < numVoxels; voxel++ )
+    {
+    this->Offsets[voxel+1] += this->Offsets[voxel];
+    }
+  this->CellIds.resize(this->Offsets[numVoxels]);
+  std::vector<vtkIdType> next(this->Offsets.begin(), this->Offsets.end()-1);
+  for ( cellId=0; cellId < numCells; cellId++ )
+    {
+    int *range = &ranges[6*cellId];
+    for ( k=range[4]; k <= range[5]; k++ )
+      {
+      for ( j=range[2]; j <= range[3]; j++ )
+        {
+        for ( i=range[0]; i <= range[1]; i++ )
+          {
+          voxel = i + this->Dimensions[0]*(j + this->Dimensions[1]*k);
+          this->CellIds[next[voxel]++] = cellId;
+          }
+        }
+      }
+    }
+
+  this->Classes.clear();
+  if ( !classify )
+    {
+    return;
+    }
+
+  // Classify the empty voxels: those connected to the border through empty
+  // voxels are outside. Every other connected set of empty voxels lies on
+  // one side of the surface, and is classified by casting rays from the
+  // center of its first voxel.
+  this->Classes.assign(numVoxels, -2); //-2: empty, not yet classified
+  for ( voxel=0; voxel < numVoxels; voxel++ )
+    {
+    if ( this->Offsets[voxel+1] > this->Offsets[voxel] )
+      {
+      this->Classes[voxel] = -1;
+      }
+    }
+
+  vtkGenericCell *cell = vtkGenericCell::New();
+  vtkMinimalStandardRandomSequence *random =
+    vtkMinimalStandardRandomSequence::New();
+  std::vector<vtkIdType> candidates, queue;
+  vtkIdType sliceSize =
+    static_cast<vtkIdType>(this->Dimensions[0])*this->Dimensions[1];
+  for ( vtkIdType seedVoxel=0; seedVoxel < numVoxels; seedVoxel++ )
+    {
+    if ( this->Classes[seedVoxel] != -2 )
+      {
+      continue;
+      }
+    // The first unclassified voxel is on the border (the padding layer) for
+    // the first set only. A wrong vote would misclassify the whole set, so
+    // the other sets take the majority of several votes.
+    signed char inside = 0;
+    if ( seedVoxel > 0 )
+      {
+      double center[3];
+      center[0] = this->Origin[0] +
+        (seedVoxel % this->Dimensions[0] + 0.5)*this->Spacing[0];
+      center[1] = this->Origin[1] +
+        ((seedVoxel / this->Dimensions[0]) % this->Dimensions[1] + 0.5)*
+        this->Spacing[1];
+      center[2] = this->Origin[2] +
+        (seedVoxel / sliceSize + 0.5)*this->Spacing[2];
+      int votes = 0;
+      for ( i=0; i < VTK_CLASSIFICATION_VOTES; i++ )
+        {
+        votes += this->CastRays(center, VTK_CLASSIFICATION_VOTES*seedVoxel+i,
+                                cell, random, candidates);
+        }
+      inside = ( 2*votes > VTK_CLASSIFICATION_VOTES ? 1 : 0 );
+      }
+
+    this->Classes[seedVoxel] = inside;
+    queue.clear();
+    queue.push_back(seedVoxel);
+    while ( !queue.empty() )
+      {
+      voxel = queue.back();
+      queue.pop_back();
+      int ijk[3];
+      ijk[0] = static_cast<int>(voxel % this->Dimensions[0]);
+      ijk[1] = static_cast<int>((voxel / this->Dimensions[0]) %
+                                this->Dimensions[1]);
+      ijk[2] = static_cast<int>(voxel / sliceSize);
+      vtkIdType stride[3] = { 1, this->Dimensions[0], sliceSize };
+      for ( i=0; i < 3; i++ )
+        {
+        for ( j=-1; j <= 1; j += 2 )
+          {
+          if ( ijk[i]+j < 0 || ijk[i]+j >= this->Dimensions[i] )
+            {
+            continue;
+            }
+          vtkIdType neighbor = voxel + j*stride[i];
+          if ( this->Classes[neighbor] == -2 )
+            {
+            this->Classes[neighbor] = inside;
+            queue.push_back(neighbor);
+            }
+          }
+        }
+      }
+    }
+  random->Delete();
+  cell->Delete();
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkSelectEnclosedPointsInternals::GetVoxel(const double x[3])
+{
+  int ijk[3];
+  for ( int i=0; i < 3; i++ )
+    {
+    ijk[i] = static_cast<int>(floor((x[i] - this->Origin[i]) /
+                                    this->Spacing[i]));
+    ijk[i] = ( ijk[i] < 0 ? 0 : ( ijk[i] >= this->Dimensions[i] ?
+                                  this->Dimensions[i]-1 : ijk[i] ) );
+    }
+  return ijk[0] + this->Dimensions[0]*
+    (ijk[1] + static_cast<vtkIdType>(this->Dimensions[1])*ijk[2]);
+}
+
+//----------------------------------------------------------------------------
+int vtkSelectEnclosedPointsInternals::IsInside(
+  double x[3], vtkIdType seed, vtkGenericCell *cell,
+  vtkMinimalStandardRandomSequence *random,
+  std::vector<vtkIdType> &candidates)
+{
+  // do a quick bounds check
+  if ( x[0] < this->Bounds[0] || x[0] > this->Bounds[1] ||
+       x[1] < this->Bounds[2] || x[1] > this->Bounds[3] ||
+       x[2] < this->Bounds[4] || x[2] > this->Bounds[5])
+    {
+    return 0;
+    }
+
+  if ( !this->Classes.empty() )
+    {
+    signed char inside = this->Classes[this->GetVoxel(x)];
+    if ( inside >= 0 )
+      {
+      return inside;
+      }
+    }
+
+  return this->CastRays(x, seed, cell, random, candidates);
+}
+
+//----------------------------------------------------------------------------
+// Same vote as vtkSelectEnclosedPoints::IsInsideSurface(), with a random
+// sequence seeded from the given seed, so that the rays cast from a point
+// do not depend on the thread testing it.
+int vtkSelectEnclosedPointsInternals::CastRays(
+  double x[3], vtkIdType seed, vtkGenericCell *cell,
+  vtkMinimalStandardRandomSequence *random,
+  std::vector<vtkIdType> &candidates)
+{
+  double rayMag, ray[3], xray[3];
+  int i, iterNumber, deltaVotes;
+
+  random->SetSeed(static_cast<int>(seed % 2147483646) + 1);
+  for (deltaVotes = 0, iterNumber = 1;
+       (iterNumber < VTK_MAX_ITER) && (abs(deltaVotes) < VTK_VOTE_THRESHOLD);
+       iterNumber++)
+    {
+    //  Define a random ray to fire.
+    rayMag = 0.0;
+    while (rayMag == 0.0 )
+      {
+      for (i=0; i<3; i++)
+        {
+        random->Next();
+        ray[i] = random->GetRangeValue(-1.0,1.0);
+        }
+      rayMag = vtkMath::Norm(ray);
+      }
+
+    // The ray must be appropriately sized wrt the bounding box. (It has to go
+    // all the way through the bounding box.)
+    for (i=0; i<3; i++)
+      {
+      xray[i] = x[i] + (this->Length/rayMag)*ray[i];
+      }
+
+    // Count the result
+    if ( (this->CountIntersections(x, xray, cell, candidates) % 2) == 0)
+      {
+      --deltaVotes;
+      }
+    else
+      {
+      ++deltaVotes;
+      }
+    } //try another ray
+
+  //   If the number of votes is positive, the point is inside
+  //
+  return ( deltaVotes < 0 ? 0 : 1 );
+}
+
+//----------------------------------------------------------------------------
+// Walk the voxels crossed by the segment (x,xray) to gather the candidate
+// cells, then intersect the segment with those whose bounds it crosses.
+int vtkSelectEnclosedPointsInternals::CountIntersections(
+  double x[3], double xray[3], vtkGenericCell *cell,
+  std::vector<vtkIdType> &candidates)
+{
+  double dir[3], t0 = 0.0, t1 = 1.0;
+  int i, ijk[3], step[3];
+  double tMax[3], tDelta[3];
+
+  // Clip the segment to the grid
+  for ( i=0; i < 3; i++ )
+    {
+    dir[i] = xray[i] - x[i];
+    double lo = this->Origin[i];
+    double hi = this->Origin[i] + this->Dimensions[i]*this->Spacing[i];
+    if ( dir[i] == 0.0 )
+      {
+      if ( x[i] < lo || x[i] > hi )
+        {
+        return 0;
+        }
+      continue;
+      }
+    double ta = (lo - x[i]) / dir[i];
+    double tb = (hi - x[i]) / dir[i];
+    if ( ta > tb )
+      {
+      std::swap(ta, tb);
+      }
+    t0 = ( ta > t0 ? ta : t0 );
+    t1 = ( tb < t1 ? tb : t1 );
+    }
+  if ( t0 > t1 )
+    {
+    return 0;
+    }
+
+  // 3D digital differential analyzer
+  for ( i=0; i < 3; i++ )
+    {
+    double p = x[i] + t0*dir[i];
+    ijk[i] = static_cast<int>(floor((p - this->Origin[i]) / this->Spacing[i]));
+    ijk[i] = ( ijk[i] < 0 ? 0 : ( ijk[i] >= this->Dimensions[i] ?
+                                  this->Dimensions[i]-1 : ijk[i] ) );
+    if ( dir[i] > 0.0 )
+      {
+      step[i] = 1;
+      tMax[i] = (this->Origin[i] + (ijk[i]+1)*this->Spacing[i] - x[i]) / dir[i];
+      tDelta[i] = this->Spacing[i] / dir[i];
+      }
+    else if ( dir[i] < 0.0 )
+      {
+      step[i] = -1;
+      tMax[i] = (this->Origin[i] + ijk[i]*this->Spacing[i] - x[i]) / dir[i];
+      tDelta[i] = -this->Spacing[i] / dir[i];
+      }
+    else
+      {
+      step[i] = 0;
+      tMax[i] = VTK_DOUBLE_MAX;
+      tDelta[i] = VTK_DOUBLE_MAX;
+      }
+    }
+
+  candidates.clear();
+  for (;;)
+    {
+    vtkIdType voxel = ijk[0] + this->Dimensions[0]*
+      (ijk[1] + static_cast<vtkIdType>(this->Dimensions[1])*ijk[2]);
+    candidates.insert(candidates.end(),
+                      this->CellIds.begin() + this->Offsets[voxel],
+                      this->CellIds.begin() + this->Offsets[voxel+1]);
+    int axis = ( tMax[0] < tMax[1] ? ( tMax[0] < tMax[2] ? 0 : 2 ) :
+                 ( tMax[1] < tMax[2] ? 1 : 2 ) );
+    if ( tMax[axis] > t1 )
+      {
+      break;
+      }
+    ijk[axis] += step[axis];
+    if ( ijk[axis] < 0 || ijk[axis] >= this->Dimensions[axis] )
+      {
+      break;
+      }
+    tMax[axis] += tDelta[axis];
+    }
+  std::sort(candidates.begin(), candidates.end());
+  candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                   candidates.end());
+
+  // Intersect the line with each of the candidate cells
+  double tol = this->Tolerance*this->Length;
+  double t, pcoords[3], xint[3], hit[3];
+  int subId, numInts = 0;
+  for ( size_t idx=0; idx < candidates.size(); idx++ )
+    {
+    vtkIdType cellId = candidates[idx];
+    if ( !vtkBox::IntersectBox(&this->CellBounds[6*cellId], x, dir, hit, t) )
+      {
+      continue;
+      }
+    this->Surface->GetCell(cellId, cell);
+    if ( cell->IntersectWithLine(x, xray, tol, t, xint, pcoords, subId) )
+      {
+      numInts++;
+      }
+    } //for all candidate cells
+
+  return numInts;
+}
+
+//----------------------------------------------------------------------------
+namespace
+{
+struct vtkSelectEnclosedPointsThreadStruct
+{
+  vtkSelectEnclosedPoints *Filter;
+  vtkSelectEnclosedPointsInternals *Internals;
+  const double *Points;
+  const vtkIdType *Order;
+  vtkIdType NumberOfPoints;
+  unsigned char *Marks;
+  int InsideOut;
+  int NumberOfThreads;
+};
+}
+
+//----------------------------------------------------------------------------
+// Test a range of the points, taken in voxel order so that successive rays
+// traverse the same voxels. Every thread stops once the filter is aborted;
+// thread 0 reports the progress.
+static VTK_THREAD_RETURN_TYPE vtkSelectEnclosedPointsExecute(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkSelectEnclosedPointsThreadStruct *str =
+    static_cast<vtkSelectEnclosedPointsThreadStruct *>(info->UserData);
+
+  vtkIdType begin = str->NumberOfPoints * info->ThreadID /
+    str->NumberOfThreads;
+  vtkIdType end = str->NumberOfPoints * (info->ThreadID + 1) /
+    str->NumberOfThreads;
+
+  vtkGenericCell *cell = vtkGenericCell::New();
+  vtkMinimalStandardRandomSequence *random =
+    vtkMinimalStandardRandomSequence::New();
+  std::vector<vtkIdType> candidates;
+  double x[3];
+
+  vtkIdType progressInterval = (end - begin)/20 + 1;
+  for ( vtkIdType idx=begin; idx < end; idx++ )
+    {
+    if ( ! ((idx - begin) % progressInterval) ) //manage progress / early abort
+      {
+      if ( info->ThreadID == 0 )
+        {
+        str->Filter->UpdateProgress(0.2 + 0.8*(idx - begin)/(end - begin));
+        }
+      if ( str->Filter->GetAbortExecute() )
+        {
+        break;
+        }
+      }
+
+    vtkIdType ptId = str->Order[idx];
+    x[0] = str->Points[3*ptId];
+    x[1] = str->Points[3*ptId+1];
+    x[2] = str->Points[3*ptId+2];
+    int inside = str->Internals->IsInside(x, ptId, cell, random, candidates);
+    str->Marks[ptId] = ( inside ? (str->InsideOut?0:1) :
+                         (str->InsideOut?1:0) );
+    }
+
+  random->Delete();
+  cell->Delete();
+  return VTK_THREAD_RETURN_VALUE;
+}
+
 //----------------------------------------------------------------------------
 // Construct object.
 vtkSelectEnclosedPoints::vtkSelectEnclosedPoints()
@@ -47,6 +568,11 @@ vtkSelectEnclosedPoints::vtkSelectEnclosedPoints()
   this->CellLocator = vtkCellLocator::New();
   this->CellIds = vtkIdList::New();
   this->Cell = vtkGenericCell::New();
+
+  this->VoxelClassification = 0;
+  this->Internals = new vtkSelectEnclosedPointsInternals;
+  this->Threader = vtkMultiThreader::New();
+  this->NumberOfThreads = this->Threader->GetNumberOfThreads();
 }
 
 //----------------------------------------------------------------------------
@@ -66,6 +592,9 @@ vtkSelectEnclosedPoints::~vtkSelectEnclosedPoints()
 
   this->CellIds->Delete();
   this->Cell->Delete();
+
+  delete this->Internals;
+  this->Threader->Delete();
 }
 
 //----------------------------------------------------------------------------
@@ -95,8 +624,15 @@ int vtkSelectEnclosedPoints::RequestData(
     return 0;
     }
 
-  // Initiailize search structures
-  this->Initialize(surface);
+  // Build the search grid, unless the surface is unchanged since the
+  // previous execution.
+  vtkSelectEnclosedPointsInternals *internals = this->Internals;
+  if ( internals->NeedsBuild(surface, this->Tolerance,
+                             this->VoxelClassification) )
+    {
+    internals->Build(surface, this->Tolerance, this->VoxelClassification);
+    }
+  this->UpdateProgress(0.2);
 
   // Create array to mark inside/outside
   if ( this->InsideOutsideArray )
@@ -107,33 +643,55 @@ int vtkSelectEnclosedPoints::RequestData(
   vtkUnsignedCharArray *marks = this->InsideOutsideArray;
   marks->SetName("SelectedPointsArray");
 
-  // Loop over all input points determining inside/outside
   vtkIdType numPts = input->GetNumberOfPoints();
   marks->SetNumberOfValues(numPts);
   vtkIdType ptId;
-  double x[3];
 
-  int abort=0;
-  vtkIdType progressInterval=numPts/20+1;
-  for ( ptId=0; ptId < numPts && !abort; ptId++ )
+  // Gather the points, sorted by voxel
+  std::vector<double> points(3*numPts+1);
+  std::vector<vtkIdType> voxels(numPts);
+  vtkIdType numVoxels = static_cast<vtkIdType>(internals->Offsets.size()) - 1;
+  std::vector<vtkIdType> offsets(numVoxels+1, 0);
+  for ( ptId=0; ptId < numPts; ptId++ )
     {
-    if ( ! (ptId % progressInterval) ) //manage progress / early abort
-      {
-      this->UpdateProgress ((double)ptId / numPts);
-      abort = this->GetAbortExecute();
-      }
-
-    input->GetPoint(ptId,x);
+    input->GetPoint(ptId, &points[3*ptId]);
+    voxels[ptId] = internals->GetVoxel(&points[3*ptId]);
+    offsets[voxels[ptId]+1]++;
+    }
+  for ( vtkIdType voxel=0; voxel < numVoxels; voxel++ )
+    {
+    offsets[voxel+1] += offsets[voxel];
+    }
+  std::vector<vtkIdType> order(numPts+1);
+  for ( ptId=0; ptId < numPts; ptId++ )
+    {
+    order[offsets[voxels[ptId]]++] = ptId;
+    }
+  std::vector<vtkIdType>().swap(voxels);
+  std::vector<vtkIdType>().swap(offsets);
 
-    if ( this->IsInsideSurface(x) )
-      {
-      marks->SetValue(ptId,(this->InsideOut?0:1));
-      }
-    else
-      {
-      marks->SetValue(ptId,(this->InsideOut?1:0));
-      }
+  // Loop over all input points determining inside/outside
+  if ( numPts > 0 )
+    {
+    int numThreads = this->NumberOfThreads;
+    numThreads = ( numThreads > numPts ? static_cast<int>(numPts) :
+                   numThreads );
+
+    vtkSelectEnclosedPointsThreadStruct str;
+    str.Filter = this;
+    str.Internals = internals;
+    str.Points = &points[0];
+    str.Order = &order[0];
+    str.NumberOfPoints = numPts;
+    str.Marks = marks->GetPointer(0);
+    str.InsideOut = this->InsideOut;
+    str.NumberOfThreads = numThreads;
+
+    this->Threader->SetNumberOfThreads(numThreads);
+    this->Threader->SetSingleMethod(vtkSelectEnclosedPointsExecute, &str);
+    this->Threader->SingleMethodExecute();
     }
+  this->UpdateProgress(1.0);
 
   // Copy all the input geometry and data to the output.
   output->CopyStructure(input);
@@ -144,9 +702,6 @@ int vtkSelectEnclosedPoints::RequestData(
   marks->SetName("SelectedPoints");
   output->GetPointData()->SetScalars(marks);
 
-  // release memory
-  this->Complete();
-
   return 1;
 }
 
@@ -219,11 +774,6 @@ int vtkSelectEnclosedPoints::IsInsideSurface(double x, double y, double z)
   return this->IsInsideSurface(xyz);
 }
 
-
-#define VTK_CERTAIN 1
-#define VTK_UNCERTAIN 0
-#define VTK_MAX_ITER 10    //Maximum iterations for ray-firing
-#define VTK_VOTE_THRESHOLD 3
 //----------------------------------------------------------------------------
 int vtkSelectEnclosedPoints::IsInsideSurface(double x[3])
 {
@@ -310,6 +860,8 @@ int vtkSelectEnclosedPoints::IsInsideSurface(double x[3])
 #undef VTK_UNCERTAIN
 #undef VTK_MAX_ITER
 #undef VTK_VOTE_THRESHOLD
+#undef VTK_MAX_GRID_DIVISIONS
+#undef VTK_CLASSIFICATION_VOTES
 
 
 //----------------------------------------------------------------------------
@@ -389,5 +941,10 @@ void vtkSelectEnclosedPoints::PrintSelf(ostream& os, vtkIndent indent)
      << (this->InsideOut ? "On\n" : "Off\n");
 
   os << indent << "Tolerance: " << this->Tolerance << "\n";
+
+  os << indent << "Voxel Classification: "
+     << (this->VoxelClassification ? "On\n" : "Off\n");
+
+  os << indent << "Number Of Threads: " << this->NumberOfThreads << "\n";
 }
 
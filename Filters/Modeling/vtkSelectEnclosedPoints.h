@@ -22,6 +22,14 @@
 //
 // After running the filter, it is possible to query it as to whether a point
 // is inside/outside by invoking the IsInside(ptId) method.
+//
+// The filter builds a uniform grid of voxels over the surface, listing the
+// cells overlapping each voxel. The grid is kept between executions as long
+// as the surface is not modified. The points are sorted by voxel and split
+// over several threads, and rays are traversed voxel by voxel. Optionally
+// (VoxelClassification), the voxels without cells are classified once as
+// inside or outside, so that only points in voxels crossed by the surface
+// need rays to be cast.
 
 // .SECTION Caveats
 // The filter assumes that the surface is closed and manifold. A boolean flag
@@ -46,6 +54,8 @@ class vtkUnsignedCharArray;
 class vtkCellLocator;
 class vtkIdList;
 class vtkGenericCell;
+class vtkMultiThreader;
+class vtkSelectEnclosedPointsInternals;
 
 
 class VTKFILTERSMODELING_EXPORT vtkSelectEnclosedPoints : public vtkDataSetAlgorithm
@@ -98,6 +108,22 @@ public:
   vtkSetClampMacro(Tolerance,double,0.0,VTK_LARGE_FLOAT);
   vtkGetMacro(Tolerance,double);
 
+  // Description:
+  // Specify whether the voxels of the search grid that contain no cell of
+  // the surface are classified as inside or outside before the points are
+  // tested. Points falling in these voxels are then classified without
+  // casting rays. This assumes that the surface is closed. Off by default.
+  vtkSetMacro(VoxelClassification,int);
+  vtkBooleanMacro(VoxelClassification,int);
+  vtkGetMacro(VoxelClassification,int);
+
+  // Description:
+  // Set/Get the number of threads used to test the input points. Defaults
+  // to the number of available processors. The result does not depend on
+  // the number of threads.
+  vtkSetClampMacro(NumberOfThreads,int,1,VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads,int);
+
   // Description:
   // This is a backdoor that can be used to test many points for containment.
   // First initialize the instance, then repeated calls to IsInsideSurface()
@@ -115,6 +141,8 @@ protected:
   int    CheckSurface;
   int    InsideOut;
   double Tolerance;
+  int    VoxelClassification;
+  int    NumberOfThreads;
 
   int IsSurfaceClosed(vtkPolyData *surface);
   vtkUnsignedCharArray *InsideOutsideArray;
@@ -127,6 +155,10 @@ protected:
   double          Bounds[6];
   double          Length;
 
+  // Search grid used by RequestData(), kept between executions
+  vtkSelectEnclosedPointsInternals *Internals;
+  vtkMultiThreader                 *Threader;
+
   virtual int RequestData(vtkInformation *, vtkInformationVector **, vtkInformationVector *);
   virtual int FillInputPortInformation(int, vtkInformation *);
 
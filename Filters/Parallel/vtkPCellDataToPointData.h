@@ -18,7 +18,8 @@
 // a point to get new point data.  This subclass requests a layer of
 // ghost cells to make the results invariant to pieces.  There is a
 // "PieceInvariant" flag that lets the user change the behavior
-// of the filter to that of its superclass.
+// of the filter to that of its superclass. The averaging itself is done by
+// the superclass, with its NumberOfThreads threads.
 
 #ifndef __vtkPCellDataToPointData_h
 #define __vtkPCellDataToPointData_h
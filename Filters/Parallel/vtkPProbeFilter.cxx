@@ -16,6 +16,7 @@
 
 #include "vtkCompositeDataPipeline.h"
 #include "vtkCharArray.h"
+#include "vtkIdTypeArray.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkMultiProcessController.h"
@@ -25,6 +26,7 @@
 #include "vtkOnePieceExtentTranslator.h"
 #include "vtkPolyData.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
+#include "vtkTable.h"
 
 vtkStandardNewMacro(vtkPProbeFilter);
 
@@ -89,6 +91,11 @@ int vtkPProbeFilter::RequestData(vtkInformation *request,
     numProcs = this->Controller->GetNumberOfProcesses();
     }
 
+  // Only the tuples of the valid points are exchanged, in a table that also
+  // holds their point ids under the name of the mask array, which is the only
+  // name no probed array can have.
+  const char *idsName = this->ValidPointMaskArrayName ?
+    this->ValidPointMaskArrayName : "vtkValidPointMask";
   vtkIdType numPoints = this->NumberOfValidPoints;
   if ( procid )
     {
@@ -96,53 +103,88 @@ int vtkPProbeFilter::RequestData(vtkInformation *request,
     this->Controller->Send(&numPoints, 1, 0, PROBE_COMMUNICATION_TAG);
     if ( numPoints > 0 )
       {
-      this->Controller->Send(output, 0, PROBE_COMMUNICATION_TAG);
+      vtkTable *validTuples = vtkTable::New();
+      vtkIdTypeArray *validIds = vtkIdTypeArray::New();
+      validIds->DeepCopy(this->ValidPoints);
+      validIds->SetName(idsName);
+      validTuples->AddColumn(validIds);
+      validIds->Delete();
+
+      vtkPointData *pointData = output->GetPointData();
+      for (int k = 0; k < pointData->GetNumberOfArrays(); k++)
+        {
+        vtkAbstractArray *array = pointData->GetAbstractArray(k);
+        if (!array || !array->GetName() || !strcmp(array->GetName(), idsName))
+          {
+          continue;
+          }
+        vtkAbstractArray *packed = array->NewInstance();
+        packed->SetName(array->GetName());
+        packed->SetNumberOfComponents(array->GetNumberOfComponents());
+        packed->SetNumberOfTuples(numPoints);
+        for (vtkIdType i = 0; i < numPoints; i++)
+          {
+          packed->SetTuple(i, this->ValidPoints->GetValue(i), array);
+          }
+        validTuples->AddColumn(packed);
+        packed->Delete();
+        }
+      this->Controller->Send(validTuples, 0, PROBE_COMMUNICATION_TAG);
+      validTuples->Delete();
       }
     output->ReleaseData();
     }
   else if ( numProcs > 1 )
     {
     vtkIdType numRemoteValidPoints = 0;
-    vtkDataSet *remoteProbeOutput = output->NewInstance();
-    vtkPointData *remotePointData;
+    vtkTable *remoteValidTuples = vtkTable::New();
     vtkPointData *pointData = output->GetPointData();
+    vtkCharArray* maskArray = vtkCharArray::SafeDownCast(
+      pointData->GetArray(idsName));
     vtkIdType i;
-    vtkIdType k;
-    vtkIdType pointId;
+    vtkIdType j;
+    int k;
     for (i = 1; i < numProcs; i++)
       {
       this->Controller->Receive(&numRemoteValidPoints, 1, i, PROBE_COMMUNICATION_TAG);
       if (numRemoteValidPoints > 0)
         {
-        this->Controller->Receive(remoteProbeOutput, i, PROBE_COMMUNICATION_TAG);
-
-        remotePointData = remoteProbeOutput->GetPointData();
+        this->Controller->Receive(remoteValidTuples, i, PROBE_COMMUNICATION_TAG);
 
-        vtkCharArray* maskArray = vtkCharArray::SafeDownCast(
-          remotePointData->GetArray(this->ValidPointMaskArrayName));
+        vtkIdTypeArray *remoteIds = vtkIdTypeArray::SafeDownCast(
+          remoteValidTuples->GetColumnByName(idsName));
+        vtkIdType numRemoteIds = remoteIds ? remoteIds->GetNumberOfTuples() : 0;
 
-        // Iterate over all point data in the output gathered from the remove
-        // and copy array values from all the pointIds which have the mask array
-        // bit set to 1.
-        vtkIdType numRemotePoints = remoteProbeOutput->GetNumberOfPoints();
-        for (pointId=0; (pointId < numRemotePoints) && maskArray; pointId++)
+        // Scatter the values of each array received to the points they were
+        // probed at, and mark these points as valid.
+        for (k = 0; k < pointData->GetNumberOfArrays(); k++)
           {
-          if (maskArray->GetValue(pointId) == 1)
+          vtkAbstractArray *oaa = pointData->GetAbstractArray(k);
+          if (!oaa || !oaa->GetName())
+            {
+            continue;
+            }
+          if (oaa == maskArray)
+            {
+            for (j = 0; j < numRemoteIds; j++)
+              {
+              maskArray->SetValue(remoteIds->GetValue(j), 1);
+              }
+            continue;
+            }
+          vtkAbstractArray *raa =
+            remoteValidTuples->GetColumnByName(oaa->GetName());
+          if (raa != NULL)
             {
-            for (k = 0; k < pointData->GetNumberOfArrays(); k++)
+            for (j = 0; j < numRemoteIds; j++)
               {
-              vtkAbstractArray *oaa = pointData->GetArray(k);
-              vtkAbstractArray *raa = remotePointData->GetArray(oaa->GetName());
-              if (raa != NULL)
-                {
-                oaa->SetTuple(pointId, pointId, raa);
-                }
+              oaa->SetTuple(remoteIds->GetValue(j), j, raa);
               }
             }
           }
         }
       }
-    remoteProbeOutput->Delete();
+    remoteValidTuples->Delete();
     }
 
   return 1;
@@ -14,6 +14,10 @@
 =========================================================================*/
 // .NAME vtkPProbeFilter - probe dataset in parallel
 // .SECTION Description
+// vtkPProbeFilter probes the piece of the source of each process, then
+// gathers the results on process 0. Each satellite only sends the values
+// of the points it found, with their ids, which process 0 copies into its
+// output.
 
 #ifndef __vtkPProbeFilter_h
 #define __vtkPProbeFilter_h
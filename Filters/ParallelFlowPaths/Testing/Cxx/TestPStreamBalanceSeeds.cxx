@@ -0,0 +1,178 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestPStreamBalanceSeeds.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// This tests that vtkPStreamTracer traces the same streamlines with
+// BalanceSeeds off and on, on an image split in blocks among the processes,
+// where the traces are handed over from one block to the next, and on an
+// image replicated on every process, where the balanced seeds are traced by
+// several processes.
+// The tracer is executed several times in a row, so that the messages of an
+// execution must not be mistaken for those of the next one.
+
+#include "TestVectorFieldSource.h"
+#include <vtkCellArray.h>
+#include <vtkExtentTranslator.h>
+#include <vtkIdList.h>
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkMPIController.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkPStreamTracer.h>
+
+#define PRINT(x) cout<<"("<<myRank<<")"<<x<<endl;
+
+namespace
+{
+// The total length of the lines of a poly data
+double ComputeLength(vtkPolyData* poly)
+{
+  vtkNew<vtkIdList> polyLine;
+  vtkCellArray* lines = poly->GetLines();
+  double length(0);
+  lines->InitTraversal();
+  while(lines->GetNextCell(polyLine.GetPointer()))
+    {
+    double p[3], q[3];
+    for(vtkIdType j=1; j<polyLine->GetNumberOfIds(); j++)
+      {
+      poly->GetPoint(polyLine->GetId(j-1),p);
+      poly->GetPoint(polyLine->GetId(j),q);
+      length += sqrt(vtkMath::Distance2BetweenPoints(p,q));
+      }
+    }
+  return length;
+}
+}
+
+int main( int argc, char* argv[] )
+{
+  vtkNew<vtkMPIController> c;
+  vtkMultiProcessController::SetGlobalController(c.GetPointer());
+  c->Initialize(&argc,&argv);
+  int numProcs = c->GetNumberOfProcesses();
+  int myRank = c->GetLocalProcessId();
+  if(numProcs!=4)
+    {
+    c->Finalize();
+    return EXIT_SUCCESS;
+    }
+
+  int size(9);
+  vtkNew<TestVectorFieldSource> imageSource;
+  imageSource->SetExtent(0,size-1,0,1,0,size-1);
+  imageSource->SetBoundingBox(-1,1,-1,1,-1,1);
+  imageSource->Update();
+
+  // The whole field on every process, and a block of it on each process
+  vtkNew<vtkImageData> replicated;
+  replicated->ShallowCopy(imageSource->GetOutput());
+  vtkNew<vtkImageData> split;
+    {
+    vtkNew<vtkExtentTranslator> translator;
+    translator->SetWholeExtent(replicated->GetExtent());
+    translator->SetPiece(myRank);
+    translator->SetNumberOfPieces(numProcs);
+    translator->SetGhostLevel(0);
+    translator->PieceToExtent();
+    split->DeepCopy(replicated.GetPointer());
+    split->Crop(translator->GetExtent());
+    }
+
+  double stepSize(0.01);
+  double radius = 0.8;
+  double maximumPropagation = radius*2*vtkMath::Pi();
+  double angle = vtkMath::Pi()/20;
+  int numTraces=12;
+
+  // Circles at several heights, and a seed out of bounds
+  vtkNew<vtkPolyData> seeds;
+    {
+    vtkNew<vtkPoints> seedPoints;
+    double dt = 1.8/(numTraces-1);
+    for(int i=0; i<numTraces;i++)
+      {
+      seedPoints->InsertNextPoint(radius*cos(angle),-0.9+dt*i,
+                                  radius*sin(angle));
+      }
+    seedPoints->InsertNextPoint(-2,-2,-2);
+    seeds->SetPoints(seedPoints.GetPointer());
+    }
+
+  bool res(true);
+  for(int replicate=0; replicate<2; replicate++)
+    {
+    double lengths[3], lineCounts[3];
+    int balance[3] = { 0, 1, 0 };
+    for(int run=0; run<3; run++)
+      {
+      vtkNew<vtkPStreamTracer> tracer;
+      tracer->SetInputData(0,replicate ? replicated.GetPointer()
+                                       : split.GetPointer());
+      tracer->SetInputData(1,seeds.GetPointer());
+      tracer->SetBalanceSeeds(balance[run]);
+      tracer->SetIntegrationDirectionToForward();
+      tracer->SetIntegratorTypeToRungeKutta4();
+      tracer->SetMaximumNumberOfSteps(4*maximumPropagation/stepSize);
+      tracer->SetMinimumIntegrationStep(stepSize*.1);
+      tracer->SetMaximumIntegrationStep(stepSize);
+      tracer->SetInitialIntegrationStep(stepSize);
+      tracer->SetMaximumPropagation(maximumPropagation);
+      tracer->Update();
+
+      vtkPolyData* out = tracer->GetOutput();
+      double local[3] = { ComputeLength(out),
+                          static_cast<double>(out->GetNumberOfLines()),
+                          out->GetNumberOfLines()>0 ? 1.0 : 0.0 };
+      double all[3] = { 0, 0, 0 };
+      c->Reduce(local,all,3,vtkCommunicator::SUM_OP,0);
+      if(myRank==0)
+        {
+        lengths[run] = all[0];
+        lineCounts[run] = all[1];
+        PRINT((replicate ? "Replicated" : "Split")<<" data, BalanceSeeds "
+              <<balance[run]<<": "<<all[1]<<" lines of total length "
+              <<all[0]<<" on "<<all[2]<<" processes")
+        // the traces are handed over between the blocks, and the balanced
+        // seeds of the replicated data are traced by several processes
+        if((!replicate || balance[run]) && all[2]<2)
+          {
+          PRINT("Error: the lines were traced by a single process")
+          res = false;
+          }
+        }
+      }
+
+    if(myRank==0)
+      {
+      double expected = numTraces*maximumPropagation;
+      for(int run=0; run<3; run++)
+        {
+        double err = fabs(lengths[run] - expected)/expected;
+        if(err>0.02 || fabs(lengths[run] - lengths[0]) > 1e-6*expected ||
+           (replicate && lineCounts[run]!=numTraces))
+          {
+          PRINT("Error: run "<<run<<" traced a total length of "
+                <<lengths[run]<<" in "<<lineCounts[run]<<" lines instead of "
+                <<expected)
+          res = false;
+          }
+        }
+      }
+    }
+
+  c->Finalize();
+  return res? EXIT_SUCCESS: EXIT_FAILURE;
+}
@@ -493,6 +493,17 @@ public:
   {
     return InBB(p,GetBoundingBox(Rank));
   }
+  void FindProcesses(double* p, std::vector<int>& ranks)
+  {
+    ranks.clear();
+    for(int rank=0; rank<this->NumProcs; rank++)
+      {
+      if(InBB(p,GetBoundingBox(rank)))
+        {
+        ranks.push_back(rank);
+        }
+      }
+  }
   int FindNextProcess(double* p)
   {
     for(int rank=CNext(this->Rank,this->NumProcs);
@@ -1059,7 +1070,7 @@ namespace
     {
       NewTask,
       NoMoreTasks,
-      TaskFinished
+      TasksFinished
     };
 
     TaskManager(ProcessLocator* locator, PStreamTracerPoint* proto):
@@ -1075,11 +1086,13 @@ namespace
       this->ReceiveBuffer = NULL;
 
       this->NumSends =0;
+      this->NumFinished = 0;
       this->Timer = vtkSmartPointer<vtkTimerLog>::New();
       this->ReceiveTime = 0;
     }
 
-    void Initialize(bool hasData, const PStreamTracerPointArray& seeds, int MaxId)
+    void Initialize(bool hasData, const PStreamTracerPointArray& seeds, int MaxId,
+                    bool balanceSeeds)
     {
       AssertGe(MaxId,0);
       int numSeeds  = static_cast<int>(seeds.size());
@@ -1110,11 +1123,32 @@ namespace
         {
         processMap0[i] = -1;
         }
+      // every process sees the same seeds and bounding boxes, so they all
+      // spread the seeds the same way
+      std::vector<int> numAssigned(NumProcs,0);
+      std::vector<int> candidates;
       for (int i = 0; i < numSeeds; i ++ )
         {
         int rank  = seeds[i]->GetRank();
         int id = seeds[i]->GetId();
-        if(rank<0 && this->Locator)
+        if(rank<0 && this->Locator && balanceSeeds)
+          {
+          //the process containing the seed with the fewest seeds so far
+          this->Locator->FindProcesses(seeds[i]->GetSeed(),candidates);
+          for(size_t j=0; j<candidates.size(); j++)
+            {
+            if(rank<0 || numAssigned[candidates[j]]<numAssigned[rank])
+              {
+              rank = candidates[j];
+              }
+            }
+          if(rank>=0)
+            {
+            numAssigned[rank]++;
+            }
+          rank = rank==this->Rank? rank : -1;
+          }
+        else if(rank<0 && this->Locator)
           {
           rank = this->Locator->InCurrentProcess(seeds[i]->GetSeed())? this->Rank : -1;
           }
@@ -1166,8 +1200,7 @@ namespace
 
         if(task->GetTraceTerminated())
           {
-          //send to the master process
-          this->Send(TaskFinished,this->Leader,task);
+          this->FinishTask(task);
           }
         else
           {
@@ -1195,7 +1228,7 @@ namespace
 
           if(nextProcess<0)
             {
-            this->Send(TaskFinished,this->Leader,task); //no one can do it, norminally finished
+            this->FinishTask(task); //no one can do it, norminally finished
             PRINT("Bail on "<<task->GetId());
             }
           }
@@ -1207,6 +1240,11 @@ namespace
 
       do
         {
+        if(NTasks.empty())
+          {
+          //report the finished tasks before waiting for more
+          this->SendFinishedTasks();
+          }
         this->Receive(this->TotalNumTasks!=0 && this->Msgs.empty() && NTasks.empty()); //wait if there is nothing to do
         while(!this->Msgs.empty())
           {
@@ -1215,9 +1253,8 @@ namespace
           switch(msg)
             {
             case NewTask: break;
-            case TaskFinished:
+            case TasksFinished:
               AssertEq(Rank,this->Leader);
-              this->TotalNumTasks--;
               PRINT(TotalNumTasks<<" tasks left");
               break;
             case NoMoreTasks:
@@ -1256,15 +1293,18 @@ namespace
 
     ~TaskManager()
     {
+      //all the messages have been received once the tasks are done, so the
+      //sends complete without synchronizing the processes
       for( BufferList::iterator itr=SendBuffers.begin();itr!=SendBuffers.end();itr++)
         {
         MessageBuffer* buf = *itr;
-        AssertNe(buf->GetRequest().Test(),0);
+        buf->GetRequest().Wait();
         delete buf;
         }
       if(this->ReceiveBuffer)
         {
         this->ReceiveBuffer->GetRequest().Cancel();
+        this->ReceiveBuffer->GetRequest().Wait();
         delete ReceiveBuffer;
         }
     }
@@ -1287,28 +1327,46 @@ namespace
     int MessageSize;
     std::vector<int> HasData;
     int Leader;
+    int NumFinished; //finished tasks not reported to the leader yet
     typedef  std::list<MessageBuffer*> BufferList;
     BufferList SendBuffers;
     MessageBuffer* ReceiveBuffer;
 
-    void Send(int msg, int rank, Task* task)
+    // The leader counts the tasks left, the other processes report theirs
+    // in batches when they run out of work
+#ifdef DEBUGTRACE
+    void FinishTask(Task* task)
+#else
+    void FinishTask(Task* vtkNotUsed(task))
+#endif
     {
-      if(msg==TaskFinished)
+      PRINT("Done in "<<task->Point->GetNumSteps()<<" steps "<<task->NumHops<<" hops");
+      if(this->Rank==this->Leader)
         {
-        PRINT("Done in "<<task->Point->GetNumSteps()<<" steps "<<task->NumHops<<" hops");
+        this->TotalNumTasks--;
+        PRINT(TotalNumTasks<<" tasks left");
         }
+      else
+        {
+        this->NumFinished++;
+        }
+    }
+
+    void SendFinishedTasks()
+    {
+      if(this->NumFinished>0)
+        {
+        this->Send(TasksFinished,this->Leader,0,this->NumFinished);
+        this->NumFinished = 0;
+        }
+    }
+
+    void Send(int msg, int rank, Task* task, int numFinished=0)
+    {
       if(rank==this->Rank)
         {
-        switch(msg)
-          {
-          case TaskFinished:
-            this->TotalNumTasks--;
-            PRINT(TotalNumTasks<<" tasks left");
-            break;
-          default:
-            PRINT("Unhandled message "<<msg);
-            assert(false);
-          }
+        PRINT("Unhandled message "<<msg);
+        assert(false);
         }
       else
         {
@@ -1322,6 +1380,10 @@ namespace
           {
           outStream<<(*task);
           }
+        if(msg==TasksFinished)
+          {
+          outStream<<numFinished;
+          }
 
         AssertGe(this->MessageSize,outStream.GetLength());
         this->Controller->NoBlockSend(outStream.GetRawData(),outStream.GetLength(),rank,561,buf.GetRequest());
@@ -1430,6 +1492,12 @@ namespace
           PRINT("Received task "<<task->GetId());//<<" "<<task->Seed[0]<<" "<<task->Seed[1]<<" "<<task->Seed[2]);
           this->NTasks.push_back(task);
           }
+        else if(msg==TasksFinished)
+          {
+          int numFinished(0);
+          inStream>>numFinished;
+          this->TotalNumTasks-=numFinished;
+          }
         delete ReceiveBuffer;  ReceiveBuffer = NULL;
         }
       if(ReceiveBuffer==NULL)
@@ -1487,6 +1555,7 @@ vtkPStreamTracer::vtkPStreamTracer()
   this->GenerateNormalsInIntegrate = 0;
 
   this->EmptyData = 0;
+  this->BalanceSeeds = 0;
 }
 
 vtkPStreamTracer::~vtkPStreamTracer()
@@ -1635,7 +1704,7 @@ int vtkPStreamTracer::RequestData(
 
   int maxId;
   this->Utils->ComputeSeeds(source,seedPoints,maxId);
-  taskManager.Initialize(this->EmptyData==0,seedPoints,maxId);
+  taskManager.Initialize(this->EmptyData==0,seedPoints,maxId,this->BalanceSeeds!=0);
 
   Task* task(0);
   std::vector<int> traceIds;
@@ -1700,8 +1769,6 @@ int vtkPStreamTracer::RequestData(
       }
     }
 
-  this->Controller->Barrier();
-
 #ifdef LOGTRACE
   double receiveTime = taskManager.ComputeReceiveTime();
   if(this->Rank==0)
@@ -1791,6 +1858,7 @@ void vtkPStreamTracer::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os,indent);
   os << indent << "Controller: " << this->Controller << endl;
+  os << indent << "BalanceSeeds: " << this->BalanceSeeds << endl;
 }
 
 
@@ -52,6 +52,15 @@ public:
 
   static vtkPStreamTracer * New();
 
+  // Description:
+  // When on, the seeds lying within the bounds of several processes are
+  // spread evenly among them, instead of all starting on the last of
+  // them. This balances the tracing when the data of the processes
+  // overlap, e.g. when they are replicated. Off by default.
+  vtkSetMacro(BalanceSeeds, int);
+  vtkGetMacro(BalanceSeeds, int);
+  vtkBooleanMacro(BalanceSeeds, int);
+
 protected:
 
   vtkPStreamTracer();
@@ -67,6 +76,7 @@ protected:
   void SetInterpolator(vtkAbstractInterpolatedVelocityField*);
 
   int EmptyData;
+  int BalanceSeeds;
 private:
   vtkPStreamTracer(const vtkPStreamTracer&);  // Not implemented.
   void operator=(const vtkPStreamTracer&);  // Not implemented.
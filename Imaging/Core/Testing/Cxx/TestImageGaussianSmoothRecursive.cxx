@@ -0,0 +1,135 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestImageGaussianSmoothRecursive.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// This tests the recursive mode of vtkImageGaussianSmooth: it must be close
+// to a wide kernel inside the image, keep constant images constant, give the
+// same result whatever the number of threads, and the same result for a
+// sub extent as for the whole image. The number of rows along x is not a
+// multiple of the rows filtered at once.
+
+#include "vtkImageData.h"
+#include "vtkImageGaussianSmooth.h"
+#include "vtkMath.h"
+#include "vtkSmartPointer.h"
+#include "vtkStreamingDemandDrivenPipeline.h"
+
+#include <cmath>
+
+static vtkImageData *Smooth(vtkImageData *input, int recursive,
+                            int numThreads, int *extent = 0)
+{
+  vtkImageGaussianSmooth *smooth = vtkImageGaussianSmooth::New();
+  smooth->SetInputData(input);
+  smooth->SetStandardDeviations(3.0, 2.0, 1.5);
+  smooth->SetRadiusFactors(6.0, 6.0, 6.0);
+  smooth->SetRecursiveGaussian(recursive);
+  smooth->SetNumberOfThreads(numThreads);
+  if (extent)
+    {
+    smooth->UpdateInformation();
+    vtkStreamingDemandDrivenPipeline::SetUpdateExtent(
+      smooth->GetOutputInformation(0), extent);
+    }
+  smooth->Update();
+  vtkImageData *output = vtkImageData::New();
+  output->DeepCopy(smooth->GetOutput());
+  smooth->Delete();
+  return output;
+}
+
+int TestImageGaussianSmoothRecursive(int, char *[])
+{
+  vtkMath::RandomSeed(4321);
+  vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+  image->SetExtent(0, 59, 0, 48, 0, 38);
+  image->AllocateScalars(VTK_DOUBLE, 2);
+  double *values = static_cast<double *>(image->GetScalarPointer());
+  vtkIdType numValues = 2 * image->GetNumberOfPoints();
+  for (vtkIdType i = 0; i < numValues; ++i)
+    {
+    values[i] = vtkMath::Random();
+    }
+
+  vtkSmartPointer<vtkImageData> kernel;
+  kernel.TakeReference(Smooth(image, 0, 1));
+  vtkSmartPointer<vtkImageData> serial;
+  serial.TakeReference(Smooth(image, 1, 1));
+  vtkSmartPointer<vtkImageData> threaded;
+  threaded.TakeReference(Smooth(image, 1, 4));
+  int subExtent[6] = { 10, 40, 5, 30, 12, 20 };
+  vtkSmartPointer<vtkImageData> piece;
+  piece.TakeReference(Smooth(image, 1, 3, subExtent));
+
+  int *extent = image->GetExtent();
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      for (int i = extent[0]; i <= extent[1]; ++i)
+        {
+        for (int c = 0; c < 2; ++c)
+          {
+          double value = serial->GetScalarComponentAsDouble(i, j, k, c);
+          if (threaded->GetScalarComponentAsDouble(i, j, k, c) != value)
+            {
+            std::cerr << "Error: (" << i << ", " << j << ", " << k
+                      << ") depends on the number of threads" << std::endl;
+            return EXIT_FAILURE;
+            }
+          // the kernel is renormalized near the boundaries
+          if (i >= 18 && i <= 41 && j >= 12 && j <= 36 && k >= 9 && k <= 29 &&
+              fabs(kernel->GetScalarComponentAsDouble(i, j, k, c) - value) >
+              0.005)
+            {
+            std::cerr << "Error: (" << i << ", " << j << ", " << k
+                      << ") is " << value << " instead of "
+                      << kernel->GetScalarComponentAsDouble(i, j, k, c)
+                      << std::endl;
+            return EXIT_FAILURE;
+            }
+          if (i >= subExtent[0] && i <= subExtent[1] &&
+              j >= subExtent[2] && j <= subExtent[3] &&
+              k >= subExtent[4] && k <= subExtent[5] &&
+              piece->GetScalarComponentAsDouble(i, j, k, c) != value)
+            {
+            std::cerr << "Error: (" << i << ", " << j << ", " << k
+                      << ") differs in a sub extent" << std::endl;
+            return EXIT_FAILURE;
+            }
+          }
+        }
+      }
+    }
+
+  // A constant image stays constant up to the boundaries
+  for (vtkIdType i = 0; i < numValues; ++i)
+    {
+    values[i] = 7.0;
+    }
+  image->Modified();
+  vtkSmartPointer<vtkImageData> constant;
+  constant.TakeReference(Smooth(image, 1, 2));
+  values = static_cast<double *>(constant->GetScalarPointer());
+  for (vtkIdType i = 0; i < numValues; ++i)
+    {
+    if (fabs(values[i] - 7.0) > 1e-9)
+      {
+      std::cerr << "Error: constant image smoothed to " << values[i]
+                << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
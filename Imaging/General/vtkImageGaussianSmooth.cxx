@@ -17,10 +17,12 @@
 #include "vtkImageData.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
+#include "vtkMultiThreader.h"
 #include "vtkObjectFactory.h"
 #include "vtkStreamingDemandDrivenPipeline.h"
 
 #include <math.h>
+#include <vector>
 
 vtkStandardNewMacro(vtkImageGaussianSmooth);
 
@@ -34,6 +36,7 @@ vtkImageGaussianSmooth::vtkImageGaussianSmooth()
   this->RadiusFactors[0] = 1.5;
   this->RadiusFactors[1] = 1.5;
   this->RadiusFactors[2] = 1.5;
+  this->RecursiveGaussian = 0;
 }
 
 //----------------------------------------------------------------------------
@@ -61,6 +64,9 @@ void vtkImageGaussianSmooth::PrintSelf(ostream& os, vtkIndent indent)
      << this->StandardDeviations[0] << ", "
      << this->StandardDeviations[1] << ", "
      << this->StandardDeviations[2] << " )\n";
+
+  os << indent << "RecursiveGaussian: "
+     << (this->RecursiveGaussian ? "On\n" : "Off\n");
 }
 
 //----------------------------------------------------------------------------
@@ -125,6 +131,13 @@ void vtkImageGaussianSmooth::InternalRequestUpdateExtent(int *inExt,
   // Expand filtered axes
   for (idx = 0; idx < this->Dimensionality; ++idx)
     {
+    // the recursive filter needs whole lines
+    if (this->RecursiveGaussian && this->StandardDeviations[idx] > 0.0)
+      {
+      inExt[idx*2] = wholeExtent[idx*2];
+      inExt[idx*2+1] = wholeExtent[idx*2+1];
+      continue;
+      }
     radius = static_cast<int>(this->StandardDeviations[idx]
                               * this->RadiusFactors[idx]);
     inExt[idx*2] -= radius;
@@ -461,3 +474,452 @@ void vtkImageGaussianSmooth::ThreadedRequestData(
       break;
     }
 }
+
+//----------------------------------------------------------------------------
+// Deriche's fourth order recursive approximation of the gaussian, with the
+// coefficients fitted by Farneback and Westin (2006). The kernel is split
+// into a causal part, run forward along the lines, and an anticausal part,
+// run backward; both are the responses of two damped sinusoids, and the
+// line is extended by its end values.
+struct vtkImageGaussianSmoothRecursiveFilter
+{
+  double N[4]; // causal coefficients of the input
+  double M[4]; // anticausal coefficients of the input
+  double D[4]; // coefficients of the previous responses
+  double CausalGain; // responses to a constant input
+  double AntiCausalGain;
+  double Scale; // normalizes the sum of the kernel to 1
+};
+
+// Lines are filtered by tiles of this many neighboring scalars, so that the
+// inner loops run over contiguous memory: runs of the rows along y and z,
+// rows transposed along x.
+#define VTK_GAUSSIAN_SMOOTH_TILE_WIDTH 32
+
+struct vtkImageGaussianSmoothRecursiveStruct
+{
+  vtkImageGaussianSmoothRecursiveFilter Filter;
+  int Axis;
+  int NumberOfComponents;
+  int Length; // of the input lines
+  int OutBegin; // first and last output points along the lines
+  int OutEnd;
+  int Dimensions[3]; // of the output
+  int RowsPerTile; // along x
+  void *InPtr;
+  void *OutPtr;
+  vtkIdType InIncs[3];
+  vtkIdType OutIncs[3];
+  vtkIdType NumberOfTiles;
+  int NumberOfThreads;
+  int ScalarType;
+};
+
+//----------------------------------------------------------------------------
+static void vtkImageGaussianSmoothComputeRecursiveFilter(
+  double std, vtkImageGaussianSmoothRecursiveFilter *f)
+{
+  double a1 = 1.3530, b1 = 1.8151, w1 = 0.6681 / std, l1 = -1.3932 / std;
+  double a2 = -0.3531, b2 = 0.0902, w2 = 2.0787 / std, l2 = -1.3732 / std;
+  double e1 = exp(l1), e2 = exp(l2);
+  double c1 = cos(w1), c2 = cos(w2), s1 = sin(w1), s2 = sin(w2);
+
+  f->D[0] = -2.0*e2*c2 - 2.0*e1*c1;
+  f->D[1] = 4.0*c2*c1*e1*e2 + e2*e2 + e1*e1;
+  f->D[2] = -2.0*c1*e1*e2*e2 - 2.0*c2*e2*e1*e1;
+  f->D[3] = e1*e1*e2*e2;
+
+  f->N[0] = a1 + a2;
+  f->N[1] = e2*(b2*s2 - (a2 + 2.0*a1)*c2) + e1*(b1*s1 - (a1 + 2.0*a2)*c1);
+  f->N[2] = 2.0*e1*e2*((a1 + a2)*c2*c1 - b1*c2*s1 - b2*c1*s2) +
+    a2*e1*e1 + a1*e2*e2;
+  f->N[3] = e2*e1*e1*(b2*s2 - a2*c2) + e1*e2*e2*(b1*s1 - a1*c1);
+
+  // the anticausal part leaves out the center of the kernel
+  double sumN = 0.0, sumM = 0.0, sumD = 1.0;
+  for (int k = 0; k < 4; ++k)
+    {
+    f->M[k] = ((k < 3) ? f->N[k+1] : 0.0) - f->D[k]*f->N[0];
+    sumN += f->N[k];
+    sumM += f->M[k];
+    sumD += f->D[k];
+    }
+  f->CausalGain = sumN / sumD;
+  f->AntiCausalGain = sumM / sumD;
+  f->Scale = 1.0 / (f->CausalGain + f->AntiCausalGain);
+}
+
+//----------------------------------------------------------------------------
+// Filters width neighboring lines of length points, the points of a line
+// being inStep (outStep) scalars apart. Only the points from outBegin to
+// outEnd are written, outPtr pointing at outBegin. The lines are copied to
+// the buffer before any point is written, so the output may overwrite the
+// input. The buffer holds (2*length + 8) * width values.
+template <class T>
+void vtkImageGaussianSmoothRecursiveLines(
+  const vtkImageGaussianSmoothRecursiveFilter *f,
+  const T *inPtr, vtkIdType inStep, int length,
+  T *outPtr, vtkIdType outStep, int outBegin, int outEnd,
+  int width, double *buffer)
+{
+  const double n0 = f->N[0], n1 = f->N[1], n2 = f->N[2], n3 = f->N[3];
+  const double m0 = f->M[0], m1 = f->M[1], m2 = f->M[2], m3 = f->M[3];
+  const double d0 = f->D[0], d1 = f->D[1], d2 = f->D[2], d3 = f->D[3];
+  const double scale = f->Scale;
+  int j;
+
+  // The first 4 rows of the buffer hold the causal responses before the
+  // line, the next length rows the causal responses along the line, the
+  // next 4 rows the anticausal responses after the current point and the
+  // last length rows the input.
+  double *causal = buffer + 4*width;
+  double *input = buffer + (length + 8)*width;
+  double *anti[4];
+  for (int n = 0; n < length; ++n)
+    {
+    const T *x = inPtr + n*inStep;
+    double *row = input + n*width;
+    for (j = 0; j < width; ++j)
+      {
+      row[j] = static_cast<double>(x[j]);
+      }
+    }
+  const double *last = input + (length - 1)*width;
+  for (int k = 0; k < 4; ++k)
+    {
+    anti[k] = buffer + (length + 4 + k)*width;
+    for (j = 0; j < width; ++j)
+      {
+      buffer[k*width + j] = f->CausalGain * input[j];
+      anti[k][j] = f->AntiCausalGain * last[j];
+      }
+    }
+
+  // causal pass
+  for (int n = 0; n < length; ++n)
+    {
+    const double *x0 = input + n*width;
+    const double *x1 = input + ((n > 0) ? n - 1 : 0)*width;
+    const double *x2 = input + ((n > 1) ? n - 2 : 0)*width;
+    const double *x3 = input + ((n > 2) ? n - 3 : 0)*width;
+    double *y0 = causal + n*width;
+    const double *y1 = y0 - width;
+    const double *y2 = y1 - width;
+    const double *y3 = y2 - width;
+    const double *y4 = y3 - width;
+    for (j = 0; j < width; ++j)
+      {
+      y0[j] = n0*x0[j] + n1*x1[j] + n2*x2[j] + n3*x3[j] -
+        d0*y1[j] - d1*y2[j] - d2*y3[j] - d3*y4[j];
+      }
+    }
+
+  // anticausal pass, summed with the causal responses
+  for (int n = length - 1; n >= outBegin; --n)
+    {
+    const double *x1 = input + ((n + 1 < length) ? n + 1 : length - 1)*width;
+    const double *x2 = input + ((n + 2 < length) ? n + 2 : length - 1)*width;
+    const double *x3 = input + ((n + 3 < length) ? n + 3 : length - 1)*width;
+    const double *x4 = input + ((n + 4 < length) ? n + 4 : length - 1)*width;
+    const double *y1 = anti[0];
+    const double *y2 = anti[1];
+    const double *y3 = anti[2];
+    double *y0 = anti[3]; // replaces the oldest response
+    for (j = 0; j < width; ++j)
+      {
+      y0[j] = m0*x1[j] + m1*x2[j] + m2*x3[j] + m3*x4[j] -
+        d0*y1[j] - d1*y2[j] - d2*y3[j] - d3*y0[j];
+      }
+    if (n <= outEnd)
+      {
+      T *out = outPtr + (n - outBegin)*outStep;
+      const double *c = causal + n*width;
+      for (j = 0; j < width; ++j)
+        {
+        out[j] = static_cast<T>(scale*(c[j] + y0[j]));
+        }
+      }
+    anti[3] = anti[2];
+    anti[2] = anti[1];
+    anti[1] = anti[0];
+    anti[0] = y0;
+    }
+}
+
+//----------------------------------------------------------------------------
+// Filters the tiles from begin to end. Along x a tile is RowsPerTile rows,
+// transposed so that the points of the lines are the scalars of the rows
+// apart; along y and z it is a run of neighboring scalars of the rows.
+template <class T>
+void vtkImageGaussianSmoothRecursiveTiles(
+  vtkImageGaussianSmoothRecursiveStruct *str, T *, vtkIdType begin,
+  vtkIdType end)
+{
+  int axis = str->Axis;
+  int *dims = str->Dimensions;
+  int numComps = str->NumberOfComponents;
+  int length = str->Length;
+  int outLength = str->OutEnd - str->OutBegin + 1;
+  int run = dims[0]*numComps;
+  int numChunks = (run + VTK_GAUSSIAN_SMOOTH_TILE_WIDTH - 1) /
+    VTK_GAUSSIAN_SMOOTH_TILE_WIDTH;
+  int otherAxis = (axis == 1) ? 2 : 1;
+  const T *inPtr = static_cast<const T *>(str->InPtr);
+  T *outPtr = static_cast<T *>(str->OutPtr);
+
+  int maxWidth = (axis == 0) ? str->RowsPerTile*numComps :
+    VTK_GAUSSIAN_SMOOTH_TILE_WIDTH;
+  std::vector<double> buffer((2*length + 8)*static_cast<size_t>(maxWidth));
+  std::vector<T> rowsIn, rowsOut;
+  if (axis == 0)
+    {
+    rowsIn.resize(length*static_cast<size_t>(maxWidth));
+    rowsOut.resize(outLength*static_cast<size_t>(maxWidth));
+    }
+
+  vtkIdType numRows = static_cast<vtkIdType>(dims[1])*dims[2];
+  for (vtkIdType tile = begin; tile < end; ++tile)
+    {
+    if (axis == 0)
+      {
+      vtkIdType firstRow = tile*str->RowsPerTile;
+      int numTileRows = static_cast<int>(
+        (numRows - firstRow < str->RowsPerTile) ?
+        numRows - firstRow : str->RowsPerTile);
+      int width = numTileRows*numComps;
+      for (int r = 0; r < numTileRows; ++r)
+        {
+        vtkIdType row = firstRow + r;
+        const T *in = inPtr + (row % dims[1])*str->InIncs[1] +
+          (row / dims[1])*str->InIncs[2];
+        for (int n = 0; n < length; ++n)
+          {
+          for (int c = 0; c < numComps; ++c)
+            {
+            rowsIn[n*width + r*numComps + c] = in[n*str->InIncs[0] + c];
+            }
+          }
+        }
+      vtkImageGaussianSmoothRecursiveLines(
+        &str->Filter, &rowsIn[0], width, length, &rowsOut[0], width,
+        str->OutBegin, str->OutEnd, width, &buffer[0]);
+      for (int r = 0; r < numTileRows; ++r)
+        {
+        vtkIdType row = firstRow + r;
+        T *out = outPtr + (row % dims[1])*str->OutIncs[1] +
+          (row / dims[1])*str->OutIncs[2];
+        for (int n = 0; n < outLength; ++n)
+          {
+          for (int c = 0; c < numComps; ++c)
+            {
+            out[n*str->OutIncs[0] + c] = rowsOut[n*width + r*numComps + c];
+            }
+          }
+        }
+      }
+    else
+      {
+      vtkIdType start = (tile % numChunks)*VTK_GAUSSIAN_SMOOTH_TILE_WIDTH;
+      vtkIdType idx = tile / numChunks;
+      int width = static_cast<int>(
+        (run - start < VTK_GAUSSIAN_SMOOTH_TILE_WIDTH) ?
+        run - start : VTK_GAUSSIAN_SMOOTH_TILE_WIDTH);
+      vtkImageGaussianSmoothRecursiveLines(
+        &str->Filter, inPtr + start + idx*str->InIncs[otherAxis],
+        str->InIncs[axis], length,
+        outPtr + start + idx*str->OutIncs[otherAxis], str->OutIncs[axis],
+        str->OutBegin, str->OutEnd, width, &buffer[0]);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Each thread filters a contiguous range of tiles.
+static VTK_THREAD_RETURN_TYPE vtkImageGaussianSmoothRecursiveExecute(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *info =
+    static_cast<vtkMultiThreader::ThreadInfo *>(arg);
+  vtkImageGaussianSmoothRecursiveStruct *str =
+    static_cast<vtkImageGaussianSmoothRecursiveStruct *>(info->UserData);
+
+  vtkIdType begin = str->NumberOfTiles * info->ThreadID /
+    str->NumberOfThreads;
+  vtkIdType end = str->NumberOfTiles * (info->ThreadID + 1) /
+    str->NumberOfThreads;
+  switch (str->ScalarType)
+    {
+    vtkTemplateMacro(
+      vtkImageGaussianSmoothRecursiveTiles(str, static_cast<VTK_TT *>(0),
+                                           begin, end));
+    }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+// This method filters the whole lines of inExt along one axis, the output
+// extent being the same except along that axis. The output may be the
+// input, its extent then being a sub extent of the input.
+void vtkImageGaussianSmooth::ExecuteRecursiveAxis(int axis,
+                                                  vtkImageData *inData,
+                                                  int inExt[6],
+                                                  vtkImageData *outData,
+                                                  int outExt[6],
+                                                  vtkInformation *inInfo)
+{
+  double std = this->StandardDeviations[axis];
+  if (std <= 0.0)
+    {
+    // nothing to smooth, the kernel copies the input
+    if (outData == inData)
+      {
+      return;
+      }
+    int cycle = 0, count = 0;
+    this->ExecuteAxis(axis, inData, inExt, outData, outExt,
+                      &cycle, 0, &count, 0, inInfo);
+    return;
+    }
+
+  vtkImageGaussianSmoothRecursiveStruct str;
+  vtkImageGaussianSmoothComputeRecursiveFilter(std, &str.Filter);
+  str.Axis = axis;
+  str.NumberOfComponents = inData->GetNumberOfScalarComponents();
+  str.Length = inExt[axis*2+1] - inExt[axis*2] + 1;
+  str.OutBegin = outExt[axis*2] - inExt[axis*2];
+  str.OutEnd = outExt[axis*2+1] - inExt[axis*2];
+  for (int idx = 0; idx < 3; ++idx)
+    {
+    str.Dimensions[idx] = outExt[idx*2+1] - outExt[idx*2] + 1;
+    str.InIncs[idx] = inData->GetIncrements()[idx];
+    str.OutIncs[idx] = outData->GetIncrements()[idx];
+    }
+  str.InPtr = inData->GetScalarPointerForExtent(inExt);
+  str.OutPtr = outData->GetScalarPointerForExtent(outExt);
+  str.ScalarType = inData->GetScalarType();
+  str.RowsPerTile = VTK_GAUSSIAN_SMOOTH_TILE_WIDTH / str.NumberOfComponents;
+  str.RowsPerTile = (str.RowsPerTile < 1) ? 1 : str.RowsPerTile;
+  if (axis == 0)
+    {
+    vtkIdType numRows =
+      static_cast<vtkIdType>(str.Dimensions[1])*str.Dimensions[2];
+    str.NumberOfTiles = (numRows + str.RowsPerTile - 1) / str.RowsPerTile;
+    }
+  else
+    {
+    int run = str.Dimensions[0]*str.NumberOfComponents;
+    str.NumberOfTiles =
+      static_cast<vtkIdType>((run + VTK_GAUSSIAN_SMOOTH_TILE_WIDTH - 1) /
+                             VTK_GAUSSIAN_SMOOTH_TILE_WIDTH) *
+      str.Dimensions[(axis == 1) ? 2 : 1];
+    }
+  if (str.NumberOfTiles < 1)
+    {
+    return;
+    }
+
+  str.NumberOfThreads = this->NumberOfThreads;
+  if (str.NumberOfThreads > str.NumberOfTiles)
+    {
+    str.NumberOfThreads = static_cast<int>(str.NumberOfTiles);
+    }
+  this->Threader->SetNumberOfThreads(str.NumberOfThreads);
+  this->Threader->SetSingleMethod(vtkImageGaussianSmoothRecursiveExecute,
+                                  &str);
+  this->Threader->SingleMethodExecute();
+}
+
+//----------------------------------------------------------------------------
+// The recursive filter smooths along x, then y and z, each pass over the
+// whole extent with all the threads. Otherwise the superclass splits the
+// output extent among the threads.
+int vtkImageGaussianSmooth::RequestData(vtkInformation *request,
+                                        vtkInformationVector **inputVector,
+                                        vtkInformationVector *outputVector)
+{
+  if (!this->RecursiveGaussian)
+    {
+    return this->Superclass::RequestData(request, inputVector, outputVector);
+    }
+
+  vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
+  vtkInformation *outInfo = outputVector->GetInformationObject(0);
+  vtkImageData *inData = vtkImageData::SafeDownCast(
+    inInfo->Get(vtkDataObject::DATA_OBJECT()));
+  vtkImageData *outData = vtkImageData::SafeDownCast(
+    outInfo->Get(vtkDataObject::DATA_OBJECT()));
+
+  int outExt[6], inExt[6], wholeExt[6];
+  outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), outExt);
+  this->AllocateOutputData(outData, outInfo, outExt);
+  this->CopyAttributeData(inData, outData, inputVector);
+
+  // this filter expects that input is the same type as output.
+  if (inData->GetScalarType() != outData->GetScalarType())
+    {
+    vtkErrorMacro("Execute: input ScalarType, "
+                  << inData->GetScalarType()
+                  << ", must match out ScalarType "
+                  << outData->GetScalarType());
+    return 0;
+    }
+  if (outExt[0] > outExt[1] || outExt[2] > outExt[3] || outExt[4] > outExt[5])
+    {
+    return 1;
+    }
+
+  inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), wholeExt);
+  for (int idx = 0; idx < 6; ++idx)
+    {
+    inExt[idx] = outExt[idx];
+    }
+  this->InternalRequestUpdateExtent(inExt, wholeExt);
+
+  // x goes first: its lines are contiguous, and it crops the data that the
+  // strided passes along y and z have to go through. The passes before the
+  // last one write a single temporary image, filtered in place along y.
+  int numAxes = (this->Dimensionality < 3) ? this->Dimensionality : 3;
+  vtkImageData *data = inData;
+  vtkImageData *temp = 0;
+  int dataExt[6], nextExt[6];
+  for (int idx = 0; idx < 6; ++idx)
+    {
+    dataExt[idx] = inExt[idx];
+    }
+  for (int axis = 0; axis < numAxes && !this->AbortExecute; ++axis)
+    {
+    for (int idx = 0; idx < 6; ++idx)
+      {
+      nextExt[idx] = dataExt[idx];
+      }
+    nextExt[axis*2] = outExt[axis*2];
+    nextExt[axis*2+1] = outExt[axis*2+1];
+
+    // the last pass writes the output, the others the temporary image
+    vtkImageData *next = outData;
+    if (axis < numAxes - 1)
+      {
+      if (!temp)
+        {
+        temp = vtkImageData::New();
+        temp->SetExtent(nextExt);
+        temp->AllocateScalars(inData->GetScalarType(),
+                              inData->GetNumberOfScalarComponents());
+        }
+      next = temp;
+      }
+    this->ExecuteRecursiveAxis(axis, data, dataExt, next, nextExt, inInfo);
+    data = next;
+    for (int idx = 0; idx < 6; ++idx)
+      {
+      dataExt[idx] = nextExt[idx];
+      }
+    this->UpdateProgress(static_cast<double>(axis + 1) / numAxes);
+    }
+  if (temp)
+    {
+    temp->Delete();
+    }
+
+  return 1;
+}
@@ -16,6 +16,13 @@
 // .SECTION Description
 // vtkImageGaussianSmooth implements a convolution of the input image
 // with a gaussian. Supports from one to three dimensional convolutions.
+//
+// By default the gaussian is truncated by the RadiusFactors, and its cost
+// grows with the standard deviations. With RecursiveGaussian on, the
+// filter instead applies Deriche's fourth order recursive approximation of
+// the gaussian, whose cost per pixel does not depend on the standard
+// deviations. The lines along each axis are then filtered in tiles of
+// neighboring lines, split among the threads.
 
 #ifndef __vtkImageGaussianSmooth_h
 #define __vtkImageGaussianSmooth_h
@@ -70,6 +77,15 @@ public:
   vtkSetMacro(Dimensionality, int);
   vtkGetMacro(Dimensionality, int);
 
+  // Description:
+  // Turn on to smooth with a recursive (IIR) approximation of the gaussian
+  // instead of the truncated kernel. The RadiusFactors are then ignored, and
+  // the whole extent of the input is requested along the smoothed axes; the
+  // image is extended by its boundary values. Off by default.
+  vtkSetMacro(RecursiveGaussian, int);
+  vtkGetMacro(RecursiveGaussian, int);
+  vtkBooleanMacro(RecursiveGaussian, int);
+
 protected:
   vtkImageGaussianSmooth();
   ~vtkImageGaussianSmooth();
@@ -77,6 +93,7 @@ protected:
   int Dimensionality;
   double StandardDeviations[3];
   double RadiusFactors[3];
+  int RecursiveGaussian;
 
   void ComputeKernel(double *kernel, int min, int max, double std);
   virtual int RequestUpdateExtent (vtkInformation *, vtkInformationVector **, vtkInformationVector *);
@@ -91,6 +108,16 @@ protected:
                            vtkImageData ***inData, vtkImageData **outData,
                            int outExt[6], int id);
 
+  // Description:
+  // The recursive filter processes each axis over the whole image at once,
+  // so it replaces the extent splitting of the superclass.
+  virtual int RequestData(vtkInformation *request,
+                          vtkInformationVector **inputVector,
+                          vtkInformationVector *outputVector);
+  void ExecuteRecursiveAxis(int axis, vtkImageData *inData, int inExt[6],
+                            vtkImageData *outData, int outExt[6],
+                            vtkInformation *inInfo);
+
 private:
   vtkImageGaussianSmooth(const vtkImageGaussianSmooth&);  // Not implemented.
   void operator=(const vtkImageGaussianSmooth&);  // Not implemented.
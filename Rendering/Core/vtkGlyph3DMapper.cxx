@@ -337,6 +337,8 @@ const char* vtkGlyph3DMapper::GetOrientationModeAsString()
     return "Direction";
   case vtkGlyph3DMapper::ORIENTATION:
     return "Orientation";
+  case vtkGlyph3DMapper::MATRIX:
+    return "Matrix";
     }
   return "Invalid";
 }
@@ -586,6 +588,40 @@ bool vtkGlyph3DMapper::GetBoundsInternal(vtkDataSet* ds, double ds_bounds[6])
     bbox.Scale(this->ScaleFactor,this->ScaleFactor,this->ScaleFactor);
     }
 
+  if (bbox.IsValid() && orientArray &&
+      this->OrientationMode == vtkGlyph3DMapper::MATRIX &&
+      orientArray->GetNumberOfComponents() == 16)
+    {
+    // The matrices place the glyphs: transform the corners of the glyph
+    // bounding box with each of them.
+    double bounds[6];
+    bbox.GetBounds(bounds);
+    vtkBoundingBox glyphsBox;
+    vtkIdType numTuples = orientArray->GetNumberOfTuples();
+    for (vtkIdType i = 0; i < numTuples; ++i)
+      {
+      double *m = orientArray->GetTuple(i);
+      for (int corner = 0; corner < 8; ++corner)
+        {
+        double p[3], q[3];
+        p[0] = bounds[corner & 1];
+        p[1] = bounds[2 + ((corner >> 1) & 1)];
+        p[2] = bounds[4 + ((corner >> 2) & 1)];
+        for (int j = 0; j < 3; ++j)
+          {
+          q[j] = m[4*j]*p[0] + m[4*j+1]*p[1] + m[4*j+2]*p[2] + m[4*j+3];
+          }
+        glyphsBox.AddPoint(q);
+        }
+      }
+    if (!glyphsBox.IsValid())
+      {
+      return false;
+      }
+    glyphsBox.GetBounds(ds_bounds);
+    return true;
+    }
+
   if(bbox.IsValid())
     {
     double bounds[6];
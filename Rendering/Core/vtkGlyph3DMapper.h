@@ -127,20 +127,28 @@ public:
 
   // Description:
   // Orientation mode indicates if the OrientationArray provides the direction
-  // vector for the orientation or the rotations around each axes. Default is
-  // DIRECTION
-  vtkSetClampMacro(OrientationMode, int, DIRECTION, ROTATION);
+  // vector for the orientation, the rotations around each axes, or the
+  // complete transformation of each glyph. In MATRIX mode the orientation
+  // array has 16 components, the elements of a 4x4 matrix in row-major
+  // order, which maps the source to its final position; the point
+  // coordinates are then ignored, and scaling (if on) is applied before the
+  // matrix. This is the "GlyphTransform" array of the instance tables
+  // generated by vtkGlyph3D and vtkTensorGlyph. Default is DIRECTION
+  vtkSetClampMacro(OrientationMode, int, DIRECTION, MATRIX);
   vtkGetMacro(OrientationMode, int);
   void SetOrientationModeToDirection()
     { this->SetOrientationMode(vtkGlyph3DMapper::DIRECTION); }
   void SetOrientationModeToRotation()
     { this->SetOrientationMode(vtkGlyph3DMapper::ROTATION); }
+  void SetOrientationModeToMatrix()
+    { this->SetOrientationMode(vtkGlyph3DMapper::MATRIX); }
   const char* GetOrientationModeAsString();
   //BTX
   enum OrientationModes
     {
     DIRECTION=0,
-    ROTATION=1
+    ROTATION=1,
+    MATRIX=2
     };
   //ETX
 
@@ -0,0 +1,142 @@
+/*=========================================================================
+
+  Program:   Visualization Toolkit
+  Module:    TestGlyph3DMapperMatrix.cxx
+
+  Copyright (c) Ken Martin, Will Schroeder, Bill Lorensen
+  All rights reserved.
+  See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
+
+     This software is distributed WITHOUT ANY WARRANTY; without even
+     the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+     PURPOSE.  See the above copyright notice for more information.
+
+=========================================================================*/
+// This tests that vtkGlyph3DMapper, in orientation mode MATRIX, renders the
+// instance table of vtkGlyph3D as the glyphs vtkGlyph3D generates: the
+// glyphs generated by the filter are rendered first, then the instance
+// table is rendered in the same view, and the two images are compared. The
+// bounds of the mapper are compared with the bounds of the glyphs.
+
+#include "vtkActor.h"
+#include "vtkCamera.h"
+#include "vtkConeSource.h"
+#include "vtkGlyph3D.h"
+#include "vtkGlyph3DMapper.h"
+#include "vtkImageData.h"
+#include "vtkImageDifference.h"
+#include "vtkPointData.h"
+#include "vtkPolyData.h"
+#include "vtkPolyDataMapper.h"
+#include "vtkRenderWindow.h"
+#include "vtkRenderer.h"
+#include "vtkSmartPointer.h"
+#include "vtkSphereSource.h"
+#include "vtkTransform.h"
+#include "vtkWindowToImageFilter.h"
+
+int TestGlyph3DMapperMatrix(int, char *[])
+{
+  vtkSmartPointer<vtkSphereSource> sphere =
+    vtkSmartPointer<vtkSphereSource>::New();
+  sphere->SetThetaResolution(10);
+  sphere->SetPhiResolution(8);
+  sphere->Update();
+
+  // glyphs oriented along the sphere normals
+  vtkSmartPointer<vtkPolyData> input = vtkSmartPointer<vtkPolyData>::New();
+  input->ShallowCopy(sphere->GetOutput());
+  input->GetPointData()->SetVectors(input->GetPointData()->GetNormals());
+
+  vtkSmartPointer<vtkConeSource> cone = vtkSmartPointer<vtkConeSource>::New();
+  cone->SetResolution(8);
+
+  vtkSmartPointer<vtkTransform> sourceTransform =
+    vtkSmartPointer<vtkTransform>::New();
+  sourceTransform->Translate(0.5, 0.0, 0.0);
+
+  vtkSmartPointer<vtkGlyph3D> glyphs[2];
+  for (int i = 0; i < 2; ++i)
+    {
+    glyphs[i] = vtkSmartPointer<vtkGlyph3D>::New();
+    glyphs[i]->SetInputData(input);
+    glyphs[i]->SetSourceConnection(cone->GetOutputPort());
+    glyphs[i]->SetScaleModeToDataScalingOff();
+    glyphs[i]->SetScaleFactor(0.2);
+    glyphs[i]->SetSourceTransform(sourceTransform);
+    }
+  glyphs[1]->OutputInstancesOn();
+  glyphs[0]->Update();
+  glyphs[1]->Update();
+
+  vtkSmartPointer<vtkPolyDataMapper> geometryMapper =
+    vtkSmartPointer<vtkPolyDataMapper>::New();
+  geometryMapper->SetInputConnection(glyphs[0]->GetOutputPort());
+  geometryMapper->ScalarVisibilityOff();
+
+  vtkSmartPointer<vtkGlyph3DMapper> tableMapper =
+    vtkSmartPointer<vtkGlyph3DMapper>::New();
+  tableMapper->SetInputConnection(glyphs[1]->GetOutputPort());
+  tableMapper->SetSourceConnection(cone->GetOutputPort());
+  tableMapper->SetOrientationModeToMatrix();
+  tableMapper->SetOrientationArray("GlyphTransform");
+  tableMapper->ScalingOff();
+  tableMapper->ScalarVisibilityOff();
+
+  double expected[6], bounds[6];
+  glyphs[0]->GetOutput()->GetBounds(expected);
+  tableMapper->GetBounds(bounds);
+  for (int i = 0; i < 6; ++i)
+    {
+    if (fabs(bounds[i] - expected[i]) > 1.0e-6)
+      {
+      std::cerr << "Error: bound " << i << " of the mapper is " << bounds[i]
+                << " instead of " << expected[i] << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  vtkSmartPointer<vtkActor> actor = vtkSmartPointer<vtkActor>::New();
+  actor->SetMapper(geometryMapper);
+  vtkSmartPointer<vtkRenderer> ren = vtkSmartPointer<vtkRenderer>::New();
+  ren->AddActor(actor);
+  ren->SetBackground(0.5, 0.5, 0.5);
+  vtkSmartPointer<vtkRenderWindow> win =
+    vtkSmartPointer<vtkRenderWindow>::New();
+  win->SetMultiSamples(0);
+  win->AddRenderer(ren);
+  win->SetSize(300, 300);
+  ren->ResetCamera();
+  ren->GetActiveCamera()->Azimuth(30.0);
+  ren->GetActiveCamera()->Elevation(20.0);
+
+  vtkSmartPointer<vtkImageData> images[2];
+  for (int i = 0; i < 2; ++i)
+    {
+    if (i == 1)
+      {
+      actor->SetMapper(tableMapper);
+      }
+    win->Render();
+    vtkSmartPointer<vtkWindowToImageFilter> grab =
+      vtkSmartPointer<vtkWindowToImageFilter>::New();
+    grab->SetInput(win);
+    grab->Update();
+    images[i] = vtkSmartPointer<vtkImageData>::New();
+    images[i]->DeepCopy(grab->GetOutput());
+    }
+
+  vtkSmartPointer<vtkImageDifference> diff =
+    vtkSmartPointer<vtkImageDifference>::New();
+  diff->SetInputData(images[1]);
+  diff->SetImageData(images[0]);
+  diff->Update();
+  if (diff->GetThresholdedError() > 10.0)
+    {
+    std::cerr << "Error: the instance table is rendered with an error of "
+              << diff->GetThresholdedError() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
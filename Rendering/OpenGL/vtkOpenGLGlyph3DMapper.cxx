@@ -399,9 +399,12 @@ void vtkOpenGLGlyph3DMapper::Render(
       }
     }
 
-  if (orientArray !=0 && orientArray->GetNumberOfComponents() != 3)
+  int orientComps =
+    (this->OrientationMode == vtkGlyph3DMapper::MATRIX ? 16 : 3);
+  if (orientArray !=0 && orientArray->GetNumberOfComponents() != orientComps)
     {
-    vtkErrorMacro(" expecting an orientation array with 3 component, getting "
+    vtkErrorMacro(" expecting an orientation array with " << orientComps
+      << " component, getting "
       << orientArray->GetNumberOfComponents() << " components.");
     return;
     }
@@ -517,10 +520,15 @@ void vtkOpenGLGlyph3DMapper::Render(
 
       if (orientArray)
         {
-        double orientation[3];
+        double orientation[16];
         orientArray->GetTuple(inPtId, orientation);
         switch (this->OrientationMode)
           {
+        case MATRIX:
+          // the matrix includes the translation to the glyph position
+          trans->SetMatrix(orientation);
+          break;
+
         case ROTATION:
           trans->RotateZ(orientation[2]);
           trans->RotateX(orientation[0]);